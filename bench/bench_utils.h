@@ -0,0 +1,281 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __BENCH_UTILS_H__
+#define __BENCH_UTILS_H__
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_HISTOGRAM_SUB_BITS 4 /* sub buckets per power of two are 1 << this */
+#define BENCH_HISTOGRAM_BUCKETS  (64 << BENCH_HISTOGRAM_SUB_BITS)
+
+/*
+ * bench_histogram_t
+ * log-linear latency histogram in nanoseconds, each power of two is split into 16 buckets so
+ * percentiles are within about 6% of the actual value
+ * @param counts the count per bucket
+ * @param count the number of recorded values
+ * @param sum the sum of the recorded values
+ * @param min the smallest recorded value
+ * @param max the largest recorded value
+ */
+typedef struct
+{
+    uint64_t counts[BENCH_HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+} bench_histogram_t;
+
+/*
+ * bench_now_ns
+ * gets the monotonic time in nanoseconds
+ */
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline void bench_histogram_init(bench_histogram_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+/*
+ * bench_histogram_bucket
+ * gets the bucket of a value, values below 16 get a bucket each
+ */
+static inline int bench_histogram_bucket(uint64_t value)
+{
+    if (value < (1ULL << BENCH_HISTOGRAM_SUB_BITS)) return (int)value;
+
+    int msb = 0;
+    while ((value >> msb) > 1) msb++;
+
+    int sub = (int)((value >> (msb - BENCH_HISTOGRAM_SUB_BITS)) &
+                    ((1 << BENCH_HISTOGRAM_SUB_BITS) - 1));
+    return ((msb - BENCH_HISTOGRAM_SUB_BITS + 1) << BENCH_HISTOGRAM_SUB_BITS) + sub;
+}
+
+/*
+ * bench_histogram_bucket_limit
+ * gets the largest value that falls in a bucket
+ */
+static inline uint64_t bench_histogram_bucket_limit(int bucket)
+{
+    if (bucket < (1 << BENCH_HISTOGRAM_SUB_BITS)) return (uint64_t)bucket;
+
+    int msb = (bucket >> BENCH_HISTOGRAM_SUB_BITS) + BENCH_HISTOGRAM_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(bucket & ((1 << BENCH_HISTOGRAM_SUB_BITS) - 1));
+    int shift = msb - BENCH_HISTOGRAM_SUB_BITS;
+    uint64_t lower = (((uint64_t)1 << BENCH_HISTOGRAM_SUB_BITS) + sub) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+static inline void bench_histogram_add(bench_histogram_t *h, uint64_t value)
+{
+    h->counts[bench_histogram_bucket(value)]++;
+    h->count++;
+    h->sum += value;
+    if (value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+}
+
+static inline void bench_histogram_merge(bench_histogram_t *dst, const bench_histogram_t *src)
+{
+    for (int i = 0; i < BENCH_HISTOGRAM_BUCKETS; i++) dst->counts[i] += src->counts[i];
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+/*
+ * bench_histogram_percentile
+ * gets the value below which a percentage of the recorded values fall
+ * @param p the percentile, 0 to 100
+ */
+static inline uint64_t bench_histogram_percentile(const bench_histogram_t *h, double p)
+{
+    if (h->count == 0) return 0;
+
+    uint64_t rank = (uint64_t)ceil(p / 100.0 * (double)h->count);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BENCH_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += h->counts[i];
+        if (seen < rank) continue;
+
+        /* we report the bucket limit but never more than we have seen */
+        uint64_t limit = bench_histogram_bucket_limit(i);
+        return limit < h->max ? limit : h->max;
+    }
+
+    return h->max;
+}
+
+/*
+ * bench_histogram_print
+ * prints the average, percentiles and extremes of a histogram in microseconds
+ */
+static inline void bench_histogram_print(const bench_histogram_t *h)
+{
+    if (h->count == 0) return;
+
+    printf("Latency (micros): avg %.2f p50 %.2f p99 %.2f p99.9 %.2f min %.2f max %.2f\n",
+           (double)h->sum / (double)h->count / 1000.0,
+           (double)bench_histogram_percentile(h, 50.0) / 1000.0,
+           (double)bench_histogram_percentile(h, 99.0) / 1000.0,
+           (double)bench_histogram_percentile(h, 99.9) / 1000.0, (double)h->min / 1000.0,
+           (double)h->max / 1000.0);
+}
+
+/*
+ * bench_rng_t
+ * xorshift64* generator, one per thread so threads don't share state
+ */
+typedef struct
+{
+    uint64_t state;
+} bench_rng_t;
+
+static inline void bench_rng_seed(bench_rng_t *rng, uint64_t seed)
+{
+    /* the state must not be 0 */
+    rng->state = seed * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+static inline uint64_t bench_rng_next(bench_rng_t *rng)
+{
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return rng->state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * bench_rng_uniform
+ * gets a uniform value in [0, n)
+ */
+static inline uint64_t bench_rng_uniform(bench_rng_t *rng, uint64_t n)
+{
+    return n == 0 ? 0 : bench_rng_next(rng) % n;
+}
+
+/*
+ * bench_rng_double
+ * gets a uniform value in [0, 1)
+ */
+static inline double bench_rng_double(bench_rng_t *rng)
+{
+    return (double)(bench_rng_next(rng) >> 11) / (double)(1ULL << 53);
+}
+
+/*
+ * bench_zipfian_t
+ * zipfian generator over [0, n) as described by Gray et al. in "Quickly Generating Billion-Record
+ * Synthetic Databases", the same one YCSB uses.  the popular items are scattered over the key
+ * space by hashing so they don't all sit at its start
+ * @param n the number of items
+ * @param theta the skew, 0.99 is the YCSB default
+ * @param alpha 1 / (1 - theta)
+ * @param zetan the zeta of n
+ * @param eta precomputed for generating
+ */
+typedef struct
+{
+    uint64_t n;
+    double theta;
+    double alpha;
+    double zetan;
+    double eta;
+} bench_zipfian_t;
+
+static inline double bench_zeta(uint64_t n, double theta)
+{
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++) sum += 1.0 / pow((double)i, theta);
+    return sum;
+}
+
+static inline void bench_zipfian_init(bench_zipfian_t *z, uint64_t n, double theta)
+{
+    z->n = n > 0 ? n : 1;
+    z->theta = theta;
+    z->alpha = 1.0 / (1.0 - theta);
+    z->zetan = bench_zeta(z->n, theta);
+    double zeta2 = bench_zeta(2, theta);
+    z->eta = (1.0 - pow(2.0 / (double)z->n, 1.0 - theta)) / (1.0 - zeta2 / z->zetan);
+}
+
+/*
+ * bench_fnv1a
+ * 64 bit FNV-1a hash of an integer, used to scatter zipfian items
+ */
+static inline uint64_t bench_fnv1a(uint64_t value)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < 8; i++)
+    {
+        hash ^= value & 0xFF;
+        hash *= 0x100000001B3ULL;
+        value >>= 8;
+    }
+    return hash;
+}
+
+/*
+ * bench_zipfian_rank
+ * gets the popularity rank of the next item, 0 being the most popular
+ */
+static inline uint64_t bench_zipfian_rank(bench_zipfian_t *z, bench_rng_t *rng)
+{
+    double u = bench_rng_double(rng);
+    double uz = u * z->zetan;
+
+    uint64_t item;
+    if (uz < 1.0)
+        item = 0;
+    else if (uz < 1.0 + pow(0.5, z->theta))
+        item = 1;
+    else
+        item = (uint64_t)((double)z->n * pow(z->eta * u - z->eta + 1.0, z->alpha));
+    if (item >= z->n) item = z->n - 1;
+
+    return item;
+}
+
+/*
+ * bench_zipfian_next
+ * gets the next item, the ranks are scattered over [0, n)
+ */
+static inline uint64_t bench_zipfian_next(bench_zipfian_t *z, bench_rng_t *rng)
+{
+    return bench_fnv1a(bench_zipfian_rank(z, rng)) % z->n;
+}
+
+#endif /* __BENCH_UTILS_H__ */
@@ -0,0 +1,642 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/block_manager.h"
+#include "../src/bloom_filter.h"
+#include "../src/compress.h"
+#include "../src/hash_table.h"
+#include "../src/skip_list.h"
+#include "../test/test_macros.h"
+#include "bench_utils.h"
+
+/*
+ * microbenchmarks of the data structures under TidesDB, each result is printed as a csv row or a
+ * json object per line so runs can be kept per commit and compared
+ *
+ * tidesdb_micro_bench --suites=skip_list,bloom_filter --sizes=1000000,10000000 --format=json
+ *
+ * run with --help for every flag
+ */
+
+#define MICRO_DEFAULT_SUITES "skip_list,hash_table,bloom_filter,compress,block_manager"
+#define MICRO_KEY_SIZE       16
+#define MICRO_VALUE_SIZE     8
+#define MICRO_MAX_LIST       16
+
+/*
+ * micro_options_t
+ * the command line flags
+ */
+typedef struct
+{
+    const char *suites;
+    uint64_t sizes[MICRO_MAX_LIST];
+    int num_sizes;
+    uint64_t block_sizes[MICRO_MAX_LIST];
+    int num_block_sizes;
+    uint64_t compress_bytes;
+    uint64_t blocks;
+    double bloom_fpr;
+    bool json;
+    const char *label;
+    const char *dir;
+    uint64_t seed;
+} micro_options_t;
+
+/*
+ * micro_result_t
+ * a measured operation
+ * @param suite the data structure
+ * @param name the operation
+ * @param codec the codec for compression results, NULL otherwise
+ * @param entries the entries in the structure
+ * @param block_size the block size for compression and block manager results, 0 otherwise
+ * @param ops the operations timed
+ * @param elapsed_ns the time they took
+ * @param bytes the bytes they processed, 0 when throughput in bytes means nothing
+ * @param metric the name of an extra measurement such as a ratio, NULL for none
+ * @param metric_value the extra measurement
+ */
+typedef struct
+{
+    const char *suite;
+    const char *name;
+    const char *codec;
+    uint64_t entries;
+    uint64_t block_size;
+    uint64_t ops;
+    uint64_t elapsed_ns;
+    uint64_t bytes;
+    const char *metric;
+    double metric_value;
+} micro_result_t;
+
+static micro_options_t options;
+
+static void micro_print_header(void)
+{
+    if (options.json) return;
+    printf("label,suite,name,codec,entries,block_size,ops,ns_per_op,ops_per_sec,mb_per_sec,metric,"
+           "metric_value\n");
+}
+
+static void micro_print(const micro_result_t *r)
+{
+    double seconds = (double)r->elapsed_ns / 1e9;
+    double ns_per_op = r->ops > 0 ? (double)r->elapsed_ns / (double)r->ops : 0.0;
+    double ops_per_sec = seconds > 0 ? (double)r->ops / seconds : 0.0;
+    double mb_per_sec = seconds > 0 ? (double)r->bytes / (1024.0 * 1024.0) / seconds : 0.0;
+
+    if (options.json)
+    {
+        printf("{\"label\":\"%s\",\"suite\":\"%s\",\"name\":\"%s\",\"codec\":\"%s\","
+               "\"entries\":%" PRIu64 ",\"block_size\":%" PRIu64 ",\"ops\":%" PRIu64
+               ",\"ns_per_op\":%.3f,\"ops_per_sec\":%.1f,\"mb_per_sec\":%.3f",
+               options.label, r->suite, r->name, r->codec ? r->codec : "", r->entries,
+               r->block_size, r->ops, ns_per_op, ops_per_sec, mb_per_sec);
+        if (r->metric != NULL) printf(",\"%s\":%.6f", r->metric, r->metric_value);
+        printf("}\n");
+    }
+    else
+    {
+        printf("%s,%s,%s,%s,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.3f,%.1f,%.3f,%s,", options.label,
+               r->suite, r->name, r->codec ? r->codec : "", r->entries, r->block_size, r->ops,
+               ns_per_op, ops_per_sec, mb_per_sec, r->metric ? r->metric : "");
+        if (r->metric != NULL) printf("%.6f", r->metric_value);
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+/*
+ * micro_key
+ * formats the key of an entry, entries are hashed so inserts arrive in random key order
+ */
+static void micro_key(uint64_t entry, uint8_t *key)
+{
+    char hex[MICRO_KEY_SIZE + 1];
+    (void)snprintf(hex, sizeof(hex), "%016" PRIx64, bench_fnv1a(entry));
+    memcpy(key, hex, MICRO_KEY_SIZE);
+}
+
+static void micro_skip_list(uint64_t n)
+{
+    uint8_t key[MICRO_KEY_SIZE];
+    uint8_t value[MICRO_VALUE_SIZE] = {0};
+    micro_result_t r = {.suite = "skip_list", .entries = n};
+
+    skip_list_t *list = skip_list_new(12, 0.24f);
+    if (list == NULL) return;
+
+    uint64_t start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        micro_key(i, key);
+        (void)skip_list_put(list, key, sizeof(key), value, sizeof(value), -1);
+    }
+    r.name = "insert";
+    r.ops = n;
+    r.elapsed_ns = bench_now_ns() - start;
+    r.bytes = n * (sizeof(key) + sizeof(value));
+    micro_print(&r);
+
+    uint64_t found = 0;
+    start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        micro_key(i, key);
+        uint8_t *v = NULL;
+        size_t v_size;
+        if (skip_list_get(list, key, sizeof(key), &v, &v_size) == 0) found++;
+        free(v);
+    }
+    r.name = "lookup";
+    r.elapsed_ns = bench_now_ns() - start;
+    r.metric = "found";
+    r.metric_value = (double)found / (double)n;
+    micro_print(&r);
+
+    start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        micro_key(n + i, key);
+        uint8_t *v = NULL;
+        size_t v_size;
+        if (skip_list_get(list, key, sizeof(key), &v, &v_size) == 0) free(v);
+    }
+    r.name = "lookup_missing";
+    r.elapsed_ns = bench_now_ns() - start;
+    r.bytes = n * sizeof(key);
+    r.metric = NULL;
+    micro_print(&r);
+
+    (void)skip_list_destroy(list);
+}
+
+static void micro_hash_table(uint64_t n)
+{
+    uint8_t key[MICRO_KEY_SIZE];
+    uint8_t value[MICRO_VALUE_SIZE] = {0};
+    micro_result_t r = {.suite = "hash_table", .entries = n};
+
+    hash_table_t *ht = NULL;
+    if (hash_table_new(&ht) != 0) return;
+
+    /* the puts grow the table, their time includes the resizes */
+    uint64_t start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        micro_key(i, key);
+        (void)hash_table_put(&ht, key, sizeof(key), value, sizeof(value), -1);
+    }
+    r.name = "put";
+    r.ops = n;
+    r.elapsed_ns = bench_now_ns() - start;
+    r.bytes = n * (sizeof(key) + sizeof(value));
+    micro_print(&r);
+
+    uint64_t found = 0;
+    start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        micro_key(i, key);
+        uint8_t *v = NULL;
+        size_t v_size;
+        if (hash_table_get(ht, key, sizeof(key), &v, &v_size) == 0) found++;
+        free(v);
+    }
+    r.name = "get";
+    r.elapsed_ns = bench_now_ns() - start;
+    r.metric = "found";
+    r.metric_value = (double)found / (double)n;
+    micro_print(&r);
+
+    /* a single resize of the full table to twice its buckets */
+    size_t buckets = ht->bucket_count;
+    start = bench_now_ns();
+    int rc = hash_table_resize(&ht, buckets * 2);
+    r.name = "resize";
+    r.ops = 1;
+    r.bytes = 0;
+    r.elapsed_ns = bench_now_ns() - start;
+    r.metric = "buckets";
+    r.metric_value = (double)(buckets * 2);
+    if (rc == 0) micro_print(&r);
+
+    hash_table_destroy(ht);
+}
+
+static void micro_bloom_filter(uint64_t n)
+{
+    uint8_t key[MICRO_KEY_SIZE];
+    micro_result_t r = {.suite = "bloom_filter", .entries = n};
+
+    if (n > INT32_MAX) return;
+
+    bloom_filter_t *bf = NULL;
+    if (bloom_filter_new(&bf, options.bloom_fpr, (int)n) != 0) return;
+
+    uint64_t start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        micro_key(i, key);
+        bloom_filter_add(bf, key, sizeof(key));
+    }
+    r.name = "add";
+    r.ops = n;
+    r.elapsed_ns = bench_now_ns() - start;
+    r.bytes = n * sizeof(key);
+    micro_print(&r);
+
+    uint64_t hits = 0;
+    start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        micro_key(i, key);
+        hits += (uint64_t)bloom_filter_contains(bf, key, sizeof(key));
+    }
+    r.name = "contains";
+    r.elapsed_ns = bench_now_ns() - start;
+    r.metric = "found";
+    r.metric_value = (double)hits / (double)n;
+    micro_print(&r);
+
+    /* keys that were never added, every hit is a false positive */
+    hits = 0;
+    start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        micro_key(n + i, key);
+        hits += (uint64_t)bloom_filter_contains(bf, key, sizeof(key));
+    }
+    r.name = "contains_missing";
+    r.elapsed_ns = bench_now_ns() - start;
+    r.metric = "false_positive_rate";
+    r.metric_value = (double)hits / (double)n;
+    micro_print(&r);
+
+    size_t size = 0;
+    uint8_t *serialized = bloom_filter_serialize(bf, &size);
+    free(serialized);
+    r.name = "size";
+    r.ops = 0;
+    r.elapsed_ns = 0;
+    r.bytes = 0;
+    r.metric = "bits_per_key";
+    r.metric_value = (double)size * 8.0 / (double)n;
+    micro_print(&r);
+
+    bloom_filter_free(bf);
+}
+
+/*
+ * micro_fill_compressible
+ * fills a buffer with text-like data, words from a small vocabulary, so codecs have something to
+ * find without the data being trivially repetitive
+ */
+static void micro_fill_compressible(uint8_t *buf, size_t size, bench_rng_t *rng)
+{
+    static const char *words[] = {"tides", "key",    "value",  "column", "family", "sstable",
+                                  "merge", "bloom",  "filter", "block",  "cursor", "flush",
+                                  "wal",   "shard",  "level",  "ttl",    "delete", "compact",
+                                  "seek",  "memory", "table",  "skip",   "list",   "hash"};
+    size_t num_words = sizeof(words) / sizeof(words[0]);
+
+    size_t pos = 0;
+    while (pos < size)
+    {
+        const char *word = words[bench_rng_uniform(rng, num_words)];
+        for (size_t i = 0; word[i] != '\0' && pos < size; i++) buf[pos++] = (uint8_t)word[i];
+        if (pos < size) buf[pos++] = bench_rng_uniform(rng, 8) == 0 ? '\n' : ' ';
+
+        /* some numbers, like the ids and timestamps real values carry */
+        if (pos + 8 < size && bench_rng_uniform(rng, 4) == 0)
+            pos += (size_t)snprintf((char *)buf + pos, 9, "%08" PRIu64,
+                                    bench_rng_uniform(rng, 100000000));
+    }
+}
+
+static void micro_compress(uint64_t block_size)
+{
+    static const struct
+    {
+        const char *name;
+        compress_type type;
+    } codecs[] = {{"snappy", COMPRESS_SNAPPY}, {"lz4", COMPRESS_LZ4}, {"zstd", COMPRESS_ZSTD}};
+
+    uint64_t blocks = options.compress_bytes / block_size;
+    if (blocks == 0) blocks = 1;
+
+    uint8_t *data = malloc(block_size * blocks);
+    uint8_t **compressed = calloc(blocks, sizeof(uint8_t *));
+    size_t *compressed_sizes = calloc(blocks, sizeof(size_t));
+    if (data == NULL || compressed == NULL || compressed_sizes == NULL)
+    {
+        free(data);
+        free(compressed);
+        free(compressed_sizes);
+        return;
+    }
+
+    bench_rng_t rng;
+    bench_rng_seed(&rng, options.seed);
+    micro_fill_compressible(data, block_size * blocks, &rng);
+
+    for (size_t c = 0; c < sizeof(codecs) / sizeof(codecs[0]); c++)
+    {
+        micro_result_t r = {.suite = "compress",
+                            .codec = codecs[c].name,
+                            .entries = blocks,
+                            .block_size = block_size,
+                            .ops = blocks,
+                            .bytes = blocks * block_size};
+
+        uint64_t total = 0;
+        uint64_t start = bench_now_ns();
+        for (uint64_t i = 0; i < blocks; i++)
+        {
+            compressed[i] = compress_data(data + i * block_size, block_size, &compressed_sizes[i],
+                                          codecs[c].type);
+            total += compressed_sizes[i];
+        }
+        r.name = "compress";
+        r.elapsed_ns = bench_now_ns() - start;
+        r.metric = "ratio";
+        r.metric_value = total > 0 ? (double)(blocks * block_size) / (double)total : 0.0;
+        micro_print(&r);
+
+        start = bench_now_ns();
+        for (uint64_t i = 0; i < blocks; i++)
+        {
+            size_t size = 0;
+            if (compressed[i] == NULL) continue;
+            free(decompress_data(compressed[i], compressed_sizes[i], &size, codecs[c].type));
+        }
+        r.name = "decompress";
+        r.elapsed_ns = bench_now_ns() - start;
+        r.metric = NULL;
+        micro_print(&r);
+
+        for (uint64_t i = 0; i < blocks; i++)
+        {
+            free(compressed[i]);
+            compressed[i] = NULL;
+        }
+    }
+
+    free(data);
+    free(compressed);
+    free(compressed_sizes);
+}
+
+static void micro_block_manager(uint64_t block_size)
+{
+    char path[MAX_FILE_PATH_LENGTH];
+    (void)snprintf(path, sizeof(path), "%s/micro_bench.%d.blocks", options.dir, (int)getpid());
+    (void)remove(path);
+
+    uint64_t n = options.blocks;
+    micro_result_t r = {.suite = "block_manager",
+                        .entries = n,
+                        .block_size = block_size,
+                        .ops = n,
+                        .bytes = n * block_size};
+
+    uint8_t *data = malloc(block_size);
+    block_manager_t *bm = NULL;
+    if (data == NULL || block_manager_open(&bm, path, 0) != 0)
+    {
+        free(data);
+        return;
+    }
+
+    bench_rng_t rng;
+    bench_rng_seed(&rng, options.seed);
+    for (uint64_t i = 0; i < block_size; i++) data[i] = (uint8_t)(bench_rng_next(&rng) >> 56);
+
+    /* the write time includes the final sync, as a flush would pay it */
+    uint64_t start = bench_now_ns();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        block_manager_block_t *block = block_manager_block_create(block_size, data);
+        if (block == NULL) break;
+        (void)block_manager_block_write(bm, block);
+        block_manager_block_free(block);
+    }
+    (void)block_manager_sync(bm);
+    r.name = "write_seq";
+    r.elapsed_ns = bench_now_ns() - start;
+    micro_print(&r);
+
+    block_manager_cursor_t *cursor = NULL;
+    if (block_manager_cursor_init(&cursor, bm) == 0)
+    {
+        start = bench_now_ns();
+        for (uint64_t i = 0; i < n; i++)
+        {
+            block_manager_block_t *block = block_manager_cursor_read(cursor);
+            if (block == NULL) break;
+            block_manager_block_free(block);
+            (void)block_manager_cursor_next(cursor);
+        }
+        r.name = "read_seq";
+        r.elapsed_ns = bench_now_ns() - start;
+        micro_print(&r);
+
+        /* blocks are a size prefix and the data so their offsets follow from the index */
+        start = bench_now_ns();
+        for (uint64_t i = 0; i < n; i++)
+        {
+            cursor->current_pos = bench_rng_uniform(&rng, n) * (sizeof(uint64_t) + block_size);
+            block_manager_block_t *block = block_manager_cursor_read(cursor);
+            if (block == NULL) break;
+            block_manager_block_free(block);
+        }
+        r.name = "read_random";
+        r.elapsed_ns = bench_now_ns() - start;
+        micro_print(&r);
+
+        block_manager_cursor_free(cursor);
+    }
+
+    (void)block_manager_close(bm);
+    (void)remove(path);
+    free(data);
+}
+
+static void micro_usage(void)
+{
+    printf("usage: tidesdb_micro_bench [--flag=value ...]\n"
+           "  --suites=list              comma separated, run in order (%s)\n"
+           "  --sizes=list               entries for skip_list, hash_table and bloom_filter "
+           "(1000000)\n"
+           "  --block_sizes=list         block sizes for compress and block_manager "
+           "(4096,65536)\n"
+           "  --compress_bytes=n         bytes compressed per codec and block size (16777216)\n"
+           "  --blocks=n                 blocks written and read by block_manager (10000)\n"
+           "  --bloom_fpr=f              bloom filter false positive rate (0.01)\n"
+           "  --format                   csv or json, json is one object per line (csv)\n"
+           "  --label=text               added to every result, such as a commit hash\n"
+           "  --dir=path                 directory for block_manager files (.)\n"
+           "  --seed=n                   random seed (1)\n",
+           MICRO_DEFAULT_SUITES);
+}
+
+/*
+ * micro_parse_list
+ * parses a comma separated list of numbers
+ */
+static bool micro_parse_list(const char *value, uint64_t *list, int *count)
+{
+    *count = 0;
+    while (*value != '\0')
+    {
+        char *end = NULL;
+        uint64_t n = strtoull(value, &end, 10);
+        if (end == value || n == 0 || *count == MICRO_MAX_LIST) return false;
+        list[(*count)++] = n;
+
+        if (*end == '\0') break;
+        if (*end != ',') return false;
+        value = end + 1;
+    }
+    return *count > 0;
+}
+
+static bool micro_parse_flag(const char *arg)
+{
+    if (strncmp(arg, "--", 2) != 0) return false;
+
+    const char *eq = strchr(arg, '=');
+    if (eq == NULL) return false;
+
+    size_t len = (size_t)(eq - arg - 2);
+    const char *name = arg + 2;
+    const char *value = eq + 1;
+    char *end = NULL;
+
+#define MICRO_FLAG(flag) (len == strlen(flag) && strncmp(name, flag, len) == 0)
+
+    if (MICRO_FLAG("suites"))
+    {
+        options.suites = value;
+        return true;
+    }
+    if (MICRO_FLAG("label"))
+    {
+        options.label = value;
+        return true;
+    }
+    if (MICRO_FLAG("dir"))
+    {
+        options.dir = value;
+        return true;
+    }
+    if (MICRO_FLAG("format"))
+    {
+        options.json = strcmp(value, "json") == 0;
+        return options.json || strcmp(value, "csv") == 0;
+    }
+    if (MICRO_FLAG("sizes")) return micro_parse_list(value, options.sizes, &options.num_sizes);
+    if (MICRO_FLAG("block_sizes"))
+        return micro_parse_list(value, options.block_sizes, &options.num_block_sizes);
+    if (MICRO_FLAG("bloom_fpr"))
+    {
+        options.bloom_fpr = strtod(value, &end);
+        return *end == '\0' && options.bloom_fpr > 0 && options.bloom_fpr < 1;
+    }
+
+    uint64_t n = strtoull(value, &end, 10);
+    if (*value == '\0' || *end != '\0') return false;
+    if (MICRO_FLAG("compress_bytes")) return (options.compress_bytes = n) > 0;
+    if (MICRO_FLAG("blocks")) return (options.blocks = n) > 0;
+    if (MICRO_FLAG("seed")) return ((options.seed = n), true);
+
+#undef MICRO_FLAG
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    options = (micro_options_t){.suites = MICRO_DEFAULT_SUITES,
+                                .sizes = {1000000},
+                                .num_sizes = 1,
+                                .block_sizes = {4096, 65536},
+                                .num_block_sizes = 2,
+                                .compress_bytes = 16 * 1024 * 1024,
+                                .blocks = 10000,
+                                .bloom_fpr = 0.01,
+                                .label = "",
+                                .dir = ".",
+                                .seed = 1};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            micro_usage();
+            return 0;
+        }
+        if (!micro_parse_flag(argv[i]))
+        {
+            fprintf(stderr, RED "invalid flag %s\n" RESET, argv[i]);
+            micro_usage();
+            return 1;
+        }
+    }
+
+    micro_print_header();
+
+    int rc = 0;
+    char *list = strdup(options.suites);
+    char *save = NULL;
+    for (char *suite = strtok_r(list, ",", &save); suite != NULL;
+         suite = strtok_r(NULL, ",", &save))
+    {
+        bool sized = true;
+        void (*fn)(uint64_t) = NULL;
+        if (strcmp(suite, "skip_list") == 0) fn = micro_skip_list;
+        if (strcmp(suite, "hash_table") == 0) fn = micro_hash_table;
+        if (strcmp(suite, "bloom_filter") == 0) fn = micro_bloom_filter;
+        if (strcmp(suite, "compress") == 0) fn = micro_compress, sized = false;
+        if (strcmp(suite, "block_manager") == 0) fn = micro_block_manager, sized = false;
+
+        if (fn == NULL)
+        {
+            fprintf(stderr, RED "unknown suite %s\n" RESET, suite);
+            rc = 1;
+            break;
+        }
+
+        /* the data structures run per size, the block suites per block size */
+        uint64_t *params = sized ? options.sizes : options.block_sizes;
+        int count = sized ? options.num_sizes : options.num_block_sizes;
+        for (int i = 0; i < count; i++) fn(params[i]);
+    }
+
+    free(list);
+    return rc;
+}
@@ -16,298 +16,922 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <inttypes.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #include "../src/tidesdb.h"
 #include "../test/test_macros.h"
-#include "../test/test_utils.h"
+#include "bench_utils.h"
 
-/* test constants */
-#define NUM_OPERATIONS         500000 /* number of operations per thread */
-#define NUM_THREADS            2 /* you can increase this to test with more threads, usually slower */
-#define SIZE                   (1024 * 1024) /* key and value size, 1MB */
-#define DIR                    "benchmark_db"
-#define FLUSH_THRESHOLD        ((1024 * 1024) * 64)
-#define THREADS_FOR_COMPACTION 2
+/*
+ * a db_bench style benchmark, workloads are picked on the command line and run in order against
+ * the same database
+ *
+ * tidesdb_bench --benchmarks=fillseq,readrandom --num=1000000 --threads=4 --distribution=zipfian
+ *
+ * run with --help for every flag
+ */
+
+#define BENCH_DEFAULT_BENCHMARKS \
+    "fillseq,readrandom,readseq,seekrandom,multiget,fillrandom,overwrite,readwhilewriting," \
+    "deleterandom"
+#define BENCH_CF_NAME         "bench_cf"
+#define BENCH_VALUE_POOL_SIZE (1024 * 1024) /* random bytes values are sliced from */
+#define BENCH_MAX_THREADS     256
 
 /*
- * thread_arg_t
- * @param tdb the tidesdb instance
- * @param column_family_name the column family name
- * @param thread_id the thread id
+ * bench_options_t
+ * the command line flags
  */
 typedef struct
 {
+    const char *benchmarks;
+    const char *db;
+    bool use_existing_db;
+    uint64_t num;
+    uint64_t reads;
+    uint64_t writes;
+    int threads;
+    size_t key_size;
+    size_t value_size;
+    bool value_size_uniform;
+    size_t value_size_min;
+    size_t value_size_max;
+    bool zipfian;
+    double zipf_theta;
+    int batch_size;
+    uint64_t seed;
+    int flush_threshold;
+    bool compressed;
+    tidesdb_compression_algo_t compress_algo;
+    bool bloom_filter;
+    tidesdb_filter_type_t filter_type;
+    bool partitioned_index;
+    bool hash_index;
+    bool learned_index;
+    tidesdb_memtable_ds_t memtable_ds;
+    int memtable_shards;
+    int compaction_threads;
+    bool json;
+    tidesdb_config_t config;
+} bench_options_t;
+
+/*
+ * bench_t
+ * state shared by the threads of a benchmark
+ */
+typedef struct
+{
+    bench_options_t *options;
     tidesdb_t *tdb;
-    const char *column_family_name;
-    int thread_id;
-} thread_arg_t;
+    tidesdb_cf_handle_t *handle;
+    tidesdb_async_t *async;
+    uint8_t *value_pool;
+    bench_zipfian_t zipfian;
+    atomic_bool stop; /* set when the measured threads are done, stops background writers */
+} bench_t;
+
+/*
+ * bench_thread_t
+ * the state and results of a benchmark thread
+ */
+typedef struct
+{
+    bench_t *bench;
+    int id;
+    uint64_t ops; /* operations to run */
+    bench_rng_t rng;
+    bench_histogram_t histogram;
+    uint64_t done;  /* operations run */
+    uint64_t found; /* reads that found their key */
+    uint64_t bytes; /* key and value bytes written or read */
+    pthread_t thread;
+} bench_thread_t;
+
+typedef void (*bench_fn_t)(bench_thread_t *thread);
+
+/*
+ * bench_key
+ * formats a key index as a zero padded decimal of key_size bytes so keys sort by index
+ */
+static void bench_key(bench_options_t *options, uint64_t index, uint8_t *key)
+{
+    char digits[32];
+    int len = snprintf(digits, sizeof(digits), "%020" PRIu64, index);
+
+    /* we keep the low digits, the key size was checked to hold every index */
+    size_t n = options->key_size < (size_t)len ? options->key_size : (size_t)len;
+    memset(key, '0', options->key_size);
+    memcpy(key + options->key_size - n, digits + len - n, n);
+}
+
+/*
+ * bench_next_key
+ * picks a key index from the configured distribution
+ */
+static uint64_t bench_next_key(bench_thread_t *thread)
+{
+    bench_t *bench = thread->bench;
+    if (bench->options->zipfian) return bench_zipfian_next(&bench->zipfian, &thread->rng);
+    return bench_rng_uniform(&thread->rng, bench->options->num);
+}
+
+/*
+ * bench_next_value
+ * picks a value from the value pool with a size from the configured distribution
+ */
+static const uint8_t *bench_next_value(bench_thread_t *thread, size_t *value_size)
+{
+    bench_options_t *options = thread->bench->options;
+
+    *value_size = options->value_size;
+    if (options->value_size_uniform)
+        *value_size =
+            options->value_size_min +
+            bench_rng_uniform(&thread->rng, options->value_size_max - options->value_size_min + 1);
+
+    uint64_t offset = bench_rng_uniform(&thread->rng, BENCH_VALUE_POOL_SIZE - *value_size + 1);
+    return thread->bench->value_pool + offset;
+}
 
-void pad_key_with_nines(uint8_t *key, size_t target_len)
+/*
+ * bench_put
+ * writes a key and records the latency
+ */
+static void bench_put(bench_thread_t *thread, uint64_t index)
 {
-    size_t current_len = strlen((char *)key);
-    if (current_len < target_len)
+    uint8_t key[thread->bench->options->key_size];
+    bench_key(thread->bench->options, index, key);
+
+    size_t value_size;
+    const uint8_t *value = bench_next_value(thread, &value_size);
+
+    uint64_t start = bench_now_ns();
+    int rc = tidesdb_put_status(thread->bench->handle, key, sizeof(key), value, value_size, -1);
+    bench_histogram_add(&thread->histogram, bench_now_ns() - start);
+
+    if (rc != TIDESDB_SUCCESS)
+        fprintf(stderr, RED "put failed: %s" RESET, tidesdb_err_message(rc));
+
+    thread->done++;
+    thread->bytes += sizeof(key) + value_size;
+}
+
+static void bench_fillseq(bench_thread_t *thread)
+{
+    /* each thread writes its own slice of the key space in order */
+    uint64_t first = thread->ops * (uint64_t)thread->id;
+    for (uint64_t i = 0; i < thread->ops; i++) bench_put(thread, first + i);
+}
+
+static void bench_fillrandom(bench_thread_t *thread)
+{
+    for (uint64_t i = 0; i < thread->ops; i++)
+        bench_put(thread, bench_rng_uniform(&thread->rng, thread->bench->options->num));
+}
+
+static void bench_overwrite(bench_thread_t *thread)
+{
+    for (uint64_t i = 0; i < thread->ops; i++) bench_put(thread, bench_next_key(thread));
+}
+
+static void bench_readrandom(bench_thread_t *thread)
+{
+    bench_options_t *options = thread->bench->options;
+    uint8_t key[options->key_size];
+
+    for (uint64_t i = 0; i < thread->ops; i++)
     {
-        memset(key + current_len, '9', target_len - current_len);
-        key[target_len] = '\0';
+        bench_key(options, bench_next_key(thread), key);
+
+        uint8_t *value = NULL;
+        size_t value_size = 0;
+
+        uint64_t start = bench_now_ns();
+        int rc = tidesdb_get_status(thread->bench->handle, key, sizeof(key), &value, &value_size);
+        bench_histogram_add(&thread->histogram, bench_now_ns() - start);
+
+        thread->done++;
+        if (rc != TIDESDB_SUCCESS) continue;
+
+        thread->found++;
+        thread->bytes += sizeof(key) + value_size;
+        free(value);
     }
 }
 
-void create_key(uint8_t *key, int index)
+static void bench_deleterandom(bench_thread_t *thread)
 {
-    snprintf((char *)key, SIZE, "key%03d", index);
-    pad_key_with_nines(key, SIZE - 1);
+    bench_options_t *options = thread->bench->options;
+    uint8_t key[options->key_size];
+
+    for (uint64_t i = 0; i < thread->ops; i++)
+    {
+        bench_key(options, bench_next_key(thread), key);
+
+        uint64_t start = bench_now_ns();
+        int rc = tidesdb_delete_status(thread->bench->handle, key, sizeof(key));
+        bench_histogram_add(&thread->histogram, bench_now_ns() - start);
+
+        thread->done++;
+        thread->bytes += sizeof(key);
+        if (rc != TIDESDB_SUCCESS && rc != TIDESDB_ERR_KEY_NOT_FOUND)
+            fprintf(stderr, RED "delete failed: %s" RESET, tidesdb_err_message(rc));
+    }
 }
 
-void create_value(uint8_t *value, int index, int thread_id)
+/*
+ * bench_cursor_entry
+ * reads the entry a cursor is on, returns whether there was one
+ */
+static bool bench_cursor_entry(bench_thread_t *thread, tidesdb_cursor_t *cursor)
 {
-    snprintf((char *)value, SIZE, "value%03d_%d", index, thread_id);
-    pad_key_with_nines(value, SIZE - 1);
+    uint8_t *key = NULL;
+    size_t key_size;
+    uint8_t *value = NULL;
+    size_t value_size;
+
+    tidesdb_err_t *err = tidesdb_cursor_get(cursor, &key, &key_size, &value, &value_size);
+    if (err != NULL)
+    {
+        tidesdb_err_free(err);
+        return false;
+    }
+
+    thread->found++;
+    thread->bytes += key_size + value_size;
+    free(key);
+    free(value);
+    return true;
 }
 
-void *benchmark_put(void *arg)
+static void bench_readseq(bench_thread_t *thread)
 {
-    thread_arg_t *targ = arg;
-    tidesdb_t *tdb = targ->tdb;
-    const char *cf_name = targ->column_family_name;
-    int thread_id = targ->thread_id;
+    tidesdb_cursor_t *cursor = NULL;
+    tidesdb_err_t *err = tidesdb_cursor_init_w_handle(thread->bench->handle, &cursor);
+    if (err != NULL)
+    {
+        fprintf(stderr, RED "cursor init failed: %s" RESET, err->message);
+        tidesdb_err_free(err);
+        return;
+    }
 
-    for (int i = 0; i < NUM_OPERATIONS; i++)
+    /* every thread scans from the start, each step is an operation */
+    for (uint64_t i = 0; i < thread->ops; i++)
     {
-        uint8_t key[SIZE];
-        uint8_t value[SIZE];
-        create_key(key, i);
-        create_value(value, i, thread_id);
+        uint64_t start = bench_now_ns();
+        bool read = bench_cursor_entry(thread, cursor);
+        err = read ? tidesdb_cursor_next(cursor) : NULL;
+        bench_histogram_add(&thread->histogram, bench_now_ns() - start);
 
-        tidesdb_err_t *err =
-            tidesdb_put(tdb, cf_name, key, strlen((char *)key), value, strlen((char *)value), -1);
-        if (err != NULL)
-        {
-            printf(RED "Error: %s\n" RESET, err->message);
-            tidesdb_err_free(err);
-        }
+        if (read) thread->done++;
+        if (err == NULL && read) continue;
+
+        if (err != NULL) tidesdb_err_free(err);
+        break; /* the end of the column family */
     }
-    return NULL;
+
+    (void)tidesdb_cursor_free(cursor);
 }
 
-void *benchmark_put_compact(void *arg)
+static void bench_seekrandom(bench_thread_t *thread)
 {
-    thread_arg_t *targ = arg;
-    tidesdb_t *tdb = targ->tdb;
-    const char *cf_name = targ->column_family_name;
-    int thread_id = targ->thread_id;
+    bench_options_t *options = thread->bench->options;
+    uint8_t key[options->key_size];
 
-    for (int i = 0; i < NUM_OPERATIONS; i++)
+    tidesdb_cursor_t *cursor = NULL;
+    tidesdb_err_t *err = tidesdb_cursor_init_w_handle(thread->bench->handle, &cursor);
+    if (err != NULL)
     {
-        uint8_t key[SIZE];
-        uint8_t value[SIZE];
-        create_key(key, i);
-        create_value(value, i, thread_id);
+        fprintf(stderr, RED "cursor init failed: %s" RESET, err->message);
+        tidesdb_err_free(err);
+        return;
+    }
 
-        tidesdb_err_t *err =
-            tidesdb_put(tdb, cf_name, key, strlen((char *)key), value, strlen((char *)value), -1);
-        if (err != NULL)
-        {
-            printf(RED "Error: %s\n" RESET, err->message);
-            tidesdb_err_free(err);
-        }
+    for (uint64_t i = 0; i < thread->ops; i++)
+    {
+        bench_key(options, bench_next_key(thread), key);
 
-        /* compact sstables in the middle of the benchmark */
-        if (i == (NUM_OPERATIONS / 2))
-        {
-            err = tidesdb_compact_sstables(tdb, cf_name, THREADS_FOR_COMPACTION);
-            if (err != NULL)
-            {
-                printf(RED "Error: %s\n" RESET, err->message);
-                tidesdb_err_free(err);
-            }
-        }
+        uint64_t start = bench_now_ns();
+        err = tidesdb_cursor_seek(cursor, key, sizeof(key));
+        if (err == NULL) (void)bench_cursor_entry(thread, cursor);
+        bench_histogram_add(&thread->histogram, bench_now_ns() - start);
+
+        thread->done++;
+        if (err != NULL) tidesdb_err_free(err);
     }
-    return NULL;
+
+    (void)tidesdb_cursor_free(cursor);
 }
 
-void *benchmark_get(void *arg)
+/*
+ * bench_multiget_batch_t
+ * completion state of a multiget batch
+ */
+typedef struct
+{
+    bench_thread_t *thread;
+    int remaining;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} bench_multiget_batch_t;
+
+static void bench_multiget_callback(int status, const uint8_t *key, size_t key_size,
+                                    uint8_t *value, size_t value_size, void *arg)
 {
-    thread_arg_t *targ = arg;
-    tidesdb_t *tdb = targ->tdb;
-    const char *cf_name = targ->column_family_name;
-    int thread_id = targ->thread_id;
+    bench_multiget_batch_t *batch = arg;
 
-    for (int i = 0; i < NUM_OPERATIONS; i++)
+    pthread_mutex_lock(&batch->lock);
+    if (status == TIDESDB_SUCCESS)
     {
-        uint8_t key[SIZE];
-        create_key(key, i);
+        batch->thread->found++;
+        batch->thread->bytes += key_size + value_size;
+    }
+    batch->remaining--;
+    if (batch->remaining == 0) pthread_cond_signal(&batch->cond);
+    pthread_mutex_unlock(&batch->lock);
 
-        uint8_t *value = NULL;
-        size_t value_size = 0;
-        tidesdb_err_t *err =
-            tidesdb_get(tdb, cf_name, key, strlen((char *)key), &value, &value_size);
-        if (err != NULL)
+    (void)key;
+    free(value);
+}
+
+static void bench_multiget(bench_thread_t *thread)
+{
+    bench_options_t *options = thread->bench->options;
+    int batch_size = options->batch_size;
+
+    uint8_t *keys = malloc(options->key_size * (size_t)batch_size);
+    const uint8_t **key_ptrs = malloc(sizeof(uint8_t *) * (size_t)batch_size);
+    size_t *key_sizes = malloc(sizeof(size_t) * (size_t)batch_size);
+    if (keys == NULL || key_ptrs == NULL || key_sizes == NULL)
+    {
+        free(keys);
+        free(key_ptrs);
+        free(key_sizes);
+        return;
+    }
+
+    bench_multiget_batch_t batch = {.thread = thread};
+    pthread_mutex_init(&batch.lock, NULL);
+    pthread_cond_init(&batch.cond, NULL);
+
+    for (uint64_t i = 0; i < thread->ops; i += (uint64_t)batch_size)
+    {
+        int n = thread->ops - i < (uint64_t)batch_size ? (int)(thread->ops - i) : batch_size;
+        for (int k = 0; k < n; k++)
         {
-            printf(RED "Error: %s\n" RESET, err->message);
-            tidesdb_err_free(err);
-            continue;
+            key_ptrs[k] = keys + options->key_size * (size_t)k;
+            key_sizes[k] = options->key_size;
+            bench_key(options, bench_next_key(thread), keys + options->key_size * (size_t)k);
         }
-        if (value != NULL)
+
+        batch.remaining = n;
+
+        /* the latency is of the whole batch */
+        uint64_t start = bench_now_ns();
+        tidesdb_err_t *err = tidesdb_multi_get_async(thread->bench->async, thread->bench->handle,
+                                                     key_ptrs, key_sizes, n,
+                                                     bench_multiget_callback, &batch);
+        if (err != NULL)
         {
-            free(value);
-            value = NULL;
+            fprintf(stderr, RED "multi get failed: %s" RESET, err->message);
+            tidesdb_err_free(err);
+            break;
         }
+
+        pthread_mutex_lock(&batch.lock);
+        while (batch.remaining > 0) pthread_cond_wait(&batch.cond, &batch.lock);
+        pthread_mutex_unlock(&batch.lock);
+        bench_histogram_add(&thread->histogram, bench_now_ns() - start);
+
+        thread->done += (uint64_t)n;
     }
+
+    pthread_cond_destroy(&batch.cond);
+    pthread_mutex_destroy(&batch.lock);
+    free(keys);
+    free(key_ptrs);
+    free(key_sizes);
+}
+
+static void bench_writer(bench_thread_t *thread)
+{
+    /* we overwrite until the readers are done, the writes are not part of the results */
+    while (!atomic_load(&thread->bench->stop)) bench_put(thread, bench_next_key(thread));
+}
+
+static void bench_compact(bench_thread_t *thread)
+{
+    uint64_t start = bench_now_ns();
+    tidesdb_err_t *err = tidesdb_compact_sstables_w_handle(
+        thread->bench->handle, thread->bench->options->compaction_threads);
+    bench_histogram_add(&thread->histogram, bench_now_ns() - start);
+
+    thread->done++;
+    if (err == NULL) return;
+
+    /* too few sstables is not worth failing the run over */
+    if (err->code != TIDESDB_ERR_INVALID_SSTABLES_FOR_COMPACTION)
+        fprintf(stderr, RED "compaction failed: %s" RESET, err->message);
+    tidesdb_err_free(err);
+}
+
+/*
+ * bench_workload_t
+ * a named benchmark
+ * @param name the name given to --benchmarks
+ * @param fn the function each thread runs
+ * @param writes whether the operation count is --writes rather than --reads
+ * @param background_writer whether a writer runs alongside the threads until they are done
+ */
+typedef struct
+{
+    const char *name;
+    bench_fn_t fn;
+    bool writes;
+    bool background_writer;
+} bench_workload_t;
+
+static const bench_workload_t bench_workloads[] = {
+    {"fillseq", bench_fillseq, true, false},
+    {"fillrandom", bench_fillrandom, true, false},
+    {"overwrite", bench_overwrite, true, false},
+    {"readrandom", bench_readrandom, false, false},
+    {"readseq", bench_readseq, false, false},
+    {"seekrandom", bench_seekrandom, false, false},
+    {"readwhilewriting", bench_readrandom, false, true},
+    {"multiget", bench_multiget, false, false},
+    {"deleterandom", bench_deleterandom, true, false},
+    {"compact", bench_compact, false, false},
+};
+
+typedef struct
+{
+    bench_thread_t *thread;
+    bench_fn_t fn;
+} bench_thread_arg_t;
+
+static void *bench_thread_main(void *arg)
+{
+    bench_thread_arg_t *targ = arg;
+    targ->fn(targ->thread);
     return NULL;
 }
 
-void *benchmark_delete(void *arg)
+static void bench_thread_init(bench_t *bench, bench_thread_t *thread, int id, uint64_t ops)
+{
+    memset(thread, 0, sizeof(*thread));
+    thread->bench = bench;
+    thread->id = id;
+    thread->ops = ops;
+    bench_rng_seed(&thread->rng, bench->options->seed + (uint64_t)id * 0x9e3779b97f4a7c15ULL);
+    bench_histogram_init(&thread->histogram);
+}
+
+/*
+ * bench_run
+ * runs a benchmark on the configured threads and prints its results
+ */
+static void bench_run(bench_t *bench, const bench_workload_t *workload)
 {
-    thread_arg_t *targ = arg;
-    tidesdb_t *tdb = targ->tdb;
-    const char *cf_name = targ->column_family_name;
-    /* int thread_id = targ->thread_id; could be used for debugging if need be */
+    bench_options_t *options = bench->options;
+    int threads = options->threads;
+
+    /* compaction is a single call however many threads are asked for */
+    if (workload->fn == bench_compact) threads = 1;
+
+    uint64_t total = workload->writes ? options->writes : options->reads;
+    if (workload->fn == bench_compact) total = 1;
+
+    bench_thread_t *state = calloc((size_t)threads + 1, sizeof(bench_thread_t));
+    bench_thread_arg_t *args = calloc((size_t)threads + 1, sizeof(bench_thread_arg_t));
+    if (state == NULL || args == NULL)
+    {
+        free(state);
+        free(args);
+        return;
+    }
 
-    for (int i = 0; i < NUM_OPERATIONS; i++)
+    /* we split the operations across the threads, the first threads take the remainder */
+    for (int i = 0; i < threads; i++)
     {
-        uint8_t key[SIZE];
-        create_key(key, i);
+        uint64_t ops = total / (uint64_t)threads + ((uint64_t)i < total % (uint64_t)threads);
+        bench_thread_init(bench, &state[i], i, ops);
+        args[i] = (bench_thread_arg_t){&state[i], workload->fn};
+    }
 
-        tidesdb_err_t *err = tidesdb_delete(tdb, cf_name, key, strlen((char *)key));
-        if (err != NULL)
-        {
-            printf(RED "Error: %s\n" RESET, err->message);
-            tidesdb_err_free(err);
-        }
+    if (workload->fn == bench_fillseq)
+    {
+        /* the slices must cover the key space in order so every thread takes the same count */
+        for (int i = 0; i < threads; i++) state[i].ops = total / (uint64_t)threads;
+        state[threads - 1].ops += total % (uint64_t)threads;
     }
-    return NULL;
+
+    atomic_store(&bench->stop, false);
+    if (workload->background_writer)
+    {
+        bench_thread_init(bench, &state[threads], threads, 0);
+        args[threads] = (bench_thread_arg_t){&state[threads], bench_writer};
+        (void)pthread_create(&state[threads].thread, NULL, bench_thread_main, &args[threads]);
+    }
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < threads; i++)
+        (void)pthread_create(&state[i].thread, NULL, bench_thread_main, &args[i]);
+    for (int i = 0; i < threads; i++) (void)pthread_join(state[i].thread, NULL);
+    uint64_t elapsed = bench_now_ns() - start;
+
+    atomic_store(&bench->stop, true);
+    if (workload->background_writer) (void)pthread_join(state[threads].thread, NULL);
+
+    bench_histogram_t histogram;
+    bench_histogram_init(&histogram);
+    uint64_t done = 0;
+    uint64_t found = 0;
+    uint64_t bytes = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        bench_histogram_merge(&histogram, &state[i].histogram);
+        done += state[i].done;
+        found += state[i].found;
+        bytes += state[i].bytes;
+    }
+
+    double seconds = (double)elapsed / 1e9;
+    if (options->json)
+    {
+        /* one object per workload so scripts can compare runs, see cmake/PerfCheck.cmake */
+        printf("{\"benchmark\":\"%s\",\"ops\":%" PRIu64 ",\"micros_per_op\":%.3f,"
+               "\"ops_per_sec\":%.0f,\"mb_per_sec\":%.2f,\"p50_us\":%.2f,\"p99_us\":%.2f,"
+               "\"p999_us\":%.2f}\n",
+               workload->name, done, done > 0 ? (double)elapsed / 1e3 / (double)done : 0.0,
+               seconds > 0 ? (double)done / seconds : 0.0,
+               seconds > 0 ? (double)bytes / (1024.0 * 1024.0) / seconds : 0.0,
+               (double)bench_histogram_percentile(&histogram, 50.0) / 1000.0,
+               (double)bench_histogram_percentile(&histogram, 99.0) / 1000.0,
+               (double)bench_histogram_percentile(&histogram, 99.9) / 1000.0);
+        fflush(stdout);
+        free(state);
+        free(args);
+        return;
+    }
+
+    printf(BOLDWHITE "%-18s" RESET " : %11.3f micros/op %10.0f ops/sec %8.1f MB/s", workload->name,
+           done > 0 ? (double)elapsed / 1e3 / (double)done : 0.0,
+           seconds > 0 ? (double)done / seconds : 0.0,
+           seconds > 0 ? (double)bytes / (1024.0 * 1024.0) / seconds : 0.0);
+    if (!workload->writes && workload->fn != bench_compact)
+        printf(" (%" PRIu64 " of %" PRIu64 " found)", found, done);
+    if (workload->background_writer)
+        printf(" (%" PRIu64 " background writes)", state[threads].done);
+    printf("\n");
+    bench_histogram_print(&histogram);
+
+    free(state);
+    free(args);
 }
 
-void run_benchmark(void *(*benchmark_func)(void *), tidesdb_t *tdb, const char *cf_name)
+static void bench_usage(void)
 {
-    pthread_t threads[NUM_THREADS];
-    thread_arg_t args[NUM_THREADS];
+    printf("usage: tidesdb_bench [--flag=value ...]\n"
+           "  --benchmarks=list          comma separated, run in order (%s)\n"
+           "                             also compact\n"
+           "  --num=n                    key space (100000)\n"
+           "  --reads=n                  operations for read benchmarks (num)\n"
+           "  --writes=n                 operations for write benchmarks (num)\n"
+           "  --threads=n                threads per benchmark (1)\n"
+           "  --key_size=n               key size in bytes (16)\n"
+           "  --value_size=n             value size in bytes (100)\n"
+           "  --value_size_distribution  fixed or uniform (fixed)\n"
+           "  --value_size_min=n         smallest uniform value size (1)\n"
+           "  --value_size_max=n         largest uniform value size (value_size * 2)\n"
+           "  --distribution             uniform or zipfian key selection (uniform)\n"
+           "  --zipf_theta=f             zipfian skew (0.99)\n"
+           "  --batch_size=n             keys per multiget (16)\n"
+           "  --seed=n                   random seed (1)\n"
+           "  --db=path                  database directory (benchmark_db)\n"
+           "  --use_existing_db=0|1      keep the database of a previous run (0)\n"
+           "  --flush_threshold=n        memtable flush threshold in bytes (67108864)\n"
+           "  --compression              none, snappy, lz4 or zstd (none)\n"
+           "  --bloom_filter=0|1         sstable filters (1)\n"
+           "  --filter                   bloom or fuse, the kind of sstable filter (bloom)\n"
+           "  --partitioned_index=0|1    partitioned sstable filters under a top level index (0)\n"
+           "  --hash_index=0|1           hash index per sstable partition for point lookups (0)\n"
+           "  --learned_index=0|1        learned index per sstable partition for integer keys (0)\n"
+           "  --memtable                 skiplist or hashtable (skiplist)\n"
+           "  --memtable_shards=n        memtable shards (1)\n"
+           "  --compaction_threads=n     concurrent pair merges for compact (2)\n"
+           "  --background_threads=n     background pool threads (2)\n"
+           "  --max_subcompactions=n     key ranges per pair merge (0)\n"
+           "  --direct_io=0|1            bypass the page cache for sstables (0)\n"
+           "  --rate_limit=n             flush and compaction bytes per second, 0 unlimited (0)\n"
+           "  --row_cache=n              row cache size in bytes, 0 for none (0)\n"
+           "  --format                   text or json, json is one object per benchmark (text)\n",
+           BENCH_DEFAULT_BENCHMARKS);
+}
 
-    for (int i = 0; i < NUM_THREADS; i++)
+/*
+ * bench_parse_flag
+ * parses a --name=value flag into the options, returns false for an unknown or bad flag
+ */
+static bool bench_parse_flag(bench_options_t *options, const char *arg)
+{
+    if (strncmp(arg, "--", 2) != 0) return false;
+
+    const char *eq = strchr(arg, '=');
+    if (eq == NULL) return false;
+
+    size_t len = (size_t)(eq - arg - 2);
+    const char *name = arg + 2;
+    const char *value = eq + 1;
+    char *end = NULL;
+
+#define BENCH_FLAG(flag) (len == strlen(flag) && strncmp(name, flag, len) == 0)
+#define BENCH_NUMBER(field)                            \
+    do                                                 \
+    {                                                  \
+        (field) = strtoull(value, &end, 10);           \
+        return *value != '\0' && *end == '\0';         \
+    } while (0)
+
+    unsigned long long n;
+    if (BENCH_FLAG("benchmarks"))
+    {
+        options->benchmarks = value;
+        return true;
+    }
+    if (BENCH_FLAG("db"))
+    {
+        options->db = value;
+        return true;
+    }
+    if (BENCH_FLAG("num")) BENCH_NUMBER(options->num);
+    if (BENCH_FLAG("reads")) BENCH_NUMBER(options->reads);
+    if (BENCH_FLAG("writes")) BENCH_NUMBER(options->writes);
+    if (BENCH_FLAG("seed")) BENCH_NUMBER(options->seed);
+    if (BENCH_FLAG("key_size")) BENCH_NUMBER(options->key_size);
+    if (BENCH_FLAG("value_size")) BENCH_NUMBER(options->value_size);
+    if (BENCH_FLAG("value_size_min")) BENCH_NUMBER(options->value_size_min);
+    if (BENCH_FLAG("value_size_max")) BENCH_NUMBER(options->value_size_max);
+    if (BENCH_FLAG("rate_limit")) BENCH_NUMBER(options->config.rate_limit_bytes_per_sec);
+    if (BENCH_FLAG("row_cache")) BENCH_NUMBER(options->config.row_cache_bytes);
+
+    /* the remaining numbers are ints */
+    n = strtoull(value, &end, 10);
+    bool number = *value != '\0' && *end == '\0' && n <= INT32_MAX;
+    if (BENCH_FLAG("threads")) return number && (options->threads = (int)n) > 0;
+    if (BENCH_FLAG("batch_size")) return number && (options->batch_size = (int)n) > 0;
+    if (BENCH_FLAG("flush_threshold")) return number && (options->flush_threshold = (int)n) > 0;
+    if (BENCH_FLAG("memtable_shards")) return number && (options->memtable_shards = (int)n) > 0;
+    if (BENCH_FLAG("compaction_threads"))
+        return number && (options->compaction_threads = (int)n) > 0;
+    if (BENCH_FLAG("background_threads"))
+        return number && ((options->config.background_threads = (int)n), true);
+    if (BENCH_FLAG("max_subcompactions"))
+        return number && ((options->config.max_subcompactions = (int)n), true);
+    if (BENCH_FLAG("use_existing_db")) return number && ((options->use_existing_db = n), true);
+    if (BENCH_FLAG("bloom_filter")) return number && ((options->bloom_filter = n), true);
+    if (BENCH_FLAG("partitioned_index"))
+        return number && ((options->partitioned_index = n), true);
+    if (BENCH_FLAG("hash_index")) return number && ((options->hash_index = n), true);
+    if (BENCH_FLAG("learned_index")) return number && ((options->learned_index = n), true);
+    if (BENCH_FLAG("direct_io")) return number && ((options->config.direct_io = n), true);
+
+    if (BENCH_FLAG("zipf_theta"))
+    {
+        options->zipf_theta = strtod(value, &end);
+        return *end == '\0' && options->zipf_theta > 0 && options->zipf_theta != 1.0;
+    }
+    if (BENCH_FLAG("distribution"))
     {
-        args[i].tdb = tdb;
-        args[i].column_family_name = cf_name;
-        args[i].thread_id = i;
-        pthread_create(&threads[i], NULL, benchmark_func, &args[i]);
+        options->zipfian = strcmp(value, "zipfian") == 0;
+        return options->zipfian || strcmp(value, "uniform") == 0;
     }
+    if (BENCH_FLAG("value_size_distribution"))
+    {
+        options->value_size_uniform = strcmp(value, "uniform") == 0;
+        return options->value_size_uniform || strcmp(value, "fixed") == 0;
+    }
+    if (BENCH_FLAG("filter"))
+    {
+        options->filter_type = strcmp(value, "fuse") == 0 ? TDB_FILTER_BINARY_FUSE
+                                                          : TDB_FILTER_BLOOM;
+        return strcmp(value, "fuse") == 0 || strcmp(value, "bloom") == 0;
+    }
+    if (BENCH_FLAG("format"))
+    {
+        options->json = strcmp(value, "json") == 0;
+        return options->json || strcmp(value, "text") == 0;
+    }
+    if (BENCH_FLAG("memtable"))
+    {
+        options->memtable_ds =
+            strcmp(value, "hashtable") == 0 ? TDB_MEMTABLE_HASH_TABLE : TDB_MEMTABLE_SKIP_LIST;
+        return strcmp(value, "hashtable") == 0 || strcmp(value, "skiplist") == 0;
+    }
+    if (BENCH_FLAG("compression"))
+    {
+        options->compressed = strcmp(value, "none") != 0;
+        if (strcmp(value, "snappy") == 0) options->compress_algo = TDB_COMPRESS_SNAPPY;
+        else if (strcmp(value, "lz4") == 0) options->compress_algo = TDB_COMPRESS_LZ4;
+        else if (strcmp(value, "zstd") == 0) options->compress_algo = TDB_COMPRESS_ZSTD;
+        else return !options->compressed;
+        return true;
+    }
+
+#undef BENCH_NUMBER
+#undef BENCH_FLAG
+    return false;
+}
 
-    for (int i = 0; i < NUM_THREADS; i++)
+/*
+ * bench_validate
+ * fills in defaults that depend on other flags and checks the flags fit together
+ */
+static bool bench_validate(bench_options_t *options)
+{
+    if (options->reads == 0) options->reads = options->num;
+    if (options->writes == 0) options->writes = options->num;
+    if (options->value_size_max == 0) options->value_size_max = options->value_size * 2;
+
+    if (options->num == 0 || options->threads > BENCH_MAX_THREADS) return false;
+    if (options->key_size == 0) return false;
+
+    /* every key index must fit in key_size digits */
+    char digits[32];
+    if ((size_t)snprintf(digits, sizeof(digits), "%" PRIu64, options->num - 1) > options->key_size)
     {
-        pthread_join(threads[i], NULL);
+        fprintf(stderr, RED "--key_size=%zu is too small for --num=%" PRIu64 "\n" RESET,
+                options->key_size, options->num);
+        return false;
     }
+
+    size_t largest = options->value_size_uniform ? options->value_size_max : options->value_size;
+    if (largest > BENCH_VALUE_POOL_SIZE) return false;
+    if (options->value_size_uniform && options->value_size_min > options->value_size_max)
+        return false;
+
+    return true;
 }
 
-/* benchmarks put with many flushes, put with compaction triggered in the middle of write operations
- * get, delete operations
- *
- * We also benchmark with different column family configurations with compression and bloom filter
- * and without
+/*
+ * bench_open
+ * opens the database and the benchmark column family
  */
-int main(void)
+static bool bench_open(bench_t *bench)
 {
-    (void)_tidesdb_remove_directory(DIR);
+    bench_options_t *options = bench->options;
 
-    tidesdb_t *tdb = NULL;
+    if (!options->use_existing_db) (void)_tidesdb_remove_directory(options->db);
 
-    tidesdb_err_t *err = tidesdb_open(DIR, &tdb);
+    tidesdb_err_t *err = tidesdb_open_w_config((char *)options->db, &options->config, &bench->tdb);
     if (err != NULL)
     {
-        printf(RED "Error opening database: %s\n" RESET, err->message);
+        fprintf(stderr, RED "open failed: %s" RESET, err->message);
         tidesdb_err_free(err);
-        return -1;
+        return false;
     }
 
-    /* we can run one more benchmark with different column family configurations */
-
-    const char *cf_name = "cf1";
-    err = tidesdb_create_column_family(tdb, cf_name, FLUSH_THRESHOLD, 12, 0.24f, false,
-                                       TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    tidesdb_column_family_config_t config = {.name = BENCH_CF_NAME,
+                                             .flush_threshold = options->flush_threshold,
+                                             .max_level = 12,
+                                             .probability = 0.24f,
+                                             .compressed = options->compressed,
+                                             .compress_algo = options->compress_algo,
+                                             .memtable_ds = options->memtable_ds,
+                                             .bloom_filter = options->bloom_filter,
+                                             .memtable_shards = options->memtable_shards,
+                                             .filter_type = options->filter_type,
+                                             .partitioned_index = options->partitioned_index,
+                                             .hash_index = options->hash_index,
+                                             .learned_index = options->learned_index};
+    err = tidesdb_create_column_family_w_config(bench->tdb, &config);
     if (err != NULL)
     {
-        printf(RED "Error creating column family: %s\n" RESET, err->message);
+        /* an existing database already has the column family */
+        if (!options->use_existing_db) fprintf(stderr, RED "%s" RESET, err->message);
         tidesdb_err_free(err);
-        tidesdb_close(tdb);
-        return -1;
     }
 
-    const char *cf_name2 = "cf2";
-    err = tidesdb_create_column_family(tdb, cf_name2, FLUSH_THRESHOLD, 12, 0.24f, false,
-                                       TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    err = tidesdb_get_cf_handle(bench->tdb, BENCH_CF_NAME, &bench->handle);
+    if (err == NULL) err = tidesdb_async_open(bench->tdb, options->threads, &bench->async);
     if (err != NULL)
     {
-        printf(RED "Error creating column family: %s\n" RESET, err->message);
+        fprintf(stderr, RED "%s" RESET, err->message);
         tidesdb_err_free(err);
-        tidesdb_close(tdb);
-        return -1;
-    }
-
-    printf(BOLDCYAN "Running PUT (no compression, bloom filter) benchmark...\n" RESET);
-    clock_t start = clock();
-    run_benchmark(benchmark_put, tdb, cf_name);
-    clock_t end = clock();
-    printf(BOLDGREEN "PUT (no compression, bloom filter) benchmark completed in %f seconds\n" RESET,
-           (double)(end - start) / CLOCKS_PER_SEC);
-
-    printf(BOLDCYAN "Running PUT (no compression, bloom filter) compact benchmark...\n" RESET);
-    start = clock();
-    run_benchmark(benchmark_put_compact, tdb, cf_name);
-    end = clock();
-    printf(BOLDGREEN
-           "PUT (no compression, bloom filter) compact benchmark completed in %f seconds\n" RESET,
-           (double)(end - start) / CLOCKS_PER_SEC);
-
-    printf(BOLDCYAN "Running GET (no compression, bloom filter) benchmark...\n" RESET);
-    start = clock();
-    run_benchmark(benchmark_get, tdb, cf_name);
-    end = clock();
-    printf(BOLDGREEN "GET (no compression, bloom filter) benchmark completed in %f seconds\n" RESET,
-           (double)(end - start) / CLOCKS_PER_SEC);
-
-    printf(BOLDCYAN "Running DELETE (no compression, bloom filter) benchmark...\n" RESET);
-    start = clock();
-    run_benchmark(benchmark_delete, tdb, cf_name);
-    end = clock();
-    printf(BOLDGREEN
-           "DELETE (no compression, bloom filter) benchmark completed in %f seconds\n" RESET,
-           (double)(end - start) / CLOCKS_PER_SEC);
-
-    /* with snappy compression and bloom filter */
-    printf(BOLDCYAN "Running PUT (compression, bloom filter) benchmark...\n" RESET);
-    start = clock();
-    run_benchmark(benchmark_put, tdb, cf_name);
-    end = clock();
-    printf(BOLDGREEN "PUT benchmark completed in %f seconds\n" RESET,
-           (double)(end - start) / CLOCKS_PER_SEC);
-
-    printf(BOLDCYAN "Running PUT (compression, bloom filter) compact benchmark...\n" RESET);
-    start = clock();
-    run_benchmark(benchmark_put_compact, tdb, cf_name);
-    end = clock();
-    printf(BOLDGREEN
-           "PUT (compression, bloom filter) compact benchmark completed in %f seconds\n" RESET,
-           (double)(end - start) / CLOCKS_PER_SEC);
-
-    printf(BOLDCYAN "Running GET (compression, bloom filter) benchmark...\n" RESET);
-    start = clock();
-    run_benchmark(benchmark_get, tdb, cf_name);
-    end = clock();
-    printf(BOLDGREEN "GET (compression, bloom filter) benchmark completed in %f seconds\n" RESET,
-           (double)(end - start) / CLOCKS_PER_SEC);
-
-    printf(BOLDCYAN "Running DELETE (compression, bloom filter) benchmark...\n" RESET);
-    start = clock();
-    run_benchmark(benchmark_delete, tdb, cf_name);
-    end = clock();
-    printf(BOLDGREEN "DELETE (compression, bloom filter) benchmark completed in %f seconds\n" RESET,
-           (double)(end - start) / CLOCKS_PER_SEC);
-
-    (void)tidesdb_close(tdb);
-    (void)_tidesdb_remove_directory(DIR);
-    return 0;
-}
\ No newline at end of file
+        return false;
+    }
+
+    return true;
+}
+
+static void bench_close(bench_t *bench)
+{
+    if (bench->async != NULL) (void)tidesdb_async_close(bench->async);
+    if (bench->handle != NULL) (void)tidesdb_release_cf_handle(bench->handle);
+    if (bench->tdb != NULL) (void)tidesdb_close(bench->tdb);
+}
+
+int main(int argc, char **argv)
+{
+    bench_options_t options = {.benchmarks = BENCH_DEFAULT_BENCHMARKS,
+                               .db = "benchmark_db",
+                               .num = 100000,
+                               .threads = 1,
+                               .key_size = 16,
+                               .value_size = 100,
+                               .value_size_min = 1,
+                               .zipf_theta = 0.99,
+                               .batch_size = 16,
+                               .seed = 1,
+                               .flush_threshold = (1024 * 1024) * 64,
+                               .compress_algo = TDB_NO_COMPRESSION,
+                               .bloom_filter = true,
+                               .memtable_ds = TDB_MEMTABLE_SKIP_LIST,
+                               .memtable_shards = 1,
+                               .compaction_threads = 2};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            bench_usage();
+            return 0;
+        }
+        if (!bench_parse_flag(&options, argv[i]))
+        {
+            fprintf(stderr, RED "invalid flag %s\n" RESET, argv[i]);
+            bench_usage();
+            return 1;
+        }
+    }
+
+    if (!bench_validate(&options))
+    {
+        fprintf(stderr, RED "invalid flags\n" RESET);
+        return 1;
+    }
+
+    bench_t bench = {.options = &options};
+    bench.value_pool = malloc(BENCH_VALUE_POOL_SIZE);
+    if (bench.value_pool == NULL) return 1;
+
+    bench_rng_t rng;
+    bench_rng_seed(&rng, options.seed);
+    for (size_t i = 0; i < BENCH_VALUE_POOL_SIZE; i++)
+        bench.value_pool[i] = (uint8_t)(bench_rng_next(&rng) >> 56);
+
+    if (options.zipfian) bench_zipfian_init(&bench.zipfian, options.num, options.zipf_theta);
+
+    if (!options.json)
+    {
+        printf(BOLDWHITE "Keys:       %zu bytes each, %" PRIu64 " in the key space (%s)\n" RESET,
+               options.key_size, options.num, options.zipfian ? "zipfian" : "uniform");
+        printf(BOLDWHITE "Values:     %zu bytes each (%s)\n" RESET,
+               options.value_size_uniform ? (options.value_size_min + options.value_size_max) / 2
+                                          : options.value_size,
+               options.value_size_uniform ? "uniform" : "fixed");
+        printf(BOLDWHITE "Threads:    %d\n" RESET, options.threads);
+        printf(BOLDWHITE "Memtable:   %s, %d shards, %d byte flush threshold\n" RESET,
+               options.memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "skip list" : "hash table",
+               options.memtable_shards, options.flush_threshold);
+        printf("------------------------------------------------\n");
+    }
+
+    if (!bench_open(&bench))
+    {
+        bench_close(&bench);
+        free(bench.value_pool);
+        return 1;
+    }
+
+    int rc = 0;
+    char *list = strdup(options.benchmarks);
+    char *save = NULL;
+    for (char *name = strtok_r(list, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save))
+    {
+        const bench_workload_t *workload = NULL;
+        for (size_t i = 0; i < sizeof(bench_workloads) / sizeof(bench_workloads[0]); i++)
+            if (strcmp(bench_workloads[i].name, name) == 0) workload = &bench_workloads[i];
+
+        if (workload == NULL)
+        {
+            fprintf(stderr, RED "unknown benchmark %s\n" RESET, name);
+            rc = 1;
+            break;
+        }
+
+        bench_run(&bench, workload);
+    }
+
+    free(list);
+    bench_close(&bench);
+    free(bench.value_pool);
+    return rc;
+}
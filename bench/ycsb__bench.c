@@ -0,0 +1,765 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/tidesdb.h"
+#include "../test/test_macros.h"
+#include "bench_utils.h"
+
+/*
+ * a YCSB driver, loads the records then runs the core workloads against the TidesDB C API and
+ * prints the results in the YCSB summary format
+ *
+ * tidesdb_ycsb --workload=a,b,c,f,d --recordcount=1000000 --operationcount=1000000 --threads=4
+ *
+ * the workloads are the YCSB core workloads
+ *
+ * a  50% read, 50% update, zipfian
+ * b  95% read, 5% update, zipfian
+ * c  100% read, zipfian
+ * d  95% read, 5% insert, latest
+ * e  95% scan, 5% insert, zipfian, scans of 1 to maxscanlength records through a cursor
+ * f  50% read, 50% read-modify-write, zipfian, the write goes through a transaction
+ *
+ * run with --help for every flag
+ */
+
+#define YCSB_CF_NAME         "usertable"
+#define YCSB_VALUE_POOL_SIZE (1024 * 1024) /* random bytes field values are sliced from */
+#define YCSB_MAX_THREADS     256
+#define YCSB_KEY_MAX         32 /* "user" and a 64 bit decimal */
+
+/*
+ * ycsb_op_t
+ * the YCSB operations
+ */
+typedef enum
+{
+    YCSB_READ,
+    YCSB_UPDATE,
+    YCSB_INSERT,
+    YCSB_SCAN,
+    YCSB_READ_MODIFY_WRITE,
+    YCSB_OPS
+} ycsb_op_t;
+
+static const char *ycsb_op_names[YCSB_OPS] = {"READ", "UPDATE", "INSERT", "SCAN",
+                                              "READ-MODIFY-WRITE"};
+
+/*
+ * ycsb_distribution_t
+ * how request keys are picked
+ */
+typedef enum
+{
+    YCSB_UNIFORM,
+    YCSB_ZIPFIAN,
+    YCSB_LATEST /* zipfian over the most recently inserted records */
+} ycsb_distribution_t;
+
+/*
+ * ycsb_workload_t
+ * a core workload, the proportions add up to 1
+ */
+typedef struct
+{
+    char name;
+    double proportions[YCSB_OPS];
+    ycsb_distribution_t distribution;
+} ycsb_workload_t;
+
+static const ycsb_workload_t ycsb_workloads[] = {
+    {'a', {[YCSB_READ] = 0.5, [YCSB_UPDATE] = 0.5}, YCSB_ZIPFIAN},
+    {'b', {[YCSB_READ] = 0.95, [YCSB_UPDATE] = 0.05}, YCSB_ZIPFIAN},
+    {'c', {[YCSB_READ] = 1.0}, YCSB_ZIPFIAN},
+    {'d', {[YCSB_READ] = 0.95, [YCSB_INSERT] = 0.05}, YCSB_LATEST},
+    {'e', {[YCSB_SCAN] = 0.95, [YCSB_INSERT] = 0.05}, YCSB_ZIPFIAN},
+    {'f', {[YCSB_READ] = 0.5, [YCSB_READ_MODIFY_WRITE] = 0.5}, YCSB_ZIPFIAN},
+};
+
+/*
+ * ycsb_options_t
+ * the command line flags
+ */
+typedef struct
+{
+    const char *workloads;
+    const char *db;
+    bool load;
+    bool run;
+    uint64_t recordcount;
+    uint64_t operationcount;
+    int threads;
+    int fieldcount;
+    size_t fieldlength;
+    int maxscanlength;
+    int requestdistribution; /* -1 for the workload default */
+    double zipfian_constant;
+    uint64_t seed;
+    int flush_threshold;
+    bool compressed;
+    tidesdb_compression_algo_t compress_algo;
+    bool bloom_filter;
+    tidesdb_memtable_ds_t memtable_ds;
+    tidesdb_config_t config;
+} ycsb_options_t;
+
+/*
+ * ycsb_t
+ * state shared by the client threads
+ */
+typedef struct
+{
+    ycsb_options_t *options;
+    const ycsb_workload_t *workload;
+    tidesdb_t *tdb;
+    tidesdb_cf_handle_t *handle;
+    uint8_t *value_pool;
+    bench_zipfian_t zipfian;
+    _Atomic uint64_t next_insert; /* the next record number to insert */
+    _Atomic uint64_t inserted;    /* the records inserted so far, reads stay below it */
+} ycsb_t;
+
+/*
+ * ycsb_measurement_t
+ * the latencies and return codes of an operation
+ */
+typedef struct
+{
+    bench_histogram_t histogram;
+    uint64_t ok;
+    uint64_t not_found;
+    uint64_t error;
+} ycsb_measurement_t;
+
+/*
+ * ycsb_client_t
+ * a client thread
+ */
+typedef struct
+{
+    ycsb_t *ycsb;
+    int id;
+    uint64_t ops;
+    uint64_t first_record; /* the first record the client inserts in the load phase */
+    bench_rng_t rng;
+    uint8_t *record; /* scratch record of fieldcount * fieldlength bytes */
+    ycsb_measurement_t measurements[YCSB_OPS];
+    pthread_t thread;
+} ycsb_client_t;
+
+/*
+ * ycsb_key
+ * builds the key of a record number, YCSB hashes the number so inserts are spread over the key
+ * space
+ */
+static size_t ycsb_key(uint64_t record, uint8_t *key)
+{
+    return (size_t)snprintf((char *)key, YCSB_KEY_MAX, "user%" PRIu64, bench_fnv1a(record));
+}
+
+static size_t ycsb_record_size(ycsb_options_t *options)
+{
+    return (size_t)options->fieldcount * options->fieldlength;
+}
+
+/*
+ * ycsb_fill_field
+ * fills a field of the scratch record with random bytes
+ */
+static void ycsb_fill_field(ycsb_client_t *client, int field)
+{
+    size_t length = client->ycsb->options->fieldlength;
+    uint64_t offset = bench_rng_uniform(&client->rng, YCSB_VALUE_POOL_SIZE - length + 1);
+    memcpy(client->record + length * (size_t)field, client->ycsb->value_pool + offset, length);
+}
+
+static void ycsb_fill_record(ycsb_client_t *client)
+{
+    for (int i = 0; i < client->ycsb->options->fieldcount; i++) ycsb_fill_field(client, i);
+}
+
+/*
+ * ycsb_next_record
+ * picks the record number of a read, update, scan or read-modify-write
+ */
+static uint64_t ycsb_next_record(ycsb_client_t *client)
+{
+    ycsb_t *ycsb = client->ycsb;
+    uint64_t count = atomic_load(&ycsb->inserted);
+    if (count == 0) return 0;
+
+    ycsb_distribution_t distribution = ycsb->workload->distribution;
+    if (ycsb->options->requestdistribution >= 0)
+        distribution = (ycsb_distribution_t)ycsb->options->requestdistribution;
+
+    switch (distribution)
+    {
+        case YCSB_UNIFORM:
+            return bench_rng_uniform(&client->rng, count);
+        case YCSB_LATEST:
+            return count - 1 - bench_zipfian_rank(&ycsb->zipfian, &client->rng) % count;
+        default:
+            break;
+    }
+
+    /* the zipfian covers the records inserts may add, we draw again past the inserted ones */
+    uint64_t record;
+    do
+    {
+        record = bench_zipfian_next(&ycsb->zipfian, &client->rng);
+    } while (record >= count);
+    return record;
+}
+
+static void ycsb_measure(ycsb_client_t *client, ycsb_op_t op, uint64_t start, int rc)
+{
+    ycsb_measurement_t *m = &client->measurements[op];
+    bench_histogram_add(&m->histogram, bench_now_ns() - start);
+
+    if (rc == TIDESDB_SUCCESS)
+        m->ok++;
+    else if (rc == TIDESDB_ERR_KEY_NOT_FOUND)
+        m->not_found++;
+    else
+        m->error++;
+}
+
+static int ycsb_read(ycsb_client_t *client, uint64_t record)
+{
+    uint8_t key[YCSB_KEY_MAX];
+    size_t key_size = ycsb_key(record, key);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    int rc = tidesdb_get_status(client->ycsb->handle, key, key_size, &value, &value_size);
+    free(value);
+    return rc;
+}
+
+static int ycsb_write(ycsb_client_t *client, uint64_t record)
+{
+    uint8_t key[YCSB_KEY_MAX];
+    size_t key_size = ycsb_key(record, key);
+
+    return tidesdb_put_status(client->ycsb->handle, key, key_size, client->record,
+                              ycsb_record_size(client->ycsb->options), -1);
+}
+
+static int ycsb_insert(ycsb_client_t *client)
+{
+    uint64_t record = atomic_fetch_add(&client->ycsb->next_insert, 1);
+
+    ycsb_fill_record(client);
+    int rc = ycsb_write(client, record);
+    if (rc == TIDESDB_SUCCESS) atomic_fetch_add(&client->ycsb->inserted, 1);
+    return rc;
+}
+
+static int ycsb_scan(ycsb_client_t *client, uint64_t record)
+{
+    uint8_t key[YCSB_KEY_MAX];
+    size_t key_size = ycsb_key(record, key);
+    int length = 1 + (int)bench_rng_uniform(&client->rng,
+                                            (uint64_t)client->ycsb->options->maxscanlength);
+
+    tidesdb_cursor_t *cursor = NULL;
+    tidesdb_err_t *err = tidesdb_cursor_init_w_handle(client->ycsb->handle, &cursor);
+    if (err == NULL) err = tidesdb_cursor_seek(cursor, key, key_size);
+
+    for (int i = 0; err == NULL && i < length; i++)
+    {
+        uint8_t *k = NULL;
+        size_t k_size;
+        uint8_t *v = NULL;
+        size_t v_size;
+
+        err = tidesdb_cursor_get(cursor, &k, &k_size, &v, &v_size);
+        if (err != NULL) break;
+        free(k);
+        free(v);
+
+        err = tidesdb_cursor_next(cursor);
+    }
+
+    int rc = TIDESDB_SUCCESS;
+    if (err != NULL)
+    {
+        /* running off the end of the column family is a short scan, not a failure */
+        if (err->code != TIDESDB_ERR_AT_END_OF_CURSOR) rc = err->code;
+        tidesdb_err_free(err);
+    }
+
+    if (cursor != NULL) (void)tidesdb_cursor_free(cursor);
+    return rc;
+}
+
+/*
+ * ycsb_read_modify_write
+ * reads a record, changes a field and writes it back in a transaction
+ */
+static int ycsb_read_modify_write(ycsb_client_t *client, uint64_t record)
+{
+    uint8_t key[YCSB_KEY_MAX];
+    size_t key_size = ycsb_key(record, key);
+    size_t record_size = ycsb_record_size(client->ycsb->options);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    int rc = tidesdb_get_status(client->ycsb->handle, key, key_size, &value, &value_size);
+    if (rc != TIDESDB_SUCCESS) return rc;
+
+    memcpy(client->record, value, value_size < record_size ? value_size : record_size);
+    free(value);
+    ycsb_fill_field(client, (int)bench_rng_uniform(&client->rng,
+                                                   (uint64_t)client->ycsb->options->fieldcount));
+
+    tidesdb_txn_t *txn = NULL;
+    tidesdb_err_t *err = tidesdb_txn_begin_w_handle(client->ycsb->handle, &txn);
+    if (err == NULL) err = tidesdb_txn_put(txn, key, key_size, client->record, record_size, -1);
+    if (err == NULL) err = tidesdb_txn_commit(txn);
+
+    rc = TIDESDB_SUCCESS;
+    if (err != NULL)
+    {
+        rc = err->code;
+        tidesdb_err_free(err);
+    }
+
+    if (txn != NULL) (void)tidesdb_txn_free(txn);
+    return rc;
+}
+
+/*
+ * ycsb_next_op
+ * picks an operation by the workload proportions
+ */
+static ycsb_op_t ycsb_next_op(ycsb_client_t *client)
+{
+    double u = bench_rng_double(&client->rng);
+    double sum = 0;
+    for (int op = 0; op < YCSB_OPS; op++)
+    {
+        sum += client->ycsb->workload->proportions[op];
+        if (u < sum) return (ycsb_op_t)op;
+    }
+    return YCSB_READ;
+}
+
+static void *ycsb_load_thread(void *arg)
+{
+    ycsb_client_t *client = arg;
+
+    for (uint64_t i = 0; i < client->ops; i++)
+    {
+        ycsb_fill_record(client);
+
+        uint64_t start = bench_now_ns();
+        int rc = ycsb_write(client, client->first_record + i);
+        ycsb_measure(client, YCSB_INSERT, start, rc);
+    }
+    return NULL;
+}
+
+static void *ycsb_run_thread(void *arg)
+{
+    ycsb_client_t *client = arg;
+
+    for (uint64_t i = 0; i < client->ops; i++)
+    {
+        ycsb_op_t op = ycsb_next_op(client);
+        uint64_t record = op == YCSB_INSERT ? 0 : ycsb_next_record(client);
+        if (op == YCSB_UPDATE) ycsb_fill_record(client);
+
+        int rc = TIDESDB_SUCCESS;
+        uint64_t start = bench_now_ns();
+        switch (op)
+        {
+            case YCSB_READ:
+                rc = ycsb_read(client, record);
+                break;
+            case YCSB_UPDATE:
+                rc = ycsb_write(client, record);
+                break;
+            case YCSB_INSERT:
+                rc = ycsb_insert(client);
+                break;
+            case YCSB_SCAN:
+                rc = ycsb_scan(client, record);
+                break;
+            default:
+                rc = ycsb_read_modify_write(client, record);
+                break;
+        }
+        ycsb_measure(client, op, start, rc);
+    }
+    return NULL;
+}
+
+/*
+ * ycsb_print
+ * prints the results of a phase in the YCSB summary format
+ */
+static void ycsb_print(ycsb_client_t *clients, int threads, uint64_t elapsed)
+{
+    uint64_t total = 0;
+    ycsb_measurement_t merged[YCSB_OPS];
+    memset(merged, 0, sizeof(merged));
+    for (int op = 0; op < YCSB_OPS; op++)
+    {
+        bench_histogram_init(&merged[op].histogram);
+        for (int i = 0; i < threads; i++)
+        {
+            ycsb_measurement_t *m = &clients[i].measurements[op];
+            bench_histogram_merge(&merged[op].histogram, &m->histogram);
+            merged[op].ok += m->ok;
+            merged[op].not_found += m->not_found;
+            merged[op].error += m->error;
+        }
+        total += merged[op].histogram.count;
+    }
+
+    double ms = (double)elapsed / 1e6;
+    printf("[OVERALL], RunTime(ms), %.0f\n", ms);
+    printf("[OVERALL], Throughput(ops/sec), %f\n", ms > 0 ? (double)total * 1000.0 / ms : 0.0);
+
+    for (int op = 0; op < YCSB_OPS; op++)
+    {
+        bench_histogram_t *h = &merged[op].histogram;
+        if (h->count == 0) continue;
+
+        const char *name = ycsb_op_names[op];
+        printf("[%s], Operations, %" PRIu64 "\n", name, h->count);
+        printf("[%s], AverageLatency(us), %f\n", name, (double)h->sum / (double)h->count / 1e3);
+        printf("[%s], MinLatency(us), %" PRIu64 "\n", name, h->min / 1000);
+        printf("[%s], MaxLatency(us), %" PRIu64 "\n", name, h->max / 1000);
+        printf("[%s], 95thPercentileLatency(us), %" PRIu64 "\n", name,
+               bench_histogram_percentile(h, 95.0) / 1000);
+        printf("[%s], 99thPercentileLatency(us), %" PRIu64 "\n", name,
+               bench_histogram_percentile(h, 99.0) / 1000);
+        printf("[%s], Return=OK, %" PRIu64 "\n", name, merged[op].ok);
+        if (merged[op].not_found > 0)
+            printf("[%s], Return=NOT_FOUND, %" PRIu64 "\n", name, merged[op].not_found);
+        if (merged[op].error > 0)
+            printf("[%s], Return=ERROR, %" PRIu64 "\n", name, merged[op].error);
+    }
+}
+
+/*
+ * ycsb_phase
+ * runs the load phase or the run phase of the current workload
+ */
+static int ycsb_phase(ycsb_t *ycsb, bool load)
+{
+    ycsb_options_t *options = ycsb->options;
+    int threads = options->threads;
+    uint64_t total = load ? options->recordcount : options->operationcount;
+
+    ycsb_client_t *clients = calloc((size_t)threads, sizeof(ycsb_client_t));
+    if (clients == NULL) return -1;
+
+    /* we split the operations across the clients, the first clients take the remainder */
+    uint64_t first = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        ycsb_client_t *client = &clients[i];
+        client->ycsb = ycsb;
+        client->id = i;
+        client->ops = total / (uint64_t)threads + ((uint64_t)i < total % (uint64_t)threads);
+        client->first_record = first;
+        first += client->ops;
+        bench_rng_seed(&client->rng, options->seed + (uint64_t)i * 0x9e3779b97f4a7c15ULL +
+                                         (load ? 0 : (uint64_t)ycsb->workload->name));
+        client->record = malloc(ycsb_record_size(options));
+        for (int op = 0; op < YCSB_OPS; op++)
+            bench_histogram_init(&client->measurements[op].histogram);
+    }
+
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < threads; i++)
+        (void)pthread_create(&clients[i].thread, NULL, load ? ycsb_load_thread : ycsb_run_thread,
+                             &clients[i]);
+    for (int i = 0; i < threads; i++) (void)pthread_join(clients[i].thread, NULL);
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if (load)
+        printf("# load %" PRIu64 " records\n", options->recordcount);
+    else
+        printf("# run workload %c\n", ycsb->workload->name);
+    ycsb_print(clients, threads, elapsed);
+
+    for (int i = 0; i < threads; i++) free(clients[i].record);
+    free(clients);
+    return 0;
+}
+
+static void ycsb_usage(void)
+{
+    printf("usage: tidesdb_ycsb [--flag=value ...]\n"
+           "  --workload=list            comma separated core workloads a to f, run in order (a)\n"
+           "  --phase                    load, run or both (both)\n"
+           "  --recordcount=n            records loaded (100000)\n"
+           "  --operationcount=n         operations per workload run (100000)\n"
+           "  --threads=n                client threads (1)\n"
+           "  --fieldcount=n             fields per record (10)\n"
+           "  --fieldlength=n            bytes per field (100)\n"
+           "  --maxscanlength=n          longest scan of workload e (100)\n"
+           "  --requestdistribution      uniform, zipfian or latest (workload default)\n"
+           "  --zipfian_constant=f       zipfian skew (0.99)\n"
+           "  --seed=n                   random seed (1)\n"
+           "  --db=path                  database directory (ycsb_db)\n"
+           "  --flush_threshold=n        memtable flush threshold in bytes (67108864)\n"
+           "  --compression              none, snappy, lz4 or zstd (none)\n"
+           "  --bloom_filter=0|1         sstable bloom filters (1)\n"
+           "  --memtable                 skiplist or hashtable (skiplist)\n"
+           "  --background_threads=n     background pool threads (2)\n"
+           "  --max_subcompactions=n     key ranges per pair merge (0)\n"
+           "  --direct_io=0|1            bypass the page cache for sstables (0)\n");
+}
+
+/*
+ * ycsb_parse_flag
+ * parses a --name=value flag into the options, returns false for an unknown or bad flag
+ */
+static bool ycsb_parse_flag(ycsb_options_t *options, const char *arg)
+{
+    if (strncmp(arg, "--", 2) != 0) return false;
+
+    const char *eq = strchr(arg, '=');
+    if (eq == NULL) return false;
+
+    size_t len = (size_t)(eq - arg - 2);
+    const char *name = arg + 2;
+    const char *value = eq + 1;
+    char *end = NULL;
+
+#define YCSB_FLAG(flag) (len == strlen(flag) && strncmp(name, flag, len) == 0)
+
+    if (YCSB_FLAG("workload"))
+    {
+        options->workloads = value;
+        return true;
+    }
+    if (YCSB_FLAG("db"))
+    {
+        options->db = value;
+        return true;
+    }
+    if (YCSB_FLAG("phase"))
+    {
+        options->load = strcmp(value, "run") != 0;
+        options->run = strcmp(value, "load") != 0;
+        return strcmp(value, "load") == 0 || strcmp(value, "run") == 0 ||
+               strcmp(value, "both") == 0;
+    }
+    if (YCSB_FLAG("requestdistribution"))
+    {
+        if (strcmp(value, "uniform") == 0) options->requestdistribution = YCSB_UNIFORM;
+        else if (strcmp(value, "zipfian") == 0) options->requestdistribution = YCSB_ZIPFIAN;
+        else if (strcmp(value, "latest") == 0) options->requestdistribution = YCSB_LATEST;
+        else return false;
+        return true;
+    }
+    if (YCSB_FLAG("zipfian_constant"))
+    {
+        options->zipfian_constant = strtod(value, &end);
+        return *end == '\0' && options->zipfian_constant > 0 && options->zipfian_constant != 1.0;
+    }
+    if (YCSB_FLAG("memtable"))
+    {
+        options->memtable_ds =
+            strcmp(value, "hashtable") == 0 ? TDB_MEMTABLE_HASH_TABLE : TDB_MEMTABLE_SKIP_LIST;
+        return strcmp(value, "hashtable") == 0 || strcmp(value, "skiplist") == 0;
+    }
+    if (YCSB_FLAG("compression"))
+    {
+        options->compressed = strcmp(value, "none") != 0;
+        if (strcmp(value, "snappy") == 0) options->compress_algo = TDB_COMPRESS_SNAPPY;
+        else if (strcmp(value, "lz4") == 0) options->compress_algo = TDB_COMPRESS_LZ4;
+        else if (strcmp(value, "zstd") == 0) options->compress_algo = TDB_COMPRESS_ZSTD;
+        else return !options->compressed;
+        return true;
+    }
+
+    /* the rest are numbers */
+    unsigned long long n = strtoull(value, &end, 10);
+    if (*value == '\0' || *end != '\0') return false;
+
+    if (YCSB_FLAG("recordcount")) return (options->recordcount = n) > 0;
+    if (YCSB_FLAG("operationcount")) return ((options->operationcount = n), true);
+    if (YCSB_FLAG("seed")) return ((options->seed = n), true);
+    if (YCSB_FLAG("fieldlength")) return (options->fieldlength = n) > 0;
+    if (n > INT32_MAX) return false;
+    if (YCSB_FLAG("threads")) return (options->threads = (int)n) > 0 && n <= YCSB_MAX_THREADS;
+    if (YCSB_FLAG("fieldcount")) return (options->fieldcount = (int)n) > 0;
+    if (YCSB_FLAG("maxscanlength")) return (options->maxscanlength = (int)n) > 0;
+    if (YCSB_FLAG("flush_threshold")) return (options->flush_threshold = (int)n) > 0;
+    if (YCSB_FLAG("bloom_filter")) return ((options->bloom_filter = n), true);
+    if (YCSB_FLAG("background_threads"))
+        return ((options->config.background_threads = (int)n), true);
+    if (YCSB_FLAG("max_subcompactions"))
+        return ((options->config.max_subcompactions = (int)n), true);
+    if (YCSB_FLAG("direct_io")) return ((options->config.direct_io = n), true);
+
+#undef YCSB_FLAG
+    return false;
+}
+
+static const ycsb_workload_t *ycsb_find_workload(const char *name)
+{
+    if (strlen(name) != 1) return NULL;
+    for (size_t i = 0; i < sizeof(ycsb_workloads) / sizeof(ycsb_workloads[0]); i++)
+        if (ycsb_workloads[i].name == name[0]) return &ycsb_workloads[i];
+    return NULL;
+}
+
+static bool ycsb_open(ycsb_t *ycsb)
+{
+    ycsb_options_t *options = ycsb->options;
+
+    /* a load starts over, a run alone uses the records of an earlier load */
+    if (options->load) (void)_tidesdb_remove_directory(options->db);
+
+    tidesdb_err_t *err = tidesdb_open_w_config((char *)options->db, &options->config, &ycsb->tdb);
+    if (err == NULL && options->load)
+        err = tidesdb_create_column_family(ycsb->tdb, YCSB_CF_NAME, options->flush_threshold, 12,
+                                           0.24f, options->compressed, options->compress_algo,
+                                           options->bloom_filter, options->memtable_ds);
+    if (err == NULL) err = tidesdb_get_cf_handle(ycsb->tdb, YCSB_CF_NAME, &ycsb->handle);
+    if (err != NULL)
+    {
+        fprintf(stderr, RED "%s" RESET, err->message);
+        tidesdb_err_free(err);
+        return false;
+    }
+
+    return true;
+}
+
+static void ycsb_close(ycsb_t *ycsb)
+{
+    if (ycsb->handle != NULL) (void)tidesdb_release_cf_handle(ycsb->handle);
+    if (ycsb->tdb != NULL) (void)tidesdb_close(ycsb->tdb);
+}
+
+int main(int argc, char **argv)
+{
+    ycsb_options_t options = {.workloads = "a",
+                              .db = "ycsb_db",
+                              .load = true,
+                              .run = true,
+                              .recordcount = 100000,
+                              .operationcount = 100000,
+                              .threads = 1,
+                              .fieldcount = 10,
+                              .fieldlength = 100,
+                              .maxscanlength = 100,
+                              .requestdistribution = -1,
+                              .zipfian_constant = 0.99,
+                              .seed = 1,
+                              .flush_threshold = (1024 * 1024) * 64,
+                              .compress_algo = TDB_NO_COMPRESSION,
+                              .bloom_filter = true,
+                              .memtable_ds = TDB_MEMTABLE_SKIP_LIST};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            ycsb_usage();
+            return 0;
+        }
+        if (!ycsb_parse_flag(&options, argv[i]))
+        {
+            fprintf(stderr, RED "invalid flag %s\n" RESET, argv[i]);
+            ycsb_usage();
+            return 1;
+        }
+    }
+
+    if (ycsb_record_size(&options) > YCSB_VALUE_POOL_SIZE ||
+        options.fieldlength > YCSB_VALUE_POOL_SIZE)
+    {
+        fprintf(stderr, RED "records are limited to %d bytes\n" RESET, YCSB_VALUE_POOL_SIZE);
+        return 1;
+    }
+
+    /* we check every workload up front so a typo doesn't waste a load */
+    char *list = strdup(options.workloads);
+    char *save = NULL;
+    double insert_proportion = 0;
+    for (char *name = strtok_r(list, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save))
+    {
+        const ycsb_workload_t *workload = ycsb_find_workload(name);
+        if (workload == NULL)
+        {
+            fprintf(stderr, RED "unknown workload %s\n" RESET, name);
+            free(list);
+            return 1;
+        }
+        insert_proportion += workload->proportions[YCSB_INSERT];
+    }
+    free(list);
+
+    ycsb_t ycsb = {.options = &options};
+    ycsb.value_pool = malloc(YCSB_VALUE_POOL_SIZE);
+    if (ycsb.value_pool == NULL) return 1;
+
+    bench_rng_t rng;
+    bench_rng_seed(&rng, options.seed);
+    for (size_t i = 0; i < YCSB_VALUE_POOL_SIZE; i++)
+        ycsb.value_pool[i] = (uint8_t)(bench_rng_next(&rng) >> 56);
+
+    /* like YCSB the zipfian covers the records the runs are expected to insert */
+    uint64_t expected = options.recordcount +
+                        (uint64_t)((double)options.operationcount * insert_proportion * 2.0);
+    bench_zipfian_init(&ycsb.zipfian, expected, options.zipfian_constant);
+    atomic_init(&ycsb.next_insert, options.recordcount);
+    atomic_init(&ycsb.inserted, options.recordcount);
+
+    int rc = 0;
+    if (!ycsb_open(&ycsb)) rc = 1;
+
+    if (rc == 0 && options.load)
+    {
+        ycsb.workload = &ycsb_workloads[0];
+        rc = ycsb_phase(&ycsb, true);
+    }
+
+    list = strdup(options.workloads);
+    save = NULL;
+    for (char *name = strtok_r(list, ",", &save); rc == 0 && options.run && name != NULL;
+         name = strtok_r(NULL, ",", &save))
+    {
+        ycsb.workload = ycsb_find_workload(name);
+        rc = ycsb_phase(&ycsb, false);
+    }
+    free(list);
+
+    ycsb_close(&ycsb);
+    free(ycsb.value_pool);
+    return rc == 0 ? 0 : 1;
+}
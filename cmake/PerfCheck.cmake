@@ -0,0 +1,175 @@
+# runs a short fixed set of tidesdb_bench workloads and compares them against a checked in baseline
+#
+# cmake -DBENCH=path/to/tidesdb_bench -DBASELINE=bench/perf_baseline.json -DWORK_DIR=dir
+#       [-DUPDATE=ON] -P cmake/PerfCheck.cmake
+#
+# the baseline holds the bench flags, how many times to repeat the run, the tolerances and the
+# ops/sec and p99 of every workload.  each workload keeps its best ops/sec and p99 over the
+# repeats so one noisy run does not fail the check.  a workload regresses when its ops/sec falls
+# more than ops_per_sec_tolerance_pct below the baseline or its p99 rises more than
+# p99_tolerance_pct (plus p99_slack_ns, tiny latencies are mostly noise) above it.  with UPDATE
+# the measured numbers are written back to the baseline instead.  every number is an integer,
+# cmake has no floating point math
+
+cmake_minimum_required(VERSION 3.25)
+
+foreach(var BENCH BASELINE WORK_DIR)
+        if(NOT DEFINED ${var})
+                message(FATAL_ERROR "PerfCheck: ${var} is not set")
+        endif()
+endforeach()
+
+file(READ "${BASELINE}" baseline)
+
+string(JSON repeat GET "${baseline}" repeat)
+string(JSON build GET "${baseline}" build)
+string(JSON ops_tolerance GET "${baseline}" ops_per_sec_tolerance_pct)
+string(JSON p99_tolerance GET "${baseline}" p99_tolerance_pct)
+string(JSON p99_slack GET "${baseline}" p99_slack_ns)
+
+set(args "")
+string(JSON nargs LENGTH "${baseline}" args)
+math(EXPR last "${nargs} - 1")
+foreach(i RANGE ${last})
+        string(JSON arg GET "${baseline}" args ${i})
+        list(APPEND args "${arg}")
+endforeach()
+
+# the bench prints latencies in micros with two decimals, we compare them in nanoseconds
+function(perf_nanos value out)
+        if(value MATCHES "^([0-9]+)\\.([0-9]*)$")
+                string(SUBSTRING "${CMAKE_MATCH_2}000" 0 3 frac)
+                math(EXPR nanos "${CMAKE_MATCH_1} * 1000 + ${frac}")
+        elseif(value MATCHES "^[0-9]+$")
+                math(EXPR nanos "${value} * 1000")
+        else()
+                message(FATAL_ERROR "PerfCheck: ${value} is not a number")
+        endif()
+        set(${out} ${nanos} PARENT_SCOPE)
+endfunction()
+
+# pads a table cell to width columns
+function(perf_cell value width out)
+        string(LENGTH "${value}" len)
+        set(cell "${value}")
+        if(len LESS width)
+                math(EXPR pad "${width} - ${len}")
+                string(REPEAT " " ${pad} spaces)
+                set(cell "${value}${spaces}")
+        endif()
+        set(${out} "${${out}}${cell}" PARENT_SCOPE)
+endfunction()
+
+set(names "")
+foreach(run RANGE 1 ${repeat})
+        file(REMOVE_RECURSE "${WORK_DIR}")
+        file(MAKE_DIRECTORY "${WORK_DIR}")
+
+        execute_process(COMMAND "${BENCH}" ${args} --format=json --db=${WORK_DIR}/db
+                        RESULT_VARIABLE rc OUTPUT_VARIABLE output ERROR_VARIABLE errors)
+        if(NOT rc EQUAL 0)
+                message(FATAL_ERROR "PerfCheck: tidesdb_bench failed (${rc})\n${errors}")
+        endif()
+
+        string(REPLACE "\n" ";" lines "${output}")
+        foreach(line IN LISTS lines)
+                if(NOT line MATCHES "^{")
+                        continue()
+                endif()
+                string(JSON name GET "${line}" benchmark)
+                string(JSON ops GET "${line}" ops_per_sec)
+                string(JSON p99 GET "${line}" p99_us)
+                perf_nanos(${p99} p99)
+
+                if(NOT name IN_LIST names)
+                        list(APPEND names ${name})
+                        set(best_ops_${name} ${ops})
+                        set(best_p99_${name} ${p99})
+                endif()
+                if(ops GREATER best_ops_${name})
+                        set(best_ops_${name} ${ops})
+                endif()
+                if(p99 LESS best_p99_${name})
+                        set(best_p99_${name} ${p99})
+                endif()
+        endforeach()
+endforeach()
+file(REMOVE_RECURSE "${WORK_DIR}")
+
+if(UPDATE)
+        # we write the file by hand, string(JSON SET) sorts the keys and reflows everything
+        list(JOIN args "\",\n    \"" quoted)
+        set(out "{\n  \"build\": \"${build}\",\n  \"args\": [\n    \"${quoted}\"\n  ],\n")
+        string(APPEND out "  \"repeat\": ${repeat},\n")
+        string(APPEND out "  \"ops_per_sec_tolerance_pct\": ${ops_tolerance},\n")
+        string(APPEND out "  \"p99_tolerance_pct\": ${p99_tolerance},\n")
+        string(APPEND out "  \"p99_slack_ns\": ${p99_slack},\n  \"benchmarks\": {")
+        set(sep "")
+        foreach(name IN LISTS names)
+                string(APPEND out "${sep}\n    \"${name}\": {\"ops_per_sec\": ${best_ops_${name}}, "
+                       "\"p99_ns\": ${best_p99_${name}}}")
+                set(sep ",")
+        endforeach()
+        string(APPEND out "\n  }\n}\n")
+        file(WRITE "${BASELINE}" "${out}")
+        message(STATUS "PerfCheck: wrote ${BASELINE}")
+        return()
+endif()
+
+set(regressions "")
+set(row "")
+foreach(cell benchmark ops/sec baseline "p99 ns" baseline)
+        perf_cell("${cell}" 14 row)
+endforeach()
+message("${row}")
+
+# rows follow the run order, string(JSON MEMBER) would give them sorted
+foreach(name IN LISTS names)
+        set(ops ${best_ops_${name}})
+        set(p99 ${best_p99_${name}})
+        string(JSON base_ops ERROR_VARIABLE missing
+               GET "${baseline}" benchmarks ${name} ops_per_sec)
+        string(JSON base_p99 ERROR_VARIABLE missing GET "${baseline}" benchmarks ${name} p99_ns)
+
+        set(status "ok")
+        if(missing)
+                set(base_ops "-")
+                set(base_p99 "-")
+                set(status "new")
+        else()
+                math(EXPR min_ops "${base_ops} * (100 - ${ops_tolerance}) / 100")
+                math(EXPR max_p99 "${base_p99} * (100 + ${p99_tolerance}) / 100 + ${p99_slack}")
+                if(ops LESS min_ops)
+                        set(status "REGRESSION")
+                        list(APPEND regressions "${name} ops/sec ${ops} below ${min_ops}")
+                endif()
+                if(p99 GREATER max_p99)
+                        set(status "REGRESSION")
+                        list(APPEND regressions "${name} p99 ${p99}ns above ${max_p99}ns")
+                endif()
+        endif()
+
+        set(row "")
+        foreach(cell ${name} ${ops} ${base_ops} ${p99} ${base_p99})
+                perf_cell("${cell}" 14 row)
+        endforeach()
+        message("${row}${status}")
+endforeach()
+
+string(JSON count LENGTH "${baseline}" benchmarks)
+if(count EQUAL 0)
+        message(FATAL_ERROR "PerfCheck: ${BASELINE} has no benchmarks, build tidesdb_perf_baseline")
+endif()
+math(EXPR last "${count} - 1")
+foreach(i RANGE ${last})
+        string(JSON name MEMBER "${baseline}" benchmarks ${i})
+        if(NOT name IN_LIST names)
+                list(APPEND regressions "${name} did not run")
+        endif()
+endforeach()
+
+if(regressions)
+        list(JOIN regressions "\n  " report)
+        message(FATAL_ERROR "PerfCheck: regressions against ${BASELINE}\n  ${report}")
+endif()
+message(STATUS "PerfCheck: no regressions")
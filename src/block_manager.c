@@ -16,9 +16,184 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* for O_DIRECT */
+#endif
+#include <fcntl.h>
+#include <time.h>
+
 #include "block_manager.h"
 
+/*
+ * block_manager_open_direct
+ * opens the direct I/O file of a block manager and loads the unaligned tail of the file into
+ * the write buffer so appends continue from the last aligned offset
+ * @param bm the block manager
+ * @return 0 if successful or direct I/O is not supported, -1 on error
+ */
+static int block_manager_open_direct(block_manager_t *bm)
+{
+#if defined(O_DIRECT)
+    int fd = open(bm->file_path, O_RDWR | O_DIRECT);
+#elif defined(F_NOCACHE)
+    int fd = open(bm->file_path, O_RDWR);
+    if (fd != -1 && fcntl(fd, F_NOCACHE, 1) == -1)
+    {
+        (void)close(fd);
+        fd = -1;
+    }
+#else
+    int fd = -1;
+#endif
+
+    /* not every file system supports direct I/O (tmpfs for one), we stay buffered there */
+    if (fd == -1) return 0;
+
+    if (posix_memalign((void **)&bm->write_buf, BLOCK_MANAGER_DIRECT_IO_ALIGNMENT,
+                       BLOCK_MANAGER_DIRECT_IO_BUFFER_SIZE) != 0)
+    {
+        (void)close(fd);
+        bm->write_buf = NULL;
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        (void)close(fd);
+        free(bm->write_buf);
+        bm->write_buf = NULL;
+        return -1;
+    }
+
+    bm->write_pos = (uint64_t)st.st_size & ~((uint64_t)BLOCK_MANAGER_DIRECT_IO_ALIGNMENT - 1);
+    bm->write_len = (size_t)((uint64_t)st.st_size - bm->write_pos);
+
+    /* a short read at the end of the file is expected, we only need the tail */
+    if (bm->write_len > 0 &&
+        pread(fd, bm->write_buf, BLOCK_MANAGER_DIRECT_IO_ALIGNMENT, (off_t)bm->write_pos) <
+            (ssize_t)bm->write_len)
+    {
+        (void)close(fd);
+        free(bm->write_buf);
+        bm->write_buf = NULL;
+        return -1;
+    }
+
+    bm->direct_fd = fd;
+    return 0;
+}
+
+/*
+ * block_manager_pwrite
+ * writes exactly size bytes at offset
+ * @param fd the file to write to
+ * @param buf the buffer to write
+ * @param size the amount of bytes to write
+ * @param offset the offset to write at
+ * @return 0 if successful, -1 if not
+ */
+static int block_manager_pwrite(int fd, const void *buf, size_t size, uint64_t offset)
+{
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t n = pwrite(fd, (const uint8_t *)buf + done, size - done, (off_t)(offset + done));
+        if (n <= 0) return -1;
+        done += (size_t)n;
+    }
+
+    return 0;
+}
+
+/*
+ * block_manager_direct_append
+ * appends to the direct I/O write buffer, full buffers are written out
+ * @param bm the block manager
+ * @param data the data to append
+ * @param size the size of the data
+ * @return 0 if successful, -1 if not
+ */
+static int block_manager_direct_append(block_manager_t *bm, const void *data, size_t size)
+{
+    const uint8_t *src = data;
+    while (size > 0)
+    {
+        size_t n = BLOCK_MANAGER_DIRECT_IO_BUFFER_SIZE - bm->write_len;
+        if (n > size) n = size;
+
+        memcpy(bm->write_buf + bm->write_len, src, n);
+        bm->write_len += n;
+        bm->write_dirty = true;
+        src += n;
+        size -= n;
+
+        if (bm->write_len == BLOCK_MANAGER_DIRECT_IO_BUFFER_SIZE)
+        {
+            if (block_manager_pwrite(bm->direct_fd, bm->write_buf,
+                                     BLOCK_MANAGER_DIRECT_IO_BUFFER_SIZE, bm->write_pos) != 0)
+                return -1;
+
+            bm->write_pos += BLOCK_MANAGER_DIRECT_IO_BUFFER_SIZE;
+            bm->write_len = 0;
+            bm->write_dirty = false;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * block_manager_direct_flush
+ * writes the direct I/O write buffer out, padded to the alignment, then truncates the padding
+ * the unaligned tail stays in the buffer so the next append rewrites its aligned chunk
+ * @param bm the block manager
+ * @return 0 if successful, -1 if not
+ */
+static int block_manager_direct_flush(block_manager_t *bm)
+{
+    if (!bm->write_dirty) return 0;
+
+    size_t padded = (bm->write_len + BLOCK_MANAGER_DIRECT_IO_ALIGNMENT - 1) &
+                    ~((size_t)BLOCK_MANAGER_DIRECT_IO_ALIGNMENT - 1);
+    memset(bm->write_buf + bm->write_len, 0, padded - bm->write_len);
+
+    if (block_manager_pwrite(bm->direct_fd, bm->write_buf, padded, bm->write_pos) != 0) return -1;
+
+    /* the padding is not part of the file */
+    if (ftruncate(bm->direct_fd, (off_t)(bm->write_pos + bm->write_len)) != 0) return -1;
+
+    /* we only keep the unaligned tail */
+    size_t aligned = bm->write_len & ~((size_t)BLOCK_MANAGER_DIRECT_IO_ALIGNMENT - 1);
+    if (aligned > 0)
+    {
+        memmove(bm->write_buf, bm->write_buf + aligned, bm->write_len - aligned);
+        bm->write_pos += aligned;
+        bm->write_len -= aligned;
+    }
+
+    bm->write_dirty = false;
+    return 0;
+}
+
+/*
+ * block_manager_read_fd
+ * gets the file descriptor reads should go through
+ * @param bm the block manager
+ * @return the file descriptor
+ */
+static int block_manager_read_fd(block_manager_t *bm)
+{
+    return bm->direct_fd != -1 ? bm->direct_fd : fileno(bm->file);
+}
+
 int block_manager_open(block_manager_t **bm, const char *file_path, float fsync_interval)
+{
+    return block_manager_open_w_direct_io(bm, file_path, fsync_interval, false);
+}
+
+int block_manager_open_w_direct_io(block_manager_t **bm, const char *file_path,
+                                   float fsync_interval, bool direct_io)
 {
     /* we allocate memory for the new block manager */
     (*bm) = malloc(sizeof(block_manager_t));
@@ -40,25 +215,90 @@ int block_manager_open(block_manager_t **bm, const char *file_path, float fsync_
     /* we set the stop fsync thread flag to 0 */
     (*bm)->stop_fsync_thread = 0;
 
+    (*bm)->direct_fd = -1;
+    (*bm)->write_buf = NULL;
+    (*bm)->write_len = 0;
+    (*bm)->write_pos = 0;
+    (*bm)->write_dirty = false;
+    (*bm)->sync_hook = NULL;
+    (*bm)->sync_hook_arg = NULL;
+
+    if (direct_io && block_manager_open_direct(*bm) == -1)
+    {
+        (void)fclose((*bm)->file);
+        free(*bm);
+        return -1;
+    }
+
+    /* immutable files are synced once when written so they don't need an fsync thread */
+    if (fsync_interval <= 0) return 0;
+
+    (void)pthread_mutex_init(&(*bm)->fsync_lock, NULL);
+    (void)pthread_cond_init(&(*bm)->fsync_cond, NULL);
+
     /* we create and start the fsync thread */
     if (pthread_create(&(*bm)->fsync_thread, NULL, block_manager_fsync_thread, *bm) != 0)
     {
+        (void)pthread_cond_destroy(&(*bm)->fsync_cond);
+        (void)pthread_mutex_destroy(&(*bm)->fsync_lock);
+        if ((*bm)->direct_fd != -1) (void)close((*bm)->direct_fd);
+        free((*bm)->write_buf);
+        (void)fclose((*bm)->file);
         free(*bm);
         return -1;
     }
     return 0;
 }
 
+int block_manager_set_sync_hook(block_manager_t *bm, void (*hook)(void *arg, bool begin),
+                                void *arg)
+{
+    if (bm->fsync_interval <= 0) return -1;
+
+    /* the fsync thread reads the hook under the fsync lock */
+    (void)pthread_mutex_lock(&bm->fsync_lock);
+    bm->sync_hook = hook;
+    bm->sync_hook_arg = arg;
+    (void)pthread_mutex_unlock(&bm->fsync_lock);
+
+    return 0;
+}
+
 int block_manager_close(block_manager_t *bm)
 {
-    /* we stop the fsync thread */
+    /* we stop the fsync thread and join it if we started one, waking it so we don't wait out
+     * its interval */
+    if (bm->fsync_interval > 0)
+    {
+        (void)pthread_mutex_lock(&bm->fsync_lock);
+        bm->stop_fsync_thread = 1;
+        (void)pthread_cond_signal(&bm->fsync_cond);
+        (void)pthread_mutex_unlock(&bm->fsync_lock);
+
+        if (pthread_join(bm->fsync_thread, NULL) != 0) return -1;
+
+        (void)pthread_cond_destroy(&bm->fsync_cond);
+        (void)pthread_mutex_destroy(&bm->fsync_lock);
+    }
     bm->stop_fsync_thread = 1;
 
     /* we flush the file to disk */
     fsync(fileno(bm->file)); /* flush file to disk */
 
-    /* we join the fsync thread */
-    if (pthread_join(bm->fsync_thread, NULL) != 0) return -1;
+    /* we write out what is left in the direct I/O write buffer */
+    if (bm->direct_fd != -1)
+    {
+        int rc = block_manager_direct_flush(bm);
+        if (rc == 0) rc = fsync(bm->direct_fd);
+        (void)close(bm->direct_fd);
+        free(bm->write_buf);
+        if (rc != 0)
+        {
+            (void)fclose(bm->file);
+            free(bm);
+            return -1;
+        }
+    }
 
     /* we close the file */
     if (fclose(bm->file) != 0) return -1;
@@ -95,6 +335,13 @@ block_manager_block_t *block_manager_block_create(uint64_t size, void *data)
 
 int block_manager_block_write(block_manager_t *bm, block_manager_block_t *block)
 {
+    /* with direct I/O blocks go through the aligned write buffer */
+    if (bm->direct_fd != -1)
+    {
+        if (block_manager_direct_append(bm, &block->size, sizeof(uint64_t)) != 0) return -1;
+        return block_manager_direct_append(bm, block->data, block->size);
+    }
+
     /* seek to end of file */
     if (fseek(bm->file, 0, SEEK_END) != 0) return -1;
 
@@ -141,6 +388,94 @@ block_manager_block_t *block_manager_block_read(block_manager_t *bm)
     return block;
 }
 
+int block_manager_sync(block_manager_t *bm)
+{
+    if (bm->direct_fd != -1)
+    {
+        if (block_manager_direct_flush(bm) != 0) return -1;
+        return fsync(bm->direct_fd) != 0 ? -1 : 0;
+    }
+
+    /* we flush the stdio buffer then sync the file to disk */
+    if (fflush(bm->file) != 0) return -1;
+    if (fsync(fileno(bm->file)) != 0) return -1;
+
+    return 0;
+}
+
+/*
+ * block_manager_direct_pread
+ * reads exactly size bytes at offset with direct I/O through an aligned bounce buffer
+ * @param bm the block manager to read from
+ * @param buf the buffer to read into
+ * @param size the amount of bytes to read
+ * @param offset the offset to read at
+ * @return 0 if successful, 1 if the end of the file was reached, -1 on error
+ */
+static int block_manager_direct_pread(block_manager_t *bm, void *buf, size_t size,
+                                      uint64_t offset)
+{
+    uint64_t start = offset & ~((uint64_t)BLOCK_MANAGER_DIRECT_IO_ALIGNMENT - 1);
+    size_t span = (size_t)(offset + size - start);
+    span = (span + BLOCK_MANAGER_DIRECT_IO_ALIGNMENT - 1) &
+           ~((size_t)BLOCK_MANAGER_DIRECT_IO_ALIGNMENT - 1);
+
+    uint8_t *aligned = NULL;
+    if (posix_memalign((void **)&aligned, BLOCK_MANAGER_DIRECT_IO_ALIGNMENT, span) != 0)
+        return -1;
+
+    size_t done = 0;
+    while (done < span)
+    {
+        ssize_t n = pread(bm->direct_fd, aligned + done, span - done, (off_t)(start + done));
+        if (n < 0)
+        {
+            free(aligned);
+            return -1;
+        }
+        done += (size_t)n;
+
+        /* a short read means we hit the end of the file */
+        if (n == 0 || done % BLOCK_MANAGER_DIRECT_IO_ALIGNMENT != 0) break;
+    }
+
+    int rc = 1; /* end of file */
+    if (start + done >= offset + size)
+    {
+        memcpy(buf, aligned + (offset - start), size);
+        rc = 0;
+    }
+
+    free(aligned);
+    return rc;
+}
+
+/*
+ * block_manager_pread
+ * reads exactly size bytes at offset without moving the shared file position
+ * @param bm the block manager to read from
+ * @param buf the buffer to read into
+ * @param size the amount of bytes to read
+ * @param offset the offset to read at
+ * @return 0 if successful, 1 if the end of the file was reached, -1 on error
+ */
+static int block_manager_pread(block_manager_t *bm, void *buf, size_t size, uint64_t offset)
+{
+    if (bm->direct_fd != -1) return block_manager_direct_pread(bm, buf, size, offset);
+
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t n = pread(fileno(bm->file), (uint8_t *)buf + done, size - done,
+                          (off_t)(offset + done));
+        if (n == 0) return 1; /* end of file */
+        if (n < 0) return -1;
+        done += (size_t)n;
+    }
+
+    return 0;
+}
+
 void block_manager_block_free(block_manager_block_t *block)
 {
     /* we free the data and the block */
@@ -158,8 +493,22 @@ int block_manager_cursor_init(block_manager_cursor_t **cursor, block_manager_t *
     (*cursor) = malloc(sizeof(block_manager_cursor_t));
     if (!(*cursor)) return -1; /* if allocation fails, return -1 */
 
-    /* seek to beginning of file */
-    if (fseek(bm->file, 0, SEEK_SET) != 0) return -1;
+    /* we flush buffered writes so the cursor sees everything written so far */
+    if (fflush(bm->file) != 0 || (bm->direct_fd != -1 && block_manager_direct_flush(bm) != 0))
+    {
+        free(*cursor);
+        return -1;
+    }
+
+    /* we allocate the read-ahead buffer of the cursor, aligned so it can take direct reads */
+    if (posix_memalign((void **)&(*cursor)->buf, BLOCK_MANAGER_DIRECT_IO_ALIGNMENT,
+                       BLOCK_MANAGER_CURSOR_BUFFER_SIZE) != 0)
+    {
+        free(*cursor);
+        return -1;
+    }
+    (*cursor)->buf_pos = 0;
+    (*cursor)->buf_len = 0;
 
     /* we set the block manager of the cursor */
     (*cursor)->bm = bm;
@@ -168,26 +517,59 @@ int block_manager_cursor_init(block_manager_cursor_t **cursor, block_manager_t *
     return 0;
 }
 
-int block_manager_cursor_next(block_manager_cursor_t *cursor)
+/*
+ * block_manager_cursor_pread
+ * reads exactly size bytes at offset through the read-ahead buffer of the cursor
+ * small reads are served from the buffer so sequential scans cost one pread per buffer
+ * @param cursor the cursor to read with
+ * @param buf the buffer to read into
+ * @param size the amount of bytes to read
+ * @param offset the offset to read at
+ * @return 0 if successful, 1 if the end of the file was reached, -1 on error
+ */
+static int block_manager_cursor_pread(block_manager_cursor_t *cursor, void *buf, size_t size,
+                                      uint64_t offset)
 {
-    uint64_t block_size; /* we declare a variable to store the block size */
-    if (fseek(cursor->bm->file, cursor->current_pos, SEEK_SET) != 0)
-        return -1; /* we move the file pointer to the current position */
+    /* large reads bypass the buffer */
+    if (size > BLOCK_MANAGER_CURSOR_BUFFER_SIZE)
+        return block_manager_pread(cursor->bm, buf, size, offset);
 
-    /* we read the size of the next block */
-    if (fread(&block_size, sizeof(uint64_t), 1, cursor->bm->file) != 1)
+    /* we refill the buffer if the range is not in it */
+    if (offset < cursor->buf_pos || offset + size > cursor->buf_pos + cursor->buf_len)
     {
-        if (feof(cursor->bm->file)) return 1; /* if we reached the end of the file, return 1 */
-        return -1;
+        /* direct reads have to start at an aligned offset */
+        uint64_t start = offset;
+        if (cursor->bm->direct_fd != -1)
+            start &= ~((uint64_t)BLOCK_MANAGER_DIRECT_IO_ALIGNMENT - 1);
+
+        ssize_t n = pread(block_manager_read_fd(cursor->bm), cursor->buf,
+                          BLOCK_MANAGER_CURSOR_BUFFER_SIZE, (off_t)start);
+        if (n < 0) return -1;
+
+        cursor->buf_pos = start;
+        cursor->buf_len = (size_t)n;
+
+        /* a short read is fine as long as it covers the range */
+        if (cursor->buf_pos + cursor->buf_len < offset + size)
+            return block_manager_pread(cursor->bm, buf, size, offset);
     }
 
+    memcpy(buf, cursor->buf + (offset - cursor->buf_pos), size);
+    return 0;
+}
+
+int block_manager_cursor_next(block_manager_cursor_t *cursor)
+{
+    uint64_t block_size; /* we declare a variable to store the block size */
+
+    /* we read the size of the block at the current position */
+    int rc = block_manager_cursor_pread(cursor, &block_size, sizeof(uint64_t), cursor->current_pos);
+    if (rc != 0) return rc; /* 1 if we reached the end of the file, -1 on error */
+
     /* we set the current block size */
     cursor->current_block_size = block_size;
 
-    /* we move the file pointer to the beginning of the next block */
-    if (fseek(cursor->bm->file, cursor->current_pos + sizeof(uint64_t), SEEK_SET) != 0) return -1;
-
-    /* we update the current position */
+    /* we update the current position to the beginning of the next block */
     cursor->current_pos += sizeof(uint64_t) + block_size;
 
     return 0;
@@ -195,23 +577,11 @@ int block_manager_cursor_next(block_manager_cursor_t *cursor)
 
 int block_manager_cursor_has_next(block_manager_cursor_t *cursor)
 {
-    /* save the current file pointer position */
-    long original_pos = ftell(cursor->bm->file);
-    if (original_pos == -1) return -1;
-
-    /* move the file pointer to the current position */
-    if (fseek(cursor->bm->file, cursor->current_pos, SEEK_SET) != 0) return -1;
-
-    /* read the size of the next block */
+    /* we read the size of the next block */
     uint64_t block_size;
-    if (fread(&block_size, sizeof(uint64_t), 1, cursor->bm->file) != 1)
-    {
-        if (feof(cursor->bm->file)) return 0; /* if we reached the end of the file, return 0 */
-        return -1;
-    }
-
-    /* restore the original file pointer position */
-    if (fseek(cursor->bm->file, original_pos, SEEK_SET) != 0) return -1;
+    int rc = block_manager_cursor_pread(cursor, &block_size, sizeof(uint64_t), cursor->current_pos);
+    if (rc == 1) return 0; /* if we reached the end of the file, return 0 */
+    if (rc == -1) return -1;
 
     return 1;
 }
@@ -221,26 +591,22 @@ int block_manager_cursor_goto_last(block_manager_cursor_t *cursor)
     if (cursor == NULL || cursor->bm == NULL)
         return -1; /* if the cursor or the block manager is NULL, return -1 */
 
-    /* seek to the beginning of the file */
-    if (fseek(cursor->bm->file, 0, SEEK_SET) != 0) return -1;
-
-    uint64_t block_size;
-    long last_pos = 0;
-    long current_pos = 0;
+    uint64_t block_size = 0;
+    uint64_t last_size = 0;
+    uint64_t last_pos = 0;
+    uint64_t current_pos = 0;
 
     /* traverse through each block until the end of the file */
-    while (fread(&block_size, sizeof(uint64_t), 1, cursor->bm->file) == 1)
+    while (block_manager_cursor_pread(cursor, &block_size, sizeof(uint64_t), current_pos) == 0)
     {
         last_pos = current_pos;
+        last_size = block_size;
         current_pos += sizeof(uint64_t) + block_size;
-
-        /* move the file pointer to the next block */
-        if (fseek(cursor->bm->file, block_size, SEEK_CUR) != 0) return -1;
     }
 
     /* update the cursor position and block size */
     cursor->current_pos = last_pos;
-    cursor->current_block_size = block_size;
+    cursor->current_block_size = last_size;
 
     return 0;
 }
@@ -249,12 +615,9 @@ int block_manager_cursor_goto_first(block_manager_cursor_t *cursor)
 {
     if (cursor == NULL || cursor->bm == NULL) return -1;
 
-    /* move to the beginning of the file */
-    if (fseek(cursor->bm->file, 0, SEEK_SET) != 0) return -1;
-
     /* read the size of the first block */
     uint64_t block_size;
-    if (fread(&block_size, sizeof(uint64_t), 1, cursor->bm->file) != 1) return -1;
+    if (block_manager_cursor_pread(cursor, &block_size, sizeof(uint64_t), 0) != 0) return -1;
 
     /* update the cursor position */
     cursor->current_pos = 0;
@@ -311,9 +674,33 @@ block_manager_block_t *block_manager_cursor_read(block_manager_cursor_t *cursor)
 {
     if (cursor == NULL) return NULL; /* if the cursor is NULL, return NULL */
 
-    /* we move the file pointer to the current position */
-    if (fseek(cursor->bm->file, cursor->current_pos, SEEK_SET) != 0) return NULL;
-    return block_manager_block_read(cursor->bm); /* we read the block at the current position */
+    /* we read the size of the block at the current position */
+    uint64_t block_size;
+    if (block_manager_cursor_pread(cursor, &block_size, sizeof(uint64_t), cursor->current_pos) != 0)
+        return NULL;
+
+    /* we allocate memory for the new block */
+    block_manager_block_t *block = malloc(sizeof(block_manager_block_t));
+    if (!block) return NULL; /* if allocation fails, return NULL */
+
+    block->size = block_size;
+    block->data = malloc(block_size);
+    if (!block->data)
+    {
+        free(block);
+        return NULL;
+    }
+
+    /* we read the data of the block */
+    if (block_manager_cursor_pread(cursor, block->data, block_size,
+                                   cursor->current_pos + sizeof(uint64_t)) != 0)
+    {
+        free(block->data);
+        free(block);
+        return NULL;
+    }
+
+    return block;
 }
 
 void block_manager_cursor_free(block_manager_cursor_t *cursor)
@@ -323,6 +710,7 @@ void block_manager_cursor_free(block_manager_cursor_t *cursor)
     {
         if (cursor->bm) cursor->bm = NULL;
 
+        free(cursor->buf);
         free(cursor);
         cursor = NULL;
     }
@@ -332,12 +720,36 @@ void *block_manager_fsync_thread(void *arg)
 {
     /* we cast the argument to a block manager */
     block_manager_t *bm = arg;
-    /* we fsync the file every fsync interval */
+    uint64_t interval_ns = (uint64_t)((double)bm->fsync_interval * 1e9);
+
+    /* we fsync the file every fsync interval, we wait on a condition rather than sleeping as
+     * sleep takes whole seconds and would spin on a fractional interval */
+    (void)pthread_mutex_lock(&bm->fsync_lock);
     while (bm->stop_fsync_thread == 0)
     {
-        sleep(bm->fsync_interval);
+        struct timespec deadline;
+        (void)clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t)(interval_ns / 1000000000ULL);
+        deadline.tv_nsec += (long)(interval_ns % 1000000000ULL);
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        (void)pthread_cond_timedwait(&bm->fsync_cond, &bm->fsync_lock, &deadline);
+        if (bm->stop_fsync_thread != 0) break;
+
+        void (*hook)(void *arg, bool begin) = bm->sync_hook;
+        void *hook_arg = bm->sync_hook_arg;
+
+        (void)pthread_mutex_unlock(&bm->fsync_lock);
+        if (hook != NULL) hook(hook_arg, true);
         fsync(fileno(bm->file));
+        if (hook != NULL) hook(hook_arg, false);
+        (void)pthread_mutex_lock(&bm->fsync_lock);
     }
+    (void)pthread_mutex_unlock(&bm->fsync_lock);
     return NULL;
 }
 
@@ -349,6 +761,11 @@ int block_manager_truncate(block_manager_t *bm)
     /* we truncate the file */
     if (truncate(bm->file_path, 0) != 0) return -1;
 
+    /* the direct I/O write buffer starts over */
+    bm->write_pos = 0;
+    bm->write_len = 0;
+    bm->write_dirty = false;
+
     /* we open the file again */
     bm->file = fopen(bm->file_path, "a+b");
     if (!bm->file) return -1;
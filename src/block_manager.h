@@ -19,6 +19,7 @@
 #ifndef __BLOCK_MANAGER_H__
 #define __BLOCK_MANAGER_H__
 #include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -27,6 +28,9 @@
 #include <unistd.h>
 
 #define MAX_FILE_PATH_LENGTH 1024 /* max file path length for block manager file(s) */
+#define BLOCK_MANAGER_CURSOR_BUFFER_SIZE (64 * 1024) /* read-ahead buffer size for cursors */
+#define BLOCK_MANAGER_DIRECT_IO_ALIGNMENT 4096 /* offset and size alignment for direct I/O */
+#define BLOCK_MANAGER_DIRECT_IO_BUFFER_SIZE (1024 * 1024) /* write buffer size for direct I/O */
 
 /**
  * block_manager_t
@@ -35,8 +39,17 @@
  * @param file the file the block manager is managing
  * @param file_path the path of the file
  * @param fsync_thread the fsync thread
- * @param fsync_interval the fsync interval
+ * @param fsync_interval the fsync interval, 0 or less means no fsync thread is started
  * @param stop_fsync_thread flag to stop fsync thread
+ * @param fsync_lock the lock the fsync thread sleeps under
+ * @param fsync_cond signalled to wake the fsync thread when it is stopped
+ * @param direct_fd the file opened for direct I/O, -1 if the block manager is buffered
+ * @param write_buf the aligned write buffer for direct I/O
+ * @param write_len the amount of bytes in the write buffer
+ * @param write_pos the aligned file offset the write buffer starts at
+ * @param write_dirty whether the write buffer holds bytes that are not on disk yet
+ * @param sync_hook called before and after each sync of the fsync thread, NULL for none
+ * @param sync_hook_arg the argument passed to the sync hook
  */
 typedef struct
 {
@@ -45,6 +58,15 @@ typedef struct
     pthread_t fsync_thread;
     float fsync_interval;
     int stop_fsync_thread;
+    pthread_mutex_t fsync_lock;
+    pthread_cond_t fsync_cond;
+    int direct_fd;
+    uint8_t *write_buf;
+    size_t write_len;
+    uint64_t write_pos;
+    bool write_dirty;
+    void (*sync_hook)(void *arg, bool begin);
+    void *sync_hook_arg;
 } block_manager_t;
 
 /**
@@ -67,12 +89,18 @@ typedef struct
  * @param bm the block manager
  * @param current_pos the current position of the cursor
  * @param previous_pos the previous position of the cursor
+ * @param buf the read-ahead buffer of the cursor
+ * @param buf_pos the file offset the read-ahead buffer starts at
+ * @param buf_len the amount of valid bytes in the read-ahead buffer
  */
 typedef struct
 {
     block_manager_t *bm;
     uint64_t current_pos;
     uint64_t current_block_size;
+    uint8_t *buf;
+    uint64_t buf_pos;
+    size_t buf_len;
 } block_manager_cursor_t;
 
 /**
@@ -80,11 +108,38 @@ typedef struct
  * opens a block manager
  * @param bm the block manager to open
  * @param file_path the path of the file
- * @param fsync_interval the fsync interval
+ * @param fsync_interval the fsync interval, 0 or less to not start an fsync thread (i.e immutable
+ * files which are synced once with block_manager_sync)
  * @return 0 if successful, -1 if not
  */
 int block_manager_open(block_manager_t **bm, const char *file_path, float fsync_interval);
 
+/**
+ * block_manager_open_w_direct_io
+ * opens a block manager which can bypass the page cache
+ * with direct I/O writes are staged in an aligned buffer and written in aligned chunks, the
+ * unaligned tail is written padded and the file truncated back on sync, cursor reads are aligned
+ * as well.  if the file system doesn't support direct I/O the block manager stays buffered
+ * @param bm the block manager to open
+ * @param file_path the path of the file
+ * @param fsync_interval the fsync interval, 0 or less to not start an fsync thread
+ * @param direct_io whether to use direct I/O
+ * @return 0 if successful, -1 if not
+ */
+int block_manager_open_w_direct_io(block_manager_t **bm, const char *file_path,
+                                   float fsync_interval, bool direct_io);
+
+/**
+ * block_manager_set_sync_hook
+ * sets the hook the fsync thread calls around each sync, the hook runs on the fsync thread
+ * @param bm the block manager
+ * @param hook the hook, called with begin true before the sync and false after it, NULL to remove
+ * @param arg the argument passed to the hook
+ * @return 0 if successful, -1 if the block manager has no fsync thread
+ */
+int block_manager_set_sync_hook(block_manager_t *bm, void (*hook)(void *arg, bool begin),
+                                void *arg);
+
 /**
  * block_manager_close
  * closes a block manager gracefully
@@ -119,6 +174,14 @@ int block_manager_block_write(block_manager_t *bm, block_manager_block_t *block)
  */
 block_manager_block_t *block_manager_block_read(block_manager_t *bm);
 
+/**
+ * block_manager_sync
+ * flushes buffered writes and syncs the file to disk
+ * @param bm the block manager to sync
+ * @return 0 if successful, -1 if not
+ */
+int block_manager_sync(block_manager_t *bm);
+
 /**
  * block_manager_block_free
  * frees a block
@@ -129,6 +192,7 @@ void block_manager_block_free(block_manager_block_t *block);
 /**
  * block_manager_cursor_init
  * initializes a block manager cursor
+ * cursors read at their own position with pread so many cursors can read the same file at once
  * @param cursor the cursor to initialize
  * @param bm the block manager to initialize the cursor on
  * @return 0 if successful, -1 if not
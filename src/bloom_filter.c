@@ -86,6 +86,15 @@ int bloom_filter_is_full(bloom_filter_t *bf)
     return 1;
 }
 
+int bloom_filter_count_set(bloom_filter_t *bf)
+{
+    int set = 0;
+    for (int i = 0; i < bf->m; i++)
+        if (bf->bitset[i] != 0) set++;
+
+    return set;
+}
+
 unsigned int bloom_filter_hash(const uint8_t *entry, size_t size, int seed)
 {
     /* local constants */
@@ -74,6 +74,14 @@ int bloom_filter_contains(bloom_filter_t *bf, const uint8_t *entry, size_t size)
  */
 int bloom_filter_is_full(bloom_filter_t *bf);
 
+/**
+ * bloom_filter_count_set
+ * counts the bits set in the bloom filter, divided by m it is the fill ratio
+ * @param bf the bloom filter
+ * @return the number of bits set
+ */
+int bloom_filter_count_set(bloom_filter_t *bf);
+
 /**
  * bloom_filter_hash
  * hashes an entry
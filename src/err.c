@@ -125,6 +125,12 @@ tidesdb_err_t* tidesdb_err_from_code(TIDESDB_ERR_CODE code, ...)
             snprintf(buffer, sizeof(buffer), tidesdb_err_messages[code].message, obj);
             break;
         }
+        case TIDESDB_ERR_FAILED_TO_START_THREAD:
+        {
+            const char* obj = va_arg(args, const char*);
+            snprintf(buffer, sizeof(buffer), tidesdb_err_messages[code].message, obj);
+            break;
+        }
         default:
             snprintf(buffer, sizeof(buffer), "%s", tidesdb_err_messages[code].message);
     }
@@ -133,4 +139,29 @@ tidesdb_err_t* tidesdb_err_from_code(TIDESDB_ERR_CODE code, ...)
 
     tidesdb_err_t* err = tidesdb_err_new(tidesdb_err_messages[code].code, buffer);
     return err;
-}
\ No newline at end of file
+}
+
+tidesdb_err_t* tidesdb_err_from_status(int status)
+{
+    if (status == TIDESDB_SUCCESS) return NULL;
+
+    /* a status doesn't carry the object it is about so we name the most likely one, the status
+     * apis only fail on the column family or the value they allocate */
+    switch (status)
+    {
+        case TIDESDB_ERR_MEMORY_ALLOC:
+            return tidesdb_err_from_code(status, "value");
+        default:
+            return tidesdb_err_from_code(status, "column family");
+    }
+}
+
+const char* tidesdb_err_message(int status)
+{
+    if (status == TIDESDB_SUCCESS) return "Success.\n";
+
+    if (status < 0 || status > TIDESDB_ERR_WRITE_STALLED)
+        return "Unknown error.\n";
+
+    return tidesdb_err_messages[status].message;
+}
@@ -57,6 +57,7 @@ typedef struct
  */
 typedef enum
 {
+    TIDESDB_SUCCESS = -1, /* status of a call that succeeded, error codes start at 0 */
     TIDESDB_ERR_INVALID_DB,
     TIDESDB_ERR_INVALID_DB_DIR,
     TIDESDB_ERR_MEMORY_ALLOC,
@@ -96,6 +97,8 @@ typedef enum
     TIDESDB_ERR_FAILED_TO_DESERIALIZE_BLOOM_FILTER,
     TIDESDB_ERR_NOT_IMPLEMENTED,
     TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE,
+    TIDESDB_ERR_FAILED_TO_START_THREAD,
+    TIDESDB_ERR_WRITE_STALLED,
 } TIDESDB_ERR_CODE;
 
 /* TidesDB error messages */
@@ -114,8 +117,8 @@ static const tidesdb_err_info_t tidesdb_err_messages[] = {
     {TIDESDB_ERR_FAILED_TO_CREATE_COLUMN_FAMILY, "Failed to create column family.\n"},
     {TIDESDB_ERR_FAILED_TO_ADD_COLUMN_FAMILY, "Failed to add column family.\n"},
     {TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND, "Column family not found.\n"},
-    {TIDESDB_ERR_RM_FAILED, "Failed to remove %s.\n"},
     {TIDESDB_ERR_REALLOC_FAILED, "Memory reallocation failed for %s.\n"},
+    {TIDESDB_ERR_RM_FAILED, "Failed to remove %s.\n"},
     {TIDESDB_ERR_INVALID_COLUMN_FAMILY, "Invalid column family.\n"},
     {TIDESDB_ERR_INVALID_KEY, "Invalid key.\n"},
     {TIDESDB_ERR_INVALID_VALUE, "Invalid value.\n"},
@@ -140,6 +143,8 @@ static const tidesdb_err_info_t tidesdb_err_messages[] = {
     {TIDESDB_ERR_FAILED_TO_DESERIALIZE_BLOOM_FILTER, "Failed to deserialize bloom filter.\n"},
     {TIDESDB_ERR_NOT_IMPLEMENTED, "Not implemented.\n"},
     {TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE, "Invalid memtable data structure.\n"},
+    {TIDESDB_ERR_FAILED_TO_START_THREAD, "Failed to start thread for %s.\n"},
+    {TIDESDB_ERR_WRITE_STALLED, "Write stalled waiting for compaction.\n"},
 
 };
 
@@ -166,4 +171,21 @@ void tidesdb_err_free(tidesdb_err_t *e);
  */
 tidesdb_err_t *tidesdb_err_from_code(TIDESDB_ERR_CODE code, ...);
 
+/*
+ * tidesdb_err_from_status
+ * create a new TidesDB error from a status code returned by a status api
+ * @param status the status code
+ * @return the error or NULL if the status is TIDESDB_SUCCESS
+ */
+tidesdb_err_t *tidesdb_err_from_status(int status);
+
+/*
+ * tidesdb_err_message
+ * get the message for a status code without allocating, messages of codes that name an object
+ * are returned unformatted
+ * @param status the status code
+ * @return the message
+ */
+const char *tidesdb_err_message(int status);
+
 #endif /* __TIDESDB_ERR_H__ */
\ No newline at end of file
@@ -0,0 +1,355 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fuse_filter.h"
+
+#include <stdbool.h>
+
+/* the binary fuse construction follows Graf and Lemire, "Binary Fuse Filters: Fast and Smaller
+ * Than Xor Filters" (2022), with 8 bit fingerprints and 3 slots per key */
+
+/*
+ * fuse_filter_mix
+ * the murmur3 64 bit finalizer, a bijection so distinct inputs stay distinct
+ * @param h the value to mix
+ * @return the mixed value
+ */
+static uint64_t fuse_filter_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * fuse_filter_next_seed
+ * splitmix64, the seeds tried while building
+ * @param state the generator state
+ * @return the next seed
+ */
+static uint64_t fuse_filter_next_seed(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * fuse_filter_mulhi
+ * the high 64 bits of a 64 by 32 bit product, maps a hash onto [0, n)
+ * @param hash the hash
+ * @param n the range
+ * @return the high bits
+ */
+static uint64_t fuse_filter_mulhi(uint64_t hash, uint32_t n)
+{
+    uint64_t hi = (hash >> 32) * n;
+    uint64_t lo = (hash & 0xffffffffULL) * n;
+    return (hi + (lo >> 32)) >> 32;
+}
+
+static uint8_t fuse_filter_fingerprint(uint64_t hash)
+{
+    return (uint8_t)(hash ^ (hash >> 32));
+}
+
+/*
+ * fuse_filter_slots
+ * gets the 3 slots of a mixed key hash, one in each of 3 consecutive segments
+ * @param ff the fuse filter
+ * @param hash the key hash mixed with the seed
+ * @param slots the slots
+ */
+static void fuse_filter_slots(const fuse_filter_t *ff, uint64_t hash, uint32_t slots[3])
+{
+    uint32_t h0 = (uint32_t)fuse_filter_mulhi(hash, ff->segment_count_length);
+    slots[0] = h0;
+    slots[1] = (h0 + ff->segment_length) ^ ((uint32_t)(hash >> 18) & ff->segment_length_mask);
+    slots[2] = (h0 + 2 * ff->segment_length) ^ ((uint32_t)hash & ff->segment_length_mask);
+}
+
+/*
+ * fuse_filter_size
+ * sizes the segments and the fingerprint array of a fuse filter for n keys
+ * @param ff the fuse filter
+ * @param n the number of keys
+ */
+static void fuse_filter_size(fuse_filter_t *ff, size_t n)
+{
+    /* these constants come from the paper, they keep construction succeeding on the first seed
+     * almost always */
+    double size = n < 2 ? 2.0 : (double)n;
+    uint32_t segment_length = 1U << (int)floor(log(size) / log(3.33) + 2.25);
+    if (segment_length > FUSE_FILTER_MAX_SEGMENT) segment_length = FUSE_FILTER_MAX_SEGMENT;
+    double size_factor = fmax(1.125, 0.875 + 0.25 * log(1000000.0) / log(size));
+    uint32_t capacity = (uint32_t)round(size * size_factor);
+
+    int64_t segments = ((int64_t)capacity + segment_length - 1) / segment_length;
+    segments -= FUSE_FILTER_ARITY - 1;
+    if (segments < 1) segments = 1;
+
+    ff->segment_length = segment_length;
+    ff->segment_length_mask = segment_length - 1;
+    ff->segment_count = (uint32_t)segments;
+    ff->segment_count_length = ff->segment_count * segment_length;
+    ff->array_length = (ff->segment_count + FUSE_FILTER_ARITY - 1) * segment_length;
+}
+
+static int fuse_filter_compare_hashes(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+uint64_t fuse_filter_hash(const uint8_t *entry, size_t size)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)size * 0xff51afd7ed558ccdULL);
+
+    /* we read 8 bytes at a time little endian so the hash is the same on every platform, it is
+     * stored with the filter */
+    while (size >= 8)
+    {
+        uint64_t w = 0;
+        for (int i = 7; i >= 0; i--) w = (w << 8) | entry[i];
+        h = (h ^ fuse_filter_mix(w)) * 0x94D049BB133111EBULL;
+        h ^= h >> 29;
+        entry += 8;
+        size -= 8;
+    }
+
+    uint64_t w = 0;
+    for (size_t i = size; i > 0; i--) w = (w << 8) | entry[i - 1];
+    h = (h ^ fuse_filter_mix(w ^ size)) * 0x94D049BB133111EBULL;
+
+    return fuse_filter_mix(h);
+}
+
+int fuse_filter_new(fuse_filter_t **ff, uint64_t *hashes, size_t n)
+{
+    /* a key set with duplicates can't be peeled, we drop them */
+    qsort(hashes, n, sizeof(uint64_t), fuse_filter_compare_hashes);
+    size_t unique = 0;
+    for (size_t i = 0; i < n; i++)
+        if (unique == 0 || hashes[unique - 1] != hashes[i]) hashes[unique++] = hashes[i];
+    n = unique;
+
+    *ff = malloc(sizeof(fuse_filter_t));
+    if (*ff == NULL) return -1;
+
+    fuse_filter_t *f = *ff;
+    fuse_filter_size(f, n);
+    uint32_t capacity = f->array_length;
+
+    f->fingerprints = calloc(capacity, sizeof(uint8_t));
+
+    /* per slot the keys over it, counted in the upper 6 bits while the lower 2 hold the xor of
+     * which of a key's 3 slots it is, and the xor of their hashes.  a slot with one key left
+     * tells us both the key and where it sits */
+    uint8_t *counts = calloc(capacity, sizeof(uint8_t));
+    uint64_t *xors = calloc(capacity, sizeof(uint64_t));
+    uint32_t *alone = malloc(capacity * sizeof(uint32_t));
+    uint64_t *stack = malloc((n > 0 ? n : 1) * sizeof(uint64_t));
+    uint8_t *stack_slot = malloc(n > 0 ? n : 1);
+    if (f->fingerprints == NULL || counts == NULL || xors == NULL || alone == NULL ||
+        stack == NULL || stack_slot == NULL)
+    {
+        free(counts);
+        free(xors);
+        free(alone);
+        free(stack);
+        free(stack_slot);
+        fuse_filter_free(f);
+        *ff = NULL;
+        return -1;
+    }
+
+    uint64_t state = 0x726b2b9d438b9d4dULL;
+    size_t peeled = 0;
+    for (int iteration = 0; iteration < FUSE_FILTER_MAX_ITERATIONS; iteration++)
+    {
+        f->seed = fuse_filter_next_seed(&state);
+        memset(counts, 0, capacity);
+        memset(xors, 0, capacity * sizeof(uint64_t));
+
+        bool overflow = false;
+        for (size_t i = 0; i < n; i++)
+        {
+            uint64_t hash = fuse_filter_mix(hashes[i] + f->seed);
+            uint32_t slots[3];
+            fuse_filter_slots(f, hash, slots);
+            for (uint8_t k = 0; k < 3; k++)
+            {
+                counts[slots[k]] += 4;
+                counts[slots[k]] ^= k;
+                xors[slots[k]] ^= hash;
+                if (counts[slots[k]] < 4) overflow = true; /* more than 63 keys on a slot */
+            }
+        }
+        if (overflow) continue;
+
+        /* we peel keys off slots they have to themselves until none are left */
+        uint32_t queued = 0;
+        for (uint32_t i = 0; i < capacity; i++)
+            if ((counts[i] >> 2) == 1) alone[queued++] = i;
+
+        peeled = 0;
+        while (queued > 0)
+        {
+            uint32_t slot = alone[--queued];
+            if ((counts[slot] >> 2) != 1) continue;
+
+            uint64_t hash = xors[slot];
+            uint8_t found = counts[slot] & 3;
+            stack[peeled] = hash;
+            stack_slot[peeled] = found;
+            peeled++;
+
+            uint32_t slots[3];
+            fuse_filter_slots(f, hash, slots);
+            for (uint8_t k = 0; k < 3; k++)
+            {
+                if (k == found) continue;
+                uint32_t other = slots[k];
+                if ((counts[other] >> 2) == 2) alone[queued++] = other;
+                counts[other] -= 4;
+                counts[other] ^= k;
+                xors[other] ^= hash;
+            }
+            counts[slot] = 0;
+            xors[slot] = 0;
+        }
+
+        if (peeled == n) break;
+    }
+
+    free(counts);
+    free(xors);
+    free(alone);
+
+    if (peeled != n)
+    {
+        free(stack);
+        free(stack_slot);
+        fuse_filter_free(f);
+        *ff = NULL;
+        return -1;
+    }
+
+    /* in reverse peel order each key owns the slot it was peeled from, we set it so the 3 slots
+     * xor to the key's fingerprint */
+    for (size_t i = peeled; i > 0; i--)
+    {
+        uint64_t hash = stack[i - 1];
+        uint32_t slots[3];
+        fuse_filter_slots(f, hash, slots);
+        uint8_t found = stack_slot[i - 1];
+        f->fingerprints[slots[found]] = fuse_filter_fingerprint(hash) ^
+                                        f->fingerprints[slots[(found + 1) % 3]] ^
+                                        f->fingerprints[slots[(found + 2) % 3]];
+    }
+
+    free(stack);
+    free(stack_slot);
+    return 0;
+}
+
+int fuse_filter_contains_hash(fuse_filter_t *ff, uint64_t hash)
+{
+    hash = fuse_filter_mix(hash + ff->seed);
+    uint32_t slots[3];
+    fuse_filter_slots(ff, hash, slots);
+    uint8_t f = fuse_filter_fingerprint(hash);
+    f ^= ff->fingerprints[slots[0]] ^ ff->fingerprints[slots[1]] ^ ff->fingerprints[slots[2]];
+    return f == 0;
+}
+
+int fuse_filter_contains(fuse_filter_t *ff, const uint8_t *entry, size_t size)
+{
+    return fuse_filter_contains_hash(ff, fuse_filter_hash(entry, size));
+}
+
+uint8_t *fuse_filter_serialize(fuse_filter_t *ff, size_t *out_size)
+{
+    /* the seed, segment length, segment count and the fingerprints, the rest is derived */
+    *out_size = sizeof(uint64_t) + sizeof(uint32_t) * 2 + ff->array_length;
+    uint8_t *buffer = malloc(*out_size);
+    if (buffer == NULL) return NULL;
+
+    uint8_t *ptr = buffer;
+    memcpy(ptr, &ff->seed, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    memcpy(ptr, &ff->segment_length, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(ptr, &ff->segment_count, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(ptr, ff->fingerprints, ff->array_length);
+
+    return buffer;
+}
+
+fuse_filter_t *fuse_filter_deserialize(const uint8_t *data, size_t size)
+{
+    size_t header = sizeof(uint64_t) + sizeof(uint32_t) * 2;
+    if (data == NULL || size < header) return NULL;
+
+    uint64_t seed;
+    uint32_t segment_length;
+    uint32_t segment_count;
+    memcpy(&seed, data, sizeof(uint64_t));
+    memcpy(&segment_length, data + sizeof(uint64_t), sizeof(uint32_t));
+    memcpy(&segment_count, data + sizeof(uint64_t) + sizeof(uint32_t), sizeof(uint32_t));
+
+    /* the segment length is a power of two and the fingerprints must all be there */
+    if (segment_length == 0 || (segment_length & (segment_length - 1)) != 0 ||
+        segment_length > FUSE_FILTER_MAX_SEGMENT || segment_count == 0)
+        return NULL;
+    uint64_t array_length = ((uint64_t)segment_count + FUSE_FILTER_ARITY - 1) * segment_length;
+    if (array_length > UINT32_MAX || size - header != array_length) return NULL;
+
+    fuse_filter_t *ff = malloc(sizeof(fuse_filter_t));
+    if (ff == NULL) return NULL;
+
+    ff->fingerprints = malloc(array_length);
+    if (ff->fingerprints == NULL)
+    {
+        free(ff);
+        return NULL;
+    }
+    memcpy(ff->fingerprints, data + header, array_length);
+
+    ff->seed = seed;
+    ff->segment_length = segment_length;
+    ff->segment_length_mask = segment_length - 1;
+    ff->segment_count = segment_count;
+    ff->segment_count_length = segment_count * segment_length;
+    ff->array_length = (uint32_t)array_length;
+
+    return ff;
+}
+
+void fuse_filter_free(fuse_filter_t *ff)
+{
+    if (ff == NULL) return;
+    free(ff->fingerprints);
+    free(ff);
+}
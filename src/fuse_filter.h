@@ -0,0 +1,118 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __FUSE_FILTER_H__
+#define __FUSE_FILTER_H__
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tgmath.h>
+
+#define FUSE_FILTER_ARITY          3   /* each key is xor-ed over this many fingerprints */
+#define FUSE_FILTER_MAX_SEGMENT    262144 /* the largest segment length */
+#define FUSE_FILTER_MAX_ITERATIONS 100 /* seeds to try before giving up on a key set */
+
+/**
+ * fuse_filter_t
+ * binary fuse filter struct, a static filter built once from every key it holds
+ * each key maps to 3 slots in neighbouring segments of an array of 8 bit fingerprints and is
+ * present when the xor of the 3 equals its own fingerprint.  it takes about 9 bits per key for a
+ * false positive rate of 1/256 where a bloom filter needs about 12, a lookup is always 3 probes
+ * @param seed the seed the key hashes are mixed with, picked while building
+ * @param segment_length the slots per segment, a power of two
+ * @param segment_length_mask segment_length - 1
+ * @param segment_count the segments a key's first slot can fall in
+ * @param segment_count_length segment_count * segment_length
+ * @param array_length the number of fingerprints
+ * @param fingerprints the fingerprints
+ */
+typedef struct
+{
+    uint64_t seed;
+    uint32_t segment_length;
+    uint32_t segment_length_mask;
+    uint32_t segment_count;
+    uint32_t segment_count_length;
+    uint32_t array_length;
+    uint8_t *fingerprints;
+} fuse_filter_t;
+
+/**
+ * fuse_filter_hash
+ * hashes an entry to the 64 bit hash fuse filters are built from
+ * @param entry the entry to hash
+ * @param size the size of the entry
+ * @return the hash
+ */
+uint64_t fuse_filter_hash(const uint8_t *entry, size_t size);
+
+/**
+ * fuse_filter_new
+ * builds a fuse filter holding a set of keys
+ * @param ff the fuse filter to create
+ * @param hashes the fuse_filter_hash of every key, sorted and deduplicated in place
+ * @param n the number of hashes
+ * @return 0 if successful, -1 if not
+ */
+int fuse_filter_new(fuse_filter_t **ff, uint64_t *hashes, size_t n);
+
+/**
+ * fuse_filter_contains
+ * checks if an entry is in the fuse filter
+ * @param ff the fuse filter to check
+ * @param entry the entry to check
+ * @param size the size of the entry
+ * @return 1 if the entry may be in the fuse filter, 0 if not
+ */
+int fuse_filter_contains(fuse_filter_t *ff, const uint8_t *entry, size_t size);
+
+/**
+ * fuse_filter_contains_hash
+ * checks if the key with a fuse_filter_hash is in the fuse filter
+ * @param ff the fuse filter to check
+ * @param hash the hash of the key
+ * @return 1 if the key may be in the fuse filter, 0 if not
+ */
+int fuse_filter_contains_hash(fuse_filter_t *ff, uint64_t hash);
+
+/**
+ * fuse_filter_serialize
+ * serializes a fuse filter
+ * @param ff the fuse filter to serialize
+ * @param out_size the size of the serialized fuse filter
+ * @return the serialized fuse filter
+ */
+uint8_t *fuse_filter_serialize(fuse_filter_t *ff, size_t *out_size);
+
+/**
+ * fuse_filter_deserialize
+ * deserializes a fuse filter
+ * @param data the serialized fuse filter
+ * @param size the size of the serialized fuse filter
+ * @return the deserialized fuse filter, NULL if the data does not hold one
+ */
+fuse_filter_t *fuse_filter_deserialize(const uint8_t *data, size_t size);
+
+/**
+ * fuse_filter_free
+ * frees a fuse filter
+ * @param ff the fuse filter to free
+ */
+void fuse_filter_free(fuse_filter_t *ff);
+
+#endif /* __FUSE_FILTER_H__ */
@@ -90,9 +90,19 @@ int hash_table_put(hash_table_t **ht, const uint8_t *key, size_t key_size, const
     bucket->value_size = value_size;
     bucket->ttl = ttl;
 
+    /* we probe linearly for the key or an empty bucket so colliding keys don't overwrite
+     * each other, the load factor keeps an empty bucket available */
+    while ((*ht)->buckets[index] != NULL &&
+           ((*ht)->buckets[index]->key_size != key_size ||
+            memcmp((*ht)->buckets[index]->key, key, key_size) != 0))
+    {
+        index = (index + 1) % (*ht)->bucket_count;
+    }
+
     /* we free the old bucket if it exists */
     if ((*ht)->buckets[index] != NULL)
     {
+        (*ht)->total_size -= (*ht)->buckets[index]->key_size + (*ht)->buckets[index]->value_size;
         free((*ht)->buckets[index]->key);
         free((*ht)->buckets[index]->value);
         free((*ht)->buckets[index]);
@@ -175,8 +185,17 @@ int hash_table_get(hash_table_t *ht, const uint8_t *key, size_t key_size, uint8_
                    size_t *value_size)
 {
     size_t index = bloom_filter_hash(key, key_size, 0) % ht->bucket_count;
+
+    /* we probe linearly until we find the key or reach an empty bucket */
     hash_table_bucket_t *bucket = ht->buckets[index];
-    if (bucket == NULL || bucket->key_size != key_size || memcmp(bucket->key, key, key_size) != 0)
+    while (bucket != NULL &&
+           (bucket->key_size != key_size || memcmp(bucket->key, key, key_size) != 0))
+    {
+        index = (index + 1) % ht->bucket_count;
+        bucket = ht->buckets[index];
+    }
+
+    if (bucket == NULL)
     {
         return -1; /* key not found */
     }
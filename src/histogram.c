@@ -0,0 +1,145 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "histogram.h"
+
+/*
+ * histogram_bucket
+ * gets the bucket of a value
+ * @param value the value
+ * @return the bucket
+ */
+static int histogram_bucket(uint64_t value)
+{
+    if (value < (1ULL << HISTOGRAM_SUB_BITS)) return (int)value;
+
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - HISTOGRAM_SUB_BITS;
+    int sub = (int)((value >> shift) & ((1ULL << HISTOGRAM_SUB_BITS) - 1));
+    return ((shift + 1) << HISTOGRAM_SUB_BITS) + sub;
+}
+
+/*
+ * histogram_bucket_limit
+ * gets the largest value that lands in a bucket
+ * @param bucket the bucket
+ * @return the largest value
+ */
+static uint64_t histogram_bucket_limit(int bucket)
+{
+    if (bucket < (1 << HISTOGRAM_SUB_BITS)) return (uint64_t)bucket;
+
+    int shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+    uint64_t sub = (uint64_t)(bucket & ((1 << HISTOGRAM_SUB_BITS) - 1));
+    uint64_t lower = ((1ULL << HISTOGRAM_SUB_BITS) + sub) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+void histogram_init(histogram_t *h)
+{
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) atomic_init(&h->counts[i], 0);
+    atomic_init(&h->count, 0);
+    atomic_init(&h->sum, 0);
+    atomic_init(&h->min, UINT64_MAX);
+    atomic_init(&h->max, 0);
+}
+
+void histogram_record(histogram_t *h, uint64_t value)
+{
+    (void)atomic_fetch_add_explicit(&h->counts[histogram_bucket(value)], 1,
+                                    memory_order_relaxed);
+    (void)atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+    (void)atomic_fetch_add_explicit(&h->sum, value, memory_order_relaxed);
+
+    /* the extremes rarely change so we only try to swap them in when they do */
+    uint64_t min = atomic_load_explicit(&h->min, memory_order_relaxed);
+    while (value < min && !atomic_compare_exchange_weak_explicit(
+                              &h->min, &min, value, memory_order_relaxed, memory_order_relaxed))
+        ;
+
+    uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (value > max && !atomic_compare_exchange_weak_explicit(
+                              &h->max, &max, value, memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+void histogram_merge(histogram_t *dst, const histogram_t *src)
+{
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        uint64_t n = atomic_load_explicit(&src->counts[i], memory_order_relaxed);
+        if (n > 0) (void)atomic_fetch_add_explicit(&dst->counts[i], n, memory_order_relaxed);
+    }
+
+    (void)atomic_fetch_add_explicit(
+        &dst->count, atomic_load_explicit(&src->count, memory_order_relaxed), memory_order_relaxed);
+    (void)atomic_fetch_add_explicit(
+        &dst->sum, atomic_load_explicit(&src->sum, memory_order_relaxed), memory_order_relaxed);
+
+    uint64_t min = atomic_load_explicit(&src->min, memory_order_relaxed);
+    if (min < atomic_load_explicit(&dst->min, memory_order_relaxed))
+        atomic_store_explicit(&dst->min, min, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&src->max, memory_order_relaxed);
+    if (max > atomic_load_explicit(&dst->max, memory_order_relaxed))
+        atomic_store_explicit(&dst->max, max, memory_order_relaxed);
+}
+
+uint64_t histogram_percentile(const histogram_t *h, double percentile)
+{
+    /* we total the buckets rather than trust count, recorders may be between the two adds */
+    uint64_t total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+        total += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+    if (total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total);
+    if (rank == 0) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+        if (seen < rank) continue;
+
+        /* the bucket bound can overshoot the largest value recorded */
+        uint64_t limit = histogram_bucket_limit(i);
+        uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+        return limit < max ? limit : max;
+    }
+
+    return atomic_load_explicit(&h->max, memory_order_relaxed);
+}
+
+void histogram_summarize(const histogram_t *h, histogram_summary_t *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+
+    summary->count = atomic_load_explicit(&h->count, memory_order_relaxed);
+    if (summary->count == 0) return;
+
+    summary->sum = atomic_load_explicit(&h->sum, memory_order_relaxed);
+    summary->min = atomic_load_explicit(&h->min, memory_order_relaxed);
+    summary->max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    summary->avg = summary->sum / summary->count;
+    summary->p50 = histogram_percentile(h, 50.0);
+    summary->p95 = histogram_percentile(h, 95.0);
+    summary->p99 = histogram_percentile(h, 99.0);
+    summary->p999 = histogram_percentile(h, 99.9);
+}
@@ -0,0 +1,116 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HISTOGRAM_SUB_BITS 4 /* each power of two is split into 1 << this buckets */
+#define HISTOGRAM_BUCKETS  (64 << HISTOGRAM_SUB_BITS)
+
+/**
+ * histogram_t
+ * log-linear histogram struct, in the style of HDR histograms
+ * values below 16 have a bucket each and every power of two above is split into 16 buckets so a
+ * percentile is within about 6% of the value it stands for.  recording is lock free so many
+ * threads can record into the same histogram
+ * @param counts the count per bucket
+ * @param count the number of recorded values
+ * @param sum the sum of the recorded values
+ * @param min the smallest recorded value, UINT64_MAX while empty
+ * @param max the largest recorded value
+ */
+typedef struct
+{
+    _Atomic uint64_t counts[HISTOGRAM_BUCKETS];
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t min;
+    _Atomic uint64_t max;
+} histogram_t;
+
+/**
+ * histogram_summary_t
+ * the summary of a histogram
+ * @param count the number of recorded values
+ * @param sum the sum of the recorded values
+ * @param min the smallest recorded value, 0 if there are none
+ * @param max the largest recorded value
+ * @param avg the average of the recorded values
+ * @param p50 the median
+ * @param p95 the 95th percentile
+ * @param p99 the 99th percentile
+ * @param p999 the 99.9th percentile
+ */
+typedef struct
+{
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t avg;
+    uint64_t p50;
+    uint64_t p95;
+    uint64_t p99;
+    uint64_t p999;
+} histogram_summary_t;
+
+/**
+ * histogram_init
+ * initializes a histogram to empty
+ * @param h the histogram
+ */
+void histogram_init(histogram_t *h);
+
+/**
+ * histogram_record
+ * records a value
+ * @param h the histogram
+ * @param value the value to record
+ */
+void histogram_record(histogram_t *h, uint64_t value);
+
+/**
+ * histogram_merge
+ * adds the values recorded in a histogram to another
+ * @param dst the histogram to add to
+ * @param src the histogram to add
+ */
+void histogram_merge(histogram_t *dst, const histogram_t *src);
+
+/**
+ * histogram_percentile
+ * gets the value below which a percentage of the recorded values fall
+ * @param h the histogram
+ * @param percentile the percentage, 0 to 100
+ * @return the upper bound of the bucket holding the percentile, 0 if the histogram is empty
+ */
+uint64_t histogram_percentile(const histogram_t *h, double percentile);
+
+/**
+ * histogram_summarize
+ * summarizes a histogram
+ * @param h the histogram
+ * @param summary the summary
+ */
+void histogram_summarize(const histogram_t *h, histogram_summary_t *summary);
+
+#endif /* __HISTOGRAM_H__ */
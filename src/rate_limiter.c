@@ -0,0 +1,194 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "rate_limiter.h"
+
+/*
+ * rate_limiter_now
+ * gets the monotonic time in nanoseconds
+ * @return the time
+ */
+static uint64_t rate_limiter_now(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * rate_limiter_refill
+ * adds the tokens earned since the last refill, the lock must be held
+ * @param rl the rate limiter
+ * @param bytes_per_sec the current budget
+ */
+static void rate_limiter_refill(rate_limiter_t *rl, int64_t bytes_per_sec)
+{
+    uint64_t now = rate_limiter_now();
+    int64_t earned = (int64_t)((double)(now - rl->last_refill) * (double)bytes_per_sec / 1e9);
+
+    /* we keep the clock where it was until a whole token is earned so low budgets still refill */
+    if (earned < 1) return;
+    rl->last_refill = now;
+
+    /* we cap the bucket at a refill period's worth so an idle limiter can't build a burst */
+    int64_t burst = bytes_per_sec / (1000000 / RATE_LIMITER_REFILL_PERIOD_US);
+    if (burst < 1) burst = 1;
+
+    rl->available += earned;
+    if (rl->available > burst) rl->available = burst;
+}
+
+int rate_limiter_new(rate_limiter_t **rl, int64_t bytes_per_sec)
+{
+    *rl = malloc(sizeof(rate_limiter_t));
+    if (*rl == NULL) return -1;
+
+    atomic_init(&(*rl)->bytes_per_sec, bytes_per_sec);
+    (*rl)->available = 0;
+    (*rl)->last_refill = rate_limiter_now();
+    (*rl)->high_waiting = 0;
+
+    for (int i = 0; i < 2; i++)
+    {
+        atomic_init(&(*rl)->total_bytes[i], 0);
+        atomic_init(&(*rl)->total_wait_us[i], 0);
+    }
+
+    if (pthread_mutex_init(&(*rl)->lock, NULL) != 0)
+    {
+        free(*rl);
+        return -1;
+    }
+
+    if (pthread_cond_init(&(*rl)->cond, NULL) != 0)
+    {
+        (void)pthread_mutex_destroy(&(*rl)->lock);
+        free(*rl);
+        return -1;
+    }
+
+    return 0;
+}
+
+void rate_limiter_request(rate_limiter_t *rl, size_t bytes, rate_limiter_priority_t priority)
+{
+    if (rl == NULL) return;
+
+    (void)atomic_fetch_add(&rl->total_bytes[priority], bytes);
+
+    /* an unlimited limiter admits everything without locking */
+    if (atomic_load(&rl->bytes_per_sec) <= 0) return;
+
+    uint64_t start = rate_limiter_now();
+
+    (void)pthread_mutex_lock(&rl->lock);
+
+    if (priority == RATE_LIMITER_PRIORITY_HIGH) rl->high_waiting++;
+
+    while (true)
+    {
+        int64_t bytes_per_sec = atomic_load(&rl->bytes_per_sec);
+        if (bytes_per_sec <= 0) break; /* the limit was lifted while we waited */
+
+        rate_limiter_refill(rl, bytes_per_sec);
+
+        /* low priority requests let high priority ones go first */
+        bool yield = priority == RATE_LIMITER_PRIORITY_LOW && rl->high_waiting > 0;
+        if (!yield && rl->available > 0)
+        {
+            rl->available -= (int64_t)bytes;
+            break;
+        }
+
+        /* we sleep until the debt is paid off, at most a refill period so we notice changes */
+        uint64_t wait_ns = (uint64_t)RATE_LIMITER_REFILL_PERIOD_US * 1000;
+        if (!yield)
+        {
+            uint64_t debt_ns =
+                (uint64_t)((double)(1 - rl->available) * 1e9 / (double)bytes_per_sec);
+            if (debt_ns < wait_ns) wait_ns = debt_ns;
+        }
+
+        struct timespec deadline;
+        (void)clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t)(wait_ns / 1000000000ULL);
+        deadline.tv_nsec += (long)(wait_ns % 1000000000ULL);
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        (void)pthread_cond_timedwait(&rl->cond, &rl->lock, &deadline);
+    }
+
+    if (priority == RATE_LIMITER_PRIORITY_HIGH)
+    {
+        rl->high_waiting--;
+
+        /* low priority requests may be yielding to us */
+        if (rl->high_waiting == 0) (void)pthread_cond_broadcast(&rl->cond);
+    }
+
+    (void)pthread_mutex_unlock(&rl->lock);
+
+    (void)atomic_fetch_add(&rl->total_wait_us[priority], (rate_limiter_now() - start) / 1000);
+}
+
+void rate_limiter_charge(rate_limiter_t *rl, size_t bytes, rate_limiter_priority_t priority)
+{
+    if (rl == NULL) return;
+
+    (void)atomic_fetch_add(&rl->total_bytes[priority], bytes);
+
+    int64_t bytes_per_sec = atomic_load(&rl->bytes_per_sec);
+    if (bytes_per_sec <= 0) return;
+
+    (void)pthread_mutex_lock(&rl->lock);
+
+    /* we refill first so the tokens earned before the charge aren't lost */
+    rate_limiter_refill(rl, bytes_per_sec);
+    rl->available -= (int64_t)bytes;
+
+    (void)pthread_mutex_unlock(&rl->lock);
+}
+
+void rate_limiter_set_bytes_per_sec(rate_limiter_t *rl, int64_t bytes_per_sec)
+{
+    if (rl == NULL) return;
+
+    (void)pthread_mutex_lock(&rl->lock);
+
+    atomic_store(&rl->bytes_per_sec, bytes_per_sec);
+
+    /* we start the new budget from an empty bucket */
+    rl->available = 0;
+    rl->last_refill = rate_limiter_now();
+
+    (void)pthread_cond_broadcast(&rl->cond);
+    (void)pthread_mutex_unlock(&rl->lock);
+}
+
+void rate_limiter_free(rate_limiter_t *rl)
+{
+    if (rl == NULL) return;
+
+    (void)pthread_cond_destroy(&rl->cond);
+    (void)pthread_mutex_destroy(&rl->lock);
+    free(rl);
+}
@@ -0,0 +1,110 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __RATE_LIMITER_H__
+#define __RATE_LIMITER_H__
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define RATE_LIMITER_REFILL_PERIOD_US 100000 /* bounds the burst of a limiter */
+
+/**
+ * rate_limiter_priority_t
+ * priority of a rate limiter request, low priority requests wait while high priority ones do
+ */
+typedef enum
+{
+    RATE_LIMITER_PRIORITY_LOW,
+    RATE_LIMITER_PRIORITY_HIGH,
+} rate_limiter_priority_t;
+
+/**
+ * rate_limiter_t
+ * token bucket rate limiter struct
+ * tokens are bytes, they refill continuously at bytes_per_sec up to a refill period's worth.  a
+ * request is admitted as soon as there are tokens and takes all it asked for, the bucket can go
+ * into debt which later requests wait out, so large requests don't starve
+ * @param bytes_per_sec the budget in bytes per second, 0 or less means unlimited
+ * @param available the tokens in the bucket, negative while in debt
+ * @param last_refill the time of the last refill in nanoseconds
+ * @param high_waiting the number of waiting high priority requests
+ * @param lock the lock for the bucket
+ * @param cond signalled when a request is admitted or the budget changes
+ * @param total_bytes the bytes admitted per priority
+ * @param total_wait_us the time spent waiting per priority in microseconds
+ */
+typedef struct
+{
+    _Atomic int64_t bytes_per_sec;
+    int64_t available;
+    uint64_t last_refill;
+    int high_waiting;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    _Atomic uint64_t total_bytes[2];
+    _Atomic uint64_t total_wait_us[2];
+} rate_limiter_t;
+
+/**
+ * rate_limiter_new
+ * creates a new rate limiter
+ * @param rl the rate limiter to create
+ * @param bytes_per_sec the budget in bytes per second, 0 or less for unlimited
+ * @return 0 if successful, -1 if not
+ */
+int rate_limiter_new(rate_limiter_t **rl, int64_t bytes_per_sec);
+
+/**
+ * rate_limiter_request
+ * waits until bytes may be written under the budget
+ * @param rl the rate limiter
+ * @param bytes the amount of bytes to write
+ * @param priority the priority of the request
+ */
+void rate_limiter_request(rate_limiter_t *rl, size_t bytes, rate_limiter_priority_t priority);
+
+/**
+ * rate_limiter_charge
+ * takes bytes from the budget without waiting, for writers that must not block.  the bucket goes
+ * into debt which the requests after it wait out
+ * @param rl the rate limiter
+ * @param bytes the amount of bytes written
+ * @param priority the priority the bytes are counted under
+ */
+void rate_limiter_charge(rate_limiter_t *rl, size_t bytes, rate_limiter_priority_t priority);
+
+/**
+ * rate_limiter_set_bytes_per_sec
+ * changes the budget of a rate limiter, waiting requests see the new budget right away
+ * @param rl the rate limiter
+ * @param bytes_per_sec the budget in bytes per second, 0 or less for unlimited
+ */
+void rate_limiter_set_bytes_per_sec(rate_limiter_t *rl, int64_t bytes_per_sec);
+
+/**
+ * rate_limiter_free
+ * frees a rate limiter
+ * @param rl the rate limiter to free
+ */
+void rate_limiter_free(rate_limiter_t *rl);
+
+#endif /* __RATE_LIMITER_H__ */
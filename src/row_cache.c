@@ -0,0 +1,349 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "row_cache.h"
+
+/* we hash the key seeded with the owner so the rows of column families spread apart */
+static unsigned int row_cache_hash(uint64_t owner, const uint8_t *key, size_t key_size)
+{
+    return bloom_filter_hash(key, key_size, (int)owner);
+}
+
+static row_cache_shard_t *row_cache_shard(row_cache_t *cache, unsigned int hash)
+{
+    return &cache->shards[hash % ROW_CACHE_SHARDS];
+}
+
+/* we use the bits of the hash the shard did not use to pick the bucket */
+static size_t row_cache_bucket(row_cache_shard_t *shard, unsigned int hash)
+{
+    return (hash / ROW_CACHE_SHARDS) & (shard->num_buckets - 1);
+}
+
+static row_cache_entry_t *row_cache_find(row_cache_shard_t *shard, unsigned int hash,
+                                         uint64_t owner, const uint8_t *key, size_t key_size)
+{
+    row_cache_entry_t *entry = shard->buckets[row_cache_bucket(shard, hash)];
+    while (entry != NULL)
+    {
+        if (entry->hash == hash && entry->owner == owner && entry->key_size == key_size &&
+            memcmp(entry->key, key, key_size) == 0)
+            return entry;
+        entry = entry->next;
+    }
+
+    return NULL;
+}
+
+static void row_cache_lru_unlink(row_cache_shard_t *shard, row_cache_entry_t *entry)
+{
+    if (entry->prev_lru != NULL)
+        entry->prev_lru->next_lru = entry->next_lru;
+    else
+        shard->head = entry->next_lru;
+
+    if (entry->next_lru != NULL)
+        entry->next_lru->prev_lru = entry->prev_lru;
+    else
+        shard->tail = entry->prev_lru;
+
+    entry->prev_lru = NULL;
+    entry->next_lru = NULL;
+}
+
+static void row_cache_lru_push(row_cache_shard_t *shard, row_cache_entry_t *entry)
+{
+    entry->prev_lru = NULL;
+    entry->next_lru = shard->head;
+    if (shard->head != NULL)
+        shard->head->prev_lru = entry;
+    else
+        shard->tail = entry;
+    shard->head = entry;
+}
+
+/* we unlink an entry from its bucket and the lru list and free it */
+static void row_cache_remove(row_cache_shard_t *shard, row_cache_entry_t *entry)
+{
+    row_cache_entry_t **link = &shard->buckets[row_cache_bucket(shard, entry->hash)];
+    while (*link != entry) link = &(*link)->next;
+    *link = entry->next;
+
+    row_cache_lru_unlink(shard, entry);
+
+    shard->count--;
+    shard->bytes -= entry->charge;
+
+    free(entry->key);
+    free(entry->value);
+    free(entry);
+}
+
+/* we double the buckets of a shard, on failure the shard keeps its longer chains */
+static void row_cache_grow(row_cache_shard_t *shard)
+{
+    size_t num_buckets = shard->num_buckets * 2;
+    row_cache_entry_t **buckets = calloc(num_buckets, sizeof(row_cache_entry_t *));
+    if (buckets == NULL) return;
+
+    for (size_t i = 0; i < shard->num_buckets; i++)
+    {
+        row_cache_entry_t *entry = shard->buckets[i];
+        while (entry != NULL)
+        {
+            row_cache_entry_t *next = entry->next;
+            size_t bucket = (entry->hash / ROW_CACHE_SHARDS) & (num_buckets - 1);
+            entry->next = buckets[bucket];
+            buckets[bucket] = entry;
+            entry = next;
+        }
+    }
+
+    free(shard->buckets);
+    shard->buckets = buckets;
+    shard->num_buckets = num_buckets;
+}
+
+int row_cache_new(row_cache_t **cache, size_t capacity)
+{
+    *cache = malloc(sizeof(row_cache_t));
+    if (*cache == NULL) return -1;
+
+    (*cache)->capacity = capacity;
+    atomic_init(&(*cache)->hits, 0);
+    atomic_init(&(*cache)->misses, 0);
+    atomic_init(&(*cache)->evictions, 0);
+
+    for (int i = 0; i < ROW_CACHE_SHARDS; i++)
+    {
+        row_cache_shard_t *shard = &(*cache)->shards[i];
+
+        shard->buckets = calloc(ROW_CACHE_INITIAL_BUCKETS, sizeof(row_cache_entry_t *));
+        if (shard->buckets == NULL)
+        {
+            for (int j = 0; j < i; j++)
+            {
+                (void)pthread_mutex_destroy(&(*cache)->shards[j].lock);
+                free((*cache)->shards[j].buckets);
+            }
+            free(*cache);
+            *cache = NULL;
+            return -1;
+        }
+
+        (void)pthread_mutex_init(&shard->lock, NULL);
+        shard->num_buckets = ROW_CACHE_INITIAL_BUCKETS;
+        shard->count = 0;
+        shard->bytes = 0;
+        /* every shard gets an even share of the capacity */
+        shard->capacity = capacity / ROW_CACHE_SHARDS;
+        shard->invalidations = 0;
+        shard->head = NULL;
+        shard->tail = NULL;
+    }
+
+    return 0;
+}
+
+int row_cache_get(row_cache_t *cache, uint64_t owner, const uint8_t *key, size_t key_size,
+                  uint8_t **value, size_t *value_size, uint64_t *version)
+{
+    unsigned int hash = row_cache_hash(owner, key, key_size);
+    row_cache_shard_t *shard = row_cache_shard(cache, hash);
+
+    (void)pthread_mutex_lock(&shard->lock);
+
+    row_cache_entry_t *entry = row_cache_find(shard, hash, owner, key, key_size);
+    if (entry != NULL && entry->ttl != -1 && entry->ttl < time(NULL))
+    {
+        /* the row expired, we drop it so the caller reads the key again */
+        row_cache_remove(shard, entry);
+        entry = NULL;
+    }
+
+    if (entry == NULL)
+    {
+        *version = shard->invalidations;
+        (void)pthread_mutex_unlock(&shard->lock);
+        atomic_fetch_add(&cache->misses, 1);
+        return -1;
+    }
+
+    *value = malloc(entry->value_size);
+    if (*value == NULL)
+    {
+        *version = shard->invalidations;
+        (void)pthread_mutex_unlock(&shard->lock);
+        return -1;
+    }
+    memcpy(*value, entry->value, entry->value_size);
+    *value_size = entry->value_size;
+
+    /* the row is now the most recently used */
+    row_cache_lru_unlink(shard, entry);
+    row_cache_lru_push(shard, entry);
+
+    (void)pthread_mutex_unlock(&shard->lock);
+    atomic_fetch_add(&cache->hits, 1);
+    return 0;
+}
+
+int row_cache_put(row_cache_t *cache, uint64_t owner, const uint8_t *key, size_t key_size,
+                  const uint8_t *value, size_t value_size, int64_t ttl, uint64_t version)
+{
+    unsigned int hash = row_cache_hash(owner, key, key_size);
+    row_cache_shard_t *shard = row_cache_shard(cache, hash);
+    size_t charge = sizeof(row_cache_entry_t) + key_size + value_size;
+
+    /* a row bigger than the shard would only evict everything else */
+    if (charge > shard->capacity) return -1;
+
+    row_cache_entry_t *entry = malloc(sizeof(row_cache_entry_t));
+    if (entry == NULL) return -1;
+
+    entry->key = malloc(key_size);
+    entry->value = malloc(value_size > 0 ? value_size : 1);
+    if (entry->key == NULL || entry->value == NULL)
+    {
+        free(entry->key);
+        free(entry->value);
+        free(entry);
+        return -1;
+    }
+
+    memcpy(entry->key, key, key_size);
+    memcpy(entry->value, value, value_size);
+    entry->owner = owner;
+    entry->key_size = key_size;
+    entry->value_size = value_size;
+    entry->ttl = ttl;
+    entry->hash = hash;
+    entry->charge = charge;
+    entry->prev_lru = NULL;
+    entry->next_lru = NULL;
+
+    (void)pthread_mutex_lock(&shard->lock);
+
+    /* a write invalidated a key of the shard since the miss, the row we read may be stale.  we
+     * can't tell which key it was so we skip the insert, the next miss will try again */
+    if (shard->invalidations != version)
+    {
+        (void)pthread_mutex_unlock(&shard->lock);
+        free(entry->key);
+        free(entry->value);
+        free(entry);
+        return -1;
+    }
+
+    row_cache_entry_t *existing = row_cache_find(shard, hash, owner, key, key_size);
+    if (existing != NULL) row_cache_remove(shard, existing);
+
+    while (shard->bytes + charge > shard->capacity && shard->tail != NULL)
+    {
+        row_cache_remove(shard, shard->tail);
+        atomic_fetch_add(&cache->evictions, 1);
+    }
+
+    if (shard->count >= shard->num_buckets) row_cache_grow(shard);
+
+    size_t bucket = row_cache_bucket(shard, hash);
+    entry->next = shard->buckets[bucket];
+    shard->buckets[bucket] = entry;
+    row_cache_lru_push(shard, entry);
+
+    shard->count++;
+    shard->bytes += charge;
+
+    (void)pthread_mutex_unlock(&shard->lock);
+    return 0;
+}
+
+void row_cache_invalidate(row_cache_t *cache, uint64_t owner, const uint8_t *key,
+                          size_t key_size)
+{
+    unsigned int hash = row_cache_hash(owner, key, key_size);
+    row_cache_shard_t *shard = row_cache_shard(cache, hash);
+
+    (void)pthread_mutex_lock(&shard->lock);
+
+    row_cache_entry_t *entry = row_cache_find(shard, hash, owner, key, key_size);
+    if (entry != NULL) row_cache_remove(shard, entry);
+
+    /* we bump the invalidations even without a row, a reader may be about to insert one */
+    shard->invalidations++;
+
+    (void)pthread_mutex_unlock(&shard->lock);
+}
+
+void row_cache_invalidate_owner(row_cache_t *cache, uint64_t owner)
+{
+    for (int i = 0; i < ROW_CACHE_SHARDS; i++)
+    {
+        row_cache_shard_t *shard = &cache->shards[i];
+
+        (void)pthread_mutex_lock(&shard->lock);
+
+        row_cache_entry_t *entry = shard->head;
+        while (entry != NULL)
+        {
+            row_cache_entry_t *next = entry->next_lru;
+            if (entry->owner == owner) row_cache_remove(shard, entry);
+            entry = next;
+        }
+        shard->invalidations++;
+
+        (void)pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+size_t row_cache_size(row_cache_t *cache)
+{
+    size_t size = 0;
+    for (int i = 0; i < ROW_CACHE_SHARDS; i++)
+    {
+        row_cache_shard_t *shard = &cache->shards[i];
+        (void)pthread_mutex_lock(&shard->lock);
+        size += shard->bytes;
+        (void)pthread_mutex_unlock(&shard->lock);
+    }
+
+    return size;
+}
+
+void row_cache_free(row_cache_t *cache)
+{
+    if (cache == NULL) return;
+
+    for (int i = 0; i < ROW_CACHE_SHARDS; i++)
+    {
+        row_cache_shard_t *shard = &cache->shards[i];
+        row_cache_entry_t *entry = shard->head;
+        while (entry != NULL)
+        {
+            row_cache_entry_t *next = entry->next_lru;
+            free(entry->key);
+            free(entry->value);
+            free(entry);
+            entry = next;
+        }
+        free(shard->buckets);
+        (void)pthread_mutex_destroy(&shard->lock);
+    }
+
+    free(cache);
+}
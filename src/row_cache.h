@@ -0,0 +1,184 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __ROW_CACHE_H__
+#define __ROW_CACHE_H__
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bloom_filter.h" /* for bloom_filter_hash */
+
+#define ROW_CACHE_SHARDS          16 /* independently locked parts of a row cache */
+#define ROW_CACHE_INITIAL_BUCKETS 64 /* hash buckets of a shard before it grows */
+
+/**
+ * row_cache_entry_t
+ * a cached row, on the hash chain of its bucket and the lru list of its shard
+ * @param owner the id of what the row belongs to, a column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl when the row expires, -1 for never
+ * @param hash the hash of the owner and the key
+ * @param charge the memory the entry holds in bytes
+ * @param next the next entry in the bucket
+ * @param prev_lru the entry used more recently
+ * @param next_lru the entry used less recently
+ */
+typedef struct row_cache_entry_t
+{
+    uint64_t owner;
+    uint8_t *key;
+    size_t key_size;
+    uint8_t *value;
+    size_t value_size;
+    int64_t ttl;
+    unsigned int hash;
+    size_t charge;
+    struct row_cache_entry_t *next;
+    struct row_cache_entry_t *prev_lru;
+    struct row_cache_entry_t *next_lru;
+} row_cache_entry_t;
+
+/**
+ * row_cache_shard_t
+ * a part of a row cache with its own lock, lru list and share of the capacity
+ * @param lock the lock for the shard
+ * @param buckets the hash buckets
+ * @param num_buckets the number of buckets, a power of two
+ * @param count the number of entries
+ * @param bytes the memory the entries hold in bytes
+ * @param capacity the most memory the entries may hold in bytes
+ * @param invalidations the invalidations of the shard, a miss remembers it so a row read before
+ * an invalidation is not inserted after it
+ * @param head the most recently used entry
+ * @param tail the least recently used entry, evicted first
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    row_cache_entry_t **buckets;
+    size_t num_buckets;
+    size_t count;
+    size_t bytes;
+    size_t capacity;
+    uint64_t invalidations;
+    row_cache_entry_t *head;
+    row_cache_entry_t *tail;
+} row_cache_shard_t;
+
+/**
+ * row_cache_t
+ * a cache of rows keyed by their owner and key, sized by bytes and evicting the least recently
+ * used rows first
+ * @param shards the shards, a row lives in the shard its hash picks
+ * @param capacity the most memory the rows may hold in bytes
+ * @param hits the lookups that found their row
+ * @param misses the lookups that didn't
+ * @param evictions the rows evicted to make room
+ */
+typedef struct
+{
+    row_cache_shard_t shards[ROW_CACHE_SHARDS];
+    size_t capacity;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t misses;
+    _Atomic uint64_t evictions;
+} row_cache_t;
+
+/**
+ * row_cache_new
+ * creates a new row cache
+ * @param cache the row cache to create
+ * @param capacity the most memory the rows may hold in bytes
+ * @return 0 if successful, -1 if not
+ */
+int row_cache_new(row_cache_t **cache, size_t capacity);
+
+/**
+ * row_cache_get
+ * looks up a row, an expired row is removed instead of returned
+ * @param cache the row cache
+ * @param owner the owner of the row
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the copy of the value, freed by the caller
+ * @param value_size the size of the value
+ * @param version set on a miss, pass it to row_cache_put with the row read in its place
+ * @return 0 if the row was found, -1 if not
+ */
+int row_cache_get(row_cache_t *cache, uint64_t owner, const uint8_t *key, size_t key_size,
+                  uint8_t **value, size_t *value_size, uint64_t *version);
+
+/**
+ * row_cache_put
+ * caches a row read after a miss, unless its key was invalidated since the miss
+ * @param cache the row cache
+ * @param owner the owner of the row
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl when the row expires, -1 for never
+ * @param version the version row_cache_get set on the miss
+ * @return 0 if the row was cached, -1 if not
+ */
+int row_cache_put(row_cache_t *cache, uint64_t owner, const uint8_t *key, size_t key_size,
+                  const uint8_t *value, size_t value_size, int64_t ttl, uint64_t version);
+
+/**
+ * row_cache_invalidate
+ * removes the row of a key, call it after the key is written
+ * @param cache the row cache
+ * @param owner the owner of the row
+ * @param key the key
+ * @param key_size the size of the key
+ */
+void row_cache_invalidate(row_cache_t *cache, uint64_t owner, const uint8_t *key,
+                          size_t key_size);
+
+/**
+ * row_cache_invalidate_owner
+ * removes every row of an owner
+ * @param cache the row cache
+ * @param owner the owner
+ */
+void row_cache_invalidate_owner(row_cache_t *cache, uint64_t owner);
+
+/**
+ * row_cache_size
+ * gets the memory the rows hold
+ * @param cache the row cache
+ * @return the memory in bytes
+ */
+size_t row_cache_size(row_cache_t *cache);
+
+/**
+ * row_cache_free
+ * frees a row cache and its rows
+ * @param cache the row cache to free
+ */
+void row_cache_free(row_cache_t *cache);
+
+#endif /* __ROW_CACHE_H__ */
@@ -0,0 +1,211 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "thread_pool.h"
+
+/*
+ * thread_pool_worker
+ * runs queued jobs, highest priority first, until the pool stops and the queue is empty
+ * @param arg the pool
+ * @return NULL
+ */
+static void *thread_pool_worker(void *arg)
+{
+    thread_pool_t *pool = arg;
+
+    (void)pthread_mutex_lock(&pool->lock);
+
+    while (true)
+    {
+        while (pool->queued == 0 && !pool->stop)
+            (void)pthread_cond_wait(&pool->not_empty, &pool->lock);
+
+        if (pool->queued == 0) break; /* stopped and nothing left to run */
+
+        thread_pool_job_t *job = NULL;
+        for (int p = 0; p < THREAD_POOL_PRIORITIES; p++)
+        {
+            if (pool->head[p] == NULL) continue;
+
+            job = pool->head[p];
+            pool->head[p] = job->next;
+            if (pool->head[p] == NULL) pool->tail[p] = NULL;
+            break;
+        }
+
+        pool->queued--;
+        pool->running++;
+
+        (void)pthread_mutex_unlock(&pool->lock);
+
+        job->fn(job->arg);
+        free(job);
+        (void)atomic_fetch_add(&pool->completed, 1);
+
+        (void)pthread_mutex_lock(&pool->lock);
+
+        pool->running--;
+        if (pool->queued == 0 && pool->running == 0) (void)pthread_cond_broadcast(&pool->idle);
+    }
+
+    (void)pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/*
+ * thread_pool_stop
+ * stops the pool threads once the queue is empty and joins them
+ * @param pool the pool
+ * @param num_threads the number of started threads
+ */
+static void thread_pool_stop(thread_pool_t *pool, int num_threads)
+{
+    (void)pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    (void)pthread_cond_broadcast(&pool->not_empty);
+    (void)pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < num_threads; i++) (void)pthread_join(pool->threads[i], NULL);
+}
+
+int thread_pool_new(thread_pool_t **pool, int num_threads)
+{
+    if (num_threads < 1 || num_threads > THREAD_POOL_MAX_THREADS) return -1;
+
+    *pool = malloc(sizeof(thread_pool_t));
+    if (*pool == NULL) return -1;
+
+    (*pool)->threads = malloc(sizeof(pthread_t) * (size_t)num_threads);
+    if ((*pool)->threads == NULL)
+    {
+        free(*pool);
+        return -1;
+    }
+
+    (*pool)->num_threads = num_threads;
+    for (int p = 0; p < THREAD_POOL_PRIORITIES; p++)
+    {
+        (*pool)->head[p] = NULL;
+        (*pool)->tail[p] = NULL;
+    }
+    (*pool)->queued = 0;
+    (*pool)->running = 0;
+    (*pool)->stop = false;
+    atomic_init(&(*pool)->completed, 0);
+
+    if (pthread_mutex_init(&(*pool)->lock, NULL) != 0)
+    {
+        free((*pool)->threads);
+        free(*pool);
+        return -1;
+    }
+
+    if (pthread_cond_init(&(*pool)->not_empty, NULL) != 0)
+    {
+        (void)pthread_mutex_destroy(&(*pool)->lock);
+        free((*pool)->threads);
+        free(*pool);
+        return -1;
+    }
+
+    if (pthread_cond_init(&(*pool)->idle, NULL) != 0)
+    {
+        (void)pthread_cond_destroy(&(*pool)->not_empty);
+        (void)pthread_mutex_destroy(&(*pool)->lock);
+        free((*pool)->threads);
+        free(*pool);
+        return -1;
+    }
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        if (pthread_create(&(*pool)->threads[i], NULL, thread_pool_worker, *pool) != 0)
+        {
+            /* we stop the threads we did start */
+            thread_pool_stop(*pool, i);
+            (void)pthread_cond_destroy(&(*pool)->idle);
+            (void)pthread_cond_destroy(&(*pool)->not_empty);
+            (void)pthread_mutex_destroy(&(*pool)->lock);
+            free((*pool)->threads);
+            free(*pool);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int thread_pool_submit(thread_pool_t *pool, thread_pool_priority_t priority,
+                       thread_pool_job_fn_t fn, void *arg)
+{
+    if (pool == NULL || fn == NULL) return -1;
+    if (priority < THREAD_POOL_PRIORITY_HIGH || priority >= THREAD_POOL_PRIORITIES) return -1;
+
+    thread_pool_job_t *job = malloc(sizeof(thread_pool_job_t));
+    if (job == NULL) return -1;
+
+    job->fn = fn;
+    job->arg = arg;
+    job->next = NULL;
+
+    (void)pthread_mutex_lock(&pool->lock);
+
+    /* a stopping pool takes no new work */
+    if (pool->stop)
+    {
+        (void)pthread_mutex_unlock(&pool->lock);
+        free(job);
+        return -1;
+    }
+
+    if (pool->tail[priority] == NULL)
+        pool->head[priority] = job;
+    else
+        pool->tail[priority]->next = job;
+    pool->tail[priority] = job;
+    pool->queued++;
+
+    (void)pthread_cond_signal(&pool->not_empty);
+    (void)pthread_mutex_unlock(&pool->lock);
+
+    return 0;
+}
+
+void thread_pool_wait(thread_pool_t *pool)
+{
+    if (pool == NULL) return;
+
+    (void)pthread_mutex_lock(&pool->lock);
+    while (pool->queued > 0 || pool->running > 0)
+        (void)pthread_cond_wait(&pool->idle, &pool->lock);
+    (void)pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_free(thread_pool_t *pool)
+{
+    if (pool == NULL) return;
+
+    thread_pool_stop(pool, pool->num_threads);
+
+    (void)pthread_cond_destroy(&pool->idle);
+    (void)pthread_cond_destroy(&pool->not_empty);
+    (void)pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,127 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define THREAD_POOL_MAX_THREADS 64 /* the maximum number of threads in a pool */
+
+/**
+ * thread_pool_priority_t
+ * priority of a job, queued jobs of a higher priority run first and jobs of the same priority run
+ * in the order they were submitted
+ */
+typedef enum
+{
+    THREAD_POOL_PRIORITY_HIGH,   /* i.e flushes */
+    THREAD_POOL_PRIORITY_MEDIUM, /* i.e compactions */
+    THREAD_POOL_PRIORITY_LOW,    /* everything else */
+    THREAD_POOL_PRIORITIES,
+} thread_pool_priority_t;
+
+/**
+ * thread_pool_job_fn_t
+ * the function a job runs on a pool thread
+ */
+typedef void (*thread_pool_job_fn_t)(void *arg);
+
+/**
+ * thread_pool_job_t
+ * a queued job
+ * @param fn the function to run
+ * @param arg the argument for the function
+ * @param next the next job of the same priority
+ */
+typedef struct thread_pool_job_t
+{
+    thread_pool_job_fn_t fn;
+    void *arg;
+    struct thread_pool_job_t *next;
+} thread_pool_job_t;
+
+/**
+ * thread_pool_t
+ * a fixed set of threads running jobs off a priority queue
+ * @param threads the pool threads
+ * @param num_threads the number of pool threads
+ * @param head the oldest queued job per priority
+ * @param tail the newest queued job per priority
+ * @param queued the number of queued jobs
+ * @param running the number of jobs being run
+ * @param stop whether the pool is shutting down, queued jobs still run
+ * @param lock the lock for the queue
+ * @param not_empty signalled when a job is queued or the pool stops
+ * @param idle signalled when the pool runs out of work
+ * @param completed the number of jobs run
+ */
+typedef struct
+{
+    pthread_t *threads;
+    int num_threads;
+    thread_pool_job_t *head[THREAD_POOL_PRIORITIES];
+    thread_pool_job_t *tail[THREAD_POOL_PRIORITIES];
+    int queued;
+    int running;
+    bool stop;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t idle;
+    _Atomic uint64_t completed;
+} thread_pool_t;
+
+/**
+ * thread_pool_new
+ * creates a new thread pool and starts its threads
+ * @param pool the pool to create
+ * @param num_threads the number of threads, 1 to THREAD_POOL_MAX_THREADS
+ * @return 0 if successful, -1 if not
+ */
+int thread_pool_new(thread_pool_t **pool, int num_threads);
+
+/**
+ * thread_pool_submit
+ * queues a job on the pool
+ * @param pool the pool
+ * @param priority the priority of the job
+ * @param fn the function to run
+ * @param arg the argument for the function
+ * @return 0 if the job was queued, -1 if not
+ */
+int thread_pool_submit(thread_pool_t *pool, thread_pool_priority_t priority,
+                       thread_pool_job_fn_t fn, void *arg);
+
+/**
+ * thread_pool_wait
+ * waits until every job submitted so far has run
+ * @param pool the pool
+ */
+void thread_pool_wait(thread_pool_t *pool);
+
+/**
+ * thread_pool_free
+ * runs the queued jobs, stops the threads and frees the pool
+ * @param pool the pool to free
+ */
+void thread_pool_free(thread_pool_t *pool);
+
+#endif /* __THREAD_POOL_H__ */
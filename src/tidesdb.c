@@ -86,15 +86,18 @@ tidesdb_key_value_pair_t *_tidesdb_deserialize_key_value_pair(
     /* if we are to decompress the data */
     if (decompress)
     {
+        uint64_t start = _tidesdb_perf_start();
         size_t decompressed_size = 0;
         decompressed_data = decompress_data(data, data_size, &decompressed_size,
                                             _tidesdb_map_compression_algo(compress_algo));
+        (void)_tidesdb_perf_stop(TDB_PERF_DECOMPRESS, start);
 
         if (decompressed_data == NULL) return NULL;
         data = decompressed_data;
         data_size = decompressed_size;
     }
 
+    uint64_t start = _tidesdb_perf_start();
     const uint8_t *ptr = data;
 
     /* deserialize key_size */
@@ -141,6 +144,8 @@ tidesdb_key_value_pair_t *_tidesdb_deserialize_key_value_pair(
     free(value);
     if (decompressed_data) free(decompressed_data);
 
+    (void)_tidesdb_perf_stop(TDB_PERF_DESERIALIZE, start);
+
     return kv;
 }
 
@@ -213,8 +218,8 @@ uint8_t *_tidesdb_serialize_column_family_config(tidesdb_column_family_config_t
                                                  size_t *out_size)
 {
     /* calculate the size of the serialized data */
-    *out_size = sizeof(uint32_t) + strlen(config->name) + 1 + sizeof(int32_t) * 2 + sizeof(float) +
-                sizeof(uint8_t) * 2 + sizeof(tidesdb_compression_algo_t) +
+    *out_size = sizeof(uint32_t) + strlen(config->name) + 1 + sizeof(int32_t) * 3 + sizeof(float) +
+                sizeof(uint8_t) * 6 + sizeof(tidesdb_compression_algo_t) +
                 sizeof(tidesdb_memtable_ds_t);
 
     /* allocate memory for the serialized data */
@@ -254,14 +259,40 @@ uint8_t *_tidesdb_serialize_column_family_config(tidesdb_column_family_config_t
 
     /* serialize compression_algo */
     memcpy(ptr, &config->compress_algo, sizeof(tidesdb_compression_algo_t));
+    ptr += sizeof(tidesdb_compression_algo_t);
 
     /* serialize memtable_ds */
     memcpy(ptr, &config->memtable_ds, sizeof(tidesdb_memtable_ds_t));
+    ptr += sizeof(tidesdb_memtable_ds_t);
+
+    /* serialize memtable_shards */
+    memcpy(ptr, &config->memtable_shards, sizeof(int32_t));
+    ptr += sizeof(int32_t);
+
+    /* serialize filter_type */
+    uint8_t filter_type = (uint8_t)config->filter_type;
+    memcpy(ptr, &filter_type, sizeof(uint8_t));
+    ptr += sizeof(uint8_t);
+
+    /* serialize partitioned_index */
+    uint8_t partitioned_index = config->partitioned_index;
+    memcpy(ptr, &partitioned_index, sizeof(uint8_t));
+    ptr += sizeof(uint8_t);
+
+    /* serialize hash_index */
+    uint8_t hash_index = config->hash_index;
+    memcpy(ptr, &hash_index, sizeof(uint8_t));
+    ptr += sizeof(uint8_t);
+
+    /* serialize learned_index */
+    uint8_t learned_index = config->learned_index;
+    memcpy(ptr, &learned_index, sizeof(uint8_t));
 
     return serialized_data;
 }
 
-tidesdb_column_family_config_t *_tidesdb_deserialize_column_family_config(const uint8_t *data)
+tidesdb_column_family_config_t *_tidesdb_deserialize_column_family_config(const uint8_t *data,
+                                                                          size_t size)
 {
     const uint8_t *ptr = data;
 
@@ -304,10 +335,43 @@ tidesdb_column_family_config_t *_tidesdb_deserialize_column_family_config(const
     /* deserialize compression_algo */
     tidesdb_compression_algo_t compress_algo;
     memcpy(&compress_algo, ptr, sizeof(tidesdb_compression_algo_t));
+    ptr += sizeof(tidesdb_compression_algo_t);
 
     /* deserialize memtable_ds */
     tidesdb_memtable_ds_t memtable_ds;
     memcpy(&memtable_ds, ptr, sizeof(tidesdb_memtable_ds_t));
+    ptr += sizeof(tidesdb_memtable_ds_t);
+
+    /* deserialize memtable_shards, configs written before shards existed have a single shard */
+    int32_t memtable_shards = 1;
+    if ((size_t)(ptr - data) + sizeof(int32_t) <= size)
+        memcpy(&memtable_shards, ptr, sizeof(int32_t));
+    if (memtable_shards < 1 || memtable_shards > TDB_MAX_MEMTABLE_SHARDS) memtable_shards = 1;
+    ptr += sizeof(int32_t);
+
+    /* deserialize filter_type, configs written before filter types existed use bloom filters */
+    uint8_t filter_type = TDB_FILTER_BLOOM;
+    if ((size_t)(ptr - data) + sizeof(uint8_t) <= size)
+        memcpy(&filter_type, ptr, sizeof(uint8_t));
+    if (filter_type > TDB_FILTER_BINARY_FUSE) filter_type = TDB_FILTER_BLOOM;
+    ptr += sizeof(uint8_t);
+
+    /* deserialize partitioned_index, configs written before it existed have plain sstables */
+    uint8_t partitioned_index = 0;
+    if ((size_t)(ptr - data) + sizeof(uint8_t) <= size)
+        memcpy(&partitioned_index, ptr, sizeof(uint8_t));
+    ptr += sizeof(uint8_t);
+
+    /* deserialize hash_index, configs written before it existed have no partition hash indexes */
+    uint8_t hash_index = 0;
+    if ((size_t)(ptr - data) + sizeof(uint8_t) <= size)
+        memcpy(&hash_index, ptr, sizeof(uint8_t));
+    ptr += sizeof(uint8_t);
+
+    /* deserialize learned_index, configs written before it existed have no learned indexes */
+    uint8_t learned_index = 0;
+    if ((size_t)(ptr - data) + sizeof(uint8_t) <= size)
+        memcpy(&learned_index, ptr, sizeof(uint8_t));
 
     /* create the column family config */
     tidesdb_column_family_config_t *config = malloc(sizeof(tidesdb_column_family_config_t));
@@ -326,6 +390,11 @@ tidesdb_column_family_config_t *_tidesdb_deserialize_column_family_config(const
     config->bloom_filter = (bool)bloom_filter;
     config->compress_algo = compress_algo;
     config->memtable_ds = memtable_ds;
+    config->memtable_shards = memtable_shards;
+    config->filter_type = (tidesdb_filter_type_t)filter_type;
+    config->partitioned_index = partitioned_index != 0;
+    config->hash_index = config->partitioned_index && hash_index != 0;
+    config->learned_index = config->partitioned_index && learned_index != 0;
 
     /* return the column family config */
     return config;
@@ -476,6 +545,11 @@ void _tidesdb_free_operation(tidesdb_operation_t *op)
 }
 
 tidesdb_err_t *tidesdb_open(char *directory, tidesdb_t **tdb)
+{
+    return tidesdb_open_w_config(directory, NULL, tdb);
+}
+
+tidesdb_err_t *tidesdb_open_w_config(char *directory, tidesdb_config_t *config, tidesdb_t **tdb)
 {
     /* we check if the provided tidesdb instance is NULL */
     if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
@@ -500,6 +574,61 @@ tidesdb_err_t *tidesdb_open(char *directory, tidesdb_t **tdb)
         return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "db path");
     }
 
+    /* we copy the configuration, everything is off by default */
+    if (config != NULL)
+        (*tdb)->config = *config;
+    else
+        (*tdb)->config = (tidesdb_config_t){0};
+
+    atomic_init(&(*tdb)->delayed_writes, 0);
+    atomic_init(&(*tdb)->stopped_writes, 0);
+    atomic_init(&(*tdb)->stall_us, 0);
+    atomic_init(&(*tdb)->memtable_bytes, 0);
+
+    /* we always have a rate limiter so the budget can be set later, unlimited costs nothing */
+    if (rate_limiter_new(&(*tdb)->rate_limiter, (*tdb)->config.rate_limit_bytes_per_sec) == -1)
+    {
+        free((*tdb)->directory);
+        free(*tdb);
+        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "rate limiter");
+    }
+
+    /* the row cache is shared by every column family, its rows are keyed by their cache id */
+    (*tdb)->row_cache = NULL;
+    atomic_init(&(*tdb)->next_cache_id, 0);
+    if ((*tdb)->config.row_cache_bytes > 0 &&
+        row_cache_new(&(*tdb)->row_cache, (size_t)(*tdb)->config.row_cache_bytes) == -1)
+    {
+        (void)rate_limiter_free((*tdb)->rate_limiter);
+        free((*tdb)->directory);
+        free(*tdb);
+        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "row cache");
+    }
+
+    /* the background pool is shared by every column family so the threads doing background work
+     * stay bounded however many column families there are */
+    int background_threads = (*tdb)->config.background_threads;
+    if (background_threads == 0) background_threads = TDB_DEFAULT_BACKGROUND_THREADS;
+    if (background_threads < 1 || background_threads > THREAD_POOL_MAX_THREADS ||
+        (*tdb)->config.max_subcompactions < 0 ||
+        (*tdb)->config.max_subcompactions > THREAD_POOL_MAX_THREADS)
+    {
+        (void)rate_limiter_free((*tdb)->rate_limiter);
+        (void)row_cache_free((*tdb)->row_cache);
+        free((*tdb)->directory);
+        free(*tdb);
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MAX_THREADS);
+    }
+
+    if (thread_pool_new(&(*tdb)->background_pool, background_threads) == -1)
+    {
+        (void)rate_limiter_free((*tdb)->rate_limiter);
+        (void)row_cache_free((*tdb)->row_cache);
+        free((*tdb)->directory);
+        free(*tdb);
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_START_THREAD, "background pool");
+    }
+
     /* set column families */
     (*tdb)->column_families = NULL;
     (*tdb)->num_column_families = 0; /* 0 for now until we read db path */
@@ -507,6 +636,9 @@ tidesdb_err_t *tidesdb_open(char *directory, tidesdb_t **tdb)
     /* initialize the lock */
     if (pthread_rwlock_init(&(*tdb)->rwlock, NULL) != 0)
     {
+        (void)thread_pool_free((*tdb)->background_pool);
+        (void)rate_limiter_free((*tdb)->rate_limiter);
+        (void)row_cache_free((*tdb)->row_cache);
         free((*tdb)->directory);
         free(*tdb);
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_LOCK, "tidesdb_t");
@@ -517,6 +649,10 @@ tidesdb_err_t *tidesdb_open(char *directory, tidesdb_t **tdb)
     if (access(directory, F_OK) == -1) /* we create the directory **/
         if (mkdir(directory, 0777) == -1)
         {
+            (void)thread_pool_free((*tdb)->background_pool);
+            (void)rate_limiter_free((*tdb)->rate_limiter);
+            (void)row_cache_free((*tdb)->row_cache);
+            (void)pthread_rwlock_destroy(&(*tdb)->rwlock);
             free((*tdb)->directory);
             free(*tdb);
             return tidesdb_err_from_code(TIDESDB_ERR_MKDIR, directory);
@@ -525,6 +661,10 @@ tidesdb_err_t *tidesdb_open(char *directory, tidesdb_t **tdb)
     /* now we load the column families */
     if (_tidesdb_load_column_families(*tdb) == -1)
     {
+        (void)thread_pool_free((*tdb)->background_pool);
+        (void)rate_limiter_free((*tdb)->rate_limiter);
+        (void)row_cache_free((*tdb)->row_cache);
+        (void)pthread_rwlock_destroy(&(*tdb)->rwlock);
         free((*tdb)->directory);
         free(*tdb);
         return tidesdb_err_from_code(TIDESDB_ERR_LOAD_COLUMN_FAMILIES);
@@ -604,7 +744,7 @@ int _tidesdb_load_column_families(tidesdb_t *tdb)
 
                 /* deserialize the cf config */
                 tidesdb_column_family_config_t *config =
-                    _tidesdb_deserialize_column_family_config(buffer);
+                    _tidesdb_deserialize_column_family_config(buffer, config_size);
                 if (config == NULL)
                 {
                     free(buffer);
@@ -624,25 +764,19 @@ int _tidesdb_load_column_families(tidesdb_t *tdb)
                     continue;
                 }
 
+                cf->tdb = NULL; /* set when the column family is added */
                 cf->config = *config;
                 cf->path = strdup(cf_path);
-                cf->sstables = NULL;
-                cf->num_sstables = 0;
-
-                switch (cf->config.memtable_ds)
-                {
-                    case TDB_MEMTABLE_SKIP_LIST:
-                        cf->memtable = skip_list_new(cf->config.max_level, cf->config.probability);
-                        break; /* create a skip list */
-                    case TDB_MEMTABLE_HASH_TABLE:
-                        (void)hash_table_new(cf->memtable);
-                        break;
-                }
+                cf->next_sstable_id = 0;
+                cf->dropped = false;
+                atomic_init(&cf->refcount, 1); /* the reference held by the db */
+                cf->shards = NULL;
 
                 free(config);
 
-                cf->wal = malloc(sizeof(tidesdb_wal_t));
-                if (cf->wal == NULL) /* could not allocate memory for wal */
+                /* we start with an empty version, the sstables are loaded into it below */
+                cf->version = _tidesdb_version_new(NULL, 0);
+                if (cf->version == NULL)
                 {
                     free(cf->path);
                     free(cf);
@@ -650,23 +784,35 @@ int _tidesdb_load_column_families(tidesdb_t *tdb)
                     continue;
                 }
 
+                (void)pthread_mutex_init(&cf->version_lock, NULL);
+                (void)pthread_cond_init(&cf->version_cond, NULL);
+                atomic_init(&cf->num_sstables, 0);
+                cf->stall_condition = TDB_STALL_NORMAL;
+                atomic_init(&cf->memtable_bytes, 0);
+                (void)pthread_mutex_init(&cf->compaction_lock, NULL);
+                (void)pthread_mutex_init(&cf->file_lock, NULL);
+
                 /* initialize read-write lock */
                 if (pthread_rwlock_init(&cf->rwlock, NULL) != 0)
                 {
+                    (void)pthread_mutex_destroy(&cf->file_lock);
+                    (void)pthread_mutex_destroy(&cf->compaction_lock);
+                    (void)pthread_cond_destroy(&cf->version_cond);
+                    (void)pthread_mutex_destroy(&cf->version_lock);
+                    (void)_tidesdb_release_version(cf->version);
+                    free(cf->config.name);
                     free(cf->path);
-                    free(cf->wal);
                     free(cf);
                     (void)closedir(cf_dir);
                     continue;
                 }
 
-                /* now we open the wal */
-                if (_tidesdb_open_wal(cf->path, &cf->wal, cf->config.compressed,
-                                      cf->config.compress_algo) == -1)
+                /* now we open the memtable shards and their wals, the wals count their bytes
+                 * into the statistics */
+                cf->stats = _tidesdb_stats_new();
+                if (cf->stats == NULL || _tidesdb_open_shards(cf) == -1)
                 {
-                    free(cf->path);
-                    free(cf->wal);
-                    free(cf);
+                    (void)_tidesdb_free_column_family(cf);
                     (void)closedir(cf_dir);
                     continue;
                 }
@@ -674,21 +820,17 @@ int _tidesdb_load_column_families(tidesdb_t *tdb)
                 /* we add the column family to tidesdb arr */
                 if (_tidesdb_add_column_family(tdb, cf) == -1)
                 {
-                    (void)_tidesdb_close_wal(cf->wal);
-                    free(cf->path);
-                    free(cf);
+                    (void)_tidesdb_free_column_family(cf);
                     (void)closedir(cf_dir);
                     continue;
                 }
 
-                /* we load the sstable files into memory */
+                /* we load the sstables listed in the manifest */
                 (void)_tidesdb_load_sstables(cf);
 
-                /* we sort sstables if any */
-                (void)_tidesdb_sort_sstables(cf);
-
-                /* now we replay from the wal and populate column family memtable */
-                (void)_tidesdb_replay_from_wal(cf);
+                /* now we replay each shard's wal and populate its memtable */
+                for (int i = 0; i < cf->config.memtable_shards; i++)
+                    (void)_tidesdb_replay_from_wal(cf, &cf->shards[i]);
             }
         }
 
@@ -702,16 +844,222 @@ int _tidesdb_load_column_families(tidesdb_t *tdb)
     return 0;
 }
 
+tidesdb_err_t *tidesdb_set_rate_limit(tidesdb_t *tdb, int64_t bytes_per_sec)
+{
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    /* flushes and compactions already waiting pick up the new budget */
+    (void)rate_limiter_set_bytes_per_sec(tdb->rate_limiter, bytes_per_sec);
+
+    tdb->config.rate_limit_bytes_per_sec = bytes_per_sec;
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_get_stall_stats(tidesdb_t *tdb, tidesdb_stall_stats_t *stats)
+{
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    if (stats == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    stats->delayed_writes = atomic_load(&tdb->delayed_writes);
+    stats->stopped_writes = atomic_load(&tdb->stopped_writes);
+    stats->stall_us = atomic_load(&tdb->stall_us);
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_get_stats(tidesdb_t *tdb, const char *column_family_name,
+                                 tidesdb_stats_t *stats)
+{
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    if (stats == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    tidesdb_column_family_t *cf = NULL;
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family_name, &cf);
+    if (e != NULL) return e;
+
+    (void)_tidesdb_stats_collect(cf, stats);
+
+    (void)_tidesdb_release_column_family(cf);
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_get_stats_w_handle(tidesdb_cf_handle_t *handle, tidesdb_stats_t *stats)
+{
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    if (stats == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    (void)_tidesdb_stats_collect(handle->cf, stats);
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_get_sstable_stats(tidesdb_t *tdb, const char *column_family_name,
+                                         tidesdb_sstable_stats_t **stats, int *num_sstables)
+{
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    if (stats == NULL || num_sstables == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    tidesdb_column_family_t *cf = NULL;
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family_name, &cf);
+    if (e != NULL) return e;
+
+    e = _tidesdb_sstable_stats(cf, stats, num_sstables);
+
+    (void)_tidesdb_release_column_family(cf);
+
+    return e;
+}
+
+tidesdb_err_t *tidesdb_get_sstable_stats_w_handle(tidesdb_cf_handle_t *handle,
+                                                  tidesdb_sstable_stats_t **stats,
+                                                  int *num_sstables)
+{
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    if (stats == NULL || num_sstables == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    return _tidesdb_sstable_stats(handle->cf, stats, num_sstables);
+}
+
+tidesdb_err_t *_tidesdb_sstable_stats(tidesdb_column_family_t *cf, tidesdb_sstable_stats_t **stats,
+                                      int *num_sstables)
+{
+    /* the version keeps its sstables open while we read them */
+    tidesdb_version_t *version = _tidesdb_acquire_version(cf);
+
+    *stats = NULL;
+    *num_sstables = version->num_sstables;
+    if (version->num_sstables > 0)
+    {
+        *stats = malloc(sizeof(tidesdb_sstable_stats_t) * version->num_sstables);
+        if (*stats == NULL)
+        {
+            *num_sstables = 0;
+            (void)_tidesdb_release_version(version);
+            return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "sstable stats");
+        }
+    }
+
+    for (int i = 0; i < version->num_sstables; i++)
+    {
+        tidesdb_sstable_t *sst = version->sstables[i];
+        tidesdb_sstable_stats_t *s = &(*stats)[i];
+
+        s->id = sst->id;
+        s->size = _tidesdb_sstable_size(sst);
+        s->filter_type = cf->config.filter_type;
+
+        /* the index of a partitioned sstable also gives its filter statistics */
+        s->index_partitions = 0;
+        s->index_bytes = 0;
+        tidesdb_sstable_index_t *index =
+            cf->config.partitioned_index ? _tidesdb_sstable_index(sst) : NULL;
+        if (index != NULL)
+        {
+            s->index_partitions = (int)index->num_partitions;
+            s->index_bytes = index->size;
+        }
+
+        s->bloom_bits = atomic_load(&sst->bloom_bits);
+        s->bloom_bits_set = s->bloom_bits > 0 ? atomic_load(&sst->bloom_bits_set) : 0;
+        s->bloom_hashes = s->bloom_bits > 0 ? atomic_load(&sst->bloom_hashes) : 0;
+
+        /* with a fraction f of the bits set a missing key passes all h probes about f^h of the
+         * time */
+        s->bloom_fill_ratio = 0.0;
+        s->bloom_estimated_fpr = 0.0;
+        if (s->bloom_bits > 0 && s->filter_type == TDB_FILTER_BINARY_FUSE)
+        {
+            /* a missing key passes when its 8 bit fingerprint matches by chance */
+            s->bloom_estimated_fpr = 1.0 / 256;
+        }
+        else if (s->bloom_bits > 0)
+        {
+            s->bloom_fill_ratio = (double)s->bloom_bits_set / s->bloom_bits;
+            s->bloom_estimated_fpr = pow(s->bloom_fill_ratio, s->bloom_hashes);
+        }
+
+        s->bloom_checks = atomic_load_explicit(&sst->bloom_checks, memory_order_relaxed);
+        s->bloom_negatives = atomic_load_explicit(&sst->bloom_negatives, memory_order_relaxed);
+        s->bloom_false_positives =
+            atomic_load_explicit(&sst->bloom_false_positives, memory_order_relaxed);
+    }
+
+    (void)_tidesdb_release_version(version);
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_get_memory_usage(tidesdb_t *tdb, tidesdb_memory_usage_t *usage)
+{
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    if (usage == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0)
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
+
+    *usage = (tidesdb_memory_usage_t){0};
+    for (int i = 0; i < tdb->num_column_families; i++)
+    {
+        tidesdb_stats_t stats;
+        (void)_tidesdb_stats_collect(tdb->column_families[i], &stats);
+        usage->memtable_bytes += stats.memtable_bytes;
+        usage->bloom_filter_bytes += stats.bloom_filter_bytes;
+        usage->merge_table_bytes += stats.merge_table_bytes;
+        usage->txn_buffer_bytes += stats.txn_buffer_bytes;
+    }
+
+    (void)pthread_rwlock_unlock(&tdb->rwlock);
+
+    if (tdb->row_cache != NULL)
+    {
+        usage->row_cache_bytes = row_cache_size(tdb->row_cache);
+        usage->row_cache_capacity = tdb->row_cache->capacity;
+    }
+
+    usage->total_bytes = usage->memtable_bytes + usage->bloom_filter_bytes +
+                         usage->merge_table_bytes + usage->txn_buffer_bytes +
+                         usage->row_cache_bytes;
+    if (tdb->config.write_buffer_budget > 0)
+        usage->write_buffer_budget = (uint64_t)tdb->config.write_buffer_budget;
+
+    return NULL;
+}
+
 tidesdb_err_t *tidesdb_close(tidesdb_t *tdb)
 {
     if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
 
+    /* we let queued background jobs finish before the column families they work on go away */
+    (void)thread_pool_free(tdb->background_pool);
+    tdb->background_pool = NULL;
+
     (void)_tidesdb_free_column_families(tdb);
 
     /* we destroy the db lock */
     if (pthread_rwlock_destroy(&tdb->rwlock) != 0)
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_DESTROY_LOCK, "tidesdb_t");
 
+    (void)rate_limiter_free(tdb->rate_limiter);
+
+    /* the column families are gone so nothing reads or invalidates the row cache anymore */
+    (void)row_cache_free(tdb->row_cache);
+
     free(tdb->directory);
 
     /* we free the tidesdb */
@@ -727,45 +1075,18 @@ void _tidesdb_free_column_families(tidesdb_t *tdb)
     /* we check if we have column families */
     if (tdb->num_column_families > 0)
     {
-        /* we iterate over the column families and free them */
+        /* we iterate over the column families releasing the reference the db holds on each
+         * column families still pinned by a handle are freed when that handle is released */
         for (int i = 0; i < tdb->num_column_families; i++)
         {
-            if (tdb->column_families[i]->config.name != NULL)
-                free(tdb->column_families[i]->config.name);
-
-            if (tdb->column_families[i]->path != NULL) free(tdb->column_families[i]->path);
-
-            if (tdb->column_families[i]->memtable != NULL)
-            {
-                (void)skip_list_destroy(tdb->column_families[i]->memtable);
-                tdb->column_families[i]->memtable = NULL;
-            }
-
-            /* we free the sstables, closing them as well */
-            if (tdb->column_families[i]->sstables != NULL)
-            {
-                for (int j = 0; j < tdb->column_families[i]->num_sstables; j++)
-                    (void)_tidesdb_free_sstable(tdb->column_families[i]->sstables[j]);
-
-                free(tdb->column_families[i]->sstables);
-                tdb->column_families[i]->sstables = NULL;
-            }
-
-            /* we close the wal */
-            if (tdb->column_families[i]->wal != NULL)
-            {
-                (void)_tidesdb_close_wal(tdb->column_families[i]->wal); /* flushes on close */
-                tdb->column_families[i]->wal = NULL;
-            }
-
-            /* we free the column family */
-            free(tdb->column_families[i]);
+            (void)_tidesdb_release_column_family(tdb->column_families[i]);
             tdb->column_families[i] = NULL;
         }
 
         /* we free the column families */
         free(tdb->column_families);
         tdb->column_families = NULL;
+        tdb->num_column_families = 0;
     }
 }
 
@@ -781,6 +1102,9 @@ int _tidesdb_free_sstable(tidesdb_sstable_t *sst)
         sst->block_manager = NULL;
     }
 
+    /* we free the top level index of a partitioned sstable */
+    (void)_tidesdb_free_sstable_index(atomic_load(&sst->index));
+
     /* we free the sstable */
     free(sst);
 
@@ -807,1536 +1131,3761 @@ void _tidesdb_close_wal(tidesdb_wal_t *wal)
     wal = NULL;
 }
 
-int _tidesdb_load_sstables(tidesdb_column_family_t *cf)
+int _tidesdb_open_sstable(tidesdb_column_family_t *cf, uint64_t id, tidesdb_sstable_t **sst)
 {
-    /* we check if cf is NULL */
-    if (cf == NULL) return -1;
+    /* we construct the path to the sstable from its id */
+    char sstable_path[MAX_FILE_PATH_LENGTH];
+    (void)snprintf(sstable_path, sizeof(sstable_path), "%s%s%s%" PRIu64 "%s", cf->path,
+                   _tidesdb_get_path_seperator(), TDB_SSTABLE_PREFIX, id, TDB_SSTABLE_EXT);
 
-    if (cf->path == NULL) return -1;
+    *sst = malloc(sizeof(tidesdb_sstable_t));
+    if (*sst == NULL) return -1;
 
-    /* we open the column family directory */
-    DIR *cf_dir = opendir(cf->path);
-    if (cf_dir == NULL)
-    { /* we check if the directory was opened */
+    /* with direct I/O sstable reads, flushes and compactions bypass the page cache */
+    bool direct_io = cf->tdb != NULL && cf->tdb->config.direct_io;
+
+    /* sstables are immutable once written and synced so they don't need an fsync thread */
+    if (block_manager_open_w_direct_io(&(*sst)->block_manager, sstable_path, 0, direct_io) == -1)
+    {
+        free(*sst);
+        *sst = NULL;
         return -1;
     }
 
-    struct dirent *entry;
+    (*sst)->id = id;
+    (*sst)->cf = cf;
+    atomic_init(&(*sst)->refcount, 1); /* the reference held by the caller */
+    atomic_init(&(*sst)->obsolete, false);
+    atomic_init(&(*sst)->bloom_bits, 0);
+    atomic_init(&(*sst)->bloom_bits_set, 0);
+    atomic_init(&(*sst)->bloom_hashes, 0);
+    atomic_init(&(*sst)->bloom_checks, 0);
+    atomic_init(&(*sst)->bloom_negatives, 0);
+    atomic_init(&(*sst)->bloom_false_positives, 0);
+    atomic_init(&(*sst)->index, NULL);
 
-    /* we iterate over the column family directory */
-    while ((entry = readdir(cf_dir)) != NULL)
-    {
-        /* we skip the . and .. directories */
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+    return 0;
+}
 
-        /* we check if the file ends with SSTABLE_EXT or contains */
-        if (strstr(entry->d_name, TDB_SSTABLE_EXT) == NULL) continue;
+void _tidesdb_ref_sstable(tidesdb_sstable_t *sst)
+{
+    (void)atomic_fetch_add_explicit(&sst->refcount, 1, memory_order_relaxed);
+}
 
-        /* we construct the path to the sstable */
-        char sstable_path[MAX_FILE_PATH_LENGTH];
-        (void)snprintf(sstable_path, sizeof(sstable_path), "%s%s%s", cf->path,
-                       _tidesdb_get_path_seperator(), entry->d_name);
+void _tidesdb_release_sstable(tidesdb_sstable_t *sst)
+{
+    if (atomic_fetch_sub_explicit(&sst->refcount, 1, memory_order_acq_rel) != 1) return;
 
-        /* we open the sstable */
-        block_manager_t *sstable_block_manager = NULL;
+    /* the last reference is gone, if the sstable was compacted away no version or reader can see
+     * it anymore so we remove its file as well */
+    if (atomic_load(&sst->obsolete))
+    {
+        char sstable_path[MAX_FILE_PATH_LENGTH];
+        (void)snprintf(sstable_path, sizeof(sstable_path), "%s", sst->block_manager->file_path);
+        tidesdb_column_family_t *cf = sst->cf;
 
-        if (block_manager_open(&sstable_block_manager, sstable_path, TDB_SYNC_INTERVAL) == -1)
-        {
-            /* free up resources */
-            (void)closedir(cf_dir);
+        (void)_tidesdb_free_sstable(sst);
 
-            return -1;
-        }
+        /* a dropped column family's directory is gone and one created under the same name may
+         * have an sstable at the same path, drop sets the flag under the file lock so it can't
+         * come between our check and the removal */
+        (void)pthread_mutex_lock(&cf->file_lock);
+        if (!cf->dropped) (void)remove(sstable_path);
+        (void)pthread_mutex_unlock(&cf->file_lock);
+        return;
+    }
 
-        /* we create/alloc the sstable struct */
-        tidesdb_sstable_t *sst = malloc(sizeof(tidesdb_sstable_t));
-        if (sst == NULL) return -1;
+    (void)_tidesdb_free_sstable(sst);
+}
 
-        /* we set the block manager */
-        sst->block_manager = sstable_block_manager;
+uint64_t _tidesdb_sstable_size(tidesdb_sstable_t *sst)
+{
+    struct stat st;
+    if (stat(sst->block_manager->file_path, &st) != 0) return 0;
 
-        /* check if sstables is NULL */
-        if (cf->sstables == NULL)
-        {
-            cf->sstables = malloc(sizeof(tidesdb_sstable_t));
-            if (cf->sstables == NULL) return -1;
-        }
-        else
-        {
-            /* we add the sstable to the column family */
-            tidesdb_sstable_t **temp_sstables =
-                realloc(cf->sstables, sizeof(tidesdb_sstable_t) * (cf->num_sstables + 1));
-            if (temp_sstables == NULL) return -1;
+    return (uint64_t)st.st_size;
+}
 
-            cf->sstables = temp_sstables;
-        }
+tidesdb_version_t *_tidesdb_version_new(tidesdb_sstable_t **sstables, int num_sstables)
+{
+    tidesdb_version_t *version = malloc(sizeof(tidesdb_version_t));
+    if (version == NULL) return NULL;
 
-        cf->sstables[cf->num_sstables] = sst;
+    version->sstables = NULL;
+    version->num_sstables = num_sstables;
+    atomic_init(&version->refcount, 1); /* the reference held by the caller */
 
-        /* we increment the number of sstables */
-        cf->num_sstables++;
+    if (num_sstables == 0) return version;
 
-        /* we free up resources */
-        (void)closedir(cf_dir);
+    version->sstables = malloc(sizeof(tidesdb_sstable_t *) * num_sstables);
+    if (version->sstables == NULL)
+    {
+        free(version);
+        return NULL;
+    }
 
-        return 0;
+    /* the version holds a reference on each of its sstables */
+    for (int i = 0; i < num_sstables; i++)
+    {
+        version->sstables[i] = sstables[i];
+        (void)_tidesdb_ref_sstable(sstables[i]);
     }
 
-    /* we free up resources */
-    (void)closedir(cf_dir);
+    return version;
+}
 
-    /* we return -1 if no sstables were found */
-    return -1;
+void _tidesdb_release_version(tidesdb_version_t *version)
+{
+    if (atomic_fetch_sub_explicit(&version->refcount, 1, memory_order_acq_rel) != 1) return;
+
+    /* the last reference is gone so we release the sstables the version held */
+    for (int i = 0; i < version->num_sstables; i++)
+        (void)_tidesdb_release_sstable(version->sstables[i]);
+
+    free(version->sstables);
+    free(version);
 }
 
-int _tidesdb_open_wal(const char *cf_path, tidesdb_wal_t **w, bool compress,
-                      tidesdb_compression_algo_t compress_algo)
+tidesdb_version_t *_tidesdb_acquire_version(tidesdb_column_family_t *cf)
 {
-    if (cf_path == NULL) return -1;
+    (void)pthread_mutex_lock(&cf->version_lock);
 
-    /* we check if wal is NULL */
-    if (w == NULL) return -1;
+    tidesdb_version_t *version = cf->version;
+    (void)atomic_fetch_add_explicit(&version->refcount, 1, memory_order_relaxed);
 
-    char wal_path[MAX_FILE_PATH_LENGTH];
-    (void)snprintf(wal_path, sizeof(wal_path), "%s%s%s", cf_path, _tidesdb_get_path_seperator(),
-                   TDB_WAL_EXT);
+    (void)pthread_mutex_unlock(&cf->version_lock);
 
-    block_manager_t *wal_block_manager = NULL;
-    if (block_manager_open(&wal_block_manager, wal_path, TDB_SYNC_INTERVAL) == -1)
+    return version;
+}
+
+int _tidesdb_install_version(tidesdb_column_family_t *cf, tidesdb_version_t *version)
+{
+    /* we persist the new set of sstables first, if we crash before the rename the old manifest
+     * is still in place and the new sstable files are removed as orphans on the next open */
+    if (_tidesdb_write_manifest(cf, version) == -1) return -1;
+
+    tidesdb_version_t *old = cf->version;
+    cf->version = version;
+
+    /* writers stalled on the sstable count recheck it, the event listener is told of the change
+     * once the caller released its locks */
+    atomic_store(&cf->num_sstables, version->num_sstables);
+    (void)pthread_cond_broadcast(&cf->version_cond);
+
+    /* readers that pinned the old version keep it alive until they are done */
+    if (old != NULL) (void)_tidesdb_release_version(old);
+
+    return 0;
+}
+
+int _tidesdb_write_manifest(tidesdb_column_family_t *cf, tidesdb_version_t *version)
+{
+    char manifest_path[MAX_FILE_PATH_LENGTH];
+    char temp_path[MAX_FILE_PATH_LENGTH];
+    (void)snprintf(manifest_path, sizeof(manifest_path), "%s%s%s", cf->path,
+                   _tidesdb_get_path_seperator(), TDB_MANIFEST_FILE);
+    (void)snprintf(temp_path, sizeof(temp_path), "%s%s%s%s", cf->path,
+                   _tidesdb_get_path_seperator(), TDB_MANIFEST_FILE, TDB_TEMP_EXT);
+
+    FILE *manifest = fopen(temp_path, "wb");
+    if (manifest == NULL) return -1;
+
+    /* the manifest is the next sstable id, the amount of sstables and their ids oldest first */
+    uint64_t next_id = cf->next_sstable_id;
+    uint32_t num_sstables = (uint32_t)version->num_sstables;
+    int rc = 0;
+
+    if (fwrite(&next_id, sizeof(uint64_t), 1, manifest) != 1) rc = -1;
+    if (rc == 0 && fwrite(&num_sstables, sizeof(uint32_t), 1, manifest) != 1) rc = -1;
+
+    for (int i = 0; rc == 0 && i < version->num_sstables; i++)
+        if (fwrite(&version->sstables[i]->id, sizeof(uint64_t), 1, manifest) != 1) rc = -1;
+
+    if (rc == 0 && fflush(manifest) != 0) rc = -1;
+    if (rc == 0 && fsync(fileno(manifest)) != 0) rc = -1;
+
+    if (fclose(manifest) != 0) rc = -1;
+
+    if (rc == -1)
     {
+        (void)remove(temp_path);
         return -1;
     }
-    (*w)->compress = compress;
-    (*w)->compress_algo = compress_algo;
 
-    (*w)->block_manager = wal_block_manager;
+    /* we swap the new manifest in */
+    if (rename(temp_path, manifest_path) != 0)
+    {
+        (void)remove(temp_path);
+        return -1;
+    }
 
     return 0;
 }
 
-int _tidesdb_add_column_family(tidesdb_t *tdb, tidesdb_column_family_t *cf)
+uint64_t _tidesdb_next_sstable_id(tidesdb_column_family_t *cf)
 {
-    /* we check if tdb or cf is NULL */
-    if (tdb == NULL || cf == NULL) return -1;
+    (void)pthread_mutex_lock(&cf->version_lock);
+    uint64_t id = cf->next_sstable_id++;
+    (void)pthread_mutex_unlock(&cf->version_lock);
 
-    if (tdb->column_families == NULL)
-    {
-        tdb->column_families = malloc(sizeof(tidesdb_column_family_t *));
-        if (tdb->column_families == NULL)
-        {
-            return -1;
-        }
-    }
-    else
-    {
-        tidesdb_column_family_t **temp_families =
-            realloc(tdb->column_families,
-                    sizeof(tidesdb_column_family_t *) * (tdb->num_column_families + 1));
-        /* we check if the reallocation was successful */
-        if (temp_families == NULL)
-        {
-            return -1;
-        }
-
-        tdb->column_families = temp_families;
-    }
+    return id;
+}
 
-    /* we increment the number of column families */
-    tdb->num_column_families++;
+int _tidesdb_parse_sstable_id(const char *name, uint64_t *id)
+{
+    size_t prefix_len = strlen(TDB_SSTABLE_PREFIX);
+    if (strncmp(name, TDB_SSTABLE_PREFIX, prefix_len) != 0) return -1;
 
-    /* we add the column family */
-    tdb->column_families[tdb->num_column_families - 1] = cf;
+    /* the id has to be followed by the extension and nothing else */
+    char *end = NULL;
+    unsigned long long parsed = strtoull(name + prefix_len, &end, 10);
+    if (end == name + prefix_len || strcmp(end, TDB_SSTABLE_EXT) != 0) return -1;
 
+    *id = (uint64_t)parsed;
     return 0;
 }
 
-int _tidesdb_sort_sstables(const tidesdb_column_family_t *cf)
+int _tidesdb_compare_sstable_ids(const void *a, const void *b)
 {
-    /* we check if the column family is NULL */
-    if (cf == NULL) return -1;
-
-    /* if we have more than 1 sstable we sort them by last modified time */
-    if (cf->num_sstables > 1)
-    {
-        qsort(cf->sstables, cf->num_sstables, sizeof(tidesdb_sstable_t), _tidesdb_compare_sstables);
-        return 0;
-    }
+    uint64_t id1 = *(const uint64_t *)a;
+    uint64_t id2 = *(const uint64_t *)b;
 
-    return -1;
+    return (id1 > id2) - (id1 < id2);
 }
 
-int _tidesdb_compare_sstables(const void *a, const void *b)
+int _tidesdb_load_sstables(tidesdb_column_family_t *cf)
 {
-    if (a == NULL || b == NULL) return 0;
+    /* we check if cf is NULL */
+    if (cf == NULL) return -1;
 
-    tidesdb_sstable_t *s1 = (tidesdb_sstable_t *)a;
-    tidesdb_sstable_t *s2 = (tidesdb_sstable_t *)b;
+    if (cf->path == NULL) return -1;
+
+    /* we read the manifest which lists the live sstables oldest first */
+    char manifest_path[MAX_FILE_PATH_LENGTH];
+    (void)snprintf(manifest_path, sizeof(manifest_path), "%s%s%s", cf->path,
+                   _tidesdb_get_path_seperator(), TDB_MANIFEST_FILE);
 
-    time_t last_modified_s1 = block_manager_last_modified(s1->block_manager);
-    time_t last_modified_s2 = block_manager_last_modified(s2->block_manager);
+    uint64_t *ids = NULL;
+    uint32_t num_ids = 0;
+    uint64_t next_id = 0;
+    bool have_manifest = false;
 
-    switch ((last_modified_s1 < last_modified_s2) - (last_modified_s1 > last_modified_s2))
+    FILE *manifest = fopen(manifest_path, "rb");
+    if (manifest != NULL)
     {
-        case -1:
-            return -1;
-        case 1:
-            return 1;
-        default:
-            return 0;
-    }
-}
+        if (fread(&next_id, sizeof(uint64_t), 1, manifest) == 1 &&
+            fread(&num_ids, sizeof(uint32_t), 1, manifest) == 1)
+        {
+            ids = malloc(sizeof(uint64_t) * (num_ids > 0 ? num_ids : 1));
+            if (ids != NULL && fread(ids, sizeof(uint64_t), num_ids, manifest) == num_ids)
+                have_manifest = true;
+        }
 
-int _tidesdb_replay_from_wal(tidesdb_column_family_t *cf)
-{
-    /* we simply create a block manager cursor, deserialize operations and replay them on the
-     * memtable */
-    block_manager_cursor_t *cursor = NULL;
+        (void)fclose(manifest);
 
-    /* initialize the cursor */
-    if (block_manager_cursor_init(&cursor, cf->wal->block_manager) == -1)
-    {
+        if (!have_manifest)
+        {
+            free(ids);
+            ids = NULL;
+            num_ids = 0;
+            next_id = 0;
+        }
+    }
+
+    /* we open the column family directory */
+    DIR *cf_dir = opendir(cf->path);
+    if (cf_dir == NULL)
+    { /* we check if the directory was opened */
+        free(ids);
         return -1;
     }
 
-    do /* we iterate over the wal */
+    struct dirent *entry;
+    uint32_t ids_cap = num_ids;
+
+    /* we iterate over the column family directory */
+    while ((entry = readdir(cf_dir)) != NULL)
     {
-        /* we read the block */
-        block_manager_block_t *block = block_manager_cursor_read(cursor);
-        if (block == NULL) break;
+        uint64_t id;
+        if (_tidesdb_parse_sstable_id(entry->d_name, &id) == -1) continue;
 
-        /* we deserialize the operation */
-        tidesdb_operation_t *op = _tidesdb_deserialize_operation(
-            block->data, block->size, cf->config.compressed, cf->config.compress_algo);
-        if (op == NULL)
+        if (have_manifest)
         {
-            free(block);
-            break;
+            bool live = false;
+            for (uint32_t i = 0; i < num_ids && !live; i++) live = ids[i] == id;
+            if (live) continue;
+
+            /* an sstable not in the manifest was left behind by a flush or compaction that
+             * didn't get to install its version, its data is still in the wal or the inputs */
+            char orphan_path[MAX_FILE_PATH_LENGTH];
+            (void)snprintf(orphan_path, sizeof(orphan_path), "%s%s%s", cf->path,
+                           _tidesdb_get_path_seperator(), entry->d_name);
+            (void)remove(orphan_path);
+            continue;
         }
 
-        switch (op->op_code)
+        /* no manifest yet, we take every sstable in the directory */
+        if (num_ids == ids_cap)
         {
-            case TIDESDB_OP_PUT:
-                switch (cf->config.memtable_ds)
-                {
-                    case TDB_MEMTABLE_SKIP_LIST:
-                    {
-                        (void)skip_list_put(cf->memtable, op->kv->key, op->kv->key_size,
-                                            op->kv->value, op->kv->value_size, op->kv->ttl);
-                    }
-                    break;
-                    case TDB_MEMTABLE_HASH_TABLE:
-                        (void)hash_table_put(cf->memtable, op->kv->key, op->kv->key_size,
-                                             op->kv->value, op->kv->value_size, op->kv->ttl);
-                        break;
-                    default:
-                        break;
-                }
-
-                break;
-            case TIDESDB_OP_DELETE:
+            ids_cap = ids_cap == 0 ? 16 : ids_cap * 2;
+            uint64_t *temp_ids = realloc(ids, sizeof(uint64_t) * ids_cap);
+            if (temp_ids == NULL)
             {
-                uint8_t *tombstone = malloc(4);
-                if (tombstone == NULL) continue;
-
-                uint32_t tombstone_value = TOMBSTONE;
-                memcpy(tombstone, &tombstone_value, sizeof(uint32_t));
-
-                switch (cf->config.memtable_ds)
-                {
-                    case TDB_MEMTABLE_SKIP_LIST:
-                    {
-                        (void)skip_list_put(cf->memtable, op->kv->key, op->kv->key_size, tombstone,
-                                            4, op->kv->ttl);
-                    }
-                    break;
-                    case TDB_MEMTABLE_HASH_TABLE:
-                        (void)hash_table_put(cf->memtable, op->kv->key, op->kv->key_size, tombstone,
-                                             4, op->kv->ttl);
-                        break;
-                    default:
-                        break;
-                }
-
-                free(tombstone);
+                free(ids);
+                (void)closedir(cf_dir);
+                return -1;
             }
-            break;
-            default:
-                break;
+            ids = temp_ids;
         }
 
-        (void)block_manager_block_free(block);
-
-        /* we free the operation */
-        (void)_tidesdb_free_operation(op);
-
-    } while (block_manager_cursor_next(cursor) != -1);
-
-    (void)block_manager_cursor_free(cursor);
-
-    return 0;
-}
-
-tidesdb_err_t *tidesdb_create_column_family(tidesdb_t *tdb, const char *name, int flush_threshold,
-                                            int max_level, float probability, bool compressed,
-                                            tidesdb_compression_algo_t compression_algo,
-                                            bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
-{
-    /* verify the compression algorithm */
-    if (compressed && compression_algo == TDB_NO_COMPRESSION)
-        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COMPRESSION_ALGO);
-
-    /* we check if the db is NULL */
-    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+        ids[num_ids++] = id;
+    }
 
-    /* we check if the name is NULL */
-    if (name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_NAME, "column family");
+    /* we free up resources */
+    (void)closedir(cf_dir);
 
-    /* we check if the column family name is greater than 2 */
-    if (strlen(name) < 2) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_NAME, "column family");
+    /* sstable ids only grow so without a manifest we order the sstables by id */
+    if (!have_manifest && num_ids > 1)
+        qsort(ids, num_ids, sizeof(uint64_t), _tidesdb_compare_sstable_ids);
 
-    /* we check flush threshold
-     * the system expects at least TDB_FLUSH_THRESHOLD threshold */
-    if (flush_threshold < TDB_FLUSH_THRESHOLD)
-        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_FLUSH_THRESHOLD);
+    tidesdb_sstable_t **sstables =
+        malloc(sizeof(tidesdb_sstable_t *) * (num_ids > 0 ? num_ids : 1));
+    if (sstables == NULL)
+    {
+        free(ids);
+        return -1;
+    }
 
-    /* only if the memtable data structure is skip list
-     * we check max level and probability */
-    if (memtable_ds == TDB_MEMTABLE_SKIP_LIST)
+    int num_sstables = 0;
+    for (uint32_t i = 0; i < num_ids; i++)
     {
-        /* we check max level
-         * the system expects at least a level of TDB_MIN_MAX_LEVEL */
-        if (max_level < TDB_MIN_MAX_LEVEL)
-            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_MAX_LEVEL);
+        if (ids[i] >= next_id) next_id = ids[i] + 1;
 
-        /* we check probability
-         * the system expects at least a probability of TDB_MIN_PROBABILITY */
-        if (probability < TDB_MIN_PROBABILITY)
-            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_PROBABILITY);
+        if (_tidesdb_open_sstable(cf, ids[i], &sstables[num_sstables]) == -1) continue;
+        num_sstables++;
     }
 
-    tidesdb_column_family_t *cf = NULL;
-    if (_tidesdb_new_column_family(tdb->directory, name, flush_threshold, max_level, probability,
-                                   &cf, compressed, compression_algo, bloom_filter,
-                                   memtable_ds) == -1)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_CREATE_COLUMN_FAMILY);
+    free(ids);
 
-    /* now we add the column family */
-    if (_tidesdb_add_column_family(tdb, cf) == -1)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ADD_COLUMN_FAMILY);
+    tidesdb_version_t *version = _tidesdb_version_new(sstables, num_sstables);
 
-    return NULL;
-}
+    /* the version holds its own references now */
+    for (int i = 0; i < num_sstables; i++) (void)_tidesdb_release_sstable(sstables[i]);
+    free(sstables);
 
-tidesdb_err_t *tidesdb_drop_column_family(tidesdb_t *tdb, const char *name)
-{
-    /* check if either tdb or name is NULL */
-    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+    if (version == NULL) return -1;
 
-    /* iterate over the column families to find the one to remove */
-    int index = -1;
-    for (int i = 0; i < tdb->num_column_families; i++)
+    (void)pthread_mutex_lock(&cf->version_lock);
+    cf->next_sstable_id = next_id;
+
+    int rc = 0;
+    if (!have_manifest && num_sstables > 0)
     {
-        if (strcmp(tdb->column_families[i]->config.name, name) == 0)
-        {
-            index = i;
-            break;
-        }
+        /* we write a manifest for a column family from before manifests existed */
+        rc = _tidesdb_install_version(cf, version);
     }
-
-    if (index == -1)
+    else
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+        tidesdb_version_t *old = cf->version;
+        cf->version = version;
+        atomic_store(&cf->num_sstables, version->num_sstables);
+        if (old != NULL) (void)_tidesdb_release_version(old);
     }
 
-    /* free the resources associated with the column family */
-    free(tdb->column_families[index]->config.name);
+    (void)pthread_mutex_unlock(&cf->version_lock);
 
-    /* check if the column family has sstables */
-    if (tdb->column_families[index]->num_sstables > 0)
-    {
-        /* iterate over the sstables and free the resources */
-        for (int i = 0; i < tdb->column_families[index]->num_sstables; i++)
-            (void)_tidesdb_free_sstable(tdb->column_families[index]->sstables[i]);
+    if (rc == -1) (void)_tidesdb_release_version(version);
 
-        /* free the sstables array */
-        free(tdb->column_families[index]->sstables);
-    }
+    return rc;
+}
+
+int _tidesdb_open_wal(const char *cf_path, int shard, tidesdb_wal_t **w, bool compress,
+                      tidesdb_compression_algo_t compress_algo)
+{
+    if (cf_path == NULL) return -1;
 
-    /* close the wal */
-    (void)_tidesdb_close_wal(tdb->column_families[index]->wal);
+    /* we check if wal is NULL */
+    if (w == NULL) return -1;
 
-    /* wal path */
+    /* the first shard keeps the original wal name so single shard column families are unchanged
+     * other shards suffix it with their index */
     char wal_path[MAX_FILE_PATH_LENGTH];
+    if (shard == 0)
+        (void)snprintf(wal_path, sizeof(wal_path), "%s%s%s", cf_path,
+                       _tidesdb_get_path_seperator(), TDB_WAL_EXT);
+    else
+        (void)snprintf(wal_path, sizeof(wal_path), "%s%s%s.%d", cf_path,
+                       _tidesdb_get_path_seperator(), TDB_WAL_EXT, shard);
 
-    snprintf(wal_path, sizeof(wal_path), "%s%s%s", tdb->column_families[index]->path,
-             _tidesdb_get_path_seperator(), TDB_WAL_EXT);
-
-    /* remove the wal file */
-    if (unlink(wal_path) == -1)
+    block_manager_t *wal_block_manager = NULL;
+    if (block_manager_open(&wal_block_manager, wal_path, TDB_SYNC_INTERVAL) == -1)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_RM_FAILED, wal_path);
+        return -1;
     }
+    (*w)->compress = compress;
+    (*w)->compress_algo = compress_algo;
 
-    (void)remove(wal_path); /*incase */
-
-    (void)skip_list_destroy(tdb->column_families[index]->memtable);
-
-    /* remove all files in the column family directory */
-    (void)_tidesdb_remove_directory(tdb->column_families[index]->path);
+    (*w)->block_manager = wal_block_manager;
 
-    free(tdb->column_families[index]->sstables);
-    free(tdb->column_families[index]->path);
+    return 0;
+}
 
-    free(tdb->column_families[index]);
+int _tidesdb_add_column_family(tidesdb_t *tdb, tidesdb_column_family_t *cf)
+{
+    /* we check if tdb or cf is NULL */
+    if (tdb == NULL || cf == NULL) return -1;
 
-    /* reallocate memory for the column families array */
-    if (tdb->num_column_families > 1)
+    if (tdb->column_families == NULL)
     {
-        for (int i = index; i < tdb->num_column_families - 1; i++)
-            tdb->column_families[i] = tdb->column_families[i + 1];
-
-        tdb->num_column_families--;
-        tidesdb_column_family_t **temp_families = realloc(
-            tdb->column_families, tdb->num_column_families * sizeof(tidesdb_column_family_t *));
-        if (temp_families == NULL)
+        tdb->column_families = malloc(sizeof(tidesdb_column_family_t *));
+        if (tdb->column_families == NULL)
         {
-            return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "column families");
+            return -1;
         }
-
-        tdb->column_families = temp_families;
     }
     else
     {
-        /* free the column families array */
-        free(tdb->column_families);
-        tdb->num_column_families = 0;
-        tdb->column_families = NULL;
+        tidesdb_column_family_t **temp_families =
+            realloc(tdb->column_families,
+                    sizeof(tidesdb_column_family_t *) * (tdb->num_column_families + 1));
+        /* we check if the reallocation was successful */
+        if (temp_families == NULL)
+        {
+            return -1;
+        }
+
+        tdb->column_families = temp_families;
     }
 
-    return NULL;
+    /* we increment the number of column families */
+    tdb->num_column_families++;
+
+    cf->tdb = tdb;
+    cf->cache_id = atomic_fetch_add(&tdb->next_cache_id, 1);
+
+    /* we add the column family */
+    tdb->column_families[tdb->num_column_families - 1] = cf;
+
+    /* the wal syncs are traced once the column family knows its database */
+    if (tdb->config.trace != NULL)
+        for (int i = 0; i < cf->config.memtable_shards; i++)
+            (void)block_manager_set_sync_hook(cf->shards[i].wal->block_manager,
+                                              _tidesdb_wal_sync_hook, cf);
+
+    return 0;
 }
 
-int _tidesdb_remove_directory(const char *path)
+int _tidesdb_open_shards(tidesdb_column_family_t *cf)
 {
-    /* we could rework to remove recursion and use a stack-iterative approach */
-    struct dirent *entry;
-    struct stat statbuf;
-    char fullpath[MAX_FILE_PATH_LENGTH];
-    DIR *dir;
+    /* we allocate the shards */
+    cf->shards = calloc(cf->config.memtable_shards, sizeof(tidesdb_memtable_shard_t));
+    if (cf->shards == NULL) return -1;
 
-    dir = opendir(path);
-    if (!dir)
+    /* we initialize the shard locks first so the shards can always be closed as a whole */
+    for (int i = 0; i < cf->config.memtable_shards; i++)
     {
-        return -1;
+        if (pthread_rwlock_init(&cf->shards[i].rwlock, NULL) != 0)
+        {
+            for (int j = 0; j < i; j++) (void)pthread_rwlock_destroy(&cf->shards[j].rwlock);
+            free(cf->shards);
+            cf->shards = NULL;
+            return -1;
+        }
     }
 
-    while ((entry = readdir(dir)) != NULL)
+    for (int i = 0; i < cf->config.memtable_shards; i++)
     {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        tidesdb_memtable_shard_t *shard = &cf->shards[i];
+
+        /* we create the memtable for the shard */
+        switch (cf->config.memtable_ds)
         {
-            continue;
+            case TDB_MEMTABLE_SKIP_LIST:
+                shard->memtable = skip_list_new(cf->config.max_level, cf->config.probability);
+                break;
+            case TDB_MEMTABLE_HASH_TABLE:
+                (void)hash_table_new((hash_table_t **)&shard->memtable);
+                break;
+            default:
+                break;
         }
 
-        snprintf(fullpath, sizeof(fullpath), "%s%s%s", path, _tidesdb_get_path_seperator(),
-                 entry->d_name);
-        if (stat(fullpath, &statbuf) == -1)
+        if (shard->memtable == NULL)
         {
-            (void)closedir(dir);
+            (void)_tidesdb_close_shards(cf);
             return -1;
         }
 
-        if (S_ISDIR(statbuf.st_mode))
+        /* we open the wal for the shard */
+        shard->wal = calloc(1, sizeof(tidesdb_wal_t));
+        if (shard->wal == NULL)
         {
-            /* should maybe try to avoid recursion :) */
-            if (_tidesdb_remove_directory(fullpath) == -1)
-            {
-                (void)closedir(dir);
-                return -1;
-            }
-            /* remove the directory */
-            (void)rmdir(fullpath);
+            (void)_tidesdb_close_shards(cf);
+            return -1;
         }
-        else
+
+        if (_tidesdb_open_wal(cf->path, i, &shard->wal, cf->config.compressed,
+                              cf->config.compress_algo) == -1)
         {
-            if (unlink(fullpath) == -1)
-            {
-                (void)closedir(dir);
-                return -1;
-            }
+            (void)_tidesdb_close_shards(cf);
+            return -1;
         }
+
+        shard->wal->stats = cf->stats;
     }
 
-    (void)closedir(dir);
-    (void)rmdir(path); /* in case */
     return 0;
 }
 
-int _tidesdb_new_column_family(const char *db_path, const char *name, int flush_threshold,
-                               int max_level, float probability, tidesdb_column_family_t **cf,
-                               bool compressed, tidesdb_compression_algo_t compress_algo,
-                               bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+void _tidesdb_close_shards(tidesdb_column_family_t *cf)
 {
-    /* we allocate memory for the column family */
-    *cf = malloc(sizeof(tidesdb_column_family_t));
-
-    /* we check if allocation was successful */
-    if (*cf == NULL) return -1;
+    if (cf->shards == NULL) return;
 
-    /* we copy the name */
-    (*cf)->config.name = strdup(name);
-
-    /* we check if the name was copied */
-    if ((*cf)->config.name == NULL)
+    for (int i = 0; i < cf->config.memtable_shards; i++)
     {
-        free(*cf);
-        return -1;
-    }
-
-    /* we set the flush threshold */
-    (*cf)->config.flush_threshold = flush_threshold;
-
-    /* we set the compression algorithm */
-    (*cf)->config.compress_algo = compress_algo;
-
-    /* we set the max level */
-    (*cf)->config.max_level = max_level;
+        tidesdb_memtable_shard_t *shard = &cf->shards[i];
 
-    /* we set the probability */
-    (*cf)->config.probability = probability;
+        /* we free the memtable */
+        if (shard->memtable != NULL)
+        {
+            switch (cf->config.memtable_ds)
+            {
+                case TDB_MEMTABLE_SKIP_LIST:
+                    (void)skip_list_destroy(shard->memtable);
+                    break;
+                case TDB_MEMTABLE_HASH_TABLE:
+                    (void)hash_table_destroy(shard->memtable);
+                    break;
+                default:
+                    break;
+            }
+            shard->memtable = NULL;
+        }
 
-    /* set compressed to false */
-    (*cf)->config.compressed = compressed;
+        /* we close the wal, it flushes on close */
+        if (shard->wal != NULL)
+        {
+            (void)_tidesdb_close_wal(shard->wal);
+            shard->wal = NULL;
+        }
 
-    /* set bloom filter to false */
-    (*cf)->config.bloom_filter = bloom_filter;
+        (void)pthread_rwlock_destroy(&shard->rwlock);
+    }
 
-    /* set memtable data structure */
-    (*cf)->config.memtable_ds = memtable_ds;
+    free(cf->shards);
+    cf->shards = NULL;
+}
 
-    if (pthread_rwlock_init(&(*cf)->rwlock, NULL) != 0)
-    {
-        free((*cf)->config.name);
-        free(*cf);
-        return -1;
-    }
+tidesdb_memtable_shard_t *_tidesdb_get_shard(tidesdb_column_family_t *cf, const uint8_t *key,
+                                             size_t key_size)
+{
+    if (cf->config.memtable_shards == 1) return &cf->shards[0];
 
-    /* we construct the path to the column family */
-    char cf_path[MAX_FILE_PATH_LENGTH];
+    /* we hash with a seed of our own so the shard doesn't correlate with hash table buckets */
+    unsigned int hash = bloom_filter_hash(key, key_size, TDB_MEMTABLE_SHARD_SEED);
+    return &cf->shards[hash % (unsigned int)cf->config.memtable_shards];
+}
 
-    /* we use snprintf to construct the path */
-    (void)snprintf(cf_path, sizeof(cf_path), "%s%s%s", db_path, _tidesdb_get_path_seperator(),
-                   name);
+int _tidesdb_memtable_put(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard,
+                          const uint8_t *key, size_t key_size, const uint8_t *value,
+                          size_t value_size, time_t ttl)
+{
+    size_t before = _tidesdb_memtable_size(cf, shard);
 
-    /* we check if the column family path exists */
-    if (access(cf_path, F_OK) == -1)
+    int rc;
+    switch (cf->config.memtable_ds)
     {
-        /* we create the directory */
-        if (mkdir(cf_path, 0777) == -1)
-        {
-            free((*cf)->config.name);
-            free(*cf);
+        case TDB_MEMTABLE_SKIP_LIST:
+            rc = skip_list_put(shard->memtable, key, key_size, value, value_size, ttl);
+            break;
+        case TDB_MEMTABLE_HASH_TABLE:
+            rc = hash_table_put((hash_table_t **)&shard->memtable, key, key_size, value,
+                                value_size, ttl);
+            break;
+        default:
             return -1;
-        }
     }
 
-    /* we create config file name
-     * each column family has a config file
-     * this contains a serialized version of the column family struct */
-    char config_file_name[MAX_FILE_PATH_LENGTH];
-
-    (void)snprintf(config_file_name, sizeof(config_file_name), "%s%s%s%s%s%s", db_path,
-                   _tidesdb_get_path_seperator(), name, _tidesdb_get_path_seperator(), name,
-                   TDB_COLUMN_FAMILY_CONFIG_FILE_EXT);
+    (void)_tidesdb_account_memtable(cf, before, _tidesdb_memtable_size(cf, shard));
 
-    /* now we serialize the column family struct */
-    size_t serialized_size;
-    uint8_t *serialized_cf =
-        _tidesdb_serialize_column_family_config(&(*cf)->config, &serialized_size);
-    if (serialized_cf == NULL)
-    {
-        free((*cf)->config.name);
-        free(*cf);
-        free(serialized_cf);
-        return -1;
-    }
+    /* the memtable now answers for the key, we drop its cached row.  wal replay on open finds
+     * the row cache still empty, its invalidations are harmless */
+    if (cf->tdb != NULL && cf->tdb->row_cache != NULL)
+        (void)row_cache_invalidate(cf->tdb->row_cache, cf->cache_id, key, key_size);
 
-    /* we open the config file (new file) */
-    FILE *config_file = fopen(config_file_name, "wb");
-    if (config_file == NULL)
-    {
-        free((*cf)->config.name);
-        free(*cf);
-        free(serialized_cf);
-        return -1;
-    }
+    return rc;
+}
 
-    /* we write the serialized column family struct to the config file */
-    if (fwrite(serialized_cf, serialized_size, 1, config_file) != 1)
+int _tidesdb_memtable_get(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard,
+                          const uint8_t *key, size_t key_size, uint8_t **value, size_t *value_size)
+{
+    switch (cf->config.memtable_ds)
     {
-        free((*cf)->config.name);
-        free(*cf);
-        free(serialized_cf);
-        (void)fclose(config_file);
-        return -1;
+        case TDB_MEMTABLE_SKIP_LIST:
+            return skip_list_get(shard->memtable, key, key_size, value, value_size);
+        case TDB_MEMTABLE_HASH_TABLE:
+            return hash_table_get(shard->memtable, key, key_size, value, value_size);
+        default:
+            return -1;
     }
+}
 
-    /* sync the file */
-    (void)fflush(config_file);
-
-    /* we set the path */
-    (*cf)->path = strdup(cf_path);
-
-    /* we check if the path was copied */
-    if ((*cf)->path == NULL)
+size_t _tidesdb_memtable_size(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard)
+{
+    switch (cf->config.memtable_ds)
     {
-        free((*cf)->config.name);
-        free(*cf);
-        free(serialized_cf);
-        (void)fclose(config_file);
-        return -1;
+        case TDB_MEMTABLE_SKIP_LIST:
+            return ((skip_list_t *)shard->memtable)->total_size;
+        case TDB_MEMTABLE_HASH_TABLE:
+            return ((hash_table_t *)shard->memtable)->total_size;
+        default:
+            return 0;
     }
+}
 
-    /* we init sstables array and len */
-    (*cf)->num_sstables = 0;
-    (*cf)->sstables = NULL;
+int _tidesdb_memtable_clear(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard)
+{
+    size_t before = _tidesdb_memtable_size(cf, shard);
 
-    switch ((*cf)->config.memtable_ds)
+    int rc;
+    switch (cf->config.memtable_ds)
     {
         case TDB_MEMTABLE_SKIP_LIST:
-            (*cf)->memtable = skip_list_new((*cf)->config.max_level, (*cf)->config.probability);
+            rc = skip_list_clear(shard->memtable);
             break;
         case TDB_MEMTABLE_HASH_TABLE:
-            (void)hash_table_new((*cf)->memtable);
+            (void)hash_table_clear(shard->memtable);
+            rc = 0;
             break;
+        default:
+            return -1;
     }
 
-    /* we check if the memtable was created */
-    if ((*cf)->memtable == NULL)
-    {
-        free((*cf)->config.name);
-        free((*cf)->path);
-        free(*cf);
-        free(serialized_cf);
-        (void)fclose(config_file);
-        return -1;
-    }
+    (void)_tidesdb_account_memtable(cf, before, _tidesdb_memtable_size(cf, shard));
 
-    /* we free what we must */
-    free(serialized_cf);
-    (void)fclose(config_file);
+    return rc;
+}
+
+void _tidesdb_account_memtable(tidesdb_column_family_t *cf, size_t before, size_t after)
+{
+    if (after == before) return;
 
-    (*cf)->wal = malloc(sizeof(tidesdb_wal_t));
-    if ((*cf)->wal == NULL)
+    /* a dropped column family was already taken out of the database total */
+    _Atomic uint64_t *total = cf->tdb != NULL && !cf->dropped ? &cf->tdb->memtable_bytes : NULL;
+
+    if (after > before)
     {
-        free((*cf)->config.name);
-        free((*cf)->path);
-        free(*cf);
-        return -1;
+        (void)atomic_fetch_add(&cf->memtable_bytes, after - before);
+        if (total != NULL) (void)atomic_fetch_add(total, after - before);
     }
-
-    /* create wal */
-    if (_tidesdb_open_wal(cf_path, &(*cf)->wal, compressed, compress_algo) == -1)
+    else
     {
-        free((*cf)->config.name);
-        free((*cf)->path);
-        free(*cf);
-        return -1;
+        (void)atomic_fetch_sub(&cf->memtable_bytes, before - after);
+        if (total != NULL) (void)atomic_fetch_sub(total, before - after);
     }
-
-    return 0;
 }
 
-int _tidesdb_get_column_family(tidesdb_t *tdb, const char *name, tidesdb_column_family_t **cf)
+int _tidesdb_flush_over_budget(tidesdb_t *tdb)
 {
-    /* we check if tdb or name is NULL */
-    if (tdb == NULL || name == NULL) return -1;
+    if (tdb == NULL || tdb->config.write_buffer_budget <= 0) return 0;
 
-    if (tdb->num_column_families == 0)
-    {
-        return -1;
-    }
+    uint64_t budget = (uint64_t)tdb->config.write_buffer_budget;
+    if (atomic_load(&tdb->memtable_bytes) <= budget) return 0;
 
-    /* we iterate over the column families and return the one with the matching name */
+    /* we pick the column family holding the most, flushing it frees the most */
+    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0) return -1;
+
+    tidesdb_column_family_t *largest = NULL;
+    uint64_t largest_bytes = 0;
     for (int i = 0; i < tdb->num_column_families; i++)
     {
-        if (strcmp(tdb->column_families[i]->config.name, name) == 0)
+        uint64_t bytes = atomic_load(&tdb->column_families[i]->memtable_bytes);
+        if (bytes > largest_bytes)
         {
-            /* match on name we return the column family */
-            *cf = tdb->column_families[i];
-
-            return 0;
+            largest = tdb->column_families[i];
+            largest_bytes = bytes;
         }
     }
 
-    return -1; /* no column family with that name */
-}
+    if (largest != NULL) (void)_tidesdb_ref_column_family(largest);
 
-char *tidesdb_list_column_families(tidesdb_t *tdb)
-{
-    if (tdb == NULL) return NULL;
+    (void)pthread_rwlock_unlock(&tdb->rwlock);
 
-    /* get read lock for database */
-    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0) return NULL;
+    if (largest == NULL) return 0;
 
-    size_t total_size = 1; /* +1 for null terminator */
-    for (int i = 0; i < tdb->num_column_families; i++)
+    if (pthread_rwlock_wrlock(&largest->rwlock) != 0)
     {
-        total_size += strlen(tdb->column_families[i]->config.name) + 1; /* +1 for newline */
+        (void)_tidesdb_release_column_family(largest);
+        return -1;
     }
 
-    char *list = malloc(total_size);
-    if (list == NULL) return NULL;
-
-    list[0] = '\0'; /* null terminate the string */
-
-    for (int i = 0; i < tdb->num_column_families; i++)
+    /* another writer may have flushed while we waited on the lock so we check again */
+    int rc = 0;
+    tidesdb_flush_info_t info;
+    bool flushed = !largest->dropped && atomic_load(&tdb->memtable_bytes) > budget &&
+                   atomic_load(&largest->memtable_bytes) > 0;
+    if (flushed)
     {
-        strcat(list, tdb->column_families[i]->config.name);
-        strcat(list, "\n");
+        rc = _tidesdb_flush_memtable(largest, &info);
+        if (rc == 0) (void)_tidesdb_stats_add(largest->stats, TDB_STAT_BUDGET_FLUSHES, 1);
     }
 
-    /* release the read lock */
-    if (pthread_rwlock_unlock(&tdb->rwlock) != 0)
-    {
-        free(list);
-        return NULL;
-    }
+    (void)pthread_rwlock_unlock(&largest->rwlock);
 
-    return list;
+    if (flushed) (void)_tidesdb_report_flush(largest, &info);
+    (void)_tidesdb_release_column_family(largest);
+
+    return rc;
 }
 
-tidesdb_err_t *tidesdb_put(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
-                           size_t key_size, const uint8_t *value, size_t value_size, time_t ttl)
+bool _tidesdb_shard_full(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard)
 {
-    /* we check if the db is NULL */
-    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+    /* each shard gets an equal part of the flush threshold, keys are spread evenly by hash */
+    size_t threshold = (size_t)cf->config.flush_threshold / (size_t)cf->config.memtable_shards;
+    return _tidesdb_memtable_size(cf, shard) >= threshold;
+}
 
-    /* we check if the column family name is NULL */
-    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+bool _tidesdb_any_shard_full(tidesdb_column_family_t *cf)
+{
+    for (int i = 0; i < cf->config.memtable_shards; i++)
+        if (_tidesdb_shard_full(cf, &cf->shards[i])) return true;
 
-    /* we check if the key is NULL */
-    if (key == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_KEY);
+    return false;
+}
 
-    /* we check if the value is NULL */
-    if (value == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_VALUE);
+int _tidesdb_memtable_copy_into(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard,
+                                skip_list_t *list)
+{
+    uint8_t *key;
+    size_t key_size;
+    uint8_t *value;
+    size_t value_size;
+    time_t ttl;
 
-    /* get db read lock for column family */
-    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0)
+    switch (cf->config.memtable_ds)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
-    }
+        case TDB_MEMTABLE_SKIP_LIST:
+        {
+            skip_list_cursor_t *cursor = skip_list_cursor_init(shard->memtable);
+            if (cursor == NULL) return -1;
 
-    /* get column family */
-    tidesdb_column_family_t *cf = NULL;
-    if (_tidesdb_get_column_family(tdb, column_family_name, &cf) == -1)
-    {
-        (void)pthread_rwlock_unlock(&tdb->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
-    }
+            do
+            {
+                if (skip_list_cursor_get(cursor, &key, &key_size, &value, &value_size, &ttl) != 0)
+                    continue;
 
-    /* release db read lock */
-    if (pthread_rwlock_unlock(&tdb->rwlock) != 0)
-    {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "db");
+                if (skip_list_put(list, key, key_size, value, value_size, ttl) == -1)
+                {
+                    (void)skip_list_cursor_free(cursor);
+                    return -1;
+                }
+            } while (skip_list_cursor_next(cursor) == 0);
+
+            (void)skip_list_cursor_free(cursor);
+            return 0;
+        }
+        case TDB_MEMTABLE_HASH_TABLE:
+        {
+            hash_table_cursor_t *cursor = hash_table_cursor_new(shard->memtable);
+            if (cursor == NULL) return -1;
+
+            do
+            {
+                if (hash_table_cursor_get(cursor, &key, &key_size, &value, &value_size, &ttl) != 0)
+                    continue;
+
+                if (skip_list_put(list, key, key_size, value, value_size, ttl) == -1)
+                {
+                    (void)hash_table_cursor_destroy(cursor);
+                    return -1;
+                }
+            } while (hash_table_cursor_next(cursor) == 0);
+
+            (void)hash_table_cursor_destroy(cursor);
+            return 0;
+        }
+        default:
+            return -1;
     }
+}
 
-    /* get column family write lock */
-    if (pthread_rwlock_wrlock(&cf->rwlock) != 0)
+skip_list_t *_tidesdb_memtable_snapshot(tidesdb_column_family_t *cf)
+{
+    /* we merge every shard into a single sorted skip list */
+    skip_list_t *list = skip_list_new(cf->config.max_level, cf->config.probability);
+    if (list == NULL) return NULL;
+
+    for (int i = 0; i < cf->config.memtable_shards; i++)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
+        tidesdb_memtable_shard_t *shard = &cf->shards[i];
+
+        (void)pthread_rwlock_rdlock(&shard->rwlock);
+        int rc = _tidesdb_memtable_copy_into(cf, shard, list);
+        (void)pthread_rwlock_unlock(&shard->rwlock);
+
+        if (rc == -1)
+        {
+            (void)skip_list_destroy(list);
+            return NULL;
+        }
     }
 
-    /* we append to the wal */
-    if (_tidesdb_append_to_wal(cf->wal, key, key_size, value, value_size, ttl, TIDESDB_OP_PUT,
-                               column_family_name) == -1)
+    return list;
+}
+
+int _tidesdb_flush_memtable_if_full(tidesdb_column_family_t *cf)
+{
+    /* we take the column family exclusively so no writer is in any shard */
+    if (pthread_rwlock_wrlock(&cf->rwlock) != 0) return -1;
+
+    /* another writer may have flushed while we waited on the lock so we check again */
+    int rc = 0;
+    tidesdb_flush_info_t info;
+    bool flushed = !cf->dropped && _tidesdb_any_shard_full(cf);
+    if (flushed) rc = _tidesdb_flush_memtable(cf, &info);
+
+    (void)pthread_rwlock_unlock(&cf->rwlock);
+
+    if (flushed) (void)_tidesdb_report_flush(cf, &info);
+
+    return rc;
+}
+
+int _tidesdb_replay_from_wal(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard)
+{
+    /* we simply create a block manager cursor, deserialize operations and replay them on the
+     * shard memtable */
+    block_manager_cursor_t *cursor = NULL;
+
+    /* initialize the cursor */
+    if (block_manager_cursor_init(&cursor, shard->wal->block_manager) == -1)
     {
-        (void)pthread_rwlock_unlock(&cf->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_APPEND_TO_WAL);
+        return -1;
     }
 
-    /* we determine the data structure to use */
-    switch (cf->config.memtable_ds)
+    do /* we iterate over the wal */
     {
-        case TDB_MEMTABLE_SKIP_LIST:
-            /* put in memtable */
-            if (skip_list_put(cf->memtable, key, key_size, value, value_size, ttl) == -1)
-            {
-                (void)pthread_rwlock_unlock(&cf->rwlock);
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_PUT_TO_MEMTABLE);
-            }
+        /* we read the block */
+        block_manager_block_t *block = block_manager_cursor_read(cursor);
+        if (block == NULL) break;
 
-            /* we check if the memtable has reached the flush threshold */
-            if ((int)((skip_list_t *)cf->memtable)->total_size >= cf->config.flush_threshold)
-            {
-                if (cf->config.bloom_filter)
-                {
-                    if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter_f_hash_table(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-                else
-                {
-                    if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_f_hash_table(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-            }
+        /* we deserialize the operation */
+        tidesdb_operation_t *op = _tidesdb_deserialize_operation(
+            block->data, block->size, cf->config.compressed, cf->config.compress_algo);
+        if (op == NULL)
+        {
+            free(block);
             break;
-        case TDB_MEMTABLE_HASH_TABLE:
-            /* put in memtable */
-            if (hash_table_put(cf->memtable, key, key_size, value, value_size, ttl) == -1)
-            {
-                (void)pthread_rwlock_unlock(&cf->rwlock);
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_PUT_TO_MEMTABLE);
-            }
+        }
 
-            /* we check if the memtable has reached the flush threshold */
-            if ((int)((hash_table_t *)cf->memtable)->total_size >= cf->config.flush_threshold)
+        switch (op->op_code)
+        {
+            case TIDESDB_OP_PUT:
+                (void)_tidesdb_memtable_put(cf, shard, op->kv->key, op->kv->key_size,
+                                            op->kv->value, op->kv->value_size, op->kv->ttl);
+                break;
+            case TIDESDB_OP_DELETE:
             {
-                if (cf->config.bloom_filter)
-                {
-                    if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter_f_hash_table(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-                else
-                {
-                    if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_f_hash_table(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
+                /* a tombstone never expires, the same as when the delete was first applied */
+                uint32_t tombstone = TOMBSTONE;
+                (void)_tidesdb_memtable_put(cf, shard, op->kv->key, op->kv->key_size,
+                                            (uint8_t *)&tombstone, 4, -1);
             }
             break;
-        default:
-            if (pthread_rwlock_unlock(&cf->rwlock) != 0)
-            {
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
-            }
+            default:
+                break;
+        }
+
+        (void)block_manager_block_free(block);
+
+        /* we free the operation */
+        (void)_tidesdb_free_operation(op);
+
+    } while (block_manager_cursor_next(cursor) != -1);
+
+    (void)block_manager_cursor_free(cursor);
+
+    return 0;
+}
+
+tidesdb_err_t *tidesdb_create_column_family(tidesdb_t *tdb, const char *name, int flush_threshold,
+                                            int max_level, float probability, bool compressed,
+                                            tidesdb_compression_algo_t compression_algo,
+                                            bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    /* a single shard keeps one memtable and one wal for the column family */
+    return tidesdb_create_column_family_w_shards(tdb, name, flush_threshold, max_level,
+                                                 probability, compressed, compression_algo,
+                                                 bloom_filter, memtable_ds, 1);
+}
+
+tidesdb_err_t *tidesdb_create_column_family_w_shards(tidesdb_t *tdb, const char *name,
+                                                     int flush_threshold, int max_level,
+                                                     float probability, bool compressed,
+                                                     tidesdb_compression_algo_t compression_algo,
+                                                     bool bloom_filter,
+                                                     tidesdb_memtable_ds_t memtable_ds,
+                                                     int memtable_shards)
+{
+    tidesdb_column_family_config_t config = {.name = (char *)name,
+                                             .flush_threshold = flush_threshold,
+                                             .max_level = max_level,
+                                             .probability = probability,
+                                             .compressed = compressed,
+                                             .compress_algo = compression_algo,
+                                             .memtable_ds = memtable_ds,
+                                             .bloom_filter = bloom_filter,
+                                             .memtable_shards = memtable_shards,
+                                             .filter_type = TDB_FILTER_BLOOM,
+                                             .partitioned_index = false,
+                                             .hash_index = false,
+                                             .learned_index = false};
+
+    return tidesdb_create_column_family_w_config(tdb, &config);
+}
+
+tidesdb_err_t *tidesdb_create_column_family_w_config(tidesdb_t *tdb,
+                                                     const tidesdb_column_family_config_t *config)
+{
+    /* we check if the config is NULL */
+    if (config == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    const char *name = config->name;
+    int flush_threshold = config->flush_threshold;
+    int max_level = config->max_level;
+    float probability = config->probability;
+    bool compressed = config->compressed;
+    tidesdb_compression_algo_t compression_algo = config->compress_algo;
+    bool bloom_filter = config->bloom_filter;
+    tidesdb_memtable_ds_t memtable_ds = config->memtable_ds;
+    int memtable_shards = config->memtable_shards;
+
+    /* verify the compression algorithm */
+    if (compressed && compression_algo == TDB_NO_COMPRESSION)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COMPRESSION_ALGO);
+
+    /* we check if the db is NULL */
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    /* we check if the name is NULL */
+    if (name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_NAME, "column family");
+
+    /* we check if the column family name is greater than 2 */
+    if (strlen(name) < 2) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_NAME, "column family");
+
+    /* we check flush threshold
+     * the system expects at least TDB_FLUSH_THRESHOLD threshold */
+    if (flush_threshold < TDB_FLUSH_THRESHOLD)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_FLUSH_THRESHOLD);
+
+    /* only if the memtable data structure is skip list
+     * we check max level and probability */
+    if (memtable_ds == TDB_MEMTABLE_SKIP_LIST)
+    {
+        /* we check max level
+         * the system expects at least a level of TDB_MIN_MAX_LEVEL */
+        if (max_level < TDB_MIN_MAX_LEVEL)
+            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_MAX_LEVEL);
+
+        /* we check probability
+         * the system expects at least a probability of TDB_MIN_PROBABILITY */
+        if (probability < TDB_MIN_PROBABILITY)
+            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_PROBABILITY);
+    }
+
+    /* we check the number of memtable shards */
+    if (memtable_shards < 1 || memtable_shards > TDB_MAX_MEMTABLE_SHARDS)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    /* we check the filter type */
+    if (config->filter_type != TDB_FILTER_BLOOM && config->filter_type != TDB_FILTER_BINARY_FUSE)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    /* the hash and learned indexes belong to the partitions of a partitioned sstable */
+    if ((config->hash_index || config->learned_index) && !config->partitioned_index)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    tidesdb_column_family_t *cf = NULL;
+    if (_tidesdb_new_column_family(tdb->directory, name, flush_threshold, max_level, probability,
+                                   &cf, compressed, compression_algo, bloom_filter, memtable_ds,
+                                   memtable_shards, config->filter_type,
+                                   config->partitioned_index, config->hash_index,
+                                   config->learned_index) == -1)
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_CREATE_COLUMN_FAMILY);
+
+    /* we get the db write lock as we are modifying the column families array */
+    if (pthread_rwlock_wrlock(&tdb->rwlock) != 0)
+    {
+        (void)_tidesdb_release_column_family(cf);
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
+    }
+
+    /* now we add the column family */
+    if (_tidesdb_add_column_family(tdb, cf) == -1)
+    {
+        (void)pthread_rwlock_unlock(&tdb->rwlock);
+        (void)_tidesdb_release_column_family(cf);
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ADD_COLUMN_FAMILY);
+    }
+
+    (void)pthread_rwlock_unlock(&tdb->rwlock);
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_drop_column_family(tidesdb_t *tdb, const char *name)
+{
+    /* check if either tdb or name is NULL */
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    if (name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_NAME, "column family");
+
+    /* we get the db write lock as we are modifying the column families array */
+    if (pthread_rwlock_wrlock(&tdb->rwlock) != 0)
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
+
+    /* iterate over the column families to find the one to remove */
+    int index = -1;
+    for (int i = 0; i < tdb->num_column_families; i++)
+    {
+        if (strcmp(tdb->column_families[i]->config.name, name) == 0)
+        {
+            index = i;
+            break;
+        }
+    }
+
+    if (index == -1)
+    {
+        (void)pthread_rwlock_unlock(&tdb->rwlock);
+        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+    }
+
+    tidesdb_column_family_t *cf = tdb->column_families[index];
+
+    /* we remove the column family from the column families array */
+    if (tdb->num_column_families > 1)
+    {
+        for (int i = index; i < tdb->num_column_families - 1; i++)
+            tdb->column_families[i] = tdb->column_families[i + 1];
+
+        tdb->num_column_families--;
+        tidesdb_column_family_t **temp_families = realloc(
+            tdb->column_families, tdb->num_column_families * sizeof(tidesdb_column_family_t *));
+        if (temp_families != NULL) tdb->column_families = temp_families;
+    }
+    else
+    {
+        /* free the column families array */
+        free(tdb->column_families);
+        tdb->num_column_families = 0;
+        tdb->column_families = NULL;
+    }
+
+    /* release the db write lock */
+    (void)pthread_rwlock_unlock(&tdb->rwlock);
+
+    /* we mark the column family as dropped under its write lock
+     * once we hold it no operation is in flight and all later ones will see the flag */
+    if (pthread_rwlock_wrlock(&cf->rwlock) != 0)
+    {
+        (void)_tidesdb_release_column_family(cf);
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
+    }
+
+    /* compaction checks the flag under the version lock before it installs its outputs, the
+     * last release of an obsolete sstable under the file lock before it removes its file */
+    (void)pthread_mutex_lock(&cf->version_lock);
+    (void)pthread_mutex_lock(&cf->file_lock);
+    cf->dropped = true;
+    (void)pthread_mutex_unlock(&cf->file_lock);
+    (void)pthread_mutex_unlock(&cf->version_lock);
+
+    /* its memtables no longer count against the write buffer budget */
+    (void)atomic_fetch_sub(&tdb->memtable_bytes, atomic_load(&cf->memtable_bytes));
+
+    /* nor its rows against the row cache, a get reading its sstables right now won't cache its row
+     * either as every shard of the cache is invalidated */
+    if (tdb->row_cache != NULL) (void)row_cache_invalidate_owner(tdb->row_cache, cf->cache_id);
+
+    (void)pthread_rwlock_unlock(&cf->rwlock);
+
+    /* a compaction in flight still writes its outputs and the manifest into the directory, we
+     * wait for it to finish, it sees the flag and removes its outputs instead of installing them.
+     * flushes and writes check the flag under the column family lock so nothing else writes */
+    (void)pthread_mutex_lock(&cf->compaction_lock);
+
+    /* remove all files in the column family directory
+     * open wal and sstable files are closed once the last reference goes away */
+    int rm = _tidesdb_remove_directory(cf->path);
+
+    (void)pthread_mutex_unlock(&cf->compaction_lock);
+
+    /* we release the reference the db held, handles, transactions and cursors may
+     * still hold theirs in which case the last one to release frees the column family */
+    (void)_tidesdb_release_column_family(cf);
+
+    if (rm == -1) return tidesdb_err_from_code(TIDESDB_ERR_RM_FAILED, "column family directory");
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_get_cf_handle(tidesdb_t *tdb, const char *column_family_name,
+                                     tidesdb_cf_handle_t **handle)
+{
+    /* we check if the db is NULL */
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    /* we check if the column family name is NULL */
+    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    /* we check if the handle is NULL */
+    if (handle == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    *handle = malloc(sizeof(tidesdb_cf_handle_t));
+    if (*handle == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "column family handle");
+
+    /* we look up the column family once, the handle keeps the reference */
+    tidesdb_column_family_t *cf = NULL;
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family_name, &cf);
+    if (e != NULL)
+    {
+        free(*handle);
+        *handle = NULL;
+        return e;
+    }
+
+    (*handle)->tdb = tdb;
+    (*handle)->cf = cf;
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_release_cf_handle(tidesdb_cf_handle_t *handle)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    /* we release the handle's reference on the column family */
+    if (handle->cf != NULL) (void)_tidesdb_release_column_family(handle->cf);
+
+    free(handle);
+    handle = NULL;
+
+    return NULL;
+}
+
+tidesdb_err_t *_tidesdb_acquire_column_family(tidesdb_t *tdb, const char *name,
+                                              tidesdb_column_family_t **cf)
+{
+    /* get db read lock to get column family */
+    uint64_t lock_wait = _tidesdb_perf_start();
+    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0)
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
+    (void)_tidesdb_perf_stop(TDB_PERF_DB_LOCK_WAIT, lock_wait);
+
+    if (_tidesdb_get_column_family(tdb, name, cf) == -1)
+    {
+        (void)pthread_rwlock_unlock(&tdb->rwlock);
+        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+    }
+
+    /* we take the reference before releasing the db lock so a concurrent drop can't free it */
+    (void)_tidesdb_ref_column_family(*cf);
+
+    /* release db read lock */
+    (void)pthread_rwlock_unlock(&tdb->rwlock);
+
+    return NULL;
+}
+
+void _tidesdb_ref_column_family(tidesdb_column_family_t *cf)
+{
+    (void)atomic_fetch_add_explicit(&cf->refcount, 1, memory_order_relaxed);
+}
+
+void _tidesdb_release_column_family(tidesdb_column_family_t *cf)
+{
+    /* the last reference frees the column family */
+    if (atomic_fetch_sub_explicit(&cf->refcount, 1, memory_order_acq_rel) == 1)
+        (void)_tidesdb_free_column_family(cf);
+}
+
+void _tidesdb_free_column_family(tidesdb_column_family_t *cf)
+{
+    if (cf == NULL) return;
+
+    /* we free the memtables and close the wals, wals flush on close.  until the wal sync threads
+     * are stopped their trace hook may still read the column family name */
+    (void)_tidesdb_close_shards(cf);
+
+    if (cf->config.name != NULL) free(cf->config.name);
+
+    if (cf->path != NULL) free(cf->path);
+
+    /* we release the current version which closes its sstables */
+    if (cf->version != NULL)
+    {
+        (void)_tidesdb_release_version(cf->version);
+        cf->version = NULL;
+    }
+
+    (void)pthread_rwlock_destroy(&cf->rwlock);
+    (void)pthread_mutex_destroy(&cf->version_lock);
+    (void)pthread_cond_destroy(&cf->version_cond);
+    (void)pthread_mutex_destroy(&cf->compaction_lock);
+    (void)pthread_mutex_destroy(&cf->file_lock);
+
+    free(cf->stats);
+
+    /* we free the column family */
+    free(cf);
+}
+
+int _tidesdb_remove_directory(const char *path)
+{
+    /* we could rework to remove recursion and use a stack-iterative approach */
+    struct dirent *entry;
+    struct stat statbuf;
+    char fullpath[MAX_FILE_PATH_LENGTH];
+    DIR *dir;
+
+    dir = opendir(path);
+    if (!dir)
+    {
+        return -1;
+    }
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        snprintf(fullpath, sizeof(fullpath), "%s%s%s", path, _tidesdb_get_path_seperator(),
+                 entry->d_name);
+        if (stat(fullpath, &statbuf) == -1)
+        {
+            (void)closedir(dir);
+            return -1;
+        }
+
+        if (S_ISDIR(statbuf.st_mode))
+        {
+            /* should maybe try to avoid recursion :) */
+            if (_tidesdb_remove_directory(fullpath) == -1)
+            {
+                (void)closedir(dir);
+                return -1;
+            }
+            /* remove the directory */
+            (void)rmdir(fullpath);
+        }
+        else
+        {
+            if (unlink(fullpath) == -1)
+            {
+                (void)closedir(dir);
+                return -1;
+            }
+        }
+    }
+
+    (void)closedir(dir);
+    (void)rmdir(path); /* in case */
+    return 0;
+}
+
+int _tidesdb_new_column_family(const char *db_path, const char *name, int flush_threshold,
+                               int max_level, float probability, tidesdb_column_family_t **cf,
+                               bool compressed, tidesdb_compression_algo_t compress_algo,
+                               bool bloom_filter, tidesdb_memtable_ds_t memtable_ds,
+                               int memtable_shards, tidesdb_filter_type_t filter_type,
+                               bool partitioned_index, bool hash_index, bool learned_index)
+{
+    /* we allocate memory for the column family */
+    *cf = malloc(sizeof(tidesdb_column_family_t));
+
+    /* we check if allocation was successful */
+    if (*cf == NULL) return -1;
+
+    (*cf)->tdb = NULL; /* set when the column family is added */
+
+    /* we copy the name */
+    (*cf)->config.name = strdup(name);
+
+    /* we check if the name was copied */
+    if ((*cf)->config.name == NULL)
+    {
+        free(*cf);
+        return -1;
+    }
+
+    /* we set the flush threshold */
+    (*cf)->config.flush_threshold = flush_threshold;
+
+    /* we set the compression algorithm */
+    (*cf)->config.compress_algo = compress_algo;
+
+    /* we set the max level */
+    (*cf)->config.max_level = max_level;
+
+    /* we set the probability */
+    (*cf)->config.probability = probability;
+
+    /* set compressed to false */
+    (*cf)->config.compressed = compressed;
+
+    /* set bloom filter to false */
+    (*cf)->config.bloom_filter = bloom_filter;
+
+    /* set memtable data structure */
+    (*cf)->config.memtable_ds = memtable_ds;
+
+    /* set the amount of memtable shards */
+    (*cf)->config.memtable_shards = memtable_shards;
+
+    /* set the kind of sstable filter */
+    (*cf)->config.filter_type = filter_type;
+
+    /* set whether sstables are partitioned under a top level index */
+    (*cf)->config.partitioned_index = partitioned_index;
+
+    /* set whether the partitions get hash indexes */
+    (*cf)->config.hash_index = hash_index;
+
+    /* set whether the partitions get learned indexes */
+    (*cf)->config.learned_index = learned_index;
+    (*cf)->shards = NULL;
+
+    if (pthread_rwlock_init(&(*cf)->rwlock, NULL) != 0)
+    {
+        free((*cf)->config.name);
+        free(*cf);
+        return -1;
+    }
+
+    /* we construct the path to the column family */
+    char cf_path[MAX_FILE_PATH_LENGTH];
+
+    /* we use snprintf to construct the path */
+    (void)snprintf(cf_path, sizeof(cf_path), "%s%s%s", db_path, _tidesdb_get_path_seperator(),
+                   name);
+
+    /* we check if the column family path exists */
+    if (access(cf_path, F_OK) == -1)
+    {
+        /* we create the directory */
+        if (mkdir(cf_path, 0777) == -1)
+        {
+            (void)pthread_rwlock_destroy(&(*cf)->rwlock);
+            free((*cf)->config.name);
+            free(*cf);
+            return -1;
+        }
+    }
+
+    /* we create config file name
+     * each column family has a config file
+     * this contains a serialized version of the column family struct */
+    char config_file_name[MAX_FILE_PATH_LENGTH];
+
+    (void)snprintf(config_file_name, sizeof(config_file_name), "%s%s%s%s%s%s", db_path,
+                   _tidesdb_get_path_seperator(), name, _tidesdb_get_path_seperator(), name,
+                   TDB_COLUMN_FAMILY_CONFIG_FILE_EXT);
+
+    /* now we serialize the column family struct */
+    size_t serialized_size;
+    uint8_t *serialized_cf =
+        _tidesdb_serialize_column_family_config(&(*cf)->config, &serialized_size);
+    if (serialized_cf == NULL)
+    {
+        (void)pthread_rwlock_destroy(&(*cf)->rwlock);
+        free((*cf)->config.name);
+        free(*cf);
+        free(serialized_cf);
+        return -1;
+    }
+
+    /* we open the config file (new file) */
+    FILE *config_file = fopen(config_file_name, "wb");
+    if (config_file == NULL)
+    {
+        (void)pthread_rwlock_destroy(&(*cf)->rwlock);
+        free((*cf)->config.name);
+        free(*cf);
+        free(serialized_cf);
+        return -1;
+    }
+
+    /* we write the serialized column family struct to the config file */
+    if (fwrite(serialized_cf, serialized_size, 1, config_file) != 1)
+    {
+        (void)pthread_rwlock_destroy(&(*cf)->rwlock);
+        free((*cf)->config.name);
+        free(*cf);
+        free(serialized_cf);
+        (void)fclose(config_file);
+        return -1;
+    }
+
+    /* sync the file */
+    (void)fflush(config_file);
+
+    /* we set the path */
+    (*cf)->path = strdup(cf_path);
+
+    /* we check if the path was copied */
+    if ((*cf)->path == NULL)
+    {
+        (void)pthread_rwlock_destroy(&(*cf)->rwlock);
+        free((*cf)->config.name);
+        free(*cf);
+        free(serialized_cf);
+        (void)fclose(config_file);
+        return -1;
+    }
+
+    /* we start with an empty version */
+    (*cf)->version = _tidesdb_version_new(NULL, 0);
+    if ((*cf)->version == NULL)
+    {
+        (void)pthread_rwlock_destroy(&(*cf)->rwlock);
+        free((*cf)->config.name);
+        free((*cf)->path);
+        free(*cf);
+        free(serialized_cf);
+        (void)fclose(config_file);
+        return -1;
+    }
+
+    (*cf)->next_sstable_id = 0;
+    (void)pthread_mutex_init(&(*cf)->version_lock, NULL);
+    (void)pthread_cond_init(&(*cf)->version_cond, NULL);
+    atomic_init(&(*cf)->num_sstables, 0);
+    (*cf)->stall_condition = TDB_STALL_NORMAL;
+    atomic_init(&(*cf)->memtable_bytes, 0);
+    (void)pthread_mutex_init(&(*cf)->compaction_lock, NULL);
+    (void)pthread_mutex_init(&(*cf)->file_lock, NULL);
+
+    /* the db holds the initial reference on the column family */
+    (*cf)->dropped = false;
+    atomic_init(&(*cf)->refcount, 1);
+
+    /* we free what we must */
+    free(serialized_cf);
+    (void)fclose(config_file);
+
+    /* we create the memtable shards and their wals, the wals count their bytes into the
+     * statistics */
+    (*cf)->stats = _tidesdb_stats_new();
+    if ((*cf)->stats == NULL || _tidesdb_open_shards(*cf) == -1)
+    {
+        (void)_tidesdb_free_column_family(*cf);
+        *cf = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+int _tidesdb_get_column_family(tidesdb_t *tdb, const char *name, tidesdb_column_family_t **cf)
+{
+    /* we check if tdb or name is NULL */
+    if (tdb == NULL || name == NULL) return -1;
+
+    if (tdb->num_column_families == 0)
+    {
+        return -1;
+    }
+
+    /* we iterate over the column families and return the one with the matching name */
+    for (int i = 0; i < tdb->num_column_families; i++)
+    {
+        if (strcmp(tdb->column_families[i]->config.name, name) == 0)
+        {
+            /* match on name we return the column family */
+            *cf = tdb->column_families[i];
+
+            return 0;
+        }
+    }
+
+    return -1; /* no column family with that name */
+}
+
+char *tidesdb_list_column_families(tidesdb_t *tdb)
+{
+    if (tdb == NULL) return NULL;
+
+    /* get read lock for database */
+    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0) return NULL;
+
+    size_t total_size = 1; /* +1 for null terminator */
+    for (int i = 0; i < tdb->num_column_families; i++)
+    {
+        total_size += strlen(tdb->column_families[i]->config.name) + 1; /* +1 for newline */
+    }
+
+    char *list = malloc(total_size);
+    if (list == NULL) return NULL;
+
+    list[0] = '\0'; /* null terminate the string */
+
+    for (int i = 0; i < tdb->num_column_families; i++)
+    {
+        strcat(list, tdb->column_families[i]->config.name);
+        strcat(list, "\n");
+    }
+
+    /* release the read lock */
+    if (pthread_rwlock_unlock(&tdb->rwlock) != 0)
+    {
+        free(list);
+        return NULL;
+    }
+
+    return list;
+}
+
+tidesdb_err_t *tidesdb_put(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
+                           size_t key_size, const uint8_t *value, size_t value_size, time_t ttl)
+{
+    /* we check if the db is NULL */
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    /* we check if the column family name is NULL */
+    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    /* get column family, we hold a reference on it for the duration of the put */
+    tidesdb_column_family_t *cf = NULL;
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family_name, &cf);
+    if (e != NULL) return e;
+
+    e = tidesdb_err_from_status(_tidesdb_put(cf, key, key_size, value, value_size, ttl));
+
+    (void)_tidesdb_release_column_family(cf);
+
+    return e;
+}
+
+tidesdb_err_t *tidesdb_put_w_handle(tidesdb_cf_handle_t *handle, const uint8_t *key,
+                                    size_t key_size, const uint8_t *value, size_t value_size,
+                                    time_t ttl)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    /* the handle pins the column family so no lookup or db lock is required */
+    return tidesdb_err_from_status(_tidesdb_put(handle->cf, key, key_size, value, value_size, ttl));
+}
+
+int tidesdb_put_status(tidesdb_cf_handle_t *handle, const uint8_t *key, size_t key_size,
+                       const uint8_t *value, size_t value_size, time_t ttl)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL) return TIDESDB_ERR_INVALID_COLUMN_FAMILY;
+
+    return _tidesdb_put(handle->cf, key, key_size, value, value_size, ttl);
+}
+
+int _tidesdb_put(tidesdb_column_family_t *cf, const uint8_t *key, size_t key_size,
+                 const uint8_t *value, size_t value_size, time_t ttl)
+{
+    /* we check if the key is NULL */
+    if (key == NULL) return TIDESDB_ERR_INVALID_KEY;
+
+    /* we check if the value is NULL */
+    if (value == NULL) return TIDESDB_ERR_INVALID_VALUE;
+
+    /* the latency includes any stall and the flush the put may trigger */
+    uint64_t start = _tidesdb_now_ns();
+
+    /* we slow down or stop if compaction has fallen behind */
+    int stalled = _tidesdb_write_stall(cf);
+    if (stalled != TIDESDB_SUCCESS) return stalled;
+
+    /* get column family read lock, writers to different shards run concurrently under it */
+    uint64_t lock_wait = _tidesdb_perf_start();
+    if (pthread_rwlock_rdlock(&cf->rwlock) != 0)
+    {
+        return TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK;
+    }
+    (void)_tidesdb_perf_stop(TDB_PERF_CF_LOCK_WAIT, lock_wait);
+
+    /* we check if the column family was dropped while we were waiting on the lock */
+    if (cf->dropped)
+    {
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND;
+    }
+
+    /* get the shard the key belongs to and its write lock */
+    tidesdb_memtable_shard_t *shard = _tidesdb_get_shard(cf, key, key_size);
+    lock_wait = _tidesdb_perf_start();
+    if (pthread_rwlock_wrlock(&shard->rwlock) != 0)
+    {
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK;
+    }
+    (void)_tidesdb_perf_stop(TDB_PERF_SHARD_LOCK_WAIT, lock_wait);
+
+    /* we append to the shard wal */
+    uint64_t append = _tidesdb_perf_start();
+    int appended = _tidesdb_append_to_wal(shard->wal, key, key_size, value, value_size, ttl,
+                                          TIDESDB_OP_PUT, cf->config.name);
+    (void)_tidesdb_perf_stop(TDB_PERF_WAL_APPEND, append);
+    if (appended == -1)
+    {
+        (void)pthread_rwlock_unlock(&shard->rwlock);
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_FAILED_TO_APPEND_TO_WAL;
+    }
+
+    /* put in memtable */
+    if (_tidesdb_memtable_put(cf, shard, key, key_size, value, value_size, ttl) == -1)
+    {
+        (void)pthread_rwlock_unlock(&shard->rwlock);
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_FAILED_TO_PUT_TO_MEMTABLE;
+    }
+
+    bool full = _tidesdb_shard_full(cf, shard);
+
+    (void)pthread_rwlock_unlock(&shard->rwlock);
+
+    /* release column family read lock */
+    if (pthread_rwlock_unlock(&cf->rwlock) != 0)
+    {
+        return TIDESDB_ERR_FAILED_TO_RELEASE_LOCK;
+    }
+
+    /* we check if the shard has reached its part of the flush threshold */
+    if (full && _tidesdb_flush_memtable_if_full(cf) == -1)
+        return TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE;
+
+    /* and if the memtables of all column families together are over the budget */
+    if (_tidesdb_flush_over_budget(cf->tdb) == -1) return TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE;
+
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_PUTS, 1);
+    (void)_tidesdb_stats_record(cf->stats, TDB_LATENCY_PUT, start);
+
+    return TIDESDB_SUCCESS;
+}
+
+tidesdb_err_t *tidesdb_get(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
+                           size_t key_size, uint8_t **value, size_t *value_size)
+{
+    /* we check if the db is NULL */
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    /* we check if the column family name is NULL */
+    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    /* get column family, we hold a reference on it for the duration of the get */
+    tidesdb_column_family_t *cf = NULL;
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family_name, &cf);
+    if (e != NULL) return e;
+
+    e = tidesdb_err_from_status(_tidesdb_get(cf, key, key_size, value, value_size));
+
+    (void)_tidesdb_release_column_family(cf);
+
+    return e;
+}
+
+tidesdb_err_t *tidesdb_get_w_handle(tidesdb_cf_handle_t *handle, const uint8_t *key,
+                                    size_t key_size, uint8_t **value, size_t *value_size)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    return tidesdb_err_from_status(_tidesdb_get(handle->cf, key, key_size, value, value_size));
+}
+
+int tidesdb_get_status(tidesdb_cf_handle_t *handle, const uint8_t *key, size_t key_size,
+                       uint8_t **value, size_t *value_size)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL) return TIDESDB_ERR_INVALID_COLUMN_FAMILY;
+
+    return _tidesdb_get(handle->cf, key, key_size, value, value_size);
+}
+
+int _tidesdb_get(tidesdb_column_family_t *cf, const uint8_t *key, size_t key_size,
+                 uint8_t **value, size_t *value_size)
+{
+    /* we check if key is NULL */
+    if (key == NULL) return TIDESDB_ERR_INVALID_KEY;
+
+    uint64_t start = _tidesdb_now_ns();
+
+    int rc = _tidesdb_get_value(cf, key, key_size, value, value_size);
+
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_GETS, 1);
+    (void)_tidesdb_stats_record(cf->stats, TDB_LATENCY_GET, start);
+
+    return rc;
+}
+
+int _tidesdb_get_value(tidesdb_column_family_t *cf, const uint8_t *key, size_t key_size,
+                       uint8_t **value, size_t *value_size)
+{
+    /* get column family read lock */
+    uint64_t lock_wait = _tidesdb_perf_start();
+    if (pthread_rwlock_rdlock(&cf->rwlock) != 0)
+    {
+        return TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK;
+    }
+    (void)_tidesdb_perf_stop(TDB_PERF_CF_LOCK_WAIT, lock_wait);
+
+    /* we check if the column family was dropped while we were waiting on the lock */
+    if (cf->dropped)
+    {
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND;
+    }
+
+    /* a row read from an sstable before is answered from the row cache, the miss remembers the
+     * cache version so the row we read below isn't cached if the key is written meanwhile */
+    row_cache_t *row_cache = cf->tdb != NULL ? cf->tdb->row_cache : NULL;
+    uint64_t cache_version = 0;
+    if (row_cache != NULL)
+    {
+        if (row_cache_get(row_cache, cf->cache_id, key, key_size, value, value_size,
+                          &cache_version) == 0)
+        {
+            (void)pthread_rwlock_unlock(&cf->rwlock);
+            (void)_tidesdb_stats_add(cf->stats, TDB_STAT_ROW_CACHE_HITS, 1);
+            return TIDESDB_SUCCESS;
+        }
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_ROW_CACHE_MISSES, 1);
+    }
+
+    /* we check if the key exists in the memtable shard it hashes to */
+    tidesdb_memtable_shard_t *shard = _tidesdb_get_shard(cf, key, key_size);
+    lock_wait = _tidesdb_perf_start();
+    if (pthread_rwlock_rdlock(&shard->rwlock) != 0)
+    {
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK;
+    }
+    (void)_tidesdb_perf_stop(TDB_PERF_SHARD_LOCK_WAIT, lock_wait);
+
+    uint64_t search = _tidesdb_perf_start();
+    int found = _tidesdb_memtable_get(cf, shard, key, key_size, value, value_size);
+    (void)_tidesdb_perf_stop(TDB_PERF_MEMTABLE_SEARCH, search);
+
+    (void)pthread_rwlock_unlock(&shard->rwlock);
+
+    if (found != -1)
+    {
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_MEMTABLE_HITS, 1);
+
+        /* we found the key in the memtable
+         * we check if the value is a tombstone */
+        if (_tidesdb_is_tombstone(*value, *value_size))
+        {
+            free(*value);
+            return TIDESDB_ERR_KEY_NOT_FOUND;
+        }
+
+        return TIDESDB_SUCCESS;
+    }
+
+    /* we pin the current version before releasing the column family lock, a flush installs its
+     * version under the write lock so whatever left the memtable is in the version we pin */
+    tidesdb_version_t *version = _tidesdb_acquire_version(cf);
+
+    /* unlock column family, the sstables are read without it */
+    if (pthread_rwlock_unlock(&cf->rwlock) != 0)
+    {
+        (void)_tidesdb_release_version(version);
+        return TIDESDB_ERR_FAILED_TO_RELEASE_LOCK;
+    }
+
+    /* now we check sstables from latest to oldest */
+    for (int i = version->num_sstables - 1; i >= 0; i--)
+    {
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_SSTABLES_PROBED, 1);
+
+        int64_t ttl = -1;
+        int rc = _tidesdb_get_from_sstable(cf, version->sstables[i], key, key_size, value,
+                                           value_size, &ttl);
+        if (rc == -1) continue; /* we go onto the next sstable */
+
+        (void)_tidesdb_release_version(version);
+
+        if (rc == 0)
+        {
+            /* we found the key, the next get of it won't touch the sstables */
+            if (row_cache != NULL)
+                (void)row_cache_put(row_cache, cf->cache_id, key, key_size, *value, *value_size,
+                                    ttl, cache_version);
+            return TIDESDB_SUCCESS;
+        }
+
+        if (rc == -2) return TIDESDB_ERR_MEMORY_ALLOC;
+
+        /* the key was deleted or has expired */
+        return TIDESDB_ERR_KEY_NOT_FOUND;
+    }
+
+    (void)_tidesdb_release_version(version);
+
+    return TIDESDB_ERR_KEY_NOT_FOUND;
+}
+
+int _tidesdb_get_from_sstable(tidesdb_column_family_t *cf, tidesdb_sstable_t *sst,
+                              const uint8_t *key, size_t key_size, uint8_t **value,
+                              size_t *value_size, int64_t *ttl)
+{
+    /* we create a block manager cursor */
+    block_manager_cursor_t *cursor = NULL;
+
+    /* we initialize the cursor */
+    if (block_manager_cursor_init(&cursor, sst->block_manager) == -1) return -1;
+
+    /* we count the blocks we read and add them to the statistics once at the end */
+    uint64_t block_reads = 0;
+    uint64_t bytes_read = 0;
+    bool bloom_passed = false;
+
+    /* a partitioned sstable only reads the filter and the blocks of the partition that can hold
+     * the key, its top level index tells which one */
+    tidesdb_sstable_partition_t *partition = NULL;
+    if (cf->config.partitioned_index)
+    {
+        tidesdb_sstable_index_t *index = _tidesdb_sstable_index(sst);
+        if (index != NULL) partition = _tidesdb_find_partition(index, key, key_size);
+        if (partition == NULL)
+        {
+            (void)block_manager_cursor_free(cursor);
+            return -1;
+        }
+    }
+
+    if (cf->config.bloom_filter && (partition == NULL || partition->filter_offset != UINT64_MAX))
+    {
+        uint64_t check = _tidesdb_perf_start();
+        if (partition != NULL) cursor->current_pos = partition->filter_offset;
+        block_manager_block_t *block = block_manager_cursor_read(cursor);
+        if (block == NULL)
+        {
+            (void)block_manager_cursor_free(cursor);
+            return -1;
+        }
+
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BLOCK_READS, 1);
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BYTES_READ, sizeof(uint64_t) + block->size);
+
+        /* we check if the key exists in the filter, the perf context times the filter block
+         * read as part of the check.  a filter we can't read lets every key through */
+        int filtered = _tidesdb_filter_contains(cf, sst, block->data, block->size, key, key_size);
+        (void)block_manager_block_free(block);
+        if (filtered != -1)
+        {
+            (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BLOOM_CHECKS, 1);
+            (void)atomic_fetch_add_explicit(&sst->bloom_checks, 1, memory_order_relaxed);
+        }
+        bool contains = filtered != 0;
+        (void)_tidesdb_perf_stop(TDB_PERF_BLOOM_CHECK, check);
+        bloom_passed = filtered == 1;
+
+        if (!contains)
+        {
+            (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BLOOM_NEGATIVES, 1);
+            (void)atomic_fetch_add_explicit(&sst->bloom_negatives, 1, memory_order_relaxed);
+            (void)block_manager_cursor_free(cursor);
+            return -1;
+        }
+
+        /* go next block */
+        if (partition == NULL && block_manager_cursor_next(cursor) == -1)
+        {
+            (void)block_manager_cursor_free(cursor);
+            return -1;
+        }
+    }
+
+    /* we never read past the partition */
+    uint32_t remaining = UINT32_MAX;
+    if (partition != NULL)
+    {
+        cursor->current_pos = partition->data_offset;
+        remaining = partition->entries;
+    }
+
+    /* the hash index of the partition points at the one block that can hold the key */
+    uint32_t bucket = TDB_HASH_INDEX_COLLISION;
+    if (partition != NULL && partition->hash_offset != UINT64_MAX)
+    {
+        uint64_t data_offset = cursor->current_pos;
+        cursor->current_pos = partition->hash_offset;
+        block_manager_block_t *block = block_manager_cursor_read(cursor);
+        if (block != NULL)
+        {
+            block_reads++;
+            bytes_read += sizeof(uint64_t) + block->size;
+            bucket = _tidesdb_hash_index_lookup(block->data, block->size, key, key_size);
+            (void)block_manager_block_free(block);
+        }
+
+        cursor->current_pos = data_offset;
+        if (bucket == TDB_HASH_INDEX_EMPTY)
+        {
+            remaining = 0;
+        }
+        else if (bucket != TDB_HASH_INDEX_COLLISION)
+        {
+            cursor->current_pos = data_offset + bucket;
+            remaining = 1;
+        }
+    }
+
+    /* otherwise the learned index of the partition narrows it down to the few blocks around
+     * where its model puts the key */
+    uint64_t segment_offset;
+    uint32_t skip;
+    uint32_t count;
+    if (partition != NULL && bucket == TDB_HASH_INDEX_COLLISION)
+    {
+        int predicted = _tidesdb_learned_index_lookup(partition, key, key_size, &segment_offset,
+                                                      &skip, &count);
+        if (predicted == 1) remaining = 0;
+        if (predicted == 0)
+        {
+            cursor->current_pos = partition->data_offset + segment_offset;
+            remaining = count;
+
+            /* we step over the blocks before the window by their sizes alone */
+            for (uint32_t i = 0; i < skip && remaining > 0; i++)
+                if (block_manager_cursor_next(cursor) != 0) remaining = 0;
+        }
+    }
+
+    int rc = -1;
+    block_manager_block_t *block;
+    uint64_t read = _tidesdb_perf_start();
+    while (remaining-- > 0 && (block = block_manager_cursor_read(cursor)) != NULL)
+    {
+        (void)_tidesdb_perf_stop(TDB_PERF_BLOCK_READ, read);
+        block_reads++;
+        bytes_read += sizeof(uint64_t) + block->size;
+
+        /* we deserialize the kv */
+        tidesdb_key_value_pair_t *kv = _tidesdb_deserialize_key_value_pair(
+            block->data, block->size, cf->config.compressed, cf->config.compress_algo);
+        (void)block_manager_block_free(block);
+        if (kv == NULL) break;
+
+        /* we check if the key matches */
+        if (_tidesdb_compare_keys(kv->key, kv->key_size, key, key_size) == 0)
+        {
+            /* check if value is a tombstone or the key has expired */
+            if (_tidesdb_is_tombstone(kv->value, kv->value_size) || _tidesdb_is_expired(kv->ttl))
+            {
+                rc = 1;
+            }
+            else
+            {
+                /* we found the key, we copy the value */
+                *value = malloc(kv->value_size);
+                if (*value == NULL)
+                {
+                    rc = -2;
+                }
+                else
+                {
+                    memcpy(*value, kv->value, kv->value_size);
+                    *value_size = kv->value_size;
+                    *ttl = kv->ttl;
+                    rc = 0;
+                }
+            }
+
+            (void)_tidesdb_free_key_value_pair(kv);
+            break;
+        }
+
+        /* a partition is in key order, once we are past the key it isn't there */
+        bool past = partition != NULL &&
+                    _tidesdb_compare_keys(kv->key, kv->key_size, key, key_size) > 0;
+        (void)_tidesdb_free_key_value_pair(kv);
+        if (past) break;
+
+        read = _tidesdb_perf_start();
+        if (block_manager_cursor_next(cursor) != 0) break;
+    }
+
+    (void)block_manager_cursor_free(cursor);
+
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BLOCK_READS, block_reads);
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BYTES_READ, bytes_read);
+
+    /* the filter let us in but the key isn't here */
+    if (bloom_passed && rc == -1)
+    {
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BLOOM_FALSE_POSITIVES, 1);
+        (void)atomic_fetch_add_explicit(&sst->bloom_false_positives, 1, memory_order_relaxed);
+    }
+
+    return rc;
+}
+
+tidesdb_err_t *tidesdb_delete(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
+                              size_t key_size)
+{
+    /* we check if the db is NULL */
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+
+    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    /* get column family, we hold a reference on it for the duration of the delete */
+    tidesdb_column_family_t *cf = NULL;
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family_name, &cf);
+    if (e != NULL) return e;
+
+    e = tidesdb_err_from_status(_tidesdb_delete(cf, key, key_size));
+
+    (void)_tidesdb_release_column_family(cf);
+
+    return e;
+}
+
+tidesdb_err_t *tidesdb_delete_w_handle(tidesdb_cf_handle_t *handle, const uint8_t *key,
+                                       size_t key_size)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    return tidesdb_err_from_status(_tidesdb_delete(handle->cf, key, key_size));
+}
+
+int tidesdb_delete_status(tidesdb_cf_handle_t *handle, const uint8_t *key, size_t key_size)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL) return TIDESDB_ERR_INVALID_COLUMN_FAMILY;
+
+    return _tidesdb_delete(handle->cf, key, key_size);
+}
+
+int _tidesdb_write_stall(tidesdb_column_family_t *cf)
+{
+    if (cf->tdb == NULL) return TIDESDB_SUCCESS;
+
+    tidesdb_t *tdb = cf->tdb;
+    int soft = tdb->config.stall_soft_sstables;
+    int hard = tdb->config.stall_hard_sstables;
+    int num_sstables = atomic_load(&cf->num_sstables);
+    TIDESDB_STALL_CONDITION condition = _tidesdb_stall_condition(tdb, num_sstables);
+
+    /* the common case, nothing to do */
+    if (condition == TDB_STALL_NORMAL) return TIDESDB_SUCCESS;
+
+    struct timespec start;
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int rc = TIDESDB_SUCCESS;
+    if (condition == TDB_STALL_STOPPED)
+    {
+        (void)atomic_fetch_add(&tdb->stopped_writes, 1);
+
+        /* compaction is manual, if nobody compacts the column family we give up rather than
+         * block the writer for good */
+        long timeout_ms = tdb->config.stall_timeout_ms;
+        if (timeout_ms <= 0) timeout_ms = TDB_DEFAULT_STALL_TIMEOUT_MS;
+
+        struct timespec timeout;
+        (void)clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += timeout_ms / 1000;
+        timeout.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        timeout.tv_sec += timeout.tv_nsec / 1000000000L;
+        timeout.tv_nsec %= 1000000000L;
+
+        /* we wait for a compaction to install a smaller version, we wake up now and then in
+         * case the column family is dropped while we wait */
+        (void)pthread_mutex_lock(&cf->version_lock);
+        while (!cf->dropped && atomic_load(&cf->num_sstables) >= hard)
+        {
+            struct timespec deadline;
+            (void)clock_gettime(CLOCK_REALTIME, &deadline);
+            if (deadline.tv_sec > timeout.tv_sec ||
+                (deadline.tv_sec == timeout.tv_sec && deadline.tv_nsec >= timeout.tv_nsec))
+            {
+                rc = TIDESDB_ERR_WRITE_STALLED;
+                break;
+            }
+
+            deadline.tv_nsec += TDB_STALL_WAIT_US * 1000L;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            if (deadline.tv_sec > timeout.tv_sec ||
+                (deadline.tv_sec == timeout.tv_sec && deadline.tv_nsec > timeout.tv_nsec))
+                deadline = timeout;
+
+            (void)pthread_cond_timedwait(&cf->version_cond, &cf->version_lock, &deadline);
+        }
+        (void)pthread_mutex_unlock(&cf->version_lock);
+    }
+    else
+    {
+        (void)atomic_fetch_add(&tdb->delayed_writes, 1);
+
+        /* the delay grows with every sstable past the soft limit */
+        long delay = (long)TDB_STALL_DELAY_US * (num_sstables - soft + 1);
+        if (delay > TDB_STALL_MAX_DELAY_US) delay = TDB_STALL_MAX_DELAY_US;
+        (void)usleep((useconds_t)delay);
+    }
+
+    struct timespec end;
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+    (void)atomic_fetch_add(&tdb->stall_us, (uint64_t)((end.tv_sec - start.tv_sec) * 1000000L +
+                                                      (end.tv_nsec - start.tv_nsec) / 1000L));
+
+    return rc;
+}
+
+TIDESDB_STALL_CONDITION _tidesdb_stall_condition(tidesdb_t *tdb, int num_sstables)
+{
+    int soft = tdb->config.stall_soft_sstables;
+    int hard = tdb->config.stall_hard_sstables;
+
+    if (hard > 0 && num_sstables >= hard) return TDB_STALL_STOPPED;
+    if (soft > 0 && num_sstables >= soft) return TDB_STALL_DELAYED;
+
+    return TDB_STALL_NORMAL;
+}
+
+void _tidesdb_update_stall_condition(tidesdb_column_family_t *cf)
+{
+    if (cf->tdb == NULL) return;
+
+    (void)pthread_mutex_lock(&cf->version_lock);
+
+    int num_sstables = atomic_load(&cf->num_sstables);
+    TIDESDB_STALL_CONDITION condition = _tidesdb_stall_condition(cf->tdb, num_sstables);
+    if (condition == cf->stall_condition)
+    {
+        (void)pthread_mutex_unlock(&cf->version_lock);
+        return;
+    }
+
+    tidesdb_write_stall_info_t info = {.column_family = cf->config.name,
+                                       .prev = cf->stall_condition,
+                                       .cur = condition,
+                                       .num_sstables = num_sstables};
+    cf->stall_condition = condition;
+
+    (void)pthread_mutex_unlock(&cf->version_lock);
+
+    const tidesdb_event_listener_t *listener = _tidesdb_listener(cf);
+    if (listener->on_write_stall_change != NULL)
+        listener->on_write_stall_change(&info, listener->arg);
+}
+
+uint64_t _tidesdb_now_ns()
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+tidesdb_stats_shard_t *_tidesdb_stats_new()
+{
+    /* the shards are cache line aligned so threads recording into neighbouring shards don't share
+     * lines */
+    tidesdb_stats_shard_t *stats = aligned_alloc(_Alignof(tidesdb_stats_shard_t),
+                                                 sizeof(tidesdb_stats_shard_t) * TDB_STATS_SHARDS);
+    if (stats == NULL) return NULL;
+
+    for (int i = 0; i < TDB_STATS_SHARDS; i++)
+    {
+        for (int c = 0; c < TDB_STATS; c++) atomic_init(&stats[i].counters[c], 0);
+        for (int l = 0; l < TDB_LATENCIES; l++) (void)histogram_init(&stats[i].latencies[l]);
+    }
+
+    return stats;
+}
+
+/* the shard of the calling thread, -1 until it records for the first time */
+static _Thread_local int _tidesdb_stats_thread_shard = -1;
+static atomic_int _tidesdb_stats_next_shard;
+
+tidesdb_stats_shard_t *_tidesdb_stats_shard(tidesdb_stats_shard_t *stats)
+{
+    if (_tidesdb_stats_thread_shard == -1)
+        _tidesdb_stats_thread_shard =
+            atomic_fetch_add(&_tidesdb_stats_next_shard, 1) % TDB_STATS_SHARDS;
+
+    return &stats[_tidesdb_stats_thread_shard];
+}
+
+void _tidesdb_stats_add(tidesdb_stats_shard_t *stats, TIDESDB_STAT stat, uint64_t n)
+{
+    if (stats == NULL || n == 0) return;
+
+    (void)atomic_fetch_add_explicit(&_tidesdb_stats_shard(stats)->counters[stat], n,
+                                    memory_order_relaxed);
+}
+
+void _tidesdb_stats_sub(tidesdb_stats_shard_t *stats, TIDESDB_STAT stat, uint64_t n)
+{
+    /* a gauge may go down on another shard than the one it went up on, the shards only have to
+     * add up so we add the two's complement and let it wrap */
+    (void)_tidesdb_stats_add(stats, stat, (uint64_t)0 - n);
+}
+
+void _tidesdb_stats_record(tidesdb_stats_shard_t *stats, TIDESDB_LATENCY latency, uint64_t start)
+{
+    if (stats == NULL) return;
+
+    (void)histogram_record(&_tidesdb_stats_shard(stats)->latencies[latency],
+                           _tidesdb_now_ns() - start);
+}
+
+void _tidesdb_stats_collect(tidesdb_column_family_t *cf, tidesdb_stats_t *out)
+{
+    tidesdb_stats_shard_t *stats = cf->stats;
+    uint64_t counters[TDB_STATS] = {0};
+    for (int i = 0; i < TDB_STATS_SHARDS; i++)
+        for (int c = 0; c < TDB_STATS; c++)
+            counters[c] += atomic_load_explicit(&stats[i].counters[c], memory_order_relaxed);
+
+    out->gets = counters[TDB_STAT_GETS];
+    out->puts = counters[TDB_STAT_PUTS];
+    out->deletes = counters[TDB_STAT_DELETES];
+    out->commits = counters[TDB_STAT_COMMITS];
+    out->memtable_hits = counters[TDB_STAT_MEMTABLE_HITS];
+    out->row_cache_hits = counters[TDB_STAT_ROW_CACHE_HITS];
+    out->row_cache_misses = counters[TDB_STAT_ROW_CACHE_MISSES];
+    out->bloom_checks = counters[TDB_STAT_BLOOM_CHECKS];
+    out->bloom_negatives = counters[TDB_STAT_BLOOM_NEGATIVES];
+    out->bloom_false_positives = counters[TDB_STAT_BLOOM_FALSE_POSITIVES];
+    out->sstables_probed = counters[TDB_STAT_SSTABLES_PROBED];
+    out->block_reads = counters[TDB_STAT_BLOCK_READS];
+    out->bytes_read = counters[TDB_STAT_BYTES_READ];
+    out->bytes_written = counters[TDB_STAT_BYTES_WRITTEN];
+    out->wal_bytes = counters[TDB_STAT_WAL_BYTES];
+    out->flushes = counters[TDB_STAT_FLUSHES];
+    out->flush_bytes = counters[TDB_STAT_FLUSH_BYTES];
+    out->flush_us = counters[TDB_STAT_FLUSH_US];
+    out->compactions = counters[TDB_STAT_COMPACTIONS];
+    out->compaction_bytes = counters[TDB_STAT_COMPACTION_BYTES];
+    out->compaction_us = counters[TDB_STAT_COMPACTION_US];
+    out->budget_flushes = counters[TDB_STAT_BUDGET_FLUSHES];
+    out->memtable_bytes = atomic_load(&cf->memtable_bytes);
+    out->bloom_filter_bytes = counters[TDB_STAT_MEM_BLOOM_FILTERS];
+    out->merge_table_bytes = counters[TDB_STAT_MEM_MERGE_TABLES];
+    out->txn_buffer_bytes = counters[TDB_STAT_MEM_TXN_BUFFERS];
+
+    histogram_summary_t *summaries[TDB_LATENCIES] = {&out->get_latency, &out->put_latency,
+                                                     &out->commit_latency};
+    for (int l = 0; l < TDB_LATENCIES; l++)
+    {
+        histogram_t merged;
+        (void)histogram_init(&merged);
+        for (int i = 0; i < TDB_STATS_SHARDS; i++)
+            (void)histogram_merge(&merged, &stats[i].latencies[l]);
+        (void)histogram_summarize(&merged, summaries[l]);
+    }
+}
+
+/* the perf context of the calling thread */
+static _Thread_local tidesdb_perf_state_t _tidesdb_perf;
+
+tidesdb_err_t *tidesdb_perf_context_enable(bool enable)
+{
+    _tidesdb_perf.enabled = enable;
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_perf_context_reset()
+{
+    memset(_tidesdb_perf.ns, 0, sizeof(_tidesdb_perf.ns));
+    memset(_tidesdb_perf.counts, 0, sizeof(_tidesdb_perf.counts));
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_get_perf_context(tidesdb_perf_context_t *ctx)
+{
+    if (ctx == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    ctx->db_lock_wait_ns = _tidesdb_perf.ns[TDB_PERF_DB_LOCK_WAIT];
+    ctx->cf_lock_wait_ns = _tidesdb_perf.ns[TDB_PERF_CF_LOCK_WAIT];
+    ctx->shard_lock_wait_ns = _tidesdb_perf.ns[TDB_PERF_SHARD_LOCK_WAIT];
+    ctx->wal_append_ns = _tidesdb_perf.ns[TDB_PERF_WAL_APPEND];
+    ctx->memtable_search_ns = _tidesdb_perf.ns[TDB_PERF_MEMTABLE_SEARCH];
+    ctx->bloom_check_ns = _tidesdb_perf.ns[TDB_PERF_BLOOM_CHECK];
+    ctx->block_read_ns = _tidesdb_perf.ns[TDB_PERF_BLOCK_READ];
+    ctx->decompress_ns = _tidesdb_perf.ns[TDB_PERF_DECOMPRESS];
+    ctx->deserialize_ns = _tidesdb_perf.ns[TDB_PERF_DESERIALIZE];
+    ctx->bloom_checks = _tidesdb_perf.counts[TDB_PERF_BLOOM_CHECK];
+    ctx->block_reads = _tidesdb_perf.counts[TDB_PERF_BLOCK_READ];
+
+    return NULL;
+}
+
+uint64_t _tidesdb_perf_start()
+{
+    /* while disabled a timer is a thread-local load and a branch, no clock read */
+    if (!_tidesdb_perf.enabled) return 0;
+
+    return _tidesdb_now_ns();
+}
+
+void _tidesdb_perf_stop(TIDESDB_PERF_TIMER timer, uint64_t start)
+{
+    if (start == 0) return;
+
+    _tidesdb_perf.ns[timer] += _tidesdb_now_ns() - start;
+    _tidesdb_perf.counts[timer]++;
+}
+
+void _tidesdb_trace(tidesdb_column_family_t *cf, TIDESDB_TRACE_EVENT event, bool begin)
+{
+    if (cf->tdb == NULL || cf->tdb->config.trace == NULL) return;
+
+    cf->tdb->config.trace(event, begin, cf->config.name, cf->tdb->config.trace_arg);
+}
+
+const tidesdb_event_listener_t *_tidesdb_listener(tidesdb_column_family_t *cf)
+{
+    if (cf->tdb == NULL) return NULL;
+
+    return &cf->tdb->config.listener;
+}
+
+void _tidesdb_background_error(tidesdb_column_family_t *cf, TIDESDB_BACKGROUND_OP op,
+                               TIDESDB_ERR_CODE code)
+{
+    const tidesdb_event_listener_t *listener = _tidesdb_listener(cf);
+    if (listener == NULL || listener->on_background_error == NULL) return;
+
+    tidesdb_background_error_info_t info = {
+        .column_family = cf->config.name, .op = op, .code = code};
+    listener->on_background_error(&info, listener->arg);
+}
+
+void _tidesdb_wal_sync_hook(void *arg, bool begin)
+{
+    (void)_tidesdb_trace(arg, TDB_TRACE_WAL_SYNC, begin);
+}
+
+int _tidesdb_delete(tidesdb_column_family_t *cf, const uint8_t *key, size_t key_size)
+{
+    if (key == NULL) return TIDESDB_ERR_INVALID_KEY;
+
+    uint64_t start = _tidesdb_now_ns();
+
+    /* we slow down or stop if compaction has fallen behind */
+    int stalled = _tidesdb_write_stall(cf);
+    if (stalled != TIDESDB_SUCCESS) return stalled;
+
+    /* get column family read lock, writers to different shards run concurrently under it */
+    uint64_t lock_wait = _tidesdb_perf_start();
+    if (pthread_rwlock_rdlock(&cf->rwlock) != 0)
+    {
+        return TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK;
+    }
+    (void)_tidesdb_perf_stop(TDB_PERF_CF_LOCK_WAIT, lock_wait);
+
+    /* we check if the column family was dropped while we were waiting on the lock */
+    if (cf->dropped)
+    {
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND;
+    }
+
+    uint32_t tombstone_value = TOMBSTONE;
+    const uint8_t *tombstone = (const uint8_t *)&tombstone_value;
+
+    /* get the shard the key belongs to and its write lock */
+    tidesdb_memtable_shard_t *shard = _tidesdb_get_shard(cf, key, key_size);
+    lock_wait = _tidesdb_perf_start();
+    if (pthread_rwlock_wrlock(&shard->rwlock) != 0)
+    {
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK;
+    }
+    (void)_tidesdb_perf_stop(TDB_PERF_SHARD_LOCK_WAIT, lock_wait);
+
+    /* append to wal */
+    uint64_t append = _tidesdb_perf_start();
+    int appended = _tidesdb_append_to_wal(shard->wal, key, key_size, tombstone, 4, 0,
+                                          TIDESDB_OP_DELETE, cf->config.name);
+    (void)_tidesdb_perf_stop(TDB_PERF_WAL_APPEND, append);
+    if (appended == -1)
+    {
+        (void)pthread_rwlock_unlock(&shard->rwlock);
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_FAILED_TO_APPEND_TO_WAL;
+    }
+
+    /* add to memtable */
+    if (_tidesdb_memtable_put(cf, shard, key, key_size, tombstone, 4, -1) == -1)
+    {
+        (void)pthread_rwlock_unlock(&shard->rwlock);
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        return TIDESDB_ERR_FAILED_TO_PUT_TO_MEMTABLE;
+    }
+
+    bool full = _tidesdb_shard_full(cf, shard);
+
+    (void)pthread_rwlock_unlock(&shard->rwlock);
+
+    /* release column family read lock */
+    if (pthread_rwlock_unlock(&cf->rwlock) != 0)
+    {
+        return TIDESDB_ERR_FAILED_TO_RELEASE_LOCK;
+    }
+
+    /* we check if the shard has reached its part of the flush threshold */
+    if (full && _tidesdb_flush_memtable_if_full(cf) == -1)
+        return TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE;
+
+    /* and if the memtables of all column families together are over the budget */
+    if (_tidesdb_flush_over_budget(cf->tdb) == -1) return TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE;
+
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_DELETES, 1);
+    (void)_tidesdb_stats_record(cf->stats, TDB_LATENCY_PUT, start);
+
+    return TIDESDB_SUCCESS;
+}
+
+int _tidesdb_is_tombstone(const uint8_t *value, size_t value_size)
+{
+    return value_size == 4 && *(uint32_t *)value == TOMBSTONE;
+}
+
+int _tidesdb_append_to_wal(tidesdb_wal_t *wal, const uint8_t *key, size_t key_size,
+                           const uint8_t *value, size_t value_size, time_t ttl,
+                           TIDESDB_OP_CODE op_code, const char *cf)
+{
+    /* we append to column families write ahead log */
+
+    /* we create an operation struct */
+    tidesdb_operation_t *op = malloc(sizeof(tidesdb_operation_t));
+    if (op == NULL) return -1;
+
+    op->cf_name = strdup(cf);
+    op->kv = malloc(sizeof(tidesdb_key_value_pair_t));
+    if (op->kv == NULL)
+    {
+        (void)_tidesdb_free_operation(op);
+        return -1;
+    }
+
+    op->kv->key = malloc(key_size);
+    if (op->kv->key == NULL)
+    {
+        (void)_tidesdb_free_operation(op);
+        return -1;
+    }
+
+    /* we copy the key */
+    memcpy(op->kv->key, key, key_size);
+
+    op->kv->value = malloc(value_size);
+    if (op->kv->value == NULL)
+    {
+        (void)_tidesdb_free_operation(op);
+        return -1;
+    }
+
+    /* we copy the value */
+    memcpy(op->kv->value, value, value_size);
+
+    op->kv->key_size = key_size;
+
+    op->kv->value_size = value_size;
+
+    op->kv->ttl = ttl;
+
+    op->op_code = op_code;
+
+    /* now we serialize the operation */
+    size_t serialized_size;
+    uint8_t *serialized_op =
+        _tidesdb_serialize_operation(op, &serialized_size, wal->compress, wal->compress_algo);
+    if (serialized_op == NULL)
+    {
+        (void)_tidesdb_free_operation(op);
+        return -1;
+    }
+
+    block_manager_block_t *block = block_manager_block_create(serialized_size, serialized_op);
+    if (block == NULL)
+    {
+        (void)_tidesdb_free_operation(op);
+        free(serialized_op);
+        return -1;
+    }
+
+    /* we append to the wal */
+    if (block_manager_block_write(wal->block_manager, block) == -1)
+    {
+        (void)block_manager_block_free(block);
+        (void)_tidesdb_free_operation(op);
+        free(serialized_op);
+        return -1;
+    }
+
+    (void)_tidesdb_stats_add(wal->stats, TDB_STAT_WAL_BYTES, sizeof(uint64_t) + serialized_size);
+
+    (void)_tidesdb_free_operation(op);
+    (void)block_manager_block_free(block);
+    free(serialized_op);
+
+    return 0;
+}
+
+int _tidesdb_write_bloom_filter_block(tidesdb_column_family_t *cf, skip_list_t *list,
+                                      skip_list_node_t *start, skip_list_node_t *end,
+                                      bool drop_deleted, tidesdb_sstable_t *sst)
+{
+    if (start == NULL) start = list->header->forward[0];
+
+    /* we size the bloom filter by the amount of entries we are about to write, deletes and
+     * expired keys the sstable drops would only waste bits */
+    int n = 0;
+    for (skip_list_node_t *node = start; node != end; node = node->forward[0])
+        if (!drop_deleted || !(_tidesdb_is_expired(node->ttl) ||
+                               _tidesdb_is_tombstone(node->value, node->value_size)))
+            n++;
+
+    bloom_filter_t *bf = NULL;
+    if (bloom_filter_new(&bf, TDB_BLOOMFILTER_P, n > 0 ? n : 1) == -1) return -1;
+
+    /* the filter is counted as held memory while we build it */
+    size_t bf_size = sizeof(bloom_filter_t) + (size_t)bf->m;
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, bf_size);
+
+    skip_list_cursor_t *cursor = skip_list_cursor_init(list);
+    if (cursor == NULL)
+    {
+        (void)bloom_filter_free(bf);
+        (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, bf_size);
+        return -1;
+    }
+    cursor->current = start;
+
+    uint8_t *key;
+    size_t key_size;
+    uint8_t *value;
+    size_t value_size;
+    time_t ttl;
+    while (cursor->current != end &&
+           skip_list_cursor_get(cursor, &key, &key_size, &value, &value_size, &ttl) == 0)
+    {
+        bool dropped = drop_deleted && (_tidesdb_is_expired(ttl) ||
+                                        _tidesdb_is_tombstone(value, value_size));
+        if (!dropped) (void)bloom_filter_add(bf, key, key_size);
+
+        /* we stop before stepping onto the next range, another thread may be writing it */
+        if (cursor->current->forward[0] == end) break;
+        if (skip_list_cursor_next(cursor) == -1) break;
+    }
+
+    (void)skip_list_cursor_free(cursor);
+
+    (void)_tidesdb_set_bloom_stats(sst, bf);
+
+    size_t serialized_bf_size;
+    uint8_t *serialized_bf = bloom_filter_serialize(bf, &serialized_bf_size);
+    (void)bloom_filter_free(bf);
+    (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, bf_size);
+    if (serialized_bf == NULL) return -1;
+
+    block_manager_block_t *block = block_manager_block_create(serialized_bf_size, serialized_bf);
+    free(serialized_bf);
+    if (block == NULL) return -1;
+
+    int rc = block_manager_block_write(sst->block_manager, block);
+    (void)block_manager_block_free(block);
+
+    return rc;
+}
+
+void _tidesdb_set_bloom_stats(tidesdb_sstable_t *sst, bloom_filter_t *bf)
+{
+    /* the filter never changes once written so whoever sees it first counts it */
+    if (atomic_load(&sst->bloom_bits) != 0) return;
+
+    atomic_store(&sst->bloom_bits_set, bloom_filter_count_set(bf));
+    atomic_store(&sst->bloom_hashes, bf->h);
+    atomic_store(&sst->bloom_bits, bf->m);
+}
+
+int _tidesdb_write_fuse_filter_block(tidesdb_column_family_t *cf, skip_list_t *list,
+                                     skip_list_node_t *start, skip_list_node_t *end,
+                                     bool drop_deleted, tidesdb_sstable_t *sst)
+{
+    if (start == NULL) start = list->header->forward[0];
+
+    /* a binary fuse filter is built from every key at once so we gather the hashes of the keys
+     * we are about to write first */
+    size_t n = 0;
+    for (skip_list_node_t *node = start; node != end; node = node->forward[0]) n++;
+
+    size_t hashes_size = (n > 0 ? n : 1) * sizeof(uint64_t);
+    uint64_t *hashes = malloc(hashes_size);
+    if (hashes == NULL) return -1;
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, hashes_size);
+
+    size_t count = 0;
+    for (skip_list_node_t *node = start; node != end && count < n; node = node->forward[0])
+    {
+        bool dropped = drop_deleted && (_tidesdb_is_expired(node->ttl) ||
+                                        _tidesdb_is_tombstone(node->value, node->value_size));
+        if (!dropped) hashes[count++] = fuse_filter_hash(node->key, node->key_size);
+    }
+
+    fuse_filter_t *ff = NULL;
+    int rc = fuse_filter_new(&ff, hashes, count);
+    free(hashes);
+    (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, hashes_size);
+    if (rc == -1) return -1;
+
+    (void)_tidesdb_set_fuse_stats(sst, ff);
+
+    size_t serialized_ff_size;
+    uint8_t *serialized_ff = fuse_filter_serialize(ff, &serialized_ff_size);
+    (void)fuse_filter_free(ff);
+    if (serialized_ff == NULL) return -1;
+
+    block_manager_block_t *block = block_manager_block_create(serialized_ff_size, serialized_ff);
+    free(serialized_ff);
+    if (block == NULL) return -1;
+
+    rc = block_manager_block_write(sst->block_manager, block);
+    (void)block_manager_block_free(block);
+
+    return rc;
+}
+
+void _tidesdb_set_fuse_stats(tidesdb_sstable_t *sst, fuse_filter_t *ff)
+{
+    if (atomic_load(&sst->bloom_bits) != 0) return;
+
+    atomic_store(&sst->bloom_bits_set, 0);
+    atomic_store(&sst->bloom_hashes, FUSE_FILTER_ARITY);
+    atomic_store(&sst->bloom_bits, (int)(ff->array_length * 8));
+}
+
+int _tidesdb_filter_contains(tidesdb_column_family_t *cf, tidesdb_sstable_t *sst,
+                             const uint8_t *data, size_t size, const uint8_t *key,
+                             size_t key_size)
+{
+    /* we deserialize the filter, it is counted as held memory until we free it */
+    if (cf->config.filter_type == TDB_FILTER_BINARY_FUSE)
+    {
+        fuse_filter_t *ff = fuse_filter_deserialize(data, size);
+        if (ff == NULL) return -1;
+
+        size_t ff_size = sizeof(fuse_filter_t) + ff->array_length;
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, ff_size);
+        (void)_tidesdb_set_fuse_stats(sst, ff);
+        int contains = fuse_filter_contains(ff, key, key_size);
+        (void)fuse_filter_free(ff);
+        (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, ff_size);
+        return contains;
+    }
+
+    bloom_filter_t *bf = bloom_filter_deserialize(data);
+    if (bf == NULL) return -1;
+
+    size_t bf_size = sizeof(bloom_filter_t) + (size_t)bf->m;
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, bf_size);
+    (void)_tidesdb_set_bloom_stats(sst, bf);
+    int contains = bloom_filter_contains(bf, key, key_size);
+    (void)bloom_filter_free(bf);
+    (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, bf_size);
+    return contains;
+}
+
+int _tidesdb_partition_add(tidesdb_column_family_t *cf, tidesdb_partition_builder_t *builder,
+                           const uint8_t *key, size_t key_size, uint64_t block_size)
+{
+    if (builder->num_keys == 0) builder->start = builder->offset;
+
+    builder->keys[builder->num_keys] = key;
+    builder->key_sizes[builder->num_keys] = key_size;
+    builder->offsets[builder->num_keys] = builder->offset;
+    builder->num_keys++;
+    builder->offset += block_size;
+
+    if (builder->num_keys == TDB_SSTABLE_PARTITION_ENTRIES)
+        return _tidesdb_close_partition(cf, builder);
+
+    return 0;
+}
+
+int _tidesdb_close_partition(tidesdb_column_family_t *cf, tidesdb_partition_builder_t *builder)
+{
+    if (builder->num_keys == 0) return 0;
+
+    tidesdb_sstable_index_t *index = builder->index;
+
+    /* we grow the partitions and the filters together */
+    if (index->num_partitions == builder->capacity)
+    {
+        uint32_t capacity = builder->capacity == 0 ? 16 : builder->capacity * 2;
+
+        tidesdb_sstable_partition_t *partitions =
+            realloc(index->partitions, sizeof(tidesdb_sstable_partition_t) * capacity);
+        if (partitions == NULL) return -1;
+        index->partitions = partitions;
+
+        uint8_t **filters = realloc(builder->filters, sizeof(uint8_t *) * capacity);
+        if (filters == NULL) return -1;
+        builder->filters = filters;
+
+        size_t *filter_sizes = realloc(builder->filter_sizes, sizeof(size_t) * capacity);
+        if (filter_sizes == NULL) return -1;
+        builder->filter_sizes = filter_sizes;
+
+        uint8_t **hash_indexes = realloc(builder->hash_indexes, sizeof(uint8_t *) * capacity);
+        if (hash_indexes == NULL) return -1;
+        builder->hash_indexes = hash_indexes;
+
+        size_t *hash_index_sizes = realloc(builder->hash_index_sizes, sizeof(size_t) * capacity);
+        if (hash_index_sizes == NULL) return -1;
+        builder->hash_index_sizes = hash_index_sizes;
+
+        builder->capacity = capacity;
+    }
+
+    uint32_t n = builder->num_keys;
+    uint32_t i = index->num_partitions;
+    tidesdb_sstable_partition_t *partition = &index->partitions[i];
+    partition->data_offset = builder->start;
+    partition->filter_offset = UINT64_MAX;
+    partition->hash_offset = UINT64_MAX;
+    partition->entries = n;
+    partition->prefix_size = 0;
+    partition->num_segments = 0;
+    partition->segments = NULL;
+    partition->last_key_size = builder->key_sizes[n - 1];
+    partition->last_key = malloc(partition->last_key_size);
+    if (partition->last_key == NULL) return -1;
+    memcpy(partition->last_key, builder->keys[n - 1], partition->last_key_size);
+
+    builder->filters[i] = NULL;
+    builder->filter_sizes[i] = 0;
+    builder->hash_indexes[i] = NULL;
+    builder->hash_index_sizes[i] = 0;
+
+    /* a partition too large for 32 bit offsets is scanned instead */
+    if (cf->config.hash_index)
+        builder->hash_indexes[i] =
+            _tidesdb_build_hash_index(builder, &builder->hash_index_sizes[i]);
+
+    if (cf->config.learned_index && _tidesdb_build_learned_index(builder, partition) == -1)
+        return -1;
+
+    builder->num_keys = 0;
+    index->num_partitions++;
+    index->size += sizeof(tidesdb_sstable_partition_t) + partition->last_key_size +
+                   sizeof(tidesdb_sstable_segment_t) * partition->num_segments;
+
+    if (!cf->config.bloom_filter) return 0;
+
+    /* the filter of a partition is sized for the keys it actually holds */
+    if (cf->config.filter_type == TDB_FILTER_BINARY_FUSE)
+    {
+        uint64_t hashes[TDB_SSTABLE_PARTITION_ENTRIES];
+        for (uint32_t k = 0; k < n; k++)
+            hashes[k] = fuse_filter_hash(builder->keys[k], builder->key_sizes[k]);
+
+        fuse_filter_t *ff = NULL;
+        if (fuse_filter_new(&ff, hashes, n) == -1) return -1;
+
+        index->filter_bits += ff->array_length * 8;
+        index->filter_hashes = FUSE_FILTER_ARITY;
+        builder->filters[i] = fuse_filter_serialize(ff, &builder->filter_sizes[i]);
+        (void)fuse_filter_free(ff);
+    }
+    else
+    {
+        bloom_filter_t *bf = NULL;
+        if (bloom_filter_new(&bf, TDB_BLOOMFILTER_P, (int)n) == -1) return -1;
+
+        for (uint32_t k = 0; k < n; k++)
+            (void)bloom_filter_add(bf, builder->keys[k], builder->key_sizes[k]);
+
+        index->filter_bits += bf->m;
+        index->filter_bits_set += bloom_filter_count_set(bf);
+        index->filter_hashes = bf->h;
+        builder->filters[i] = bloom_filter_serialize(bf, &builder->filter_sizes[i]);
+        (void)bloom_filter_free(bf);
+    }
+
+    if (builder->filters[i] == NULL) return -1;
+
+    /* the filters are counted as held memory until they are written */
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, builder->filter_sizes[i]);
+
+    return 0;
+}
+
+int _tidesdb_finish_partitioned_sstable(tidesdb_column_family_t *cf,
+                                        tidesdb_partition_builder_t *builder,
+                                        tidesdb_sstable_t *sst)
+{
+    if (_tidesdb_close_partition(cf, builder) == -1) return -1;
+
+    tidesdb_sstable_index_t *index = builder->index;
+    index->data_end = builder->offset;
+
+    /* the partition filters follow the key value blocks */
+    for (uint32_t i = 0; i < index->num_partitions; i++)
+    {
+        if (builder->filters[i] == NULL) continue;
+
+        block_manager_block_t *block =
+            block_manager_block_create(builder->filter_sizes[i], builder->filters[i]);
+        if (block == NULL) return -1;
+
+        int rc = block_manager_block_write(sst->block_manager, block);
+        (void)block_manager_block_free(block);
+        if (rc == -1) return -1;
+
+        index->partitions[i].filter_offset = builder->offset;
+        builder->offset += sizeof(uint64_t) + builder->filter_sizes[i];
+
+        free(builder->filters[i]);
+        builder->filters[i] = NULL;
+        (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS, builder->filter_sizes[i]);
+    }
+
+    /* then the partition hash indexes */
+    for (uint32_t i = 0; i < index->num_partitions; i++)
+    {
+        if (builder->hash_indexes[i] == NULL) continue;
+
+        block_manager_block_t *block =
+            block_manager_block_create(builder->hash_index_sizes[i], builder->hash_indexes[i]);
+        if (block == NULL) return -1;
+
+        int rc = block_manager_block_write(sst->block_manager, block);
+        (void)block_manager_block_free(block);
+        if (rc == -1) return -1;
+
+        index->partitions[i].hash_offset = builder->offset;
+        builder->offset += sizeof(uint64_t) + builder->hash_index_sizes[i];
+
+        free(builder->hash_indexes[i]);
+        builder->hash_indexes[i] = NULL;
+    }
+
+    /* then the top level index */
+    size_t index_size;
+    uint8_t *serialized_index = _tidesdb_serialize_sstable_index(index, &index_size);
+    if (serialized_index == NULL) return -1;
+
+    block_manager_block_t *block = block_manager_block_create(index_size, serialized_index);
+    free(serialized_index);
+    if (block == NULL) return -1;
+
+    int rc = block_manager_block_write(sst->block_manager, block);
+    (void)block_manager_block_free(block);
+    if (rc == -1) return -1;
+
+    /* and the footer, the last block of the file says where the index is */
+    uint8_t footer[sizeof(uint64_t) * 2];
+    uint64_t magic = TDB_SSTABLE_FOOTER_MAGIC;
+    memcpy(footer, &builder->offset, sizeof(uint64_t));
+    memcpy(footer + sizeof(uint64_t), &magic, sizeof(uint64_t));
+
+    block = block_manager_block_create(sizeof(footer), footer);
+    if (block == NULL) return -1;
+
+    rc = block_manager_block_write(sst->block_manager, block);
+    (void)block_manager_block_free(block);
+    if (rc == -1) return -1;
+
+    /* we already have the index so the sstable never reads it back */
+    builder->index = NULL;
+    (void)_tidesdb_set_sstable_index(sst, index);
+
+    return 0;
+}
+
+void _tidesdb_free_partition_builder(tidesdb_column_family_t *cf,
+                                     tidesdb_partition_builder_t *builder)
+{
+    if (builder->index != NULL)
+    {
+        for (uint32_t i = 0; i < builder->index->num_partitions; i++)
+        {
+            free(builder->hash_indexes[i]);
+            if (builder->filters[i] == NULL) continue;
+
+            free(builder->filters[i]);
+            (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_BLOOM_FILTERS,
+                                     builder->filter_sizes[i]);
+        }
+
+        (void)_tidesdb_free_sstable_index(builder->index);
+        builder->index = NULL;
+    }
+
+    free(builder->filters);
+    builder->filters = NULL;
+    free(builder->filter_sizes);
+    builder->filter_sizes = NULL;
+    free(builder->hash_indexes);
+    builder->hash_indexes = NULL;
+    free(builder->hash_index_sizes);
+    builder->hash_index_sizes = NULL;
+}
+
+uint8_t *_tidesdb_build_hash_index(tidesdb_partition_builder_t *builder, size_t *out_size)
+{
+    /* the offsets have to fit the slots next to the empty marker */
+    uint64_t span = builder->offsets[builder->num_keys - 1] - builder->start;
+    if (span >= TDB_HASH_INDEX_COLLISION) return NULL;
+
+    /* a power of two number of slots, filled at most TDB_HASH_INDEX_UTIL */
+    uint32_t num_slots = 1;
+    while (num_slots * TDB_HASH_INDEX_UTIL < builder->num_keys) num_slots <<= 1;
+
+    /* the slot count, then a 16 bit tag and an offset per slot */
+    *out_size = sizeof(uint32_t) + (sizeof(uint16_t) + sizeof(uint32_t)) * (size_t)num_slots;
+    uint8_t *serialized_data = malloc(*out_size);
+    if (serialized_data == NULL) return NULL;
+
+    uint16_t *tags = calloc(num_slots, sizeof(uint16_t));
+    uint32_t *offsets = malloc(sizeof(uint32_t) * num_slots);
+    if (tags == NULL || offsets == NULL)
+    {
+        free(tags);
+        free(offsets);
+        free(serialized_data);
+        return NULL;
+    }
+    for (uint32_t slot = 0; slot < num_slots; slot++) offsets[slot] = TDB_HASH_INDEX_EMPTY;
+
+    /* the low bits of the hash pick the first slot and the high bits are the tag, keys go into
+     * the next free slot */
+    for (uint32_t k = 0; k < builder->num_keys; k++)
+    {
+        uint32_t hash =
+            bloom_filter_hash(builder->keys[k], builder->key_sizes[k], TDB_HASH_INDEX_SEED);
+        uint32_t slot = hash & (num_slots - 1);
+        while (offsets[slot] != TDB_HASH_INDEX_EMPTY) slot = (slot + 1) & (num_slots - 1);
+
+        tags[slot] = (uint16_t)(hash >> 16);
+        offsets[slot] = (uint32_t)(builder->offsets[k] - builder->start);
+    }
+
+    uint8_t *ptr = serialized_data;
+    memcpy(ptr, &num_slots, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(ptr, tags, sizeof(uint16_t) * num_slots);
+    ptr += sizeof(uint16_t) * num_slots;
+    memcpy(ptr, offsets, sizeof(uint32_t) * num_slots);
+
+    free(tags);
+    free(offsets);
+
+    return serialized_data;
+}
+
+uint32_t _tidesdb_hash_index_lookup(const uint8_t *data, size_t size, const uint8_t *key,
+                                    size_t key_size)
+{
+    /* a hash index we can't read sends the get to the partition scan */
+    uint32_t num_slots;
+    if (size < sizeof(uint32_t)) return TDB_HASH_INDEX_COLLISION;
+    memcpy(&num_slots, data, sizeof(uint32_t));
+    if (num_slots == 0 || (num_slots & (num_slots - 1)) != 0 ||
+        size != sizeof(uint32_t) + (sizeof(uint16_t) + sizeof(uint32_t)) * (size_t)num_slots)
+        return TDB_HASH_INDEX_COLLISION;
+
+    const uint8_t *tags = data + sizeof(uint32_t);
+    const uint8_t *offsets = tags + sizeof(uint16_t) * num_slots;
 
-            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
-    }
+    uint32_t hash = bloom_filter_hash(key, key_size, TDB_HASH_INDEX_SEED);
+    uint16_t tag = (uint16_t)(hash >> 16);
 
-    /* release column family write lock */
-    if (pthread_rwlock_unlock(&cf->rwlock) != 0)
+    /* a key in the partition sits before the first empty slot, if only one slot on the way has
+     * its tag that is the only block that can hold it */
+    uint32_t found = TDB_HASH_INDEX_EMPTY;
+    uint32_t slot = hash & (num_slots - 1);
+    for (uint32_t probes = 0; probes < num_slots; probes++)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
+        uint32_t offset;
+        uint16_t slot_tag;
+        memcpy(&offset, offsets + sizeof(uint32_t) * slot, sizeof(uint32_t));
+        if (offset == TDB_HASH_INDEX_EMPTY) return found;
+
+        memcpy(&slot_tag, tags + sizeof(uint16_t) * slot, sizeof(uint16_t));
+        if (slot_tag == tag && found != TDB_HASH_INDEX_EMPTY) return TDB_HASH_INDEX_COLLISION;
+        if (slot_tag == tag) found = offset;
+
+        slot = (slot + 1) & (num_slots - 1);
     }
 
-    return NULL;
+    /* a full table has no empty slot to stop at, we never write one */
+    return TDB_HASH_INDEX_COLLISION;
 }
 
-tidesdb_err_t *tidesdb_get(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
-                           size_t key_size, uint8_t **value, size_t *value_size)
+uint64_t _tidesdb_learned_index_key(const uint8_t *key, size_t key_size, size_t prefix_size)
 {
-    /* we check if the db is NULL */
-    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+    uint64_t value = 0;
+    for (size_t i = prefix_size; i < prefix_size + sizeof(uint64_t); i++)
+        value = (value << 8) | (i < key_size ? key[i] : 0);
 
-    /* we check if the column family name is NULL */
-    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+    return value;
+}
 
-    /* we check if key is NULL */
-    if (key == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_KEY);
+int _tidesdb_build_learned_index(tidesdb_partition_builder_t *builder,
+                                 tidesdb_sstable_partition_t *partition)
+{
+    uint32_t n = builder->num_keys;
 
-    /* get db read lock to get column family */
-    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0)
-    {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
-    }
+    /* the segment offsets have to fit 32 bits */
+    if (builder->offsets[n - 1] - builder->start > UINT32_MAX) return 0;
 
-    /* get column family */
-    tidesdb_column_family_t *cf = NULL;
-    if (_tidesdb_get_column_family(tdb, column_family_name, &cf) == -1)
+    /* the keys of a partition sort between its first and last key so they share their prefix */
+    const uint8_t *first = builder->keys[0];
+    const uint8_t *last = builder->keys[n - 1];
+    size_t max_prefix = builder->key_sizes[0];
+    if (builder->key_sizes[n - 1] < max_prefix) max_prefix = builder->key_sizes[n - 1];
+    if (max_prefix > UINT8_MAX) max_prefix = UINT8_MAX;
+
+    size_t prefix_size = 0;
+    while (prefix_size < max_prefix && first[prefix_size] == last[prefix_size]) prefix_size++;
+
+    /* keys that read as the same integer can't be told apart by a line */
+    uint64_t xs[TDB_SSTABLE_PARTITION_ENTRIES];
+    for (uint32_t k = 0; k < n; k++)
     {
-        (void)pthread_rwlock_unlock(&tdb->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+        xs[k] = _tidesdb_learned_index_key(builder->keys[k], builder->key_sizes[k], prefix_size);
+        if (k > 0 && xs[k] <= xs[k - 1]) return 0;
     }
 
-    /* release db read lock */
-    if (pthread_rwlock_unlock(&tdb->rwlock) != 0)
+    tidesdb_sstable_segment_t segments[TDB_SSTABLE_PARTITION_ENTRIES];
+    uint16_t num_segments = 0;
+    uint32_t start = 0;
+    while (start < n)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "db");
+        /* we narrow down the slopes that keep every key of the segment within the error, the
+         * first key that leaves none starts the next segment */
+        double low = 0.0;
+        double high = DBL_MAX;
+        uint32_t end = start + 1;
+        while (end < n && end - start < TDB_LEARNED_INDEX_SEGMENT_ENTRIES)
+        {
+            double dx = (double)(xs[end] - xs[start]);
+            double dy = (double)(end - start);
+            double next_low = (dy - TDB_LEARNED_INDEX_ERROR) / dx;
+            double next_high = (dy + TDB_LEARNED_INDEX_ERROR) / dx;
+            if (next_low < low) next_low = low;
+            if (next_high > high) next_high = high;
+            if (next_low > next_high) break;
+
+            low = next_low;
+            high = next_high;
+            end++;
+        }
+
+        tidesdb_sstable_segment_t *segment = &segments[num_segments++];
+        segment->first = xs[start];
+        segment->offset = (uint32_t)(builder->offsets[start] - builder->start);
+        segment->entry = (uint16_t)start;
+        segment->slope = end - start > 1 ? low + (high - low) / 2 : 0.0;
+        start = end;
+    }
+
+    partition->segments = malloc(sizeof(tidesdb_sstable_segment_t) * num_segments);
+    if (partition->segments == NULL) return -1;
+    memcpy(partition->segments, segments, sizeof(tidesdb_sstable_segment_t) * num_segments);
+    partition->num_segments = num_segments;
+    partition->prefix_size = (uint8_t)prefix_size;
+
+    /* we check every key with the lookup itself, rounding can't then send a get past its key */
+    uint32_t segment = 0;
+    for (uint32_t k = 0; k < n; k++)
+    {
+        if (segment + 1 < num_segments && segments[segment + 1].entry == k) segment++;
+
+        uint64_t offset;
+        uint32_t skip;
+        uint32_t count;
+        uint32_t position = k - segments[segment].entry;
+        if (_tidesdb_learned_index_lookup(partition, builder->keys[k], builder->key_sizes[k],
+                                          &offset, &skip, &count) != 0 ||
+            offset != segments[segment].offset || position < skip || position >= skip + count)
+        {
+            free(partition->segments);
+            partition->segments = NULL;
+            partition->num_segments = 0;
+            partition->prefix_size = 0;
+            return 0;
+        }
     }
 
-    /* get column family read lock */
-    if (pthread_rwlock_rdlock(&cf->rwlock) != 0)
+    return 0;
+}
+
+int _tidesdb_learned_index_lookup(tidesdb_sstable_partition_t *partition, const uint8_t *key,
+                                  size_t key_size, uint64_t *offset, uint32_t *skip,
+                                  uint32_t *count)
+{
+    if (partition->segments == NULL || partition->num_segments == 0) return -1;
+
+    /* a key without the prefix of the partition sorts outside it */
+    if (key_size < partition->prefix_size ||
+        memcmp(key, partition->last_key, partition->prefix_size) != 0)
+        return 1;
+
+    uint64_t x = _tidesdb_learned_index_key(key, key_size, partition->prefix_size);
+
+    /* the last segment starting at or before the key */
+    uint32_t low = 0;
+    uint32_t high = partition->num_segments;
+    while (low < high)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
+        uint32_t mid = low + (high - low) / 2;
+        if (partition->segments[mid].first <= x)
+            low = mid + 1;
+        else
+            high = mid;
     }
+    if (low == 0) return 1;
 
-    /* we check if the key exists in the memtable */
+    tidesdb_sstable_segment_t *segment = &partition->segments[low - 1];
+    uint32_t next = low < partition->num_segments ? partition->segments[low].entry
+                                                  : partition->entries;
+    uint32_t entries = next - segment->entry;
 
-    switch (cf->config.memtable_ds)
-    {
-        case TDB_MEMTABLE_SKIP_LIST:
-            if (skip_list_get(cf->memtable, key, key_size, value, value_size) != -1)
-            {
-                /* we found the key in the memtable
-                 * we check if the value is a tombstone */
-                if (_tidesdb_is_tombstone(*value, *value_size))
-                {
-                    free(*value);
-                    (void)pthread_rwlock_unlock(&cf->rwlock);
-                    return tidesdb_err_from_code(TIDESDB_ERR_KEY_NOT_FOUND);
-                }
+    /* the key is within TDB_LEARNED_INDEX_ERROR blocks of where the line puts it */
+    double predicted = segment->slope * (double)(x - segment->first);
+    double from = predicted - TDB_LEARNED_INDEX_ERROR;
+    double to = predicted + TDB_LEARNED_INDEX_ERROR;
 
-                (void)pthread_rwlock_unlock(&cf->rwlock);
+    uint32_t first = from <= 0 ? 0 : from >= entries - 1 ? entries - 1 : (uint32_t)from;
+    uint32_t last = to >= entries - 1 ? entries - 1 : (uint32_t)to + 1;
+    if (last < first) last = first;
 
-                return NULL;
-            }
-            break;
-        case TDB_MEMTABLE_HASH_TABLE:
-            if (hash_table_get(cf->memtable, key, key_size, value, value_size) != -1)
-            {
-                /* we found the key in the memtable
-                 * we check if the value is a tombstone */
-                if (_tidesdb_is_tombstone(*value, *value_size))
-                {
-                    free(*value);
-                    (void)pthread_rwlock_unlock(&cf->rwlock);
-                    return tidesdb_err_from_code(TIDESDB_ERR_KEY_NOT_FOUND);
-                }
+    *offset = segment->offset;
+    *skip = first;
+    *count = last - first + 1;
 
-                (void)pthread_rwlock_unlock(&cf->rwlock);
+    return 0;
+}
 
-                return NULL;
-            }
-            break;
-        default:
-            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
-    }
+uint8_t *_tidesdb_serialize_sstable_index(tidesdb_sstable_index_t *index, size_t *out_size)
+{
+    /* the hash index offsets trail the partitions, an index without them reads as having none.
+     * the learned indexes come after them */
+    bool hash_offsets = false;
+    bool learned = false;
+    for (uint32_t i = 0; i < index->num_partitions; i++)
+    {
+        if (index->partitions[i].hash_offset != UINT64_MAX) hash_offsets = true;
+        if (index->partitions[i].segments != NULL) learned = true;
+    }
+    if (learned) hash_offsets = true;
+
+    /* calculate the size of the serialized index */
+    *out_size = sizeof(uint32_t) * 2 + sizeof(uint64_t) * 3;
+    for (uint32_t i = 0; i < index->num_partitions; i++)
+        *out_size += sizeof(uint64_t) * 2 + sizeof(uint32_t) * 2 +
+                     index->partitions[i].last_key_size;
+    if (hash_offsets) *out_size += sizeof(uint64_t) * index->num_partitions;
+    for (uint32_t i = 0; learned && i < index->num_partitions; i++)
+        *out_size += sizeof(uint8_t) + sizeof(uint16_t) +
+                     (sizeof(uint64_t) * 2 + sizeof(uint32_t) + sizeof(uint16_t)) *
+                         (size_t)index->partitions[i].num_segments;
 
-    /* now we check sstables from latest to oldest */
+    uint8_t *serialized_data = malloc(*out_size);
+    if (serialized_data == NULL) return NULL;
+
+    uint8_t *ptr = serialized_data;
+
+    memcpy(ptr, &index->num_partitions, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(ptr, &index->filter_hashes, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(ptr, &index->data_end, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    memcpy(ptr, &index->filter_bits, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    memcpy(ptr, &index->filter_bits_set, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
 
-    /* we check if any sstables */
-    if (cf->num_sstables == 0)
+    /* every partition is its offsets, its entries and its last key */
+    for (uint32_t i = 0; i < index->num_partitions; i++)
     {
-        (void)pthread_rwlock_unlock(&cf->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_KEY_NOT_FOUND);
+        tidesdb_sstable_partition_t *partition = &index->partitions[i];
+        uint32_t key_size = (uint32_t)partition->last_key_size;
+
+        memcpy(ptr, &partition->data_offset, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+        memcpy(ptr, &partition->filter_offset, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+        memcpy(ptr, &partition->entries, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        memcpy(ptr, &key_size, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        memcpy(ptr, partition->last_key, key_size);
+        ptr += key_size;
     }
 
-    /* we iterate over the sstables */
-    for (int i = cf->num_sstables - 1; i >= 0; i--)
+    for (uint32_t i = 0; hash_offsets && i < index->num_partitions; i++)
     {
-        /* we get the sstable */
-        tidesdb_sstable_t *sst = cf->sstables[i];
+        memcpy(ptr, &index->partitions[i].hash_offset, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+    }
 
-        /* we create a block manager cursor */
-        block_manager_cursor_t *cursor = NULL;
+    /* every learned index is its prefix size and its segments */
+    for (uint32_t i = 0; learned && i < index->num_partitions; i++)
+    {
+        tidesdb_sstable_partition_t *partition = &index->partitions[i];
 
-        /* we initialize the cursor */
-        if (block_manager_cursor_init(&cursor, sst->block_manager) == -1)
-        {
-            (void)pthread_rwlock_unlock(&cf->rwlock);
-            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_CURSOR);
-        }
+        memcpy(ptr, &partition->prefix_size, sizeof(uint8_t));
+        ptr += sizeof(uint8_t);
+        memcpy(ptr, &partition->num_segments, sizeof(uint16_t));
+        ptr += sizeof(uint16_t);
 
-        /* if the column family has bloom filters enabled then, well we read
-         * the first block which contains the bloom filter and check if the key exists */
-        if (cf->config.bloom_filter)
+        for (uint16_t s = 0; s < partition->num_segments; s++)
         {
-            block_manager_block_t *block = block_manager_cursor_read(cursor);
-            if (block == NULL)
-            {
-                (void)block_manager_cursor_free(cursor);
-                (void)pthread_rwlock_unlock(&cf->rwlock);
-                return tidesdb_err_from_code(TIDESDB_ERR_KEY_NOT_FOUND);
-            }
-
-            /* we deserialize the bloom filter */
-            bloom_filter_t *bf = bloom_filter_deserialize(block->data);
-            if (bf == NULL)
-            {
-                (void)block_manager_cursor_free(cursor);
-                (void)block_manager_block_free(block);
-                (void)pthread_rwlock_unlock(&cf->rwlock);
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_DESERIALIZE_BLOOM_FILTER);
-            }
-
-            /* we check if the key exists in the bloom filter */
-            if (!bloom_filter_contains(bf, key, key_size))
-            {
-                (void)block_manager_cursor_free(cursor);
-                (void)block_manager_block_free(block);
-                (void)bloom_filter_free(bf);
-                /* we go onto the next sstable */
-                continue;
-            }
-
-            (void)bloom_filter_free(bf);
-            (void)block_manager_block_free(block);
-
-            /* go next block */
-            if (block_manager_cursor_next(cursor) == -1)
-            {
-                (void)block_manager_cursor_free(cursor);
-                (void)pthread_rwlock_unlock(&cf->rwlock);
-                return tidesdb_err_from_code(TIDESDB_ERR_KEY_NOT_FOUND);
-            }
+            tidesdb_sstable_segment_t *segment = &partition->segments[s];
+            memcpy(ptr, &segment->first, sizeof(uint64_t));
+            ptr += sizeof(uint64_t);
+            memcpy(ptr, &segment->offset, sizeof(uint32_t));
+            ptr += sizeof(uint32_t);
+            memcpy(ptr, &segment->entry, sizeof(uint16_t));
+            ptr += sizeof(uint16_t);
+            memcpy(ptr, &segment->slope, sizeof(double));
+            ptr += sizeof(double);
         }
+    }
 
-        block_manager_block_t *block;
-        while ((block = block_manager_cursor_read(cursor)) != NULL)
-        {
-            if (block == NULL) break;
+    return serialized_data;
+}
 
-            /* we deserialize the kv */
-            tidesdb_key_value_pair_t *kv = _tidesdb_deserialize_key_value_pair(
-                block->data, block->size, cf->config.compressed, cf->config.compress_algo);
-            if (kv == NULL)
-            {
-                (void)block_manager_block_free(block);
-                break;
-            }
+tidesdb_sstable_index_t *_tidesdb_deserialize_sstable_index(const uint8_t *data, size_t size)
+{
+    size_t header_size = sizeof(uint32_t) * 2 + sizeof(uint64_t) * 3;
+    size_t partition_size = sizeof(uint64_t) * 2 + sizeof(uint32_t) * 2;
+    if (data == NULL || size < header_size) return NULL;
 
-            /* we check if the key matches */
-            if (_tidesdb_compare_keys(kv->key, kv->key_size, key, key_size) == 0)
-            {
-                /* check if value is a tombstone */
-                if (_tidesdb_is_tombstone(kv->value, kv->value_size))
-                {
-                    (void)block_manager_cursor_free(cursor);
-                    (void)block_manager_block_free(block);
-                    (void)_tidesdb_free_key_value_pair(kv);
-                    (void)pthread_rwlock_unlock(&cf->rwlock);
-                    return tidesdb_err_from_code(TIDESDB_ERR_KEY_NOT_FOUND);
-                }
+    tidesdb_sstable_index_t *index = calloc(1, sizeof(tidesdb_sstable_index_t));
+    if (index == NULL) return NULL;
 
-                /* check if the key has expired */
-                if (_tidesdb_is_expired(kv->ttl))
-                {
-                    (void)block_manager_cursor_free(cursor);
-                    (void)block_manager_block_free(block);
-                    (void)_tidesdb_free_key_value_pair(kv);
-                    (void)pthread_rwlock_unlock(&cf->rwlock);
-                    return tidesdb_err_from_code(TIDESDB_ERR_KEY_NOT_FOUND);
-                }
+    const uint8_t *ptr = data;
+    const uint8_t *end = data + size;
 
-                /* we found the key */
-                *value = malloc(kv->value_size);
-                if (*value == NULL)
-                {
-                    (void)block_manager_cursor_free(cursor);
-                    (void)block_manager_block_free(block);
-                    (void)_tidesdb_free_key_value_pair(kv);
-                    (void)pthread_rwlock_unlock(&cf->rwlock);
-                    return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "value");
-                }
+    memcpy(&index->num_partitions, ptr, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(&index->filter_hashes, ptr, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    memcpy(&index->data_end, ptr, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    memcpy(&index->filter_bits, ptr, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    memcpy(&index->filter_bits_set, ptr, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
 
-                /* we copy the value */
-                memcpy(*value, kv->value, kv->value_size);
+    /* we don't trust a partition count the data can't hold */
+    if (index->num_partitions > (size - header_size) / partition_size)
+    {
+        free(index);
+        return NULL;
+    }
 
-                *value_size = kv->value_size;
+    size_t partitions = index->num_partitions > 0 ? index->num_partitions : 1;
+    index->partitions = calloc(partitions, sizeof(tidesdb_sstable_partition_t));
+    if (index->partitions == NULL)
+    {
+        free(index);
+        return NULL;
+    }
+    index->size = sizeof(tidesdb_sstable_index_t) +
+                  sizeof(tidesdb_sstable_partition_t) * index->num_partitions;
 
-                (void)block_manager_cursor_free(cursor);
-                (void)block_manager_block_free(block);
-                (void)_tidesdb_free_key_value_pair(kv);
-                (void)pthread_rwlock_unlock(&cf->rwlock);
+    for (uint32_t i = 0; i < index->num_partitions; i++)
+    {
+        tidesdb_sstable_partition_t *partition = &index->partitions[i];
+        uint32_t key_size;
+        partition->hash_offset = UINT64_MAX;
 
-                return NULL;
-            }
+        if ((size_t)(end - ptr) < partition_size) break;
+        memcpy(&partition->data_offset, ptr, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+        memcpy(&partition->filter_offset, ptr, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+        memcpy(&partition->entries, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        memcpy(&key_size, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
 
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
+        if ((size_t)(end - ptr) < key_size) break;
+        partition->last_key = malloc(key_size > 0 ? key_size : 1);
+        if (partition->last_key == NULL) break;
+        memcpy(partition->last_key, ptr, key_size);
+        partition->last_key_size = key_size;
+        ptr += key_size;
 
-            if (block_manager_cursor_next(cursor) != 0) break;
-        };
+        index->size += key_size;
+    }
 
-        (void)block_manager_cursor_free(cursor);
+    /* the hash index offsets are there if the partitions leave room for them */
+    if ((size_t)(end - ptr) >= sizeof(uint64_t) * index->num_partitions)
+    {
+        for (uint32_t i = 0; i < index->num_partitions; i++)
+        {
+            memcpy(&index->partitions[i].hash_offset, ptr, sizeof(uint64_t));
+            ptr += sizeof(uint64_t);
+        }
     }
 
-    /* unlock column family */
-    if (pthread_rwlock_unlock(&cf->rwlock) != 0)
+    /* and the learned indexes after them, a learned index we can't read leaves the partition
+     * to be scanned */
+    for (uint32_t i = 0; ptr < end && i < index->num_partitions; i++)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
+        tidesdb_sstable_partition_t *partition = &index->partitions[i];
+        if (_tidesdb_deserialize_learned_index(partition, &ptr, end) == -1) break;
+        index->size += sizeof(tidesdb_sstable_segment_t) * partition->num_segments;
+    }
+
+    /* a partition we could not read leaves its key unset */
+    for (uint32_t i = 0; i < index->num_partitions; i++)
+    {
+        if (index->partitions[i].last_key == NULL)
+        {
+            (void)_tidesdb_free_sstable_index(index);
+            return NULL;
+        }
     }
 
-    return tidesdb_err_from_code(TIDESDB_ERR_KEY_NOT_FOUND);
+    return index;
 }
 
-tidesdb_err_t *tidesdb_delete(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
-                              size_t key_size)
+int _tidesdb_deserialize_learned_index(tidesdb_sstable_partition_t *partition,
+                                       const uint8_t **ptr, const uint8_t *end)
 {
-    /* we check if the db is NULL */
-    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
+    size_t segment_size = sizeof(uint64_t) * 2 + sizeof(uint32_t) + sizeof(uint16_t);
+    uint8_t prefix_size;
+    uint16_t num_segments;
 
-    if (column_family_name == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+    if ((size_t)(end - *ptr) < sizeof(uint8_t) + sizeof(uint16_t)) return -1;
+    memcpy(&prefix_size, *ptr, sizeof(uint8_t));
+    *ptr += sizeof(uint8_t);
+    memcpy(&num_segments, *ptr, sizeof(uint16_t));
+    *ptr += sizeof(uint16_t);
 
-    if (key == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_KEY);
+    if (num_segments == 0) return 0;
+    if ((size_t)(end - *ptr) < segment_size * num_segments) return -1;
 
-    /* get db read lock to get column family */
-    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0)
+    tidesdb_sstable_segment_t *segments = malloc(sizeof(tidesdb_sstable_segment_t) * num_segments);
+    if (segments == NULL) return -1;
+
+    for (uint16_t s = 0; s < num_segments; s++)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
+        memcpy(&segments[s].first, *ptr, sizeof(uint64_t));
+        *ptr += sizeof(uint64_t);
+        memcpy(&segments[s].offset, *ptr, sizeof(uint32_t));
+        *ptr += sizeof(uint32_t);
+        memcpy(&segments[s].entry, *ptr, sizeof(uint16_t));
+        *ptr += sizeof(uint16_t);
+        memcpy(&segments[s].slope, *ptr, sizeof(double));
+        *ptr += sizeof(double);
     }
 
-    /* get column family */
-    tidesdb_column_family_t *cf = NULL;
-    if (_tidesdb_get_column_family(tdb, column_family_name, &cf) == -1)
+    /* the segments have to cover the partition in order for a lookup to find its blocks */
+    bool valid = segments[0].entry == 0 && prefix_size <= partition->last_key_size &&
+                 segments[num_segments - 1].entry < partition->entries;
+    for (uint16_t s = 0; valid && s < num_segments; s++)
     {
-        (void)pthread_rwlock_unlock(&tdb->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+        if (!(segments[s].slope >= 0.0) || segments[s].slope > DBL_MAX) valid = false;
+        if (s > 0 && (segments[s].entry <= segments[s - 1].entry ||
+                      segments[s].first <= segments[s - 1].first))
+            valid = false;
     }
 
-    /* release db read lock */
-    if (pthread_rwlock_unlock(&tdb->rwlock) != 0)
+    if (!valid)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "db");
+        free(segments);
+        return -1;
     }
 
-    /* get column family write lock */
-    if (pthread_rwlock_wrlock(&cf->rwlock) != 0)
+    partition->prefix_size = prefix_size;
+    partition->num_segments = num_segments;
+    partition->segments = segments;
+
+    return 0;
+}
+
+void _tidesdb_free_sstable_index(tidesdb_sstable_index_t *index)
+{
+    if (index == NULL) return;
+
+    if (index->partitions != NULL)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
+        for (uint32_t i = 0; i < index->num_partitions; i++)
+        {
+            free(index->partitions[i].last_key);
+            free(index->partitions[i].segments);
+        }
+        free(index->partitions);
     }
 
-    uint8_t *tombstone = malloc(4);
-    if (tombstone == NULL) return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "tombstone");
+    free(index);
+}
 
-    uint32_t tombstone_value = TOMBSTONE;
-    memcpy(tombstone, &tombstone_value, sizeof(uint32_t));
+tidesdb_sstable_index_t *_tidesdb_read_sstable_index(block_manager_t *bm)
+{
+    /* the footer is a block of its own at the very end of the file */
+    uint64_t footer_size = sizeof(uint64_t) * 3;
+    struct stat st;
+    if (stat(bm->file_path, &st) != 0 || (uint64_t)st.st_size < footer_size) return NULL;
 
-    /* append to wal */
-    if (_tidesdb_append_to_wal(cf->wal, key, key_size, tombstone, 4, 0, TIDESDB_OP_DELETE,
-                               column_family_name) == -1)
+    block_manager_cursor_t *cursor = NULL;
+    if (block_manager_cursor_init(&cursor, bm) == -1) return NULL;
+
+    uint64_t footer_offset = (uint64_t)st.st_size - footer_size;
+    cursor->current_pos = footer_offset;
+
+    uint64_t index_offset = UINT64_MAX;
+    uint64_t magic = 0;
+    block_manager_block_t *block = block_manager_cursor_read(cursor);
+    if (block != NULL && block->size == sizeof(uint64_t) * 2)
     {
-        free(tombstone);
-        (void)pthread_rwlock_unlock(&cf->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_APPEND_TO_WAL);
+        memcpy(&index_offset, block->data, sizeof(uint64_t));
+        memcpy(&magic, (uint8_t *)block->data + sizeof(uint64_t), sizeof(uint64_t));
     }
-    /* add to memtable */
-    if (skip_list_put(cf->memtable, key, key_size, tombstone, 4, -1) == -1)
+    if (block != NULL) (void)block_manager_block_free(block);
+
+    tidesdb_sstable_index_t *index = NULL;
+    if (magic == TDB_SSTABLE_FOOTER_MAGIC && index_offset < footer_offset)
     {
-        free(tombstone);
-        (void)pthread_rwlock_unlock(&cf->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_PUT_TO_MEMTABLE);
+        cursor->current_pos = index_offset;
+        block = block_manager_cursor_read(cursor);
+        if (block != NULL)
+        {
+            index = _tidesdb_deserialize_sstable_index(block->data, block->size);
+            (void)block_manager_block_free(block);
+        }
     }
 
-    free(tombstone);
+    (void)block_manager_cursor_free(cursor);
 
-    /* we check if the memtable has reached the flush threshold */
-    switch (cf->config.memtable_ds)
+    /* the key value blocks can't run into the index */
+    if (index != NULL && index->data_end > index_offset)
     {
-        case TDB_MEMTABLE_SKIP_LIST:
-            if ((int)((skip_list_t *)cf->memtable)->total_size >= cf->config.flush_threshold)
-            {
-                if (cf->config.bloom_filter)
-                {
-                    if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                        else /* hash table */
-                        {
-                            if (_tidesdb_flush_memtable_w_bloomfilter_f_hash_table(cf) == -1)
-                            {
-                                (void)pthread_rwlock_unlock(&cf->rwlock);
-                                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                            }
-                        }
-                    }
-                }
-                else
-                {
-                    if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else /* hash table */
-                    {
-                        if (_tidesdb_flush_memtable_f_hash_table(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-            }
-            break;
-        case TDB_MEMTABLE_HASH_TABLE:
-            if ((int)((hash_table_t *)cf->memtable)->total_size >= cf->config.flush_threshold)
-            {
-                if (cf->config.bloom_filter)
-                {
-                    if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                        else /* hash table */
-                        {
-                            if (_tidesdb_flush_memtable_w_bloomfilter_f_hash_table(cf) == -1)
-                            {
-                                (void)pthread_rwlock_unlock(&cf->rwlock);
-                                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                            }
-                        }
-                    }
-                }
-                else
-                {
-                    if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else /* hash table */
-                    {
-                        if (_tidesdb_flush_memtable_f_hash_table(cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-            }
-            break;
-        default:
-            if (pthread_rwlock_unlock(&cf->rwlock) != 0)
-            {
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
-            }
+        (void)_tidesdb_free_sstable_index(index);
+        return NULL;
+    }
+
+    return index;
+}
 
-            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
+tidesdb_sstable_index_t *_tidesdb_set_sstable_index(tidesdb_sstable_t *sst,
+                                                    tidesdb_sstable_index_t *index)
+{
+    tidesdb_sstable_index_t *expected = NULL;
+    if (!atomic_compare_exchange_strong(&sst->index, &expected, index))
+    {
+        (void)_tidesdb_free_sstable_index(index);
+        return expected;
     }
 
-    /* release column family write lock */
-    if (pthread_rwlock_unlock(&cf->rwlock) != 0)
+    /* the partition filters together are the filter of the sstable */
+    if (index->filter_bits > 0 && atomic_load(&sst->bloom_bits) == 0)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
+        atomic_store(&sst->bloom_bits_set, (int)index->filter_bits_set);
+        atomic_store(&sst->bloom_hashes, (int)index->filter_hashes);
+        atomic_store(&sst->bloom_bits, (int)index->filter_bits);
     }
 
-    return NULL;
+    return index;
 }
 
-int _tidesdb_is_tombstone(const uint8_t *value, size_t value_size)
+tidesdb_sstable_index_t *_tidesdb_sstable_index(tidesdb_sstable_t *sst)
 {
-    return value_size == 4 && *(uint32_t *)value == TOMBSTONE;
+    tidesdb_sstable_index_t *index = atomic_load(&sst->index);
+    if (index != NULL) return index;
+
+    /* the index stays pinned once read, racing readers keep whichever got there first */
+    index = _tidesdb_read_sstable_index(sst->block_manager);
+    if (index == NULL) return NULL;
+
+    return _tidesdb_set_sstable_index(sst, index);
 }
 
-int _tidesdb_append_to_wal(tidesdb_wal_t *wal, const uint8_t *key, size_t key_size,
-                           const uint8_t *value, size_t value_size, time_t ttl,
-                           TIDESDB_OP_CODE op_code, const char *cf)
+tidesdb_sstable_partition_t *_tidesdb_find_partition(tidesdb_sstable_index_t *index,
+                                                     const uint8_t *key, size_t key_size)
 {
-    /* we append to column families write ahead log */
+    uint32_t low = 0;
+    uint32_t high = index->num_partitions;
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        tidesdb_sstable_partition_t *partition = &index->partitions[mid];
+        if (_tidesdb_compare_keys(partition->last_key, partition->last_key_size, key, key_size) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
 
-    /* we create an operation struct */
-    tidesdb_operation_t *op = malloc(sizeof(tidesdb_operation_t));
-    if (op == NULL) return -1;
+    return low < index->num_partitions ? &index->partitions[low] : NULL;
+}
 
-    op->cf_name = strdup(cf);
-    op->kv = malloc(sizeof(tidesdb_key_value_pair_t));
-    if (op->kv == NULL)
-    {
-        (void)_tidesdb_free_operation(op);
-        return -1;
-    }
+int _tidesdb_write_sstable(tidesdb_column_family_t *cf, skip_list_t *list, bool drop_deleted,
+                           rate_limiter_priority_t priority, tidesdb_sstable_t **sst)
+{
+    return _tidesdb_write_sstable_range(cf, list, NULL, NULL, drop_deleted, priority, sst, NULL);
+}
 
-    op->kv->key = malloc(key_size);
-    if (op->kv->key == NULL)
-    {
-        (void)_tidesdb_free_operation(op);
-        return -1;
-    }
+int _tidesdb_write_sstable_range(tidesdb_column_family_t *cf, skip_list_t *list,
+                                 skip_list_node_t *start, skip_list_node_t *end,
+                                 bool drop_deleted, rate_limiter_priority_t priority,
+                                 tidesdb_sstable_t **sst, tidesdb_dropped_t *dropped)
+{
+    if (_tidesdb_open_sstable(cf, _tidesdb_next_sstable_id(cf), sst) == -1) return -1;
 
-    /* we copy the key */
-    memcpy(op->kv->key, key, key_size);
+    /* if something fails we mark the sstable obsolete so releasing it removes the partial file */
+    int rc = 0;
 
-    op->kv->value = malloc(value_size);
-    if (op->kv->value == NULL)
+    /* a partitioned sstable writes its filters after the key value blocks, one per partition */
+    bool partitioned = cf->config.partitioned_index;
+    tidesdb_partition_builder_t builder = {0};
+    if (partitioned)
     {
-        (void)_tidesdb_free_operation(op);
-        return -1;
+        builder.index = calloc(1, sizeof(tidesdb_sstable_index_t));
+        if (builder.index == NULL) rc = -1;
+        if (builder.index != NULL) builder.index->size = sizeof(tidesdb_sstable_index_t);
     }
 
-    /* we copy the value */
-    memcpy(op->kv->value, value, value_size);
+    /* otherwise the filter goes in the initial block */
+    if (!partitioned && cf->config.bloom_filter &&
+        cf->config.filter_type == TDB_FILTER_BINARY_FUSE)
+        rc = _tidesdb_write_fuse_filter_block(cf, list, start, end, drop_deleted, *sst);
+    else if (!partitioned && cf->config.bloom_filter)
+        rc = _tidesdb_write_bloom_filter_block(cf, list, start, end, drop_deleted, *sst);
+
+    skip_list_cursor_t *cursor = rc == 0 ? skip_list_cursor_init(list) : NULL;
+    if (cursor == NULL) rc = -1;
+    if (cursor != NULL && start != NULL) cursor->current = start;
+
+    uint8_t *key;
+    size_t key_size;
+    uint8_t *value;
+    size_t value_size;
+    time_t ttl;
 
-    op->kv->key_size = key_size;
+    /* we write the key value pairs in key order */
+    while (rc == 0 && cursor->current != end &&
+           skip_list_cursor_get(cursor, &key, &key_size, &value, &value_size, &ttl) == 0)
+    {
+        /* when nothing older can be shadowed we can drop deletes and expired keys for good, the
+         * skip list turns expired values into tombstones so we check the ttl first */
+        bool expired = drop_deleted && _tidesdb_is_expired(ttl);
+        bool tombstone = drop_deleted && !expired && _tidesdb_is_tombstone(value, value_size);
+        if (dropped != NULL && tombstone) dropped->tombstones++;
+        if (dropped != NULL && expired) dropped->expired++;
 
-    op->kv->value_size = value_size;
+        if (!tombstone && !expired)
+        {
+            tidesdb_key_value_pair_t kv = {.key = key,
+                                           .key_size = key_size,
+                                           .value = value,
+                                           .value_size = value_size,
+                                           .ttl = ttl};
+
+            size_t serialized_size;
+            uint8_t *serialized_kv = _tidesdb_serialize_key_value_pair(
+                &kv, &serialized_size, cf->config.compressed, cf->config.compress_algo);
+            if (serialized_kv == NULL)
+            {
+                rc = -1;
+                break;
+            }
 
-    op->kv->ttl = ttl;
+            block_manager_block_t *block =
+                block_manager_block_create(serialized_size, serialized_kv);
+            free(serialized_kv);
+            if (block == NULL)
+            {
+                rc = -1;
+                break;
+            }
 
-    op->op_code = op_code;
+            /* we wait for our share of the flush and compaction write budget.  a flush holds the
+             * column family write lock, if it waited every read and write of the column family
+             * would wait with it, so it takes its share without waiting and compactions pay
+             * the debt back */
+            rate_limiter_t *rl = cf->tdb != NULL ? cf->tdb->rate_limiter : NULL;
+            if (priority == RATE_LIMITER_PRIORITY_HIGH)
+                (void)rate_limiter_charge(rl, sizeof(uint64_t) + serialized_size, priority);
+            else
+                (void)rate_limiter_request(rl, sizeof(uint64_t) + serialized_size, priority);
+
+            if (block_manager_block_write((*sst)->block_manager, block) == -1) rc = -1;
+            (void)block_manager_block_free(block);
 
-    /* now we serialize the operation */
-    size_t serialized_size;
-    uint8_t *serialized_op =
-        _tidesdb_serialize_operation(op, &serialized_size, wal->compress, wal->compress_algo);
-    if (serialized_op == NULL)
-    {
-        (void)_tidesdb_free_operation(op);
-        return -1;
-    }
+            if (rc == 0 && partitioned &&
+                _tidesdb_partition_add(cf, &builder, key, key_size,
+                                       sizeof(uint64_t) + serialized_size) == -1)
+                rc = -1;
+        }
 
-    block_manager_block_t *block = block_manager_block_create(serialized_size, serialized_op);
-    if (block == NULL)
-    {
-        (void)_tidesdb_free_operation(op);
-        free(serialized_op);
-        return -1;
+        /* we stop before stepping onto the next range, another thread may be writing it */
+        if (cursor->current->forward[0] == end) break;
+        if (skip_list_cursor_next(cursor) == -1) break;
     }
 
-    /* we append to the wal */
-    if (block_manager_block_write(wal->block_manager, block) == -1)
+    if (cursor != NULL) (void)skip_list_cursor_free(cursor);
+
+    if (rc == 0 && partitioned) rc = _tidesdb_finish_partitioned_sstable(cf, &builder, *sst);
+    (void)_tidesdb_free_partition_builder(cf, &builder);
+
+    /* the sstable is immutable from here on so we sync it once */
+    if (rc == 0) rc = block_manager_sync((*sst)->block_manager);
+
+    if (rc == -1)
     {
-        (void)block_manager_block_free(block);
-        (void)_tidesdb_free_operation(op);
-        free(serialized_op);
+        atomic_store(&(*sst)->obsolete, true);
+        (void)_tidesdb_release_sstable(*sst);
+        *sst = NULL;
         return -1;
     }
 
-    (void)_tidesdb_free_operation(op);
-    (void)block_manager_block_free(block);
-    free(serialized_op);
-
     return 0;
 }
 
-int _tidesdb_flush_memtable(tidesdb_column_family_t *cf)
+int _tidesdb_flush_memtable(tidesdb_column_family_t *cf, tidesdb_flush_info_t *info)
 {
-    /* we create a new sstable struct */
-    tidesdb_sstable_t *sst = malloc(sizeof(tidesdb_sstable_t));
-    if (sst == NULL) return -1;
+    tidesdb_flush_info_t unreported;
+    if (info == NULL) info = &unreported;
 
-    /* we create a new sstable with a named based on the amount of sstables */
-    char sstable_path[MAX_FILE_PATH_LENGTH];
-    snprintf(sstable_path, sizeof(sstable_path), "%s%s%s%d%s", cf->path,
-             _tidesdb_get_path_seperator(), TDB_SSTABLE_PREFIX, cf->num_sstables, TDB_SSTABLE_EXT);
+    (void)_tidesdb_trace(cf, TDB_TRACE_FLUSH, true);
 
-    /* we create a new block manager */
-    block_manager_t *sstable_block_manager = NULL;
+    *info = (tidesdb_flush_info_t){.column_family = cf->config.name};
+    uint64_t start = _tidesdb_now_ns();
 
-    if (block_manager_open(&sstable_block_manager, sstable_path, TDB_SYNC_INTERVAL) == -1)
-    {
-        return -1;
-    }
+    for (int i = 0; i < cf->config.memtable_shards; i++)
+        info->memtable_bytes += _tidesdb_memtable_size(cf, &cf->shards[i]);
 
-    /* we set the block manager */
-    sst->block_manager = sstable_block_manager;
+    int rc = _tidesdb_flush_memtable_to_sstable(cf, info);
 
-    /* we create a new skip list cursor and populate the memtable
-     * with serialized key value pairs */
+    info->elapsed_us = (_tidesdb_now_ns() - start) / 1000;
+    info->status = rc;
 
-    skip_list_cursor_t *cursor = skip_list_cursor_init(cf->memtable);
-    if (cursor == NULL)
-    {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
-    }
+    (void)_tidesdb_trace(cf, TDB_TRACE_FLUSH, false);
 
-    /* we iterate over the memtable and write to the sstable */
-    do
-    {
-        /* we get the key value pair */
-        tidesdb_key_value_pair_t *kv = malloc(sizeof(tidesdb_key_value_pair_t));
-        if (kv == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    return rc;
+}
 
-        /* we get the key */
+void _tidesdb_report_flush(tidesdb_column_family_t *cf, const tidesdb_flush_info_t *info)
+{
+    const tidesdb_event_listener_t *listener = _tidesdb_listener(cf);
+    if (listener == NULL) return;
 
-        uint8_t *retrieved_key;
-        size_t key_size;
-        uint8_t *retrieved_value;
-        size_t value_size;
-        time_t ttl;
-        if (skip_list_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size,
-                                 &ttl) == -1)
-        {
-            free(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    if (listener->on_flush_begin != NULL)
+    {
+        /* the listener sees the flush as it was when it began */
+        tidesdb_flush_info_t begin = {.column_family = info->column_family,
+                                      .memtable_bytes = info->memtable_bytes};
+        listener->on_flush_begin(&begin, listener->arg);
+    }
 
-        /* we copy the key */
-        kv->key = malloc(key_size);
-        if (kv->key == NULL)
-        {
-            free(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
-        memcpy(kv->key, retrieved_key, key_size);
+    if (listener->on_flush_completed != NULL) listener->on_flush_completed(info, listener->arg);
 
-        /* we copy the value */
-        kv->value = malloc(value_size);
-        if (kv->value == NULL)
-        {
-            free(kv->key);
-            free(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    if (info->status == -1)
+        (void)_tidesdb_background_error(cf, TDB_BACKGROUND_FLUSH,
+                                        TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
 
-        memcpy(kv->value, retrieved_value, value_size);
+    (void)_tidesdb_update_stall_condition(cf);
+}
 
-        /* we set the key size */
-        kv->key_size = key_size;
-        /* we set the value size */
-        kv->value_size = value_size;
-        /* we set the ttl */
-        kv->ttl = ttl;
+int _tidesdb_flush_memtable_to_sstable(tidesdb_column_family_t *cf, tidesdb_flush_info_t *info)
+{
+    uint64_t start = _tidesdb_now_ns();
+    skip_list_t *list = NULL;
 
-        /* we serialize the key value pair */
-        size_t serialized_size;
-        uint8_t *serialized_kv = _tidesdb_serialize_key_value_pair(
-            kv, &serialized_size, cf->config.compressed, cf->config.compress_algo);
-        if (serialized_kv == NULL)
-        {
-            (void)_tidesdb_free_key_value_pair(kv);
-            free(sst);
-            remove(sstable_path);
-            return -1;
-        }
+    /* a single skip list memtable is already sorted, otherwise we merge the shards (and sort a
+     * hash table memtable) through a temporary skip list */
+    if (cf->config.memtable_shards == 1 && cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
+        list = cf->shards[0].memtable;
+    else
+        list = _tidesdb_memtable_snapshot(cf);
 
-        (void)_tidesdb_free_key_value_pair(kv);
+    if (list == NULL) return -1;
 
-        /* we create a new block */
-        block_manager_block_t *block = block_manager_block_create(serialized_size, serialized_kv);
-        if (block == NULL)
-        {
-            free(sst);
-            free(serialized_kv);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    /* a temporary skip list is counted as a merge table until we destroy it */
+    size_t merge_size = list != cf->shards[0].memtable ? list->total_size : 0;
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_MEM_MERGE_TABLES, merge_size);
 
-        /* we write the block to the sstable */
-        if (block_manager_block_write(sst->block_manager, block) == -1)
-        {
-            (void)block_manager_block_free(block);
-            free(sst);
-            free(serialized_kv);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    /* we write the memtable to a new sstable */
+    tidesdb_sstable_t *sst = NULL;
+    int rc = _tidesdb_write_sstable(cf, list, false, RATE_LIMITER_PRIORITY_HIGH, &sst);
 
-        /* we free the resources */
-        (void)block_manager_block_free(block);
-        free(serialized_kv);
+    if (list != cf->shards[0].memtable) (void)skip_list_destroy(list);
+    (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_MERGE_TABLES, merge_size);
 
-    } while (skip_list_cursor_next(cursor) != -1);
+    if (rc == -1) return -1;
 
-    /* we free the cursor */
-    (void)skip_list_cursor_free(cursor);
+    /* we install a new version with the sstable as the newest */
+    (void)pthread_mutex_lock(&cf->version_lock);
 
-    /* we add the sstable to the column family */
-    if (cf->sstables == NULL)
-    {
-        cf->sstables = malloc(sizeof(tidesdb_sstable_t));
-        if (cf->sstables == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
-    }
-    else
+    tidesdb_version_t *current = cf->version;
+    tidesdb_sstable_t **sstables =
+        malloc(sizeof(tidesdb_sstable_t *) * (current->num_sstables + 1));
+    tidesdb_version_t *version = NULL;
+    if (sstables != NULL)
     {
-        tidesdb_sstable_t **temp_sstables =
-            realloc(cf->sstables, sizeof(tidesdb_sstable_t) * (cf->num_sstables + 1));
-        if (temp_sstables == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+        for (int i = 0; i < current->num_sstables; i++) sstables[i] = current->sstables[i];
+        sstables[current->num_sstables] = sst;
 
-        cf->sstables = temp_sstables;
+        version = _tidesdb_version_new(sstables, current->num_sstables + 1);
+        free(sstables);
     }
 
-    /* we increment the number of sstables
-     * and set the sstable
-     */
-    cf->sstables[cf->num_sstables] = sst;
-    cf->num_sstables++;
-
-    /* clear memtable */
-    if (skip_list_clear(cf->memtable) == -1)
+    if (version == NULL || _tidesdb_install_version(cf, version) == -1)
     {
-        free(sst);
-        (void)remove(sstable_path);
+        (void)pthread_mutex_unlock(&cf->version_lock);
+        if (version != NULL) (void)_tidesdb_release_version(version);
+        atomic_store(&sst->obsolete, true);
+        (void)_tidesdb_release_sstable(sst);
         return -1;
     }
 
-    /* truncate the wal */
-    if (block_manager_truncate(cf->wal->block_manager) == -1)
+    (void)pthread_mutex_unlock(&cf->version_lock);
+
+    uint64_t size = _tidesdb_sstable_size(sst);
+    info->sstable_id = sst->id;
+    info->bytes_written = size;
+
+    /* the version holds its own reference on the sstable now */
+    (void)_tidesdb_release_sstable(sst);
+
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_FLUSHES, 1);
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_FLUSH_BYTES, size);
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BYTES_WRITTEN, size);
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_FLUSH_US, (_tidesdb_now_ns() - start) / 1000);
+
+    /* clear every shard memtable and truncate its wal, they were all flushed together */
+    for (int i = 0; i < cf->config.memtable_shards; i++)
     {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        if (_tidesdb_memtable_clear(cf, &cf->shards[i]) == -1) return -1;
+
+        if (block_manager_truncate(cf->shards[i].wal->block_manager) == -1) return -1;
     }
 
     return 0;
@@ -2352,62 +4901,116 @@ tidesdb_err_t *tidesdb_compact_sstables(tidesdb_t *tdb, const char *column_famil
 
     if (max_threads < 1) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MAX_THREADS);
 
-    /* get db read lock */
-    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0)
-    {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
-    }
-
-    /* get column family */
+    /* get column family, we hold a reference on it for the duration of the compaction */
     tidesdb_column_family_t *cf = NULL;
-    if (_tidesdb_get_column_family(tdb, column_family_name, &cf) == -1)
-        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family_name, &cf);
+    if (e != NULL) return e;
 
-    /* release db read lock */
-    if (pthread_rwlock_unlock(&tdb->rwlock) != 0)
+    e = _tidesdb_compact_sstables(cf, max_threads);
+
+    (void)_tidesdb_release_column_family(cf);
+
+    return e;
+}
+
+tidesdb_err_t *tidesdb_compact_sstables_w_handle(tidesdb_cf_handle_t *handle, int max_threads)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    return _tidesdb_compact_sstables(handle->cf, max_threads);
+}
+
+tidesdb_err_t *_tidesdb_compact_sstables(tidesdb_column_family_t *cf, int max_threads)
+{
+    if (max_threads < 1) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MAX_THREADS);
+
+    /* only one compaction runs on a column family at a time, reads and writes carry on while we
+     * merge as we never take the column family lock */
+    if (pthread_mutex_lock(&cf->compaction_lock) != 0)
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "compaction");
+
+    /* we check if the column family was dropped */
+    if (cf->dropped)
     {
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "db");
+        (void)pthread_mutex_unlock(&cf->compaction_lock);
+        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
     }
 
-    /* acquire the lock for column family */
-    if (pthread_rwlock_wrlock(&cf->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
+    /* we pin the version we are compacting, flushes may add newer sstables in the meantime */
+    tidesdb_version_t *base = _tidesdb_acquire_version(cf);
 
     /* check if enough sstables to run a compaction */
-    int num_sstables = cf->num_sstables;
+    int num_sstables = base->num_sstables;
     if (num_sstables < 2)
     {
-        (void)pthread_rwlock_unlock(&cf->rwlock);
+        (void)_tidesdb_release_version(base);
+        (void)pthread_mutex_unlock(&cf->compaction_lock);
         return tidesdb_err_from_code(TIDESDB_ERR_INVALID_SSTABLES_FOR_COMPACTION);
     }
 
-    /* give er a sort */
-    qsort(cf->sstables, num_sstables, sizeof(tidesdb_sstable_t *), _tidesdb_compare_sstables);
+    int num_pairs = num_sstables / 2;
+
+    (void)_tidesdb_trace(cf, TDB_TRACE_COMPACTION, true);
+
+    /* the job arguments live until every merge is done so we allocate them all at once, they
+     * also hold the merged sstables of each pair */
+    tidesdb_compact_thread_args_t *args = malloc(sizeof(tidesdb_compact_thread_args_t) * num_pairs);
+    if (args == NULL)
+    {
+        (void)_tidesdb_trace(cf, TDB_TRACE_COMPACTION, false);
+        (void)_tidesdb_release_version(base);
+        (void)pthread_mutex_unlock(&cf->compaction_lock);
+        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "compaction jobs");
+    }
+
+    /* the event listener is told which sstables we merge and how much they hold */
+    const tidesdb_event_listener_t *listener = _tidesdb_listener(cf);
+    bool listening = listener->on_compaction_begin != NULL ||
+                     listener->on_compaction_completed != NULL;
+    tidesdb_compaction_info_t info = {.column_family = cf->config.name};
+    uint64_t *input_ids = listening ? malloc(sizeof(uint64_t) * num_pairs * 2) : NULL;
+    uint64_t start = _tidesdb_now_ns();
+    if (input_ids != NULL)
+    {
+        for (int i = 0; i < num_pairs * 2; i++)
+        {
+            input_ids[i] = base->sstables[i]->id;
+            info.bytes_in += _tidesdb_sstable_size(base->sstables[i]);
+        }
+        info.input_ids = input_ids;
+        info.num_inputs = num_pairs * 2;
+    }
+    if (listener->on_compaction_begin != NULL) listener->on_compaction_begin(&info, listener->arg);
 
     sem_t sem;
     sem_init(&sem, 0, max_threads); /* initialize the semaphore */
 
-    /* we create a temp lock which is shared between threads for sstable path creation */
-    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
-
-    /* we iterate over the sstables pairing and merging them */
-    for (int i = 0; i < num_sstables - 1; i += 2)
+    /* we iterate over the sstables pairing them and submitting their merges to the background
+     * pool, the pool bounds the threads across the db and max_threads bounds this compaction */
+    for (int p = 0; p < num_pairs; p++)
     {
-        sem_wait(&sem); /* we wait if the maximum number of threads is reached */
+        sem_wait(&sem); /* we wait if the maximum number of merges is in flight */
 
-        tidesdb_compact_thread_args_t *args = malloc(sizeof(tidesdb_compact_thread_args_t));
-        args->cf = cf;
-        args->start = i;
-        args->end = i + 1;
-        args->sem = &sem;
-        args->lock = &lock;
+        args[p].cf = cf;
+        args[p].sst1 = base->sstables[p * 2];
+        args[p].sst2 = base->sstables[p * 2 + 1];
+        args[p].bottommost = p == 0;
+        args[p].outputs = NULL;
+        args[p].num_outputs = 0;
+        args[p].dropped = (tidesdb_dropped_t){0};
+        args[p].sem = &sem;
 
-        pthread_t thread;
-        (void)pthread_create(&thread, NULL, _tidesdb_compact_sstables_thread, args);
-        (void)pthread_detach(thread);
+        if (thread_pool_submit(cf->tdb->background_pool, THREAD_POOL_PRIORITY_MEDIUM,
+                               _tidesdb_compact_sstables_job, &args[p]) == -1)
+        {
+            /* we merge the pair on this thread instead */
+            _tidesdb_compact_sstables_job(&args[p]);
+        }
     }
 
-    /* wait for all compaction threads to finish */
+    /* wait for all merges to finish */
     for (int i = 0; i < max_threads; i++)
     {
         sem_wait(&sem);
@@ -2415,338 +5018,429 @@ tidesdb_err_t *tidesdb_compact_sstables(tidesdb_t *tdb, const char *column_famil
 
     (void)sem_destroy(&sem); /* destroy the semaphore */
 
-    /* remove the sstables that were compacted
-     * the ones that are NULL; one would be null the ith+1 sstable
-     */
-    int j = 0;
-    for (int i = 0; i < num_sstables; i++)
+    /* we build the new version, each merged pair is replaced by its outputs at the position of
+     * the older input and sstables flushed since we pinned the base are kept as they are.  the
+     * outputs of a pair hold disjoint key ranges so their order among themselves doesn't matter
+     * to reads, we keep them in key order */
+    (void)pthread_mutex_lock(&cf->version_lock);
+
+    /* the column family may have been dropped while we merged, drop waits for us before it
+     * removes the directory so we must not write the manifest, our outputs are removed below */
+    bool dropped = cf->dropped;
+
+    tidesdb_version_t *current = cf->version;
+    int num_new = current->num_sstables;
+    for (int p = 0; p < num_pairs; p++)
+        if (args[p].outputs != NULL) num_new += args[p].num_outputs - 2;
+
+    tidesdb_sstable_t **sstables = dropped ? NULL : malloc(sizeof(tidesdb_sstable_t *) * num_new);
+    tidesdb_version_t *version = NULL;
+    if (sstables != NULL)
     {
-        if (cf->sstables[i] != NULL) cf->sstables[j++] = cf->sstables[i];
+        int n = 0;
+        for (int i = 0; i < current->num_sstables; i++)
+        {
+            if (i < num_pairs * 2 && args[i / 2].outputs != NULL)
+            {
+                /* the base is a prefix of the current version as only compaction removes
+                 * sstables and we hold the compaction lock */
+                if (i % 2 == 0)
+                    for (int o = 0; o < args[i / 2].num_outputs; o++)
+                        sstables[n++] = args[i / 2].outputs[o];
+                continue;
+            }
+
+            sstables[n++] = current->sstables[i];
+        }
+
+        version = _tidesdb_version_new(sstables, n);
+        free(sstables);
     }
 
-    cf->num_sstables = j;
+    int rc = -1;
+    if (version != NULL) rc = _tidesdb_install_version(cf, version);
 
-    /* destroy shared lock */
-    if (pthread_mutex_destroy(&lock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_DESTROY_LOCK, "shared compaction lock");
+    if (rc == 0)
+    {
+        /* the inputs are gone from the current version, their files are removed once the last
+         * reader pinning an older version is done with them */
+        for (int p = 0; p < num_pairs; p++)
+        {
+            if (args[p].outputs == NULL) continue;
+            atomic_store(&base->sstables[p * 2]->obsolete, true);
+            atomic_store(&base->sstables[p * 2 + 1]->obsolete, true);
+        }
+    }
 
-    /* unlock the column family */
-    if (pthread_rwlock_unlock(&cf->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
+    (void)pthread_mutex_unlock(&cf->version_lock);
+
+    if (rc == -1 && version != NULL) (void)_tidesdb_release_version(version);
+
+    /* a pair that failed to merge keeps its inputs, the compaction carries on without it */
+    bool failed = rc == -1;
+    for (int p = 0; p < num_pairs; p++)
+        if (args[p].outputs == NULL) failed = true;
+
+    /* we describe the outputs while we still hold them, on failure they are removed below */
+    uint64_t *output_ids = NULL;
+    if (listener->on_compaction_completed != NULL)
+    {
+        int num_outputs = 0;
+        for (int p = 0; p < num_pairs; p++) num_outputs += args[p].num_outputs;
+
+        output_ids = num_outputs > 0 ? malloc(sizeof(uint64_t) * num_outputs) : NULL;
+        for (int p = 0; p < num_pairs; p++)
+        {
+            for (int o = 0; o < args[p].num_outputs; o++)
+            {
+                if (output_ids != NULL) output_ids[info.num_outputs++] = args[p].outputs[o]->id;
+                info.bytes_out += _tidesdb_sstable_size(args[p].outputs[o]);
+            }
+            info.dropped_tombstones += args[p].dropped.tombstones;
+            info.expired_keys += args[p].dropped.expired;
+        }
+
+        info.output_ids = output_ids;
+        info.elapsed_us = (_tidesdb_now_ns() - start) / 1000;
+        info.status = failed ? -1 : 0;
+    }
+
+    /* we drop the references we held on the outputs, on failure this removes them */
+    for (int p = 0; p < num_pairs; p++)
+    {
+        if (args[p].outputs == NULL) continue;
+        for (int o = 0; o < args[p].num_outputs; o++)
+        {
+            if (rc == -1) atomic_store(&args[p].outputs[o]->obsolete, true);
+            (void)_tidesdb_release_sstable(args[p].outputs[o]);
+        }
+        free(args[p].outputs);
+    }
+
+    free(args);
+    (void)_tidesdb_release_version(base);
+
+    (void)_tidesdb_trace(cf, TDB_TRACE_COMPACTION, false);
+
+    (void)pthread_mutex_unlock(&cf->compaction_lock);
+
+    /* the event listener is told once the compaction is over so its callbacks may compact or drop
+     * the column family */
+    if (rc == 0) (void)_tidesdb_update_stall_condition(cf);
+
+    if (listener->on_compaction_completed != NULL)
+        listener->on_compaction_completed(&info, listener->arg);
+    free(output_ids);
+    free(input_ids);
+
+    if (failed && !dropped)
+        (void)_tidesdb_background_error(cf, TDB_BACKGROUND_COMPACTION,
+                                        TIDESDB_ERR_FAILED_TO_COMPACT_SSTABLES);
+
+    if (dropped) return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+
+    if (rc == -1) return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_COMPACT_SSTABLES);
 
     return NULL;
 }
 
-void *_tidesdb_compact_sstables_thread(void *arg)
+void _tidesdb_compact_sstables_job(void *arg)
 {
     tidesdb_compact_thread_args_t *args = arg;
-    tidesdb_column_family_t *cf = args->cf;
-    int start = args->start;
-    int end = args->end;
 
-    tidesdb_sstable_t *merged_sstable = NULL;
-    if (!cf->config.bloom_filter)
-    {
-        /* merge the current and ith+1 sstables */
-        merged_sstable =
-            _tidesdb_merge_sstables(cf->sstables[start], cf->sstables[end], cf, args->lock);
-    }
-    else
+    /* merge the pair, the inputs stay in place until the new version is installed */
+    (void)_tidesdb_merge_sstables(args->cf, args->sst1, args->sst2, args->bottommost,
+                                  &args->outputs, &args->num_outputs, &args->dropped);
+
+    (void)sem_post(args->sem); /* signal the merge is done */
+}
+
+int _tidesdb_read_sstable_into(tidesdb_column_family_t *cf, tidesdb_sstable_t *sst,
+                               skip_list_t *list)
+{
+    block_manager_cursor_t *cursor = NULL;
+    if (block_manager_cursor_init(&cursor, sst->block_manager) == -1) return -1;
+
+    /* a partitioned sstable starts with its key value blocks and ends them at data_end */
+    uint64_t data_end = UINT64_MAX;
+    if (cf->config.partitioned_index)
     {
-        /* with bloom filter */
-        merged_sstable = _tidesdb_merge_sstables_w_bloomfilter(cf->sstables[start],
-                                                               cf->sstables[end], cf, args->lock);
+        tidesdb_sstable_index_t *index = _tidesdb_sstable_index(sst);
+        if (index == NULL)
+        {
+            (void)block_manager_cursor_free(cursor);
+            return -1;
+        }
+        data_end = index->data_end;
     }
 
-    /* we check if the merged is NULL */
-    if (merged_sstable == NULL)
+    /* otherwise the initial block holds the bloom filter if the column family has them enabled */
+    if (cf->config.bloom_filter && data_end == UINT64_MAX)
     {
-        free(args);
-        return NULL;
+        int rc = block_manager_cursor_next(cursor);
+        if (rc != 0)
+        {
+            (void)block_manager_cursor_free(cursor);
+            return rc == 1 ? 0 : -1; /* an empty sstable has nothing to read */
+        }
     }
 
-    /* remove old sstable files */
-    char sstable_path1[MAX_FILE_PATH_LENGTH];
-    char sstable_path2[MAX_FILE_PATH_LENGTH];
+    block_manager_block_t *block;
+    while (cursor->current_pos < data_end && (block = block_manager_cursor_read(cursor)) != NULL)
+    {
+        tidesdb_key_value_pair_t *kv = _tidesdb_deserialize_key_value_pair(
+            block->data, block->size, cf->config.compressed, cf->config.compress_algo);
+        (void)block_manager_block_free(block);
 
-    /* get the sstable paths */
-    (void)snprintf(sstable_path1, MAX_FILE_PATH_LENGTH, "%s",
-                   cf->sstables[start]->block_manager->file_path);
-    (void)snprintf(sstable_path2, MAX_FILE_PATH_LENGTH, "%s",
-                   cf->sstables[end]->block_manager->file_path);
+        /* we rather fail the merge than lose the rest of the sstable */
+        if (kv == NULL)
+        {
+            (void)block_manager_cursor_free(cursor);
+            return -1;
+        }
 
-    /* free the old sstables */
-    (void)_tidesdb_free_sstable(cf->sstables[start]);
-    (void)_tidesdb_free_sstable(cf->sstables[end]);
+        if (skip_list_put(list, kv->key, kv->key_size, kv->value, kv->value_size, kv->ttl) == -1)
+        {
+            (void)_tidesdb_free_key_value_pair(kv);
+            (void)block_manager_cursor_free(cursor);
+            return -1;
+        }
 
-    /* remove the sstable files */
-    (void)remove(sstable_path1);
-    (void)remove(sstable_path2);
+        (void)_tidesdb_free_key_value_pair(kv);
 
-    /* replace the old sstables with the new one */
-    cf->sstables[start] = merged_sstable;
-    cf->sstables[end] = NULL;
+        if (block_manager_cursor_next(cursor) != 0) break;
+    }
 
-    (void)sem_post(args->sem); /* signal compaction thread is done */
-    free(args);                /* free the args */
+    (void)block_manager_cursor_free(cursor);
 
-    return NULL;
+    return 0;
 }
 
-tidesdb_sstable_t *_tidesdb_merge_sstables(tidesdb_sstable_t *sst1, tidesdb_sstable_t *sst2,
-                                           tidesdb_column_family_t *cf,
-                                           pthread_mutex_t *shared_lock)
+int _tidesdb_merge_sstables(tidesdb_column_family_t *cf, tidesdb_sstable_t *sst1,
+                            tidesdb_sstable_t *sst2, bool bottommost, tidesdb_sstable_t ***outputs,
+                            int *num_outputs, tidesdb_dropped_t *dropped)
 {
-    /* we initialize a new sstable */
-    tidesdb_sstable_t *merged_sstable = malloc(sizeof(tidesdb_sstable_t));
-    if (merged_sstable == NULL) return NULL;
+    *outputs = NULL;
+    *num_outputs = 0;
+
+    uint64_t start = _tidesdb_now_ns();
 
     /* we initialize a new skiplist as a mergetable with column family configurations */
     skip_list_t *mergetable = skip_list_new(cf->config.max_level, cf->config.probability);
-    if (mergetable == NULL)
-    {
-        free(merged_sstable);
-        return NULL;
-    }
-
-    /* we create a new sstable with a named based on the amount of sstables */
-    char sstable_path[MAX_FILE_PATH_LENGTH];
+    if (mergetable == NULL) return -1;
 
-    /* lock to make sure path is unique */
-    if (pthread_mutex_lock(shared_lock) != 0)
+    /* we populate the merge table with the older sstable first so the newer one overwrites it */
+    if (_tidesdb_read_sstable_into(cf, sst1, mergetable) == -1 ||
+        _tidesdb_read_sstable_into(cf, sst2, mergetable) == -1)
     {
         (void)skip_list_destroy(mergetable);
-        free(merged_sstable);
-        return NULL;
+        return -1;
     }
 
-    snprintf(sstable_path, sizeof(sstable_path), "%s%s%s%d%s", cf->path,
-             _tidesdb_get_path_seperator(), TDB_SSTABLE_PREFIX, cf->num_sstables, TDB_SSTABLE_EXT);
-    cf->num_sstables++;
+    /* the populated merge table is counted as held memory until we destroy it */
+    size_t merge_size = mergetable->total_size;
+    (void)_tidesdb_stats_add(cf->stats, TDB_STAT_MEM_MERGE_TABLES, merge_size);
 
-    /* unlock the shared lock */
-    if (pthread_mutex_unlock(shared_lock) != 0)
+    /* tombstones and expired keys must be kept unless nothing older is left for them to shadow */
+    tidesdb_subcompactions_t *subs = _tidesdb_subcompactions_new(
+        cf, mergetable, bottommost, _tidesdb_num_subcompactions(cf, mergetable));
+    if (subs == NULL)
     {
         (void)skip_list_destroy(mergetable);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_MERGE_TABLES, merge_size);
+        return -1;
     }
 
-    /* we open a new block manager for the merged sstable */
-    if (block_manager_open(&merged_sstable->block_manager, sstable_path, TDB_SYNC_INTERVAL) == -1)
+    /* we hand the ranges past the first to the background pool, each job holds a reference */
+    thread_pool_t *pool = cf->tdb != NULL ? cf->tdb->background_pool : NULL;
+    for (int i = 1; i < subs->num_ranges && pool != NULL; i++)
     {
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        (void)atomic_fetch_add(&subs->refcount, 1);
+        if (thread_pool_submit(pool, THREAD_POOL_PRIORITY_MEDIUM, _tidesdb_subcompaction_job,
+                               subs) == -1)
+        {
+            (void)atomic_fetch_sub(&subs->refcount, 1);
+            break;
+        }
     }
 
-    /* we populate the merge table with the sstables */
+    /* we write every range no pool thread has taken yet, the pool may be busy with the other
+     * pair merges of the compaction so we only ever wait on ranges that are being written */
+    while (_tidesdb_run_subcompaction(subs) == 0)
+        ;
 
-    block_manager_cursor_t *cursor = NULL;
+    (void)pthread_mutex_lock(&subs->lock);
+    while (subs->done < subs->num_ranges) (void)pthread_cond_wait(&subs->cond, &subs->lock);
+    (void)pthread_mutex_unlock(&subs->lock);
 
-    /* init cursor for sstable 1 */
-    if (block_manager_cursor_init(&cursor, sst1->block_manager) == -1)
+    int rc = 0;
+    for (int i = 0; i < subs->num_ranges; i++)
     {
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        if (subs->ranges[i].output == NULL) rc = -1;
+        dropped->tombstones += subs->ranges[i].dropped.tombstones;
+        dropped->expired += subs->ranges[i].dropped.expired;
     }
 
-    block_manager_block_t *block;
-    while ((block = block_manager_cursor_read(cursor)) != NULL)
+    if (rc == 0)
     {
-        tidesdb_key_value_pair_t *kv = _tidesdb_deserialize_key_value_pair(
-            block->data, block->size, cf->config.compressed, cf->config.compress_algo);
-        if (kv == NULL)
-        {
-            (void)block_manager_block_free(block);
-            continue;
-        }
-
-        if (_tidesdb_is_tombstone(kv->value, kv->value_size))
-        {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
-
-        if (_tidesdb_is_expired(kv->ttl))
-        {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
+        *outputs = malloc(sizeof(tidesdb_sstable_t *) * subs->num_ranges);
+        if (*outputs == NULL) rc = -1;
+    }
 
-        if (skip_list_put(mergetable, kv->key, kv->key_size, kv->value, kv->value_size, kv->ttl) ==
-            -1)
+    for (int i = 0; i < subs->num_ranges; i++)
+    {
+        if (rc == 0)
         {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
+            (*outputs)[i] = subs->ranges[i].output;
             continue;
         }
 
-        (void)block_manager_block_free(block);
-        (void)_tidesdb_free_key_value_pair(kv);
-
-        if (block_manager_cursor_next(cursor) != 0) break;
+        /* a failed range fails the pair, we remove the ranges that were written */
+        if (subs->ranges[i].output == NULL) continue;
+        atomic_store(&subs->ranges[i].output->obsolete, true);
+        (void)_tidesdb_release_sstable(subs->ranges[i].output);
     }
+    if (rc == 0) *num_outputs = subs->num_ranges;
 
-    (void)block_manager_block_free(block);
-    block = NULL;
-    (void)block_manager_cursor_free(cursor);
-    cursor = NULL;
+    (void)_tidesdb_release_subcompactions(subs);
+    (void)skip_list_destroy(mergetable);
+    (void)_tidesdb_stats_sub(cf->stats, TDB_STAT_MEM_MERGE_TABLES, merge_size);
 
-    /* init cursor for sstable 2 */
-    if (block_manager_cursor_init(&cursor, sst2->block_manager) == -1)
+    if (rc == 0)
     {
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        uint64_t size = 0;
+        for (int i = 0; i < *num_outputs; i++) size += _tidesdb_sstable_size((*outputs)[i]);
+
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_COMPACTIONS, 1);
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_COMPACTION_BYTES, size);
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_BYTES_WRITTEN, size);
+        (void)_tidesdb_stats_add(cf->stats, TDB_STAT_COMPACTION_US,
+                                 (_tidesdb_now_ns() - start) / 1000);
     }
 
-    while ((block = block_manager_cursor_read(cursor)) != NULL)
-    {
-        tidesdb_key_value_pair_t *kv = _tidesdb_deserialize_key_value_pair(
-            block->data, block->size, cf->config.compressed, cf->config.compress_algo);
-        if (kv == NULL)
-        {
-            (void)block_manager_block_free(block);
-            continue;
-        }
+    return rc;
+}
 
-        if (_tidesdb_is_tombstone(kv->value, kv->value_size))
-        {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
+int _tidesdb_num_subcompactions(tidesdb_column_family_t *cf, skip_list_t *mergetable)
+{
+    int max_subcompactions = cf->tdb != NULL ? cf->tdb->config.max_subcompactions : 0;
+    if (max_subcompactions <= 1 || cf->config.flush_threshold <= 0) return 1;
 
-        if (_tidesdb_is_expired(kv->ttl))
-        {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
+    size_t num_ranges = mergetable->total_size / (size_t)cf->config.flush_threshold;
+    if (num_ranges < 1) return 1;
+    if (num_ranges > (size_t)max_subcompactions) return max_subcompactions;
 
-        if (skip_list_put(mergetable, kv->key, kv->key_size, kv->value, kv->value_size, kv->ttl) ==
-            -1)
-        {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
+    return (int)num_ranges;
+}
 
-        (void)block_manager_block_free(block);
-        (void)_tidesdb_free_key_value_pair(kv);
+tidesdb_subcompactions_t *_tidesdb_subcompactions_new(tidesdb_column_family_t *cf,
+                                                      skip_list_t *mergetable, bool drop_deleted,
+                                                      int num_ranges)
+{
+    /* we don't split into more ranges than there are entries */
+    int n = skip_list_count_entries(mergetable);
+    if (num_ranges > n) num_ranges = n;
+    if (num_ranges < 1) num_ranges = 1;
 
-        if (block_manager_cursor_next(cursor) != 0) break;
+    tidesdb_subcompactions_t *subs = malloc(sizeof(tidesdb_subcompactions_t));
+    if (subs == NULL) return NULL;
+
+    subs->ranges = malloc(sizeof(tidesdb_subcompaction_t) * num_ranges);
+    if (subs->ranges == NULL)
+    {
+        free(subs);
+        return NULL;
     }
 
-    (void)block_manager_cursor_free(cursor);
+    if (pthread_mutex_init(&subs->lock, NULL) != 0)
+    {
+        free(subs->ranges);
+        free(subs);
+        return NULL;
+    }
 
-    skip_list_cursor_t *mergetable_cursor = skip_list_cursor_init(mergetable);
-    if (mergetable_cursor == NULL)
+    if (pthread_cond_init(&subs->cond, NULL) != 0)
     {
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
+        (void)pthread_mutex_destroy(&subs->lock);
+        free(subs->ranges);
+        free(subs);
         return NULL;
     }
 
-    do
+    subs->cf = cf;
+    subs->mergetable = mergetable;
+    subs->drop_deleted = drop_deleted;
+    subs->num_ranges = num_ranges;
+    subs->done = 0;
+    atomic_init(&subs->refcount, 1);
+
+    /* we walk the merge table once cutting it every n / num_ranges entries */
+    skip_list_node_t *node = mergetable->header->forward[0];
+    int position = 0;
+    for (int i = 0; i < num_ranges; i++)
     {
-        tidesdb_key_value_pair_t *kv = malloc(sizeof(tidesdb_key_value_pair_t));
-        if (kv == NULL)
-        {
-            (void)skip_list_cursor_free(mergetable_cursor);
-            (void)skip_list_destroy(mergetable);
-            (void)remove(sstable_path);
-            free(merged_sstable);
-            cf->num_sstables--;
-            return NULL;
-        }
+        subs->ranges[i].start = node;
+        subs->ranges[i].output = NULL;
+        subs->ranges[i].dropped = (tidesdb_dropped_t){0};
+        atomic_init(&subs->ranges[i].claimed, false);
 
-        uint8_t *retrieved_key;
-        size_t key_size;
-        uint8_t *retrieved_value;
-        size_t value_size;
-        time_t ttl;
-        if (skip_list_cursor_get(mergetable_cursor, &retrieved_key, &key_size, &retrieved_value,
-                                 &value_size, &ttl) == -1)
+        int boundary = (int)((int64_t)n * (i + 1) / num_ranges);
+        while (node != NULL && position < boundary)
         {
-            free(kv);
-            continue;
+            node = node->forward[0];
+            position++;
         }
 
-        /* we copy the key */
-        kv->key = malloc(key_size);
-        if (kv->key == NULL)
-        {
-            free(kv);
-            continue;
-        }
-        memcpy(kv->key, retrieved_key, key_size);
+        subs->ranges[i].end = node;
+    }
 
-        /* we copy the value */
-        kv->value = malloc(value_size);
-        if (kv->value == NULL)
-        {
-            free(kv->key);
-            free(kv);
-            continue;
-        }
+    return subs;
+}
 
-        memcpy(kv->value, retrieved_value, value_size);
+void _tidesdb_release_subcompactions(tidesdb_subcompactions_t *subs)
+{
+    if (subs == NULL) return;
 
-        /* we set the key size */
-        kv->key_size = key_size;
-        /* we set the value size */
-        kv->value_size = value_size;
-        /* we set the ttl */
-        kv->ttl = ttl;
+    if (atomic_fetch_sub(&subs->refcount, 1) != 1) return;
 
-        size_t serialized_size;
-        uint8_t *serialized_kv = _tidesdb_serialize_key_value_pair(
-            kv, &serialized_size, cf->config.compressed, cf->config.compress_algo);
-        if (serialized_kv == NULL)
-        {
-            free(kv);
-            break;
-        }
+    (void)pthread_cond_destroy(&subs->cond);
+    (void)pthread_mutex_destroy(&subs->lock);
+    free(subs->ranges);
+    free(subs);
+}
 
-        block = block_manager_block_create(serialized_size, serialized_kv);
-        if (block == NULL)
-        {
-            free(kv);
-            free(serialized_kv);
-            break;
-        }
+int _tidesdb_run_subcompaction(tidesdb_subcompactions_t *subs)
+{
+    for (int i = 0; i < subs->num_ranges; i++)
+    {
+        tidesdb_subcompaction_t *range = &subs->ranges[i];
+        if (atomic_exchange(&range->claimed, true)) continue;
 
-        if (block_manager_block_write(merged_sstable->block_manager, block) == -1)
-        {
-            (void)block_manager_block_free(block);
-            free(kv);
-            free(serialized_kv);
-            break;
-        }
+        tidesdb_sstable_t *output = NULL;
+        (void)_tidesdb_write_sstable_range(subs->cf, subs->mergetable, range->start, range->end,
+                                           subs->drop_deleted, RATE_LIMITER_PRIORITY_LOW,
+                                           &output, &range->dropped);
 
-        (void)block_manager_block_free(block);
-        free(serialized_kv);
-        (void)_tidesdb_free_key_value_pair(kv);
+        (void)pthread_mutex_lock(&subs->lock);
+        range->output = output;
+        subs->done++;
+        (void)pthread_cond_signal(&subs->cond);
+        (void)pthread_mutex_unlock(&subs->lock);
 
-    } while (skip_list_cursor_next(mergetable_cursor) != -1);
+        return 0;
+    }
 
-    (void)skip_list_cursor_free(mergetable_cursor);
-    (void)skip_list_clear(mergetable);
-    (void)skip_list_destroy(mergetable);
+    return -1;
+}
+
+void _tidesdb_subcompaction_job(void *arg)
+{
+    tidesdb_subcompactions_t *subs = arg;
 
-    return merged_sstable;
+    /* by the time we run the merging thread may have written every range itself */
+    (void)_tidesdb_run_subcompaction(subs);
+
+    (void)_tidesdb_release_subcompactions(subs);
 }
 
 int _tidesdb_compare_keys(const uint8_t *key1, size_t key1_size, const uint8_t *key2,
@@ -2784,52 +5478,56 @@ tidesdb_err_t *tidesdb_txn_begin(tidesdb_t *tdb, tidesdb_txn_t **txn, const char
     /* we check if transaction is NULL */
     if (txn == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_TXN);
 
-    /* allocate memory for the transaction */
-    *txn = malloc(sizeof(tidesdb_txn_t));
-    if (*txn == NULL) return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "transaction");
-
-    /* get db read lock */
-    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0)
-    {
-        free(*txn);
-        *txn = NULL;
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
-    }
-
     /* check if column family exists and get it */
     tidesdb_column_family_t *cf = NULL;
-    if (_tidesdb_get_column_family(tdb, column_family, &cf) == -1)
-    {
-        free(*txn);
-        *txn = NULL;
-        (void)pthread_rwlock_unlock(&tdb->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
-    }
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family, &cf);
+    if (e != NULL) return e;
 
-    /* unlock the db */
-    if (pthread_rwlock_unlock(&tdb->rwlock) != 0)
-    {
-        free(*txn);
-        *txn = NULL;
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "db");
-    }
+    e = _tidesdb_txn_begin(tdb, cf, txn);
+
+    /* the transaction holds its own reference on the column family */
+    (void)_tidesdb_release_column_family(cf);
+
+    return e;
+}
+
+tidesdb_err_t *tidesdb_txn_begin_w_handle(tidesdb_cf_handle_t *handle, tidesdb_txn_t **txn)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    /* we check if transaction is NULL */
+    if (txn == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_TXN);
+
+    return _tidesdb_txn_begin(handle->tdb, handle->cf, txn);
+}
+
+tidesdb_err_t *_tidesdb_txn_begin(tidesdb_t *tdb, tidesdb_column_family_t *cf, tidesdb_txn_t **txn)
+{
+    /* allocate memory for the transaction */
+    *txn = malloc(sizeof(tidesdb_txn_t));
+    if (*txn == NULL) return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "transaction");
 
     /* initialize the transaction */
     (*txn)->ops = NULL;
     (*txn)->num_ops = 0; /* 0 operations */
     (*txn)->cf = cf;
+    (*txn)->buffer_bytes = 0;
 
     /* initialize the transaction lock */
     if (pthread_mutex_init(&(*txn)->lock, NULL) != 0)
     {
         free(*txn);
         *txn = NULL;
-        (void)pthread_rwlock_unlock(&tdb->rwlock);
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_LOCK, "transaction");
     }
 
     (*txn)->tdb = tdb;
 
+    /* the transaction keeps the column family alive until it is freed */
+    (void)_tidesdb_ref_column_family(cf);
+
     return NULL;
 }
 
@@ -2988,6 +5686,11 @@ tidesdb_err_t *tidesdb_txn_put(tidesdb_txn_t *txn, const uint8_t *key, size_t ke
 
     txn->ops[txn->num_ops].rollback_op->kv->value = tombstone;
 
+    /* the operations are counted as held memory until the transaction is freed */
+    size_t op_size = _tidesdb_txn_op_size(&txn->ops[txn->num_ops]);
+    txn->buffer_bytes += op_size;
+    (void)_tidesdb_stats_add(txn->cf->stats, TDB_STAT_MEM_TXN_BUFFERS, op_size);
+
     txn->num_ops++;
 
     /* unlock the transaction */
@@ -3140,6 +5843,11 @@ tidesdb_err_t *tidesdb_txn_delete(tidesdb_txn_t *txn, const uint8_t *key, size_t
         txn->ops[txn->num_ops].rollback_op->kv->ttl = -1;
     }
 
+    /* the operations are counted as held memory until the transaction is freed */
+    size_t op_size = _tidesdb_txn_op_size(&txn->ops[txn->num_ops]);
+    txn->buffer_bytes += op_size;
+    (void)_tidesdb_stats_add(txn->cf->stats, TDB_STAT_MEM_TXN_BUFFERS, op_size);
+
     txn->num_ops++;
 
     /* unlock the transaction */
@@ -3150,6 +5858,36 @@ tidesdb_err_t *tidesdb_txn_delete(tidesdb_txn_t *txn, const uint8_t *key, size_t
 }
 
 tidesdb_err_t *tidesdb_txn_commit(tidesdb_txn_t *txn)
+{
+    uint64_t start = _tidesdb_now_ns();
+
+    tidesdb_err_t *e = _tidesdb_txn_commit(txn);
+    if (e != NULL) return e;
+
+    (void)_tidesdb_stats_add(txn->cf->stats, TDB_STAT_COMMITS, 1);
+    (void)_tidesdb_stats_record(txn->cf->stats, TDB_LATENCY_COMMIT, start);
+
+    /* the commit may have put the memtables of all column families over the budget */
+    if (_tidesdb_flush_over_budget(txn->tdb) == -1)
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
+
+    return NULL;
+}
+
+size_t _tidesdb_txn_op_size(tidesdb_txn_op_t *op)
+{
+    size_t size = 0;
+    tidesdb_operation_t *ops[2] = {op->op, op->rollback_op};
+    for (int i = 0; i < 2; i++)
+    {
+        size += sizeof(tidesdb_operation_t) + sizeof(tidesdb_key_value_pair_t);
+        size += ops[i]->kv->key_size + ops[i]->kv->value_size;
+    }
+
+    return size;
+}
+
+tidesdb_err_t *_tidesdb_txn_commit(tidesdb_txn_t *txn)
 {
     /* we check if the db is NULL */
     if (txn->tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
@@ -3157,6 +5895,10 @@ tidesdb_err_t *tidesdb_txn_commit(tidesdb_txn_t *txn)
     /* we check if the transaction is NULL */
     if (txn == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_TXN);
 
+    /* we slow down or stop if compaction has fallen behind */
+    if (_tidesdb_write_stall(txn->cf) != TIDESDB_SUCCESS)
+        return tidesdb_err_from_code(TIDESDB_ERR_WRITE_STALLED);
+
     /* we lock the transaction */
     if (pthread_mutex_lock(&txn->lock) != 0)
     {
@@ -3164,8 +5906,21 @@ tidesdb_err_t *tidesdb_txn_commit(tidesdb_txn_t *txn)
     }
 
     /* we lock the column family */
+    uint64_t lock_wait = _tidesdb_perf_start();
     if (pthread_rwlock_wrlock(&txn->cf->rwlock) != 0)
+    {
+        (void)pthread_mutex_unlock(&txn->lock);
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
+    }
+    (void)_tidesdb_perf_stop(TDB_PERF_CF_LOCK_WAIT, lock_wait);
+
+    /* we check if the column family was dropped since the transaction began */
+    if (txn->cf->dropped)
+    {
+        (void)pthread_rwlock_unlock(&txn->cf->rwlock);
+        (void)pthread_mutex_unlock(&txn->lock);
+        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+    }
 
     /* we run the operations */
     for (int i = 0; i < txn->num_ops; i++)
@@ -3176,9 +5931,14 @@ tidesdb_err_t *tidesdb_txn_commit(tidesdb_txn_t *txn)
         switch (op.op_code)
         {
             case TIDESDB_OP_PUT:
-                /* append to wal */
+            {
+                /* the operation goes to the shard its key hashes to, we hold the column family
+                 * exclusively so no shard lock is required */
+                tidesdb_memtable_shard_t *shard =
+                    _tidesdb_get_shard(txn->cf, op.kv->key, op.kv->key_size);
 
-                if (_tidesdb_append_to_wal(txn->cf->wal, op.kv->key, op.kv->key_size, op.kv->value,
+                /* append to wal */
+                if (_tidesdb_append_to_wal(shard->wal, op.kv->key, op.kv->key_size, op.kv->value,
                                            op.kv->value_size, op.kv->ttl, TIDESDB_OP_PUT,
                                            op.cf_name) == -1)
                 {
@@ -3192,43 +5952,29 @@ tidesdb_err_t *tidesdb_txn_commit(tidesdb_txn_t *txn)
                     return tidesdb_txn_rollback(txn);
                 }
 
-                switch (txn->cf->config.memtable_ds)
-                {
-                    case TDB_MEMTABLE_SKIP_LIST:
-                        if (skip_list_put(txn->cf->memtable, op.kv->key, op.kv->key_size,
+                if (_tidesdb_memtable_put(txn->cf, shard, op.kv->key, op.kv->key_size,
                                           op.kv->value, op.kv->value_size, op.kv->ttl) == -1)
-                        {
-                            /* unlock the column family */
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-
-                            /* unlock the transaction */
-                            (void)pthread_mutex_unlock(&txn->lock);
-
-                            /* we rollback the transaction */
-                            return tidesdb_txn_rollback(txn);
-                        }
-                        break;
-                    case TDB_MEMTABLE_HASH_TABLE:
-                        if (hash_table_put(txn->cf->memtable, op.kv->key, op.kv->key_size,
-                                           op.kv->value, op.kv->value_size, op.kv->ttl) == -1)
-                        {
-                            /* unlock the column family */
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-
-                            /* unlock the transaction */
-                            (void)pthread_mutex_unlock(&txn->lock);
-
-                            /* we rollback the transaction */
-                            return tidesdb_txn_rollback(txn);
-                        }
-                        break;
+                {
+                    /* unlock the column family */
+                    (void)pthread_rwlock_unlock(&txn->cf->rwlock);
+
+                    /* unlock the transaction */
+                    (void)pthread_mutex_unlock(&txn->lock);
+
+                    /* we rollback the transaction */
+                    return tidesdb_txn_rollback(txn);
                 }
 
                 /* mark op committed */
                 txn->ops[i].committed = true;
-                break;
+            }
+            break;
             case TIDESDB_OP_DELETE:
-                if (_tidesdb_append_to_wal(txn->cf->wal, op.kv->key, op.kv->key_size, op.kv->value,
+            {
+                tidesdb_memtable_shard_t *shard =
+                    _tidesdb_get_shard(txn->cf, op.kv->key, op.kv->key_size);
+
+                if (_tidesdb_append_to_wal(shard->wal, op.kv->key, op.kv->key_size, op.kv->value,
                                            4, op.kv->ttl, TIDESDB_OP_PUT, op.cf_name) == -1)
                 {
                     /* unlock the column family */
@@ -3241,41 +5987,23 @@ tidesdb_err_t *tidesdb_txn_commit(tidesdb_txn_t *txn)
                     return tidesdb_txn_rollback(txn);
                 }
 
-                switch (txn->cf->config.memtable_ds)
-                {
-                    case TDB_MEMTABLE_SKIP_LIST:
-                        if (skip_list_put(txn->cf->memtable, op.kv->key, op.kv->key_size,
+                if (_tidesdb_memtable_put(txn->cf, shard, op.kv->key, op.kv->key_size,
                                           op.kv->value, 4, 0) == -1)
-                        {
-                            /* unlock the column family */
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-
-                            /* unlock the transaction */
-                            (void)pthread_mutex_unlock(&txn->lock);
-
-                            /* we rollback the transaction */
-                            return tidesdb_txn_rollback(txn);
-                        }
-                        break;
-                    case TDB_MEMTABLE_HASH_TABLE:
-                        if (hash_table_put(txn->cf->memtable, op.kv->key, op.kv->key_size,
-                                           op.kv->value, 4, 0) == -1)
-                        {
-                            /* unlock the column family */
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-
-                            /* unlock the transaction */
-                            (void)pthread_mutex_unlock(&txn->lock);
-
-                            /* we rollback the transaction */
-                            return tidesdb_txn_rollback(txn);
-                        }
-                        break;
+                {
+                    /* unlock the column family */
+                    (void)pthread_rwlock_unlock(&txn->cf->rwlock);
+
+                    /* unlock the transaction */
+                    (void)pthread_mutex_unlock(&txn->lock);
+
+                    /* we rollback the transaction */
+                    return tidesdb_txn_rollback(txn);
                 }
 
                 /* mark op committed */
                 txn->ops[i].committed = true;
-                break;
+            }
+            break;
             default:
                 break;
         }
@@ -3285,104 +6013,19 @@ tidesdb_err_t *tidesdb_txn_commit(tidesdb_txn_t *txn)
     if (pthread_mutex_unlock(&txn->lock) != 0)
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "transaction");
 
-    /* we check if the memtable needs to be flushed */
-    switch (txn->cf->config.memtable_ds)
-    {
-        case TDB_MEMTABLE_SKIP_LIST:
-
-            if (((int)((skip_list_t *)txn->cf->memtable)->total_size >=
-                 txn->cf->config.flush_threshold))
-            {
-                if (txn->cf->config.bloom_filter)
-                {
-                    if (txn->cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter_f_hash_table(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-                else
-                {
-                    if (txn->cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_f_hash_table(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-            }
-            break;
-        case TDB_MEMTABLE_HASH_TABLE:
-            if (((int)((hash_table_t *)txn->cf->memtable)->total_size >=
-                 txn->cf->config.flush_threshold))
-            {
-                if (txn->cf->config.bloom_filter)
-                {
-                    if (txn->cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter_f_hash_table(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-                else
-                {
-                    if (txn->cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_f_hash_table(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-            }
-            break;
-    }
+    /* we check if any shard needs the memtable to be flushed */
+    tidesdb_flush_info_t info;
+    bool flushed = _tidesdb_any_shard_full(txn->cf);
+    int rc = flushed ? _tidesdb_flush_memtable(txn->cf, &info) : 0;
 
     /* unlock the column family */
     if (pthread_rwlock_unlock(&txn->cf->rwlock) != 0)
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
 
+    if (flushed) (void)_tidesdb_report_flush(txn->cf, &info);
+
+    if (rc == -1) return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
+
     return NULL;
 }
 
@@ -3409,138 +6052,46 @@ tidesdb_err_t *tidesdb_txn_rollback(tidesdb_txn_t *txn)
         {
             tidesdb_operation_t op = *txn->ops[i].rollback_op;
 
-            /* append to wal */
-            if (_tidesdb_append_to_wal(txn->cf->wal, op.kv->key, op.kv->key_size, op.kv->value,
-                                       op.kv->value_size, op.kv->ttl, TIDESDB_OP_PUT,
-                                       op.cf_name) == -1)
-            {
-                /* unlock the column family */
-                (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-
-                /* unlock the transaction */
-                (void)pthread_mutex_unlock(&txn->lock);
-
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_APPEND_TO_WAL);
-            }
-
-            /* we put back the key-value pair */
-            switch (txn->cf->config.memtable_ds)
-            {
-                case TDB_MEMTABLE_SKIP_LIST:
-                    (void)skip_list_put(txn->cf->memtable, op.kv->key, op.kv->key_size,
-                                        op.kv->value, op.kv->value_size, op.kv->ttl);
-                    break;
-                case TDB_MEMTABLE_HASH_TABLE:
-                    (void)hash_table_put(txn->cf->memtable, op.kv->key, op.kv->key_size,
-                                         op.kv->value, op.kv->value_size, op.kv->ttl);
-                    break;
-                default:
-                    return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
-            }
-        }
-    }
-
-    /* unlock the transaction */
-    if (pthread_mutex_unlock(&txn->lock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "transaction");
+            tidesdb_memtable_shard_t *shard =
+                _tidesdb_get_shard(txn->cf, op.kv->key, op.kv->key_size);
 
-    /* we check if the memtable needs to be flushed */
-    switch (txn->cf->config.memtable_ds)
-    {
-        case TDB_MEMTABLE_SKIP_LIST:
-            if (((int)((skip_list_t *)txn->cf->memtable)->total_size >=
-                 txn->cf->config.flush_threshold))
-            {
-                if (txn->cf->config.bloom_filter)
-                {
-                    if (txn->cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter_f_hash_table(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-                else
-                {
-                    if (txn->cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-            }
-            break;
-        case TDB_MEMTABLE_HASH_TABLE:
-            if (((int)((hash_table_t *)txn->cf->memtable)->total_size >=
-                 txn->cf->config.flush_threshold))
-            {
-                if (txn->cf->config.bloom_filter)
-                {
-                    if (txn->cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_w_bloomfilter_f_hash_table(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
-                else
-                {
-                    if (txn->cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
-                    {
-                        if (_tidesdb_flush_memtable(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                    else
-                    {
-                        if (_tidesdb_flush_memtable_f_hash_table(txn->cf) == -1)
-                        {
-                            (void)pthread_rwlock_unlock(&txn->cf->rwlock);
-                            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
-                        }
-                    }
-                }
+            /* append to wal */
+            if (_tidesdb_append_to_wal(shard->wal, op.kv->key, op.kv->key_size, op.kv->value,
+                                       op.kv->value_size, op.kv->ttl, TIDESDB_OP_PUT,
+                                       op.cf_name) == -1)
+            {
+                /* unlock the column family */
+                (void)pthread_rwlock_unlock(&txn->cf->rwlock);
+
+                /* unlock the transaction */
+                (void)pthread_mutex_unlock(&txn->lock);
+
+                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_APPEND_TO_WAL);
             }
-            break;
+
+            /* we put back the key-value pair */
+            (void)_tidesdb_memtable_put(txn->cf, shard, op.kv->key, op.kv->key_size, op.kv->value,
+                                        op.kv->value_size, op.kv->ttl);
+        }
     }
 
+    /* unlock the transaction */
+    if (pthread_mutex_unlock(&txn->lock) != 0)
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "transaction");
+
+    /* we check if any shard needs the memtable to be flushed */
+    tidesdb_flush_info_t info;
+    bool flushed = _tidesdb_any_shard_full(txn->cf);
+    int rc = flushed ? _tidesdb_flush_memtable(txn->cf, &info) : 0;
+
     /* unlock the column family */
     if (pthread_rwlock_unlock(&txn->cf->rwlock) != 0)
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
 
+    if (flushed) (void)_tidesdb_report_flush(txn->cf, &info);
+
+    if (rc == -1) return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_FLUSH_MEMTABLE);
+
     return NULL;
 }
 
@@ -3560,6 +6111,8 @@ tidesdb_err_t *tidesdb_txn_free(tidesdb_txn_t *txn)
 
     free(txn->ops);
 
+    (void)_tidesdb_stats_sub(txn->cf->stats, TDB_STAT_MEM_TXN_BUFFERS, txn->buffer_bytes);
+
     /* unlock the transaction */
     if (pthread_mutex_unlock(&txn->lock) != 0)
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "transaction");
@@ -3568,6 +6121,9 @@ tidesdb_err_t *tidesdb_txn_free(tidesdb_txn_t *txn)
     if (pthread_mutex_destroy(&txn->lock) != 0)
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_DESTROY_LOCK, "transaction");
 
+    /* we release the transaction's reference on the column family */
+    (void)_tidesdb_release_column_family(txn->cf);
+
     free(txn);
 
     txn = NULL;
@@ -3586,21 +6142,29 @@ tidesdb_err_t *tidesdb_cursor_init(tidesdb_t *tdb, const char *column_family_nam
 
     /* we get the column family */
     tidesdb_column_family_t *cf = NULL;
+    tidesdb_err_t *e = _tidesdb_acquire_column_family(tdb, column_family_name, &cf);
+    if (e != NULL) return e;
 
-    /* we need to get read lock for the db */
-    if (pthread_rwlock_rdlock(&tdb->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "db");
+    e = _tidesdb_cursor_init(tdb, cf, cursor);
 
-    if (_tidesdb_get_column_family(tdb, column_family_name, &cf) == -1)
-    {
-        (void)pthread_rwlock_unlock(&tdb->rwlock);
-        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
-    }
+    /* the cursor holds its own reference on the column family */
+    (void)_tidesdb_release_column_family(cf);
 
-    /* we unlock the db */
-    if (pthread_rwlock_unlock(&tdb->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "db");
+    return e;
+}
+
+tidesdb_err_t *tidesdb_cursor_init_w_handle(tidesdb_cf_handle_t *handle, tidesdb_cursor_t **cursor)
+{
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    return _tidesdb_cursor_init(handle->tdb, handle->cf, cursor);
+}
 
+tidesdb_err_t *_tidesdb_cursor_init(tidesdb_t *tdb, tidesdb_column_family_t *cf,
+                                    tidesdb_cursor_t **cursor)
+{
     /* we allocate memory for the new cursor */
     *cursor = malloc(sizeof(tidesdb_cursor_t));
     if (*cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "cursor");
@@ -3608,1470 +6172,1056 @@ tidesdb_err_t *tidesdb_cursor_init(tidesdb_t *tdb, const char *column_family_nam
     /* we setup defaults */
     (*cursor)->tidesdb = tdb;
     (*cursor)->cf = cf;
-    (*cursor)->sstable_cursor = NULL;
-    (*cursor)->memtable_cursor = NULL;
+    (*cursor)->version = NULL;
+    (*cursor)->sources = NULL;
+    (*cursor)->num_sources = 0;
+    (*cursor)->current = -1;
+    (*cursor)->forward = true;
 
     /* get column family read lock */
+    uint64_t lock_wait = _tidesdb_perf_start();
     if (pthread_rwlock_rdlock(&cf->rwlock) != 0)
     {
         free(*cursor);
         return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
     }
+    (void)_tidesdb_perf_stop(TDB_PERF_CF_LOCK_WAIT, lock_wait);
 
-    (*cursor)->sstable_index =
-        cf->num_sstables - 1; /* we start at the last sstable, the latest sstable */
-
-    /* we check what data structure the column family is using */
-    switch ((*cursor)->cf->config.memtable_ds)
-    {
-        case TDB_MEMTABLE_SKIP_LIST:
-            (*cursor)->memtable_cursor = skip_list_cursor_init(cf->memtable);
-            if ((*cursor)->memtable_cursor == NULL)
-            {
-                /* unlock column family */
-                (void)pthread_rwlock_unlock(&cf->rwlock);
-                free(*cursor);
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_CURSOR);
-            }
-            break;
-        case TDB_MEMTABLE_HASH_TABLE:
-            (*cursor)->memtable_cursor = hash_table_cursor_new(cf->memtable);
-            break;
-        default:
-            free(cursor);
-            (void)pthread_rwlock_unlock(&cf->rwlock);
-            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
-    }
-
-    /* we get current sstable cursor
-     * if there are any sstables
-     */
-    if (cf->num_sstables > 0)
+    /* we check if the column family was dropped while we were waiting on the lock */
+    if (cf->dropped)
     {
-        /* we initialize the sstable cursor */
-        if (block_manager_cursor_init(&(*cursor)->sstable_cursor,
-                                      cf->sstables[(*cursor)->sstable_index]->block_manager) == -1)
-        {
-            /* unlock column family */
-            (void)pthread_rwlock_unlock(&cf->rwlock);
-            (void)skip_list_cursor_free((*cursor)->memtable_cursor);
-            free(*cursor);
-            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_CURSOR);
-        }
-
-        /* if column family has bloom filter set we skip first block */
-        if (cf->config.bloom_filter)
-        {
-            if (block_manager_cursor_next((*cursor)->sstable_cursor) == 0)
-            {
-                (void)block_manager_cursor_free((*cursor)->sstable_cursor);
-                (*cursor)->sstable_cursor = NULL;
-            }
-        }
-    }
-
-    /* unlock column family */
-    if (pthread_rwlock_unlock(&cf->rwlock) != 0)
-    {
-        (void)skip_list_cursor_free((*cursor)->memtable_cursor);
-        (void)block_manager_cursor_free((*cursor)->sstable_cursor);
+        (void)pthread_rwlock_unlock(&cf->rwlock);
         free(*cursor);
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
-    }
-
-    return NULL;
-}
-
-tidesdb_err_t *tidesdb_cursor_next(tidesdb_cursor_t *cursor)
-{
-    /* we check if cursor is invalid */
-    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
-
-    /* we get read lock for column family */
-    if (pthread_rwlock_rdlock(&cursor->cf->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
-
-    /* we check if memtable has a next kv */
-    while (1)
-    {
-        switch (cursor->cf->config.memtable_ds)
-        {
-            case TDB_MEMTABLE_SKIP_LIST:
-                if (cursor->memtable_cursor != NULL &&
-                    skip_list_cursor_next(cursor->memtable_cursor) == 0)
-                {
-                    if (((skip_list_cursor_t *)cursor->memtable_cursor)->current !=
-                        NULL) /* check if current is not NULL */
-                    {
-                        /* check if the value is not a tombstone */
-                        if (!_tidesdb_is_tombstone(
-                                ((skip_list_cursor_t *)cursor->memtable_cursor)->current->value,
-                                ((skip_list_cursor_t *)cursor->memtable_cursor)
-                                    ->current->value_size))
-                        {
-                            if (pthread_rwlock_unlock(&cursor->cf->rwlock) != 0)
-                                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK,
-                                                             "column family");
-
-                            return NULL;
-                        }
-                    }
-                }
-                break;
-            case TDB_MEMTABLE_HASH_TABLE:
-                if (cursor->memtable_cursor != NULL &&
-                    hash_table_cursor_next(cursor->memtable_cursor) == 0)
-                {
-                    uint8_t *retrieved_key;
-                    size_t retrieved_key_size;
-                    uint8_t *retrieved_value;
-                    size_t retrieved_value_size;
-                    time_t retrieved_ttl;
-                    if (hash_table_cursor_get(cursor->memtable_cursor, &retrieved_key,
-                                              &retrieved_key_size, &retrieved_value,
-                                              &retrieved_value_size, &retrieved_ttl) == 0)
-                    {
-                        if (!_tidesdb_is_tombstone(retrieved_value, retrieved_value_size))
-                        {
-                            if (pthread_rwlock_unlock(&cursor->cf->rwlock) != 0)
-                                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK,
-                                                             "column family");
-
-                            return NULL;
-                        }
-                    }
-                }
-                break;
-            default:
-                (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-                return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
-        }
-    }
-
-    /* if memtable is exhausted we check sstables
-     * starting at the most recent sstable
-     */
-
-    while (cursor->sstable_index >= 0)
-    {
-        /* we check if sstable cursor is valid and if it has a next block */
-        if (cursor->sstable_cursor != NULL &&
-            block_manager_cursor_next(cursor->sstable_cursor) == 0)
-        {
-            if (block_manager_cursor_has_next(cursor->sstable_cursor) == 1)
-            {
-                if (pthread_rwlock_unlock(&cursor->cf->rwlock) != 0)
-                    return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK,
-                                                 "column family");
-
-                /* we return NULL as we have a next kv */
-                return NULL;
-            }
-        }
-
-        /* if sstable is exhausted we move to the next sstable */
-        if (cursor->sstable_cursor != NULL)
-        {
-            /* we free the sstable cursor for current sstable */
-            (void)block_manager_cursor_free(cursor->sstable_cursor);
-            cursor->sstable_cursor = NULL;
-        }
-
-        cursor->sstable_index--; /* move to the next sstable */
-
-        if (cursor->sstable_index < 0)
-        {
-            cursor->sstable_index = 0; /* reset to the first sstable */
-            break;
-        }
-
-        /* we check if there are more sstables */
-        if (block_manager_cursor_init(&cursor->sstable_cursor,
-                                      cursor->cf->sstables[cursor->sstable_index]->block_manager) ==
-            -1)
-        {
-            if (pthread_rwlock_unlock(&cursor->cf->rwlock) != 0)
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
-            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_CURSOR);
-        }
-
-        /* if bloom is set we skip first block */
-        if (cursor->cf->config.bloom_filter)
-        {
-            if (block_manager_cursor_next(cursor->sstable_cursor) == 0)
-            {
-                block_manager_cursor_free(cursor->sstable_cursor);
-                cursor->sstable_cursor = NULL;
-            }
-        }
-
-        if (cursor->sstable_cursor != NULL)
-        {
-            if (pthread_rwlock_unlock(&cursor->cf->rwlock) != 0)
-                return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
-
-            return NULL;
-        }
-    }
-
-    if (pthread_rwlock_unlock(&cursor->cf->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
-
-    return tidesdb_err_from_code(TIDESDB_ERR_AT_END_OF_CURSOR);
-}
-
-tidesdb_err_t *tidesdb_cursor_prev(tidesdb_cursor_t *cursor)
-{
-    /* we check if cursor is invalid */
-    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
-
-    /* get column family read lock */
-    if (pthread_rwlock_rdlock(&cursor->cf->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
-
-    /* we check if memtable has a previous kv */
-    while (1)
-    {
-        switch (cursor->cf->config.memtable_ds)
-        {
-            case TDB_MEMTABLE_SKIP_LIST:
-                while (cursor->memtable_cursor != NULL &&
-                       skip_list_cursor_prev(cursor->memtable_cursor) == 0)
-                {
-                    if (!_tidesdb_is_tombstone(
-                            ((skip_list_cursor_t *)cursor->memtable_cursor)->current->value,
-                            ((skip_list_cursor_t *)cursor->memtable_cursor)->current->value_size))
-                    {
-                        (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-                        return NULL;
-                    }
-                }
-                break;
-            case TDB_MEMTABLE_HASH_TABLE:
-                while (cursor->memtable_cursor != NULL &&
-                       hash_table_cursor_prev(cursor->memtable_cursor) == 0)
-                {
-                    uint8_t *retrieved_key;
-                    size_t retrieved_key_size;
-                    uint8_t *retrieved_value;
-                    size_t retrieved_value_size;
-                    time_t retrieved_ttl;
-
-                    if (hash_table_cursor_get(cursor->memtable_cursor, &retrieved_key,
-                                              &retrieved_key_size, &retrieved_value,
-                                              &retrieved_value_size, &retrieved_ttl) == 0)
-                    {
-                        if (!_tidesdb_is_tombstone(retrieved_value, retrieved_value_size))
-                        {
-                            (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-                            return NULL;
-                        }
-                    }
-                }
-                break;
-            default:
-                return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
-        }
-
-        if (cursor->cf->num_sstables == 0)
-        {
-            (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-            return tidesdb_err_from_code(TIDESDB_ERR_AT_START_OF_CURSOR);
-        }
-
-        if (cursor->sstable_cursor == NULL)
-        {
-            /* reset to the first sstable */
-            cursor->sstable_index = 0;
-            (void)block_manager_cursor_goto_last(cursor->sstable_cursor);
-        }
-
-        if (cursor->sstable_cursor != NULL &&
-            block_manager_cursor_prev(cursor->sstable_cursor) == 0)
-        { /* go to the previous block */
-            if (block_manager_cursor_has_prev(cursor->sstable_cursor) == 1)
-            { /* check if there is a previous block after previous */
-                (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-                return NULL;
-            }
-        }
-
-        /* if sstable is exhausted we move to the previous sstable */
-        if ((size_t)cursor->sstable_index < (size_t)(cursor->cf->num_sstables - 1))
-        {
-            if (cursor->sstable_cursor != NULL)
-            {
-                (void)block_manager_cursor_free(cursor->sstable_cursor);
-                cursor->sstable_cursor = NULL;
-            }
-            cursor->sstable_index++;
-            if (block_manager_cursor_init(
-                    &cursor->sstable_cursor,
-                    cursor->cf->sstables[cursor->sstable_index]->block_manager) == -1)
-            {
-                (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-                continue; /* retry */
-            }
-            /* go to the last block */
-            (void)block_manager_cursor_goto_last(cursor->sstable_cursor);
-        }
-
-        (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-        break;
-    }
-
-    return tidesdb_err_from_code(TIDESDB_ERR_AT_START_OF_CURSOR);
-}
-
-tidesdb_err_t *tidesdb_cursor_get(tidesdb_cursor_t *cursor, uint8_t **key, size_t *key_size,
-                                  uint8_t **value, size_t *value_size)
-{
-    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
-    if (key == NULL || key_size == NULL || value == NULL || value_size == NULL)
-        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
-
-    /* get column family read lock */
-    if (pthread_rwlock_rdlock(&cursor->cf->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "column family");
-
-    block_manager_block_t *block;
-    while ((block = block_manager_cursor_read(cursor->sstable_cursor)) != NULL)
-    {
-        tidesdb_key_value_pair_t *dkv = _tidesdb_deserialize_key_value_pair(
-            block->data, block->size, cursor->cf->config.compressed,
-            cursor->cf->config.compress_algo);
-        if (dkv == NULL)
-        {
-            (void)block_manager_block_free(block);
-            (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-            return tidesdb_err_from_code(TIDESDB_ERR_COULD_NOT_GET_KEY_VALUE_FROM_CURSOR);
-        }
-
-        (void)block_manager_block_free(block);
-
-        if (_tidesdb_is_tombstone(dkv->value, dkv->value_size) || _tidesdb_is_expired(dkv->ttl))
-        {
-            _tidesdb_free_key_value_pair(dkv);
-            continue;
-        }
-
-        *key = malloc(dkv->key_size);
-        if (*key == NULL)
-        {
-            (void)_tidesdb_free_key_value_pair(dkv);
-            (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-            return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "key");
-        }
-        memcpy(*key, dkv->key, dkv->key_size);
-
-        *value = malloc(dkv->value_size);
-        if (*value == NULL)
-        {
-            free(*key);
-            (void)_tidesdb_free_key_value_pair(dkv);
-            (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-            return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "value");
-        }
-        memcpy(*value, dkv->value, dkv->value_size);
-
-        *key_size = dkv->key_size;
-        *value_size = dkv->value_size;
-        /* unlock the column family */
-        if (pthread_rwlock_unlock(&cursor->cf->rwlock) != 0)
-        {
-            free(*key);
-            free(*value);
-            (void)_tidesdb_free_key_value_pair(dkv);
-            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
-        }
-        (void)_tidesdb_free_key_value_pair(dkv);
-        return NULL;
-    }
-
-    uint8_t *k;
-    uint8_t *v;
-    time_t ttl = time(NULL);
-
-    switch (cursor->cf->config.memtable_ds)
-    {
-        case TDB_MEMTABLE_SKIP_LIST:
-            while (skip_list_cursor_get(cursor->memtable_cursor, &k, key_size, &v, value_size,
-                                        &ttl) == 0)
-            {
-                if (!_tidesdb_is_tombstone(v, *value_size))
-                {
-                    (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-                    *key = malloc(*key_size);
-                    if (*key == NULL)
-                    {
-                        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "key");
-                    }
-
-                    *value = malloc(*value_size);
-                    if (*value == NULL)
-                    {
-                        free(*key);
-                        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "value");
-                    }
-
-                    memcpy(*key, k, *key_size);
-                    memcpy(*value, v, *value_size);
-                    return NULL;
-                }
-            }
-            break;
-        case TDB_MEMTABLE_HASH_TABLE:
-            while (hash_table_cursor_get(cursor->memtable_cursor, &k, key_size, &v, value_size,
-                                         &ttl) == 0)
-            {
-                if (!_tidesdb_is_tombstone(v, *value_size))
-                {
-                    (void)pthread_rwlock_unlock(&cursor->cf->rwlock);
-                    *key = malloc(*key_size);
-                    if (*key == NULL)
-                    {
-                        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "key");
-                    }
-
-                    *value = malloc(*value_size);
-                    if (*value == NULL)
-                    {
-                        free(*key);
-                        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "value");
-                    }
-
-                    memcpy(*key, k, *key_size);
-                    memcpy(*value, v, *value_size);
-                    return NULL;
-                }
-            }
-            break;
-        default:
-            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
+        return tidesdb_err_from_code(TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
     }
 
-    if (pthread_rwlock_unlock(&cursor->cf->rwlock) != 0)
-        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_RELEASE_LOCK, "column family");
-
-    return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
-}
-
-tidesdb_err_t *tidesdb_cursor_free(tidesdb_cursor_t *cursor)
-{
-    /* we check if the cursor is NULL */
-    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
-
-    /* we free the sstable cursor */
-    if (cursor->sstable_cursor != NULL) block_manager_cursor_free(cursor->sstable_cursor);
+    /* the cursor pins the current version so compactions don't remove sstables from under it,
+     * a flush installs its version under the write lock so nothing is missed or seen twice */
+    (*cursor)->version = _tidesdb_acquire_version(cf);
 
-    /* we free the memtable cursor */
-    switch (cursor->cf->config.memtable_ds)
+    /* the memtable snapshot first then the sstables from newest to oldest, a key in a source
+     * shadows the same key in every source after it */
+    (*cursor)->sources =
+        calloc((*cursor)->version->num_sstables + 1, sizeof(tidesdb_cursor_source_t));
+    if ((*cursor)->sources == NULL)
     {
-        case TDB_MEMTABLE_SKIP_LIST:
-            if (cursor->memtable_cursor != NULL) skip_list_cursor_free(cursor->memtable_cursor);
-            break;
-        case TDB_MEMTABLE_HASH_TABLE:
-            if (cursor->memtable_cursor != NULL) hash_table_cursor_destroy(cursor->memtable_cursor);
-            break;
-        default:
-            return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MEMTABLE_DATA_STRUCTURE);
+        (void)pthread_rwlock_unlock(&cf->rwlock);
+        (void)_tidesdb_release_version((*cursor)->version);
+        free(*cursor);
+        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "cursor sources");
     }
 
-    free(cursor);
-
-    cursor = NULL;
+    /* we copy the memtable shards straight into one sorted source while we still hold the
+     * column family lock, the shard locks are taken while they are read */
+    int rc = _tidesdb_cursor_source_from_memtable(cf, &(*cursor)->sources[0]);
+    (*cursor)->num_sources = 1;
 
-    return NULL;
-}
+    /* unlock column family */
+    (void)pthread_rwlock_unlock(&cf->rwlock);
 
-int _tidesdb_is_expired(int64_t ttl)
-{
-    if (ttl != -1 && ttl < time(NULL))
+    for (int i = (*cursor)->version->num_sstables - 1; i >= 0 && rc == 0; i--)
     {
-        return 1; /* key is expired */
+        rc = _tidesdb_cursor_source_from_sstable(cf, &(*cursor)->sources[(*cursor)->num_sources],
+                                                 (*cursor)->version->sstables[i]);
+        (*cursor)->num_sources++;
     }
 
-    return 0; /* key either has no ttl or has not expired */
-}
-
-tidesdb_sstable_t *_tidesdb_merge_sstables_w_bloomfilter(tidesdb_sstable_t *sst1,
-                                                         tidesdb_sstable_t *sst2,
-                                                         tidesdb_column_family_t *cf,
-                                                         pthread_mutex_t *shared_lock)
-{
-    /*
-     * similar to _tidesdb_merge_sstables but with bloom filter
-     */
-
-    /* we initialize a new sstable */
-    tidesdb_sstable_t *merged_sstable = malloc(sizeof(tidesdb_sstable_t));
-    if (merged_sstable == NULL) return NULL;
-
-    /* we initialize a new skiplist as a mergetable with column family configurations */
-    skip_list_t *mergetable = skip_list_new(cf->config.max_level, cf->config.probability);
-    if (mergetable == NULL)
-    {
-        free(merged_sstable);
-        return NULL;
-    }
+    /* we position the cursor on the first live entry */
+    for (int i = 0; i < (*cursor)->num_sources && rc == 0; i++)
+        if (_tidesdb_cursor_source_seek(*cursor, &(*cursor)->sources[i], 0) == -1) rc = -1;
 
-    /* we create a new sstable with a named based on the amount of sstables */
-    char sstable_path[MAX_FILE_PATH_LENGTH];
+    if (rc == 0 && _tidesdb_cursor_find_forward(*cursor) == -1) rc = -1;
 
-    /* lock to make sure path is unique */
-    if (pthread_mutex_lock(shared_lock) != 0)
+    if (rc == -1)
     {
-        (void)skip_list_destroy(mergetable);
-        free(merged_sstable);
-        return NULL;
+        (void)_tidesdb_cursor_free_sources(*cursor);
+        (void)_tidesdb_release_version((*cursor)->version);
+        free(*cursor);
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_CURSOR);
     }
 
-    snprintf(sstable_path, sizeof(sstable_path), "%s%s%s%d%s", cf->path,
-             _tidesdb_get_path_seperator(), TDB_SSTABLE_PREFIX, cf->num_sstables, TDB_SSTABLE_EXT);
-    cf->num_sstables++;
+    /* the cursor keeps the column family alive until it is freed */
+    (void)_tidesdb_ref_column_family(cf);
 
-    /* unlock the shared lock */
-    if (pthread_mutex_unlock(shared_lock) != 0)
+    return NULL;
+}
+
+int _tidesdb_cursor_source_from_memtable(tidesdb_column_family_t *cf,
+                                         tidesdb_cursor_source_t *source)
+{
+    source->index = -1;
+
+    /* we read every shard shared at once, the caller holds the column family lock so no flush
+     * clears them meanwhile */
+    for (int i = 0; i < cf->config.memtable_shards; i++)
+        (void)pthread_rwlock_rdlock(&cf->shards[i].rwlock);
+
+    int count = 0;
+    for (int i = 0; i < cf->config.memtable_shards; i++)
     {
-        (void)skip_list_destroy(mergetable);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
+            count += skip_list_count_entries(cf->shards[i].memtable);
+        else
+            count += (int)((hash_table_t *)cf->shards[i].memtable)->count;
     }
 
-    /* we open a new block manager for the merged sstable */
-    if (block_manager_open(&merged_sstable->block_manager, sstable_path, TDB_SYNC_INTERVAL) == -1)
+    int rc = 0;
+    if (count > 0)
     {
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        source->entries = malloc(sizeof(tidesdb_key_value_pair_t *) * count);
+        if (source->entries == NULL)
+            rc = -1;
+        else if (cf->config.memtable_ds == TDB_MEMTABLE_SKIP_LIST)
+            rc = _tidesdb_cursor_merge_memtable(cf, source, count);
+        else
+            rc = _tidesdb_cursor_sort_memtable(cf, source, count);
     }
 
-    /* we populate the merge table with the sstables and bloomfilter */
-    /* we create a bloom filter for the merged sstable */
-    bloom_filter_t *bf;
+    for (int i = 0; i < cf->config.memtable_shards; i++)
+        (void)pthread_rwlock_unlock(&cf->shards[i].rwlock);
 
-    /* we block counts from sst1 and sst2 */
-    int block_count1 = block_manager_count_blocks(sst1->block_manager);
-    int block_count2 = block_manager_count_blocks(sst2->block_manager);
+    return rc;
+}
 
-    if (bloom_filter_new(&bf, TDB_BLOOMFILTER_P, block_count1 + block_count2) == -1)
-    {
-        (void)block_manager_close(merged_sstable->block_manager);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
-    }
+int _tidesdb_cursor_merge_memtable(tidesdb_column_family_t *cf, tidesdb_cursor_source_t *source,
+                                   int count)
+{
+    int num_shards = cf->config.memtable_shards;
+    skip_list_cursor_t **cursors = calloc(num_shards, sizeof(skip_list_cursor_t *));
+    if (cursors == NULL) return -1;
 
-    block_manager_cursor_t *cursor = NULL;
+    uint8_t *key;
+    size_t key_size;
+    uint8_t *value;
+    size_t value_size;
+    time_t ttl;
 
-    /* init cursor for sstable 1 */
-    if (block_manager_cursor_init(&cursor, sst1->block_manager) == -1)
+    /* a cursor is dropped once its shard runs out, empty shards never get one */
+    int rc = 0;
+    for (int i = 0; i < num_shards && rc == 0; i++)
     {
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        cursors[i] = skip_list_cursor_init(cf->shards[i].memtable);
+        if (cursors[i] == NULL)
+            rc = -1;
+        else if (skip_list_cursor_get(cursors[i], &key, &key_size, &value, &value_size, &ttl) != 0)
+        {
+            (void)skip_list_cursor_free(cursors[i]);
+            cursors[i] = NULL;
+        }
     }
 
-    block_manager_block_t *block;
-    while ((block = block_manager_cursor_read(cursor)) != NULL)
+    /* keys are hashed to a single shard so we only pick the smallest head each time */
+    while (rc == 0 && source->num_entries < count)
     {
-        tidesdb_key_value_pair_t *kv = _tidesdb_deserialize_key_value_pair(
-            block->data, block->size, cf->config.compressed, cf->config.compress_algo);
-        if (kv == NULL)
+        int min = -1;
+        uint8_t *min_key = NULL;
+        size_t min_key_size = 0;
+        for (int i = 0; i < num_shards; i++)
         {
-            (void)block_manager_block_free(block);
-            continue;
+            if (cursors[i] == NULL) continue;
+            (void)skip_list_cursor_get(cursors[i], &key, &key_size, &value, &value_size, &ttl);
+            if (min == -1 || _tidesdb_compare_keys(key, key_size, min_key, min_key_size) < 0)
+            {
+                min = i;
+                min_key = key;
+                min_key_size = key_size;
+            }
         }
+        if (min == -1) break;
 
-        if (_tidesdb_is_tombstone(kv->value, kv->value_size))
+        (void)skip_list_cursor_get(cursors[min], &key, &key_size, &value, &value_size, &ttl);
+        tidesdb_key_value_pair_t *kv =
+            _tidesdb_key_value_pair_new(key, key_size, value, value_size, ttl);
+        if (kv == NULL)
         {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
+            rc = -1;
+            break;
         }
+        source->entries[source->num_entries++] = kv;
 
-        if (_tidesdb_is_expired(kv->ttl))
+        if (skip_list_cursor_next(cursors[min]) != 0)
         {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
+            (void)skip_list_cursor_free(cursors[min]);
+            cursors[min] = NULL;
         }
+    }
 
-        /* add to bloom filter */
-        (void)bloom_filter_add(bf, kv->key, kv->key_size);
+    for (int i = 0; i < num_shards; i++)
+        if (cursors[i] != NULL) (void)skip_list_cursor_free(cursors[i]);
+    free(cursors);
+
+    return rc;
+}
+
+int _tidesdb_cursor_sort_memtable(tidesdb_column_family_t *cf, tidesdb_cursor_source_t *source,
+                                  int count)
+{
+    uint8_t *key;
+    size_t key_size;
+    uint8_t *value;
+    size_t value_size;
+    time_t ttl;
+
+    /* hash tables hold no order so we gather every shard and sort once */
+    for (int i = 0; i < cf->config.memtable_shards; i++)
+    {
+        hash_table_cursor_t *cursor = hash_table_cursor_new(cf->shards[i].memtable);
+        if (cursor == NULL) return -1;
 
-        if (skip_list_put(mergetable, kv->key, kv->key_size, kv->value, kv->value_size, kv->ttl) ==
-            -1)
+        do
         {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
+            if (hash_table_cursor_get(cursor, &key, &key_size, &value, &value_size, &ttl) != 0)
+                continue;
 
-        (void)block_manager_block_free(block);
-        (void)_tidesdb_free_key_value_pair(kv);
+            if (source->num_entries == count) break;
 
-        if (block_manager_cursor_next(cursor) != 0) break;
-    }
+            tidesdb_key_value_pair_t *kv =
+                _tidesdb_key_value_pair_new(key, key_size, value, value_size, ttl);
+            if (kv == NULL)
+            {
+                (void)hash_table_cursor_destroy(cursor);
+                return -1;
+            }
 
-    (void)block_manager_block_free(block);
-    block = NULL;
-    (void)block_manager_cursor_free(cursor);
-    cursor = NULL;
+            source->entries[source->num_entries++] = kv;
+        } while (hash_table_cursor_next(cursor) == 0);
 
-    /* init cursor for sstable 2 */
-    if (block_manager_cursor_init(&cursor, sst2->block_manager) == -1)
-    {
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        (void)hash_table_cursor_destroy(cursor);
     }
 
-    while ((block = block_manager_cursor_read(cursor)) != NULL)
-    {
-        tidesdb_key_value_pair_t *kv = _tidesdb_deserialize_key_value_pair(
-            block->data, block->size, cf->config.compressed, cf->config.compress_algo);
-        if (kv == NULL)
-        {
-            (void)block_manager_block_free(block);
-            continue;
-        }
+    qsort(source->entries, source->num_entries, sizeof(tidesdb_key_value_pair_t *),
+          _tidesdb_compare_key_value_pairs);
 
-        if (_tidesdb_is_tombstone(kv->value, kv->value_size))
-        {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
+    return 0;
+}
 
-        if (_tidesdb_is_expired(kv->ttl))
-        {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
+int _tidesdb_compare_key_value_pairs(const void *a, const void *b)
+{
+    const tidesdb_key_value_pair_t *kv1 = *(tidesdb_key_value_pair_t *const *)a;
+    const tidesdb_key_value_pair_t *kv2 = *(tidesdb_key_value_pair_t *const *)b;
 
-        (void)bloom_filter_add(bf, kv->key, kv->key_size);
+    return _tidesdb_compare_keys(kv1->key, kv1->key_size, kv2->key, kv2->key_size);
+}
 
-        if (skip_list_put(mergetable, kv->key, kv->key_size, kv->value, kv->value_size, kv->ttl) ==
-            -1)
-        {
-            (void)block_manager_block_free(block);
-            (void)_tidesdb_free_key_value_pair(kv);
-            continue;
-        }
+int _tidesdb_cursor_source_from_sstable(tidesdb_column_family_t *cf,
+                                        tidesdb_cursor_source_t *source, tidesdb_sstable_t *sst)
+{
+    source->sstable = sst;
+    source->index = -1;
 
-        (void)block_manager_block_free(block);
-        (void)_tidesdb_free_key_value_pair(kv);
+    /* the source holds its own reference on the sstable */
+    (void)_tidesdb_ref_sstable(sst);
 
-        if (block_manager_cursor_next(cursor) != 0) break;
+    if (block_manager_cursor_init(&source->block_cursor, sst->block_manager) == -1)
+    {
+        source->block_cursor = NULL;
+        return -1;
     }
 
-    (void)block_manager_cursor_free(cursor);
+    /* a partitioned sstable has its key value blocks first, up to data_end */
+    source->data_end = UINT64_MAX;
+    if (cf->config.partitioned_index)
+    {
+        tidesdb_sstable_index_t *index = _tidesdb_sstable_index(sst);
+        if (index == NULL) return -1;
+        source->data_end = index->data_end;
+    }
 
-    skip_list_cursor_t *mergetable_cursor = skip_list_cursor_init(mergetable);
-    if (mergetable_cursor == NULL)
+    /* if column family has bloom filter set we skip first block */
+    else if (cf->config.bloom_filter)
     {
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        if (block_manager_cursor_next(source->block_cursor) != 0) source->exhausted = true;
     }
 
-    /* now we write the bloom filter to the merged sstable */
-    size_t bf_size;
-    uint8_t *bf_serialized = bloom_filter_serialize(bf, &bf_size);
-    if (bf_serialized == NULL)
+    source->end_offset = source->block_cursor->current_pos;
+    if (source->end_offset >= source->data_end) source->exhausted = true;
+
+    return 0;
+}
+
+int _tidesdb_cursor_source_seek(tidesdb_cursor_t *cursor, tidesdb_cursor_source_t *source,
+                                int index)
+{
+    /* the memtable snapshot is in memory so we just move to the entry */
+    if (source->sstable == NULL)
     {
-        (void)skip_list_cursor_free(mergetable_cursor);
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        if (index < 0 || index >= source->num_entries)
+        {
+            source->index = index < 0 ? -1 : source->num_entries;
+            source->kv = NULL;
+            return 1;
+        }
+
+        source->index = index;
+        source->kv = source->entries[index];
+        return 0;
     }
 
-    /* we create a new block */
-    block_manager_block_t *bf_block = block_manager_block_create(bf_size, bf_serialized);
-    if (bf_block == NULL)
+    if (source->kv != NULL)
     {
-        free(bf_serialized);
-        (void)skip_list_cursor_free(mergetable_cursor);
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        (void)_tidesdb_free_key_value_pair(source->kv);
+        source->kv = NULL;
     }
 
-    /* we write the block to the merged sstable */
-    if (block_manager_block_write(merged_sstable->block_manager, bf_block) == -1)
+    if (index < 0)
     {
-        (void)block_manager_block_free(bf_block);
-        free(bf_serialized);
-        (void)skip_list_cursor_free(mergetable_cursor);
-        (void)skip_list_destroy(mergetable);
-        (void)remove(sstable_path);
-        free(merged_sstable);
-        cf->num_sstables--;
-        return NULL;
+        source->index = -1;
+        return 1;
     }
 
-    /* now we write the key-value pairs to the merged sstable
-     * the mergetable will have keys sorted
-     */
+    block_manager_block_t *block = NULL;
 
-    do
+    if (index < source->num_offsets)
     {
-        tidesdb_key_value_pair_t *kv = malloc(sizeof(tidesdb_key_value_pair_t));
-        if (kv == NULL)
+        /* we have passed the entry before so we know where it is */
+        source->block_cursor->current_pos = source->offsets[index];
+        block = block_manager_cursor_read(source->block_cursor);
+        if (block == NULL) return -1;
+    }
+    else
+    {
+        /* we read forward from the furthest entry we know of, recording offsets on the way */
+        while (source->num_offsets <= index && !source->exhausted)
         {
-            (void)skip_list_cursor_free(mergetable_cursor);
-            (void)skip_list_destroy(mergetable);
-            (void)remove(sstable_path);
-            free(merged_sstable);
-            cf->num_sstables--;
-            return NULL;
-        }
+            if (block != NULL) (void)block_manager_block_free(block);
 
-        uint8_t *retrieved_key;
-        size_t key_size;
-        uint8_t *retrieved_value;
-        size_t value_size;
-        time_t ttl;
-        if (skip_list_cursor_get(mergetable_cursor, &retrieved_key, &key_size, &retrieved_value,
-                                 &value_size, &ttl) == -1)
-        {
-            free(kv);
-            continue;
-        }
+            source->block_cursor->current_pos = source->end_offset;
+            block = block_manager_cursor_read(source->block_cursor);
+            if (block == NULL)
+            {
+                source->exhausted = true;
+                break;
+            }
 
-        /* we copy the key */
-        kv->key = malloc(key_size);
-        if (kv->key == NULL)
-        {
-            free(kv);
-            continue;
+            if (source->num_offsets == source->offsets_capacity)
+            {
+                int capacity = source->offsets_capacity == 0 ? 64 : source->offsets_capacity * 2;
+                uint64_t *offsets = realloc(source->offsets, sizeof(uint64_t) * capacity);
+                if (offsets == NULL)
+                {
+                    (void)block_manager_block_free(block);
+                    return -1;
+                }
+
+                source->offsets = offsets;
+                source->offsets_capacity = capacity;
+            }
+
+            source->offsets[source->num_offsets++] = source->end_offset;
+            source->end_offset += sizeof(uint64_t) + block->size;
+            if (source->end_offset >= source->data_end) source->exhausted = true;
         }
-        memcpy(kv->key, retrieved_key, key_size);
 
-        /* we copy the value */
-        kv->value = malloc(value_size);
-        if (kv->value == NULL)
+        if (source->num_offsets <= index)
         {
-            free(kv->key);
-            free(kv);
-            continue;
+            source->index = source->num_offsets;
+            return 1;
         }
+    }
 
-        memcpy(kv->value, retrieved_value, value_size);
+    source->kv = _tidesdb_deserialize_key_value_pair(block->data, block->size,
+                                                     cursor->cf->config.compressed,
+                                                     cursor->cf->config.compress_algo);
+    (void)block_manager_block_free(block);
+    if (source->kv == NULL) return -1;
 
-        /* we set the key size */
-        kv->key_size = key_size;
-        /* we set the value size */
-        kv->value_size = value_size;
-        /* we set the ttl */
-        kv->ttl = ttl;
+    source->index = index;
 
-        size_t serialized_size;
-        uint8_t *serialized_kv = _tidesdb_serialize_key_value_pair(
-            kv, &serialized_size, cf->config.compressed, cf->config.compress_algo);
-        if (serialized_kv == NULL)
-        {
-            free(kv);
-            break;
-        }
+    return 0;
+}
 
-        block_manager_block_t *block = block_manager_block_create(serialized_size, serialized_kv);
-        if (block == NULL)
+int _tidesdb_cursor_find_forward(tidesdb_cursor_t *cursor)
+{
+    while (true)
+    {
+        /* we find the smallest key, on a tie the newest source wins */
+        int current = -1;
+        for (int i = 0; i < cursor->num_sources; i++)
         {
-            free(kv);
-            free(serialized_kv);
-            break;
-        }
+            tidesdb_key_value_pair_t *kv = cursor->sources[i].kv;
+            if (kv == NULL) continue;
 
-        if (block_manager_block_write(merged_sstable->block_manager, block) == -1)
-        {
-            (void)block_manager_block_free(block);
-            free(kv);
-            free(serialized_kv);
-            break;
+            tidesdb_key_value_pair_t *min = current == -1 ? NULL : cursor->sources[current].kv;
+            if (min == NULL ||
+                _tidesdb_compare_keys(kv->key, kv->key_size, min->key, min->key_size) < 0)
+                current = i;
         }
 
-        (void)block_manager_block_free(block);
-        free(serialized_kv);
-        (void)_tidesdb_free_key_value_pair(kv);
+        cursor->current = current;
+        if (current == -1) return 1;
 
-    } while (skip_list_cursor_next(mergetable_cursor) != -1);
+        tidesdb_cursor_source_t *source = &cursor->sources[current];
 
-    (void)skip_list_cursor_free(mergetable_cursor);
-    (void)skip_list_clear(mergetable);
-    (void)skip_list_destroy(mergetable);
+        /* older versions of the key in other sources are shadowed so we move them past it */
+        for (int i = 0; i < cursor->num_sources; i++)
+        {
+            tidesdb_cursor_source_t *other = &cursor->sources[i];
+            if (i == current || other->kv == NULL) continue;
+
+            if (_tidesdb_compare_keys(other->kv->key, other->kv->key_size, source->kv->key,
+                                      source->kv->key_size) == 0)
+            {
+                if (_tidesdb_cursor_source_seek(cursor, other, other->index + 1) == -1)
+                    return -1;
+            }
+        }
 
-    return merged_sstable;
+        if (!_tidesdb_is_tombstone(source->kv->value, source->kv->value_size) &&
+            !_tidesdb_is_expired(source->kv->ttl))
+            return 0;
 
-    return NULL;
+        /* the key was deleted or has expired so we skip it */
+        if (_tidesdb_cursor_source_seek(cursor, source, source->index + 1) == -1) return -1;
+    }
 }
 
-int _tidesdb_flush_memtable_w_bloomfilter(tidesdb_column_family_t *cf)
+int _tidesdb_cursor_find_backward(tidesdb_cursor_t *cursor)
 {
-    /* similar to _tidesdb_flush_memtable but with bloom filter */
+    while (true)
+    {
+        /* we find the largest key, on a tie the newest source wins */
+        int current = -1;
+        for (int i = 0; i < cursor->num_sources; i++)
+        {
+            tidesdb_key_value_pair_t *kv = cursor->sources[i].kv;
+            if (kv == NULL) continue;
 
-    /* we create a new sstable struct */
-    tidesdb_sstable_t *sst = malloc(sizeof(tidesdb_sstable_t));
-    if (sst == NULL) return -1;
+            tidesdb_key_value_pair_t *max = current == -1 ? NULL : cursor->sources[current].kv;
+            if (max == NULL ||
+                _tidesdb_compare_keys(kv->key, kv->key_size, max->key, max->key_size) > 0)
+                current = i;
+        }
 
-    /* we create a new sstable with a named based on the amount of sstables */
-    char sstable_path[MAX_FILE_PATH_LENGTH];
-    snprintf(sstable_path, sizeof(sstable_path), "%s%s%s%d%s", cf->path,
-             _tidesdb_get_path_seperator(), TDB_SSTABLE_PREFIX, cf->num_sstables, TDB_SSTABLE_EXT);
+        cursor->current = current;
+        if (current == -1) return 1;
 
-    /* we create a new block manager */
-    block_manager_t *sstable_block_manager = NULL;
+        tidesdb_cursor_source_t *source = &cursor->sources[current];
 
-    if (block_manager_open(&sstable_block_manager, sstable_path, TDB_SYNC_INTERVAL) == -1)
-    {
-        return -1;
-    }
+        /* older versions of the key in other sources are shadowed so we move them before it */
+        for (int i = 0; i < cursor->num_sources; i++)
+        {
+            tidesdb_cursor_source_t *other = &cursor->sources[i];
+            if (i == current || other->kv == NULL) continue;
 
-    /* we set the block manager */
-    sst->block_manager = sstable_block_manager;
+            if (_tidesdb_compare_keys(other->kv->key, other->kv->key_size, source->kv->key,
+                                      source->kv->key_size) == 0)
+            {
+                if (_tidesdb_cursor_source_seek(cursor, other, other->index - 1) == -1)
+                    return -1;
+            }
+        }
 
-    /* we figure out how large the bloom filter should be by getting amount of nodes in memtable */
-    int bloom_filter_size = skip_list_count_entries(cf->memtable);
+        if (!_tidesdb_is_tombstone(source->kv->value, source->kv->value_size) &&
+            !_tidesdb_is_expired(source->kv->ttl))
+            return 0;
 
-    /* we initialize the bloom filter */
-    bloom_filter_t *bf = NULL;
-    if (bloom_filter_new(&bf, TDB_BLOOMFILTER_P, bloom_filter_size) == -1)
-    {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        /* the key was deleted or has expired so we skip it */
+        if (_tidesdb_cursor_source_seek(cursor, source, source->index - 1) == -1) return -1;
     }
+}
 
-    /* we iterate over memtable and populate the bloom filter */
-    skip_list_cursor_t *cursor = skip_list_cursor_init(cf->memtable);
-    if (cursor == NULL)
-    {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
-    }
+int _tidesdb_cursor_set_direction(tidesdb_cursor_t *cursor, bool forward)
+{
+    if (cursor->forward == forward) return 0;
+
+    tidesdb_key_value_pair_t *kv = cursor->sources[cursor->current].kv;
+    int step = forward ? 1 : -1;
 
-    do
+    /* going forward every other source must be on its first key after the current key, going
+     * backward on its last key before it, so we step each one over the current key */
+    for (int i = 0; i < cursor->num_sources; i++)
     {
-        uint8_t *retrieved_key;
-        size_t key_size;
-        uint8_t *retrieved_value;
-        size_t value_size;
-        time_t ttl;
-        if (skip_list_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size,
-                                 &ttl) == -1)
+        tidesdb_cursor_source_t *source = &cursor->sources[i];
+        if (i == cursor->current) continue;
+
+        if (_tidesdb_cursor_source_seek(cursor, source, source->index + step) == -1) return -1;
+
+        if (source->kv != NULL && _tidesdb_compare_keys(source->kv->key, source->kv->key_size,
+                                                        kv->key, kv->key_size) == 0)
         {
-            free(retrieved_key);
-            free(retrieved_value);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
+            if (_tidesdb_cursor_source_seek(cursor, source, source->index + step) == -1)
+                return -1;
         }
+    }
 
-        /* add to bloom filter */
-        (void)bloom_filter_add(bf, retrieved_key, key_size);
+    cursor->forward = forward;
 
-    } while (skip_list_cursor_next(cursor) != -1);
+    return 0;
+}
 
-    /* we free the cursor */
-    (void)skip_list_cursor_free(cursor);
-    cursor = NULL;
+int _tidesdb_cursor_move(tidesdb_cursor_t *cursor, bool forward)
+{
+    if (cursor->current == -1) return 1;
 
-    size_t serialized_bf_size;
-    uint8_t *serialized_bf = bloom_filter_serialize(bf, &serialized_bf_size);
-    if (serialized_bf == NULL)
-    {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
-    }
+    /* we remember where every source is so we can stay on the current entry at either end */
+    int *indexes = malloc(sizeof(int) * cursor->num_sources);
+    if (indexes == NULL) return -1;
 
-    bloom_filter_free(bf);
+    for (int i = 0; i < cursor->num_sources; i++) indexes[i] = cursor->sources[i].index;
+    int current = cursor->current;
+    bool direction = cursor->forward;
 
-    /* we write the bloom filter to the sstable */
-    block_manager_block_t *bf_block = block_manager_block_create(serialized_bf_size, serialized_bf);
-    if (bf_block == NULL)
+    int rc = _tidesdb_cursor_set_direction(cursor, forward);
+    if (rc == 0)
     {
-        free(sst);
-        free(serialized_bf);
-        (void)remove(sstable_path);
-        return -1;
+        tidesdb_cursor_source_t *source = &cursor->sources[cursor->current];
+        rc = _tidesdb_cursor_source_seek(cursor, source, source->index + (forward ? 1 : -1));
     }
 
-    free(serialized_bf);
+    if (rc != -1)
+        rc = forward ? _tidesdb_cursor_find_forward(cursor) : _tidesdb_cursor_find_backward(cursor);
 
-    /* we write the block to the sstable */
-    if (block_manager_block_write(sst->block_manager, bf_block) == -1)
+    if (rc == 1)
     {
-        (void)block_manager_block_free(bf_block);
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        /* there is nothing past the current entry so we put every source back */
+        for (int i = 0; i < cursor->num_sources && rc != -1; i++)
+            if (_tidesdb_cursor_source_seek(cursor, &cursor->sources[i], indexes[i]) == -1)
+                rc = -1;
+
+        cursor->current = current;
+        cursor->forward = direction;
     }
 
-    /* we free the resources */
-    (void)block_manager_block_free(bf_block);
+    free(indexes);
 
-    /* we reinitialize the cursor to populate the sstable with keyvalue pairs after bloomfilter */
-    cursor = skip_list_cursor_init(cf->memtable);
-    if (cursor == NULL)
-    {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
-    }
+    return rc;
+}
 
-    /* we iterate over the memtable and write to the sstable */
-    do
-    {
-        /* we get the key value pair */
-        tidesdb_key_value_pair_t *kv = malloc(sizeof(tidesdb_key_value_pair_t));
-        if (kv == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+tidesdb_err_t *tidesdb_cursor_next(tidesdb_cursor_t *cursor)
+{
+    /* we check if cursor is invalid */
+    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
 
-        /* we get the key */
+    int rc = _tidesdb_cursor_move(cursor, true);
+    if (rc == 1) return tidesdb_err_from_code(TIDESDB_ERR_AT_END_OF_CURSOR);
+    if (rc == -1) return tidesdb_err_from_code(TIDESDB_ERR_COULD_NOT_GET_KEY_VALUE_FROM_CURSOR);
 
-        if (skip_list_cursor_get(cursor, &kv->key, (size_t *)&kv->key_size, &kv->value,
-                                 (size_t *)&kv->value_size, &kv->ttl) == -1)
-        {
-            free(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    return NULL;
+}
 
-        /* we serialize the key value pair */
-        size_t serialized_size;
-        uint8_t *serialized_kv = _tidesdb_serialize_key_value_pair(
-            kv, &serialized_size, cf->config.compressed, cf->config.compress_algo);
-        if (serialized_kv == NULL)
-        {
-            (void)_tidesdb_free_key_value_pair(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+tidesdb_err_t *tidesdb_cursor_prev(tidesdb_cursor_t *cursor)
+{
+    /* we check if cursor is invalid */
+    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
 
-        free(kv);
+    int rc = _tidesdb_cursor_move(cursor, false);
+    if (rc == 1) return tidesdb_err_from_code(TIDESDB_ERR_AT_START_OF_CURSOR);
+    if (rc == -1) return tidesdb_err_from_code(TIDESDB_ERR_COULD_NOT_GET_KEY_VALUE_FROM_CURSOR);
 
-        /* we create a new block */
-        block_manager_block_t *block = block_manager_block_create(serialized_size, serialized_kv);
-        if (block == NULL)
-        {
-            free(sst);
-            free(serialized_kv);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    return NULL;
+}
 
-        /* we write the block to the sstable */
-        if (block_manager_block_write(sst->block_manager, block) == -1)
-        {
-            (void)block_manager_block_free(block);
-            free(sst);
-            free(serialized_kv);
-            (void)remove(sstable_path);
-            return -1;
-        }
+tidesdb_err_t *tidesdb_cursor_seek(tidesdb_cursor_t *cursor, const uint8_t *key, size_t key_size)
+{
+    /* we check if cursor is invalid */
+    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
 
-        /* we free the resources */
-        (void)block_manager_block_free(block);
-        free(serialized_kv);
+    /* we check if the key is NULL */
+    if (key == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_KEY);
 
-    } while (skip_list_cursor_next(cursor) != -1);
+    /* every source moves to its first entry at or past the key, the cursor then takes the
+     * smallest live one as it would moving forward */
+    for (int i = 0; i < cursor->num_sources; i++)
+        if (_tidesdb_cursor_source_seek_key(cursor, &cursor->sources[i], key, key_size) == -1)
+            return tidesdb_err_from_code(TIDESDB_ERR_COULD_NOT_GET_KEY_VALUE_FROM_CURSOR);
 
-    /* we free the cursor */
-    (void)skip_list_cursor_free(cursor);
+    cursor->forward = true;
 
-    cursor = NULL;
+    int rc = _tidesdb_cursor_find_forward(cursor);
+    if (rc == 1) return tidesdb_err_from_code(TIDESDB_ERR_AT_END_OF_CURSOR);
+    if (rc == -1) return tidesdb_err_from_code(TIDESDB_ERR_COULD_NOT_GET_KEY_VALUE_FROM_CURSOR);
 
-    /* we add the sstable to the column family */
-    if (cf->sstables == NULL)
+    return NULL;
+}
+
+int _tidesdb_cursor_source_seek_key(tidesdb_cursor_t *cursor, tidesdb_cursor_source_t *source,
+                                    const uint8_t *key, size_t key_size)
+{
+    /* we binary search the entries we know the position of, all of them for the memtable */
+    int lo = 0;
+    int hi = source->sstable == NULL ? source->num_entries : source->num_offsets;
+    while (lo < hi)
     {
-        cf->sstables = malloc(sizeof(tidesdb_sstable_t));
-        if (cf->sstables == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+        int mid = lo + (hi - lo) / 2;
+        if (_tidesdb_cursor_source_seek(cursor, source, mid) != 0) return -1;
+
+        if (_tidesdb_compare_keys(source->kv->key, source->kv->key_size, key, key_size) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
-    else
+
+    /* past the known entries of an sstable we read forward until we reach the key */
+    for (int index = lo;; index++)
     {
-        tidesdb_sstable_t **temp_sstables =
-            realloc(cf->sstables, sizeof(tidesdb_sstable_t) * (cf->num_sstables + 1));
-        if (temp_sstables == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+        int rc = _tidesdb_cursor_source_seek(cursor, source, index);
+        if (rc != 0) return rc;
 
-        cf->sstables = temp_sstables;
+        if (_tidesdb_compare_keys(source->kv->key, source->kv->key_size, key, key_size) >= 0)
+            return 0;
     }
+}
 
-    /* we increment the number of sstables
-     * and set the sstable
-     */
-    cf->sstables[cf->num_sstables] = sst;
-    cf->num_sstables++;
+tidesdb_err_t *tidesdb_cursor_get(tidesdb_cursor_t *cursor, uint8_t **key, size_t *key_size,
+                                  uint8_t **value, size_t *value_size)
+{
+    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
+    if (key == NULL || key_size == NULL || value == NULL || value_size == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
 
-    /* clear memtable */
-    if (skip_list_clear(cf->memtable) == -1)
-    {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
-    }
+    /* the cursor is empty */
+    if (cursor->current == -1)
+        return tidesdb_err_from_code(TIDESDB_ERR_COULD_NOT_GET_KEY_VALUE_FROM_CURSOR);
+
+    tidesdb_key_value_pair_t *kv = cursor->sources[cursor->current].kv;
 
-    /* truncate the wal */
-    if (block_manager_truncate(cf->wal->block_manager) == -1)
+    *key = malloc(kv->key_size);
+    if (*key == NULL) return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "key");
+    memcpy(*key, kv->key, kv->key_size);
+
+    *value = malloc(kv->value_size);
+    if (*value == NULL)
     {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        free(*key);
+        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "value");
     }
+    memcpy(*value, kv->value, kv->value_size);
 
-    return 0;
+    *key_size = kv->key_size;
+    *value_size = kv->value_size;
+
+    return NULL;
 }
 
-compress_type _tidesdb_map_compression_algo(tidesdb_compression_algo_t algo)
+void _tidesdb_cursor_free_sources(tidesdb_cursor_t *cursor)
 {
-    switch (algo)
+    if (cursor->sources == NULL) return;
+
+    for (int i = 0; i < cursor->num_sources; i++)
     {
-        case TDB_COMPRESS_SNAPPY:
-            return COMPRESS_SNAPPY;
-        case TDB_COMPRESS_LZ4:
-            return COMPRESS_LZ4;
-        case TDB_COMPRESS_ZSTD:
-            return COMPRESS_ZSTD;
-        default:
-            return COMPRESS_SNAPPY; /* default to snappy */
+        tidesdb_cursor_source_t *source = &cursor->sources[i];
+
+        if (source->sstable != NULL)
+        {
+            if (source->kv != NULL) (void)_tidesdb_free_key_value_pair(source->kv);
+            if (source->block_cursor != NULL)
+                (void)block_manager_cursor_free(source->block_cursor);
+            free(source->offsets);
+            (void)_tidesdb_release_sstable(source->sstable);
+        }
+
+        for (int j = 0; j < source->num_entries; j++)
+            (void)_tidesdb_free_key_value_pair(source->entries[j]);
+        free(source->entries);
     }
+
+    free(cursor->sources);
+    cursor->sources = NULL;
 }
 
-int _tidesdb_flush_memtable_w_bloomfilter_f_hash_table(tidesdb_column_family_t *cf)
+tidesdb_err_t *tidesdb_cursor_free(tidesdb_cursor_t *cursor)
 {
-    /* similar to _tidesdb_flush_memtable but with bloom filter */
+    /* we check if the cursor is NULL */
+    if (cursor == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_CURSOR);
 
-    /* we create a new sstable struct */
-    tidesdb_sstable_t *sst = malloc(sizeof(tidesdb_sstable_t));
-    if (sst == NULL) return -1;
+    /* we free the sources */
+    (void)_tidesdb_cursor_free_sources(cursor);
 
-    /* we create a new sstable with a named based on the amount of sstables */
-    char sstable_path[MAX_FILE_PATH_LENGTH];
-    snprintf(sstable_path, sizeof(sstable_path), "%s%s%s%d%s", cf->path,
-             _tidesdb_get_path_seperator(), TDB_SSTABLE_PREFIX, cf->num_sstables, TDB_SSTABLE_EXT);
+    /* we release the version the cursor pinned */
+    if (cursor->version != NULL) (void)_tidesdb_release_version(cursor->version);
+
+    /* we release the cursor's reference on the column family */
+    (void)_tidesdb_release_column_family(cursor->cf);
+
+    free(cursor);
 
-    /* we create a new block manager */
-    block_manager_t *sstable_block_manager = NULL;
+    cursor = NULL;
+
+    return NULL;
+}
+
+tidesdb_err_t *tidesdb_async_open(tidesdb_t *tdb, int num_threads, tidesdb_async_t **async)
+{
+    /* we check if the db is NULL */
+    if (tdb == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_DB);
 
-    if (block_manager_open(&sstable_block_manager, sstable_path, TDB_SYNC_INTERVAL) == -1)
+    /* we check if the async context is NULL */
+    if (async == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    /* we check the number of worker threads */
+    if (num_threads < 1 || num_threads > TDB_ASYNC_MAX_THREADS)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_MAX_THREADS);
+
+    *async = malloc(sizeof(tidesdb_async_t));
+    if (*async == NULL) return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "async context");
+
+    (*async)->threads = malloc(sizeof(pthread_t) * num_threads);
+    if ((*async)->threads == NULL)
     {
-        return -1;
+        free(*async);
+        *async = NULL;
+        return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "async threads");
     }
 
-    /* we set the block manager */
-    sst->block_manager = sstable_block_manager;
+    (*async)->tdb = tdb;
+    (*async)->num_threads = 0;
+    (*async)->head = NULL;
+    (*async)->tail = NULL;
+    (*async)->queued = 0;
+    (*async)->pending = 0;
+    (*async)->stop = false;
 
-    /* we figure out how large the bloom filter should be by getting amount of nodes in memtable */
-    int bloom_filter_size = (int)((hash_table_t *)cf->memtable)->count;
-
-    /* we initialize the bloom filter */
-    bloom_filter_t *bf = NULL;
-    if (bloom_filter_new(&bf, TDB_BLOOMFILTER_P, bloom_filter_size) == -1)
+    if (pthread_mutex_init(&(*async)->lock, NULL) != 0)
     {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        free((*async)->threads);
+        free(*async);
+        *async = NULL;
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_LOCK, "async context");
     }
 
-    /* we iterate over memtable and populate the bloom filter */
-    hash_table_cursor_t *cursor = hash_table_cursor_new(cf->memtable);
-    if (cursor == NULL)
+    if (pthread_cond_init(&(*async)->not_empty, NULL) != 0 ||
+        pthread_cond_init(&(*async)->not_full, NULL) != 0 ||
+        pthread_cond_init(&(*async)->idle, NULL) != 0)
     {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        (void)pthread_mutex_destroy(&(*async)->lock);
+        free((*async)->threads);
+        free(*async);
+        *async = NULL;
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_INIT_LOCK, "async context");
     }
 
-    do
+    /* we start the workers */
+    for (int i = 0; i < num_threads; i++)
     {
-        uint8_t *retrieved_key;
-        size_t key_size;
-        uint8_t *retrieved_value;
-        size_t value_size;
-        time_t ttl;
-        if (hash_table_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size,
-                                  &ttl) == -1)
+        if (pthread_create(&(*async)->threads[i], NULL, _tidesdb_async_worker, *async) != 0)
         {
-            free(retrieved_key);
-            free(retrieved_value);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
+            /* we stop the workers we already started */
+            (void)_tidesdb_async_stop_workers(*async, i);
+            (void)pthread_cond_destroy(&(*async)->not_empty);
+            (void)pthread_cond_destroy(&(*async)->not_full);
+            (void)pthread_cond_destroy(&(*async)->idle);
+            (void)pthread_mutex_destroy(&(*async)->lock);
+            free((*async)->threads);
+            free(*async);
+            *async = NULL;
+            return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_START_THREAD, "async context");
         }
+    }
 
-        /* add to bloom filter */
-        (void)bloom_filter_add(bf, retrieved_key, key_size);
+    (*async)->num_threads = num_threads;
 
-    } while (hash_table_cursor_next(cursor) != -1);
+    return NULL;
+}
 
-    /* we free the cursor */
-    (void)hash_table_cursor_destroy(cursor);
-    cursor = NULL;
+tidesdb_err_t *tidesdb_async_wait(tidesdb_async_t *async)
+{
+    /* we check if the async context is NULL */
+    if (async == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
 
-    size_t serialized_bf_size;
-    uint8_t *serialized_bf = bloom_filter_serialize(bf, &serialized_bf_size);
-    if (serialized_bf == NULL)
-    {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
-    }
+    if (pthread_mutex_lock(&async->lock) != 0)
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "async context");
 
-    bloom_filter_free(bf);
+    while (async->pending > 0) (void)pthread_cond_wait(&async->idle, &async->lock);
 
-    /* we write the bloom filter to the sstable */
-    block_manager_block_t *bf_block = block_manager_block_create(serialized_bf_size, serialized_bf);
-    if (bf_block == NULL)
-    {
-        free(sst);
-        free(serialized_bf);
-        (void)remove(sstable_path);
-        return -1;
-    }
+    (void)pthread_mutex_unlock(&async->lock);
 
-    free(serialized_bf);
+    return NULL;
+}
 
-    /* we write the block to the sstable */
-    if (block_manager_block_write(sst->block_manager, bf_block) == -1)
-    {
-        (void)block_manager_block_free(bf_block);
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
-    }
+tidesdb_err_t *tidesdb_async_close(tidesdb_async_t *async)
+{
+    /* we check if the async context is NULL */
+    if (async == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
 
-    /* we free the resources */
-    (void)block_manager_block_free(bf_block);
+    /* the workers drain the queue before they exit so every callback is called */
+    (void)_tidesdb_async_stop_workers(async, async->num_threads);
 
-    /* we reinitialize the cursor to populate the sstable with keyvalue pairs after bloomfilter */
-    cursor = hash_table_cursor_new(cf->memtable);
-    if (cursor == NULL)
+    (void)pthread_cond_destroy(&async->not_empty);
+    (void)pthread_cond_destroy(&async->not_full);
+    (void)pthread_cond_destroy(&async->idle);
+
+    if (pthread_mutex_destroy(&async->lock) != 0)
     {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        free(async->threads);
+        free(async);
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_DESTROY_LOCK, "async context");
     }
 
-    /* we iterate over the memtable and write to the sstable */
-    do
-    {
-        /* we get the key value pair */
-        tidesdb_key_value_pair_t *kv = malloc(sizeof(tidesdb_key_value_pair_t));
-        if (kv == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    free(async->threads);
+    free(async);
+    async = NULL;
 
-        /* we get the key */
+    return NULL;
+}
 
-        if (hash_table_cursor_get(cursor, &kv->key, (size_t *)&kv->key_size, &kv->value,
-                                  (size_t *)&kv->value_size, &kv->ttl) == -1)
-        {
-            free(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+tidesdb_err_t *tidesdb_get_async(tidesdb_async_t *async, tidesdb_cf_handle_t *handle,
+                                 const uint8_t *key, size_t key_size,
+                                 tidesdb_async_callback_t callback, void *arg)
+{
+    /* a single get is a batch of one */
+    return tidesdb_multi_get_async(async, handle, &key, &key_size, 1, callback, arg);
+}
 
-        /* we serialize the key value pair */
-        size_t serialized_size;
-        uint8_t *serialized_kv = _tidesdb_serialize_key_value_pair(
-            kv, &serialized_size, cf->config.compressed, cf->config.compress_algo);
-        if (serialized_kv == NULL)
-        {
-            (void)_tidesdb_free_key_value_pair(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+tidesdb_err_t *tidesdb_multi_get_async(tidesdb_async_t *async, tidesdb_cf_handle_t *handle,
+                                       const uint8_t **keys, const size_t *key_sizes,
+                                       int num_keys, tidesdb_async_callback_t callback,
+                                       void *arg)
+{
+    /* we check if the async context is NULL */
+    if (async == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
 
-        free(kv);
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
 
-        /* we create a new block */
-        block_manager_block_t *block = block_manager_block_create(serialized_size, serialized_kv);
-        if (block == NULL)
-        {
-            free(sst);
-            free(serialized_kv);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    /* a get has nowhere to deliver its value without a callback */
+    if (callback == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
 
-        /* we write the block to the sstable */
-        if (block_manager_block_write(sst->block_manager, block) == -1)
-        {
-            (void)block_manager_block_free(block);
-            free(sst);
-            free(serialized_kv);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    /* we check the keys */
+    if (keys == NULL || key_sizes == NULL || num_keys < 1)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_KEY);
 
-        /* we free the resources */
-        (void)block_manager_block_free(block);
-        free(serialized_kv);
+    for (int i = 0; i < num_keys; i++)
+        if (keys[i] == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_KEY);
 
-    } while (hash_table_cursor_next(cursor) != -1);
+    tidesdb_async_job_t *job = _tidesdb_async_job_new(
+        TIDESDB_ASYNC_OP_GET, handle->cf, keys, key_sizes, num_keys, NULL, 0, 0, callback, arg);
+    if (job == NULL) return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "async job");
 
-    /* we free the cursor */
-    (void)hash_table_cursor_destroy(cursor);
+    return _tidesdb_async_submit(async, job);
+}
 
-    cursor = NULL;
+tidesdb_err_t *tidesdb_put_async(tidesdb_async_t *async, tidesdb_cf_handle_t *handle,
+                                 const uint8_t *key, size_t key_size, const uint8_t *value,
+                                 size_t value_size, time_t ttl, tidesdb_async_callback_t callback,
+                                 void *arg)
+{
+    /* we check if the async context is NULL */
+    if (async == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
+
+    /* we check if the handle is NULL */
+    if (handle == NULL || handle->cf == NULL)
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    /* we check if the key is NULL */
+    if (key == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_KEY);
+
+    /* we check if the value is NULL */
+    if (value == NULL) return tidesdb_err_from_code(TIDESDB_ERR_INVALID_VALUE);
 
-    /* we add the sstable to the column family */
-    if (cf->sstables == NULL)
+    tidesdb_async_job_t *job =
+        _tidesdb_async_job_new(TIDESDB_ASYNC_OP_PUT, handle->cf, &key, &key_size, 1, value,
+                               value_size, ttl, callback, arg);
+    if (job == NULL) return tidesdb_err_from_code(TIDESDB_ERR_MEMORY_ALLOC, "async job");
+
+    return _tidesdb_async_submit(async, job);
+}
+
+tidesdb_async_job_t *_tidesdb_async_job_new(TIDESDB_ASYNC_OP_CODE op_code,
+                                            tidesdb_column_family_t *cf, const uint8_t **keys,
+                                            const size_t *key_sizes, int num_keys,
+                                            const uint8_t *value, size_t value_size, time_t ttl,
+                                            tidesdb_async_callback_t callback, void *arg)
+{
+    tidesdb_async_job_t *job = calloc(1, sizeof(tidesdb_async_job_t));
+    if (job == NULL) return NULL;
+
+    job->keys = calloc(num_keys, sizeof(uint8_t *));
+    job->key_sizes = malloc(sizeof(size_t) * num_keys);
+    if (job->keys == NULL || job->key_sizes == NULL)
+    {
+        free(job->keys);
+        free(job->key_sizes);
+        free(job);
+        return NULL;
+    }
+
+    job->num_keys = num_keys;
+
+    for (int i = 0; i < num_keys; i++)
     {
-        cf->sstables = malloc(sizeof(tidesdb_sstable_t));
-        if (cf->sstables == NULL)
+        /* we allocate at least a byte so an empty key still has a buffer */
+        job->keys[i] = malloc(key_sizes[i] > 0 ? key_sizes[i] : 1);
+        if (job->keys[i] == NULL)
         {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
+            (void)_tidesdb_async_job_free(job);
+            return NULL;
         }
+        memcpy(job->keys[i], keys[i], key_sizes[i]);
+        job->key_sizes[i] = key_sizes[i];
     }
-    else
+
+    if (value != NULL)
     {
-        tidesdb_sstable_t **temp_sstables =
-            realloc(cf->sstables, sizeof(tidesdb_sstable_t) * (cf->num_sstables + 1));
-        if (temp_sstables == NULL)
+        job->value = malloc(value_size > 0 ? value_size : 1);
+        if (job->value == NULL)
         {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
+            (void)_tidesdb_async_job_free(job);
+            return NULL;
         }
-
-        cf->sstables = temp_sstables;
+        memcpy(job->value, value, value_size);
+        job->value_size = value_size;
     }
 
-    /* we increment the number of sstables
-     * and set the sstable
-     */
-    cf->sstables[cf->num_sstables] = sst;
-    cf->num_sstables++;
-
-    /* clear memtable */
-    (void)hash_table_clear(cf->memtable);
+    job->op_code = op_code;
+    job->ttl = ttl;
+    job->callback = callback;
+    job->arg = arg;
+    job->next = NULL;
 
-    /* truncate the wal */
-    if (block_manager_truncate(cf->wal->block_manager) == -1)
-    {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
-    }
+    /* the job keeps the column family alive even if the handle is released before it runs */
+    (void)_tidesdb_ref_column_family(cf);
+    job->cf = cf;
 
-    return 0;
+    return job;
 }
 
-int _tidesdb_flush_memtable_f_hash_table(tidesdb_column_family_t *cf)
+void _tidesdb_async_job_free(tidesdb_async_job_t *job)
 {
-    /* we create a new sstable struct */
-    tidesdb_sstable_t *sst = malloc(sizeof(tidesdb_sstable_t));
-    if (sst == NULL) return -1;
+    if (job == NULL) return;
 
-    /* we create a new sstable with a named based on the amount of sstables */
-    char sstable_path[MAX_FILE_PATH_LENGTH];
-    snprintf(sstable_path, sizeof(sstable_path), "%s%s%s%d%s", cf->path,
-             _tidesdb_get_path_seperator(), TDB_SSTABLE_PREFIX, cf->num_sstables, TDB_SSTABLE_EXT);
+    for (int i = 0; i < job->num_keys; i++) free(job->keys[i]);
+    free(job->keys);
+    free(job->key_sizes);
+    free(job->value);
 
-    /* we create a new block manager */
-    block_manager_t *sstable_block_manager = NULL;
+    if (job->cf != NULL) (void)_tidesdb_release_column_family(job->cf);
 
-    if (block_manager_open(&sstable_block_manager, sstable_path, TDB_SYNC_INTERVAL) == -1)
+    free(job);
+}
+
+tidesdb_err_t *_tidesdb_async_submit(tidesdb_async_t *async, tidesdb_async_job_t *job)
+{
+    if (pthread_mutex_lock(&async->lock) != 0)
     {
-        return -1;
+        (void)_tidesdb_async_job_free(job);
+        return tidesdb_err_from_code(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK, "async context");
     }
 
-    /* we set the block manager */
-    sst->block_manager = sstable_block_manager;
+    /* we apply backpressure, a submitter waits for a worker to make room */
+    while (async->queued >= TDB_ASYNC_QUEUE_DEPTH && !async->stop)
+        (void)pthread_cond_wait(&async->not_full, &async->lock);
 
-    /* we create a new hash table cursor and populate the memtable
-     * with serialized key value pairs */
-
-    hash_table_cursor_t *cursor = hash_table_cursor_new(cf->memtable);
-    if (cursor == NULL)
+    if (async->stop)
     {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        (void)pthread_mutex_unlock(&async->lock);
+        (void)_tidesdb_async_job_free(job);
+        return tidesdb_err_from_code(TIDESDB_ERR_INVALID_ARGUMENT);
     }
 
-    /* we iterate over the memtable and write to the sstable */
-    do
-    {
-        /* we get the key value pair */
-        tidesdb_key_value_pair_t *kv = malloc(sizeof(tidesdb_key_value_pair_t));
-        if (kv == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    if (async->tail == NULL)
+        async->head = job;
+    else
+        async->tail->next = job;
+    async->tail = job;
 
-        /* we get the key */
+    async->queued++;
+    async->pending++;
 
-        uint8_t *retrieved_key;
-        size_t key_size;
-        uint8_t *retrieved_value;
-        size_t value_size;
-        time_t ttl;
-        if (hash_table_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size,
-                                  &ttl) == -1)
-        {
-            free(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+    (void)pthread_cond_signal(&async->not_empty);
+    (void)pthread_mutex_unlock(&async->lock);
 
-        /* we copy the key */
-        kv->key = malloc(key_size);
-        if (kv->key == NULL)
-        {
-            free(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
-        memcpy(kv->key, retrieved_key, key_size);
+    return NULL;
+}
+
+void _tidesdb_async_run_job(tidesdb_async_job_t *job)
+{
+    if (job->op_code == TIDESDB_ASYNC_OP_PUT)
+    {
+        int status = _tidesdb_put(job->cf, job->keys[0], job->key_sizes[0], job->value,
+                                  job->value_size, job->ttl);
+        if (job->callback != NULL)
+            job->callback(status, job->keys[0], job->key_sizes[0], NULL, 0, job->arg);
+        return;
+    }
+
+    for (int i = 0; i < job->num_keys; i++)
+    {
+        uint8_t *value = NULL;
+        size_t value_size = 0;
 
-        /* we copy the value */
-        kv->value = malloc(value_size);
-        if (kv->value == NULL)
+        int status = _tidesdb_get(job->cf, job->keys[i], job->key_sizes[i], &value, &value_size);
+        if (status != TIDESDB_SUCCESS)
         {
-            free(kv->key);
-            free(kv);
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
+            value = NULL;
+            value_size = 0;
         }
 
-        memcpy(kv->value, retrieved_value, value_size);
+        /* the callback owns the value from here */
+        job->callback(status, job->keys[i], job->key_sizes[i], value, value_size, job->arg);
+    }
+}
 
-        /* we set the key size */
-        kv->key_size = key_size;
-        /* we set the value size */
-        kv->value_size = value_size;
-        /* we set the ttl */
-        kv->ttl = ttl;
+void *_tidesdb_async_worker(void *arg)
+{
+    tidesdb_async_t *async = arg;
 
-        /* we serialize the key value pair */
-        size_t serialized_size;
-        uint8_t *serialized_kv = _tidesdb_serialize_key_value_pair(
-            kv, &serialized_size, cf->config.compressed, cf->config.compress_algo);
-        if (serialized_kv == NULL)
-        {
-            (void)_tidesdb_free_key_value_pair(kv);
-            free(sst);
-            remove(sstable_path);
-            return -1;
-        }
+    (void)pthread_mutex_lock(&async->lock);
 
-        (void)_tidesdb_free_key_value_pair(kv);
+    while (true)
+    {
+        while (async->head == NULL && !async->stop)
+            (void)pthread_cond_wait(&async->not_empty, &async->lock);
 
-        /* we create a new block */
-        block_manager_block_t *block = block_manager_block_create(serialized_size, serialized_kv);
-        if (block == NULL)
-        {
-            free(sst);
-            free(serialized_kv);
-            (void)remove(sstable_path);
-            return -1;
-        }
+        /* we only exit once the queue is drained */
+        if (async->head == NULL) break;
 
-        /* we write the block to the sstable */
-        if (block_manager_block_write(sst->block_manager, block) == -1)
-        {
-            (void)block_manager_block_free(block);
-            free(sst);
-            free(serialized_kv);
-            (void)remove(sstable_path);
-            return -1;
-        }
+        tidesdb_async_job_t *job = async->head;
+        async->head = job->next;
+        if (async->head == NULL) async->tail = NULL;
 
-        /* we free the resources */
-        (void)block_manager_block_free(block);
-        free(serialized_kv);
+        async->queued--;
+        (void)pthread_cond_signal(&async->not_full);
 
-    } while (hash_table_cursor_next(cursor) != -1);
+        /* we run the job without the queue lock so workers run jobs in parallel */
+        (void)pthread_mutex_unlock(&async->lock);
 
-    /* we free the cursor */
-    (void)hash_table_cursor_destroy(cursor);
+        (void)_tidesdb_async_run_job(job);
+        (void)_tidesdb_async_job_free(job);
 
-    /* we add the sstable to the column family */
-    if (cf->sstables == NULL)
-    {
-        cf->sstables = malloc(sizeof(tidesdb_sstable_t));
-        if (cf->sstables == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
-    }
-    else
-    {
-        tidesdb_sstable_t **temp_sstables =
-            realloc(cf->sstables, sizeof(tidesdb_sstable_t) * (cf->num_sstables + 1));
-        if (temp_sstables == NULL)
-        {
-            free(sst);
-            (void)remove(sstable_path);
-            return -1;
-        }
+        (void)pthread_mutex_lock(&async->lock);
 
-        cf->sstables = temp_sstables;
+        async->pending--;
+        if (async->pending == 0) (void)pthread_cond_broadcast(&async->idle);
     }
 
-    /* we increment the number of sstables
-     * and set the sstable
-     */
-    cf->sstables[cf->num_sstables] = sst;
-    cf->num_sstables++;
+    (void)pthread_mutex_unlock(&async->lock);
+
+    return NULL;
+}
+
+void _tidesdb_async_stop_workers(tidesdb_async_t *async, int num_threads)
+{
+    (void)pthread_mutex_lock(&async->lock);
+    async->stop = true;
+    (void)pthread_cond_broadcast(&async->not_empty);
+    (void)pthread_cond_broadcast(&async->not_full);
+    (void)pthread_mutex_unlock(&async->lock);
 
-    /* clear memtable */
-    (void)hash_table_clear(cf->memtable);
+    for (int i = 0; i < num_threads; i++) (void)pthread_join(async->threads[i], NULL);
+}
 
-    /* truncate the wal */
-    if (block_manager_truncate(cf->wal->block_manager) == -1)
+int _tidesdb_is_expired(int64_t ttl)
+{
+    if (ttl != -1 && ttl < time(NULL))
     {
-        free(sst);
-        (void)remove(sstable_path);
-        return -1;
+        return 1; /* key is expired */
     }
 
-    return 0;
-}
\ No newline at end of file
+    return 0; /* key either has no ttl or has not expired */
+}
+
+compress_type _tidesdb_map_compression_algo(tidesdb_compression_algo_t algo)
+{
+    switch (algo)
+    {
+        case TDB_COMPRESS_SNAPPY:
+            return COMPRESS_SNAPPY;
+        case TDB_COMPRESS_LZ4:
+            return COMPRESS_LZ4;
+        case TDB_COMPRESS_ZSTD:
+            return COMPRESS_ZSTD;
+        default:
+            return COMPRESS_SNAPPY; /* default to snappy */
+    }
+}
@@ -20,8 +20,11 @@
 #define __TIDESDB_H__
 
 #include <dirent.h>
+#include <float.h>
+#include <inttypes.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <sys/stat.h>
 
@@ -29,8 +32,13 @@
 #include "bloom_filter.h"
 #include "compress.h"
 #include "err.h"
+#include "fuse_filter.h"
 #include "hash_table.h"
+#include "histogram.h"
+#include "rate_limiter.h"
+#include "row_cache.h"
 #include "skip_list.h"
+#include "thread_pool.h"
 
 /* TidesDB uses tidesdb, _tidesdb_, and TDB as prefixes for functions, types, and constants */
 
@@ -41,9 +49,29 @@
 #define TDB_SYNC_INTERVAL                 0.24       /* interval for syncing mainly WAL */
 #define TDB_BLOOMFILTER_P                 0.01       /*  the false positive rate for bloom filter */
 #define TDB_SSTABLE_PREFIX                "sstable_" /* prefix for SSTable files */
+#define TDB_MANIFEST_FILE                 "MANIFEST" /* lists the live SSTables of column family */
+#define TDB_TEMP_EXT                      ".tmp"     /* extension for files written before rename */
 #define TDB_FLUSH_THRESHOLD               1048576    /* default flush threshold for column family */
 #define TDB_MIN_MAX_LEVEL                 5          /* minimum max level for column family */
 #define TDB_MIN_PROBABILITY               0.1        /* minimum probability for column family */
+#define TDB_MAX_MEMTABLE_SHARDS           64         /* maximum memtable shards for column family */
+#define TDB_MEMTABLE_SHARD_SEED           0x5eed     /* hash seed used to pick a memtable shard */
+#define TDB_ASYNC_MAX_THREADS             64         /* maximum worker threads for async contexts */
+#define TDB_ASYNC_QUEUE_DEPTH             1024       /* queued async jobs before submit blocks */
+#define TDB_STALL_DELAY_US                1000       /* write delay per sstable past soft limit */
+#define TDB_STALL_MAX_DELAY_US            100000     /* maximum write delay past the soft limit */
+#define TDB_STALL_WAIT_US                 100000     /* recheck interval of stopped writes */
+#define TDB_DEFAULT_STALL_TIMEOUT_MS      10000      /* stopped write wait if not configured */
+#define TDB_DEFAULT_BACKGROUND_THREADS    2          /* background pool threads if not configured */
+#define TDB_STATS_SHARDS                  8          /* statistics shards per column family */
+#define TDB_SSTABLE_PARTITION_ENTRIES     256        /* key value blocks per sstable partition */
+#define TDB_SSTABLE_FOOTER_MAGIC 0x7464627061727469 /* ends the footer of a partitioned sstable */
+#define TDB_HASH_INDEX_SEED               0x4a5b     /* hash seed of the partition hash indexes */
+#define TDB_HASH_INDEX_UTIL               0.75       /* most slots a partition hash index fills */
+#define TDB_HASH_INDEX_EMPTY              UINT32_MAX /* hash index slot without a key */
+#define TDB_HASH_INDEX_COLLISION (UINT32_MAX - 1) /* a hash index lookup with several candidates */
+#define TDB_LEARNED_INDEX_ERROR           1          /* blocks a learned index may be off by */
+#define TDB_LEARNED_INDEX_SEGMENT_ENTRIES 16         /* most key value blocks per model segment */
 
 /*
  * tidesdb_compression_algo_t
@@ -58,28 +86,600 @@ typedef enum
     TDB_COMPRESS_ZSTD
 } tidesdb_compression_algo_t;
 
+/*
+ * tidesdb_sstable_segment_t
+ * struct for a segment of the learned index of an SSTable partition, a line from the keys of a
+ * run of key value blocks to their position in the run
+ * @param first the first key of the segment read as an integer
+ * @param offset the offset of the first key value block of the segment from the start of the
+ * partition
+ * @param entry the position of the first key value block of the segment in the partition
+ * @param slope the key value blocks per integer key
+ */
+typedef struct
+{
+    uint64_t first;
+    uint32_t offset;
+    uint16_t entry;
+    double slope;
+} tidesdb_sstable_segment_t;
+
+/*
+ * tidesdb_sstable_partition_t
+ * struct for a partition of a partitioned SSTable, a run of up to TDB_SSTABLE_PARTITION_ENTRIES
+ * key value blocks with a filter of its own
+ * @param data_offset the offset of the first key value block of the partition
+ * @param filter_offset the offset of the filter block of the partition, UINT64_MAX without one
+ * @param hash_offset the offset of the hash index block of the partition, UINT64_MAX without one
+ * @param entries the key value blocks in the partition
+ * @param last_key the largest key in the partition
+ * @param last_key_size the size of the largest key
+ * @param prefix_size the bytes every key of the partition starts with, the learned index reads
+ * the 8 bytes after them as a big endian integer
+ * @param num_segments the number of segments of the learned index
+ * @param segments the learned index of the partition, NULL without one
+ */
+typedef struct
+{
+    uint64_t data_offset;
+    uint64_t filter_offset;
+    uint64_t hash_offset;
+    uint32_t entries;
+    uint8_t *last_key;
+    size_t last_key_size;
+    uint8_t prefix_size;
+    uint16_t num_segments;
+    tidesdb_sstable_segment_t *segments;
+} tidesdb_sstable_partition_t;
+
+/*
+ * tidesdb_sstable_index_t
+ * struct for the top level index of a partitioned SSTable, it stays in memory while the SSTable is
+ * open and gets read a single partition and its filter on demand
+ * @param partitions the partitions in key order
+ * @param num_partitions the number of partitions
+ * @param data_end the offset the key value blocks end at, the partition filters follow them
+ * @param filter_bits the bits of all the partition filters together
+ * @param filter_bits_set the bits set in all the partition bloom filters
+ * @param filter_hashes the hash functions of the partition filters
+ * @param size the memory the index holds in bytes
+ */
+typedef struct
+{
+    tidesdb_sstable_partition_t *partitions;
+    uint32_t num_partitions;
+    uint64_t data_end;
+    uint64_t filter_bits;
+    uint64_t filter_bits_set;
+    uint32_t filter_hashes;
+    size_t size;
+} tidesdb_sstable_index_t;
+
+/*
+ * tidesdb_partition_builder_t
+ * struct for the state of a partitioned SSTable while it is written, the partition filters are
+ * held in memory and written after the key value blocks
+ * @param index the top level index built so far
+ * @param capacity the capacity of the partitions array of the index
+ * @param offset the offset the next block is written at
+ * @param start the offset of the first key value block of the open partition
+ * @param keys the keys of the open partition, they point into the skip list being written
+ * @param key_sizes the sizes of the keys of the open partition
+ * @param offsets the offsets of the key value blocks of the open partition
+ * @param num_keys the number of keys in the open partition
+ * @param filters the serialized filters of the closed partitions
+ * @param filter_sizes the sizes of the serialized filters
+ * @param hash_indexes the serialized hash indexes of the closed partitions
+ * @param hash_index_sizes the sizes of the serialized hash indexes
+ */
+typedef struct
+{
+    tidesdb_sstable_index_t *index;
+    uint32_t capacity;
+    uint64_t offset;
+    uint64_t start;
+    const uint8_t *keys[TDB_SSTABLE_PARTITION_ENTRIES];
+    size_t key_sizes[TDB_SSTABLE_PARTITION_ENTRIES];
+    uint64_t offsets[TDB_SSTABLE_PARTITION_ENTRIES];
+    uint32_t num_keys;
+    uint8_t **filters;
+    size_t *filter_sizes;
+    uint8_t **hash_indexes;
+    size_t *hash_index_sizes;
+} tidesdb_partition_builder_t;
+
+typedef struct tidesdb_column_family_t tidesdb_column_family_t;
+
 /*
  * tidesdb_sstable_t
  * struct for a TidesDB SSTable
  * @param block_manager the block manager for the SSTable
+ * @param id the id of the SSTable, the file is named TDB_SSTABLE_PREFIX<id>TDB_SSTABLE_EXT
+ * @param refcount references held on the SSTable by versions and the thread that wrote it
+ * @param obsolete set once the SSTable is compacted away, the file is removed on the last release
+ * @param bloom_bits the size of the bloom filter in bits, 0 until it is written or first read
+ * @param bloom_bits_set the bits set in the bloom filter
+ * @param bloom_hashes the hash functions of the bloom filter
+ * @param bloom_checks the gets that checked the bloom filter
+ * @param bloom_negatives the checks that ruled the SSTable out
+ * @param bloom_false_positives the checks that passed without the key being in the SSTable
+ * @param index the top level index of a partitioned SSTable, loaded on first use
+ * @param cf the column family the SSTable belongs to, it outlives the SSTable as every reference
+ * is held on behalf of a reference on the column family
  */
 typedef struct
 {
     block_manager_t *block_manager;
+    uint64_t id;
+    atomic_int refcount;
+    atomic_bool obsolete;
+    atomic_int bloom_bits;
+    atomic_int bloom_bits_set;
+    atomic_int bloom_hashes;
+    _Atomic uint64_t bloom_checks;
+    _Atomic uint64_t bloom_negatives;
+    _Atomic uint64_t bloom_false_positives;
+    _Atomic(tidesdb_sstable_index_t *) index;
+    tidesdb_column_family_t *cf;
 } tidesdb_sstable_t;
 
+/*
+ * tidesdb_version_t
+ * struct for an immutable set of SSTables of a column family
+ * readers pin the current version and read its SSTables without holding the column family lock,
+ * flushes and compactions install a new version in its place
+ * @param sstables the SSTables in the version, oldest first
+ * @param num_sstables the number of SSTables in the version
+ * @param refcount references held on the version, the version is freed when this reaches 0
+ */
+typedef struct
+{
+    tidesdb_sstable_t **sstables;
+    int num_sstables;
+    atomic_int refcount;
+} tidesdb_version_t;
+
+/*
+ * TIDESDB_STAT
+ * statistics counter enum
+ * the counters a column family keeps, see tidesdb_stats_t for what each one counts.  the memory
+ * counters are gauges, they are added to on allocation and subtracted from on free
+ */
+typedef enum
+{
+    TDB_STAT_GETS,
+    TDB_STAT_PUTS,
+    TDB_STAT_DELETES,
+    TDB_STAT_COMMITS,
+    TDB_STAT_MEMTABLE_HITS,
+    TDB_STAT_ROW_CACHE_HITS,
+    TDB_STAT_ROW_CACHE_MISSES,
+    TDB_STAT_BLOOM_CHECKS,
+    TDB_STAT_BLOOM_NEGATIVES,
+    TDB_STAT_BLOOM_FALSE_POSITIVES,
+    TDB_STAT_SSTABLES_PROBED,
+    TDB_STAT_BLOCK_READS,
+    TDB_STAT_BYTES_READ,
+    TDB_STAT_BYTES_WRITTEN,
+    TDB_STAT_WAL_BYTES,
+    TDB_STAT_FLUSHES,
+    TDB_STAT_FLUSH_BYTES,
+    TDB_STAT_FLUSH_US,
+    TDB_STAT_COMPACTIONS,
+    TDB_STAT_COMPACTION_BYTES,
+    TDB_STAT_COMPACTION_US,
+    TDB_STAT_BUDGET_FLUSHES,
+    TDB_STAT_MEM_BLOOM_FILTERS,
+    TDB_STAT_MEM_MERGE_TABLES,
+    TDB_STAT_MEM_TXN_BUFFERS,
+    TDB_STATS /* the number of counters */
+} TIDESDB_STAT;
+
+/*
+ * TIDESDB_LATENCY
+ * latency histogram enum
+ */
+typedef enum
+{
+    TDB_LATENCY_GET,
+    TDB_LATENCY_PUT,
+    TDB_LATENCY_COMMIT,
+    TDB_LATENCIES /* the number of histograms */
+} TIDESDB_LATENCY;
+
+/*
+ * tidesdb_stats_shard_t
+ * struct for a shard of the statistics of a column family
+ * each thread records into one shard so threads on different cores don't bounce the same cache
+ * lines, reading the statistics sums the shards
+ * @param counters the counters
+ * @param latencies the latency histograms in nanoseconds
+ */
+typedef struct
+{
+    _Alignas(64) _Atomic uint64_t counters[TDB_STATS];
+    histogram_t latencies[TDB_LATENCIES];
+} tidesdb_stats_shard_t;
+
+/*
+ * tidesdb_stats_t
+ * struct for the statistics of a column family, counted since it was opened
+ * @param gets the gets
+ * @param puts the puts
+ * @param deletes the deletes
+ * @param commits the committed transactions
+ * @param memtable_hits the gets answered by the memtable
+ * @param row_cache_hits the gets answered by the row cache
+ * @param row_cache_misses the gets the row cache could not answer, 0 without a row cache
+ * @param bloom_checks the sstable bloom filters checked by gets
+ * @param bloom_negatives the checks that ruled an sstable out
+ * @param bloom_false_positives the checks that passed for an sstable without the key
+ * @param sstables_probed the sstables gets looked in, divide by gets for sstables per get
+ * @param block_reads the sstable blocks read by gets
+ * @param bytes_read the sstable bytes read by gets
+ * @param bytes_written the sstable bytes written by flushes and compactions
+ * @param wal_bytes the bytes appended to the write-ahead logs
+ * @param flushes the memtable flushes
+ * @param flush_bytes the sstable bytes written by flushes
+ * @param flush_us the time spent flushing in microseconds
+ * @param compactions the pair merges
+ * @param compaction_bytes the sstable bytes written by pair merges
+ * @param compaction_us the time spent in pair merges in microseconds
+ * @param budget_flushes the flushes started early because the write buffer budget was exceeded
+ * @param memtable_bytes the memory held by the memtables now
+ * @param bloom_filter_bytes the memory held by bloom filters being built or checked now
+ * @param merge_table_bytes the memory held by the skip lists flushes and compactions merge into now
+ * @param txn_buffer_bytes the memory held by the operations of open transactions now
+ * @param get_latency the latency of gets in nanoseconds
+ * @param put_latency the latency of puts and deletes in nanoseconds
+ * @param commit_latency the latency of transaction commits in nanoseconds
+ */
+typedef struct
+{
+    uint64_t gets;
+    uint64_t puts;
+    uint64_t deletes;
+    uint64_t commits;
+    uint64_t memtable_hits;
+    uint64_t row_cache_hits;
+    uint64_t row_cache_misses;
+    uint64_t bloom_checks;
+    uint64_t bloom_negatives;
+    uint64_t bloom_false_positives;
+    uint64_t sstables_probed;
+    uint64_t block_reads;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t wal_bytes;
+    uint64_t flushes;
+    uint64_t flush_bytes;
+    uint64_t flush_us;
+    uint64_t compactions;
+    uint64_t compaction_bytes;
+    uint64_t compaction_us;
+    uint64_t budget_flushes;
+    uint64_t memtable_bytes;
+    uint64_t bloom_filter_bytes;
+    uint64_t merge_table_bytes;
+    uint64_t txn_buffer_bytes;
+    histogram_summary_t get_latency;
+    histogram_summary_t put_latency;
+    histogram_summary_t commit_latency;
+} tidesdb_stats_t;
+
+/*
+ * tidesdb_filter_type_t
+ * the filter written as the first block of the sstables of a column family with filters enabled
+ */
+typedef enum
+{
+    TDB_FILTER_BLOOM,      /* a bloom filter with a 1% false positive rate */
+    TDB_FILTER_BINARY_FUSE /* a binary fuse filter, about 9 bits per key for 1/256 and 3 probes */
+} tidesdb_filter_type_t;
+
+/*
+ * tidesdb_sstable_stats_t
+ * struct for the statistics of an SSTable of a column family, the bloom filter counters are counted
+ * since the SSTable was opened.  they cover binary fuse filters too, see filter_type
+ * @param id the id of the SSTable
+ * @param size the size of the SSTable file in bytes
+ * @param filter_type the kind of filter of the SSTable
+ * @param bloom_bits the size of the filter in bits, 0 if it has none or no get read it yet
+ * @param bloom_bits_set the bits set in a bloom filter, 0 for a binary fuse filter
+ * @param bloom_hashes the hash functions of a bloom filter, the 3 probes of a binary fuse filter
+ * @param bloom_fill_ratio the fraction of the bits set, 0 for a binary fuse filter
+ * @param bloom_estimated_fpr the false positive rate the fill ratio gives, fill ratio ^ hashes, for
+ * a binary fuse filter the 1/256 of its 8 bit fingerprints
+ * @param bloom_checks the gets that checked the bloom filter
+ * @param bloom_negatives the checks that ruled the SSTable out, the useful ones
+ * @param bloom_false_positives the checks that passed without the key being in the SSTable
+ * @param index_partitions the partitions of a partitioned SSTable, 0 if it is not partitioned
+ * @param index_bytes the memory the top level index of a partitioned SSTable holds
+ */
+typedef struct
+{
+    uint64_t id;
+    uint64_t size;
+    tidesdb_filter_type_t filter_type;
+    int bloom_bits;
+    int bloom_bits_set;
+    int bloom_hashes;
+    double bloom_fill_ratio;
+    double bloom_estimated_fpr;
+    uint64_t bloom_checks;
+    uint64_t bloom_negatives;
+    uint64_t bloom_false_positives;
+    int index_partitions;
+    uint64_t index_bytes;
+} tidesdb_sstable_stats_t;
+
+/*
+ * TIDESDB_PERF_TIMER
+ * perf context timer enum
+ * the timers the perf context of a thread keeps, see tidesdb_perf_context_t for what each one times
+ */
+typedef enum
+{
+    TDB_PERF_DB_LOCK_WAIT,
+    TDB_PERF_CF_LOCK_WAIT,
+    TDB_PERF_SHARD_LOCK_WAIT,
+    TDB_PERF_WAL_APPEND,
+    TDB_PERF_MEMTABLE_SEARCH,
+    TDB_PERF_BLOOM_CHECK,
+    TDB_PERF_BLOCK_READ,
+    TDB_PERF_DECOMPRESS,
+    TDB_PERF_DESERIALIZE,
+    TDB_PERF_TIMERS /* the number of timers */
+} TIDESDB_PERF_TIMER;
+
+/*
+ * tidesdb_perf_state_t
+ * struct for the perf context of a thread
+ * @param enabled whether the thread times its operations
+ * @param ns the time spent in each timer in nanoseconds
+ * @param counts the times each timer was started
+ */
+typedef struct
+{
+    bool enabled;
+    uint64_t ns[TDB_PERF_TIMERS];
+    uint64_t counts[TDB_PERF_TIMERS];
+} tidesdb_perf_state_t;
+
+/*
+ * tidesdb_perf_context_t
+ * struct for where the operations of the calling thread spent their time, accumulated since the
+ * perf context was last reset
+ * @param db_lock_wait_ns the time spent waiting on the database lock
+ * @param cf_lock_wait_ns the time spent waiting on column family locks
+ * @param shard_lock_wait_ns the time spent waiting on memtable shard locks
+ * @param wal_append_ns the time spent appending to write-ahead logs
+ * @param memtable_search_ns the time spent searching memtables
+ * @param bloom_check_ns the time spent reading and checking sstable bloom filters
+ * @param block_read_ns the time spent reading sstable blocks
+ * @param decompress_ns the time spent decompressing
+ * @param deserialize_ns the time spent deserializing key value pairs
+ * @param bloom_checks the bloom filters checked
+ * @param block_reads the sstable blocks read
+ */
+typedef struct
+{
+    uint64_t db_lock_wait_ns;
+    uint64_t cf_lock_wait_ns;
+    uint64_t shard_lock_wait_ns;
+    uint64_t wal_append_ns;
+    uint64_t memtable_search_ns;
+    uint64_t bloom_check_ns;
+    uint64_t block_read_ns;
+    uint64_t decompress_ns;
+    uint64_t deserialize_ns;
+    uint64_t bloom_checks;
+    uint64_t block_reads;
+} tidesdb_perf_context_t;
+
+/*
+ * TIDESDB_TRACE_EVENT
+ * trace span enum
+ */
+typedef enum
+{
+    TDB_TRACE_FLUSH,
+    TDB_TRACE_COMPACTION,
+    TDB_TRACE_WAL_SYNC
+} TIDESDB_TRACE_EVENT;
+
+/*
+ * tidesdb_trace_fn_t
+ * the tracing callback, called when a span begins and again when it ends.  it runs on the thread
+ * doing the work, flushes call it holding the column family lock, so it should return quickly and
+ * must not call back into TidesDB
+ * @param event the span
+ * @param begin true when the span begins, false when it ends
+ * @param column_family the name of the column family
+ * @param arg the trace argument from the configuration
+ */
+typedef void (*tidesdb_trace_fn_t)(TIDESDB_TRACE_EVENT event, bool begin,
+                                   const char *column_family, void *arg);
+
+/*
+ * TIDESDB_STALL_CONDITION
+ * write stall condition enum
+ */
+typedef enum
+{
+    TDB_STALL_NORMAL,  /* writes go through */
+    TDB_STALL_DELAYED, /* writes are delayed past stall_soft_sstables */
+    TDB_STALL_STOPPED  /* writes wait at stall_hard_sstables */
+} TIDESDB_STALL_CONDITION;
+
+/*
+ * TIDESDB_BACKGROUND_OP
+ * the operation a background error comes from
+ */
+typedef enum
+{
+    TDB_BACKGROUND_FLUSH,
+    TDB_BACKGROUND_COMPACTION
+} TIDESDB_BACKGROUND_OP;
+
+/*
+ * tidesdb_flush_info_t
+ * struct describing a memtable flush to an event listener
+ * @param column_family the name of the column family
+ * @param memtable_bytes the size of the memtable being flushed
+ * @param sstable_id the id of the sstable written, 0 when the flush begins or if it failed
+ * @param bytes_written the size of the sstable written
+ * @param elapsed_us the time the flush took in microseconds, 0 when it begins
+ * @param status 0 if the flush succeeded or is beginning, -1 if it failed
+ */
+typedef struct
+{
+    const char *column_family;
+    uint64_t memtable_bytes;
+    uint64_t sstable_id;
+    uint64_t bytes_written;
+    uint64_t elapsed_us;
+    int status;
+} tidesdb_flush_info_t;
+
+/*
+ * tidesdb_compaction_info_t
+ * struct describing a compaction to an event listener
+ * @param column_family the name of the column family
+ * @param input_ids the ids of the sstables the compaction merges
+ * @param num_inputs the number of input sstables
+ * @param output_ids the ids of the sstables written, none when the compaction begins
+ * @param num_outputs the number of output sstables
+ * @param bytes_in the size of the input sstables
+ * @param bytes_out the size of the output sstables
+ * @param dropped_tombstones the tombstones left out of the outputs
+ * @param expired_keys the expired keys left out of the outputs
+ * @param elapsed_us the time the compaction took in microseconds, 0 when it begins
+ * @param status 0 if every pair was merged and installed or the compaction is beginning, -1 if
+ * not, pairs that failed keep their inputs
+ */
+typedef struct
+{
+    const char *column_family;
+    const uint64_t *input_ids;
+    int num_inputs;
+    const uint64_t *output_ids;
+    int num_outputs;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t dropped_tombstones;
+    uint64_t expired_keys;
+    uint64_t elapsed_us;
+    int status;
+} tidesdb_compaction_info_t;
+
+/*
+ * tidesdb_write_stall_info_t
+ * struct describing a change of the write stall condition of a column family
+ * @param column_family the name of the column family
+ * @param prev the condition before
+ * @param cur the condition now
+ * @param num_sstables the sstables in the column family now
+ */
+typedef struct
+{
+    const char *column_family;
+    TIDESDB_STALL_CONDITION prev;
+    TIDESDB_STALL_CONDITION cur;
+    int num_sstables;
+} tidesdb_write_stall_info_t;
+
+/*
+ * tidesdb_background_error_info_t
+ * struct describing a failed flush or compaction
+ * @param column_family the name of the column family
+ * @param op the operation that failed
+ * @param code the error code
+ */
+typedef struct
+{
+    const char *column_family;
+    TIDESDB_BACKGROUND_OP op;
+    TIDESDB_ERR_CODE code;
+} tidesdb_background_error_info_t;
+
+/*
+ * tidesdb_event_listener_t
+ * struct for the callbacks an application registers to follow flushes, compactions and write
+ * stalls, any of them can be NULL.  the info passed is only valid during the call.  callbacks run
+ * on the thread doing the work once it released the column family locks, so they may read and
+ * write the column family
+ * @param on_flush_begin called for a flush before on_flush_completed, a flush runs under the
+ * column family write lock so both are called once it is done
+ * @param on_flush_completed called after a flush, successful or not
+ * @param on_compaction_begin called before a compaction merges its pairs, the compaction is under
+ * way so it must not compact or drop the column family
+ * @param on_compaction_completed called after a compaction, successful or not
+ * @param on_write_stall_change called when the write stall condition of a column family changes
+ * @param on_background_error called when a flush or compaction fails
+ * @param arg the argument passed to every callback
+ */
+typedef struct
+{
+    void (*on_flush_begin)(const tidesdb_flush_info_t *info, void *arg);
+    void (*on_flush_completed)(const tidesdb_flush_info_t *info, void *arg);
+    void (*on_compaction_begin)(const tidesdb_compaction_info_t *info, void *arg);
+    void (*on_compaction_completed)(const tidesdb_compaction_info_t *info, void *arg);
+    void (*on_write_stall_change)(const tidesdb_write_stall_info_t *info, void *arg);
+    void (*on_background_error)(const tidesdb_background_error_info_t *info, void *arg);
+    void *arg;
+} tidesdb_event_listener_t;
+
+/*
+ * tidesdb_dropped_t
+ * struct for what a merge left out of its output
+ * @param tombstones the tombstones dropped
+ * @param expired the expired keys dropped
+ */
+typedef struct
+{
+    uint64_t tombstones;
+    uint64_t expired;
+} tidesdb_dropped_t;
+
+/*
+ * tidesdb_memory_usage_t
+ * struct for the memory held by a TidesDB instance, summed over its column families
+ * @param memtable_bytes the memory held by the memtables
+ * @param bloom_filter_bytes the memory held by bloom filters being built or checked
+ * @param merge_table_bytes the memory held by the skip lists flushes and compactions merge into
+ * @param txn_buffer_bytes the memory held by the operations of open transactions
+ * @param row_cache_bytes the memory held by the rows of the row cache
+ * @param total_bytes the sum of the above
+ * @param write_buffer_budget the memtable budget from the configuration, 0 for none
+ * @param row_cache_capacity the row cache size from the configuration, 0 for none
+ */
+typedef struct
+{
+    uint64_t memtable_bytes;
+    uint64_t bloom_filter_bytes;
+    uint64_t merge_table_bytes;
+    uint64_t txn_buffer_bytes;
+    uint64_t row_cache_bytes;
+    uint64_t total_bytes;
+    uint64_t write_buffer_budget;
+    uint64_t row_cache_capacity;
+} tidesdb_memory_usage_t;
+
 /*
  * tidesdb_wal_t
  * struct for write-ahead logs in TidesDB
  * @param block_manager the block manager for the WAL
  * @param compress whether to compress the WAL
  * @param compress_algo the compression algorithm to use if you want to compress the WAL
+ * @param stats the statistics of the column family the WAL belongs to, NULL for none
  */
 typedef struct
 {
     block_manager_t *block_manager;
     bool compress;
     tidesdb_compression_algo_t compress_algo;
+    tidesdb_stats_shard_t *stats;
 } tidesdb_wal_t;
 
 /*
@@ -102,7 +702,16 @@ typedef enum
  * @param max_level the max level of the column family
  * @param probability the probability of the column family
  * @param compressed the compressed status of the column family
- * @param bloom_filter whether to use a bloom filter for the column family sstables
+ * @param bloom_filter whether to use a filter for the column family sstables
+ * @param memtable_shards the amount of shards the memtable and wal are partitioned into
+ * @param filter_type the kind of filter written when bloom_filter is set
+ * @param partitioned_index whether sstables are split into partitions with a filter each under a
+ * top level index, a get then reads one small filter and one partition instead of the sstable
+ * @param hash_index whether every partition also gets a hash index of its keys so a get reads a
+ * single key value block, it needs partitioned_index and only helps point lookups
+ * @param learned_index whether every partition also gets a piecewise linear model from its keys
+ * read as integers to their positions, so a get reads a few key value blocks instead of the
+ * partition, it needs partitioned_index and suits fixed width integer keys
  */
 typedef struct
 {
@@ -114,29 +723,78 @@ typedef struct
     tidesdb_compression_algo_t compress_algo;
     tidesdb_memtable_ds_t memtable_ds;
     bool bloom_filter;
+    int32_t memtable_shards;
+    tidesdb_filter_type_t filter_type;
+    bool partitioned_index;
+    bool hash_index;
+    bool learned_index;
 } tidesdb_column_family_config_t;
 
+/*
+ * tidesdb_memtable_shard_t
+ * struct for a memtable shard of a column family
+ * keys are hash-partitioned across the shards of a column family so writers of different keys
+ * don't contend on the same lock, memtable or wal
+ * @param rwlock read-write lock for the shard
+ * @param memtable the memtable for the shard
+ * @param wal the write-ahead log for the shard
+ */
+typedef struct
+{
+    pthread_rwlock_t rwlock;
+    void *memtable; /* can be a skip list or hash table */
+    tidesdb_wal_t *wal;
+} tidesdb_memtable_shard_t;
+
+typedef struct tidesdb_t tidesdb_t;
+
 /*
  * tidesdb_column_family_t
  * struct for a column family in TidesDB
+ * @param tdb the TidesDB instance the column family belongs to
  * @param config the configuration for the column family
  * @param path the path to the column family
- * @param sstables the sstables for the column family
- * @param num_sstables the number of sstables for the column family
- * @param rwlock read-write lock for column family
- * @param memtable the memtable for the column family
- * @param wal the write-ahead log for column family
- */
-typedef struct
+ * @param version the current version of the column family sstables
+ * @param version_lock lock for swapping the current version and allocating sstable ids
+ * @param version_cond signalled when a new version is installed, stalled writers wait on it
+ * @param num_sstables the number of sstables in the current version, for write stalls
+ * @param compaction_lock lock so only one compaction runs on the column family at a time, drop
+ * takes it so no compaction writes into the directory it removes
+ * @param file_lock lock for removing the files of obsolete sstables, drop takes it to set dropped
+ * so no file is removed from the directory of a column family recreated under the same name
+ * @param stats the statistics of the column family, TDB_STATS_SHARDS shards
+ * @param cache_id the id the rows of the column family are cached under, unique in the database
+ * @param stall_condition the write stall condition last reported to the event listener
+ * @param memtable_bytes the size of the memtable shards together
+ * @param next_sstable_id the id for the next sstable written
+ * @param rwlock read-write lock for column family, single key operations hold it shared along
+ * with the lock of their shard, flushes, transactions and drops hold it exclusively
+ * @param shards the memtable shards for the column family, config.memtable_shards of them
+ * @param refcount references held on the column family by the db, handles, transactions and
+ * cursors
+ * @param dropped whether the column family has been dropped
+ */
+struct tidesdb_column_family_t
 {
+    tidesdb_t *tdb;
     tidesdb_column_family_config_t config;
     char *path;
-    tidesdb_sstable_t **sstables;
-    int num_sstables;
+    tidesdb_version_t *version;
+    pthread_mutex_t version_lock;
+    pthread_cond_t version_cond;
+    atomic_int num_sstables;
+    pthread_mutex_t compaction_lock;
+    pthread_mutex_t file_lock;
+    tidesdb_stats_shard_t *stats;
+    uint64_t cache_id;
+    TIDESDB_STALL_CONDITION stall_condition; /* guarded by version_lock */
+    _Atomic uint64_t memtable_bytes;
+    uint64_t next_sstable_id; /* guarded by version_lock */
     pthread_rwlock_t rwlock;
-    void *memtable; /* can be a skip list or hash table */
-    tidesdb_wal_t *wal;
-} tidesdb_column_family_t;
+    tidesdb_memtable_shard_t *shards;
+    atomic_int refcount; /* the column family is freed when this reaches 0 */
+    bool dropped; /* set under the write lock, the version lock and the file lock on drop */
+};
 
 /*
  * tidesdb_key_value_pair_t
@@ -195,21 +853,111 @@ typedef struct
     bool committed;
 } tidesdb_txn_op_t;
 
+/*
+ * tidesdb_config_t
+ * struct for the configuration of a TidesDB instance
+ * @param direct_io whether sstable reads, flushes and compactions bypass the page cache
+ * @param rate_limit_bytes_per_sec the write budget shared by flushes and compactions, flushes
+ * never wait for it and compactions make up for them, 0 or less for unlimited
+ * @param stall_soft_sstables the sstable count of a column family at which its writes are
+ * delayed, more delay for every sstable past it, 0 to disable
+ * @param stall_hard_sstables the sstable count of a column family at which its writes wait for a
+ * compaction to bring it back down, 0 to disable.  compaction is manual, a writer at the limit
+ * waits for a tidesdb_compact_sstables call from another thread
+ * @param stall_timeout_ms the longest a write waits at stall_hard_sstables before it fails with
+ * TIDESDB_ERR_WRITE_STALLED, 0 or less for TDB_DEFAULT_STALL_TIMEOUT_MS
+ * @param background_threads the threads shared by the background jobs of every column family, 0
+ * for TDB_DEFAULT_BACKGROUND_THREADS
+ * @param max_subcompactions the key ranges a pair merge may be split into, each written to its own
+ * sstable by its own thread, 0 or 1 to merge a pair into a single sstable
+ * @param trace the tracing callback for flush, compaction and WAL sync spans, NULL for none
+ * @param trace_arg the argument passed to the tracing callback
+ * @param listener the event listener for flushes, compactions, write stalls and background errors
+ * @param write_buffer_budget the memtable bytes all column families may hold together, past it the
+ * column family holding the most is flushed early, 0 or less for no budget
+ * @param row_cache_bytes the memory the row cache may hold, gets of rows read from sstables are
+ * then answered from memory until the row is written or evicted, 0 or less for no row cache
+ */
+typedef struct
+{
+    bool direct_io;
+    int64_t rate_limit_bytes_per_sec;
+    int stall_soft_sstables;
+    int stall_hard_sstables;
+    int stall_timeout_ms;
+    int background_threads;
+    int max_subcompactions;
+    tidesdb_trace_fn_t trace;
+    void *trace_arg;
+    tidesdb_event_listener_t listener;
+    int64_t write_buffer_budget;
+    int64_t row_cache_bytes;
+} tidesdb_config_t;
+
+/*
+ * tidesdb_stall_stats_t
+ * struct for write stall metrics of a TidesDB instance
+ * @param delayed_writes the writes delayed past the soft limit
+ * @param stopped_writes the writes stopped at the hard limit
+ * @param stall_us the total time writes spent stalled in microseconds
+ */
+typedef struct
+{
+    uint64_t delayed_writes;
+    uint64_t stopped_writes;
+    uint64_t stall_us;
+} tidesdb_stall_stats_t;
+
 /*
  * tidesdb_t
  * struct for TidesDB
  * @param directory the directory for the database
+ * @param config the configuration for the database
+ * @param rate_limiter the rate limiter for flush and compaction writes, flushes are charged
+ * without waiting
+ * @param background_pool the pool running background jobs such as compaction merges
+ * @param delayed_writes the writes delayed past the soft stall limit
+ * @param stopped_writes the writes stopped at the hard stall limit
+ * @param stall_us the total time writes spent stalled in microseconds
+ * @param memtable_bytes the size of the memtables of every column family, for the write buffer
+ * budget
+ * @param row_cache the cache of rows read from sstables, NULL for none
+ * @param next_cache_id the cache id for the next column family opened or created
  * @param column_families the column families currently
  * @param num_column_families the number of column families
  * @param rwlock read-write lock for the database
  */
-typedef struct
+struct tidesdb_t
 {
     char *directory;
+    tidesdb_config_t config;
+    rate_limiter_t *rate_limiter;
+    thread_pool_t *background_pool;
+    _Atomic uint64_t delayed_writes;
+    _Atomic uint64_t stopped_writes;
+    _Atomic uint64_t stall_us;
+    _Atomic uint64_t memtable_bytes;
+    row_cache_t *row_cache;
+    _Atomic uint64_t next_cache_id;
     tidesdb_column_family_t **column_families;
     int num_column_families;
     pthread_rwlock_t rwlock;
-} tidesdb_t;
+};
+
+/*
+ * tidesdb_cf_handle_t
+ * struct for a column family handle
+ * a handle is obtained once by name and pins the column family with a reference so data
+ * operations through it skip the name lookup and the db lock, the column family stays valid
+ * until the handle is released even if it is dropped in the meantime
+ * @param tdb the TidesDB instance
+ * @param cf the column family
+ */
+typedef struct
+{
+    tidesdb_t *tdb;
+    tidesdb_column_family_t *cf;
+} tidesdb_cf_handle_t;
 
 /*
  * tidesdb_txn_t
@@ -219,6 +967,7 @@ typedef struct
  * @param num_ops the number of operations in the transaction
  * @param cf the column family for the transaction
  * @param lock the lock for the transaction
+ * @param buffer_bytes the memory held by the operations, counted into the column family
  */
 typedef struct
 {
@@ -227,45 +976,229 @@ typedef struct
     int num_ops;
     tidesdb_column_family_t *cf;
     pthread_mutex_t lock;
+    size_t buffer_bytes;
 } tidesdb_txn_t;
 
+/*
+ * tidesdb_cursor_source_t
+ * struct for one sorted source a TidesDB cursor merges, either the memtable snapshot or an
+ * sstable
+ * entries are addressed by index, sstable entry offsets are recorded as the source moves
+ * forward so it can step back over any entry it has passed
+ * @param sstable the sstable of the source, NULL for the memtable snapshot
+ * @param block_cursor the block manager cursor used to read the sstable
+ * @param entries the sorted memtable snapshot entries
+ * @param num_entries the number of memtable snapshot entries
+ * @param offsets the offsets of the sstable entries visited so far
+ * @param num_offsets the number of recorded offsets
+ * @param offsets_capacity the capacity of the offsets array
+ * @param end_offset the offset right after the last recorded sstable entry
+ * @param exhausted whether the sstable has no entries past the recorded ones
+ * @param data_end the offset the key value blocks of the sstable end at, UINT64_MAX if they run to
+ * the end of the file
+ * @param index the index of the entry the source is on, -1 if before the first entry
+ * @param kv the entry the source is on, NULL if the source is out of range
+ */
+typedef struct
+{
+    tidesdb_sstable_t *sstable;
+    block_manager_cursor_t *block_cursor;
+    tidesdb_key_value_pair_t **entries;
+    int num_entries;
+    uint64_t *offsets;
+    int num_offsets;
+    int offsets_capacity;
+    uint64_t end_offset;
+    uint64_t data_end;
+    bool exhausted;
+    int index;
+    tidesdb_key_value_pair_t *kv;
+} tidesdb_cursor_source_t;
+
 /*
  * tidesdb_cursor_t
  * struct for a TidesDB cursor
+ * the cursor merges a snapshot of the memtable shards with the sstables of the version it pins
+ * in key order, the newest version of a key wins and deleted or expired keys are skipped
  * @param tidesdb the tidesdb instance
  * @param cf the column family
- * @param memtable_cursor the cursor for the memtable
- * @param sstable_index the current index of the sstable the cursor is on
- * @param sstable_cursor the cursor for the sstable
- * @param current the current key-value pair
+ * @param version the version of the sstables pinned by the cursor
+ * @param sources the sources the cursor merges, the memtable snapshot first then the sstables
+ * from newest to oldest
+ * @param num_sources the number of sources
+ * @param current the index of the source the cursor is on, -1 if the cursor is empty
+ * @param forward whether the cursor last moved forward, every other source is then on its first
+ * key after the current key, otherwise on its last key before it
  */
 typedef struct
 {
     tidesdb_t *tidesdb;
     tidesdb_column_family_t *cf;
-    void *memtable_cursor;
-    int sstable_index;
-    block_manager_cursor_t *sstable_cursor;
-    tidesdb_key_value_pair_t *current;
+    tidesdb_version_t *version;
+    tidesdb_cursor_source_t *sources;
+    int num_sources;
+    int current;
+    bool forward;
 } tidesdb_cursor_t;
 
 /*
  * tidesdb_compact_thread_args_t
- * struct for the arguments for a compact thread
+ * struct for the arguments for a compaction merge job on the background pool
  * @param cf the column family
- * @param start the start index for the sstables
- * @param end the end index for the sstables
- * @param sem semaphore to limit concurrent threads
+ * @param sst1 the older sstable of the pair
+ * @param sst2 the newer sstable of the pair
+ * @param bottommost whether the pair holds the oldest sstable, tombstones are dropped if so
+ * @param outputs where the job stores the merged sstables in key order, left NULL if the merge
+ * fails
+ * @param num_outputs the number of merged sstables
+ * @param dropped the tombstones and expired keys the merge left out
+ * @param sem semaphore to limit concurrent merges of the compaction
  */
 typedef struct
 {
     tidesdb_column_family_t *cf; /* the column family */
-    int start;                   /* the start index for the sstables */
-    int end;                     /* the end index for the sstables */
-    sem_t *sem;                  /* semaphore to limit concurrent threads */
-    pthread_mutex_t *lock;       /* lock for the path creation on parallel compaction */
+    tidesdb_sstable_t *sst1;     /* the older sstable of the pair */
+    tidesdb_sstable_t *sst2;     /* the newer sstable of the pair */
+    bool bottommost;             /* whether sst1 is the oldest sstable in the column family */
+    tidesdb_sstable_t **outputs; /* the merged sstables */
+    int num_outputs;             /* the number of merged sstables */
+    tidesdb_dropped_t dropped;   /* what the merge left out */
+    sem_t *sem;                  /* semaphore to limit concurrent merges */
 } tidesdb_compact_thread_args_t;
 
+/*
+ * tidesdb_subcompaction_t
+ * a key range of a pair merge, written to its own sstable
+ * @param start the first node of the range in the merge table
+ * @param end the node past the range, NULL for the end of the merge table
+ * @param output the sstable written for the range, NULL if writing it failed
+ * @param dropped the tombstones and expired keys left out of the range
+ * @param claimed whether a thread has taken the range
+ */
+typedef struct
+{
+    skip_list_node_t *start;
+    skip_list_node_t *end;
+    tidesdb_sstable_t *output;
+    tidesdb_dropped_t dropped;
+    atomic_bool claimed;
+} tidesdb_subcompaction_t;
+
+/*
+ * tidesdb_subcompactions_t
+ * the key ranges of a pair merge, shared by the merging thread and the pool jobs helping it
+ * the merging thread runs every range no job has claimed yet so it never waits on a queued job
+ * @param cf the column family
+ * @param mergetable the merge table the ranges are taken from
+ * @param drop_deleted whether to drop tombstones and expired keys
+ * @param ranges the key ranges in key order
+ * @param num_ranges the number of key ranges
+ * @param done the number of ranges written
+ * @param lock the lock for done
+ * @param cond signalled when a range is written
+ * @param refcount the merging thread and the submitted jobs, the last to release frees it
+ */
+typedef struct
+{
+    tidesdb_column_family_t *cf;
+    skip_list_t *mergetable;
+    bool drop_deleted;
+    tidesdb_subcompaction_t *ranges;
+    int num_ranges;
+    int done;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    atomic_int refcount;
+} tidesdb_subcompactions_t;
+
+/*
+ * tidesdb_async_callback_t
+ * completion callback for an async operation, called on a worker thread
+ * for a get the value belongs to the callback and must be freed, it is NULL if the get failed
+ * and for puts
+ * @param status TIDESDB_SUCCESS or an error code
+ * @param key the key of the operation, only valid during the callback
+ * @param key_size the size of the key
+ * @param value the value of a get
+ * @param value_size the size of the value
+ * @param arg the argument passed when the operation was submitted
+ */
+typedef void (*tidesdb_async_callback_t)(int status, const uint8_t *key, size_t key_size,
+                                         uint8_t *value, size_t value_size, void *arg);
+
+/*
+ * TIDESDB_ASYNC_OP_CODE
+ * operation codes for async jobs
+ */
+typedef enum
+{
+    TIDESDB_ASYNC_OP_GET,
+    TIDESDB_ASYNC_OP_PUT,
+} TIDESDB_ASYNC_OP_CODE;
+
+/*
+ * tidesdb_async_job_t
+ * struct for a queued async job, keys and the value are copied so the caller's buffers can be
+ * reused as soon as the job is submitted
+ * @param op_code the operation code
+ * @param cf the column family, the job holds a reference on it
+ * @param keys the keys of the job, a multi get has more than one
+ * @param key_sizes the sizes of the keys
+ * @param num_keys the number of keys
+ * @param value the value for a put
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for a put
+ * @param callback the completion callback, called once per key
+ * @param arg the argument for the callback
+ * @param next the next job in the queue
+ */
+typedef struct tidesdb_async_job_t
+{
+    TIDESDB_ASYNC_OP_CODE op_code;
+    tidesdb_column_family_t *cf;
+    uint8_t **keys;
+    size_t *key_sizes;
+    int num_keys;
+    uint8_t *value;
+    size_t value_size;
+    time_t ttl;
+    tidesdb_async_callback_t callback;
+    void *arg;
+    struct tidesdb_async_job_t *next;
+} tidesdb_async_job_t;
+
+/*
+ * tidesdb_async_t
+ * struct for an async context, a queue of jobs served by a pool of worker threads
+ * @param tdb the TidesDB instance
+ * @param threads the worker threads
+ * @param num_threads the number of worker threads
+ * @param head the next job to run
+ * @param tail the last queued job
+ * @param queued the number of queued jobs
+ * @param pending the number of queued and running jobs
+ * @param stop whether the workers should exit once the queue is drained
+ * @param lock the lock for the queue
+ * @param not_empty signalled when a job is queued or the context is closing
+ * @param not_full signalled when a job is taken off a full queue
+ * @param idle signalled when the last pending job completes
+ */
+typedef struct
+{
+    tidesdb_t *tdb;
+    pthread_t *threads;
+    int num_threads;
+    tidesdb_async_job_t *head;
+    tidesdb_async_job_t *tail;
+    int queued;
+    int pending;
+    bool stop;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    pthread_cond_t idle;
+} tidesdb_async_t;
+
 /* functions prefixed with _ are internal functions */
 /* api functions return a tidesdb_err* */
 
@@ -280,130 +1213,388 @@ typedef struct
 tidesdb_err_t *tidesdb_open(char *directory, tidesdb_t **tdb);
 
 /*
- * tidesdb_close
- * close a TidesDB instance
- * @param tdb the TidesDB instance
+ * tidesdb_open_w_config
+ * open a TidesDB instance with a configuration
+ * @param directory the directory for the database
+ * @param config the configuration, NULL for the defaults
+ * @param tdb the TidesDB instance (should be null)
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_close(tidesdb_t *tdb);
+tidesdb_err_t *tidesdb_open_w_config(char *directory, tidesdb_config_t *config, tidesdb_t **tdb);
 
 /*
- * tidesdb_create_column_family
- * create a new column family
+ * tidesdb_set_rate_limit
+ * change the write budget shared by flushes and compactions
  * @param tdb the TidesDB instance
- * @param name the name of the column family
- * @param flush_threshold the threshold at which the memtable should be flushed to disk
- * @param max_level the maximum level for the memtable(skiplist)
- * @param probability the probability for skip list
- * @param compressed whether the column family WAL and SSTables should be compressed
- * @param compress_algo the compression algorithm to use if you want to compress the column family
- * @param bloom_filter whether the column family should use a bloom filter
- * @param memtable_ds the data structure for the memtable
+ * @param bytes_per_sec the budget in bytes per second, 0 or less for unlimited
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_create_column_family(tidesdb_t *tdb, const char *name, int flush_threshold,
-                                            int max_level, float probability, bool compressed,
-                                            tidesdb_compression_algo_t compress_algo,
-                                            bool bloom_filter, tidesdb_memtable_ds_t memtable_ds);
+tidesdb_err_t *tidesdb_set_rate_limit(tidesdb_t *tdb, int64_t bytes_per_sec);
 
 /*
- * tidesdb_drop_column_family
- * drops a column family and all associated data
+ * tidesdb_get_stall_stats
+ * get the write stall metrics of a TidesDB instance
  * @param tdb the TidesDB instance
- * @param name the name of the column family
+ * @param stats the stall metrics
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_drop_column_family(tidesdb_t *tdb, const char *name);
+tidesdb_err_t *tidesdb_get_stall_stats(tidesdb_t *tdb, tidesdb_stall_stats_t *stats);
 
 /*
- * tidesdb_compact_sstables
- * pairs and merges sstables in a column family
+ * tidesdb_get_stats
+ * get the statistics of a column family
  * @param tdb the TidesDB instance
- * @param column_family the column family name
- * @param max_threads the maximum number of threads to use
+ * @param column_family_name the name of the column family
+ * @param stats the statistics
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_compact_sstables(tidesdb_t *tdb, const char *column_family_name,
-                                        int max_threads);
+tidesdb_err_t *tidesdb_get_stats(tidesdb_t *tdb, const char *column_family_name,
+                                 tidesdb_stats_t *stats);
 
 /*
- * tidesdb_put
- * put a key-value pair into TidesDB
- * @param tdb the TidesDB instance
- * @param column_family_name the name of the column family
- * @param key the key
- * @param key_size the size of the key
- * @param value the value
- * @param value_size the size of the value
- * @param ttl the time-to-live for the key-value pair, you can provide -1 for no ttl
+ * tidesdb_get_stats_w_handle
+ * get the statistics of a column family using a column family handle
+ * @param handle the column family handle
+ * @param stats the statistics
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_put(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
-                           size_t key_size, const uint8_t *value, size_t value_size, time_t ttl);
+tidesdb_err_t *tidesdb_get_stats_w_handle(tidesdb_cf_handle_t *handle, tidesdb_stats_t *stats);
 
 /*
- * tidesdb_get
- * get a value from TidesDB
+ * tidesdb_get_sstable_stats
+ * get the statistics of each SSTable of a column family, oldest first
  * @param tdb the TidesDB instance
  * @param column_family_name the name of the column family
- * @param key the key
- * @param key_size the size of the key
- * @param value the value
- * @param value_size the size of the value
+ * @param stats the statistics, allocated for the caller to free
+ * @param num_sstables the number of SSTables
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_get(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
-                           size_t key_size, uint8_t **value, size_t *value_size);
+tidesdb_err_t *tidesdb_get_sstable_stats(tidesdb_t *tdb, const char *column_family_name,
+                                         tidesdb_sstable_stats_t **stats, int *num_sstables);
 
 /*
- * tidesdb_delete
- * delete a key-value pair from TidesDB
- * @param tdb the TidesDB instance
- * @param column_family_name the name of the column family
- * @param key the key
- * @param key_size the size of the key
+ * tidesdb_get_sstable_stats_w_handle
+ * get the statistics of each SSTable of a column family using a column family handle, oldest first
+ * @param handle the column family handle
+ * @param stats the statistics, allocated for the caller to free
+ * @param num_sstables the number of SSTables
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_delete(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
-                              size_t key_size);
+tidesdb_err_t *tidesdb_get_sstable_stats_w_handle(tidesdb_cf_handle_t *handle,
+                                                  tidesdb_sstable_stats_t **stats,
+                                                  int *num_sstables);
 
 /*
- * tidesdb_txn_begin
- * begin a transaction
+ * tidesdb_get_memory_usage
+ * get the memory held by a TidesDB instance by component, summed over its column families
  * @param tdb the TidesDB instance
- * @param txn the transaction to begin
- * @param column_family the column family
+ * @param usage the memory usage
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_txn_begin(tidesdb_t *tdb, tidesdb_txn_t **txn, const char *column_family);
+tidesdb_err_t *tidesdb_get_memory_usage(tidesdb_t *tdb, tidesdb_memory_usage_t *usage);
 
 /*
- * tidesdb_txn_put
- * put a key-value pair into a transaction
- * @param txn the transaction
- * @param key the key
- * @param key_size the size of the key
- * @param value the value
- * @param value_size the size of the value
- * @param ttl the time-to-live for the key-value pair
+ * tidesdb_perf_context_enable
+ * enable or disable the perf context of the calling thread, it is disabled by default and costs a
+ * branch per timer while disabled
+ * @param enable whether to time the operations of the calling thread
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_txn_put(tidesdb_txn_t *txn, const uint8_t *key, size_t key_size,
-                               const uint8_t *value, size_t value_size, time_t ttl);
+tidesdb_err_t *tidesdb_perf_context_enable(bool enable);
 
 /*
- * tidesdb_txn_delete
- * delete a key-value pair from a transaction
- * @param txn the transaction
- * @param key the key
- * @param key_size the size of the key
+ * tidesdb_perf_context_reset
+ * zero the perf context of the calling thread, usually before the operation to look at
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_txn_delete(tidesdb_txn_t *txn, const uint8_t *key, size_t key_size);
+tidesdb_err_t *tidesdb_perf_context_reset();
 
 /*
- * tidesdb_txn_commit
- * commit a transaction
+ * tidesdb_get_perf_context
+ * get the perf context of the calling thread
+ * @param ctx the perf context
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_get_perf_context(tidesdb_perf_context_t *ctx);
+
+/*
+ * tidesdb_close
+ * close a TidesDB instance
+ * @param tdb the TidesDB instance
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_close(tidesdb_t *tdb);
+
+/*
+ * tidesdb_create_column_family
+ * create a new column family
+ * @param tdb the TidesDB instance
+ * @param name the name of the column family
+ * @param flush_threshold the threshold at which the memtable should be flushed to disk
+ * @param max_level the maximum level for the memtable(skiplist)
+ * @param probability the probability for skip list
+ * @param compressed whether the column family WAL and SSTables should be compressed
+ * @param compress_algo the compression algorithm to use if you want to compress the column family
+ * @param bloom_filter whether the column family should use a bloom filter
+ * @param memtable_ds the data structure for the memtable
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_create_column_family(tidesdb_t *tdb, const char *name, int flush_threshold,
+                                            int max_level, float probability, bool compressed,
+                                            tidesdb_compression_algo_t compress_algo,
+                                            bool bloom_filter, tidesdb_memtable_ds_t memtable_ds);
+
+/*
+ * tidesdb_create_column_family_w_config
+ * create a new column family from a column family config, for the settings the other create
+ * functions leave at their defaults such as the filter type
+ * @param tdb the TidesDB instance
+ * @param config the column family config, the name is copied
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_create_column_family_w_config(tidesdb_t *tdb,
+                                                     const tidesdb_column_family_config_t *config);
+
+/*
+ * tidesdb_create_column_family_w_shards
+ * create a new column family with its memtable and wal hash-partitioned into shards
+ * writers of keys in different shards don't contend, the shards are flushed together into one
+ * sstable and cursors merge them in key order
+ * @param tdb the TidesDB instance
+ * @param name the name of the column family
+ * @param flush_threshold the threshold at which the memtable should be flushed to disk
+ * @param max_level the maximum level for the memtable(skiplist)
+ * @param probability the probability for skip list
+ * @param compressed whether the column family WAL and SSTables should be compressed
+ * @param compress_algo the compression algorithm to use if you want to compress the column family
+ * @param bloom_filter whether the column family should use a bloom filter
+ * @param memtable_ds the data structure for the memtable
+ * @param memtable_shards the number of memtable shards, 1 to TDB_MAX_MEMTABLE_SHARDS
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_create_column_family_w_shards(tidesdb_t *tdb, const char *name,
+                                                     int flush_threshold, int max_level,
+                                                     float probability, bool compressed,
+                                                     tidesdb_compression_algo_t compress_algo,
+                                                     bool bloom_filter,
+                                                     tidesdb_memtable_ds_t memtable_ds,
+                                                     int memtable_shards);
+
+/*
+ * tidesdb_drop_column_family
+ * drops a column family and all associated data
+ * @param tdb the TidesDB instance
+ * @param name the name of the column family
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_drop_column_family(tidesdb_t *tdb, const char *name);
+
+/*
+ * tidesdb_get_cf_handle
+ * get a handle for a column family, the handle must be released with tidesdb_release_cf_handle
+ * before the TidesDB instance is closed
+ * @param tdb the TidesDB instance
+ * @param column_family_name the name of the column family
+ * @param handle the column family handle
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_get_cf_handle(tidesdb_t *tdb, const char *column_family_name,
+                                     tidesdb_cf_handle_t **handle);
+
+/*
+ * tidesdb_release_cf_handle
+ * release a column family handle, if the column family was dropped and this is the last
+ * reference the column family is freed
+ * @param handle the column family handle
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_release_cf_handle(tidesdb_cf_handle_t *handle);
+
+/*
+ * tidesdb_compact_sstables
+ * pairs and merges sstables in a column family
+ * @param tdb the TidesDB instance
+ * @param column_family the column family name
+ * @param max_threads the maximum number of pair merges to run at once on the background pool
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_compact_sstables(tidesdb_t *tdb, const char *column_family_name,
+                                        int max_threads);
+
+/*
+ * tidesdb_compact_sstables_w_handle
+ * pairs and merges sstables in a column family using a column family handle
+ * @param handle the column family handle
+ * @param max_threads the maximum number of pair merges to run at once on the background pool
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_compact_sstables_w_handle(tidesdb_cf_handle_t *handle, int max_threads);
+
+/*
+ * tidesdb_put
+ * put a key-value pair into TidesDB
+ * @param tdb the TidesDB instance
+ * @param column_family_name the name of the column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for the key-value pair, you can provide -1 for no ttl
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_put(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
+                           size_t key_size, const uint8_t *value, size_t value_size, time_t ttl);
+
+/*
+ * tidesdb_put_w_handle
+ * put a key-value pair into TidesDB using a column family handle
+ * @param handle the column family handle
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for the key-value pair, you can provide -1 for no ttl
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_put_w_handle(tidesdb_cf_handle_t *handle, const uint8_t *key,
+                                    size_t key_size, const uint8_t *value, size_t value_size,
+                                    time_t ttl);
+
+/*
+ * tidesdb_put_status
+ * put a key-value pair into TidesDB using a column family handle, returning a status code
+ * no error is allocated, use tidesdb_err_message for a description of a failure
+ * @param handle the column family handle
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for the key-value pair
+ * @return TIDESDB_SUCCESS or an error code
+ */
+int tidesdb_put_status(tidesdb_cf_handle_t *handle, const uint8_t *key, size_t key_size,
+                       const uint8_t *value, size_t value_size, time_t ttl);
+
+/*
+ * tidesdb_get
+ * get a value from TidesDB
+ * @param tdb the TidesDB instance
+ * @param column_family_name the name of the column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_get(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
+                           size_t key_size, uint8_t **value, size_t *value_size);
+
+/*
+ * tidesdb_get_w_handle
+ * get a value from TidesDB using a column family handle
+ * @param handle the column family handle
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_get_w_handle(tidesdb_cf_handle_t *handle, const uint8_t *key,
+                                    size_t key_size, uint8_t **value, size_t *value_size);
+
+/*
+ * tidesdb_get_status
+ * get a value from TidesDB using a column family handle, returning a status code
+ * a missing key is TIDESDB_ERR_KEY_NOT_FOUND and costs no allocation
+ * @param handle the column family handle
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value, only set on TIDESDB_SUCCESS
+ * @param value_size the size of the value
+ * @return TIDESDB_SUCCESS or an error code
+ */
+int tidesdb_get_status(tidesdb_cf_handle_t *handle, const uint8_t *key, size_t key_size,
+                       uint8_t **value, size_t *value_size);
+
+/*
+ * tidesdb_delete
+ * delete a key-value pair from TidesDB
+ * @param tdb the TidesDB instance
+ * @param column_family_name the name of the column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_delete(tidesdb_t *tdb, const char *column_family_name, const uint8_t *key,
+                              size_t key_size);
+
+/*
+ * tidesdb_delete_w_handle
+ * delete a key-value pair from TidesDB using a column family handle
+ * @param handle the column family handle
+ * @param key the key
+ * @param key_size the size of the key
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_delete_w_handle(tidesdb_cf_handle_t *handle, const uint8_t *key,
+                                       size_t key_size);
+
+/*
+ * tidesdb_delete_status
+ * delete a key-value pair from TidesDB using a column family handle, returning a status code
+ * @param handle the column family handle
+ * @param key the key
+ * @param key_size the size of the key
+ * @return TIDESDB_SUCCESS or an error code
+ */
+int tidesdb_delete_status(tidesdb_cf_handle_t *handle, const uint8_t *key, size_t key_size);
+
+/*
+ * tidesdb_txn_begin
+ * begin a transaction
+ * @param tdb the TidesDB instance
+ * @param txn the transaction to begin
+ * @param column_family the column family
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_txn_begin(tidesdb_t *tdb, tidesdb_txn_t **txn, const char *column_family);
+
+/*
+ * tidesdb_txn_begin_w_handle
+ * begin a transaction on a column family handle
+ * @param handle the column family handle
+ * @param txn the transaction to begin
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_txn_begin_w_handle(tidesdb_cf_handle_t *handle, tidesdb_txn_t **txn);
+
+/*
+ * tidesdb_txn_put
+ * put a key-value pair into a transaction
+ * @param txn the transaction
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for the key-value pair
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_txn_put(tidesdb_txn_t *txn, const uint8_t *key, size_t key_size,
+                               const uint8_t *value, size_t value_size, time_t ttl);
+
+/*
+ * tidesdb_txn_delete
+ * delete a key-value pair from a transaction
+ * @param txn the transaction
+ * @param key the key
+ * @param key_size the size of the key
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_txn_delete(tidesdb_txn_t *txn, const uint8_t *key, size_t key_size);
+
+/*
+ * tidesdb_txn_commit
+ * commit a transaction
  * @param txn the transaction to be commited
  * @return error or NULL
  */
@@ -415,83 +1606,686 @@ tidesdb_err_t *tidesdb_txn_commit(tidesdb_txn_t *txn);
  * @param txn the transaction
  * @return error or NULL
  */
-tidesdb_err_t *tidesdb_txn_rollback(tidesdb_txn_t *txn);
+tidesdb_err_t *tidesdb_txn_rollback(tidesdb_txn_t *txn);
+
+/*
+ * tidesdb_txn_free
+ * free a transaction and its operations
+ * @param txn the transaction
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_txn_free(tidesdb_txn_t *txn);
+
+/*
+ * tidesdb_cursor_init
+ * initialize a new TidesDB cursor
+ * @param tdb the TidesDB instance
+ * @param column_family_name the name of the column family
+ * @param cursor the TidesDB cursor
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_cursor_init(tidesdb_t *tdb, const char *column_family_name,
+                                   tidesdb_cursor_t **cursor);
+
+/*
+ * tidesdb_cursor_init_w_handle
+ * initialize a new TidesDB cursor on a column family handle
+ * @param handle the column family handle
+ * @param cursor the TidesDB cursor
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_cursor_init_w_handle(tidesdb_cf_handle_t *handle, tidesdb_cursor_t **cursor);
+
+/*
+ * tidesdb_cursor_next
+ * move the cursor to the next key-value pair
+ * @param cursor the TidesDB cursor
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_cursor_next(tidesdb_cursor_t *cursor);
+
+/*
+ * tidesdb_cursor_prev
+ * move the cursor to the previous key-value pair
+ * @param cursor the TidesDB cursor
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_cursor_prev(tidesdb_cursor_t *cursor);
+
+/*
+ * tidesdb_cursor_seek
+ * move the cursor to the first key-value pair with a key at or past the given key, the cursor is
+ * left empty if there is none
+ * @param cursor the TidesDB cursor
+ * @param key the key to seek to
+ * @param key_size the size of the key
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_cursor_seek(tidesdb_cursor_t *cursor, const uint8_t *key, size_t key_size);
+
+/*
+ * tidesdb_cursor_get
+ * get the current key-value pair from the cursor
+ * @param cursor the TidesDB cursor
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_cursor_get(tidesdb_cursor_t *cursor, uint8_t **key, size_t *key_size,
+                                  uint8_t **value, size_t *value_size);
+
+/*
+ * tidesdb_cursor_free
+ * free the memory for the cursor
+ * @param cursor the TidesDB cursor
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_cursor_free(tidesdb_cursor_t *cursor);
+
+/*
+ * tidesdb_list_column_families
+ * list the column families in TidesDB
+ * @param tdb the TidesDB instance
+ * @return the column families
+ */
+char *tidesdb_list_column_families(tidesdb_t *tdb);
+
+/*
+ * tidesdb_async_open
+ * start an async context with a pool of worker threads
+ * @param tdb the TidesDB instance
+ * @param num_threads the number of worker threads, 1 to TDB_ASYNC_MAX_THREADS
+ * @param async the async context
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_async_open(tidesdb_t *tdb, int num_threads, tidesdb_async_t **async);
+
+/*
+ * tidesdb_async_wait
+ * wait until every submitted job has completed
+ * @param async the async context
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_async_wait(tidesdb_async_t *async);
+
+/*
+ * tidesdb_async_close
+ * close an async context, jobs already submitted complete before the workers exit
+ * @param async the async context
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_async_close(tidesdb_async_t *async);
+
+/*
+ * tidesdb_get_async
+ * submit a get, the callback receives the value once it is read
+ * @param async the async context
+ * @param handle the column family handle
+ * @param key the key
+ * @param key_size the size of the key
+ * @param callback the completion callback
+ * @param arg the argument for the callback
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_get_async(tidesdb_async_t *async, tidesdb_cf_handle_t *handle,
+                                 const uint8_t *key, size_t key_size,
+                                 tidesdb_async_callback_t callback, void *arg);
+
+/*
+ * tidesdb_multi_get_async
+ * submit a batch of gets as one job, the callback is called once per key in order
+ * @param async the async context
+ * @param handle the column family handle
+ * @param keys the keys
+ * @param key_sizes the sizes of the keys
+ * @param num_keys the number of keys
+ * @param callback the completion callback
+ * @param arg the argument for the callback
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_multi_get_async(tidesdb_async_t *async, tidesdb_cf_handle_t *handle,
+                                       const uint8_t **keys, const size_t *key_sizes,
+                                       int num_keys, tidesdb_async_callback_t callback,
+                                       void *arg);
+
+/*
+ * tidesdb_put_async
+ * submit a put, the callback is called once it is in the WAL and memtable
+ * @param async the async context
+ * @param handle the column family handle
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for the key-value pair, you can provide -1 for no ttl
+ * @param callback the completion callback, can be NULL
+ * @param arg the argument for the callback
+ * @return error or NULL
+ */
+tidesdb_err_t *tidesdb_put_async(tidesdb_async_t *async, tidesdb_cf_handle_t *handle,
+                                 const uint8_t *key, size_t key_size, const uint8_t *value,
+                                 size_t value_size, time_t ttl, tidesdb_async_callback_t callback,
+                                 void *arg);
+
+/* internal functions */
+
+/*
+ * _tidesdb_async_job_new
+ * create an async job, copying the keys and the value
+ * @param op_code the operation code
+ * @param cf the column family, a reference is taken for the job
+ * @param keys the keys
+ * @param key_sizes the sizes of the keys
+ * @param num_keys the number of keys
+ * @param value the value for a put, NULL for gets
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for a put
+ * @param callback the completion callback
+ * @param arg the argument for the callback
+ * @return the job or NULL if allocation failed
+ */
+tidesdb_async_job_t *_tidesdb_async_job_new(TIDESDB_ASYNC_OP_CODE op_code,
+                                            tidesdb_column_family_t *cf, const uint8_t **keys,
+                                            const size_t *key_sizes, int num_keys,
+                                            const uint8_t *value, size_t value_size, time_t ttl,
+                                            tidesdb_async_callback_t callback, void *arg);
+
+/*
+ * _tidesdb_async_job_free
+ * free an async job and release its column family reference
+ * @param job the job
+ */
+void _tidesdb_async_job_free(tidesdb_async_job_t *job);
+
+/*
+ * _tidesdb_async_submit
+ * queue a job, waiting while the queue is full
+ * @param async the async context
+ * @param job the job
+ * @return error or NULL
+ */
+tidesdb_err_t *_tidesdb_async_submit(tidesdb_async_t *async, tidesdb_async_job_t *job);
+
+/*
+ * _tidesdb_async_run_job
+ * run a job and call its callback for each key
+ * @param job the job
+ */
+void _tidesdb_async_run_job(tidesdb_async_job_t *job);
+
+/*
+ * _tidesdb_async_worker
+ * worker thread for an async context, runs jobs until the context is closed and drained
+ * @param arg the async context
+ * @return NULL
+ */
+void *_tidesdb_async_worker(void *arg);
+
+/*
+ * _tidesdb_async_stop_workers
+ * stop and join the first num_threads workers of an async context
+ * @param async the async context
+ * @param num_threads the number of started workers
+ */
+void _tidesdb_async_stop_workers(tidesdb_async_t *async, int num_threads);
+
+/*
+ * _tidesdb_get_column_family
+ * get a column family by name
+ * @param tdb the TidesDB instance
+ * @param name the name of the column family
+ * @param cf the column family we found
+ * @return 0 if the column family was found, -1 if not
+ */
+int _tidesdb_get_column_family(tidesdb_t *tdb, const char *name, tidesdb_column_family_t **cf);
+
+/*
+ * _tidesdb_acquire_column_family
+ * get a column family by name and take a reference on it under the db read lock
+ * @param tdb the TidesDB instance
+ * @param name the name of the column family
+ * @param cf the column family we found
+ * @return error or NULL
+ */
+tidesdb_err_t *_tidesdb_acquire_column_family(tidesdb_t *tdb, const char *name,
+                                              tidesdb_column_family_t **cf);
+
+/*
+ * _tidesdb_ref_column_family
+ * take a reference on a column family
+ * @param cf the column family
+ */
+void _tidesdb_ref_column_family(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_release_column_family
+ * release a reference on a column family, freeing it if it was the last one
+ * @param cf the column family
+ */
+void _tidesdb_release_column_family(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_free_column_family
+ * free's and closes a column family
+ * @param cf the column family
+ */
+void _tidesdb_free_column_family(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_put
+ * put a key-value pair into a column family
+ * @param cf the column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for the key-value pair
+ * @return TIDESDB_SUCCESS or an error code
+ */
+int _tidesdb_put(tidesdb_column_family_t *cf, const uint8_t *key, size_t key_size,
+                 const uint8_t *value, size_t value_size, time_t ttl);
+
+/*
+ * _tidesdb_get
+ * get a value from a column family
+ * @param cf the column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @return TIDESDB_SUCCESS or an error code
+ */
+int _tidesdb_get(tidesdb_column_family_t *cf, const uint8_t *key, size_t key_size,
+                 uint8_t **value, size_t *value_size);
+
+/*
+ * _tidesdb_get_value
+ * look a key up in the memtable then the sstables from newest to oldest, _tidesdb_get wraps it
+ * to record the statistics of the get
+ * @param cf the column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @return TIDESDB_SUCCESS or an error code
+ */
+int _tidesdb_get_value(tidesdb_column_family_t *cf, const uint8_t *key, size_t key_size,
+                       uint8_t **value, size_t *value_size);
+
+/*
+ * _tidesdb_write_stall
+ * delay or stop a write to a column family whose sstables have piled up, must be called without
+ * holding column family locks so flushes and compactions can make progress
+ * @param cf the column family
+ * @return TIDESDB_SUCCESS or TIDESDB_ERR_WRITE_STALLED if no compaction brought the sstable count
+ * below the hard limit in time
+ */
+int _tidesdb_write_stall(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_now_ns
+ * get the monotonic time in nanoseconds
+ * @return the time
+ */
+uint64_t _tidesdb_now_ns();
+
+/*
+ * _tidesdb_stats_new
+ * allocate zeroed statistics for a column family
+ * @return the statistics, TDB_STATS_SHARDS shards, or NULL
+ */
+tidesdb_stats_shard_t *_tidesdb_stats_new();
+
+/*
+ * _tidesdb_stats_shard
+ * get the shard of the calling thread, threads are handed shards round robin on first use
+ * @param stats the statistics
+ * @return the shard
+ */
+tidesdb_stats_shard_t *_tidesdb_stats_shard(tidesdb_stats_shard_t *stats);
+
+/*
+ * _tidesdb_stats_add
+ * add to a counter
+ * @param stats the statistics, can be NULL
+ * @param stat the counter
+ * @param n the amount to add
+ */
+void _tidesdb_stats_add(tidesdb_stats_shard_t *stats, TIDESDB_STAT stat, uint64_t n);
+
+/*
+ * _tidesdb_stats_sub
+ * subtract from a gauge
+ * @param stats the statistics, can be NULL
+ * @param stat the gauge
+ * @param n the amount to subtract
+ */
+void _tidesdb_stats_sub(tidesdb_stats_shard_t *stats, TIDESDB_STAT stat, uint64_t n);
+
+/*
+ * _tidesdb_stats_record
+ * record a latency
+ * @param stats the statistics, can be NULL
+ * @param latency the histogram
+ * @param start when the operation started, from _tidesdb_now_ns
+ */
+void _tidesdb_stats_record(tidesdb_stats_shard_t *stats, TIDESDB_LATENCY latency, uint64_t start);
+
+/*
+ * _tidesdb_stats_collect
+ * sum the shards of the statistics of a column family
+ * @param cf the column family
+ * @param out the summed statistics
+ */
+void _tidesdb_stats_collect(tidesdb_column_family_t *cf, tidesdb_stats_t *out);
+
+/*
+ * _tidesdb_sstable_stats
+ * get the statistics of each SSTable in the current version of a column family
+ * @param cf the column family
+ * @param stats the statistics, allocated for the caller to free
+ * @param num_sstables the number of SSTables
+ * @return error or NULL
+ */
+tidesdb_err_t *_tidesdb_sstable_stats(tidesdb_column_family_t *cf, tidesdb_sstable_stats_t **stats,
+                                      int *num_sstables);
+
+/*
+ * _tidesdb_set_bloom_stats
+ * record the size and fill of the bloom filter of an SSTable the first time it is seen
+ * @param sst the SSTable
+ * @param bf the bloom filter
+ */
+void _tidesdb_set_bloom_stats(tidesdb_sstable_t *sst, bloom_filter_t *bf);
+
+/*
+ * _tidesdb_set_fuse_stats
+ * record the size of the binary fuse filter of an SSTable the first time it is seen
+ * @param sst the SSTable
+ * @param ff the binary fuse filter
+ */
+void _tidesdb_set_fuse_stats(tidesdb_sstable_t *sst, fuse_filter_t *ff);
+
+/*
+ * _tidesdb_filter_contains
+ * checks a key against the serialized filter block of an SSTable, the filter is counted into the
+ * memory of the column family while it is held and its statistics are set
+ * @param cf the column family, its config says the kind of filter
+ * @param sst the SSTable the block belongs to
+ * @param data the filter block
+ * @param size the size of the filter block
+ * @param key the key
+ * @param key_size the size of the key
+ * @return 1 if the key may be in the SSTable, 0 if not, -1 if the filter could not be read
+ */
+int _tidesdb_filter_contains(tidesdb_column_family_t *cf, tidesdb_sstable_t *sst,
+                             const uint8_t *data, size_t size, const uint8_t *key,
+                             size_t key_size);
+
+/*
+ * _tidesdb_account_memtable
+ * count a change of a memtable shard size into the column family and database totals
+ * @param cf the column family
+ * @param before the size of the shard before the change
+ * @param after the size of the shard after the change
+ */
+void _tidesdb_account_memtable(tidesdb_column_family_t *cf, size_t before, size_t after);
+
+/*
+ * _tidesdb_flush_over_budget
+ * flush the column family holding the most memtable bytes if the memtables of the database are
+ * over the write buffer budget, must be called without holding column family locks
+ * @param tdb the TidesDB instance
+ * @return 0 if nothing had to be flushed or the flush succeeded, -1 if not
+ */
+int _tidesdb_flush_over_budget(tidesdb_t *tdb);
+
+/*
+ * _tidesdb_txn_op_size
+ * get the memory held by the operation and rollback operation of a transaction operation
+ * @param op the transaction operation
+ * @return the size in bytes
+ */
+size_t _tidesdb_txn_op_size(tidesdb_txn_op_t *op);
+
+/*
+ * _tidesdb_perf_start
+ * start a perf context timer
+ * @return the time, 0 if the perf context of the calling thread is disabled
+ */
+uint64_t _tidesdb_perf_start();
+
+/*
+ * _tidesdb_perf_stop
+ * stop a perf context timer
+ * @param timer the timer
+ * @param start what _tidesdb_perf_start returned
+ */
+void _tidesdb_perf_stop(TIDESDB_PERF_TIMER timer, uint64_t start);
+
+/*
+ * _tidesdb_trace
+ * call the tracing callback of the database of a column family if there is one
+ * @param cf the column family
+ * @param event the span
+ * @param begin whether the span begins or ends
+ */
+void _tidesdb_trace(tidesdb_column_family_t *cf, TIDESDB_TRACE_EVENT event, bool begin);
+
+/*
+ * _tidesdb_listener
+ * get the event listener of the database of a column family
+ * @param cf the column family
+ * @return the event listener, NULL if the column family isn't part of a database yet
+ */
+const tidesdb_event_listener_t *_tidesdb_listener(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_stall_condition
+ * get the write stall condition for an sstable count
+ * @param tdb the TidesDB instance
+ * @param num_sstables the sstable count of a column family
+ * @return the condition
+ */
+TIDESDB_STALL_CONDITION _tidesdb_stall_condition(tidesdb_t *tdb, int num_sstables);
+
+/*
+ * _tidesdb_update_stall_condition
+ * report a change of the write stall condition of a column family to the event listener, called
+ * after a version is installed once every column family lock is released
+ * @param cf the column family
+ */
+void _tidesdb_update_stall_condition(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_background_error
+ * report a failed flush or compaction to the event listener
+ * @param cf the column family
+ * @param op the operation that failed
+ * @param code the error code
+ */
+void _tidesdb_background_error(tidesdb_column_family_t *cf, TIDESDB_BACKGROUND_OP op,
+                               TIDESDB_ERR_CODE code);
+
+/*
+ * _tidesdb_wal_sync_hook
+ * the sync hook of the write-ahead logs, traces their syncs
+ * @param arg the column family
+ * @param begin whether the sync begins or ends
+ */
+void _tidesdb_wal_sync_hook(void *arg, bool begin);
+
+/*
+ * _tidesdb_delete
+ * delete a key-value pair from a column family
+ * @param cf the column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @return TIDESDB_SUCCESS or an error code
+ */
+int _tidesdb_delete(tidesdb_column_family_t *cf, const uint8_t *key, size_t key_size);
+
+/*
+ * _tidesdb_compact_sstables
+ * pairs and merges sstables in a column family
+ * @param cf the column family
+ * @param max_threads the maximum number of pair merges to run at once on the background pool
+ * @return error or NULL
+ */
+tidesdb_err_t *_tidesdb_compact_sstables(tidesdb_column_family_t *cf, int max_threads);
+
+/*
+ * _tidesdb_txn_begin
+ * begin a transaction on a column family
+ * @param tdb the TidesDB instance
+ * @param cf the column family
+ * @param txn the transaction to begin
+ * @return error or NULL
+ */
+tidesdb_err_t *_tidesdb_txn_begin(tidesdb_t *tdb, tidesdb_column_family_t *cf, tidesdb_txn_t **txn);
+
+/*
+ * _tidesdb_txn_commit
+ * commit a transaction, tidesdb_txn_commit wraps it to record the statistics of the commit
+ * @param txn the transaction
+ * @return error or NULL
+ */
+tidesdb_err_t *_tidesdb_txn_commit(tidesdb_txn_t *txn);
+
+/*
+ * _tidesdb_cursor_init
+ * initialize a new cursor on a column family
+ * @param tdb the TidesDB instance
+ * @param cf the column family
+ * @param cursor the TidesDB cursor
+ * @return error or NULL
+ */
+tidesdb_err_t *_tidesdb_cursor_init(tidesdb_t *tdb, tidesdb_column_family_t *cf,
+                                    tidesdb_cursor_t **cursor);
+
+/*
+ * _tidesdb_cursor_source_from_memtable
+ * set up a cursor source over a sorted copy of the memtable shards of a column family, the caller
+ * holds the column family lock
+ * @param cf the column family
+ * @param source the cursor source
+ * @return 0 if the source was set up, -1 if not
+ */
+int _tidesdb_cursor_source_from_memtable(tidesdb_column_family_t *cf,
+                                         tidesdb_cursor_source_t *source);
+
+/*
+ * _tidesdb_cursor_merge_memtable
+ * copies the skip list memtable shards into the entries of a cursor source in key order, merging
+ * the shards as they are read, the caller holds every shard lock
+ * @param cf the column family
+ * @param source the cursor source, its entries have room for count entries
+ * @param count the number of entries in the shards
+ * @return 0 if the entries were copied, -1 if not
+ */
+int _tidesdb_cursor_merge_memtable(tidesdb_column_family_t *cf, tidesdb_cursor_source_t *source,
+                                   int count);
+
+/*
+ * _tidesdb_cursor_sort_memtable
+ * copies the hash table memtable shards into the entries of a cursor source and sorts them, the
+ * caller holds every shard lock
+ * @param cf the column family
+ * @param source the cursor source, its entries have room for count entries
+ * @param count the number of entries in the shards
+ * @return 0 if the entries were copied, -1 if not
+ */
+int _tidesdb_cursor_sort_memtable(tidesdb_column_family_t *cf, tidesdb_cursor_source_t *source,
+                                  int count);
+
+/*
+ * _tidesdb_compare_key_value_pairs
+ * compares two key value pair pointers by key for sorting
+ * @param a the first key value pair pointer
+ * @param b the second key value pair pointer
+ * @return the comparison
+ */
+int _tidesdb_compare_key_value_pairs(const void *a, const void *b);
 
 /*
- * tidesdb_txn_free
- * free a transaction and its operations
- * @param txn the transaction
- * @return error or NULL
+ * _tidesdb_cursor_source_from_sstable
+ * set up a cursor source over an sstable
+ * @param cf the column family
+ * @param source the cursor source
+ * @param sst the sstable, the source holds a reference on it
+ * @return 0 if the source was set up, -1 if not
  */
-tidesdb_err_t *tidesdb_txn_free(tidesdb_txn_t *txn);
+int _tidesdb_cursor_source_from_sstable(tidesdb_column_family_t *cf,
+                                        tidesdb_cursor_source_t *source, tidesdb_sstable_t *sst);
 
 /*
- * tidesdb_cursor_init
- * initialize a new TidesDB cursor
- * @param tdb the TidesDB instance
- * @param column_family_name the name of the column family
+ * _tidesdb_cursor_source_seek
+ * move a cursor source to the entry at an index
  * @param cursor the TidesDB cursor
- * @return error or NULL
+ * @param source the cursor source
+ * @param index the index of the entry
+ * @return 0 if the source is on the entry, 1 if the index is out of range, -1 on error
  */
-tidesdb_err_t *tidesdb_cursor_init(tidesdb_t *tdb, const char *column_family_name,
-                                   tidesdb_cursor_t **cursor);
+int _tidesdb_cursor_source_seek(tidesdb_cursor_t *cursor, tidesdb_cursor_source_t *source,
+                                int index);
 
 /*
- * tidesdb_cursor_next
- * move the cursor to the next key-value pair
+ * _tidesdb_cursor_find_forward
+ * put the cursor on the smallest live key of its sources, moving shadowed and deleted entries
+ * forward
  * @param cursor the TidesDB cursor
- * @return error or NULL
+ * @return 0 if the cursor is on an entry, 1 if there are no entries left, -1 on error
  */
-tidesdb_err_t *tidesdb_cursor_next(tidesdb_cursor_t *cursor);
+int _tidesdb_cursor_find_forward(tidesdb_cursor_t *cursor);
 
 /*
- * tidesdb_cursor_prev
- * move the cursor to the previous key-value pair
+ * _tidesdb_cursor_find_backward
+ * put the cursor on the largest live key of its sources, moving shadowed and deleted entries
+ * backward
  * @param cursor the TidesDB cursor
- * @return error or NULL
+ * @return 0 if the cursor is on an entry, 1 if there are no entries left, -1 on error
  */
-tidesdb_err_t *tidesdb_cursor_prev(tidesdb_cursor_t *cursor);
+int _tidesdb_cursor_find_backward(tidesdb_cursor_t *cursor);
 
 /*
- * tidesdb_cursor_get
- * get the current key-value pair from the cursor
+ * _tidesdb_cursor_set_direction
+ * reposition the sources of a cursor for moving in a direction
  * @param cursor the TidesDB cursor
- * @param key the key
- * @param key_size the size of the key
- * @param value the value
- * @param value_size the size of the value
- * @return error or NULL
+ * @param forward whether the cursor will move forward
+ * @return 0 if the sources were repositioned, -1 on error
  */
-tidesdb_err_t *tidesdb_cursor_get(tidesdb_cursor_t *cursor, uint8_t **key, size_t *key_size,
-                                  uint8_t **value, size_t *value_size);
+int _tidesdb_cursor_set_direction(tidesdb_cursor_t *cursor, bool forward);
 
 /*
- * tidesdb_cursor_free
- * free the memory for the cursor
+ * _tidesdb_cursor_move
+ * move the cursor to the next or previous live key, the cursor stays put at either end
  * @param cursor the TidesDB cursor
- * @return error or NULL
+ * @param forward whether to move forward
+ * @return 0 if the cursor moved, 1 if there is no entry in that direction, -1 on error
  */
-tidesdb_err_t *tidesdb_cursor_free(tidesdb_cursor_t *cursor);
+int _tidesdb_cursor_move(tidesdb_cursor_t *cursor, bool forward);
 
 /*
- * tidesdb_list_column_families
- * list the column families in TidesDB
- * @param tdb the TidesDB instance
- * @return the column families
+ * _tidesdb_cursor_source_seek_key
+ * move a cursor source to its first entry with a key at or past the given key, entries whose
+ * position is already known are binary searched before reading further into an sstable
+ * @param cursor the TidesDB cursor
+ * @param source the source
+ * @param key the key
+ * @param key_size the size of the key
+ * @return 0 if the source is on an entry, 1 if it has no entry at or past the key, -1 on error
  */
-char *tidesdb_list_column_families(tidesdb_t *tdb);
-
-/* internal functions */
+int _tidesdb_cursor_source_seek_key(tidesdb_cursor_t *cursor, tidesdb_cursor_source_t *source,
+                                    const uint8_t *key, size_t key_size);
 
 /*
- * _tidesdb_get_column_family
- * get a column family by name
- * @param tdb the TidesDB instance
- * @param name the name of the column family
- * @param cf the column family we found
- * @return 0 if the column family was found, -1 if not
+ * _tidesdb_cursor_free_sources
+ * free the sources of a cursor
+ * @param cursor the TidesDB cursor
  */
-int _tidesdb_get_column_family(tidesdb_t *tdb, const char *name, tidesdb_column_family_t **cf);
+void _tidesdb_cursor_free_sources(tidesdb_cursor_t *cursor);
 
 /*
  * _tidesdb_new_column_family
@@ -506,12 +2300,19 @@ int _tidesdb_get_column_family(tidesdb_t *tdb, const char *name, tidesdb_column_
  * @param compress_algo the compression algorithm to use if you want to compress the column family
  * @param bloom_filter whether the column family should use a bloom filter
  * @param memtable_ds the data structure for the memtable
+ * @param memtable_shards the number of memtable shards
+ * @param filter_type the kind of filter written when bloom_filter is set
+ * @param partitioned_index whether sstables are written with partitions under a top level index
+ * @param hash_index whether the partitions get a hash index of their keys
+ * @param learned_index whether the partitions get a learned index of their keys
  * @return 0 if the column family was created, -1 if not
  */
 int _tidesdb_new_column_family(const char *db_path, const char *name, int flush_threshold,
                                int max_level, float probability, tidesdb_column_family_t **cf,
                                bool compressed, tidesdb_compression_algo_t compress_algo,
-                               bool bloom_filter, tidesdb_memtable_ds_t memtable_ds);
+                               bool bloom_filter, tidesdb_memtable_ds_t memtable_ds,
+                               int memtable_shards, tidesdb_filter_type_t filter_type,
+                               bool partitioned_index, bool hash_index, bool learned_index);
 
 /*
  * _tidesdb_add_column_family
@@ -556,14 +2357,15 @@ int _tidesdb_append_to_wal(tidesdb_wal_t *wal, const uint8_t *key, size_t key_si
 
 /*
  * _tidesdb_open_wal
- * open the write-ahead log
+ * open the write-ahead log of a memtable shard
  * @param cf_path the path to the column family
+ * @param shard the index of the shard, shard 0 uses the unsuffixed wal file
  * @param w the write-ahead log
  * @param compress whether to compress the wal
  * @param compress_algo the compression algorithm to use
  * @return 0 if the wal was opened, -1 if not
  */
-int _tidesdb_open_wal(const char *cf_path, tidesdb_wal_t **w, bool compress,
+int _tidesdb_open_wal(const char *cf_path, int shard, tidesdb_wal_t **w, bool compress,
                       tidesdb_compression_algo_t compress_algo);
 
 /*
@@ -583,11 +2385,130 @@ int _tidesdb_truncate_wal(tidesdb_wal_t *wal);
 
 /*
  * _tidesdb_replay_from_wal
- * replay the write-ahead log and populate column family memtable
+ * replay the write-ahead log of a memtable shard and populate the shard memtable
  * @param cf the column family
+ * @param shard the memtable shard
  * @return 0 if the wal was replayed, -1 if not
  */
-int _tidesdb_replay_from_wal(tidesdb_column_family_t *cf);
+int _tidesdb_replay_from_wal(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard);
+
+/*
+ * _tidesdb_open_shards
+ * create the memtable shards of a column family and open their write-ahead logs
+ * @param cf the column family
+ * @return 0 if the shards were opened, -1 if not
+ */
+int _tidesdb_open_shards(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_close_shards
+ * free the memtable shards of a column family and close their write-ahead logs
+ * @param cf the column family
+ */
+void _tidesdb_close_shards(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_get_shard
+ * get the memtable shard a key hashes to
+ * @param cf the column family
+ * @param key the key
+ * @param key_size the size of the key
+ * @return the memtable shard
+ */
+tidesdb_memtable_shard_t *_tidesdb_get_shard(tidesdb_column_family_t *cf, const uint8_t *key,
+                                             size_t key_size);
+
+/*
+ * _tidesdb_memtable_put
+ * put a key-value pair into the memtable of a shard
+ * @param cf the column family
+ * @param shard the memtable shard
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @param ttl the time-to-live for the key-value pair
+ * @return 0 if the key-value pair was put, -1 if not
+ */
+int _tidesdb_memtable_put(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard,
+                          const uint8_t *key, size_t key_size, const uint8_t *value,
+                          size_t value_size, time_t ttl);
+
+/*
+ * _tidesdb_memtable_get
+ * get a value from the memtable of a shard
+ * @param cf the column family
+ * @param shard the memtable shard
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value
+ * @param value_size the size of the value
+ * @return 0 if the key was found, -1 if not
+ */
+int _tidesdb_memtable_get(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard,
+                          const uint8_t *key, size_t key_size, uint8_t **value, size_t *value_size);
+
+/*
+ * _tidesdb_memtable_size
+ * get the size of the memtable of a shard
+ * @param cf the column family
+ * @param shard the memtable shard
+ * @return the size of the memtable in bytes
+ */
+size_t _tidesdb_memtable_size(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard);
+
+/*
+ * _tidesdb_memtable_clear
+ * clear the memtable of a shard
+ * @param cf the column family
+ * @param shard the memtable shard
+ * @return 0 if the memtable was cleared, -1 if not
+ */
+int _tidesdb_memtable_clear(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard);
+
+/*
+ * _tidesdb_shard_full
+ * checks if a shard has reached its part of the column family flush threshold
+ * @param cf the column family
+ * @param shard the memtable shard
+ * @return true if the shard is full, false if not
+ */
+bool _tidesdb_shard_full(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard);
+
+/*
+ * _tidesdb_any_shard_full
+ * checks if any shard of a column family is full
+ * @param cf the column family
+ * @return true if a shard is full, false if not
+ */
+bool _tidesdb_any_shard_full(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_memtable_copy_into
+ * copy the entries of the memtable of a shard into a skip list
+ * @param cf the column family
+ * @param shard the memtable shard
+ * @param list the skip list to copy into
+ * @return 0 if the entries were copied, -1 if not
+ */
+int _tidesdb_memtable_copy_into(tidesdb_column_family_t *cf, tidesdb_memtable_shard_t *shard,
+                                skip_list_t *list);
+
+/*
+ * _tidesdb_memtable_snapshot
+ * copy every memtable shard of a column family into a new sorted skip list
+ * @param cf the column family
+ * @return the skip list or NULL on error
+ */
+skip_list_t *_tidesdb_memtable_snapshot(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_flush_memtable_if_full
+ * takes the column family write lock and flushes the memtable if a shard is still full
+ * @param cf the column family
+ * @return 0 if the memtable was flushed or did not need to be, -1 on error
+ */
+int _tidesdb_flush_memtable_if_full(tidesdb_column_family_t *cf);
 
 /*
  * _tidesdb_free_sstable
@@ -598,47 +2519,406 @@ int _tidesdb_replay_from_wal(tidesdb_column_family_t *cf);
 int _tidesdb_free_sstable(tidesdb_sstable_t *sst);
 
 /*
- * _tidesdb_compare_sstables
- * compare two sstables
- * @param a the first sstable
- * @param b the second sstable
+ * _tidesdb_open_sstable
+ * opens the SSTable file with the given id in the column family directory
+ * @param cf the column family
+ * @param id the id of the SSTable
+ * @param sst the opened SSTable, returned with a reference held by the caller
+ * @return 0 if the SSTable was opened, -1 if not
+ */
+int _tidesdb_open_sstable(tidesdb_column_family_t *cf, uint64_t id, tidesdb_sstable_t **sst);
+
+/*
+ * _tidesdb_ref_sstable
+ * takes a reference on an SSTable
+ * @param sst the SSTable
+ */
+void _tidesdb_ref_sstable(tidesdb_sstable_t *sst);
+
+/*
+ * _tidesdb_release_sstable
+ * releases a reference on an SSTable, the last reference closes it and removes the file if the
+ * SSTable is obsolete
+ * @param sst the SSTable
+ */
+void _tidesdb_release_sstable(tidesdb_sstable_t *sst);
+
+/*
+ * _tidesdb_sstable_size
+ * get the size of an sstable file
+ * @param sst the sstable
+ * @return the size in bytes, 0 if it can't be read
+ */
+uint64_t _tidesdb_sstable_size(tidesdb_sstable_t *sst);
+
+/*
+ * _tidesdb_version_new
+ * creates a version holding a reference on each of the given SSTables
+ * @param sstables the SSTables, oldest first
+ * @param num_sstables the number of SSTables
+ * @return the new version with a reference held by the caller, NULL on failure
+ */
+tidesdb_version_t *_tidesdb_version_new(tidesdb_sstable_t **sstables, int num_sstables);
+
+/*
+ * _tidesdb_release_version
+ * releases a reference on a version, the last reference releases its SSTables and frees it
+ * @param version the version
+ */
+void _tidesdb_release_version(tidesdb_version_t *version);
+
+/*
+ * _tidesdb_acquire_version
+ * pins the current version of a column family
+ * @param cf the column family
+ * @return the current version, release with _tidesdb_release_version
+ */
+tidesdb_version_t *_tidesdb_acquire_version(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_install_version
+ * persists the manifest for a version and makes it the current version of the column family
+ * must be called with the column family version lock held
+ * @param cf the column family
+ * @param version the new version, the column family takes over the caller's reference
+ * @return 0 if the version was installed, -1 if not
+ */
+int _tidesdb_install_version(tidesdb_column_family_t *cf, tidesdb_version_t *version);
+
+/*
+ * _tidesdb_write_manifest
+ * writes the ids of the SSTables in a version to the column family manifest
+ * the manifest is written to a temporary file, synced and renamed over the old one
+ * @param cf the column family
+ * @param version the version to write
+ * @return 0 if the manifest was written, -1 if not
+ */
+int _tidesdb_write_manifest(tidesdb_column_family_t *cf, tidesdb_version_t *version);
+
+/*
+ * _tidesdb_next_sstable_id
+ * allocates the id for a new SSTable
+ * @param cf the column family
+ * @return the id
+ */
+uint64_t _tidesdb_next_sstable_id(tidesdb_column_family_t *cf);
+
+/*
+ * _tidesdb_parse_sstable_id
+ * parses the id out of an SSTable file name
+ * @param name the file name
+ * @param id the parsed id
+ * @return 0 if the name is an SSTable file name, -1 if not
+ */
+int _tidesdb_parse_sstable_id(const char *name, uint64_t *id);
+
+/*
+ * _tidesdb_compare_sstable_ids
+ * compares two SSTable ids for sorting
+ * @param a the first id
+ * @param b the second id
  * @return the comparison
  */
-int _tidesdb_compare_sstables(const void *a, const void *b);
+int _tidesdb_compare_sstable_ids(const void *a, const void *b);
+
+/*
+ * _tidesdb_write_bloom_filter_block
+ * writes a bloom filter of the keys in a range of a skip list as the first block of an SSTable, the
+ * filter is sized for the keys that will be written
+ * @param cf the column family, the filter is counted into its memory while it is built
+ * @param list the skip list
+ * @param start the first node of the range, NULL for the start of the skip list
+ * @param end the node past the range, NULL for the end of the skip list
+ * @param drop_deleted whether the SSTable drops tombstones and expired keys, they are left out
+ * @param sst the SSTable to write the block to, its bloom filter statistics are set
+ * @return 0 if the block was written, -1 if not
+ */
+int _tidesdb_write_bloom_filter_block(tidesdb_column_family_t *cf, skip_list_t *list,
+                                      skip_list_node_t *start, skip_list_node_t *end,
+                                      bool drop_deleted, tidesdb_sstable_t *sst);
+
+/*
+ * _tidesdb_write_fuse_filter_block
+ * writes a binary fuse filter of the keys in a range of a skip list as the first block of an
+ * SSTable, built from the keys that will be written
+ * @param cf the column family, the filter is counted into its memory while it is built
+ * @param list the skip list
+ * @param start the first node of the range, NULL for the start of the skip list
+ * @param end the node past the range, NULL for the end of the skip list
+ * @param drop_deleted whether the SSTable drops tombstones and expired keys, they are left out
+ * @param sst the SSTable to write the block to, its filter statistics are set
+ * @return 0 if the block was written, -1 if not
+ */
+int _tidesdb_write_fuse_filter_block(tidesdb_column_family_t *cf, skip_list_t *list,
+                                     skip_list_node_t *start, skip_list_node_t *end,
+                                     bool drop_deleted, tidesdb_sstable_t *sst);
+
+/*
+ * _tidesdb_partition_add
+ * records a key value block written to a partitioned SSTable, closing the open partition once it
+ * holds TDB_SSTABLE_PARTITION_ENTRIES keys
+ * @param cf the column family
+ * @param builder the partition builder
+ * @param key the key of the block, it has to stay valid until the partition is closed
+ * @param key_size the size of the key
+ * @param block_size the size of the block on disk including its size prefix
+ * @return 0 if successful, -1 if not
+ */
+int _tidesdb_partition_add(tidesdb_column_family_t *cf, tidesdb_partition_builder_t *builder,
+                           const uint8_t *key, size_t key_size, uint64_t block_size);
+
+/*
+ * _tidesdb_close_partition
+ * closes the open partition of a partitioned SSTable, its last key is copied into the index and
+ * its filter and hash index are built and kept until the SSTable is finished
+ * @param cf the column family, its config says whether and which filter to build
+ * @param builder the partition builder
+ * @return 0 if successful, -1 if not
+ */
+int _tidesdb_close_partition(tidesdb_column_family_t *cf, tidesdb_partition_builder_t *builder);
+
+/*
+ * _tidesdb_finish_partitioned_sstable
+ * writes the partition filters and hash indexes, the top level index and the footer after the key
+ * value blocks of a partitioned SSTable, the index is handed to the SSTable so it is never read
+ * back
+ * @param cf the column family
+ * @param builder the partition builder
+ * @param sst the SSTable
+ * @return 0 if successful, -1 if not
+ */
+int _tidesdb_finish_partitioned_sstable(tidesdb_column_family_t *cf,
+                                        tidesdb_partition_builder_t *builder,
+                                        tidesdb_sstable_t *sst);
+
+/*
+ * _tidesdb_free_partition_builder
+ * frees what a partition builder still holds
+ * @param cf the column family the filters are counted into
+ * @param builder the partition builder
+ */
+void _tidesdb_free_partition_builder(tidesdb_column_family_t *cf,
+                                     tidesdb_partition_builder_t *builder);
+
+/*
+ * _tidesdb_build_hash_index
+ * builds the hash index of the open partition of a partitioned SSTable, a linear probing table of
+ * keys hashed with TDB_HASH_INDEX_SEED whose slots hold a 16 bit tag of the key and the offset of
+ * its key value block from the start of the partition
+ * @param builder the partition builder
+ * @param out_size the size of the serialized hash index
+ * @return the serialized hash index, NULL on failure or if the partition is too large for it
+ */
+uint8_t *_tidesdb_build_hash_index(tidesdb_partition_builder_t *builder, size_t *out_size);
+
+/*
+ * _tidesdb_hash_index_lookup
+ * probes a serialized partition hash index for a key
+ * @param data the hash index block
+ * @param size the size of the hash index block
+ * @param key the key
+ * @param key_size the size of the key
+ * @return the offset of the only key value block that can hold the key from the start of the
+ * partition, TDB_HASH_INDEX_EMPTY if the key is not in the partition or TDB_HASH_INDEX_COLLISION if
+ * more than one block can and the partition has to be scanned
+ */
+uint32_t _tidesdb_hash_index_lookup(const uint8_t *data, size_t size, const uint8_t *key,
+                                    size_t key_size);
+
+/*
+ * _tidesdb_learned_index_key
+ * reads the 8 bytes of a key after a prefix as a big endian integer, shorter keys are padded with
+ * zeros so keys sharing the prefix keep their order
+ * @param key the key
+ * @param key_size the size of the key
+ * @param prefix_size the size of the prefix to skip
+ * @return the key as an integer
+ */
+uint64_t _tidesdb_learned_index_key(const uint8_t *key, size_t key_size, size_t prefix_size);
+
+/*
+ * _tidesdb_build_learned_index
+ * fits the learned index of the open partition of a partitioned SSTable, segments of at most
+ * TDB_LEARNED_INDEX_SEGMENT_ENTRIES key value blocks whose lines put every key within
+ * TDB_LEARNED_INDEX_ERROR blocks of its position.  a partition whose keys don't read as distinct
+ * integers gets no learned index
+ * @param builder the partition builder
+ * @param partition the partition the learned index is set on
+ * @return 0 on success, -1 on failure
+ */
+int _tidesdb_build_learned_index(tidesdb_partition_builder_t *builder,
+                                 tidesdb_sstable_partition_t *partition);
+
+/*
+ * _tidesdb_learned_index_lookup
+ * predicts the key value blocks of a partition that can hold a key from its learned index
+ * @param partition the partition
+ * @param key the key
+ * @param key_size the size of the key
+ * @param offset the offset of the segment the key falls in from the start of the partition
+ * @param skip the key value blocks to skip from the start of the segment
+ * @param count the key value blocks to read after those
+ * @return 0 if the key can only be in the predicted blocks, 1 if it is not in the partition, -1 if
+ * the partition has no learned index
+ */
+int _tidesdb_learned_index_lookup(tidesdb_sstable_partition_t *partition, const uint8_t *key,
+                                  size_t key_size, uint64_t *offset, uint32_t *skip,
+                                  uint32_t *count);
+
+/*
+ * _tidesdb_serialize_sstable_index
+ * serializes the top level index of a partitioned SSTable
+ * @param index the index
+ * @param out_size the size of the serialized index
+ * @return the serialized index, NULL on failure
+ */
+uint8_t *_tidesdb_serialize_sstable_index(tidesdb_sstable_index_t *index, size_t *out_size);
+
+/*
+ * _tidesdb_deserialize_sstable_index
+ * deserializes the top level index of a partitioned SSTable, checking it stays within the data
+ * @param data the serialized index
+ * @param size the size of the serialized index
+ * @return the index, NULL if it could not be read
+ */
+tidesdb_sstable_index_t *_tidesdb_deserialize_sstable_index(const uint8_t *data, size_t size);
+
+/*
+ * _tidesdb_deserialize_learned_index
+ * reads the learned index of a partition from a serialized top level index
+ * @param partition the partition the learned index is set on
+ * @param ptr the position in the serialized index, moved past the learned index
+ * @param end the end of the serialized index
+ * @return 0 on success, -1 if the learned index is cut short or doesn't cover the partition
+ */
+int _tidesdb_deserialize_learned_index(tidesdb_sstable_partition_t *partition,
+                                       const uint8_t **ptr, const uint8_t *end);
+
+/*
+ * _tidesdb_free_sstable_index
+ * frees the top level index of a partitioned SSTable
+ * @param index the index
+ */
+void _tidesdb_free_sstable_index(tidesdb_sstable_index_t *index);
+
+/*
+ * _tidesdb_read_sstable_index
+ * reads the top level index of a partitioned SSTable through the footer at the end of its file
+ * @param bm the block manager of the SSTable
+ * @return the index, NULL if it could not be read
+ */
+tidesdb_sstable_index_t *_tidesdb_read_sstable_index(block_manager_t *bm);
+
+/*
+ * _tidesdb_set_sstable_index
+ * pins the top level index of a partitioned SSTable, if another thread got there first the given
+ * index is freed.  the filter statistics of the SSTable are taken from the index
+ * @param sst the SSTable
+ * @param index the index
+ * @return the pinned index
+ */
+tidesdb_sstable_index_t *_tidesdb_set_sstable_index(tidesdb_sstable_t *sst,
+                                                    tidesdb_sstable_index_t *index);
+
+/*
+ * _tidesdb_sstable_index
+ * gets the top level index of a partitioned SSTable, reading it on first use
+ * @param sst the SSTable
+ * @return the index, NULL if it could not be read
+ */
+tidesdb_sstable_index_t *_tidesdb_sstable_index(tidesdb_sstable_t *sst);
+
+/*
+ * _tidesdb_find_partition
+ * finds the partition of a partitioned SSTable that can hold a key, the first whose last key is
+ * not smaller than the key
+ * @param index the top level index
+ * @param key the key
+ * @param key_size the size of the key
+ * @return the partition, NULL if the key is past the last key of the SSTable
+ */
+tidesdb_sstable_partition_t *_tidesdb_find_partition(tidesdb_sstable_index_t *index,
+                                                     const uint8_t *key, size_t key_size);
+
+/*
+ * _tidesdb_write_sstable
+ * writes the entries of a skip list to a new SSTable with a bloom filter at the initial block if
+ * the column family has bloom filters enabled
+ * @param cf the column family
+ * @param list the skip list to write
+ * @param drop_deleted whether to drop tombstones and expired keys
+ * @param priority the rate limiter priority of the writes, high for flushes which are charged
+ * without waiting and low for compactions which wait for the budget
+ * @param sst the new SSTable, returned with a reference held by the caller
+ * @return 0 if the SSTable was written, -1 if not
+ */
+int _tidesdb_write_sstable(tidesdb_column_family_t *cf, skip_list_t *list, bool drop_deleted,
+                           rate_limiter_priority_t priority, tidesdb_sstable_t **sst);
+
+/*
+ * _tidesdb_write_sstable_range
+ * writes the entries in a range of a skip list to a new SSTable, see _tidesdb_write_sstable
+ * @param cf the column family
+ * @param list the skip list to write
+ * @param start the first node of the range, NULL for the start of the skip list
+ * @param end the node past the range, NULL for the end of the skip list
+ * @param drop_deleted whether to drop tombstones and expired keys
+ * @param priority the rate limiter priority of the writes
+ * @param sst the new SSTable, returned with a reference held by the caller
+ * @param dropped where the dropped tombstones and expired keys are counted, can be NULL
+ * @return 0 if the SSTable was written, -1 if not
+ */
+int _tidesdb_write_sstable_range(tidesdb_column_family_t *cf, skip_list_t *list,
+                                 skip_list_node_t *start, skip_list_node_t *end,
+                                 bool drop_deleted, rate_limiter_priority_t priority,
+                                 tidesdb_sstable_t **sst, tidesdb_dropped_t *dropped);
 
 /*
  * _tidesdb_flush_memtable
- * flushes a memtable to disk in an SSTable from a skip list memtable
+ * flushes a memtable to disk in an SSTable and installs a new version containing it, traced as a
+ * flush span
+ * must be called with the column family write lock held, the caller reports the flush with
+ * _tidesdb_report_flush once it released the lock
  * @param cf the column family
+ * @param info where the flush is described for the event listener, NULL if it isn't reported
  * @return 0 if the memtable was flushed, -1 if not
  */
-int _tidesdb_flush_memtable(tidesdb_column_family_t *cf);
+int _tidesdb_flush_memtable(tidesdb_column_family_t *cf, tidesdb_flush_info_t *info);
 
 /*
- * _tidesdb_flush_memtable_f_hash_table
- * flushes a memtable to disk in an SSTable from a hash table memtable
+ * _tidesdb_report_flush
+ * report a flush to the event listener along with the write stall change it caused, called
+ * without column family locks held so the callbacks may use the column family
  * @param cf the column family
- * @return 0 if the memtable was flushed, -1 if not
+ * @param info the flush as described by _tidesdb_flush_memtable
  */
-int _tidesdb_flush_memtable_f_hash_table(tidesdb_column_family_t *cf);
+void _tidesdb_report_flush(tidesdb_column_family_t *cf, const tidesdb_flush_info_t *info);
 
 /*
- * _tidesdb_flush_memtable_w_bloomfilter
- * flushes a memtable to disk in an SSTable with a bloom filter at initial block from a skip list
- * memtable
+ * _tidesdb_flush_memtable_to_sstable
+ * the work of _tidesdb_flush_memtable
  * @param cf the column family
+ * @param info where the id and size of the sstable written are stored
  * @return 0 if the memtable was flushed, -1 if not
  */
-int _tidesdb_flush_memtable_w_bloomfilter(tidesdb_column_family_t *cf);
+int _tidesdb_flush_memtable_to_sstable(tidesdb_column_family_t *cf, tidesdb_flush_info_t *info);
 
 /*
- * _tidesdb_flush_memtable_w_bloomfilter_f_hash_table
- * flushes a memtable to disk in an SSTable with a bloom filter at initial block from a hash table
- * memtable
+ * _tidesdb_get_from_sstable
+ * looks up a key in an SSTable
  * @param cf the column family
- * @return 0 if the memtable was flushed, -1 if not
+ * @param sst the SSTable
+ * @param key the key
+ * @param key_size the size of the key
+ * @param value the value, allocated if the key is found
+ * @param value_size the size of the value
+ * @param ttl when the found key expires, -1 for never
+ * @return 0 if the key was found, 1 if the key is deleted or expired, -1 if the key is not in the
+ * SSTable, -2 on allocation failure
  */
-int _tidesdb_flush_memtable_w_bloomfilter_f_hash_table(tidesdb_column_family_t *cf);
+int _tidesdb_get_from_sstable(tidesdb_column_family_t *cf, tidesdb_sstable_t *sst,
+                              const uint8_t *key, size_t key_size, uint8_t **value,
+                              size_t *value_size, int64_t *ttl);
 
 /*
  * _tidesdb_is_tombstone
@@ -657,14 +2937,6 @@ int _tidesdb_is_tombstone(const uint8_t *value, size_t value_size);
  */
 int _tidesdb_load_sstables(tidesdb_column_family_t *cf);
 
-/*
- * _tidesdb_sort_sstables
- * sort the sstables for a column family by last modified being last in the array
- * @param cf the column family
- * @return 0 if the sstables were sorted, -1 if not
- */
-int _tidesdb_sort_sstables(const tidesdb_column_family_t *cf);
-
 /*
  * _tidesdb_remove_directory
  * remove a directory and its contents
@@ -674,38 +2946,85 @@ int _tidesdb_sort_sstables(const tidesdb_column_family_t *cf);
 int _tidesdb_remove_directory(const char *path);
 
 /*
- * _tidesdb_compact_sstables_thread
- * a thread for compacting sstable pairs
- * @param arg the arguments for the thread in this case a compact_thread_args struct
+ * _tidesdb_compact_sstables_job
+ * a background pool job for compacting an sstable pair
+ * @param arg the arguments for the job in this case a compact_thread_args struct
  */
-void *_tidesdb_compact_sstables_thread(void *arg);
+void _tidesdb_compact_sstables_job(void *arg);
 
 /*
  * _tidesdb_merge_sstables
- * merges two sstables into a new sstable
- * @param sst1 the first sstable
- * @param sst2 the second sstable
+ * merges two sstables, entries in the newer sstable take precedence.  the merged entries are split
+ * into up to max_subcompactions key ranges which are written to their own sstables in parallel
+ * @param cf the column family
+ * @param sst1 the older sstable
+ * @param sst2 the newer sstable
+ * @param bottommost whether sst1 is the oldest sstable, tombstones and expired keys are dropped if
+ * so as there is nothing older for them to shadow
+ * @param outputs the merged sstables in key order, each with a reference held by the caller
+ * @param num_outputs the number of merged sstables
+ * @param dropped where the dropped tombstones and expired keys are counted
+ * @return 0 if the sstables were merged, -1 if not
+ */
+int _tidesdb_merge_sstables(tidesdb_column_family_t *cf, tidesdb_sstable_t *sst1,
+                            tidesdb_sstable_t *sst2, bool bottommost, tidesdb_sstable_t ***outputs,
+                            int *num_outputs, tidesdb_dropped_t *dropped);
+
+/*
+ * _tidesdb_num_subcompactions
+ * picks how many key ranges a merge table is split into, ranges are kept at least a flush worth
+ * of data so a merge doesn't leave behind many small sstables
+ * @param cf the column family
+ * @param mergetable the merge table
+ * @return the number of key ranges
+ */
+int _tidesdb_num_subcompactions(tidesdb_column_family_t *cf, skip_list_t *mergetable);
+
+/*
+ * _tidesdb_subcompactions_new
+ * splits a merge table into key ranges of about the same amount of entries
  * @param cf the column family
- * @param shared_lock the lock for the path creation on parallel compaction
- * @return the new merged sstable
+ * @param mergetable the merge table
+ * @param drop_deleted whether to drop tombstones and expired keys
+ * @param num_ranges the number of key ranges wanted, fewer if there are fewer entries
+ * @return the key ranges with a reference held by the caller, NULL on failure
+ */
+tidesdb_subcompactions_t *_tidesdb_subcompactions_new(tidesdb_column_family_t *cf,
+                                                      skip_list_t *mergetable, bool drop_deleted,
+                                                      int num_ranges);
+
+/*
+ * _tidesdb_release_subcompactions
+ * releases a reference on key ranges, freeing them on the last
+ * @param subs the key ranges
+ */
+void _tidesdb_release_subcompactions(tidesdb_subcompactions_t *subs);
+
+/*
+ * _tidesdb_run_subcompaction
+ * claims a key range no thread has taken yet and writes it to its sstable
+ * @param subs the key ranges
+ * @return 0 if a range was written (or failed), -1 if every range is taken
+ */
+int _tidesdb_run_subcompaction(tidesdb_subcompactions_t *subs);
+
+/*
+ * _tidesdb_subcompaction_job
+ * a background pool job helping a pair merge write its key ranges
+ * @param arg the key ranges, the job holds a reference on them
  */
-tidesdb_sstable_t *_tidesdb_merge_sstables(tidesdb_sstable_t *sst1, tidesdb_sstable_t *sst2,
-                                           tidesdb_column_family_t *cf,
-                                           pthread_mutex_t *shared_lock);
+void _tidesdb_subcompaction_job(void *arg);
 
 /*
- * _tidesdb_merge_sstables_w_bloomfilter
- * merges two sstables into a new sstable and adds a bloom filter to initial block
- * @param sst1 the first sstable
- * @param sst2 the second sstable
+ * _tidesdb_read_sstable_into
+ * reads the key value pairs of an sstable into a skip list, skipping the bloom filter block
  * @param cf the column family
- * @param shared_lock the lock for the path creation on parallel compaction
- * @return the new merged sstable
+ * @param sst the sstable
+ * @param list the skip list
+ * @return 0 if the sstable was read, -1 if not
  */
-tidesdb_sstable_t *_tidesdb_merge_sstables_w_bloomfilter(tidesdb_sstable_t *sst1,
-                                                         tidesdb_sstable_t *sst2,
-                                                         tidesdb_column_family_t *cf,
-                                                         pthread_mutex_t *shared_lock);
+int _tidesdb_read_sstable_into(tidesdb_column_family_t *cf, tidesdb_sstable_t *sst,
+                               skip_list_t *list);
 
 /*
  * _tidesdb_free_column_families
@@ -804,9 +3123,11 @@ uint8_t *_tidesdb_serialize_column_family_config(tidesdb_column_family_config_t
  * _tidesdb_deserialize_column_family_config
  * deserialize a column family configuration
  * @param data the serialized data
+ * @param size the size of the serialized data
  * @return the deserialized column family configuration
  */
-tidesdb_column_family_config_t *_tidesdb_deserialize_column_family_config(const uint8_t *data);
+tidesdb_column_family_config_t *_tidesdb_deserialize_column_family_config(const uint8_t *data,
+                                                                          size_t size);
 
 /*
  * _tidesdb_key_value_pair_new
@@ -17,6 +17,7 @@
  * limitations under the License.
  */
 #include <assert.h>
+#include <stdatomic.h>
 
 #include "../src/block_manager.h"
 #include "test_macros.h"
@@ -529,6 +530,126 @@ void test_block_manager_cursor_has_prev()
     printf(GREEN "test_block_manager_cursor_has_prev passed\n" RESET);
 }
 
+void test_block_manager_direct_io()
+{
+    block_manager_t *bm;
+    assert(block_manager_open_w_direct_io(&bm, "test.db", 0, true) == 0);
+
+    /* enough blocks of an odd size to fill the write buffer more than once */
+    int num_blocks = 1000;
+    uint64_t size = 1500;
+    uint8_t data[1500];
+
+    for (int i = 0; i < num_blocks; i++)
+    {
+        memset(data, i % 256, size);
+        block_manager_block_t *block = block_manager_block_create(size, data);
+        assert(block != NULL);
+        assert(block_manager_block_write(bm, block) == 0);
+        block_manager_block_free(block);
+    }
+
+    assert(block_manager_sync(bm) == 0);
+
+    /* the alignment padding is truncated away */
+    struct stat st;
+    assert(stat("test.db", &st) == 0);
+    assert((uint64_t)st.st_size == num_blocks * (sizeof(uint64_t) + size));
+
+    assert(block_manager_close(bm) == 0);
+
+    /* we reopen and append so the unaligned tail is picked up again */
+    assert(block_manager_open_w_direct_io(&bm, "test.db", 0, true) == 0);
+
+    memset(data, 0xab, size);
+    block_manager_block_t *block = block_manager_block_create(size, data);
+    assert(block != NULL);
+    assert(block_manager_block_write(bm, block) == 0);
+    block_manager_block_free(block);
+
+    /* the cursor sees blocks that are still in the write buffer */
+    assert(block_manager_count_blocks(bm) == num_blocks + 1);
+
+    assert(block_manager_close(bm) == 0);
+
+    /* the file reads back the same without direct I/O */
+    assert(block_manager_open(&bm, "test.db", 0) == 0);
+
+    block_manager_cursor_t *cursor;
+    assert(block_manager_cursor_init(&cursor, bm) == 0);
+
+    for (int i = 0; i <= num_blocks; i++)
+    {
+        block = block_manager_cursor_read(cursor);
+        assert(block != NULL);
+        assert(block->size == size);
+        assert(((uint8_t *)block->data)[0] == (i < num_blocks ? i % 256 : 0xab));
+        assert(((uint8_t *)block->data)[size - 1] == (i < num_blocks ? i % 256 : 0xab));
+        block_manager_block_free(block);
+
+        assert(block_manager_cursor_next(cursor) == 0);
+    }
+
+    assert(block_manager_cursor_next(cursor) == 1);
+
+    block_manager_cursor_free(cursor);
+    assert(block_manager_close(bm) == 0);
+    remove("test.db");
+
+    printf(GREEN "test_block_manager_direct_io passed\n" RESET);
+}
+
+typedef struct
+{
+    atomic_int begins;
+    atomic_int ends;
+} test_sync_hook_counts_t;
+
+void test_sync_hook(void *arg, bool begin)
+{
+    test_sync_hook_counts_t *counts = arg;
+
+    /* every sync that ends has begun */
+    if (begin)
+        (void)atomic_fetch_add(&counts->begins, 1);
+    else
+        assert(atomic_fetch_add(&counts->ends, 1) < atomic_load(&counts->begins));
+}
+
+void test_block_manager_sync_hook()
+{
+    test_sync_hook_counts_t counts;
+    atomic_init(&counts.begins, 0);
+    atomic_init(&counts.ends, 0);
+
+    /* without an fsync thread there is nothing to hook */
+    block_manager_t *bm;
+    assert(block_manager_open(&bm, "test.db", 0) == 0);
+    assert(block_manager_set_sync_hook(bm, test_sync_hook, &counts) == -1);
+    assert(block_manager_close(bm) == 0);
+
+    assert(block_manager_open(&bm, "test.db", 0.01f) == 0);
+    assert(block_manager_set_sync_hook(bm, test_sync_hook, &counts) == 0);
+
+    uint8_t data[100];
+    memset(data, 'x', sizeof(data));
+    block_manager_block_t *block = block_manager_block_create(sizeof(data), data);
+    assert(block != NULL);
+    assert(block_manager_block_write(bm, block) == 0);
+    block_manager_block_free(block);
+
+    /* we give the fsync thread a few intervals */
+    (void)usleep(100000);
+
+    assert(block_manager_close(bm) == 0);
+    remove("test.db");
+
+    assert(atomic_load(&counts.begins) > 0);
+    assert(atomic_load(&counts.begins) == atomic_load(&counts.ends));
+
+    printf(GREEN "test_block_manager_sync_hook passed\n" RESET);
+}
+
 int main(void)
 {
     test_block_manager_open();
@@ -542,6 +663,8 @@ int main(void)
     test_block_manager_cursor_goto_last();
     test_block_manager_cursor_has_next();
     test_block_manager_cursor_has_prev();
+    test_block_manager_direct_io();
+    test_block_manager_sync_hook();
 
     return 0;
 }
\ No newline at end of file
@@ -70,6 +70,34 @@ void test_bloom_filter_is_full()
     printf(GREEN "test_bloom_filter_is_full passed\n" RESET);
 }
 
+void test_bloom_filter_count_set()
+{
+    bloom_filter_t *bf;
+    bloom_filter_new(&bf, 0.01, 1000);
+    assert(bloom_filter_count_set(bf) == 0);
+
+    /* a key sets at most h bits and adding it again sets none */
+    const char *key = "test_key";
+    bloom_filter_add(bf, (const uint8_t *)key, strlen(key));
+    int set = bloom_filter_count_set(bf);
+    assert(set > 0 && set <= bf->h);
+    bloom_filter_add(bf, (const uint8_t *)key, strlen(key));
+    assert(bloom_filter_count_set(bf) == set);
+
+    /* filled to the n it was sized for about half the bits are set */
+    for (int i = 0; i < 1000; i++)
+    {
+        char k[20];
+        sprintf(k, "key_%d", i);
+        bloom_filter_add(bf, (const uint8_t *)k, strlen(k));
+    }
+    double fill = (double)bloom_filter_count_set(bf) / bf->m;
+    assert(fill > 0.4 && fill < 0.6);
+
+    bloom_filter_free(bf);
+    printf(GREEN "test_bloom_filter_count_set passed\n" RESET);
+}
+
 void benchmark_bloom_filter()
 {
     bloom_filter_t *bf;
@@ -105,6 +133,7 @@ int main(void)
     test_bloom_filter_new();
     test_bloom_filter_add_and_contains();
     test_bloom_filter_is_full();
+    test_bloom_filter_count_set();
     benchmark_bloom_filter();
     return 0;
 }
\ No newline at end of file
@@ -44,9 +44,43 @@ void test_tidesdb_err_from_code()
     printf(GREEN "test_tidesdb_err_from_code passed\n" RESET);
 }
 
+void test_tidesdb_err_from_status()
+{
+    /* success has no error */
+    assert(tidesdb_err_from_status(TIDESDB_SUCCESS) == NULL);
+
+    tidesdb_err_t *e = tidesdb_err_from_status(TIDESDB_ERR_KEY_NOT_FOUND);
+    assert(e->code == TIDESDB_ERR_KEY_NOT_FOUND);
+    assert(strcmp(e->message, "Key not found.\n") == 0);
+    tidesdb_err_free(e);
+
+    /* codes that name an object are formatted */
+    e = tidesdb_err_from_status(TIDESDB_ERR_FAILED_TO_ACQUIRE_LOCK);
+    assert(strcmp(e->message, "Failed to acquire lock for column family.\n") == 0);
+    tidesdb_err_free(e);
+
+    printf(GREEN "test_tidesdb_err_from_status passed\n" RESET);
+}
+
+void test_tidesdb_err_message()
+{
+    assert(strcmp(tidesdb_err_message(TIDESDB_ERR_KEY_NOT_FOUND), "Key not found.\n") == 0);
+    assert(strcmp(tidesdb_err_message(TIDESDB_ERR_RM_FAILED), "Failed to remove %s.\n") == 0);
+    assert(strcmp(tidesdb_err_message(TIDESDB_SUCCESS), "Success.\n") == 0);
+    assert(strcmp(tidesdb_err_message(10000), "Unknown error.\n") == 0);
+
+    /* every code has its own message */
+    for (int code = 0; code <= TIDESDB_ERR_WRITE_STALLED; code++)
+        assert(tidesdb_err_messages[code].code == code);
+
+    printf(GREEN "test_tidesdb_err_message passed\n" RESET);
+}
+
 int main(void)
 {
     test_tidesdb_err_new();
     test_tidesdb_err_from_code();
+    test_tidesdb_err_from_status();
+    test_tidesdb_err_message();
     return 0;
 }
\ No newline at end of file
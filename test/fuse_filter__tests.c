@@ -0,0 +1,176 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/fuse_filter.h"
+#include "test_macros.h"
+
+/* builds a filter over key_0 .. key_n-1 */
+static fuse_filter_t *fuse_filter_of_keys(int n)
+{
+    uint64_t *hashes = malloc((n > 0 ? n : 1) * sizeof(uint64_t));
+    assert(hashes != NULL);
+    for (int i = 0; i < n; i++)
+    {
+        char key[20];
+        sprintf(key, "key_%d", i);
+        hashes[i] = fuse_filter_hash((const uint8_t *)key, strlen(key));
+    }
+
+    fuse_filter_t *ff = NULL;
+    assert(fuse_filter_new(&ff, hashes, n) == 0);
+    assert(ff != NULL);
+    free(hashes);
+    return ff;
+}
+
+void test_fuse_filter_new()
+{
+    /* empty and tiny key sets must build too, an sstable may hold a single key */
+    int sizes[] = {0, 1, 2, 10, 1000, 100000};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        fuse_filter_t *ff = fuse_filter_of_keys(sizes[s]);
+        assert(ff->array_length >= ff->segment_count_length);
+        assert(ff->array_length == (ff->segment_count + 2) * ff->segment_length);
+        for (int i = 0; i < sizes[s]; i++)
+        {
+            char key[20];
+            sprintf(key, "key_%d", i);
+            assert(fuse_filter_contains(ff, (const uint8_t *)key, strlen(key)) == 1);
+        }
+        fuse_filter_free(ff);
+    }
+    printf(GREEN "test_fuse_filter_new passed\n" RESET);
+}
+
+void test_fuse_filter_duplicates()
+{
+    /* duplicate keys are dropped rather than failing the build */
+    uint64_t hashes[100];
+    for (int i = 0; i < 100; i++)
+    {
+        char key[20];
+        sprintf(key, "key_%d", i % 10);
+        hashes[i] = fuse_filter_hash((const uint8_t *)key, strlen(key));
+    }
+
+    fuse_filter_t *ff = NULL;
+    assert(fuse_filter_new(&ff, hashes, 100) == 0);
+    for (int i = 0; i < 10; i++)
+    {
+        char key[20];
+        sprintf(key, "key_%d", i);
+        assert(fuse_filter_contains(ff, (const uint8_t *)key, strlen(key)) == 1);
+    }
+    fuse_filter_free(ff);
+    printf(GREEN "test_fuse_filter_duplicates passed\n" RESET);
+}
+
+void test_fuse_filter_false_positive_rate()
+{
+    fuse_filter_t *ff = fuse_filter_of_keys(100000);
+
+    /* 8 bit fingerprints give a false positive rate of about 1/256 at under 10 bits per key */
+    int false_positives = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        char key[24];
+        sprintf(key, "other_%d", i);
+        false_positives += fuse_filter_contains(ff, (const uint8_t *)key, strlen(key));
+    }
+    double rate = (double)false_positives / 100000;
+    assert(rate > 0.002 && rate < 0.006);
+
+    double bits_per_key = (double)ff->array_length * 8 / 100000;
+    assert(bits_per_key < 10.0);
+
+    fuse_filter_free(ff);
+    printf(GREEN "test_fuse_filter_false_positive_rate passed\n" RESET);
+}
+
+void test_fuse_filter_serialize_deserialize()
+{
+    fuse_filter_t *ff = fuse_filter_of_keys(1000);
+
+    size_t size;
+    uint8_t *data = fuse_filter_serialize(ff, &size);
+    assert(data != NULL);
+
+    /* a truncated filter is refused */
+    assert(fuse_filter_deserialize(data, size - 1) == NULL);
+    assert(fuse_filter_deserialize(data, 4) == NULL);
+
+    fuse_filter_t *copy = fuse_filter_deserialize(data, size);
+    assert(copy != NULL);
+    assert(copy->seed == ff->seed);
+    assert(copy->segment_length == ff->segment_length);
+    assert(copy->segment_count == ff->segment_count);
+    assert(copy->array_length == ff->array_length);
+    assert(memcmp(copy->fingerprints, ff->fingerprints, ff->array_length) == 0);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        char key[20];
+        sprintf(key, "key_%d", i);
+        assert(fuse_filter_contains(copy, (const uint8_t *)key, strlen(key)) == 1);
+    }
+
+    free(data);
+    fuse_filter_free(copy);
+    fuse_filter_free(ff);
+    printf(GREEN "test_fuse_filter_serialize_deserialize passed\n" RESET);
+}
+
+void benchmark_fuse_filter()
+{
+    clock_t start_build = clock();
+    fuse_filter_t *ff = fuse_filter_of_keys(1000000);
+    clock_t end_build = clock();
+    double time_spent_build = (double)(end_build - start_build) / CLOCKS_PER_SEC;
+    printf(CYAN "Building from 1,000,000 elements took %f seconds\n" RESET, time_spent_build);
+
+    clock_t start_check = clock();
+    for (int i = 0; i < 1000000; i++)
+    {
+        char key[20];
+        sprintf(key, "key_%d", i);
+        assert(fuse_filter_contains(ff, (const uint8_t *)key, strlen(key)) == 1);
+    }
+    clock_t end_check = clock();
+    double time_spent_check = (double)(end_check - start_check) / CLOCKS_PER_SEC;
+    printf(CYAN "Checking 1,000,000 elements took %f seconds\n" RESET, time_spent_check);
+
+    fuse_filter_free(ff);
+}
+
+int main(void)
+{
+    test_fuse_filter_new();
+    test_fuse_filter_duplicates();
+    test_fuse_filter_false_positive_rate();
+    test_fuse_filter_serialize_deserialize();
+    benchmark_fuse_filter();
+    return 0;
+}
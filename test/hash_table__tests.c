@@ -58,6 +58,40 @@ void test_hash_table_put_get()
     printf(GREEN "test_hash_table_put_get passed\n" RESET);
 }
 
+void test_hash_table_collisions()
+{
+    hash_table_t *ht;
+    assert(hash_table_new(&ht) == 0);
+
+    /* enough keys that some of them hash to the same bucket */
+    for (int i = 0; i < 20000; i++)
+    {
+        uint8_t key[16] = {0};
+        snprintf((char *)key, sizeof(key), "key%d", i);
+        assert(hash_table_put(&ht, key, sizeof(key), (uint8_t *)&i, sizeof(i), -1) == 0);
+    }
+
+    assert(ht->count == 20000);
+
+    /* every key must still have its own value */
+    for (int i = 0; i < 20000; i++)
+    {
+        uint8_t key[16] = {0};
+        snprintf((char *)key, sizeof(key), "key%d", i);
+
+        uint8_t *retrieved_value;
+        size_t retrieved_value_size;
+        assert(hash_table_get(ht, key, sizeof(key), &retrieved_value, &retrieved_value_size) ==
+               0);
+        assert(retrieved_value_size == sizeof(i));
+        assert(memcmp(retrieved_value, &i, sizeof(i)) == 0);
+        free(retrieved_value);
+    }
+
+    hash_table_destroy(ht);
+    printf(GREEN "test_hash_table_collisions passed\n" RESET);
+}
+
 void test_hash_table_resize()
 {
     hash_table_t *ht;
@@ -136,6 +170,7 @@ int main(void)
 {
     test_hash_table_new();
     test_hash_table_put_get();
+    test_hash_table_collisions();
     test_hash_table_clear();
     test_hash_table_cursor();
     test_hash_table_resize();
@@ -0,0 +1,133 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include "../src/histogram.h"
+#include "test_macros.h"
+
+void test_histogram_empty()
+{
+    histogram_t h;
+    histogram_init(&h);
+
+    histogram_summary_t summary;
+    histogram_summarize(&h, &summary);
+    assert(summary.count == 0);
+    assert(summary.min == 0);
+    assert(summary.max == 0);
+    assert(histogram_percentile(&h, 99.0) == 0);
+    printf(GREEN "test_histogram_empty passed\n" RESET);
+}
+
+void test_histogram_percentiles()
+{
+    histogram_t h;
+    histogram_init(&h);
+
+    /* 1 to 10000, every percentile is known */
+    for (uint64_t i = 1; i <= 10000; i++) histogram_record(&h, i);
+
+    histogram_summary_t summary;
+    histogram_summarize(&h, &summary);
+    assert(summary.count == 10000);
+    assert(summary.sum == 10000ULL * 10001 / 2);
+    assert(summary.min == 1);
+    assert(summary.max == 10000);
+    assert(summary.avg == 5000);
+
+    /* a percentile is the top of its bucket, within 1/16 of the actual value */
+    assert(summary.p50 >= 5000 && summary.p50 <= 5000 + 5000 / 16);
+    assert(summary.p99 >= 9900 && summary.p99 <= 9900 + 9900 / 16);
+    assert(summary.p999 >= 9990 && summary.p999 <= 10000);
+
+    /* small values are exact */
+    histogram_t small;
+    histogram_init(&small);
+    for (uint64_t i = 0; i < 10; i++) histogram_record(&small, 7);
+    assert(histogram_percentile(&small, 50.0) == 7);
+
+    /* the largest values have a bucket as well */
+    histogram_record(&small, UINT64_MAX);
+    assert(histogram_percentile(&small, 100.0) == UINT64_MAX);
+    printf(GREEN "test_histogram_percentiles passed\n" RESET);
+}
+
+void test_histogram_merge()
+{
+    histogram_t a;
+    histogram_t b;
+    histogram_init(&a);
+    histogram_init(&b);
+
+    for (uint64_t i = 0; i < 100; i++) histogram_record(&a, 10);
+    for (uint64_t i = 0; i < 100; i++) histogram_record(&b, 1000);
+
+    histogram_t merged;
+    histogram_init(&merged);
+    histogram_merge(&merged, &a);
+    histogram_merge(&merged, &b);
+
+    histogram_summary_t summary;
+    histogram_summarize(&merged, &summary);
+    assert(summary.count == 200);
+    assert(summary.min == 10);
+    assert(summary.max == 1000);
+    assert(summary.p50 == 10);
+    assert(summary.p99 == 1000);
+    printf(GREEN "test_histogram_merge passed\n" RESET);
+}
+
+static void *record_thread(void *arg)
+{
+    histogram_t *h = arg;
+    for (uint64_t i = 1; i <= 100000; i++) histogram_record(h, i % 1000);
+    return NULL;
+}
+
+void test_histogram_concurrent()
+{
+    histogram_t *h = malloc(sizeof(histogram_t));
+    assert(h != NULL);
+    histogram_init(h);
+
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, record_thread, h);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+
+    /* no record is lost */
+    histogram_summary_t summary;
+    histogram_summarize(h, &summary);
+    assert(summary.count == 400000);
+    assert(summary.min == 0);
+    assert(summary.max == 999);
+
+    free(h);
+    printf(GREEN "test_histogram_concurrent passed\n" RESET);
+}
+
+int main(void)
+{
+    test_histogram_empty();
+    test_histogram_percentiles();
+    test_histogram_merge();
+    test_histogram_concurrent();
+    return 0;
+}
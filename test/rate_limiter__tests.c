@@ -0,0 +1,196 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "../src/rate_limiter.h"
+#include "test_macros.h"
+
+/*
+ * elapsed_ms
+ * gets the milliseconds since start
+ */
+static double elapsed_ms(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1000.0 +
+           (double)(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+void test_rate_limiter_new()
+{
+    rate_limiter_t *rl;
+    assert(rate_limiter_new(&rl, 1024) == 0);
+    assert(rl != NULL);
+    assert(rl->bytes_per_sec == 1024);
+    assert(rl->high_waiting == 0);
+    rate_limiter_free(rl);
+    printf(GREEN "test_rate_limiter_new passed\n" RESET);
+}
+
+void test_rate_limiter_unlimited()
+{
+    rate_limiter_t *rl;
+    assert(rate_limiter_new(&rl, 0) == 0);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* an unlimited limiter never waits but still counts */
+    for (int i = 0; i < 1000; i++)
+        rate_limiter_request(rl, 1024 * 1024, RATE_LIMITER_PRIORITY_LOW);
+
+    assert(elapsed_ms(&start) < 1000);
+    assert(rl->total_bytes[RATE_LIMITER_PRIORITY_LOW] == 1000ULL * 1024 * 1024);
+    assert(rl->total_bytes[RATE_LIMITER_PRIORITY_HIGH] == 0);
+
+    rate_limiter_free(rl);
+    printf(GREEN "test_rate_limiter_unlimited passed\n" RESET);
+}
+
+void test_rate_limiter_throughput()
+{
+    rate_limiter_t *rl;
+    assert(rate_limiter_new(&rl, 1024 * 1024) == 0); /* 1MB/s */
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* 512KB in 64KB writes, the first write goes right away and the rest pay for the first */
+    for (int i = 0; i < 8; i++) rate_limiter_request(rl, 64 * 1024, RATE_LIMITER_PRIORITY_HIGH);
+
+    double ms = elapsed_ms(&start);
+    assert(ms >= 350);
+    assert(ms < 5000);
+    assert(rl->total_wait_us[RATE_LIMITER_PRIORITY_HIGH] > 0);
+
+    rate_limiter_free(rl);
+    printf(GREEN "test_rate_limiter_throughput passed\n" RESET);
+}
+
+typedef struct
+{
+    rate_limiter_t *rl;
+    rate_limiter_priority_t priority;
+    _Atomic int *order;
+    int finished;
+} test_rate_limiter_args_t;
+
+void *test_rate_limiter_request_thread(void *arg)
+{
+    test_rate_limiter_args_t *args = arg;
+    rate_limiter_request(args->rl, 1, args->priority);
+    args->finished = atomic_fetch_add(args->order, 1);
+    return NULL;
+}
+
+void test_rate_limiter_priority()
+{
+    rate_limiter_t *rl;
+    assert(rate_limiter_new(&rl, 100 * 1024) == 0); /* 100KB/s */
+
+    /* we put the bucket into about half a second of debt */
+    rate_limiter_request(rl, 50 * 1024, RATE_LIMITER_PRIORITY_LOW);
+
+    _Atomic int order = 0;
+    test_rate_limiter_args_t low = {rl, RATE_LIMITER_PRIORITY_LOW, &order, -1};
+    test_rate_limiter_args_t high = {rl, RATE_LIMITER_PRIORITY_HIGH, &order, -1};
+
+    /* the low priority request waits first but the high priority one is admitted first */
+    pthread_t low_thread;
+    pthread_t high_thread;
+    assert(pthread_create(&low_thread, NULL, test_rate_limiter_request_thread, &low) == 0);
+    usleep(20000);
+    assert(pthread_create(&high_thread, NULL, test_rate_limiter_request_thread, &high) == 0);
+
+    pthread_join(low_thread, NULL);
+    pthread_join(high_thread, NULL);
+
+    assert(high.finished == 0);
+    assert(low.finished == 1);
+
+    rate_limiter_free(rl);
+    printf(GREEN "test_rate_limiter_priority passed\n" RESET);
+}
+
+void test_rate_limiter_charge()
+{
+    rate_limiter_t *rl;
+    assert(rate_limiter_new(&rl, 100 * 1024) == 0); /* 100KB/s */
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* a charge never waits, however deep into debt it puts the bucket */
+    rate_limiter_charge(rl, 50 * 1024, RATE_LIMITER_PRIORITY_HIGH);
+    rate_limiter_charge(rl, 50 * 1024, RATE_LIMITER_PRIORITY_HIGH);
+    assert(elapsed_ms(&start) < 100);
+    assert(rl->total_bytes[RATE_LIMITER_PRIORITY_HIGH] == 100 * 1024);
+    assert(rl->total_wait_us[RATE_LIMITER_PRIORITY_HIGH] == 0);
+
+    /* the next request waits out about a second of debt */
+    rate_limiter_request(rl, 1, RATE_LIMITER_PRIORITY_LOW);
+    assert(elapsed_ms(&start) >= 800);
+    assert(rl->total_wait_us[RATE_LIMITER_PRIORITY_LOW] > 0);
+
+    rate_limiter_free(rl);
+    printf(GREEN "test_rate_limiter_charge passed\n" RESET);
+}
+
+void test_rate_limiter_set_bytes_per_sec()
+{
+    rate_limiter_t *rl;
+    assert(rate_limiter_new(&rl, 1024) == 0); /* 1KB/s */
+
+    /* about a minute of debt */
+    rate_limiter_request(rl, 64 * 1024, RATE_LIMITER_PRIORITY_LOW);
+
+    _Atomic int order = 0;
+    test_rate_limiter_args_t args = {rl, RATE_LIMITER_PRIORITY_LOW, &order, -1};
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, test_rate_limiter_request_thread, &args) == 0);
+    usleep(20000);
+
+    /* lifting the limit releases the waiting request */
+    rate_limiter_set_bytes_per_sec(rl, 0);
+    pthread_join(thread, NULL);
+
+    assert(args.finished == 0);
+    assert(elapsed_ms(&start) < 5000);
+
+    rate_limiter_free(rl);
+    printf(GREEN "test_rate_limiter_set_bytes_per_sec passed\n" RESET);
+}
+
+int main(void)
+{
+    test_rate_limiter_new();
+    test_rate_limiter_unlimited();
+    test_rate_limiter_throughput();
+    test_rate_limiter_priority();
+    test_rate_limiter_charge();
+    test_rate_limiter_set_bytes_per_sec();
+    return 0;
+}
@@ -0,0 +1,269 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <assert.h>
+#include <stdio.h>
+
+#include "../src/row_cache.h"
+#include "test_macros.h"
+
+void test_row_cache_new()
+{
+    row_cache_t *cache;
+    assert(row_cache_new(&cache, 1024 * 1024) == 0);
+    assert(cache != NULL);
+    assert(cache->capacity == 1024 * 1024);
+    assert(row_cache_size(cache) == 0);
+    row_cache_free(cache);
+    printf(GREEN "test_row_cache_new passed\n" RESET);
+}
+
+void test_row_cache_put_get()
+{
+    row_cache_t *cache;
+    assert(row_cache_new(&cache, 1024 * 1024) == 0);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    uint64_t version;
+
+    /* a miss hands out the version to insert with */
+    assert(row_cache_get(cache, 1, (uint8_t *)"key", 3, &value, &value_size, &version) == -1);
+    assert(row_cache_put(cache, 1, (uint8_t *)"key", 3, (uint8_t *)"value", 5, -1, version) == 0);
+
+    assert(row_cache_get(cache, 1, (uint8_t *)"key", 3, &value, &value_size, &version) == 0);
+    assert(value_size == 5);
+    assert(memcmp(value, "value", 5) == 0);
+    free(value);
+
+    /* the same key of another owner is another row */
+    assert(row_cache_get(cache, 2, (uint8_t *)"key", 3, &value, &value_size, &version) == -1);
+
+    /* a put replaces the row of its key */
+    assert(row_cache_get(cache, 1, (uint8_t *)"other", 5, &value, &value_size, &version) == -1);
+    assert(row_cache_put(cache, 1, (uint8_t *)"key", 3, (uint8_t *)"new", 3, -1, version) == 0);
+    assert(row_cache_get(cache, 1, (uint8_t *)"key", 3, &value, &value_size, &version) == 0);
+    assert(value_size == 3);
+    assert(memcmp(value, "new", 3) == 0);
+    free(value);
+
+    assert(row_cache_size(cache) == sizeof(row_cache_entry_t) + 3 + 3);
+    assert(atomic_load(&cache->hits) == 2);
+    assert(atomic_load(&cache->misses) == 3);
+
+    row_cache_free(cache);
+    printf(GREEN "test_row_cache_put_get passed\n" RESET);
+}
+
+void test_row_cache_invalidate()
+{
+    row_cache_t *cache;
+    assert(row_cache_new(&cache, 1024 * 1024) == 0);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    uint64_t version;
+
+    assert(row_cache_get(cache, 1, (uint8_t *)"key", 3, &value, &value_size, &version) == -1);
+    assert(row_cache_put(cache, 1, (uint8_t *)"key", 3, (uint8_t *)"value", 5, -1, version) == 0);
+
+    row_cache_invalidate(cache, 1, (uint8_t *)"key", 3);
+    assert(row_cache_get(cache, 1, (uint8_t *)"key", 3, &value, &value_size, &version) == -1);
+    assert(row_cache_size(cache) == 0);
+
+    /* a write between the miss and the put means the row read may be stale, it is not cached */
+    row_cache_invalidate(cache, 1, (uint8_t *)"key", 3);
+    assert(row_cache_put(cache, 1, (uint8_t *)"key", 3, (uint8_t *)"old", 3, -1, version) == -1);
+    assert(row_cache_get(cache, 1, (uint8_t *)"key", 3, &value, &value_size, &version) == -1);
+
+    row_cache_free(cache);
+    printf(GREEN "test_row_cache_invalidate passed\n" RESET);
+}
+
+void test_row_cache_invalidate_owner()
+{
+    row_cache_t *cache;
+    assert(row_cache_new(&cache, 1024 * 1024) == 0);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    uint64_t version;
+
+    for (int i = 0; i < 100; i++)
+    {
+        uint8_t key[4];
+        memcpy(key, &i, sizeof(i));
+        for (uint64_t owner = 1; owner <= 2; owner++)
+        {
+            assert(row_cache_get(cache, owner, key, sizeof(key), &value, &value_size, &version) ==
+                   -1);
+            assert(row_cache_put(cache, owner, key, sizeof(key), key, sizeof(key), -1, version) ==
+                   0);
+        }
+    }
+
+    row_cache_invalidate_owner(cache, 1);
+
+    for (int i = 0; i < 100; i++)
+    {
+        uint8_t key[4];
+        memcpy(key, &i, sizeof(i));
+        assert(row_cache_get(cache, 1, key, sizeof(key), &value, &value_size, &version) == -1);
+        assert(row_cache_get(cache, 2, key, sizeof(key), &value, &value_size, &version) == 0);
+        assert(value_size == sizeof(key));
+        assert(memcmp(value, key, sizeof(key)) == 0);
+        free(value);
+    }
+
+    assert(row_cache_size(cache) == 100 * (sizeof(row_cache_entry_t) + 8));
+
+    row_cache_free(cache);
+    printf(GREEN "test_row_cache_invalidate_owner passed\n" RESET);
+}
+
+void test_row_cache_eviction()
+{
+    /* every shard holds 4096 bytes */
+    size_t capacity = 4096 * ROW_CACHE_SHARDS;
+    row_cache_t *cache;
+    assert(row_cache_new(&cache, capacity) == 0);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    uint64_t version;
+    uint8_t row[256] = {0};
+
+    for (int i = 0; i < 10000; i++)
+    {
+        uint8_t key[4];
+        memcpy(key, &i, sizeof(i));
+        assert(row_cache_get(cache, 1, key, sizeof(key), &value, &value_size, &version) == -1);
+        assert(row_cache_put(cache, 1, key, sizeof(key), row, sizeof(row), -1, version) == 0);
+        assert(row_cache_size(cache) <= capacity);
+    }
+
+    assert(atomic_load(&cache->evictions) > 0);
+
+    /* the most recent row is still there, the first ones were evicted */
+    int last = 9999;
+    assert(row_cache_get(cache, 1, (uint8_t *)&last, sizeof(last), &value, &value_size,
+                         &version) == 0);
+    free(value);
+    int first = 0;
+    assert(row_cache_get(cache, 1, (uint8_t *)&first, sizeof(first), &value, &value_size,
+                         &version) == -1);
+
+    /* a row bigger than a shard is never cached */
+    uint8_t *big = calloc(1, 8192);
+    assert(big != NULL);
+    assert(row_cache_put(cache, 1, (uint8_t *)"big", 3, big, 8192, -1, version) == -1);
+    free(big);
+
+    row_cache_free(cache);
+    printf(GREEN "test_row_cache_eviction passed\n" RESET);
+}
+
+void test_row_cache_lru()
+{
+    size_t capacity = (sizeof(row_cache_entry_t) + 8) * 4 * ROW_CACHE_SHARDS;
+    row_cache_t *cache;
+    assert(row_cache_new(&cache, capacity) == 0);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    uint64_t version;
+
+    /* we find keys of one shard so they compete for the same 4 rows */
+    int keys[6];
+    int found = 0;
+    int want = -1;
+    for (int i = 0; found < 6; i++)
+    {
+        int shard = bloom_filter_hash((uint8_t *)&i, sizeof(i), 1) % ROW_CACHE_SHARDS;
+        if (want == -1) want = shard;
+        if (shard == want) keys[found++] = i;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        assert(row_cache_get(cache, 1, (uint8_t *)&keys[i], 4, &value, &value_size, &version) ==
+               -1);
+        assert(row_cache_put(cache, 1, (uint8_t *)&keys[i], 4, (uint8_t *)&keys[i], 4, -1,
+                             version) == 0);
+    }
+
+    /* we touch the oldest row so the second oldest is evicted instead */
+    assert(row_cache_get(cache, 1, (uint8_t *)&keys[0], 4, &value, &value_size, &version) == 0);
+    free(value);
+
+    for (int i = 4; i < 6; i++)
+    {
+        assert(row_cache_get(cache, 1, (uint8_t *)&keys[i], 4, &value, &value_size, &version) ==
+               -1);
+        assert(row_cache_put(cache, 1, (uint8_t *)&keys[i], 4, (uint8_t *)&keys[i], 4, -1,
+                             version) == 0);
+    }
+
+    assert(row_cache_get(cache, 1, (uint8_t *)&keys[0], 4, &value, &value_size, &version) == 0);
+    free(value);
+    assert(row_cache_get(cache, 1, (uint8_t *)&keys[1], 4, &value, &value_size, &version) == -1);
+    assert(row_cache_get(cache, 1, (uint8_t *)&keys[2], 4, &value, &value_size, &version) == -1);
+    assert(row_cache_get(cache, 1, (uint8_t *)&keys[3], 4, &value, &value_size, &version) == 0);
+    free(value);
+
+    row_cache_free(cache);
+    printf(GREEN "test_row_cache_lru passed\n" RESET);
+}
+
+void test_row_cache_ttl()
+{
+    row_cache_t *cache;
+    assert(row_cache_new(&cache, 1024 * 1024) == 0);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    uint64_t version;
+
+    assert(row_cache_get(cache, 1, (uint8_t *)"old", 3, &value, &value_size, &version) == -1);
+    assert(row_cache_put(cache, 1, (uint8_t *)"old", 3, (uint8_t *)"value", 5, time(NULL) - 1,
+                         version) == 0);
+    assert(row_cache_get(cache, 1, (uint8_t *)"new", 3, &value, &value_size, &version) == -1);
+    assert(row_cache_put(cache, 1, (uint8_t *)"new", 3, (uint8_t *)"value", 5, time(NULL) + 60,
+                         version) == 0);
+
+    /* the expired row is dropped on lookup */
+    assert(row_cache_get(cache, 1, (uint8_t *)"old", 3, &value, &value_size, &version) == -1);
+    assert(row_cache_get(cache, 1, (uint8_t *)"new", 3, &value, &value_size, &version) == 0);
+    free(value);
+    assert(row_cache_size(cache) == sizeof(row_cache_entry_t) + 3 + 5);
+
+    row_cache_free(cache);
+    printf(GREEN "test_row_cache_ttl passed\n" RESET);
+}
+
+int main(void)
+{
+    test_row_cache_new();
+    test_row_cache_put_get();
+    test_row_cache_invalidate();
+    test_row_cache_invalidate_owner();
+    test_row_cache_eviction();
+    test_row_cache_lru();
+    test_row_cache_ttl();
+    return 0;
+}
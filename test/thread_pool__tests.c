@@ -0,0 +1,176 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "../src/thread_pool.h"
+#include "test_macros.h"
+
+/*
+ * count_job
+ * bumps the counter it is given
+ */
+static void count_job(void *arg)
+{
+    atomic_int *counter = arg;
+    (void)atomic_fetch_add(counter, 1);
+}
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool open;
+    int order[8];
+    int num_order;
+} gate_t;
+
+typedef struct
+{
+    gate_t *gate;
+    int id;
+} order_arg_t;
+
+/*
+ * gate_job
+ * blocks the pool thread until the gate is opened
+ */
+static void gate_job(void *arg)
+{
+    gate_t *gate = arg;
+    pthread_mutex_lock(&gate->lock);
+    while (!gate->open) pthread_cond_wait(&gate->cond, &gate->lock);
+    pthread_mutex_unlock(&gate->lock);
+}
+
+/*
+ * order_job
+ * records the order jobs ran in
+ */
+static void order_job(void *arg)
+{
+    order_arg_t *a = arg;
+    pthread_mutex_lock(&a->gate->lock);
+    a->gate->order[a->gate->num_order++] = a->id;
+    pthread_mutex_unlock(&a->gate->lock);
+}
+
+void test_thread_pool_new()
+{
+    thread_pool_t *pool;
+    assert(thread_pool_new(&pool, 0) == -1);
+    assert(thread_pool_new(&pool, THREAD_POOL_MAX_THREADS + 1) == -1);
+
+    assert(thread_pool_new(&pool, 4) == 0);
+    assert(pool != NULL);
+    assert(pool->num_threads == 4);
+    assert(pool->queued == 0);
+    thread_pool_free(pool);
+    printf(GREEN "test_thread_pool_new passed\n" RESET);
+}
+
+void test_thread_pool_submit_wait()
+{
+    thread_pool_t *pool;
+    assert(thread_pool_new(&pool, 4) == 0);
+
+    atomic_int counter = 0;
+    for (int i = 0; i < 1000; i++)
+        assert(thread_pool_submit(pool, (thread_pool_priority_t)(i % THREAD_POOL_PRIORITIES),
+                                  count_job, &counter) == 0);
+
+    thread_pool_wait(pool);
+    assert(atomic_load(&counter) == 1000);
+    assert(pool->completed == 1000);
+    assert(pool->queued == 0 && pool->running == 0);
+
+    /* a bad priority or function is refused */
+    assert(thread_pool_submit(pool, THREAD_POOL_PRIORITIES, count_job, &counter) == -1);
+    assert(thread_pool_submit(pool, THREAD_POOL_PRIORITY_LOW, NULL, &counter) == -1);
+
+    thread_pool_free(pool);
+    printf(GREEN "test_thread_pool_submit_wait passed\n" RESET);
+}
+
+void test_thread_pool_priority()
+{
+    thread_pool_t *pool;
+    assert(thread_pool_new(&pool, 1) == 0);
+
+    gate_t gate = {.open = false, .num_order = 0};
+    pthread_mutex_init(&gate.lock, NULL);
+    pthread_cond_init(&gate.cond, NULL);
+
+    /* we hold the only thread so the rest queue up behind it */
+    assert(thread_pool_submit(pool, THREAD_POOL_PRIORITY_LOW, gate_job, &gate) == 0);
+    while (pool->running == 0) usleep(1000);
+
+    order_arg_t args[6];
+    thread_pool_priority_t priorities[6] = {
+        THREAD_POOL_PRIORITY_LOW, THREAD_POOL_PRIORITY_MEDIUM, THREAD_POOL_PRIORITY_HIGH,
+        THREAD_POOL_PRIORITY_LOW, THREAD_POOL_PRIORITY_MEDIUM, THREAD_POOL_PRIORITY_HIGH};
+    for (int i = 0; i < 6; i++)
+    {
+        args[i].gate = &gate;
+        args[i].id = i;
+        assert(thread_pool_submit(pool, priorities[i], order_job, &args[i]) == 0);
+    }
+
+    pthread_mutex_lock(&gate.lock);
+    gate.open = true;
+    pthread_cond_broadcast(&gate.cond);
+    pthread_mutex_unlock(&gate.lock);
+
+    thread_pool_wait(pool);
+
+    /* high before medium before low, in submission order within a priority */
+    int expected[6] = {2, 5, 1, 4, 0, 3};
+    assert(gate.num_order == 6);
+    for (int i = 0; i < 6; i++) assert(gate.order[i] == expected[i]);
+
+    thread_pool_free(pool);
+    pthread_cond_destroy(&gate.cond);
+    pthread_mutex_destroy(&gate.lock);
+    printf(GREEN "test_thread_pool_priority passed\n" RESET);
+}
+
+void test_thread_pool_free_drains()
+{
+    thread_pool_t *pool;
+    assert(thread_pool_new(&pool, 2) == 0);
+
+    atomic_int counter = 0;
+    for (int i = 0; i < 100; i++)
+        assert(thread_pool_submit(pool, THREAD_POOL_PRIORITY_MEDIUM, count_job, &counter) == 0);
+
+    /* queued jobs still run when the pool is freed */
+    thread_pool_free(pool);
+    assert(atomic_load(&counter) == 100);
+    printf(GREEN "test_thread_pool_free_drains passed\n" RESET);
+}
+
+int main(void)
+{
+    test_thread_pool_new();
+    test_thread_pool_submit_wait();
+    test_thread_pool_priority();
+    test_thread_pool_free_drains();
+    return 0;
+}
@@ -58,14 +58,19 @@ void test_tidesdb_serialize_deserialize_column_family_config()
                                              .compressed = true,
                                              .compress_algo = TDB_COMPRESS_LZ4,
                                              .bloom_filter = false,
-                                             .memtable_ds = TDB_MEMTABLE_SKIP_LIST};
+                                             .memtable_ds = TDB_MEMTABLE_SKIP_LIST,
+                                             .memtable_shards = 8,
+                                             .filter_type = TDB_FILTER_BINARY_FUSE,
+                                             .partitioned_index = true,
+                                             .hash_index = true,
+                                             .learned_index = true};
 
     size_t serialized_size;
     uint8_t *serialized = _tidesdb_serialize_column_family_config(&config, &serialized_size);
     assert(serialized != NULL);
 
     tidesdb_column_family_config_t *deserialized =
-        _tidesdb_deserialize_column_family_config(serialized);
+        _tidesdb_deserialize_column_family_config(serialized, serialized_size);
     assert(deserialized != NULL);
 
     assert(strcmp(deserialized->name, config.name) == 0);
@@ -76,6 +81,11 @@ void test_tidesdb_serialize_deserialize_column_family_config()
     assert(deserialized->bloom_filter == config.bloom_filter);
     assert(deserialized->compress_algo == config.compress_algo);
     assert(deserialized->memtable_ds == config.memtable_ds);
+    assert(deserialized->memtable_shards == config.memtable_shards);
+    assert(deserialized->filter_type == config.filter_type);
+    assert(deserialized->partitioned_index == config.partitioned_index);
+    assert(deserialized->hash_index == config.hash_index);
+    assert(deserialized->learned_index == config.learned_index);
 
     free(deserialized->name);
     free(deserialized);
@@ -645,6 +655,110 @@ void test_tidesdb_put_flush_close_get(bool compress, tidesdb_compression_algo_t
                                                  : "with hash table memtable");
 }
 
+void test_tidesdb_cf_handle_put_get_delete(bool compress, tidesdb_compression_algo_t algo,
+                                           bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    /* a handle for a column family that does not exist */
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "no_such_cf", &handle);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+    assert(handle == NULL);
+    tidesdb_err_free(err);
+
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+    assert(handle != NULL);
+
+    uint8_t key[] = "test_key";
+    uint8_t value[] = "test_value";
+    err = tidesdb_put_w_handle(handle, key, sizeof(key), value, sizeof(value), -1);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    /* the name based api and the handle api see the same column family */
+    uint8_t *retrieved_value = NULL;
+    size_t value_size;
+    err = tidesdb_get(db, "test_cf", key, sizeof(key), &retrieved_value, &value_size);
+    assert(err == NULL);
+    assert(value_size == sizeof(value));
+    assert(memcmp(retrieved_value, value, sizeof(value)) == 0);
+    free(retrieved_value);
+
+    err = tidesdb_get_w_handle(handle, key, sizeof(key), &retrieved_value, &value_size);
+    assert(err == NULL);
+    assert(memcmp(retrieved_value, value, sizeof(value)) == 0);
+    free(retrieved_value);
+
+    err = tidesdb_delete_w_handle(handle, key, sizeof(key));
+    assert(err == NULL);
+
+    err = tidesdb_get_w_handle(handle, key, sizeof(key), &retrieved_value, &value_size);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_KEY_NOT_FOUND);
+    tidesdb_err_free(err);
+
+    /* we drop the column family while the handle is still held */
+    err = tidesdb_drop_column_family(db, "test_cf");
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    /* the handle is still safe to use but the column family is gone */
+    err = tidesdb_put_w_handle(handle, key, sizeof(key), value, sizeof(value), -1);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+    tidesdb_err_free(err);
+
+    err = tidesdb_get_w_handle(handle, key, sizeof(key), &retrieved_value, &value_size);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+    tidesdb_err_free(err);
+
+    /* releasing the last reference frees the dropped column family */
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_cf_handle_put_get_delete %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
 void test_tidesdb_put_delete_get(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
                                  tidesdb_memtable_ds_t memtable_ds)
 {
@@ -1016,228 +1130,2837 @@ void test_tidesdb_put_flush_compact_get(bool compress, tidesdb_compression_algo_
                                                  : "with hash table memtable");
 }
 
-void test_tidesdb_txn_put_get(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
-                              tidesdb_memtable_ds_t memtable_ds)
+void test_tidesdb_direct_io(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                            tidesdb_memtable_ds_t memtable_ds)
 {
     tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.direct_io = true};
 
-    tidesdb_err_t *err = tidesdb_open("test_db", &db);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
     assert(err == NULL);
-
-    tidesdb_err_free(err);
+    assert(db->config.direct_io);
 
     err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
                                        bloom_filter, memtable_ds);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
-
     assert(err == NULL);
 
-    tidesdb_txn_t *txn = NULL;
-    err = tidesdb_txn_begin(db, &txn, "test_cf");
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
-
-    assert(err == NULL);
+    uint8_t key[20];
+    uint8_t value[1000];
 
-    uint8_t key[] = "test_key";
-    uint8_t value[] = "test_value";
-    err = tidesdb_txn_put(txn, key, sizeof(key), value, sizeof(value), -1);
-    if (err != NULL)
+    /* enough keys for a few flushes, each value is filled with a byte of its key */
+    int num_keys = 4000;
+    for (int i = 0; i < num_keys; i++)
     {
-        printf(RED "%s" RESET, err->message);
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        memset(value, i % 256, sizeof(value));
+        err = tidesdb_put(db, "test_cf", key, strlen((char *)key) + 1, value, sizeof(value), -1);
+        assert(err == NULL);
     }
 
+    /* compaction reads and writes sstables with direct I/O as well */
+    err = tidesdb_compact_sstables(db, "test_cf", 2);
     assert(err == NULL);
 
-    err = tidesdb_txn_commit(txn);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
+    err = tidesdb_close(db);
+    assert(err == NULL);
 
+    /* we reopen and read everything back through direct reads */
+    err = tidesdb_open_w_config("test_db", &config, &db);
     assert(err == NULL);
 
-    err = tidesdb_txn_free(txn);
-    if (err != NULL)
+    for (int i = 0; i < num_keys; i++)
     {
-        printf(RED "%s" RESET, err->message);
-    }
-
-    assert(err == NULL);
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
 
-    /* now we should be able to get the value */
-    uint8_t *retrieved_value = NULL;
-    size_t value_size;
+        err =
+            tidesdb_get(db, "test_cf", key, strlen((char *)key) + 1, &retrieved_value, &value_size);
+        assert(err == NULL);
+        assert(value_size == sizeof(value));
+        assert(retrieved_value[0] == i % 256);
+        assert(retrieved_value[value_size - 1] == i % 256);
 
-    err = tidesdb_get(db, "test_cf", key, sizeof(key), &retrieved_value, &value_size);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
+        free(retrieved_value);
     }
-    assert(err == NULL);
-
-    free(retrieved_value);
 
     err = tidesdb_close(db);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
     assert(err == NULL);
 
     _tidesdb_remove_directory("test_db");
-    printf(GREEN "test_tidesdb_txn_put_get %s %s %s passed\n" RESET,
+    printf(GREEN "test_tidesdb_direct_io %s %s %s passed\n" RESET,
            compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
            memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
                                                  : "with hash table memtable");
 }
 
-void test_tidesdb_txn_put_get_rollback_get(bool compress, tidesdb_compression_algo_t algo,
-                                           bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+void test_tidesdb_rate_limit(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                             tidesdb_memtable_ds_t memtable_ds)
 {
     tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.rate_limit_bytes_per_sec = 4 * 1024 * 1024};
 
-    tidesdb_err_t *err = tidesdb_open("test_db", &db);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
     assert(err == NULL);
-
-    tidesdb_err_free(err);
+    assert(db->rate_limiter->bytes_per_sec == 4 * 1024 * 1024);
 
     err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
                                        bloom_filter, memtable_ds);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
-
     assert(err == NULL);
 
-    tidesdb_txn_t *txn = NULL;
-    err = tidesdb_txn_begin(db, &txn, "test_cf");
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
-
-    assert(err == NULL);
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
 
-    uint8_t key[] = "test_key";
-    uint8_t value[] = "test_value";
-    err = tidesdb_txn_put(txn, key, sizeof(key), value, sizeof(value), -1);
-    if (err != NULL)
+    /* enough keys for a couple of flushes */
+    int num_keys = 2500;
+    for (int i = 0; i < num_keys; i++)
     {
-        printf(RED "%s" RESET, err->message);
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        err = tidesdb_put(db, "test_cf", key, strlen((char *)key) + 1, value, sizeof(value), -1);
+        assert(err == NULL);
     }
 
-    assert(err == NULL);
-
-    err = tidesdb_txn_commit(txn);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
+    /* flushes are charged at high priority */
+    assert(db->rate_limiter->total_bytes[RATE_LIMITER_PRIORITY_HIGH] > 1024 * 1024);
+    assert(db->rate_limiter->total_bytes[RATE_LIMITER_PRIORITY_LOW] == 0);
 
+    /* and compactions at low priority */
+    err = tidesdb_compact_sstables(db, "test_cf", 2);
     assert(err == NULL);
+    assert(db->rate_limiter->total_bytes[RATE_LIMITER_PRIORITY_LOW] > 0);
 
-    /* now we should be able to get the value */
-    uint8_t *retrieved_value = NULL;
-    size_t value_size;
-
-    err = tidesdb_get(db, "test_cf", key, sizeof(key), &retrieved_value, &value_size);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
+    /* the budget can be lifted at runtime */
+    err = tidesdb_set_rate_limit(db, 0);
     assert(err == NULL);
+    assert(db->rate_limiter->bytes_per_sec == 0);
 
-    free(retrieved_value);
-
-    /* now we rollback the transaction */
-    err = tidesdb_txn_rollback(txn);
-    if (err != NULL)
+    for (int i = 0; i < num_keys; i++)
     {
-        printf(RED "%s" RESET, err->message);
-    }
-
-    assert(err == NULL);
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
 
-    /* we should not be able to get the value anymore */
-    err = tidesdb_get(db, "test_cf", key, sizeof(key), &retrieved_value, &value_size);
-    assert(err != NULL), tidesdb_err_free(err);
+        err =
+            tidesdb_get(db, "test_cf", key, strlen((char *)key) + 1, &retrieved_value, &value_size);
+        assert(err == NULL);
+        assert(value_size == sizeof(value));
 
-    err = tidesdb_txn_free(txn);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
+        free(retrieved_value);
     }
 
     err = tidesdb_close(db);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
     assert(err == NULL);
 
     _tidesdb_remove_directory("test_db");
-    printf(GREEN "test_tidesdb_txn_put_get_rollback_get %s %s %s passed\n" RESET,
+    printf(GREEN "test_tidesdb_rate_limit %s %s %s passed\n" RESET,
            compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
            memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
                                                  : "with hash table memtable");
 }
 
-void test_tidesdb_txn_put_put_delete_get(bool compress, tidesdb_compression_algo_t algo,
+void *test_tidesdb_throttled_flush(void *arg)
+{
+    tidesdb_cf_handle_t *handle = arg;
+
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+    return NULL;
+}
+
+void test_tidesdb_rate_limit_flush_reads(bool compress, tidesdb_compression_algo_t algo,
                                          bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
 {
     tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.rate_limit_bytes_per_sec = 64 * 1024};
 
-    tidesdb_err_t *err = tidesdb_open("test_db", &db);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
     assert(err == NULL);
 
-    tidesdb_err_free(err);
-
     err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
                                        bloom_filter, memtable_ds);
-    if (err != NULL)
-    {
-        printf(RED "%s" RESET, err->message);
-    }
+    assert(err == NULL);
 
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
     assert(err == NULL);
 
-    tidesdb_txn_t *txn = NULL;
-    err = tidesdb_txn_begin(db, &txn, "test_cf");
-    if (err != NULL)
+    uint8_t key[20];
+    uint8_t value[1000];
+
+    /* about 800KB that doesn't compress, a flush waiting for the budget would hold the column
+     * family for 12 seconds */
+    srand(42);
+    for (int i = 0; i < 800; i++)
     {
-        printf(RED "%s" RESET, err->message);
+        for (size_t j = 0; j < sizeof(value); j++) value[j] = (uint8_t)rand();
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
     }
+    assert(atomic_load(&handle->cf->num_sstables) == 0);
 
-    assert(err == NULL);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-    uint8_t key1[] = "test_key1";
-    uint8_t value1[] = "test_value1";
-    err = tidesdb_txn_put(txn, key1, sizeof(key1), value1, sizeof(value1), -1);
-    if (err != NULL)
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, test_tidesdb_throttled_flush, handle) == 0);
+
+    /* reads go on while the flush runs */
+    for (int i = 0; i < 800; i++)
     {
-        printf(RED "%s" RESET, err->message);
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+        assert(tidesdb_get_status(handle, key, strlen((char *)key) + 1, &retrieved_value,
+                                  &value_size) == TIDESDB_SUCCESS);
+        assert(value_size == sizeof(value));
+        free(retrieved_value);
     }
 
-    assert(err == NULL);
+    pthread_join(thread, NULL);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    assert(end.tv_sec - start.tv_sec < 5);
+    assert(atomic_load(&handle->cf->num_sstables) == 1);
+
+    /* the flush was charged to the budget, compactions wait out the debt it left */
+    assert(db->rate_limiter->total_bytes[RATE_LIMITER_PRIORITY_HIGH] > 700 * 1024);
+    assert(db->rate_limiter->total_wait_us[RATE_LIMITER_PRIORITY_HIGH] == 0);
+    assert(db->rate_limiter->available < 0);
+
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_rate_limit_flush_reads %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+typedef struct
+{
+    tidesdb_cf_handle_t *handle;
+    atomic_bool done;
+} test_stalled_writer_args_t;
+
+void *test_tidesdb_stalled_writer(void *arg)
+{
+    test_stalled_writer_args_t *args = arg;
+    uint8_t key[] = "stalled_key";
+    uint8_t value[] = "stalled_value";
+
+    assert(tidesdb_put_status(args->handle, key, sizeof(key), value, sizeof(value), -1) ==
+           TIDESDB_SUCCESS);
+    atomic_store(&args->done, true);
+    return NULL;
+}
+
+void test_tidesdb_write_stall(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                              tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.stall_soft_sstables = 2, .stall_hard_sstables = 4};
+
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    /* we write until we reach the hard limit, writes past the soft limit are delayed */
+    int i = 0;
+    while (atomic_load(&handle->cf->num_sstables) < config.stall_hard_sstables)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i++);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+
+    tidesdb_stall_stats_t stats;
+    err = tidesdb_get_stall_stats(db, &stats);
+    assert(err == NULL);
+    assert(stats.delayed_writes > 0);
+    assert(stats.stopped_writes == 0);
+
+    /* the next write stops until a compaction brings the sstable count down */
+    test_stalled_writer_args_t args = {.handle = handle};
+    atomic_init(&args.done, false);
+
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, test_tidesdb_stalled_writer, &args) == 0);
+
+    usleep(300000);
+    assert(!atomic_load(&args.done));
+
+    err = tidesdb_get_stall_stats(db, &stats);
+    assert(err == NULL);
+    assert(stats.stopped_writes == 1);
+
+    err = tidesdb_compact_sstables_w_handle(handle, 2);
+    assert(err == NULL);
+
+    pthread_join(thread, NULL);
+    assert(atomic_load(&args.done));
+
+    err = tidesdb_get_stall_stats(db, &stats);
+    assert(err == NULL);
+    assert(stats.stall_us > 0);
+
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_write_stall %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_write_stall_timeout(bool compress, tidesdb_compression_algo_t algo,
+                                      bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.stall_hard_sstables = 2, .stall_timeout_ms = 200};
+
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    int i = 0;
+    while (atomic_load(&handle->cf->num_sstables) < config.stall_hard_sstables)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i++);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+
+    /* nobody compacts, so writes give up instead of waiting for good */
+    assert(tidesdb_put_status(handle, (uint8_t *)"stalled_key", 12, value, sizeof(value), -1) ==
+           TIDESDB_ERR_WRITE_STALLED);
+    assert(tidesdb_delete_status(handle, (uint8_t *)"key_0", 6) == TIDESDB_ERR_WRITE_STALLED);
+
+    tidesdb_txn_t *txn = NULL;
+    assert(tidesdb_txn_begin_w_handle(handle, &txn) == NULL);
+    assert(tidesdb_txn_put(txn, (uint8_t *)"stalled_key", 12, value, sizeof(value), -1) == NULL);
+    err = tidesdb_txn_commit(txn);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_WRITE_STALLED);
+    tidesdb_err_free(err);
+    assert(tidesdb_txn_free(txn) == NULL);
+
+    tidesdb_stall_stats_t stats;
+    err = tidesdb_get_stall_stats(db, &stats);
+    assert(err == NULL);
+    assert(stats.stopped_writes == 3);
+    assert(stats.stall_us >= 3 * 200 * 1000);
+
+    /* once compacted the writes go through again */
+    err = tidesdb_compact_sstables_w_handle(handle, 1);
+    assert(err == NULL);
+
+    assert(tidesdb_put_status(handle, (uint8_t *)"stalled_key", 12, value, sizeof(value), -1) ==
+           TIDESDB_SUCCESS);
+
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_write_stall_timeout %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_background_pool(bool compress, tidesdb_compression_algo_t algo,
+                                  bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+
+    /* the pool size is bounded */
+    tidesdb_config_t config = {.background_threads = THREAD_POOL_MAX_THREADS + 1};
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_INVALID_MAX_THREADS);
+    tidesdb_err_free(err);
+
+    /* the default is used when not configured */
+    err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+    assert(db->background_pool->num_threads == TDB_DEFAULT_BACKGROUND_THREADS);
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    config.background_threads = 1;
+    err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+    assert(db->background_pool->num_threads == 1);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    /* we write until we have two pairs to merge */
+    int num_keys = 0;
+    while (atomic_load(&handle->cf->num_sstables) < 4)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", num_keys++);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+
+    /* more merges in flight than pool threads, they queue on the single thread */
+    err = tidesdb_compact_sstables_w_handle(handle, 4);
+    assert(err == NULL);
+    assert(atomic_load(&handle->cf->num_sstables) == 2);
+    assert(db->background_pool->completed == 2);
+
+    for (int i = 0; i < num_keys; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+
+        assert(tidesdb_get_status(handle, key, strlen((char *)key) + 1, &retrieved_value,
+                                  &value_size) == TIDESDB_SUCCESS);
+        assert(value_size == sizeof(value));
+
+        free(retrieved_value);
+    }
+
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_background_pool %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_subcompactions(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                                 tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.background_threads = 2, .max_subcompactions = 4};
+
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+
+    /* two full sstables of distinct keys merge to about two flushes worth of entries */
+    int num_keys = 0;
+    while (atomic_load(&handle->cf->num_sstables) < 2)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", num_keys);
+        memset(value, num_keys % 256, sizeof(value));
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+        num_keys++;
+    }
+
+    /* the pair is split by key range into more than one sstable */
+    err = tidesdb_compact_sstables_w_handle(handle, 1);
+    assert(err == NULL);
+    int num_sstables = atomic_load(&handle->cf->num_sstables);
+    assert(num_sstables > 1 && num_sstables <= config.max_subcompactions);
+
+    /* every key is still there once and in order */
+    tidesdb_cursor_t *cursor = NULL;
+    err = tidesdb_cursor_init_w_handle(handle, &cursor);
+    assert(err == NULL);
+
+    int count = 0;
+    do
+    {
+        uint8_t *retrieved_key = NULL;
+        size_t key_size;
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+
+        err = tidesdb_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size);
+        assert(err == NULL);
+
+        assert(atoi((char *)retrieved_key + 4) == count);
+        assert(retrieved_value[0] == (uint8_t)(count % 256));
+        count++;
+
+        free(retrieved_key);
+        free(retrieved_value);
+    } while ((err = tidesdb_cursor_next(cursor)) == NULL);
+
+    assert(err->code == TIDESDB_ERR_AT_END_OF_CURSOR);
+    tidesdb_err_free(err);
+    assert(count == num_keys);
+
+    err = tidesdb_cursor_free(cursor);
+    assert(err == NULL);
+
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    /* the split outputs are in the manifest */
+    err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+    assert(atomic_load(&handle->cf->num_sstables) == num_sstables);
+
+    for (int i = 0; i < num_keys; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+
+        assert(tidesdb_get_status(handle, key, strlen((char *)key) + 1, &retrieved_value,
+                                  &value_size) == TIDESDB_SUCCESS);
+        assert(value_size == sizeof(value));
+        assert(retrieved_value[0] == (uint8_t)(i % 256));
+
+        free(retrieved_value);
+    }
+
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_subcompactions %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_cursor_seek(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                              tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+
+    /* even keys only, enough of them to spread over sstables and the memtable */
+    int num_keys = 3000;
+    for (int i = 0; i < num_keys; i += 2)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        memset(value, i % 256, sizeof(value));
+        err = tidesdb_put(db, "test_cf", key, strlen((char *)key) + 1, value, sizeof(value), -1);
+        assert(err == NULL);
+    }
+
+    /* a deleted key is skipped by a seek landing on it */
+    snprintf((char *)key, sizeof(key), "key_%05d", 100);
+    err = tidesdb_delete(db, "test_cf", key, strlen((char *)key) + 1);
+    assert(err == NULL);
+
+    tidesdb_cursor_t *cursor = NULL;
+    err = tidesdb_cursor_init(db, "test_cf", &cursor);
+    assert(err == NULL);
+
+    /* seeks in either direction land on the first key at or past the target */
+    int targets[] = {2001, 7, 2000, 99, 0, 2998};
+    int expected[] = {2002, 8, 2000, 102, 0, 2998};
+    for (int t = 0; t < (int)(sizeof(targets) / sizeof(targets[0])); t++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", targets[t]);
+        err = tidesdb_cursor_seek(cursor, key, strlen((char *)key) + 1);
+        assert(err == NULL);
+
+        uint8_t *retrieved_key = NULL;
+        size_t key_size;
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+
+        err = tidesdb_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size);
+        assert(err == NULL);
+        assert(atoi((char *)retrieved_key + 4) == expected[t]);
+        assert(retrieved_value[0] == (uint8_t)(expected[t] % 256));
+        free(retrieved_key);
+        free(retrieved_value);
+    }
+
+    /* the cursor moves on from where the seek left it */
+    snprintf((char *)key, sizeof(key), "key_%05d", 1001);
+    err = tidesdb_cursor_seek(cursor, key, strlen((char *)key) + 1);
+    assert(err == NULL);
+
+    err = tidesdb_cursor_next(cursor);
+    assert(err == NULL);
+
+    uint8_t *retrieved_key = NULL;
+    size_t key_size;
+    uint8_t *retrieved_value = NULL;
+    size_t value_size;
+
+    err = tidesdb_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size);
+    assert(err == NULL);
+    assert(atoi((char *)retrieved_key + 4) == 1004);
+    free(retrieved_key);
+    free(retrieved_value);
+
+    err = tidesdb_cursor_prev(cursor);
+    assert(err == NULL);
+    err = tidesdb_cursor_prev(cursor);
+    assert(err == NULL);
+
+    err = tidesdb_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size);
+    assert(err == NULL);
+    assert(atoi((char *)retrieved_key + 4) == 1000);
+    free(retrieved_key);
+    free(retrieved_value);
+
+    /* nothing past the last key */
+    snprintf((char *)key, sizeof(key), "key_%05d", num_keys);
+    err = tidesdb_cursor_seek(cursor, key, strlen((char *)key) + 1);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_AT_END_OF_CURSOR);
+    tidesdb_err_free(err);
+
+    err = tidesdb_cursor_free(cursor);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_cursor_seek %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_stats(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                        tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_stats_t stats;
+    err = tidesdb_get_stats(db, "test_cf", &stats);
+    assert(err == NULL);
+    assert(stats.puts == 0 && stats.gets == 0 && stats.wal_bytes == 0);
+    assert(stats.get_latency.count == 0);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    /* enough keys for a couple of flushes */
+    int num_keys = 2500;
+    for (int i = 0; i < num_keys; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        err = tidesdb_put(db, "test_cf", key, strlen((char *)key) + 1, value, sizeof(value), -1);
+        assert(err == NULL);
+    }
+
+    err = tidesdb_get_stats(db, "test_cf", &stats);
+    assert(err == NULL);
+    assert(stats.puts == (uint64_t)num_keys);
+    assert(stats.put_latency.count == (uint64_t)num_keys);
+    assert(stats.put_latency.min <= stats.put_latency.p50);
+    assert(stats.put_latency.p50 <= stats.put_latency.p99);
+    assert(stats.put_latency.p99 <= stats.put_latency.max);
+    assert(stats.wal_bytes > (uint64_t)num_keys * sizeof(value) || compress);
+    assert(stats.flushes >= 2);
+    assert(stats.flush_bytes > 0);
+    assert(stats.bytes_written == stats.flush_bytes);
+    assert(stats.compactions == 0);
+
+    err = tidesdb_compact_sstables(db, "test_cf", 2);
+    assert(err == NULL);
+
+    err = tidesdb_get_stats(db, "test_cf", &stats);
+    assert(err == NULL);
+    assert(stats.compactions >= 1);
+    assert(stats.compaction_bytes > 0);
+    assert(stats.bytes_written == stats.flush_bytes + stats.compaction_bytes);
+
+    /* a key from an sstable and a key that is nowhere */
+    uint8_t *retrieved_value = NULL;
+    size_t value_size;
+    err = tidesdb_get(db, "test_cf", (uint8_t *)"key_0", 6, &retrieved_value, &value_size);
+    assert(err == NULL);
+    free(retrieved_value);
+
+    err = tidesdb_get(db, "test_cf", (uint8_t *)"missing", 8, &retrieved_value, &value_size);
+    assert(err != NULL);
+    tidesdb_err_free(err);
+
+    err = tidesdb_get_stats(db, "test_cf", &stats);
+    assert(err == NULL);
+    assert(stats.gets == 2);
+    assert(stats.get_latency.count == 2);
+    assert(stats.memtable_hits == 0);
+    assert(stats.sstables_probed >= 2);
+    assert(stats.block_reads >= 1);
+    assert(stats.bytes_read > 0);
+    if (bloom_filter)
+    {
+        /* every check either let the get in or ruled the sstable out */
+        assert(stats.bloom_checks == stats.sstables_probed);
+        assert(stats.bloom_negatives + stats.bloom_false_positives < stats.bloom_checks);
+    }
+    else
+    {
+        assert(stats.bloom_checks == 0);
+    }
+
+    /* the memtable answers a key written since the last flush */
+    err = tidesdb_put(db, "test_cf", (uint8_t *)"hot", 4, value, 10, -1);
+    assert(err == NULL);
+    err = tidesdb_get(db, "test_cf", (uint8_t *)"hot", 4, &retrieved_value, &value_size);
+    assert(err == NULL);
+    free(retrieved_value);
+
+    err = tidesdb_delete(db, "test_cf", (uint8_t *)"hot", 4);
+    assert(err == NULL);
+
+    tidesdb_txn_t *txn = NULL;
+    err = tidesdb_txn_begin(db, &txn, "test_cf");
+    assert(err == NULL);
+    err = tidesdb_txn_put(txn, (uint8_t *)"txn_key", 8, value, 10, -1);
+    assert(err == NULL);
+    err = tidesdb_txn_commit(txn);
+    assert(err == NULL);
+    (void)tidesdb_txn_free(txn);
+
+    /* the handle sees the same statistics */
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    err = tidesdb_get_stats_w_handle(handle, &stats);
+    assert(err == NULL);
+    assert(stats.memtable_hits == 1);
+    assert(stats.deletes == 1);
+    assert(stats.puts == (uint64_t)num_keys + 1);
+    assert(stats.put_latency.count == (uint64_t)num_keys + 2);
+    assert(stats.commits == 1);
+    assert(stats.commit_latency.count == 1);
+
+    err = tidesdb_get_stats_w_handle(handle, NULL);
+    assert(err != NULL);
+    tidesdb_err_free(err);
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_get_stats(db, "no_such_cf", &stats);
+    assert(err != NULL);
+    tidesdb_err_free(err);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_stats %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+typedef struct
+{
+    atomic_int begins[TDB_TRACE_WAL_SYNC + 1];
+    atomic_int ends[TDB_TRACE_WAL_SYNC + 1];
+} test_trace_counts_t;
+
+void test_trace(TIDESDB_TRACE_EVENT event, bool begin, const char *column_family, void *arg)
+{
+    test_trace_counts_t *counts = arg;
+    assert(strcmp(column_family, "test_cf") == 0);
+
+    if (begin)
+        (void)atomic_fetch_add(&counts->begins[event], 1);
+    else
+        (void)atomic_fetch_add(&counts->ends[event], 1);
+}
+
+void test_tidesdb_perf_context(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                               tidesdb_memtable_ds_t memtable_ds)
+{
+    test_trace_counts_t counts;
+    for (int e = 0; e <= TDB_TRACE_WAL_SYNC; e++)
+    {
+        atomic_init(&counts.begins[e], 0);
+        atomic_init(&counts.ends[e], 0);
+    }
+
+    tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.trace = test_trace, .trace_arg = &counts};
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    /* the perf context is off until the thread enables it */
+    tidesdb_perf_context_t ctx;
+    err = tidesdb_perf_context_reset();
+    assert(err == NULL);
+    err = tidesdb_put(db, "test_cf", (uint8_t *)"cold", 5, value, 10, -1);
+    assert(err == NULL);
+    err = tidesdb_get_perf_context(&ctx);
+    assert(err == NULL);
+    assert(ctx.wal_append_ns == 0 && ctx.db_lock_wait_ns == 0 && ctx.cf_lock_wait_ns == 0);
+
+    err = tidesdb_perf_context_enable(true);
+    assert(err == NULL);
+    err = tidesdb_perf_context_reset();
+    assert(err == NULL);
+
+    /* enough keys for a couple of flushes */
+    int num_keys = 2500;
+    for (int i = 0; i < num_keys; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        err = tidesdb_put(db, "test_cf", key, strlen((char *)key) + 1, value, sizeof(value), -1);
+        assert(err == NULL);
+    }
+
+    err = tidesdb_get_perf_context(&ctx);
+    assert(err == NULL);
+    assert(ctx.wal_append_ns > 0);
+    assert(ctx.block_reads == 0 && ctx.bloom_checks == 0);
+    assert(atomic_load(&counts.begins[TDB_TRACE_FLUSH]) >= 2);
+    assert(atomic_load(&counts.begins[TDB_TRACE_FLUSH]) ==
+           atomic_load(&counts.ends[TDB_TRACE_FLUSH]));
+
+    err = tidesdb_compact_sstables(db, "test_cf", 2);
+    assert(err == NULL);
+    assert(atomic_load(&counts.begins[TDB_TRACE_COMPACTION]) == 1);
+    assert(atomic_load(&counts.ends[TDB_TRACE_COMPACTION]) == 1);
+
+    /* a get answered by an sstable */
+    err = tidesdb_perf_context_reset();
+    assert(err == NULL);
+
+    uint8_t *retrieved_value = NULL;
+    size_t value_size;
+    err = tidesdb_get(db, "test_cf", (uint8_t *)"key_0", 6, &retrieved_value, &value_size);
+    assert(err == NULL);
+    free(retrieved_value);
+
+    err = tidesdb_get_perf_context(&ctx);
+    assert(err == NULL);
+    assert(ctx.wal_append_ns == 0);
+    assert(ctx.memtable_search_ns > 0);
+    assert(ctx.block_reads >= 1);
+    assert(ctx.block_read_ns > 0);
+    assert(ctx.deserialize_ns > 0);
+    assert((ctx.decompress_ns > 0) == compress);
+    assert((ctx.bloom_checks > 0) == bloom_filter);
+    assert((ctx.bloom_check_ns > 0) == bloom_filter);
+
+    /* disabled again nothing more is timed */
+    err = tidesdb_perf_context_enable(false);
+    assert(err == NULL);
+    err = tidesdb_get(db, "test_cf", (uint8_t *)"key_0", 6, &retrieved_value, &value_size);
+    assert(err == NULL);
+    free(retrieved_value);
+
+    tidesdb_perf_context_t after;
+    err = tidesdb_get_perf_context(&after);
+    assert(err == NULL);
+    assert(memcmp(&ctx, &after, sizeof(ctx)) == 0);
+
+    err = tidesdb_get_perf_context(NULL);
+    assert(err != NULL);
+    tidesdb_err_free(err);
+
+    /* the wal fsync thread syncs every TDB_SYNC_INTERVAL */
+    (void)usleep(600000);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    assert(atomic_load(&counts.begins[TDB_TRACE_WAL_SYNC]) > 0);
+    assert(atomic_load(&counts.begins[TDB_TRACE_WAL_SYNC]) ==
+           atomic_load(&counts.ends[TDB_TRACE_WAL_SYNC]));
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_perf_context %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+typedef struct
+{
+    int flush_begins;
+    int flush_completions;
+    tidesdb_flush_info_t flush_begin;
+    tidesdb_flush_info_t flush;
+    int compaction_begins;
+    int compaction_completions;
+    tidesdb_compaction_info_t compaction_begin;
+    tidesdb_compaction_info_t compaction;
+    uint64_t input_ids[8];
+    int stall_changes;
+    tidesdb_write_stall_info_t stall;
+    int background_errors;
+} test_listener_events_t;
+
+void test_on_flush_begin(const tidesdb_flush_info_t *info, void *arg)
+{
+    test_listener_events_t *events = arg;
+    events->flush_begins++;
+    events->flush_begin = *info;
+}
+
+void test_on_flush_completed(const tidesdb_flush_info_t *info, void *arg)
+{
+    test_listener_events_t *events = arg;
+    events->flush_completions++;
+    events->flush = *info;
+}
+
+void test_on_compaction_begin(const tidesdb_compaction_info_t *info, void *arg)
+{
+    test_listener_events_t *events = arg;
+    events->compaction_begins++;
+    events->compaction_begin = *info;
+
+    /* the info is only valid during the call so we keep our own copy of the ids */
+    assert(info->num_inputs <= 8);
+    memcpy(events->input_ids, info->input_ids, sizeof(uint64_t) * info->num_inputs);
+}
+
+void test_on_compaction_completed(const tidesdb_compaction_info_t *info, void *arg)
+{
+    test_listener_events_t *events = arg;
+    events->compaction_completions++;
+    events->compaction = *info;
+
+    assert(info->num_inputs == events->compaction_begin.num_inputs);
+    for (int i = 0; i < info->num_inputs; i++) assert(info->input_ids[i] == events->input_ids[i]);
+    for (int i = 0; i < info->num_outputs; i++)
+        for (int j = 0; j < info->num_inputs; j++)
+            assert(info->output_ids[i] != info->input_ids[j]);
+}
+
+void test_on_write_stall_change(const tidesdb_write_stall_info_t *info, void *arg)
+{
+    test_listener_events_t *events = arg;
+    events->stall_changes++;
+    events->stall = *info;
+}
+
+void test_on_background_error(const tidesdb_background_error_info_t *info, void *arg)
+{
+    (void)info;
+    test_listener_events_t *events = arg;
+    events->background_errors++;
+}
+
+void test_tidesdb_event_listener(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                                 tidesdb_memtable_ds_t memtable_ds)
+{
+    test_listener_events_t events = {0};
+
+    tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.stall_soft_sstables = 2,
+                               .listener = {.on_flush_begin = test_on_flush_begin,
+                                            .on_flush_completed = test_on_flush_completed,
+                                            .on_compaction_begin = test_on_compaction_begin,
+                                            .on_compaction_completed = test_on_compaction_completed,
+                                            .on_write_stall_change = test_on_write_stall_change,
+                                            .on_background_error = test_on_background_error,
+                                            .arg = &events}};
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    /* the first sstable holds 10 tombstones and up to 5 expired keys */
+    int i = 0;
+    for (; i < 50; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+    for (int d = 0; d < 10; d++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", d);
+        assert(tidesdb_delete_status(handle, key, strlen((char *)key) + 1) == TIDESDB_SUCCESS);
+    }
+    for (int e = 0; e < 5; e++)
+    {
+        snprintf((char *)key, sizeof(key), "expired_%d", e);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, 10,
+                                  time(NULL) - 10) == TIDESDB_SUCCESS);
+    }
+
+    /* the second flush reaches the soft stall limit */
+    while (atomic_load(&handle->cf->num_sstables) < 2)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i++);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+
+    assert(events.flush_begins == 2);
+    assert(events.flush_completions == 2);
+    assert(strcmp(events.flush.column_family, "test_cf") == 0);
+    assert(events.flush_begin.memtable_bytes > 0);
+    assert(events.flush_begin.sstable_id == 0);
+    assert(events.flush.status == 0);
+    assert(events.flush.bytes_written > 0);
+    assert(events.flush.sstable_id == handle->cf->version->sstables[1]->id);
+
+    assert(events.stall_changes == 1);
+    assert(events.stall.prev == TDB_STALL_NORMAL);
+    assert(events.stall.cur == TDB_STALL_DELAYED);
+    assert(events.stall.num_sstables == 2);
+
+    err = tidesdb_compact_sstables(db, "test_cf", 2);
+    assert(err == NULL);
+
+    assert(events.compaction_begins == 1);
+    assert(events.compaction_begin.num_inputs == 2);
+    assert(events.compaction_begin.num_outputs == 0);
+    assert(events.compaction_begin.bytes_in > 0);
+
+    assert(events.compaction_completions == 1);
+    assert(events.compaction.status == 0);
+    assert(events.compaction.num_outputs == 1);
+    assert(events.compaction.bytes_in == events.compaction_begin.bytes_in);
+    assert(events.compaction.bytes_out > 0);
+    assert(events.compaction.bytes_out < events.compaction.bytes_in);
+    assert(events.compaction.dropped_tombstones == 10);
+    /* a hash table memtable leaves keys that expired before the flush out of the sstable */
+    assert(events.compaction.expired_keys == (memtable_ds == TDB_MEMTABLE_SKIP_LIST ? 5 : 0));
+
+    /* the compaction brought the column family back under the soft limit */
+    assert(events.stall_changes == 2);
+    assert(events.stall.prev == TDB_STALL_DELAYED);
+    assert(events.stall.cur == TDB_STALL_NORMAL);
+    assert(events.stall.num_sstables == 1);
+
+    assert(events.background_errors == 0);
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_event_listener %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+typedef struct
+{
+    tidesdb_t *db;
+    int calls;
+} test_reentrant_listener_t;
+
+/* we read and write the column family from inside the callbacks, they run without its locks */
+void test_reenter_column_family(const char *column_family, void *arg)
+{
+    test_reentrant_listener_t *listener = arg;
+    listener->calls++;
+
+    tidesdb_stats_t stats;
+    tidesdb_err_t *err = tidesdb_get_stats(listener->db, column_family, &stats);
+    assert(err == NULL);
+
+    uint8_t *value = NULL;
+    size_t value_size = 0;
+    err = tidesdb_get(listener->db, column_family, (uint8_t *)"key_0", 6, &value, &value_size);
+    assert(err == NULL);
+    free(value);
+
+    err = tidesdb_put(listener->db, column_family, (uint8_t *)"listener_key", 13,
+                      (uint8_t *)"listener_value", 15, -1);
+    assert(err == NULL);
+}
+
+void test_reenter_on_flush(const tidesdb_flush_info_t *info, void *arg)
+{
+    test_reenter_column_family(info->column_family, arg);
+}
+
+void test_reenter_on_compaction_completed(const tidesdb_compaction_info_t *info, void *arg)
+{
+    test_reenter_column_family(info->column_family, arg);
+}
+
+void test_reenter_on_write_stall_change(const tidesdb_write_stall_info_t *info, void *arg)
+{
+    test_reenter_column_family(info->column_family, arg);
+}
+
+void test_tidesdb_event_listener_reentry(bool compress, tidesdb_compression_algo_t algo,
+                                         bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    test_reentrant_listener_t listener = {0};
+
+    tidesdb_t *db = NULL;
+    tidesdb_config_t config = {
+        .stall_soft_sstables = 2,
+        .listener = {.on_flush_begin = test_reenter_on_flush,
+                     .on_flush_completed = test_reenter_on_flush,
+                     .on_compaction_completed = test_reenter_on_compaction_completed,
+                     .on_write_stall_change = test_reenter_on_write_stall_change,
+                     .arg = &listener}};
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+    listener.db = db;
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    /* two flushes, each reported from the writer once it released the column family */
+    int i = 0;
+    while (atomic_load(&handle->cf->num_sstables) < 2)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i++);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+
+    /* 2 flushes of 2 callbacks and the stall change to delayed */
+    assert(listener.calls == 5);
+
+    err = tidesdb_compact_sstables(db, "test_cf", 2);
+    assert(err == NULL);
+
+    /* the stall change back to normal and the completed compaction */
+    assert(listener.calls == 7);
+
+    uint8_t *retrieved = NULL;
+    size_t retrieved_size = 0;
+    err = tidesdb_get(db, "test_cf", (uint8_t *)"listener_key", 13, &retrieved, &retrieved_size);
+    assert(err == NULL);
+    assert(retrieved_size == 15);
+    free(retrieved);
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_event_listener_reentry %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_memory_usage(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                               tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.write_buffer_budget = 64 * 1024};
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+
+    /* the flush threshold alone would never flush, only the budget does */
+    err = tidesdb_create_column_family(db, "test_cf_a", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+    err = tidesdb_create_column_family(db, "test_cf_b", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *a = NULL;
+    tidesdb_cf_handle_t *b = NULL;
+    assert(tidesdb_get_cf_handle(db, "test_cf_a", &a) == NULL);
+    assert(tidesdb_get_cf_handle(db, "test_cf_b", &b) == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    for (int i = 0; i < 10; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        assert(tidesdb_put_status(b, key, strlen((char *)key) + 1, value, sizeof(value), -1) ==
+               TIDESDB_SUCCESS);
+    }
+
+    tidesdb_stats_t stats_a;
+    tidesdb_stats_t stats_b;
+    tidesdb_memory_usage_t usage;
+    assert(tidesdb_get_stats_w_handle(b, &stats_b) == NULL);
+    assert(stats_b.memtable_bytes >= 10 * sizeof(value));
+
+    /* open transactions hold their operations until they are freed */
+    tidesdb_txn_t *txn = NULL;
+    assert(tidesdb_txn_begin_w_handle(b, &txn) == NULL);
+    assert(tidesdb_txn_put(txn, (uint8_t *)"txn_key", 8, value, sizeof(value), -1) == NULL);
+    assert(tidesdb_get_stats_w_handle(b, &stats_b) == NULL);
+    assert(stats_b.txn_buffer_bytes >= sizeof(value));
+
+    assert(tidesdb_get_memory_usage(db, &usage) == NULL);
+    assert(usage.memtable_bytes == stats_b.memtable_bytes);
+    assert(usage.txn_buffer_bytes == stats_b.txn_buffer_bytes);
+    assert(usage.total_bytes >= usage.memtable_bytes + usage.txn_buffer_bytes);
+    assert(usage.write_buffer_budget == 64 * 1024);
+
+    assert(tidesdb_txn_commit(txn) == NULL);
+    assert(tidesdb_txn_free(txn) == NULL);
+    assert(tidesdb_get_stats_w_handle(b, &stats_b) == NULL);
+    assert(stats_b.txn_buffer_bytes == 0);
+
+    /* every write leaves the memtables of both column families within the budget */
+    for (int i = 0; i < 150; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        assert(tidesdb_put_status(a, key, strlen((char *)key) + 1, value, sizeof(value), -1) ==
+               TIDESDB_SUCCESS);
+
+        assert(tidesdb_get_memory_usage(db, &usage) == NULL);
+        assert(usage.memtable_bytes <= 64 * 1024);
+    }
+
+    assert(tidesdb_get_stats_w_handle(a, &stats_a) == NULL);
+    assert(stats_a.budget_flushes >= 2);
+    assert(stats_a.flushes == stats_a.budget_flushes);
+    assert(atomic_load(&a->cf->num_sstables) >= 2);
+
+    /* the flushed keys are still there */
+    uint8_t *got = NULL;
+    size_t got_size = 0;
+    assert(tidesdb_get_w_handle(a, (uint8_t *)"key_0", 6, &got, &got_size) == NULL);
+    assert(got_size == sizeof(value));
+    free(got);
+
+    err = tidesdb_compact_sstables(db, "test_cf_a", 2);
+    assert(err == NULL);
+
+    /* the filters and merge tables are only held while they are in use */
+    assert(tidesdb_get_stats_w_handle(a, &stats_a) == NULL);
+    assert(stats_a.bloom_filter_bytes == 0);
+    assert(stats_a.merge_table_bytes == 0);
+
+    /* a dropped column family no longer counts */
+    assert(tidesdb_get_stats_w_handle(b, &stats_b) == NULL);
+    assert(tidesdb_get_stats_w_handle(a, &stats_a) == NULL);
+    (void)tidesdb_release_cf_handle(a);
+    assert(tidesdb_drop_column_family(db, "test_cf_a") == NULL);
+    assert(atomic_load(&db->memtable_bytes) == stats_b.memtable_bytes);
+
+    (void)tidesdb_release_cf_handle(b);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_memory_usage %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_sstable_stats(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                                tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[100];
+    memset(value, 'v', sizeof(value));
+
+    /* the first sstable holds 100 keys and the second deletes 90 of them */
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%03d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    for (int i = 10; i < 100; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%03d", i);
+        assert(tidesdb_delete_status(handle, key, strlen((char *)key) + 1) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    /* the merge drops the deletes so its filter is sized for the 10 keys left */
+    err = tidesdb_compact_sstables(db, "test_cf", 1);
+    assert(err == NULL);
+
+    tidesdb_sstable_stats_t *stats = NULL;
+    int num_sstables = 0;
+    assert(tidesdb_get_sstable_stats_w_handle(handle, &stats, &num_sstables) == NULL);
+    assert(num_sstables == 1);
+    assert(stats[0].id == handle->cf->version->sstables[0]->id);
+    assert(stats[0].size > 0);
+
+    bloom_filter_t *expected = NULL;
+    assert(bloom_filter_new(&expected, TDB_BLOOMFILTER_P, 10) == 0);
+    assert(stats[0].bloom_bits == (bloom_filter ? expected->m : 0));
+    assert(stats[0].bloom_hashes == (bloom_filter ? expected->h : 0));
+    (void)bloom_filter_free(expected);
+    if (bloom_filter)
+    {
+        assert(stats[0].bloom_bits_set > 0 && stats[0].bloom_bits_set <= stats[0].bloom_bits);
+        assert(stats[0].bloom_fill_ratio > 0.0 && stats[0].bloom_fill_ratio < 1.0);
+        assert(stats[0].bloom_estimated_fpr < 0.1);
+    }
+    assert(stats[0].bloom_checks == 0);
+    free(stats);
+
+    /* every check is useful, a false positive or finds the key */
+    int found = 0;
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%03d", i);
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        err = tidesdb_get_w_handle(handle, key, strlen((char *)key) + 1, &got, &got_size);
+        if (err == NULL)
+        {
+            found++;
+            free(got);
+        }
+        else
+        {
+            (void)tidesdb_err_free(err);
+        }
+    }
+    assert(found == 10);
+
+    assert(tidesdb_get_sstable_stats(db, "test_cf", &stats, &num_sstables) == NULL);
+    assert(num_sstables == 1);
+    if (bloom_filter)
+    {
+        assert(stats[0].bloom_checks == 200);
+        assert(stats[0].bloom_negatives + stats[0].bloom_false_positives + (uint64_t)found ==
+               stats[0].bloom_checks);
+        assert(stats[0].bloom_negatives > stats[0].bloom_false_positives);
+    }
+    else
+    {
+        assert(stats[0].bloom_checks == 0);
+    }
+
+    tidesdb_stats_t cf_stats;
+    assert(tidesdb_get_stats_w_handle(handle, &cf_stats) == NULL);
+    assert(cf_stats.bloom_negatives == stats[0].bloom_negatives);
+    assert(cf_stats.bloom_false_positives == stats[0].bloom_false_positives);
+    free(stats);
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_sstable_stats %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_binary_fuse_filter(bool compress, tidesdb_compression_algo_t algo,
+                                     bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    tidesdb_column_family_config_t config = {.name = "test_cf",
+                                             .flush_threshold = 1024 * 1024,
+                                             .max_level = 12,
+                                             .probability = 0.24f,
+                                             .compressed = compress,
+                                             .compress_algo = algo,
+                                             .memtable_ds = memtable_ds,
+                                             .bloom_filter = bloom_filter,
+                                             .memtable_shards = 1,
+                                             .filter_type = 7};
+
+    /* an unknown filter type is refused */
+    err = tidesdb_create_column_family_w_config(db, &config);
+    assert(err != NULL);
+    (void)tidesdb_err_free(err);
+
+    config.filter_type = TDB_FILTER_BINARY_FUSE;
+    err = tidesdb_create_column_family_w_config(db, &config);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+    assert(handle->cf->config.filter_type == TDB_FILTER_BINARY_FUSE);
+
+    /* without filters there is nothing of the fuse filter to check, the lookups would only scan */
+    if (!bloom_filter)
+    {
+        (void)tidesdb_release_cf_handle(handle);
+        err = tidesdb_close(db);
+        assert(err == NULL);
+        _tidesdb_remove_directory("test_db");
+        printf(GREEN "test_tidesdb_binary_fuse_filter %s %s passed\n" RESET,
+               compress ? "with compression" : "",
+               memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                     : "with hash table memtable");
+        return;
+    }
+
+    uint8_t key[20];
+    uint8_t value[100];
+    memset(value, 'v', sizeof(value));
+
+    for (int i = 0; i < 5000; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+    (void)tidesdb_release_cf_handle(handle);
+
+    /* the filter type is kept with the column family config */
+    err = tidesdb_close(db);
+    assert(err == NULL);
+    err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+    assert(handle->cf->config.filter_type == TDB_FILTER_BINARY_FUSE);
+
+    /* every key is found and about 1 in 256 missing keys gets past the filter */
+    for (int i = 0; i < 10000; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        int rc = tidesdb_get_status(handle, key, strlen((char *)key) + 1, &got, &got_size);
+        assert(rc == (i < 5000 ? TIDESDB_SUCCESS : TIDESDB_ERR_KEY_NOT_FOUND));
+        free(got);
+    }
+
+    tidesdb_sstable_stats_t *stats = NULL;
+    int num_sstables = 0;
+    assert(tidesdb_get_sstable_stats_w_handle(handle, &stats, &num_sstables) == NULL);
+    assert(num_sstables == 1);
+
+    /* smaller than a bloom filter with the same false positive rate */
+    bloom_filter_t *bloom = NULL;
+    assert(bloom_filter_new(&bloom, 1.0 / 256, 5000) == 0);
+    assert(stats[0].filter_type == TDB_FILTER_BINARY_FUSE);
+    assert(stats[0].bloom_bits > 0 && stats[0].bloom_bits < bloom->m);
+    assert(stats[0].bloom_hashes == 3);
+    assert(stats[0].bloom_checks == 10000);
+    assert(stats[0].bloom_negatives + stats[0].bloom_false_positives == 5000);
+    assert(stats[0].bloom_false_positives < 100);
+    (void)bloom_filter_free(bloom);
+    free(stats);
+
+    /* the merge drops the deletes and builds its filter from the keys left */
+    for (int i = 0; i < 2500; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        assert(tidesdb_delete_status(handle, key, strlen((char *)key) + 1) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    err = tidesdb_compact_sstables_w_handle(handle, 1);
+    assert(err == NULL);
+
+    for (int i = 0; i < 5000; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        int rc = tidesdb_get_status(handle, key, strlen((char *)key) + 1, &got, &got_size);
+        assert(rc == (i < 2500 ? TIDESDB_ERR_KEY_NOT_FOUND : TIDESDB_SUCCESS));
+        free(got);
+    }
+
+    assert(tidesdb_get_sstable_stats_w_handle(handle, &stats, &num_sstables) == NULL);
+    assert(num_sstables == 1);
+    assert(stats[0].bloom_negatives > 2000);
+    free(stats);
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_binary_fuse_filter %s with fuse filter %s passed\n" RESET,
+           compress ? "with compression" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_partitioned_index(bool compress, tidesdb_compression_algo_t algo,
+                                    bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    tidesdb_column_family_config_t config = {.name = "test_cf",
+                                             .flush_threshold = 1024 * 1024,
+                                             .max_level = 12,
+                                             .probability = 0.24f,
+                                             .compressed = compress,
+                                             .compress_algo = algo,
+                                             .memtable_ds = memtable_ds,
+                                             .bloom_filter = bloom_filter,
+                                             .memtable_shards = 1,
+                                             .filter_type = TDB_FILTER_BLOOM,
+                                             .partitioned_index = true};
+    err = tidesdb_create_column_family_w_config(db, &config);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[100];
+    memset(value, 'v', sizeof(value));
+
+    /* the even keys, the odd ones fall between them */
+    for (int i = 0; i < 2000; i += 2)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    /* 1000 keys make 4 partitions, the index is reopened from the footer */
+    for (int reopen = 0; reopen < 2; reopen++)
+    {
+        for (int i = 0; i < 2000; i++)
+        {
+            snprintf((char *)key, sizeof(key), "key_%05d", i);
+            uint8_t *got = NULL;
+            size_t got_size = 0;
+            int rc = tidesdb_get_status(handle, key, strlen((char *)key) + 1, &got, &got_size);
+            assert(rc == (i % 2 == 0 ? TIDESDB_SUCCESS : TIDESDB_ERR_KEY_NOT_FOUND));
+            assert(i % 2 != 0 || (got_size == sizeof(value) && got[0] == 'v'));
+            free(got);
+        }
+
+        /* a key past the last partition never reaches a block */
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        assert(tidesdb_get_status(handle, (uint8_t *)"zzz", 4, &got, &got_size) ==
+               TIDESDB_ERR_KEY_NOT_FOUND);
+
+        tidesdb_sstable_stats_t *stats = NULL;
+        int num_sstables = 0;
+        assert(tidesdb_get_sstable_stats_w_handle(handle, &stats, &num_sstables) == NULL);
+        assert(num_sstables == 1);
+        assert(stats[0].index_partitions == 4);
+        assert(stats[0].index_bytes > 0);
+        if (bloom_filter)
+        {
+            assert(stats[0].bloom_bits > 0);
+            assert(stats[0].bloom_checks == 1999);
+            assert(stats[0].bloom_negatives + stats[0].bloom_false_positives == 999);
+            assert(stats[0].bloom_false_positives < 100);
+        }
+        else
+        {
+            assert(stats[0].bloom_bits == 0);
+            assert(stats[0].bloom_checks == 0);
+        }
+        free(stats);
+
+        (void)tidesdb_release_cf_handle(handle);
+        err = tidesdb_close(db);
+        assert(err == NULL);
+        err = tidesdb_open("test_db", &db);
+        assert(err == NULL);
+        err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+        assert(err == NULL);
+        assert(handle->cf->config.partitioned_index);
+    }
+
+    /* a get reads a single partition rather than every block before the key */
+    err = tidesdb_perf_context_enable(true);
+    assert(err == NULL);
+    err = tidesdb_perf_context_reset();
+    assert(err == NULL);
+
+    uint8_t *got = NULL;
+    size_t got_size = 0;
+    assert(tidesdb_get_status(handle, (uint8_t *)"key_01998", 10, &got, &got_size) ==
+           TIDESDB_SUCCESS);
+    free(got);
+
+    tidesdb_perf_context_t ctx;
+    err = tidesdb_get_perf_context(&ctx);
+    assert(err == NULL);
+    assert(ctx.block_reads >= 1 && ctx.block_reads <= TDB_SSTABLE_PARTITION_ENTRIES);
+    err = tidesdb_perf_context_enable(false);
+    assert(err == NULL);
+
+    /* the merge drops the deletes and partitions what is left */
+    for (int i = 0; i < 1000; i += 2)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        assert(tidesdb_delete_status(handle, key, strlen((char *)key) + 1) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    err = tidesdb_compact_sstables_w_handle(handle, 1);
+    assert(err == NULL);
+
+    tidesdb_sstable_stats_t *stats = NULL;
+    int num_sstables = 0;
+    assert(tidesdb_get_sstable_stats_w_handle(handle, &stats, &num_sstables) == NULL);
+    assert(num_sstables == 1);
+    assert(stats[0].index_partitions == 2);
+    free(stats);
+
+    /* a cursor reads the key value blocks and stops where the filters begin */
+    tidesdb_cursor_t *cursor = NULL;
+    err = tidesdb_cursor_init_w_handle(handle, &cursor);
+    assert(err == NULL);
+
+    int count = 0;
+    do
+    {
+        uint8_t *retrieved_key = NULL;
+        size_t key_size;
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+
+        err = tidesdb_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size);
+        assert(err == NULL);
+        assert(atoi((char *)retrieved_key + 4) == 1000 + count * 2);
+        assert(value_size == sizeof(value));
+        count++;
+
+        free(retrieved_key);
+        free(retrieved_value);
+    } while ((err = tidesdb_cursor_next(cursor)) == NULL);
+
+    assert(err->code == TIDESDB_ERR_AT_END_OF_CURSOR);
+    tidesdb_err_free(err);
+    assert(count == 500);
+
+    /* and back again from the end */
+    count = 0;
+    while ((err = tidesdb_cursor_prev(cursor)) == NULL) count++;
+    assert(err->code == TIDESDB_ERR_AT_START_OF_CURSOR);
+    tidesdb_err_free(err);
+    assert(count == 499);
+
+    err = tidesdb_cursor_free(cursor);
+    assert(err == NULL);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        got = NULL;
+        int rc = tidesdb_get_status(handle, key, strlen((char *)key) + 1, &got, &got_size);
+        assert(rc == (i % 2 == 0 && i >= 1000 ? TIDESDB_SUCCESS : TIDESDB_ERR_KEY_NOT_FOUND));
+        free(got);
+    }
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_partitioned_index %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_partition_hash_index(bool compress, tidesdb_compression_algo_t algo,
+                                       bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    tidesdb_column_family_config_t config = {.name = "test_cf",
+                                             .flush_threshold = 1024 * 1024,
+                                             .max_level = 12,
+                                             .probability = 0.24f,
+                                             .compressed = compress,
+                                             .compress_algo = algo,
+                                             .memtable_ds = memtable_ds,
+                                             .bloom_filter = bloom_filter,
+                                             .memtable_shards = 1,
+                                             .filter_type = TDB_FILTER_BLOOM,
+                                             .partitioned_index = false,
+                                             .hash_index = true};
+
+    /* the hash indexes need partitions to live in */
+    err = tidesdb_create_column_family_w_config(db, &config);
+    assert(err != NULL);
+    (void)tidesdb_err_free(err);
+
+    config.partitioned_index = true;
+    err = tidesdb_create_column_family_w_config(db, &config);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[100];
+    memset(value, 'v', sizeof(value));
+
+    for (int i = 0; i < 2000; i += 2)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    (void)tidesdb_release_cf_handle(handle);
+    err = tidesdb_close(db);
+    assert(err == NULL);
+    err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+    assert(handle->cf->config.hash_index);
+
+    /* a get reads the one block the hash index points at, a partition is only scanned when two
+     * keys on the probe share a tag */
+    err = tidesdb_perf_context_enable(true);
+    assert(err == NULL);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        err = tidesdb_perf_context_reset();
+        assert(err == NULL);
+
+        for (int i = pass; i < 2000; i += 2)
+        {
+            snprintf((char *)key, sizeof(key), "key_%05d", i);
+            uint8_t *got = NULL;
+            size_t got_size = 0;
+            int rc = tidesdb_get_status(handle, key, strlen((char *)key) + 1, &got, &got_size);
+            assert(rc == (pass == 0 ? TIDESDB_SUCCESS : TIDESDB_ERR_KEY_NOT_FOUND));
+            assert(pass == 1 || (got_size == sizeof(value) && got[0] == 'v'));
+            free(got);
+        }
+
+        tidesdb_perf_context_t ctx;
+        err = tidesdb_get_perf_context(&ctx);
+        assert(err == NULL);
+        if (pass == 0) assert(ctx.block_reads >= 1000 && ctx.block_reads < 1100);
+
+        /* a missing key mostly lands on an empty slot, the bloom filters rule out most anyway */
+        if (pass == 1) assert(ctx.block_reads < 100);
+    }
+
+    err = tidesdb_perf_context_enable(false);
+    assert(err == NULL);
+
+    /* the merge rebuilds the hash indexes for the keys it keeps */
+    for (int i = 0; i < 1000; i += 2)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        assert(tidesdb_delete_status(handle, key, strlen((char *)key) + 1) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    err = tidesdb_compact_sstables_w_handle(handle, 1);
+    assert(err == NULL);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        int rc = tidesdb_get_status(handle, key, strlen((char *)key) + 1, &got, &got_size);
+        assert(rc == (i % 2 == 0 && i >= 1000 ? TIDESDB_SUCCESS : TIDESDB_ERR_KEY_NOT_FOUND));
+        free(got);
+    }
+
+    /* cursors stop before the filters and hash indexes */
+    tidesdb_cursor_t *cursor = NULL;
+    err = tidesdb_cursor_init_w_handle(handle, &cursor);
+    assert(err == NULL);
+
+    int count = 1;
+    while ((err = tidesdb_cursor_next(cursor)) == NULL) count++;
+    assert(err->code == TIDESDB_ERR_AT_END_OF_CURSOR);
+    tidesdb_err_free(err);
+    assert(count == 500);
+
+    err = tidesdb_cursor_free(cursor);
+    assert(err == NULL);
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_partition_hash_index %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_learned_index(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                                tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    tidesdb_column_family_config_t config = {.name = "test_cf",
+                                             .flush_threshold = 1024 * 1024,
+                                             .max_level = 12,
+                                             .probability = 0.24f,
+                                             .compressed = compress,
+                                             .compress_algo = algo,
+                                             .memtable_ds = memtable_ds,
+                                             .bloom_filter = bloom_filter,
+                                             .memtable_shards = 1,
+                                             .filter_type = TDB_FILTER_BLOOM,
+                                             .partitioned_index = false,
+                                             .learned_index = true};
+
+    /* the learned indexes need partitions to live in */
+    err = tidesdb_create_column_family_w_config(db, &config);
+    assert(err != NULL);
+    (void)tidesdb_err_free(err);
+
+    config.partitioned_index = true;
+    err = tidesdb_create_column_family_w_config(db, &config);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[100];
+    memset(value, 'v', sizeof(value));
+
+    /* big endian millisecond timestamps a second apart with some jitter filling 8 partitions,
+     * and a few string keys after them */
+    for (int i = 0; i < 2348; i++)
+    {
+        size_t key_size = 8;
+        uint64_t ts = 1700000000000ULL + (uint64_t)i * 1000 + (uint64_t)(i * 7919 % 500);
+        for (int b = 0; b < 8; b++) key[b] = (uint8_t)(ts >> (56 - 8 * b));
+        if (i >= 2048) key_size = (size_t)snprintf((char *)key, sizeof(key), "key_%05d", i) + 1;
+        assert(tidesdb_put_status(handle, key, key_size, value, sizeof(value), -1) ==
+               TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    (void)tidesdb_release_cf_handle(handle);
+    err = tidesdb_close(db);
+    assert(err == NULL);
+    err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+    assert(handle->cf->config.learned_index);
+
+    /* the timestamps fit a line per partition, read back from the footer */
+    tidesdb_sstable_index_t *index = _tidesdb_sstable_index(handle->cf->version->sstables[0]);
+    assert(index != NULL);
+    assert(index->num_partitions == 10);
+    for (uint32_t i = 0; i < 8; i++) assert(index->partitions[i].segments != NULL);
+
+    err = tidesdb_perf_context_enable(true);
+    assert(err == NULL);
+    err = tidesdb_perf_context_reset();
+    assert(err == NULL);
+
+    /* a get reads the few blocks around the prediction instead of half its partition */
+    for (int i = 0; i < 2348; i++)
+    {
+        size_t key_size = 8;
+        uint64_t ts = 1700000000000ULL + (uint64_t)i * 1000 + (uint64_t)(i * 7919 % 500);
+        for (int b = 0; b < 8; b++) key[b] = (uint8_t)(ts >> (56 - 8 * b));
+        if (i >= 2048) key_size = (size_t)snprintf((char *)key, sizeof(key), "key_%05d", i) + 1;
+
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        assert(tidesdb_get_status(handle, key, key_size, &got, &got_size) == TIDESDB_SUCCESS);
+        assert(got_size == sizeof(value) && got[0] == 'v');
+        free(got);
+    }
+
+    tidesdb_perf_context_t ctx;
+    err = tidesdb_get_perf_context(&ctx);
+    assert(err == NULL);
+    assert(ctx.block_reads >= 2348 && ctx.block_reads < 2348 * 3);
+
+    /* a timestamp in between is not there */
+    for (int i = 0; i < 2048; i++)
+    {
+        uint64_t ts = 1700000000001ULL + (uint64_t)i * 1000 + (uint64_t)(i * 7919 % 500);
+        for (int b = 0; b < 8; b++) key[b] = (uint8_t)(ts >> (56 - 8 * b));
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        assert(tidesdb_get_status(handle, key, 8, &got, &got_size) == TIDESDB_ERR_KEY_NOT_FOUND);
+    }
+
+    err = tidesdb_perf_context_enable(false);
+    assert(err == NULL);
+
+    /* the merge fits the keys it keeps again */
+    for (int i = 0; i < 1000; i += 2)
+    {
+        uint64_t ts = 1700000000000ULL + (uint64_t)i * 1000 + (uint64_t)(i * 7919 % 500);
+        for (int b = 0; b < 8; b++) key[b] = (uint8_t)(ts >> (56 - 8 * b));
+        assert(tidesdb_delete_status(handle, key, 8) == TIDESDB_SUCCESS);
+    }
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    err = tidesdb_compact_sstables_w_handle(handle, 1);
+    assert(err == NULL);
+
+    for (int i = 0; i < 2048; i++)
+    {
+        uint64_t ts = 1700000000000ULL + (uint64_t)i * 1000 + (uint64_t)(i * 7919 % 500);
+        for (int b = 0; b < 8; b++) key[b] = (uint8_t)(ts >> (56 - 8 * b));
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        int rc = tidesdb_get_status(handle, key, 8, &got, &got_size);
+        assert(rc == (i % 2 == 0 && i < 1000 ? TIDESDB_ERR_KEY_NOT_FOUND : TIDESDB_SUCCESS));
+        free(got);
+    }
+
+    /* cursors never read the model, it lives in the top level index */
+    tidesdb_cursor_t *cursor = NULL;
+    err = tidesdb_cursor_init_w_handle(handle, &cursor);
+    assert(err == NULL);
+
+    int count = 1;
+    while ((err = tidesdb_cursor_next(cursor)) == NULL) count++;
+    assert(err->code == TIDESDB_ERR_AT_END_OF_CURSOR);
+    tidesdb_err_free(err);
+    assert(count == 1848);
+
+    err = tidesdb_cursor_free(cursor);
+    assert(err == NULL);
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_learned_index %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_row_cache(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                            tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_config_t config = {.row_cache_bytes = 1024 * 1024};
+    tidesdb_err_t *err = tidesdb_open_w_config("test_db", &config, &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[100];
+    memset(value, 'v', sizeof(value));
+
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%03d", i);
+        assert(tidesdb_put_status(handle, key, 8, value, sizeof(value), -1) == TIDESDB_SUCCESS);
+    }
+    (void)snprintf((char *)key, sizeof(key), "key_ttl");
+    assert(tidesdb_put_status(handle, key, 8, value, sizeof(value), time(NULL) + 2) ==
+           TIDESDB_SUCCESS);
+
+    /* rows in the memtable are never cached, it answers them just as fast */
+    uint8_t *got = NULL;
+    size_t got_size = 0;
+    assert(tidesdb_get_status(handle, (uint8_t *)"key_000", 8, &got, &got_size) ==
+           TIDESDB_SUCCESS);
+    free(got);
+
+    tidesdb_memory_usage_t usage;
+    assert(tidesdb_get_memory_usage(db, &usage) == NULL);
+    assert(usage.row_cache_bytes == 0);
+    assert(usage.row_cache_capacity == 1024 * 1024);
+
+    assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+
+    err = tidesdb_perf_context_enable(true);
+    assert(err == NULL);
+
+    /* the first gets read the sstable and cache their rows, the second ones read no block */
+    for (int pass = 0; pass < 2; pass++)
+    {
+        err = tidesdb_perf_context_reset();
+        assert(err == NULL);
+
+        for (int i = 0; i < 100; i++)
+        {
+            snprintf((char *)key, sizeof(key), "key_%03d", i);
+            assert(tidesdb_get_status(handle, key, 8, &got, &got_size) == TIDESDB_SUCCESS);
+            assert(got_size == sizeof(value) && memcmp(got, value, sizeof(value)) == 0);
+            free(got);
+        }
+
+        tidesdb_perf_context_t ctx;
+        err = tidesdb_get_perf_context(&ctx);
+        assert(err == NULL);
+        assert(pass == 0 ? ctx.block_reads >= 100 : ctx.block_reads == 0);
+    }
+
+    err = tidesdb_perf_context_enable(false);
+    assert(err == NULL);
+
+    tidesdb_stats_t stats;
+    assert(tidesdb_get_stats_w_handle(handle, &stats) == NULL);
+    assert(stats.row_cache_hits == 100);
+    assert(stats.row_cache_misses == 101);
+
+    assert(tidesdb_get_memory_usage(db, &usage) == NULL);
+    assert(usage.row_cache_bytes >= 100 * sizeof(value));
+    assert(usage.total_bytes >= usage.row_cache_bytes);
+
+    /* puts, deletes and commits drop the cached rows of their keys */
+    memset(value, 'w', sizeof(value));
+    assert(tidesdb_put_status(handle, (uint8_t *)"key_000", 8, value, sizeof(value), -1) ==
+           TIDESDB_SUCCESS);
+    assert(tidesdb_delete_status(handle, (uint8_t *)"key_001", 8) == TIDESDB_SUCCESS);
+
+    tidesdb_txn_t *txn = NULL;
+    assert(tidesdb_txn_begin_w_handle(handle, &txn) == NULL);
+    assert(tidesdb_txn_put(txn, (uint8_t *)"key_002", 8, value, sizeof(value), -1) == NULL);
+    assert(tidesdb_txn_commit(txn) == NULL);
+    assert(tidesdb_txn_free(txn) == NULL);
+
+    /* once flushed the new rows come from the sstables and are cached again */
+    for (int pass = 0; pass < 3; pass++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            snprintf((char *)key, sizeof(key), "key_%03d", i);
+            got = NULL;
+            int rc = tidesdb_get_status(handle, key, 8, &got, &got_size);
+            if (i == 1)
+            {
+                assert(rc == TIDESDB_ERR_KEY_NOT_FOUND);
+                continue;
+            }
+            assert(rc == TIDESDB_SUCCESS);
+            assert(got_size == sizeof(value) && got[0] == 'w');
+            free(got);
+        }
+
+        if (pass > 0) continue;
+        assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+        assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+        (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+    }
+
+    /* a cached row expires with its key */
+    assert(tidesdb_get_status(handle, (uint8_t *)"key_ttl", 8, &got, &got_size) ==
+           TIDESDB_SUCCESS);
+    free(got);
+    (void)sleep(3);
+    assert(tidesdb_get_status(handle, (uint8_t *)"key_ttl", 8, &got, &got_size) ==
+           TIDESDB_ERR_KEY_NOT_FOUND);
+
+    (void)tidesdb_release_cf_handle(handle);
+
+    /* a column family created again under the same name doesn't see the rows of the old one */
+    err = tidesdb_drop_column_family(db, "test_cf");
+    assert(err == NULL);
+    assert(tidesdb_get_memory_usage(db, &usage) == NULL);
+    assert(usage.row_cache_bytes == 0);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+    assert(tidesdb_get_status(handle, (uint8_t *)"key_050", 8, &got, &got_size) ==
+           TIDESDB_ERR_KEY_NOT_FOUND);
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_row_cache %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+typedef struct
+{
+    tidesdb_t *db;
+    atomic_bool *stop;
+    int num_keys;
+    int reads;
+} test_compact_reader_args_t;
+
+void *test_tidesdb_compact_reader(void *arg)
+{
+    test_compact_reader_args_t *args = arg;
+    uint8_t key[20];
+
+    /* we keep reading while compaction runs, every key must be found or stay deleted */
+    while (!atomic_load(args->stop))
+    {
+        for (int i = 0; i < args->num_keys; i += 7)
+        {
+            snprintf((char *)key, sizeof(key), "key_%d", i);
+            uint8_t *retrieved_value = NULL;
+            size_t value_size;
+
+            tidesdb_err_t *err = tidesdb_get(args->db, "test_cf", key, strlen((char *)key) + 1,
+                                             &retrieved_value, &value_size);
+            if (i < 1000 && i % 10 == 0)
+            {
+                assert(err != NULL);
+                tidesdb_err_free(err);
+                continue;
+            }
+
+            if (err != NULL)
+            {
+                printf(RED "%s" RESET, err->message);
+            }
+            assert(err == NULL);
+
+            free(retrieved_value);
+            args->reads++;
+        }
+    }
+
+    return NULL;
+}
+
+void test_tidesdb_put_flush_compact_concurrent_get(bool compress, tidesdb_compression_algo_t algo,
+                                                   bool bloom_filter,
+                                                   tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+
+    for (size_t i = 0; i < sizeof(value); i++)
+    {
+        value[i] = (uint8_t)(rand() % 256);
+    }
+
+    /* we put 4,000 keys which flushes a few sstables */
+    int num_keys = 4000;
+    for (int i = 0; i < num_keys; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        err = tidesdb_put(db, "test_cf", key, strlen((char *)key) + 1, value, sizeof(value), -1);
+        if (err != NULL)
+        {
+            printf(RED "%s" RESET, err->message);
+        }
+        assert(err == NULL);
+    }
+
+    /* we delete every tenth of the oldest keys, the tombstones land in a newer sstable */
+    for (int i = 0; i < 1000; i += 10)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        err = tidesdb_delete(db, "test_cf", key, strlen((char *)key) + 1);
+        if (err != NULL)
+        {
+            printf(RED "%s" RESET, err->message);
+        }
+        assert(err == NULL);
+    }
+
+    /* we put another 2,000 keys so the tombstones get flushed */
+    for (int i = num_keys; i < num_keys + 2000; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        err = tidesdb_put(db, "test_cf", key, strlen((char *)key) + 1, value, sizeof(value), -1);
+        if (err != NULL)
+        {
+            printf(RED "%s" RESET, err->message);
+        }
+        assert(err == NULL);
+    }
+    num_keys += 2000;
+
+    tidesdb_column_family_t *cf = NULL;
+    assert(_tidesdb_get_column_family(db, "test_cf", &cf) == 0);
+    int num_sstables = cf->version->num_sstables;
+    assert(num_sstables >= 4);
+
+    /* we read from another thread while we compact */
+    atomic_bool stop = false;
+    test_compact_reader_args_t args = {.db = db, .stop = &stop, .num_keys = num_keys, .reads = 0};
+    pthread_t reader;
+    assert(pthread_create(&reader, NULL, test_tidesdb_compact_reader, &args) == 0);
+
+    err = tidesdb_compact_sstables(db, "test_cf", 2);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    atomic_store(&stop, true);
+    assert(pthread_join(reader, NULL) == 0);
+    assert(args.reads > 0);
+
+    /* we should have half the sstables, rounded up */
+    assert(cf->version->num_sstables == (num_sstables + 1) / 2);
+
+    /* we reopen the database, the manifest should give us the compacted sstables */
+    err = tidesdb_close(db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    err = tidesdb_open("test_db", &db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    assert(_tidesdb_get_column_family(db, "test_cf", &cf) == 0);
+    assert(cf->version->num_sstables == (num_sstables + 1) / 2);
+
+    /* we check all keys, deleted keys must stay deleted */
+    for (int i = 0; i < num_keys; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+
+        err =
+            tidesdb_get(db, "test_cf", key, strlen((char *)key) + 1, &retrieved_value, &value_size);
+        if (i < 1000 && i % 10 == 0)
+        {
+            assert(err != NULL);
+            tidesdb_err_free(err);
+            continue;
+        }
+
+        if (err != NULL)
+        {
+            printf(RED "%s" RESET, err->message);
+        }
+        assert(err == NULL);
+        assert(value_size == sizeof(value));
+        assert(memcmp(retrieved_value, value, sizeof(value)) == 0);
+
+        free(retrieved_value);
+    }
+
+    err = tidesdb_close(db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_put_flush_compact_concurrent_get %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+typedef struct
+{
+    tidesdb_cf_handle_t *handle;
+    atomic_bool *started;
+    int code;
+} test_compact_dropped_args_t;
+
+void *test_tidesdb_compact_dropped(void *arg)
+{
+    test_compact_dropped_args_t *args = arg;
+
+    atomic_store(args->started, true);
+    tidesdb_err_t *err = tidesdb_compact_sstables_w_handle(args->handle, 1);
+    args->code = err != NULL ? err->code : 0;
+    if (err != NULL) tidesdb_err_free(err);
+
+    (void)tidesdb_release_cf_handle(args->handle);
+    return NULL;
+}
+
+void test_tidesdb_drop_during_compaction(bool compress, tidesdb_compression_algo_t algo,
+                                         bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[1000];
+    memset(value, 'v', sizeof(value));
+
+    /* a dozen sstables so the merge takes a while */
+    for (int i = 0; i < 1200; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+        if (i % 100 != 99) continue;
+        assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+        assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+        (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+    }
+    assert(handle->cf->version->num_sstables == 12);
+
+    /* we drop and recreate the column family while another thread compacts the old one */
+    atomic_bool started = false;
+    test_compact_dropped_args_t args = {.handle = handle, .started = &started, .code = -1};
+    pthread_t compactor;
+    assert(pthread_create(&compactor, NULL, test_tidesdb_compact_dropped, &args) == 0);
+    while (!atomic_load(&started)) (void)usleep(100);
+    (void)usleep(1000);
+
+    err = tidesdb_drop_column_family(db, "test_cf");
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *fresh = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &fresh);
+    assert(err == NULL);
+    assert(tidesdb_put_status(fresh, (uint8_t *)"new_key", 8, value, sizeof(value), -1) ==
+           TIDESDB_SUCCESS);
+    assert(pthread_rwlock_wrlock(&fresh->cf->rwlock) == 0);
+    assert(_tidesdb_flush_memtable(fresh->cf, NULL) == 0);
+    (void)pthread_rwlock_unlock(&fresh->cf->rwlock);
+    (void)tidesdb_release_cf_handle(fresh);
+
+    /* the compaction either finished before the drop or gave up without installing its outputs */
+    assert(pthread_join(compactor, NULL) == 0);
+    assert(args.code == 0 || args.code == TIDESDB_ERR_COLUMN_FAMILY_NOT_FOUND);
+
+    /* the manifest of the new column family is its own, its sstable survives the reopen */
+    err = tidesdb_close(db);
+    assert(err == NULL);
+    err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+    err = tidesdb_get_cf_handle(db, "test_cf", &fresh);
+    assert(err == NULL);
+    assert(fresh->cf->version->num_sstables == 1);
+
+    uint8_t *got = NULL;
+    size_t got_size = 0;
+    assert(tidesdb_get_status(fresh, (uint8_t *)"new_key", 8, &got, &got_size) ==
+           TIDESDB_SUCCESS);
+    assert(got_size == sizeof(value));
+    free(got);
+    assert(tidesdb_get_status(fresh, (uint8_t *)"key_0", 6, &got, &got_size) ==
+           TIDESDB_ERR_KEY_NOT_FOUND);
+    (void)tidesdb_release_cf_handle(fresh);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_drop_during_compaction %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_drop_with_pinned_version(bool compress, tidesdb_compression_algo_t algo,
+                                           bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    uint8_t key[20];
+    uint8_t value[100];
+    memset(value, 'v', sizeof(value));
+
+    /* two sstables, the cursor pins them and the compaction makes them obsolete */
+    for (int i = 0; i < 20; i++)
+    {
+        snprintf((char *)key, sizeof(key), "old_%d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+        if (i % 10 != 9) continue;
+        assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+        assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+        (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+    }
+
+    tidesdb_cursor_t *cursor = NULL;
+    err = tidesdb_cursor_init(db, "test_cf", &cursor);
+    assert(err == NULL);
+
+    err = tidesdb_compact_sstables_w_handle(handle, 1);
+    assert(err == NULL);
+    (void)tidesdb_release_cf_handle(handle);
+
+    /* the new column family writes its sstables under the ids of the obsolete ones */
+    err = tidesdb_drop_column_family(db, "test_cf");
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+    for (int i = 0; i < 20; i++)
+    {
+        snprintf((char *)key, sizeof(key), "new_%d", i);
+        assert(tidesdb_put_status(handle, key, strlen((char *)key) + 1, value, sizeof(value),
+                                  -1) == TIDESDB_SUCCESS);
+        if (i % 10 != 9) continue;
+        assert(pthread_rwlock_wrlock(&handle->cf->rwlock) == 0);
+        assert(_tidesdb_flush_memtable(handle->cf, NULL) == 0);
+        (void)pthread_rwlock_unlock(&handle->cf->rwlock);
+    }
+    (void)tidesdb_release_cf_handle(handle);
+
+    /* the last release of the obsolete sstables must leave the new files alone */
+    err = tidesdb_cursor_free(cursor);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+    err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+    assert(handle->cf->version->num_sstables == 2);
+
+    for (int i = 0; i < 20; i++)
+    {
+        snprintf((char *)key, sizeof(key), "new_%d", i);
+        uint8_t *got = NULL;
+        size_t got_size = 0;
+        assert(tidesdb_get_status(handle, key, strlen((char *)key) + 1, &got, &got_size) ==
+               TIDESDB_SUCCESS);
+        assert(got_size == sizeof(value));
+        free(got);
+    }
+    (void)tidesdb_release_cf_handle(handle);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_drop_with_pinned_version %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_txn_put_get(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                              tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    tidesdb_err_free(err);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    tidesdb_txn_t *txn = NULL;
+    err = tidesdb_txn_begin(db, &txn, "test_cf");
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    uint8_t key[] = "test_key";
+    uint8_t value[] = "test_value";
+    err = tidesdb_txn_put(txn, key, sizeof(key), value, sizeof(value), -1);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    err = tidesdb_txn_commit(txn);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    err = tidesdb_txn_free(txn);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    /* now we should be able to get the value */
+    uint8_t *retrieved_value = NULL;
+    size_t value_size;
+
+    err = tidesdb_get(db, "test_cf", key, sizeof(key), &retrieved_value, &value_size);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    free(retrieved_value);
+
+    err = tidesdb_close(db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_txn_put_get %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_txn_put_get_rollback_get(bool compress, tidesdb_compression_algo_t algo,
+                                           bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    tidesdb_err_free(err);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    tidesdb_txn_t *txn = NULL;
+    err = tidesdb_txn_begin(db, &txn, "test_cf");
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    uint8_t key[] = "test_key";
+    uint8_t value[] = "test_value";
+    err = tidesdb_txn_put(txn, key, sizeof(key), value, sizeof(value), -1);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    err = tidesdb_txn_commit(txn);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    /* now we should be able to get the value */
+    uint8_t *retrieved_value = NULL;
+    size_t value_size;
+
+    err = tidesdb_get(db, "test_cf", key, sizeof(key), &retrieved_value, &value_size);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    free(retrieved_value);
+
+    /* now we rollback the transaction */
+    err = tidesdb_txn_rollback(txn);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    /* we should not be able to get the value anymore */
+    err = tidesdb_get(db, "test_cf", key, sizeof(key), &retrieved_value, &value_size);
+    assert(err != NULL), tidesdb_err_free(err);
+
+    err = tidesdb_txn_free(txn);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    err = tidesdb_close(db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_txn_put_get_rollback_get %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+void test_tidesdb_txn_put_put_delete_get(bool compress, tidesdb_compression_algo_t algo,
+                                         bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+    assert(err == NULL);
+
+    tidesdb_err_free(err);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    tidesdb_txn_t *txn = NULL;
+    err = tidesdb_txn_begin(db, &txn, "test_cf");
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
+
+    uint8_t key1[] = "test_key1";
+    uint8_t value1[] = "test_value1";
+    err = tidesdb_txn_put(txn, key1, sizeof(key1), value1, sizeof(value1), -1);
+    if (err != NULL)
+    {
+        printf(RED "%s" RESET, err->message);
+    }
+
+    assert(err == NULL);
 
     uint8_t key2[] = "test_key2";
     uint8_t value2[] = "test_value2";
@@ -1306,6 +4029,358 @@ void test_tidesdb_txn_put_put_delete_get(bool compress, tidesdb_compression_algo
 
 /* mainly test going forward and backwards through column family memtable
  * no bloom filter or compression */
+void test_tidesdb_status_put_get_delete(bool compress, tidesdb_compression_algo_t algo,
+                                        bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    /* the status apis validate the handle */
+    assert(tidesdb_delete_status(NULL, (uint8_t *)"k", 1) == TIDESDB_ERR_INVALID_COLUMN_FAMILY);
+
+    uint8_t key[] = "test_key";
+    uint8_t value[] = "test_value";
+    assert(tidesdb_put_status(handle, key, sizeof(key), value, sizeof(value), -1) ==
+           TIDESDB_SUCCESS);
+
+    uint8_t *retrieved_value = NULL;
+    size_t value_size;
+    assert(tidesdb_get_status(handle, key, sizeof(key), &retrieved_value, &value_size) ==
+           TIDESDB_SUCCESS);
+    assert(value_size == sizeof(value));
+    assert(memcmp(retrieved_value, value, sizeof(value)) == 0);
+    free(retrieved_value);
+
+    /* a missing key is a plain status */
+    uint8_t missing[] = "missing_key";
+    assert(tidesdb_get_status(handle, missing, sizeof(missing), &retrieved_value, &value_size) ==
+           TIDESDB_ERR_KEY_NOT_FOUND);
+
+    assert(tidesdb_delete_status(handle, key, sizeof(key)) == TIDESDB_SUCCESS);
+    assert(tidesdb_get_status(handle, key, sizeof(key), &retrieved_value, &value_size) ==
+           TIDESDB_ERR_KEY_NOT_FOUND);
+
+    /* the error api reports the same outcome */
+    err = tidesdb_get_w_handle(handle, key, sizeof(key), &retrieved_value, &value_size);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_KEY_NOT_FOUND);
+    tidesdb_err_free(err);
+
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_status_put_get_delete %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+typedef struct
+{
+    _Atomic int completed;
+    _Atomic int found;
+    _Atomic int not_found;
+    _Atomic int mismatched;
+} test_async_results_t;
+
+void test_tidesdb_async_callback(int status, const uint8_t *key, size_t key_size, uint8_t *value,
+                                 size_t value_size, void *arg)
+{
+    test_async_results_t *results = arg;
+
+    if (status == TIDESDB_SUCCESS && value != NULL)
+    {
+        /* the value of key_i is value_i */
+        char expected[32];
+        snprintf(expected, sizeof(expected), "value_%.*s", (int)key_size - 4, key + 4);
+        if (value_size != strlen(expected) || memcmp(value, expected, value_size) != 0)
+            (void)atomic_fetch_add(&results->mismatched, 1);
+        (void)atomic_fetch_add(&results->found, 1);
+        free(value);
+    }
+    else if (status == TIDESDB_ERR_KEY_NOT_FOUND)
+        (void)atomic_fetch_add(&results->not_found, 1);
+    else if (status != TIDESDB_SUCCESS)
+        (void)atomic_fetch_add(&results->mismatched, 1);
+
+    (void)atomic_fetch_add(&results->completed, 1);
+}
+
+void test_tidesdb_async(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
+                        tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    err = tidesdb_create_column_family(db, "test_cf", 1024 * 1024, 12, 0.24f, compress, algo,
+                                       bloom_filter, memtable_ds);
+    assert(err == NULL);
+
+    tidesdb_cf_handle_t *handle = NULL;
+    err = tidesdb_get_cf_handle(db, "test_cf", &handle);
+    assert(err == NULL);
+
+    tidesdb_async_t *async = NULL;
+    err = tidesdb_async_open(db, 0, &async);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_INVALID_MAX_THREADS);
+    tidesdb_err_free(err);
+
+    err = tidesdb_async_open(db, 4, &async);
+    assert(err == NULL);
+
+    /* a get needs a callback */
+    err = tidesdb_get_async(async, handle, (uint8_t *)"k", 1, NULL, NULL);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_INVALID_ARGUMENT);
+    tidesdb_err_free(err);
+
+    int num_keys = 500;
+    test_async_results_t puts = {0};
+
+    for (int i = 0; i < num_keys; i++)
+    {
+        /* the buffers are reused right away, the job keeps its own copy */
+        char key[32];
+        char value[32];
+        int key_size = snprintf(key, sizeof(key), "key_%d", i);
+        int value_size = snprintf(value, sizeof(value), "value_%d", i);
+
+        err = tidesdb_put_async(async, handle, (uint8_t *)key, key_size, (uint8_t *)value,
+                                value_size, -1, test_tidesdb_async_callback, &puts);
+        assert(err == NULL);
+    }
+
+    err = tidesdb_async_wait(async);
+    assert(err == NULL);
+    assert(atomic_load(&puts.completed) == num_keys);
+    assert(atomic_load(&puts.mismatched) == 0);
+
+    test_async_results_t gets = {0};
+
+    for (int i = 0; i < num_keys; i++)
+    {
+        char key[32];
+        int key_size = snprintf(key, sizeof(key), "key_%d", i);
+
+        err = tidesdb_get_async(async, handle, (uint8_t *)key, key_size,
+                                test_tidesdb_async_callback, &gets);
+        assert(err == NULL);
+    }
+
+    /* a multi get with one missing key */
+    const uint8_t *keys[] = {(uint8_t *)"key_1", (uint8_t *)"key_missing", (uint8_t *)"key_499"};
+    size_t key_sizes[] = {5, 11, 7};
+    err = tidesdb_multi_get_async(async, handle, keys, key_sizes, 3, test_tidesdb_async_callback,
+                                  &gets);
+    assert(err == NULL);
+
+    /* the jobs hold their own reference so the handle can go before they complete */
+    err = tidesdb_release_cf_handle(handle);
+    assert(err == NULL);
+
+    err = tidesdb_async_wait(async);
+    assert(err == NULL);
+    assert(atomic_load(&gets.completed) == num_keys + 3);
+    assert(atomic_load(&gets.found) == num_keys + 2);
+    assert(atomic_load(&gets.not_found) == 1);
+    assert(atomic_load(&gets.mismatched) == 0);
+
+    err = tidesdb_async_close(async);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_async %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
+typedef struct
+{
+    tidesdb_t *db;
+    int thread;
+    int num_threads;
+    int num_keys;
+} test_shard_writer_args_t;
+
+void *test_tidesdb_shard_writer(void *arg)
+{
+    test_shard_writer_args_t *args = arg;
+    uint8_t key[20];
+    uint8_t value[256];
+
+    /* every writer puts its own keys, they spread over all shards */
+    for (int i = args->thread; i < args->num_keys; i += args->num_threads)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        memset(value, i % 256, sizeof(value));
+
+        tidesdb_err_t *err = tidesdb_put(args->db, "test_cf", key, strlen((char *)key) + 1,
+                                         value, sizeof(value), -1);
+        if (err != NULL)
+        {
+            printf(RED "%s" RESET, err->message);
+        }
+        assert(err == NULL);
+    }
+
+    return NULL;
+}
+
+/* we write from multiple threads into a sharded memtable, flush, delete, iterate in order and
+ * replay the shard wals on reopen */
+void test_tidesdb_sharded_memtable(bool compress, tidesdb_compression_algo_t algo,
+                                   bool bloom_filter, tidesdb_memtable_ds_t memtable_ds)
+{
+    tidesdb_t *db = NULL;
+    tidesdb_err_t *err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    /* the number of shards is checked */
+    err = tidesdb_create_column_family_w_shards(db, "test_cf", TDB_FLUSH_THRESHOLD, 12, 0.24f,
+                                                compress, algo, bloom_filter, memtable_ds,
+                                                TDB_MAX_MEMTABLE_SHARDS + 1);
+    assert(err != NULL);
+    assert(err->code == TIDESDB_ERR_INVALID_ARGUMENT);
+    tidesdb_err_free(err);
+
+    err = tidesdb_create_column_family_w_shards(db, "test_cf", TDB_FLUSH_THRESHOLD, 12, 0.24f,
+                                                compress, algo, bloom_filter, memtable_ds, 4);
+    assert(err == NULL);
+
+    int num_keys = 5000;
+    int num_threads = 4;
+    pthread_t threads[4];
+    test_shard_writer_args_t args[4];
+
+    for (int t = 0; t < num_threads; t++)
+    {
+        args[t] = (test_shard_writer_args_t){
+            .db = db, .thread = t, .num_threads = num_threads, .num_keys = num_keys};
+        assert(pthread_create(&threads[t], NULL, test_tidesdb_shard_writer, &args[t]) == 0);
+    }
+
+    for (int t = 0; t < num_threads; t++) (void)pthread_join(threads[t], NULL);
+
+    /* the shards were flushed together at least once */
+    tidesdb_column_family_t *cf = NULL;
+    assert(_tidesdb_get_column_family(db, "test_cf", &cf) == 0);
+    assert(cf->version->num_sstables > 0);
+
+    uint8_t key[20];
+
+    /* we delete every tenth key, some of them are in sstables */
+    for (int i = 0; i < num_keys; i += 10)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        err = tidesdb_delete(db, "test_cf", key, strlen((char *)key) + 1);
+        assert(err == NULL);
+    }
+
+    /* the cursor merges the shards and sstables in key order */
+    tidesdb_cursor_t *cursor = NULL;
+    err = tidesdb_cursor_init(db, "test_cf", &cursor);
+    assert(err == NULL);
+
+    int count = 0;
+    int last = -1;
+    do
+    {
+        uint8_t *retrieved_key = NULL;
+        size_t key_size;
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+
+        err = tidesdb_cursor_get(cursor, &retrieved_key, &key_size, &retrieved_value, &value_size);
+        assert(err == NULL);
+
+        int i = atoi((char *)retrieved_key + 4);
+        assert(i > last);
+        assert(i % 10 != 0);
+        assert(retrieved_value[0] == (uint8_t)(i % 256));
+        last = i;
+        count++;
+
+        free(retrieved_key);
+        free(retrieved_value);
+    } while ((err = tidesdb_cursor_next(cursor)) == NULL);
+
+    assert(err->code == TIDESDB_ERR_AT_END_OF_CURSOR);
+    tidesdb_err_free(err);
+    assert(count == num_keys - num_keys / 10);
+
+    /* and backwards */
+    count = 0;
+    while ((err = tidesdb_cursor_prev(cursor)) == NULL) count++;
+    assert(err->code == TIDESDB_ERR_AT_START_OF_CURSOR);
+    tidesdb_err_free(err);
+    assert(count == num_keys - num_keys / 10 - 1);
+
+    err = tidesdb_cursor_free(cursor);
+    assert(err == NULL);
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    /* we reopen, the shard wals are replayed into their shards */
+    err = tidesdb_open("test_db", &db);
+    assert(err == NULL);
+
+    assert(_tidesdb_get_column_family(db, "test_cf", &cf) == 0);
+    assert(cf->config.memtable_shards == 4);
+
+    for (int i = 0; i < num_keys; i++)
+    {
+        snprintf((char *)key, sizeof(key), "key_%05d", i);
+        uint8_t *retrieved_value = NULL;
+        size_t value_size;
+
+        err =
+            tidesdb_get(db, "test_cf", key, strlen((char *)key) + 1, &retrieved_value, &value_size);
+        if (i % 10 == 0)
+        {
+            assert(err != NULL);
+            assert(err->code == TIDESDB_ERR_KEY_NOT_FOUND);
+            tidesdb_err_free(err);
+            continue;
+        }
+
+        assert(err == NULL);
+        assert(value_size == 256);
+        assert(retrieved_value[0] == (uint8_t)(i % 256));
+        free(retrieved_value);
+    }
+
+    err = tidesdb_close(db);
+    assert(err == NULL);
+
+    _tidesdb_remove_directory("test_db");
+    printf(GREEN "test_tidesdb_sharded_memtable %s %s %s passed\n" RESET,
+           compress ? "with compression" : "", bloom_filter ? "with bloom filter" : "",
+           memtable_ds == TDB_MEMTABLE_SKIP_LIST ? "with skip list memtable"
+                                                 : "with hash table memtable");
+}
+
 void test_tidesdb_cursor(bool compress, tidesdb_compression_algo_t algo, bool bloom_filter,
                          tidesdb_memtable_ds_t memtable_ds)
 {
@@ -1659,8 +4734,13 @@ int main(void)
     test_tidesdb_txn_put_get_rollback_get(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_txn_put_put_delete_get(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_delete_get(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_cf_handle_put_get_delete(false, TDB_NO_COMPRESSION, false,
+                                          TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_status_put_get_delete(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_async(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_cursor(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_cursor_memtable_sstables(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_sharded_memtable(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_flush_get(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_flush_close_get(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_flush_delete_get(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
@@ -1668,6 +4748,29 @@ int main(void)
     /* these tests take a while to run */
     test_tidesdb_put_many_flush_get(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_flush_compact_get(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_direct_io(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_rate_limit(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_rate_limit_flush_reads(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_write_stall(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_write_stall_timeout(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_background_pool(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_subcompactions(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_cursor_seek(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_stats(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_perf_context(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_event_listener(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_event_listener_reentry(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_memory_usage(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_sstable_stats(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_binary_fuse_filter(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_partitioned_index(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_partition_hash_index(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_learned_index(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_row_cache(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_put_flush_compact_concurrent_get(false, TDB_NO_COMPRESSION, false,
+                                                  TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_drop_during_compaction(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_drop_with_pinned_version(false, TDB_NO_COMPRESSION, false, TDB_MEMTABLE_SKIP_LIST);
 
     /* the next batch of tests we will run with bloom filters and compression
      * same tests just with bloom filters and compression enabled */
@@ -1684,15 +4787,42 @@ int main(void)
     test_tidesdb_txn_put_get_rollback_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_txn_put_put_delete_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_delete_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_cf_handle_put_get_delete(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_status_put_get_delete(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_async(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_flush_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_flush_close_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_flush_delete_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_cursor(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_cursor_memtable_sstables(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_sharded_memtable(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
 
     /* these tests take a while to run */
     test_tidesdb_put_many_flush_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
     test_tidesdb_put_flush_compact_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_direct_io(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_rate_limit(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_rate_limit_flush_reads(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_write_stall(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_write_stall_timeout(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_background_pool(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_subcompactions(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_cursor_seek(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_stats(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_perf_context(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_event_listener(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_event_listener_reentry(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_memory_usage(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_sstable_stats(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_binary_fuse_filter(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_partitioned_index(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_partition_hash_index(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_learned_index(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_row_cache(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_put_flush_compact_concurrent_get(true, TDB_COMPRESS_SNAPPY, true,
+                                                  TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_drop_during_compaction(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
+    test_tidesdb_drop_with_pinned_version(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_SKIP_LIST);
 
     /* same tests as above but using a hash table as the memtable data structure */
     test_tidesdb_put_get_memtable(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
@@ -1701,13 +4831,38 @@ int main(void)
     test_tidesdb_txn_put_get_rollback_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_txn_put_put_delete_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_put_delete_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_async(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_put_flush_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_put_flush_close_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_put_flush_delete_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_cursor(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_cursor_memtable_sstables(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_sharded_memtable(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_put_many_flush_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
     test_tidesdb_put_flush_compact_get(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_direct_io(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_rate_limit(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_rate_limit_flush_reads(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_write_stall(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_write_stall_timeout(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_background_pool(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_subcompactions(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_cursor_seek(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_stats(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_perf_context(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_event_listener(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_event_listener_reentry(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_memory_usage(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_sstable_stats(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_binary_fuse_filter(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_partitioned_index(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_partition_hash_index(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_learned_index(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_row_cache(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_put_flush_compact_concurrent_get(true, TDB_COMPRESS_SNAPPY, true,
+                                                  TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_drop_during_compaction(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
+    test_tidesdb_drop_with_pinned_version(true, TDB_COMPRESS_SNAPPY, true, TDB_MEMTABLE_HASH_TABLE);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,912 @@
+/*
+ *
+ * Copyright (C) TidesDB
+ *
+ * Original Author: Alex Gaetano Padula
+ *
+ * Licensed under the Mozilla Public License, v. 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.mozilla.org/en-US/MPL/2.0/
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/tidesdb.h"
+
+/*
+ * inspects the sstable and wal files of a column family directory
+ *
+ * tidesdb_sst_dump --command=properties db/cf/sstable_3.sst
+ * tidesdb_sst_dump --command=scan --from=key_10 --limit=20 db/cf/sstable_3.sst
+ * tidesdb_sst_dump --command=verify db/cf/sstable_3.sst
+ * tidesdb_sst_dump --command=wal db/cf/.wal
+ *
+ * the files are read directly and never opened for writing, the compression and filter
+ * settings are taken from the column family config next to the file unless given as flags
+ *
+ * run with --help for every flag
+ */
+
+/*
+ * sst_dump_options_t
+ * the command line flags
+ */
+typedef struct
+{
+    const char *command;
+    const char *path;
+    const char *from;
+    uint64_t limit;
+    bool hex;
+    int compress;    /* -1 to take it from the column family config */
+    int bloom;       /* -1 to take it from the column family config */
+    int filter;      /* -1 to take it from the column family config */
+    int partitioned; /* -1 to take it from the column family config */
+} sst_dump_options_t;
+
+/*
+ * sst_dump_file_t
+ * a file being read block by block
+ * @param file the file
+ * @param size the size of the file
+ * @param pos the offset of the next block
+ * @param corrupt set once a block doesn't fit in the file
+ */
+typedef struct
+{
+    FILE *file;
+    uint64_t size;
+    uint64_t pos;
+    bool corrupt;
+} sst_dump_file_t;
+
+/*
+ * sst_dump_properties_t
+ * what a pass over an sstable found
+ */
+typedef struct
+{
+    uint64_t file_size;
+    uint64_t blocks;
+    uint64_t entries;
+    uint64_t tombstones;
+    uint64_t expired;
+    uint64_t key_bytes;
+    uint64_t value_bytes;
+    uint64_t raw_bytes;
+    uint64_t stored_bytes;
+    uint64_t unordered;
+    uint64_t undecodable;
+    uint64_t bloom_misses;
+    uint64_t index_mismatches;
+    uint64_t hash_slots;
+    uint64_t hash_used;
+    uint64_t hash_scans;
+    uint64_t hash_misses;
+    uint64_t learned_partitions;
+    uint64_t learned_segments;
+    uint64_t learned_keys;
+    uint64_t learned_window;
+    uint64_t learned_misses;
+    uint8_t *first_key;
+    size_t first_key_size;
+    uint8_t *last_key;
+    size_t last_key_size;
+    bloom_filter_t *bf;
+    uint64_t bf_bits_set;
+    fuse_filter_t *ff;
+    tidesdb_sstable_index_t *index;
+} sst_dump_properties_t;
+
+static sst_dump_options_t options;
+static bool compressed;
+static tidesdb_compression_algo_t compress_algo;
+static bool bloom_filter;
+static tidesdb_filter_type_t filter_type;
+static bool partitioned_index;
+
+static void sst_dump_print_bytes(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (options.hex)
+            printf("%02x", data[i]);
+        else if (data[i] >= 0x20 && data[i] < 0x7f && data[i] != '\\')
+            putchar(data[i]);
+        else
+            printf("\\x%02x", data[i]);
+    }
+}
+
+static int sst_dump_open(sst_dump_file_t *f, const char *path)
+{
+    *f = (sst_dump_file_t){0};
+    f->file = fopen(path, "rb");
+    if (f->file == NULL) return -1;
+
+    if (fseek(f->file, 0, SEEK_END) != 0)
+    {
+        (void)fclose(f->file);
+        return -1;
+    }
+    f->size = (uint64_t)ftell(f->file);
+    (void)fseek(f->file, 0, SEEK_SET);
+
+    return 0;
+}
+
+/*
+ * sst_dump_read_block
+ * reads the next block the way the block manager wrote it, a size followed by the data
+ * @return the block, NULL at the end of the file or when the block doesn't fit in the file
+ */
+static block_manager_block_t *sst_dump_read_block(sst_dump_file_t *f)
+{
+    if (f->pos == f->size) return NULL;
+
+    uint64_t size;
+    if (f->size - f->pos < sizeof(uint64_t) || fread(&size, sizeof(uint64_t), 1, f->file) != 1 ||
+        size > f->size - f->pos - sizeof(uint64_t))
+    {
+        f->corrupt = true;
+        return NULL;
+    }
+
+    block_manager_block_t *block = malloc(sizeof(block_manager_block_t));
+    if (block == NULL) return NULL;
+
+    block->size = size;
+    block->data = malloc(size > 0 ? size : 1);
+    if (block->data == NULL || fread(block->data, 1, size, f->file) != size)
+    {
+        f->corrupt = block->data != NULL;
+        free(block->data);
+        free(block);
+        return NULL;
+    }
+
+    f->pos += sizeof(uint64_t) + size;
+    return block;
+}
+
+/*
+ * sst_dump_read_block_at
+ * reads the block at an offset, the next sst_dump_read_block carries on where it was
+ * @return the block, NULL if there is none at the offset
+ */
+static block_manager_block_t *sst_dump_read_block_at(sst_dump_file_t *f, uint64_t offset)
+{
+    uint64_t pos = f->pos;
+    block_manager_block_t *block = NULL;
+    if (offset < f->size && fseek(f->file, (long)offset, SEEK_SET) == 0)
+    {
+        f->pos = offset;
+        block = sst_dump_read_block(f);
+    }
+
+    f->pos = pos;
+    (void)fseek(f->file, (long)pos, SEEK_SET);
+    return block;
+}
+
+/*
+ * sst_dump_read_index
+ * reads the top level index of a partitioned sstable through the footer at the end of the file
+ * @return the index, NULL if it can't be read
+ */
+static tidesdb_sstable_index_t *sst_dump_read_index(sst_dump_file_t *f)
+{
+    uint64_t footer_size = sizeof(uint64_t) * 3;
+    if (f->size < footer_size) return NULL;
+
+    uint64_t index_offset = UINT64_MAX;
+    uint64_t magic = 0;
+    block_manager_block_t *block = sst_dump_read_block_at(f, f->size - footer_size);
+    if (block != NULL && block->size == sizeof(uint64_t) * 2)
+    {
+        memcpy(&index_offset, block->data, sizeof(uint64_t));
+        memcpy(&magic, (uint8_t *)block->data + sizeof(uint64_t), sizeof(uint64_t));
+    }
+    if (block != NULL) (void)block_manager_block_free(block);
+    if (magic != TDB_SSTABLE_FOOTER_MAGIC || index_offset >= f->size - footer_size) return NULL;
+
+    block = sst_dump_read_block_at(f, index_offset);
+    if (block == NULL) return NULL;
+
+    tidesdb_sstable_index_t *index = _tidesdb_deserialize_sstable_index(block->data, block->size);
+    (void)block_manager_block_free(block);
+    if (index != NULL && index->data_end > index_offset)
+    {
+        (void)_tidesdb_free_sstable_index(index);
+        return NULL;
+    }
+
+    return index;
+}
+
+/*
+ * sst_dump_decompress
+ * decompresses a block if the column family compresses
+ * @return the raw data, the block data itself when not compressed, NULL if it doesn't decompress
+ */
+static uint8_t *sst_dump_decompress(block_manager_block_t *block, size_t *raw_size)
+{
+    *raw_size = block->size;
+    if (!compressed) return block->data;
+
+    if (block->size == 0) return NULL;
+
+    return decompress_data(block->data, block->size, raw_size,
+                           _tidesdb_map_compression_algo(compress_algo));
+}
+
+/*
+ * sst_dump_kv_fits
+ * checks a serialized key value pair holds exactly what its sizes say, the deserializer trusts
+ * them
+ */
+static bool sst_dump_kv_fits(const uint8_t *data, size_t size)
+{
+    uint32_t key_size;
+    uint32_t value_size;
+    if (size < sizeof(uint32_t)) return false;
+    memcpy(&key_size, data, sizeof(uint32_t));
+    size -= sizeof(uint32_t);
+
+    if (size < (size_t)key_size + sizeof(uint32_t)) return false;
+    memcpy(&value_size, data + sizeof(uint32_t) + key_size, sizeof(uint32_t));
+    size -= (size_t)key_size + sizeof(uint32_t);
+
+    return size == (size_t)value_size + sizeof(int64_t);
+}
+
+static tidesdb_key_value_pair_t *sst_dump_decode_kv(block_manager_block_t *block,
+                                                    size_t *raw_size)
+{
+    uint8_t *raw = sst_dump_decompress(block, raw_size);
+    if (raw == NULL) return NULL;
+
+    tidesdb_key_value_pair_t *kv = NULL;
+    if (sst_dump_kv_fits(raw, *raw_size))
+        kv = _tidesdb_deserialize_key_value_pair(raw, *raw_size, false, TDB_NO_COMPRESSION);
+
+    if (raw != block->data) free(raw);
+    return kv;
+}
+
+static tidesdb_operation_t *sst_dump_decode_operation(block_manager_block_t *block)
+{
+    size_t raw_size;
+    uint8_t *raw = sst_dump_decompress(block, &raw_size);
+    if (raw == NULL) return NULL;
+
+    /* the op code and column family name come before the key value pair */
+    tidesdb_operation_t *op = NULL;
+    size_t header = sizeof(TIDESDB_OP_CODE) + sizeof(uint32_t);
+    uint32_t name_size = 0;
+    if (raw_size >= header) memcpy(&name_size, raw + sizeof(TIDESDB_OP_CODE), sizeof(uint32_t));
+    if (raw_size >= header && name_size > 0 && raw_size - header >= name_size &&
+        raw[header + name_size - 1] == '\0' &&
+        sst_dump_kv_fits(raw + header + name_size, raw_size - header - name_size))
+        op = _tidesdb_deserialize_operation(raw, raw_size, false, TDB_NO_COMPRESSION);
+
+    if (raw != block->data) free(raw);
+    return op;
+}
+
+static bloom_filter_t *sst_dump_decode_bloom_filter(block_manager_block_t *block)
+{
+    int32_t m;
+    int32_t h;
+    if (block->size < sizeof(int32_t) * 2) return NULL;
+    memcpy(&m, block->data, sizeof(int32_t));
+    memcpy(&h, (uint8_t *)block->data + sizeof(int32_t), sizeof(int32_t));
+
+    if (m <= 0 || h <= 0 || block->size != sizeof(int32_t) * 2 + (uint64_t)m) return NULL;
+
+    return bloom_filter_deserialize(block->data);
+}
+
+/*
+ * sst_dump_load_config
+ * takes the compression and filter settings from the column family config in the
+ * directory of the file, flags given on the command line win
+ */
+static void sst_dump_load_config(void)
+{
+    char dir[MAX_FILE_PATH_LENGTH];
+    (void)snprintf(dir, sizeof(dir), "%s", options.path);
+    char *slash = strrchr(dir, _tidesdb_get_path_seperator()[0]);
+    if (slash != NULL)
+        *slash = '\0';
+    else
+        (void)snprintf(dir, sizeof(dir), ".");
+
+    tidesdb_column_family_config_t *config = NULL;
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+    while (d != NULL && config == NULL && (entry = readdir(d)) != NULL)
+    {
+        if (strstr(entry->d_name, TDB_COLUMN_FAMILY_CONFIG_FILE_EXT) == NULL) continue;
+
+        char path[MAX_FILE_PATH_LENGTH * 2];
+        (void)snprintf(path, sizeof(path), "%s%s%s", dir, _tidesdb_get_path_seperator(),
+                       entry->d_name);
+
+        sst_dump_file_t f;
+        if (sst_dump_open(&f, path) == -1) continue;
+
+        uint8_t *buffer = malloc(f.size > 0 ? f.size : 1);
+        if (buffer != NULL && fread(buffer, 1, f.size, f.file) == f.size)
+            config = _tidesdb_deserialize_column_family_config(buffer, f.size);
+        free(buffer);
+        (void)fclose(f.file);
+    }
+    if (d != NULL) (void)closedir(d);
+
+    if (config != NULL)
+    {
+        compressed = config->compressed;
+        compress_algo = config->compress_algo;
+        bloom_filter = config->bloom_filter;
+        filter_type = config->filter_type;
+        partitioned_index = config->partitioned_index;
+        printf("column family    %s\n", config->name);
+        free(config->name);
+        free(config);
+    }
+    else if (options.compress == -1 || options.bloom == -1)
+    {
+        fprintf(stderr, "no column family config next to %s, assuming no compression and no "
+                        "bloom filter unless --compress and --bloom are given\n",
+                options.path);
+    }
+
+    if (options.compress != -1)
+    {
+        compressed = options.compress != TDB_NO_COMPRESSION;
+        compress_algo = (tidesdb_compression_algo_t)options.compress;
+    }
+    if (options.bloom != -1) bloom_filter = options.bloom == 1;
+    if (options.filter != -1) filter_type = (tidesdb_filter_type_t)options.filter;
+    if (options.partitioned != -1) partitioned_index = options.partitioned == 1;
+}
+
+static void sst_dump_print_kv(const tidesdb_key_value_pair_t *kv)
+{
+    sst_dump_print_bytes(kv->key, kv->key_size);
+    if (_tidesdb_is_tombstone(kv->value, kv->value_size))
+    {
+        printf(" => (tombstone)");
+    }
+    else
+    {
+        printf(" => ");
+        sst_dump_print_bytes(kv->value, kv->value_size);
+    }
+    if (kv->ttl != -1)
+        printf(" ttl %" PRId64 "%s", kv->ttl, _tidesdb_is_expired(kv->ttl) ? " (expired)" : "");
+    printf("\n");
+}
+
+/*
+ * sst_dump_decode_filter
+ * decodes a filter block into the properties, replacing the filter of the previous partition
+ */
+static void sst_dump_decode_filter(sst_dump_properties_t *p, block_manager_block_t *block)
+{
+    if (p->bf != NULL) (void)bloom_filter_free(p->bf);
+    if (p->ff != NULL) (void)fuse_filter_free(p->ff);
+    p->bf = NULL;
+    p->ff = NULL;
+
+    if (filter_type == TDB_FILTER_BINARY_FUSE)
+        p->ff = fuse_filter_deserialize(block->data, block->size);
+    else
+        p->bf = sst_dump_decode_bloom_filter(block);
+    if (p->bf == NULL && p->ff == NULL) p->undecodable++;
+}
+
+/*
+ * sst_dump_check_learned_index
+ * checks the learned index of a partition predicts a window holding the key value block at a
+ * position of the partition, and adds the window to the properties
+ */
+static void sst_dump_check_learned_index(sst_dump_properties_t *p,
+                                         tidesdb_sstable_partition_t *partition,
+                                         uint32_t position, const tidesdb_key_value_pair_t *kv)
+{
+    /* the segment the block belongs to */
+    uint32_t segment = 0;
+    while (segment + 1 < partition->num_segments &&
+           partition->segments[segment + 1].entry <= position)
+        segment++;
+
+    uint64_t offset;
+    uint32_t skip;
+    uint32_t count;
+    uint32_t in_segment = position - partition->segments[segment].entry;
+    int rc = _tidesdb_learned_index_lookup(partition, kv->key, kv->key_size, &offset, &skip,
+                                           &count);
+    if (rc != 0 || offset != partition->segments[segment].offset || in_segment < skip ||
+        in_segment >= skip + count)
+    {
+        p->learned_misses++;
+        return;
+    }
+
+    p->learned_keys++;
+    p->learned_window += count;
+}
+
+/*
+ * sst_dump_count_hash_slots
+ * adds the slots of a partition hash index block to the properties, the slot count is followed
+ * by a 16 bit tag and a 32 bit offset per slot
+ */
+static void sst_dump_count_hash_slots(sst_dump_properties_t *p, block_manager_block_t *block)
+{
+    uint32_t num_slots = 0;
+    if (block->size >= sizeof(uint32_t)) memcpy(&num_slots, block->data, sizeof(uint32_t));
+    uint64_t slot_size = sizeof(uint16_t) + sizeof(uint32_t);
+    if (block->size != sizeof(uint32_t) + slot_size * num_slots)
+    {
+        p->undecodable++;
+        return;
+    }
+
+    const uint8_t *offsets =
+        (uint8_t *)block->data + sizeof(uint32_t) + sizeof(uint16_t) * (size_t)num_slots;
+    p->hash_slots += num_slots;
+    for (uint32_t slot = 0; slot < num_slots; slot++)
+    {
+        uint32_t offset;
+        memcpy(&offset, offsets + sizeof(uint32_t) * slot, sizeof(uint32_t));
+        if (offset != TDB_HASH_INDEX_EMPTY) p->hash_used++;
+    }
+}
+
+/*
+ * sst_dump_sstable
+ * makes one pass over an sstable, scan prints the records on the way
+ * @return 0 if the file is intact, -1 if not
+ */
+static int sst_dump_sstable(sst_dump_properties_t *p, bool scan)
+{
+    sst_dump_file_t f;
+    if (sst_dump_open(&f, options.path) == -1)
+    {
+        fprintf(stderr, "cannot open %s\n", options.path);
+        return -1;
+    }
+    p->file_size = f.size;
+
+    /* a partitioned sstable ends its key value blocks where its index says, the partition
+     * filters, the index and the footer follow */
+    block_manager_block_t *block;
+    uint64_t data_end = f.size;
+    if (partitioned_index)
+    {
+        p->index = sst_dump_read_index(&f);
+        if (p->index == NULL) p->index_mismatches++;
+        data_end = p->index != NULL ? p->index->data_end : 0;
+    }
+    else if (bloom_filter && (block = sst_dump_read_block(&f)) != NULL)
+    {
+        p->blocks++;
+        (void)sst_dump_decode_filter(p, block);
+        for (int i = 0; p->bf != NULL && i < p->bf->m; i++)
+            if (p->bf->bitset[i] != 0) p->bf_bits_set++;
+        (void)block_manager_block_free(block);
+    }
+
+    uint64_t printed = 0;
+    size_t from_size = options.from != NULL ? strlen(options.from) : 0;
+    uint32_t part = 0;
+    uint32_t part_entries = 0;
+    block_manager_block_t *hash_block = NULL;
+    while (f.pos < data_end)
+    {
+        /* every partition starts where the index says and brings its own filter */
+        tidesdb_sstable_partition_t *partition = NULL;
+        if (p->index != NULL && part < p->index->num_partitions)
+            partition = &p->index->partitions[part];
+        if (p->index != NULL && (partition == NULL ||
+                                 (part_entries == 0 && partition->data_offset != f.pos)))
+            p->index_mismatches++;
+        if (partition != NULL && part_entries == 0 && bloom_filter)
+        {
+            block = sst_dump_read_block_at(&f, partition->filter_offset);
+            if (block != NULL)
+            {
+                p->blocks++;
+                (void)sst_dump_decode_filter(p, block);
+                (void)block_manager_block_free(block);
+            }
+            else
+            {
+                p->undecodable++;
+            }
+        }
+        if (partition != NULL && part_entries == 0)
+        {
+            if (hash_block != NULL) (void)block_manager_block_free(hash_block);
+            hash_block = NULL;
+            if (partition->hash_offset != UINT64_MAX)
+            {
+                hash_block = sst_dump_read_block_at(&f, partition->hash_offset);
+                if (hash_block == NULL) p->undecodable++;
+                if (hash_block != NULL) p->blocks++;
+                if (hash_block != NULL) (void)sst_dump_count_hash_slots(p, hash_block);
+            }
+        }
+        if (partition != NULL && part_entries == 0 && partition->segments != NULL)
+        {
+            p->learned_partitions++;
+            p->learned_segments += partition->num_segments;
+        }
+        uint32_t position = part_entries;
+        if (partition != NULL && ++part_entries == partition->entries)
+        {
+            part++;
+            part_entries = 0;
+        }
+
+        uint64_t offset = f.pos;
+        if ((block = sst_dump_read_block(&f)) == NULL) break;
+        p->blocks++;
+        p->stored_bytes += block->size;
+
+        size_t raw_size = 0;
+        tidesdb_key_value_pair_t *kv = sst_dump_decode_kv(block, &raw_size);
+        (void)block_manager_block_free(block);
+        if (kv == NULL)
+        {
+            p->undecodable++;
+            continue;
+        }
+
+        p->entries++;
+        p->raw_bytes += raw_size;
+        p->key_bytes += kv->key_size;
+        p->value_bytes += kv->value_size;
+        if (_tidesdb_is_tombstone(kv->value, kv->value_size)) p->tombstones++;
+        if (_tidesdb_is_expired(kv->ttl)) p->expired++;
+        if (p->bf != NULL && !bloom_filter_contains(p->bf, kv->key, kv->key_size))
+            p->bloom_misses++;
+        if (p->ff != NULL && !fuse_filter_contains(p->ff, kv->key, kv->key_size))
+            p->bloom_misses++;
+        if (partition != NULL && _tidesdb_compare_keys(kv->key, kv->key_size, partition->last_key,
+                                                       partition->last_key_size) > 0)
+            p->index_mismatches++;
+
+        /* the hash index has to lead a get to the block, or to a scan on a collision */
+        if (partition != NULL && hash_block != NULL)
+        {
+            uint32_t bucket = _tidesdb_hash_index_lookup(hash_block->data, hash_block->size,
+                                                         kv->key, kv->key_size);
+            if (bucket == TDB_HASH_INDEX_COLLISION)
+                p->hash_scans++;
+            else if (bucket != offset - partition->data_offset)
+                p->hash_misses++;
+        }
+
+        /* and the learned index has to put the block in the window of its segment */
+        if (partition != NULL && partition->segments != NULL)
+            (void)sst_dump_check_learned_index(p, partition, position, kv);
+
+        /* sstables are written in key order and never hold a key twice */
+        if (p->last_key != NULL &&
+            _tidesdb_compare_keys(p->last_key, p->last_key_size, kv->key, kv->key_size) >= 0)
+            p->unordered++;
+
+        if (scan && printed < options.limit &&
+            (options.from == NULL || _tidesdb_compare_keys(kv->key, kv->key_size,
+                                                           (const uint8_t *)options.from,
+                                                           from_size) >= 0))
+        {
+            sst_dump_print_kv(kv);
+            printed++;
+        }
+
+        free(p->last_key);
+        p->last_key = malloc(kv->key_size);
+        if (p->last_key != NULL) memcpy(p->last_key, kv->key, kv->key_size);
+        p->last_key_size = kv->key_size;
+
+        if (p->first_key == NULL)
+        {
+            p->first_key = kv->key;
+            p->first_key_size = kv->key_size;
+            kv->key = NULL;
+        }
+
+        (void)_tidesdb_free_key_value_pair(kv);
+    }
+
+    if (hash_block != NULL) (void)block_manager_block_free(hash_block);
+
+    /* the index can't list partitions the sstable doesn't have */
+    if (p->index != NULL && part != p->index->num_partitions) p->index_mismatches++;
+    if (p->index != NULL) p->blocks += 2;
+
+    int rc = f.corrupt || p->undecodable > 0 || p->unordered > 0 || p->bloom_misses > 0 ||
+                     p->index_mismatches > 0 || p->hash_misses > 0 || p->learned_misses > 0
+                 ? -1
+                 : 0;
+    if (f.corrupt)
+        fprintf(stderr, "block at offset %" PRIu64 " runs past the end of the file (%" PRIu64
+                        " bytes)\n",
+                f.pos, f.size);
+    (void)fclose(f.file);
+
+    return rc;
+}
+
+static void sst_dump_print_properties(const sst_dump_properties_t *p)
+{
+    static const char *algos[] = {"none", "snappy", "lz4", "zstd"};
+    printf("file             %s\n", options.path);
+    printf("file size        %" PRIu64 "\n", p->file_size);
+    printf("blocks           %" PRIu64 "\n", p->blocks);
+    printf("entries          %" PRIu64 "\n", p->entries);
+    printf("tombstones       %" PRIu64 "\n", p->tombstones);
+    printf("expired          %" PRIu64 "\n", p->expired);
+    printf("key bytes        %" PRIu64 " (avg %.1f)\n", p->key_bytes,
+           p->entries > 0 ? (double)p->key_bytes / (double)p->entries : 0.0);
+    printf("value bytes      %" PRIu64 " (avg %.1f)\n", p->value_bytes,
+           p->entries > 0 ? (double)p->value_bytes / (double)p->entries : 0.0);
+    printf("compression      %s\n", compressed ? algos[compress_algo] : "none");
+    printf("compression ratio %.2f (%" PRIu64 " raw bytes, %" PRIu64 " stored)\n",
+           p->stored_bytes > 0 ? (double)p->raw_bytes / (double)p->stored_bytes : 0.0,
+           p->raw_bytes, p->stored_bytes);
+
+    printf("smallest key     ");
+    if (p->first_key != NULL) sst_dump_print_bytes(p->first_key, p->first_key_size);
+    printf("\nlargest key      ");
+    if (p->last_key != NULL) sst_dump_print_bytes(p->last_key, p->last_key_size);
+    printf("\n");
+
+    if (p->index != NULL)
+    {
+        printf("partitions       %u of up to %d entries, top level index %zu bytes\n",
+               p->index->num_partitions, TDB_SSTABLE_PARTITION_ENTRIES, p->index->size);
+        if (p->hash_slots > 0)
+            printf("hash index       %" PRIu64 " slots, %.2f used, %" PRIu64
+                   " keys found by a scan\n",
+                   p->hash_slots, (double)p->hash_used / (double)p->hash_slots, p->hash_scans);
+        if (p->learned_partitions > 0)
+            printf("learned index    %" PRIu64 " segments in %" PRIu64
+                   " partitions, %.2f blocks per prediction\n",
+                   p->learned_segments, p->learned_partitions,
+                   p->learned_keys > 0 ? (double)p->learned_window / (double)p->learned_keys
+                                       : 0.0);
+        if (p->index->filter_bits == 0)
+        {
+            printf("filter           none\n");
+            return;
+        }
+        printf("partition filters %s, %" PRIu64 " bits, %.2f bits per key\n",
+               filter_type == TDB_FILTER_BINARY_FUSE ? "fuse" : "bloom", p->index->filter_bits,
+               p->entries > 0 ? (double)p->index->filter_bits / (double)p->entries : 0.0);
+        return;
+    }
+
+    if (p->ff != NULL)
+    {
+        /* a missing key passes when its 8 bit fingerprint matches by chance */
+        printf("fuse filter      %u fingerprints, %d probes, %.2f bits per key\n",
+               p->ff->array_length, FUSE_FILTER_ARITY,
+               p->entries > 0 ? (double)p->ff->array_length * 8 / (double)p->entries : 0.0);
+        printf("fuse filter fpr  %.4f\n", 1.0 / 256);
+        return;
+    }
+
+    if (p->bf == NULL)
+    {
+        printf("filter           %s\n", bloom_filter ? "unreadable" : "none");
+        return;
+    }
+
+    /* with a fraction f of the bits set a missing key passes all h probes about f^h of the time */
+    double fill = (double)p->bf_bits_set / (double)p->bf->m;
+    printf("bloom filter     %d bits, %d hashes, %.2f bits per key\n", p->bf->m, p->bf->h,
+           p->entries > 0 ? (double)p->bf->m / (double)p->entries : 0.0);
+    printf("bloom fill ratio %.4f (estimated false positive rate %.4f)\n", fill,
+           pow(fill, p->bf->h));
+}
+
+static int sst_dump_wal(void)
+{
+    sst_dump_file_t f;
+    if (sst_dump_open(&f, options.path) == -1)
+    {
+        fprintf(stderr, "cannot open %s\n", options.path);
+        return -1;
+    }
+
+    uint64_t ops = 0;
+    uint64_t undecodable = 0;
+    uint64_t printed = 0;
+    block_manager_block_t *block;
+    while ((block = sst_dump_read_block(&f)) != NULL)
+    {
+        uint64_t offset = f.pos - sizeof(uint64_t) - block->size;
+        tidesdb_operation_t *op = sst_dump_decode_operation(block);
+        (void)block_manager_block_free(block);
+        if (op == NULL)
+        {
+            printf("%" PRIu64 " undecodable operation\n", offset);
+            undecodable++;
+            continue;
+        }
+
+        ops++;
+        if (printed++ < options.limit)
+        {
+            printf("%" PRIu64 " %s %s ", offset,
+                   op->op_code == TIDESDB_OP_PUT ? "PUT" : "DELETE", op->cf_name);
+            sst_dump_print_kv(op->kv);
+        }
+        (void)_tidesdb_free_operation(op);
+    }
+
+    if (f.corrupt)
+        printf("%" PRIu64 " torn write, the last %" PRIu64 " bytes are not a whole block\n",
+               f.pos, f.size - f.pos);
+    printf("%" PRIu64 " operations, %" PRIu64 " undecodable\n", ops, undecodable);
+    (void)fclose(f.file);
+
+    return undecodable > 0 ? -1 : 0;
+}
+
+static void sst_dump_usage(void)
+{
+    printf("usage: tidesdb_sst_dump [--flag=value ...] file\n"
+           "  --command=name             properties, scan, verify or wal (properties, wal for "
+           ".wal files)\n"
+           "  --from=key                 scan from the first key at or after this one\n"
+           "  --limit=n                  records printed by scan and wal (all)\n"
+           "  --hex=1                    print keys and values in hex\n"
+           "  --compress=algo            none, snappy, lz4 or zstd (from the column family "
+           "config)\n"
+           "  --bloom=0|1                whether the first block is a filter (from the column "
+           "family config)\n"
+           "  --filter=kind              bloom or fuse, the kind of filter (from the column "
+           "family config)\n"
+           "  --partitioned=0|1          whether the sstable has partitions under a top level "
+           "index (from the column family config)\n");
+}
+
+static bool sst_dump_parse_flag(const char *arg)
+{
+    if (strncmp(arg, "--", 2) != 0)
+    {
+        options.path = arg;
+        return true;
+    }
+
+    const char *eq = strchr(arg, '=');
+    if (eq == NULL) return false;
+
+    size_t len = (size_t)(eq - arg - 2);
+    const char *name = arg + 2;
+    const char *value = eq + 1;
+    char *end = NULL;
+
+#define SST_DUMP_FLAG(flag) (len == strlen(flag) && strncmp(name, flag, len) == 0)
+
+    if (SST_DUMP_FLAG("command"))
+    {
+        options.command = value;
+        return strcmp(value, "properties") == 0 || strcmp(value, "scan") == 0 ||
+               strcmp(value, "verify") == 0 || strcmp(value, "wal") == 0;
+    }
+    if (SST_DUMP_FLAG("from"))
+    {
+        options.from = value;
+        return true;
+    }
+    if (SST_DUMP_FLAG("filter"))
+    {
+        if (strcmp(value, "bloom") == 0) options.filter = TDB_FILTER_BLOOM;
+        if (strcmp(value, "fuse") == 0) options.filter = TDB_FILTER_BINARY_FUSE;
+        return options.filter != -1;
+    }
+    if (SST_DUMP_FLAG("compress"))
+    {
+        static const char *algos[] = {"none", "snappy", "lz4", "zstd"};
+        for (int i = 0; i < 4; i++)
+            if (strcmp(value, algos[i]) == 0) options.compress = i;
+        return options.compress != -1;
+    }
+
+    uint64_t n = strtoull(value, &end, 10);
+    if (*value == '\0' || *end != '\0') return false;
+    if (SST_DUMP_FLAG("limit")) return ((options.limit = n), true);
+    if (SST_DUMP_FLAG("hex")) return ((options.hex = n != 0), true);
+    if (SST_DUMP_FLAG("bloom")) return ((options.bloom = n != 0), true);
+    if (SST_DUMP_FLAG("partitioned")) return ((options.partitioned = n != 0), true);
+
+#undef SST_DUMP_FLAG
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    options = (sst_dump_options_t){.limit = UINT64_MAX, .compress = -1, .bloom = -1,
+                                    .filter = -1, .partitioned = -1};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            sst_dump_usage();
+            return 0;
+        }
+        if (!sst_dump_parse_flag(argv[i]))
+        {
+            fprintf(stderr, "invalid flag %s\n", argv[i]);
+            sst_dump_usage();
+            return 1;
+        }
+    }
+
+    if (options.path == NULL)
+    {
+        sst_dump_usage();
+        return 1;
+    }
+
+    /* wal files are named after the extension, with the shard index after it past the first */
+    const char *base = strrchr(options.path, _tidesdb_get_path_seperator()[0]);
+    base = base != NULL ? base + 1 : options.path;
+    if (options.command == NULL)
+        options.command = strncmp(base, TDB_WAL_EXT, strlen(TDB_WAL_EXT)) == 0 ? "wal"
+                                                                              : "properties";
+
+    (void)sst_dump_load_config();
+
+    if (strcmp(options.command, "wal") == 0) return sst_dump_wal() == 0 ? 0 : 1;
+
+    sst_dump_properties_t p = {0};
+    int rc = sst_dump_sstable(&p, strcmp(options.command, "scan") == 0);
+
+    if (strcmp(options.command, "properties") == 0) (void)sst_dump_print_properties(&p);
+
+    if (strcmp(options.command, "verify") == 0 || rc == -1)
+    {
+        printf("verify           %s\n", rc == 0 ? "ok" : "FAILED");
+        if (p.undecodable > 0) printf("  %" PRIu64 " blocks don't decode\n", p.undecodable);
+        if (p.unordered > 0) printf("  %" PRIu64 " keys out of order\n", p.unordered);
+        if (p.bloom_misses > 0)
+            printf("  %" PRIu64 " keys missing from the filter\n", p.bloom_misses);
+        if (p.index_mismatches > 0)
+            printf("  %" PRIu64 " mismatches against the top level index\n", p.index_mismatches);
+        if (p.hash_misses > 0)
+            printf("  %" PRIu64 " keys the hash index doesn't lead to\n", p.hash_misses);
+        if (p.learned_misses > 0)
+            printf("  %" PRIu64 " keys outside their learned index window\n", p.learned_misses);
+    }
+
+    free(p.first_key);
+    free(p.last_key);
+    if (p.bf != NULL) (void)bloom_filter_free(p.bf);
+    if (p.ff != NULL) (void)fuse_filter_free(p.ff);
+    (void)_tidesdb_free_sstable_index(p.index);
+
+    return rc == 0 ? 0 : 1;
+}